@@ -0,0 +1,505 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+
+#include <algorithm>
+
+#include "graph/node_binary.h"
+
+#include "render/attribute.h"
+#include "render/background.h"
+#include "render/camera.h"
+#include "render/film.h"
+#include "render/graph.h"
+#include "render/integrator.h"
+#include "render/light.h"
+#include "render/mesh.h"
+#include "render/nodes.h"
+#include "render/object.h"
+#include "render/scene.h"
+#include "render/shader.h"
+
+#include "subd/subd_dice.h"
+
+#include "util/util_foreach.h"
+#include "util/util_md5.h"
+#include "util/util_path.h"
+#include "util/util_version.h"
+
+#include "app/cycles_binary.h"
+
+CCL_NAMESPACE_BEGIN
+
+static const char BINARY_FILE_MAGIC[8] = {'C', 'Y', 'C', 'L', 'B', 'I', 'N', '\0'};
+static const int BINARY_FILE_VERSION = 2;
+
+/* Key identifying the sources the cache was written from, the main XML file followed by all
+ * files it includes. Both paths and contents are hashed. */
+static string binary_source_key(const vector<string> &source_filepaths)
+{
+  MD5Hash md5;
+  md5.append(CYCLES_VERSION_STRING);
+  foreach (const string &source_filepath, source_filepaths) {
+    md5.append(source_filepath);
+    if (!md5.append_file(source_filepath)) {
+      return "";
+    }
+  }
+  return md5.get_hex();
+}
+
+/* Shader */
+
+static bool binary_write_shader_graph(BinaryWriter &writer, ShaderGraph *graph)
+{
+  assert(graph->nodes.front() == graph->output());
+
+  map<ShaderNode *, int> node_index;
+  vector<int> links;
+
+  writer.write((int)graph->nodes.size());
+
+  foreach (ShaderNode *node, graph->nodes) {
+    /* Nodes with types created at runtime such as OSL nodes can't be recreated. */
+    if (node->type->create == NULL || NodeType::find(node->type->name) != node->type) {
+      fprintf(stderr,
+              "Shader node \"%s\" can't be written to binary file.\n",
+              node->type->name.c_str());
+      return false;
+    }
+
+    writer.write_string(node->type->name.string());
+    binary_write_node(writer, node);
+
+    const int index = node_index.size();
+    node_index[node] = index;
+  }
+
+  /* Links as (to node, input, from node, output) indices. */
+  foreach (ShaderNode *node, graph->nodes) {
+    for (size_t i = 0; i < node->inputs.size(); i++) {
+      ShaderOutput *link = node->inputs[i]->link;
+
+      if (link) {
+        ShaderNode *from = link->parent;
+        int output = std::find(from->outputs.begin(), from->outputs.end(), link) -
+                     from->outputs.begin();
+
+        links.push_back(node_index[node]);
+        links.push_back(i);
+        links.push_back(node_index[from]);
+        links.push_back(output);
+      }
+    }
+  }
+
+  writer.write_array(links.data(), links.size());
+
+  return true;
+}
+
+static ShaderGraph *binary_read_shader_graph(BinaryReader &reader)
+{
+  ShaderGraph *graph = new ShaderGraph();
+  vector<ShaderNode *> nodes;
+  int num_nodes = 0;
+
+  reader.read(num_nodes);
+
+  for (int i = 0; i < num_nodes && !reader.error; i++) {
+    string type_name;
+    reader.read_string(type_name);
+
+    const NodeType *node_type = NodeType::find(ustring(type_name));
+    ShaderNode *node;
+
+    if (i == 0) {
+      node = graph->output();
+    }
+    else if (node_type && node_type->type == NodeType::SHADER && node_type->create) {
+      node = graph->add((ShaderNode *)node_type->create(node_type));
+    }
+    else {
+      fprintf(stderr, "Unknown shader node \"%s\".\n", type_name.c_str());
+      reader.error = true;
+      break;
+    }
+
+    binary_read_node(reader, node);
+    nodes.push_back(node);
+  }
+
+  vector<int> links;
+  reader.read_array(links);
+
+  for (size_t i = 0; i + 3 < links.size() && !reader.error; i += 4) {
+    const int to = links[i + 0], input = links[i + 1];
+    const int from = links[i + 2], output = links[i + 3];
+
+    if (to < 0 || to >= (int)nodes.size() || from < 0 || from >= (int)nodes.size() ||
+        input < 0 || input >= (int)nodes[to]->inputs.size() || output < 0 ||
+        output >= (int)nodes[from]->outputs.size()) {
+      reader.error = true;
+      break;
+    }
+
+    graph->connect(nodes[from]->outputs[output], nodes[to]->inputs[input]);
+  }
+
+  if (reader.error) {
+    delete graph;
+    return NULL;
+  }
+
+  return graph;
+}
+
+static bool binary_write_shader(BinaryWriter &writer, Shader *shader)
+{
+  binary_write_node(writer, shader);
+
+  writer.write(shader->graph != NULL);
+  if (shader->graph) {
+    return binary_write_shader_graph(writer, shader->graph);
+  }
+
+  return true;
+}
+
+static bool binary_read_shader(BinaryReader &reader, Scene *scene, Shader *shader)
+{
+  bool has_graph = false;
+
+  binary_read_node(reader, shader);
+  reader.read(has_graph);
+
+  if (has_graph) {
+    ShaderGraph *graph = binary_read_shader_graph(reader);
+    if (graph == NULL) {
+      return false;
+    }
+
+    shader->set_graph(graph);
+  }
+
+  shader->tag_update(scene);
+
+  return !reader.error;
+}
+
+/* Mesh */
+
+static void binary_write_attributes(BinaryWriter &writer, const AttributeSet &attributes)
+{
+  writer.write((int)attributes.attributes.size());
+
+  foreach (const Attribute &attr, attributes.attributes) {
+    writer.write_string(attr.name.string());
+    writer.write(attr.std);
+    writer.write(attr.type);
+    writer.write(attr.element);
+    writer.write(attr.flags);
+    writer.write_array(attr.buffer.data(), attr.buffer.size());
+  }
+}
+
+static void binary_read_attributes(BinaryReader &reader, AttributeSet &attributes)
+{
+  int num_attributes = 0;
+  reader.read(num_attributes);
+
+  for (int i = 0; i < num_attributes && !reader.error; i++) {
+    string name;
+    AttributeStandard std;
+    TypeDesc type;
+    AttributeElement element;
+    uint flags;
+
+    reader.read_string(name);
+    reader.read(std);
+    reader.read(type);
+    reader.read(element);
+    reader.read(flags);
+
+    if (reader.error) {
+      break;
+    }
+
+    Attribute *attr = (std != ATTR_STD_NONE) ? attributes.add(std, ustring(name)) :
+                                               attributes.add(ustring(name), type, element);
+    attr->flags = flags;
+
+    /* Replaces the buffer allocated for the current mesh size. */
+    reader.read_array(attr->buffer);
+  }
+}
+
+static void binary_write_mesh(BinaryWriter &writer, Mesh *mesh)
+{
+  binary_write_node(writer, mesh);
+
+  writer.write((int)mesh->used_shaders.size());
+  foreach (Shader *shader, mesh->used_shaders) {
+    writer.write_node_ref(shader);
+  }
+
+  writer.write(mesh->subdivision_type);
+  writer.write(mesh->volume_isovalue);
+  writer.write_array(mesh->subd_faces.data(), mesh->subd_faces.size());
+  writer.write_array(mesh->subd_face_corners.data(), mesh->subd_face_corners.size());
+  writer.write(mesh->num_ngons);
+  writer.write_array(mesh->subd_creases.data(), mesh->subd_creases.size());
+
+  writer.write(mesh->subd_params != NULL);
+  if (mesh->subd_params) {
+    const SubdParams &params = *mesh->subd_params;
+    writer.write(params.ptex);
+    writer.write(params.test_steps);
+    writer.write(params.split_threshold);
+    writer.write(params.dicing_rate);
+    writer.write(params.max_level);
+    writer.write(params.objecttoworld);
+  }
+
+  binary_write_attributes(writer, mesh->attributes);
+  binary_write_attributes(writer, mesh->subd_attributes);
+}
+
+static void binary_read_mesh(BinaryReader &reader, Mesh *mesh)
+{
+  binary_read_node(reader, mesh);
+
+  int num_shaders = 0;
+  reader.read(num_shaders);
+  for (int i = 0; i < num_shaders && !reader.error; i++) {
+    Node *shader = reader.read_node_ref();
+    if (shader && shader->is_a(Shader::node_type)) {
+      mesh->used_shaders.push_back((Shader *)shader);
+    }
+  }
+
+  reader.read(mesh->subdivision_type);
+  reader.read(mesh->volume_isovalue);
+  reader.read_array(mesh->subd_faces);
+  reader.read_array(mesh->subd_face_corners);
+  reader.read(mesh->num_ngons);
+  reader.read_array(mesh->subd_creases);
+
+  bool has_subd_params = false;
+  reader.read(has_subd_params);
+  if (has_subd_params) {
+    mesh->subd_params = new SubdParams(mesh);
+
+    SubdParams &params = *mesh->subd_params;
+    reader.read(params.ptex);
+    reader.read(params.test_steps);
+    reader.read(params.split_threshold);
+    reader.read(params.dicing_rate);
+    reader.read(params.max_level);
+    reader.read(params.objecttoworld);
+  }
+
+  binary_read_attributes(reader, mesh->attributes);
+  binary_read_attributes(reader, mesh->subd_attributes);
+}
+
+/* Camera */
+
+static void binary_write_camera(BinaryWriter &writer, Camera *cam)
+{
+  binary_write_node(writer, cam);
+
+  writer.write(cam->width);
+  writer.write(cam->height);
+  writer.write(cam->full_width);
+  writer.write(cam->full_height);
+}
+
+static void binary_read_camera(BinaryReader &reader, Scene *scene)
+{
+  Camera *cam = scene->camera;
+
+  binary_read_node(reader, cam);
+
+  reader.read(cam->width);
+  reader.read(cam->height);
+  reader.read(cam->full_width);
+  reader.read(cam->full_height);
+
+  cam->need_update = true;
+  cam->update(scene);
+}
+
+/* File */
+
+bool binary_write_file(Scene *scene,
+                       const char *filepath,
+                       const vector<string> &source_filepaths)
+{
+  BinaryWriter writer;
+
+  writer.write(BINARY_FILE_MAGIC, sizeof(BINARY_FILE_MAGIC));
+  writer.write(BINARY_FILE_VERSION);
+  writer.write((int)source_filepaths.size());
+  foreach (const string &source_filepath, source_filepaths) {
+    writer.write_string(source_filepath);
+  }
+  writer.write_string(binary_source_key(source_filepaths));
+
+  /* Shaders and geometry come first, since other nodes refer to them. */
+  writer.write((int)scene->shaders.size());
+  foreach (Shader *shader, scene->shaders) {
+    if (!binary_write_shader(writer, shader)) {
+      return false;
+    }
+  }
+
+  writer.write((int)scene->geometry.size());
+  foreach (Geometry *geom, scene->geometry) {
+    if (geom->type != Geometry::MESH) {
+      fprintf(stderr, "Geometry \"%s\" can't be written to binary file.\n", geom->name.c_str());
+      return false;
+    }
+
+    binary_write_mesh(writer, (Mesh *)geom);
+  }
+
+  writer.write((int)scene->objects.size());
+  foreach (Object *object, scene->objects) {
+    binary_write_node(writer, object);
+  }
+
+  writer.write((int)scene->lights.size());
+  foreach (Light *light, scene->lights) {
+    binary_write_node(writer, light);
+  }
+
+  binary_write_camera(writer, scene->camera);
+  binary_write_node(writer, scene->film);
+  binary_write_node(writer, scene->integrator);
+  binary_write_node(writer, scene->background);
+
+  if (!path_write_binary(filepath, writer.buffer)) {
+    fprintf(stderr, "Failed to write binary file \"%s\".\n", filepath);
+    return false;
+  }
+
+  return true;
+}
+
+bool binary_read_file(Scene *scene, const char *filepath, const char *source_filepath)
+{
+  vector<uint8_t> buffer;
+
+  if (!path_read_binary(filepath, buffer)) {
+    return false;
+  }
+
+  BinaryReader reader(buffer.data(), buffer.size());
+
+  /* Check the file matches this build and source before modifying the scene. */
+  char magic[sizeof(BINARY_FILE_MAGIC)];
+  int version = 0;
+
+  reader.read(magic, sizeof(magic));
+  reader.read(version);
+
+  if (reader.error || memcmp(magic, BINARY_FILE_MAGIC, sizeof(magic)) != 0 ||
+      version != BINARY_FILE_VERSION) {
+    return false;
+  }
+
+  /* All files that were read for the cache, starting with the main XML file. */
+  vector<string> source_filepaths;
+  int num_source_filepaths = 0;
+  reader.read(num_source_filepaths);
+
+  for (int i = 0; i < num_source_filepaths && !reader.error; i++) {
+    string source_filepath;
+    reader.read_string(source_filepath);
+    source_filepaths.push_back(source_filepath);
+  }
+
+  string key;
+  reader.read_string(key);
+
+  if (reader.error || source_filepaths.empty() || source_filepaths[0] != source_filepath ||
+      key.empty() || key != binary_source_key(source_filepaths)) {
+    return false;
+  }
+
+  /* Default shaders already exist in the scene, and are written first. */
+  int num_shaders = 0;
+  reader.read(num_shaders);
+
+  for (int i = 0; i < num_shaders && !reader.error; i++) {
+    Shader *shader;
+
+    if (i < (int)scene->shaders.size()) {
+      shader = scene->shaders[i];
+    }
+    else {
+      shader = new Shader();
+      scene->shaders.push_back(shader);
+    }
+
+    binary_read_shader(reader, scene, shader);
+  }
+
+  int num_geometry = 0;
+  reader.read(num_geometry);
+
+  for (int i = 0; i < num_geometry && !reader.error; i++) {
+    Mesh *mesh = new Mesh();
+    scene->geometry.push_back(mesh);
+    binary_read_mesh(reader, mesh);
+  }
+
+  int num_objects = 0;
+  reader.read(num_objects);
+
+  for (int i = 0; i < num_objects && !reader.error; i++) {
+    Object *object = new Object();
+    scene->objects.push_back(object);
+    binary_read_node(reader, object);
+  }
+
+  int num_lights = 0;
+  reader.read(num_lights);
+
+  for (int i = 0; i < num_lights && !reader.error; i++) {
+    Light *light = new Light();
+    scene->lights.push_back(light);
+    binary_read_node(reader, light);
+  }
+
+  binary_read_camera(reader, scene);
+  binary_read_node(reader, scene->film);
+  binary_read_node(reader, scene->integrator);
+  binary_read_node(reader, scene->background);
+
+  if (reader.error) {
+    fprintf(stderr, "Failed to read binary file \"%s\".\n", filepath);
+    return false;
+  }
+
+  scene->params.bvh_type = SceneParams::BVH_STATIC;
+
+  return true;
+}
+
+CCL_NAMESPACE_END
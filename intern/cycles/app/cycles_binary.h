@@ -0,0 +1,37 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __CYCLES_BINARY_H__
+#define __CYCLES_BINARY_H__
+
+#include "util/util_string.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+class Scene;
+
+/* Binary cache of a scene read from an XML file, so later runs can skip parsing.
+ * The cache is only valid for the same build and the same contents of the XML file and all files
+ * it includes. The source files are passed in the order they were read, main XML file first. */
+bool binary_write_file(Scene *scene,
+                       const char *filepath,
+                       const vector<string> &source_filepaths);
+bool binary_read_file(Scene *scene, const char *filepath, const char *source_filepath);
+
+CCL_NAMESPACE_END
+
+#endif /* __CYCLES_BINARY_H__ */
@@ -17,6 +17,7 @@
 #include <stdio.h>
 
 #include "device/device.h"
+#include "device/device_network.h"
 
 #include "util/util_args.h"
 #include "util/util_foreach.h"
@@ -38,8 +39,9 @@ int main(int argc, const char **argv)
   string devicename = "cpu";
   bool list = false, debug = false;
   int threads = 0, verbosity = 1;
+  int port = SERVER_PORT;
 
-  vector<DeviceType> &types = Device::available_types();
+  vector<DeviceType> types = Device::available_types();
 
   foreach (DeviceType type, types) {
     if (devicelist != "")
@@ -61,6 +63,9 @@ int main(int argc, const char **argv)
              "--threads %d",
              &threads,
              "Number of threads to use for CPU device",
+             "--port %d",
+             &port,
+             "Port to listen on, use different ports to run multiple servers on one machine",
 #ifdef WITH_CYCLES_LOGGING
              "--debug",
              &debug,
@@ -83,7 +88,7 @@ int main(int argc, const char **argv)
   }
 
   if (list) {
-    vector<DeviceInfo> &devices = Device::available_devices();
+    vector<DeviceInfo> devices = Device::available_devices();
 
     printf("Devices:\n");
 
@@ -96,7 +101,7 @@ int main(int argc, const char **argv)
 
   /* find matching device */
   DeviceType device_type = Device::type_from_string(devicename.c_str());
-  vector<DeviceInfo> &devices = Device::available_devices();
+  vector<DeviceInfo> devices = Device::available_devices();
   DeviceInfo device_info;
 
   foreach (DeviceInfo &device, devices) {
@@ -110,9 +115,10 @@ int main(int argc, const char **argv)
 
   while (1) {
     Stats stats;
-    Device *device = Device::create(device_info, stats, true);
+    Profiler profiler;
+    Device *device = Device::create(device_info, stats, profiler, true);
     printf("Cycles Server with device: %s\n", device->info.description.c_str());
-    device->server_run();
+    device->server_run(port);
     delete device;
   }
 
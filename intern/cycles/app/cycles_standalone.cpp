@@ -39,6 +39,7 @@
 #  include "util/util_view.h"
 #endif
 
+#include "app/cycles_binary.h"
 #include "app/cycles_xml.h"
 
 CCL_NAMESPACE_BEGIN
@@ -47,6 +48,9 @@ struct Options {
   Session *session;
   Scene *scene;
   string filepath;
+  string scene_cache_path;
+  double start_time;
+  bool first_sample;
   int width, height;
   SceneParams scene_params;
   SessionParams session_params;
@@ -78,6 +82,12 @@ static void session_print_status()
 
   /* get status */
   float progress = options.session->progress.get_progress();
+
+  if (!options.first_sample && progress > 0.0f) {
+    options.first_sample = true;
+    printf("\nTime to first sample: %.3f seconds\n", time_dt() - options.start_time);
+  }
+
   options.session->progress.get_status(status, substatus);
 
   if (substatus != "")
@@ -127,8 +137,32 @@ static void scene_init()
 {
   options.scene = new Scene(options.scene_params, options.session->device);
 
-  /* Read XML */
-  xml_read_file(options.scene, options.filepath.c_str());
+  double load_time = time_dt();
+  const char *cache_path = options.scene_cache_path.c_str();
+  const char *filepath = options.filepath.c_str();
+
+  /* Read binary cache, or XML and write the cache for the next run. */
+  if (!options.scene_cache_path.empty() && binary_read_file(options.scene, cache_path, filepath)) {
+    VLOG(1) << "Scene read from cache " << options.scene_cache_path;
+  }
+  else {
+    if (!options.scene_cache_path.empty()) {
+      /* Start over in case the cache was only partially read. */
+      delete options.scene;
+      options.scene = new Scene(options.scene_params, options.session->device);
+    }
+
+    vector<string> source_filepaths;
+    xml_read_file(options.scene, filepath, &source_filepaths);
+
+    if (!options.scene_cache_path.empty()) {
+      binary_write_file(options.scene, cache_path, source_filepaths);
+    }
+  }
+
+  if (!options.quiet) {
+    printf("Scene loaded in %.3f seconds\n", time_dt() - load_time);
+  }
 
   /* Camera width/height override? */
   if (!(options.width == 0 || options.height == 0)) {
@@ -369,6 +403,8 @@ static void options_parse(int argc, const char **argv)
   options.filepath = "";
   options.session = NULL;
   options.quiet = false;
+  options.start_time = time_dt();
+  options.first_sample = false;
 
   /* device names */
   string device_names = "";
@@ -416,6 +452,10 @@ static void options_parse(int argc, const char **argv)
              "--output %s",
              &options.output_path,
              "File path to write output image",
+             "--scene-cache %s",
+             &options.scene_cache_path,
+             "Binary scene cache file, written from the XML file and read instead of it on later "
+             "runs",
              "--threads %d",
              &options.session_params.threads,
              "CPU Rendering Threads",
@@ -503,6 +543,12 @@ static void options_parse(int argc, const char **argv)
   if (!devices.empty()) {
     options.session_params.device = devices.front();
     device_available = true;
+
+    /* Render on all servers listed in CYCLES_NETWORK_SERVERS at the same time. */
+    if (device_type == DEVICE_NETWORK && devices.size() > 1) {
+      options.session_params.device = Device::get_multi_device(
+          devices, options.session_params.threads, options.session_params.background);
+    }
   }
 
   /* handle invalid configurations */
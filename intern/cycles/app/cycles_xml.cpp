@@ -51,14 +51,15 @@ CCL_NAMESPACE_BEGIN
 /* XML reading state */
 
 struct XMLReadState : public XMLReader {
-  Scene *scene;      /* scene pointer */
-  Transform tfm;     /* current transform state */
-  bool smooth;       /* smooth normal state */
-  Shader *shader;    /* current shader */
-  string base;       /* base path to current file*/
-  float dicing_rate; /* current dicing rate */
-
-  XMLReadState() : scene(NULL), smooth(false), shader(NULL), dicing_rate(1.0f)
+  Scene *scene;              /* scene pointer */
+  Transform tfm;             /* current transform state */
+  bool smooth;               /* smooth normal state */
+  Shader *shader;            /* current shader */
+  string base;               /* base path to current file*/
+  float dicing_rate;         /* current dicing rate */
+  vector<string> *filepaths; /* files read so far, optional */
+
+  XMLReadState() : scene(NULL), smooth(false), shader(NULL), dicing_rate(1.0f), filepaths(NULL)
   {
     tfm = transform_identity();
   }
@@ -670,6 +671,10 @@ static void xml_read_include(XMLReadState &state, const string &src)
   parse_result = doc.load_file(path.c_str());
 
   if (parse_result) {
+    if (state.filepaths) {
+      state.filepaths->push_back(path);
+    }
+
     XMLReadState substate = state;
     substate.base = path_dirname(path);
 
@@ -684,7 +689,7 @@ static void xml_read_include(XMLReadState &state, const string &src)
 
 /* File */
 
-void xml_read_file(Scene *scene, const char *filepath)
+void xml_read_file(Scene *scene, const char *filepath, vector<string> *r_filepaths)
 {
   XMLReadState state;
 
@@ -694,6 +699,7 @@ void xml_read_file(Scene *scene, const char *filepath)
   state.smooth = false;
   state.dicing_rate = 1.0f;
   state.base = path_dirname(filepath);
+  state.filepaths = r_filepaths;
 
   xml_read_include(state, path_filename(filepath));
 
@@ -17,11 +17,16 @@
 #ifndef __CYCLES_XML_H__
 #define __CYCLES_XML_H__
 
+#include "util/util_string.h"
+#include "util/util_vector.h"
+
 CCL_NAMESPACE_BEGIN
 
 class Scene;
 
-void xml_read_file(Scene *scene, const char *filepath);
+/* Read scene from an XML file. When given, r_filepaths is filled with the paths of the main file
+ * and all included files, in the order they were read. */
+void xml_read_file(Scene *scene, const char *filepath, vector<string> *r_filepaths = NULL);
 
 /* macros for importing */
 #define RAD2DEGF(_rad) ((_rad) * (float)(180.0 / M_PI))
@@ -1223,12 +1223,14 @@ void CUDADevice::tex_alloc(device_memory &mem)
   /* Set Mapping and tag that we need to (re-)upload to device */
   TextureInfo &info = texture_info[flat_slot];
   info.data = (uint64_t)cmem->texobject;
+  info.grid_info = 0;
   info.cl_buffer = 0;
   info.interpolation = mem.interpolation;
   info.extension = mem.extension;
   info.width = mem.data_width;
   info.height = mem.data_height;
   info.depth = mem.data_depth;
+  info.grid_type = IMAGE_GRID_TYPE_DEFAULT;
   need_texture_info = true;
 }
 
@@ -398,9 +398,13 @@ Device *Device::create(DeviceInfo &info, Stats &stats, Profiler &profiler, bool
       break;
 #endif
 #ifdef WITH_NETWORK
-    case DEVICE_NETWORK:
-      device = device_network_create(info, stats, profiler, "127.0.0.1");
+    case DEVICE_NETWORK: {
+      /* Server address is stored in the device ID. */
+      const string address = string_startswith(info.id, "NETWORK_") ? info.id.substr(8) :
+                                                                         "127.0.0.1";
+      device = device_network_create(info, stats, profiler, address.c_str());
       break;
+    }
 #endif
 #ifdef WITH_OPENCL
     case DEVICE_OPENCL:
@@ -597,6 +601,7 @@ DeviceInfo Device::get_multi_device(const vector<DeviceInfo> &subdevices,
 
   info.has_half_images = true;
   info.has_volume_decoupled = true;
+  info.has_sparse_volumes = true;
   info.has_osl = true;
   info.has_profiling = true;
 
@@ -639,6 +644,7 @@ DeviceInfo Device::get_multi_device(const vector<DeviceInfo> &subdevices,
     /* Accumulate device info. */
     info.has_half_images &= device.has_half_images;
     info.has_volume_decoupled &= device.has_volume_decoupled;
+    info.has_sparse_volumes &= device.has_sparse_volumes;
     info.has_osl &= device.has_osl;
     info.has_profiling &= device.has_profiling;
   }
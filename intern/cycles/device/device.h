@@ -78,6 +78,7 @@ class DeviceInfo {
   bool display_device;       /* GPU is used as a display device. */
   bool has_half_images;      /* Support half-float textures. */
   bool has_volume_decoupled; /* Decoupled volume shading. */
+  bool has_sparse_volumes;   /* Support sparse tiled 3D textures. */
   bool has_osl;              /* Support Open Shading Language. */
   bool use_split_kernel;     /* Use split or mega kernel. */
   bool has_profiling;        /* Supports runtime collection of profiling info. */
@@ -94,6 +95,7 @@ class DeviceInfo {
     display_device = false;
     has_half_images = false;
     has_volume_decoupled = false;
+    has_sparse_volumes = false;
     has_osl = false;
     use_split_kernel = false;
     has_profiling = false;
@@ -415,7 +417,7 @@ class Device {
 
 #ifdef WITH_NETWORK
   /* networking */
-  void server_run();
+  void server_run(int port);
 #endif
 
   /* multi device */
@@ -482,12 +482,14 @@ class CPUDevice : public Device {
 
       TextureInfo &info = texture_info[flat_slot];
       info.data = (uint64_t)mem.host_pointer;
+      info.grid_info = (mem.grid_info) ? (uint64_t)mem.grid_info->host_pointer : 0;
       info.cl_buffer = 0;
       info.interpolation = mem.interpolation;
       info.extension = mem.extension;
       info.width = mem.data_width;
       info.height = mem.data_height;
       info.depth = mem.data_depth;
+      info.grid_type = mem.grid_type;
 
       need_texture_info = true;
     }
@@ -1318,6 +1320,7 @@ void device_cpu_info(vector<DeviceInfo> &devices)
   info.id = "CPU";
   info.num = 0;
   info.has_volume_decoupled = true;
+  info.has_sparse_volumes = true;
   info.has_osl = true;
   info.has_half_images = true;
   info.has_profiling = true;
@@ -33,6 +33,8 @@ device_memory::device_memory(Device *device, const char *name, MemoryType type)
       name(name),
       interpolation(INTERPOLATION_NONE),
       extension(EXTENSION_REPEAT),
+      grid_type(IMAGE_GRID_TYPE_DEFAULT),
+      grid_info(NULL),
       device(device),
       device_pointer(0),
       host_pointer(0),
@@ -210,6 +210,9 @@ class device_memory {
   const char *name;
   InterpolationType interpolation;
   ExtensionType extension;
+  /* Voxel layout and tile offsets memory of 3D textures. */
+  ImageGridType grid_type;
+  device_memory *grid_info;
 
   /* Pointers. */
   Device *device;
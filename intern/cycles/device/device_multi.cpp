@@ -68,6 +68,13 @@ class MultiDevice : public Device {
     }
 
 #ifdef WITH_NETWORK
+    /* Servers were specified explicitly, no need to look for others. */
+    foreach (DeviceInfo &subinfo, info.multi_devices) {
+      if (subinfo.type == DEVICE_NETWORK) {
+        return;
+      }
+    }
+
     /* try to add network devices */
     ServerDiscovery discovery(true);
     time_sleep(1.0);
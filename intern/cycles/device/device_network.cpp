@@ -20,6 +20,8 @@
 
 #include "util/util_foreach.h"
 #include "util/util_logging.h"
+#include "util/util_math.h"
+#include "util/util_time.h"
 
 #if defined(WITH_NETWORK)
 
@@ -47,23 +49,33 @@ class NetworkDevice : public Device {
   tcp::socket socket;
   device_ptr mem_counter;
   DeviceTask the_task; /* todo: handle multiple tasks */
+  string address;
 
   thread_mutex rpc_lock;
+  thread *service_thread;
 
   virtual bool show_samples() const
   {
     return false;
   }
 
-  NetworkDevice(DeviceInfo &info, Stats &stats, Profiler &profiler, const char *address)
-      : Device(info, stats, profiler, true), socket(io_service)
+  NetworkDevice(DeviceInfo &info, Stats &stats, Profiler &profiler, const char *address_)
+      : Device(info, stats, profiler, true),
+        socket(io_service),
+        address(address_),
+        service_thread(NULL)
   {
     error_func = NetworkError();
+
+    string host;
+    int port;
+    network_address_parse(address, host, port);
+
     stringstream portstr;
-    portstr << SERVER_PORT;
+    portstr << port;
 
     tcp::resolver resolver(io_service);
-    tcp::resolver::query query(address, portstr.str());
+    tcp::resolver::query query(host, portstr.str());
     tcp::resolver::iterator endpoint_iterator = resolver.resolve(query);
     tcp::resolver::iterator end;
 
@@ -81,6 +93,8 @@ class NetworkDevice : public Device {
 
   ~NetworkDevice()
   {
+    task_wait();
+
     RPCSend snd(socket, &error_func, "stop");
     snd.write();
   }
@@ -111,11 +125,34 @@ class NetworkDevice : public Device {
   {
     thread_scoped_lock lock(rpc_lock);
 
+    size_t data_size = mem.memory_size();
+
+    /* Large buffers are announced by their content hash first, the server then tells whether it
+     * still has the same data from an earlier session and the transfer can be skipped. */
+    string hash;
+    if (data_size >= NETWORK_CACHE_MIN_SIZE) {
+      hash = network_data_hash(mem.host_pointer, data_size);
+    }
+
     RPCSend snd(socket, &error_func, "mem_copy_to");
 
     snd.add(mem);
+    snd.add(hash);
     snd.write();
-    snd.write_buffer(mem.host_pointer, mem.memory_size());
+
+    bool cached = false;
+    if (!hash.empty()) {
+      RPCReceive rcv(socket, &error_func);
+      rcv.read(cached);
+    }
+
+    if (cached) {
+      VLOG(2) << "Buffer " << ((mem.name) ? mem.name : "") << " found in cache of server "
+              << address << ", skipping transfer.";
+    }
+    else {
+      snd.write_buffer(mem.host_pointer, data_size);
+    }
   }
 
   void mem_copy_from(device_memory &mem, int y, int w, int h, int elem)
@@ -183,10 +220,7 @@ class NetworkDevice : public Device {
     thread_scoped_lock lock(rpc_lock);
 
     RPCSend snd(socket, &error_func, "load_kernels");
-    snd.add(requested_features.experimental);
-    snd.add(requested_features.max_closure);
-    snd.add(requested_features.max_nodes_group);
-    snd.add(requested_features.nodes_features);
+    snd.add(requested_features);
     snd.write();
 
     bool result;
@@ -198,6 +232,9 @@ class NetworkDevice : public Device {
 
   void task_add(DeviceTask &task)
   {
+    /* The server runs one task at a time. */
+    task_wait();
+
     thread_scoped_lock lock(rpc_lock);
 
     the_task = task;
@@ -205,9 +242,24 @@ class NetworkDevice : public Device {
     RPCSend snd(socket, &error_func, "task_add");
     snd.add(task);
     snd.write();
+
+    lock.unlock();
+
+    /* Serve the task from a separate thread, so that multiple servers in a multi device render
+     * at the same time instead of one after the other in task_wait(). */
+    service_thread = new thread(function_bind(&NetworkDevice::task_service, this));
   }
 
   void task_wait()
+  {
+    if (service_thread) {
+      service_thread->join();
+      delete service_thread;
+      service_thread = NULL;
+    }
+  }
+
+  void task_service()
   {
     thread_scoped_lock lock(rpc_lock);
 
@@ -218,7 +270,11 @@ class NetworkDevice : public Device {
 
     TileList the_tiles;
 
-    /* todo: run this threaded for connecting to multiple clients */
+    /* Statistics to report the throughput of this server. */
+    const double start_time = time_dt();
+    uint64_t pixel_samples = 0;
+    int num_tiles = 0;
+
     for (;;) {
       if (error_func.have_error())
         break;
@@ -229,24 +285,33 @@ class NetworkDevice : public Device {
       RPCReceive rcv(socket, &error_func);
 
       if (rcv.name == "acquire_tile") {
+        int max_tiles;
+        rcv.read(max_tiles);
         lock.unlock();
 
+        /* Hand out as many tiles as the server asks for based on its throughput. Tiles come from
+         * the shared tile manager, so faster servers take a larger share of the work. Denoising
+         * tiles may wait for neighbors rendered by this server, so those go one at a time. */
+        if (the_task.tile_types & RenderTile::DENOISE) {
+          max_tiles = 1;
+        }
+
+        vector<RenderTile> tiles;
+
         /* todo: watch out for recursive calls! */
-        if (the_task.acquire_tile(this, tile)) { /* write return as bool */
+        while ((int)tiles.size() < max_tiles && the_task.acquire_tile(this, tile, the_task.tile_types)) {
           the_tiles.push_back(tile);
-
-          lock.lock();
-          RPCSend snd(socket, &error_func, "acquire_tile");
-          snd.add(tile);
-          snd.write();
-          lock.unlock();
+          tiles.push_back(tile);
         }
-        else {
-          lock.lock();
-          RPCSend snd(socket, &error_func, "acquire_tile_none");
-          snd.write();
-          lock.unlock();
+
+        lock.lock();
+        RPCSend snd(socket, &error_func, "acquire_tile");
+        snd.add((int)tiles.size());
+        foreach (RenderTile &acquired_tile, tiles) {
+          snd.add(acquired_tile);
         }
+        snd.write();
+        lock.unlock();
       }
       else if (rcv.name == "release_tile") {
         rcv.read(tile);
@@ -260,6 +325,9 @@ class NetworkDevice : public Device {
 
         assert(tile.buffers != NULL);
 
+        pixel_samples += (uint64_t)tile.w * tile.h * tile.num_samples;
+        num_tiles++;
+
         the_task.release_tile(tile);
 
         lock.lock();
@@ -267,6 +335,31 @@ class NetworkDevice : public Device {
         snd.write();
         lock.unlock();
       }
+      else if (rcv.name == "update_tile_sample") {
+        rcv.read(tile);
+        lock.unlock();
+
+        /* Intermediate result of a tile still being rendered, for progressive display. */
+        TileList::iterator it = tile_list_find(the_tiles, tile);
+        if (it != the_tiles.end()) {
+          tile.buffers = it->buffers;
+          the_task.update_tile_sample(tile);
+        }
+
+        lock.lock();
+        RPCSend snd(socket, &error_func, "update_tile_sample");
+        snd.write();
+        lock.unlock();
+      }
+      else if (rcv.name == "update_progress_sample") {
+        long progress_pixel_samples;
+        int sample;
+        rcv.read(progress_pixel_samples);
+        rcv.read(sample);
+        lock.unlock();
+
+        the_task.update_progress_sample(progress_pixel_samples, sample);
+      }
       else if (rcv.name == "task_wait_done") {
         lock.unlock();
         break;
@@ -274,6 +367,13 @@ class NetworkDevice : public Device {
       else
         lock.unlock();
     }
+
+    const double elapsed = time_dt() - start_time;
+    if (num_tiles > 0 && elapsed > 0.0) {
+      VLOG(1) << "Network device " << address << " rendered " << num_tiles << " tiles, "
+              << string_human_readable_number((size_t)(pixel_samples / elapsed))
+              << " pixel samples per second.";
+    }
   }
 
   void task_cancel()
@@ -302,20 +402,93 @@ Device *device_network_create(DeviceInfo &info,
 
 void device_network_info(vector<DeviceInfo> &devices)
 {
-  DeviceInfo info;
+  /* Servers are listed as host[:port] separated by commas, which allows running multiple
+   * servers on the same machine. By default a single server on the local machine is used. */
+  vector<string> addresses;
+  const char *servers = getenv("CYCLES_NETWORK_SERVERS");
+
+  if (servers) {
+    string_split(addresses, servers, ", ");
+  }
+  if (addresses.empty()) {
+    addresses.push_back("127.0.0.1");
+  }
+
+  int num = 0;
 
-  info.type = DEVICE_NETWORK;
-  info.description = "Network Device";
-  info.id = "NETWORK";
-  info.num = 0;
+  foreach (const string &address, addresses) {
+    DeviceInfo info;
 
-  /* todo: get this info from device */
-  info.has_volume_decoupled = false;
-  info.has_osl = false;
+    info.type = DEVICE_NETWORK;
+    info.description = "Network Device (" + address + ")";
+    info.id = "NETWORK_" + address;
+    info.num = num++;
 
-  devices.push_back(info);
+    /* todo: get this info from device */
+    info.has_volume_decoupled = false;
+    info.has_osl = false;
+
+    devices.push_back(info);
+  }
 }
 
+/* Cache of device memory contents received by the server. It is kept across client sessions, so
+ * scene data that did not change does not need to be transferred again. Entries are identified
+ * by the content hash computed by the client, least recently used ones are removed when the
+ * cache exceeds its maximum size. */
+class NetworkDataCache {
+ public:
+  explicit NetworkDataCache(size_t max_size) : max_size(max_size), total_size(0)
+  {
+  }
+
+  bool find(const string &hash, void *data, size_t size)
+  {
+    for (list<Entry>::iterator it = entries.begin(); it != entries.end(); ++it) {
+      if (it->hash == hash && it->data.size() == size) {
+        memcpy(data, &it->data[0], size);
+
+        /* Move to the front of the list as most recently used. */
+        entries.splice(entries.begin(), entries, it);
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  void insert(const string &hash, const void *data, size_t size)
+  {
+    if (size == 0 || size > max_size) {
+      return;
+    }
+
+    while (total_size + size > max_size) {
+      total_size -= entries.back().data.size();
+      entries.pop_back();
+    }
+
+    entries.push_front(Entry());
+
+    Entry &entry = entries.front();
+    entry.hash = hash;
+    entry.data.resize(size);
+    memcpy(&entry.data[0], data, size);
+
+    total_size += size;
+  }
+
+ protected:
+  struct Entry {
+    string hash;
+    DataVector data;
+  };
+
+  list<Entry> entries;
+  size_t max_size;
+  size_t total_size;
+};
+
 class DeviceServer {
  public:
   thread_mutex rpc_lock;
@@ -330,8 +503,18 @@ class DeviceServer {
     return error_func.have_error();
   }
 
-  DeviceServer(Device *device_, tcp::socket &socket_)
-      : device(device_), socket(socket_), stop(false), blocked_waiting(false)
+  DeviceServer(Device *device_, tcp::socket &socket_, NetworkDataCache &cache_)
+      : device(device_),
+        socket(socket_),
+        cache(cache_),
+        reply_received(false),
+        num_released_tiles(0),
+        task_start_time(0.0),
+        progress_pixel_samples(0),
+        progress_sample(0),
+        progress_time(0.0),
+        stop(false),
+        blocked_waiting(false)
   {
     error_func = NetworkError();
   }
@@ -456,10 +639,10 @@ class DeviceServer {
       pointer_mapping_insert(client_pointer, mem.device_pointer);
     }
     else if (rcv.name == "mem_copy_to") {
-      string name;
+      string name, hash;
       network_device_memory mem(device);
       rcv.read(mem, name);
-      lock.unlock();
+      rcv.read(hash);
 
       size_t data_size = mem.memory_size();
       device_ptr client_pointer = mem.device_pointer;
@@ -478,8 +661,25 @@ class DeviceServer {
         mem.host_pointer = (data_size) ? (void *)&(data_v[0]) : 0;
       }
 
-      /* Copy data from network into memory buffer. */
-      rcv.read_buffer((uint8_t *)mem.host_pointer, data_size);
+      if (!hash.empty()) {
+        /* Reuse data from an earlier session if possible, and tell the client whether it
+         * still needs to send it. */
+        bool cached = cache.find(hash, mem.host_pointer, data_size);
+
+        RPCSend snd(socket, &error_func, "mem_copy_to");
+        snd.add(cached);
+        snd.write();
+
+        if (!cached) {
+          rcv.read_buffer((uint8_t *)mem.host_pointer, data_size);
+          cache.insert(hash, mem.host_pointer, data_size);
+        }
+      }
+      else {
+        /* Copy data from network into memory buffer. */
+        rcv.read_buffer((uint8_t *)mem.host_pointer, data_size);
+      }
+      lock.unlock();
 
       /* Copy the data from the memory buffer to the device buffer. */
       device->mem_copy_to(mem);
@@ -505,7 +705,7 @@ class DeviceServer {
 
       DataVector &data_v = data_vector_find(client_pointer);
 
-      mem.host_pointer = (device_ptr) & (data_v[0]);
+      mem.host_pointer = (void *)&(data_v[0]);
 
       device->mem_copy_from(mem, y, w, h, elem);
 
@@ -536,7 +736,7 @@ class DeviceServer {
       else {
         /* Allocate host side data buffer. */
         DataVector &data_v = data_vector_insert(client_pointer, data_size);
-        mem.host_pointer = (void *) ? (device_ptr) & (data_v[0]) : 0;
+        mem.host_pointer = (data_size) ? (void *)&(data_v[0]) : 0;
       }
 
       /* Zero memory. */
@@ -575,10 +775,7 @@ class DeviceServer {
     }
     else if (rcv.name == "load_kernels") {
       DeviceRequestedFeatures requested_features;
-      rcv.read(requested_features.experimental);
-      rcv.read(requested_features.max_closure);
-      rcv.read(requested_features.max_nodes_group);
-      rcv.read(requested_features.nodes_features);
+      rcv.read(requested_features);
 
       bool result;
       result = device->load_kernels(requested_features);
@@ -608,13 +805,16 @@ class DeviceServer {
       if (task.shader_output)
         task.shader_output = device_ptr_from_client_pointer(task.shader_output);
 
-      task.acquire_tile = function_bind(&DeviceServer::task_acquire_tile, this, _1, _2);
+      task.acquire_tile = function_bind(&DeviceServer::task_acquire_tile, this, _1, _2, _3);
       task.release_tile = function_bind(&DeviceServer::task_release_tile, this, _1);
-      task.update_progress_sample = function_bind(&DeviceServer::task_update_progress_sample,
-                                                  this);
+      task.update_progress_sample = function_bind(
+          &DeviceServer::task_update_progress_sample, this, _1, _2);
       task.update_tile_sample = function_bind(&DeviceServer::task_update_tile_sample, this, _1);
       task.get_cancel = function_bind(&DeviceServer::task_get_cancel, this);
 
+      num_released_tiles = 0;
+      task_start_time = time_dt();
+
       device->task_add(task);
     }
     else if (rcv.name == "task_wait") {
@@ -634,22 +834,20 @@ class DeviceServer {
       device->task_cancel();
     }
     else if (rcv.name == "acquire_tile") {
-      AcquireEntry entry;
-      entry.name = rcv.name;
-      rcv.read(entry.tile);
-      acquire_queue.push_back(entry);
-      lock.unlock();
-    }
-    else if (rcv.name == "acquire_tile_none") {
-      AcquireEntry entry;
-      entry.name = rcv.name;
-      acquire_queue.push_back(entry);
+      int num_tiles;
+      rcv.read(num_tiles);
+
+      for (int i = 0; i < num_tiles; i++) {
+        RenderTile tile;
+        rcv.read(tile);
+        tile_queue.push_back(tile);
+      }
+
+      reply_received = true;
       lock.unlock();
     }
-    else if (rcv.name == "release_tile") {
-      AcquireEntry entry;
-      entry.name = rcv.name;
-      acquire_queue.push_back(entry);
+    else if (rcv.name == "release_tile" || rcv.name == "update_tile_sample") {
+      reply_received = true;
       lock.unlock();
     }
     else {
@@ -658,92 +856,128 @@ class DeviceServer {
     }
   }
 
-  bool task_acquire_tile(Device *, RenderTile &tile)
+  /* Wait for the client to reply to a tile request, processing incoming calls meanwhile.
+   * Only one request is in flight at a time, acquire_mutex must be held by the caller. */
+  void wait_reply()
   {
-    thread_scoped_lock acquire_lock(acquire_mutex);
-
-    bool result = false;
-
-    RPCSend snd(socket, &error_func, "acquire_tile");
-    snd.write();
-
-    do {
+    while (!stop && !have_error()) {
       if (blocked_waiting)
         listen_step();
 
       /* todo: avoid busy wait loop */
       thread_scoped_lock lock(rpc_lock);
 
-      if (!acquire_queue.empty()) {
-        AcquireEntry entry = acquire_queue.front();
-        acquire_queue.pop_front();
-
-        if (entry.name == "acquire_tile") {
-          tile = entry.tile;
+      if (reply_received) {
+        reply_received = false;
+        break;
+      }
+    }
+  }
 
-          if (tile.buffer)
-            tile.buffer = ptr_map[tile.buffer];
+  /* Number of tiles to request at once, enough to keep this server busy for the prefetch
+   * time at the throughput measured so far in the task. */
+  int prefetch_tile_count()
+  {
+    const double elapsed = time_dt() - task_start_time;
 
-          result = true;
-          break;
-        }
-        else if (entry.name == "acquire_tile_none") {
-          break;
-        }
-        else {
-          cout << "Error: unexpected acquire RPC receive call \"" + entry.name + "\"\n";
-        }
-      }
-    } while (acquire_queue.empty() && !stop && !have_error());
+    if (num_released_tiles == 0 || elapsed <= 0.0) {
+      return 1;
+    }
 
-    return result;
+    const double tiles_per_second = num_released_tiles / elapsed;
+    return clamp((int)(tiles_per_second * NETWORK_PREFETCH_TIME), 1, NETWORK_PREFETCH_MAX_TILES);
   }
 
-  void task_update_progress_sample()
+  bool task_acquire_tile(Device *, RenderTile &tile, uint /*tile_types*/)
   {
-    ; /* skip */
+    thread_scoped_lock acquire_lock(acquire_mutex);
+
+    /* Request a new batch of tiles when all received tiles are handed out. */
+    if (tile_queue.empty()) {
+      RPCSend snd(socket, &error_func, "acquire_tile");
+      snd.add(prefetch_tile_count());
+      snd.write();
+
+      wait_reply();
+    }
+
+    thread_scoped_lock lock(rpc_lock);
+
+    if (tile_queue.empty()) {
+      return false;
+    }
+
+    tile = tile_queue.front();
+    tile_queue.pop_front();
+
+    if (tile.buffer)
+      tile.buffer = ptr_map[tile.buffer];
+
+    return true;
   }
 
-  void task_update_tile_sample(RenderTile &)
+  /* Send accumulated progress to the client, acquire_mutex must be held by the caller. */
+  void send_progress()
   {
-    ; /* skip */
+    if (progress_pixel_samples == 0) {
+      return;
+    }
+
+    RPCSend snd(socket, &error_func, "update_progress_sample");
+    snd.add(progress_pixel_samples);
+    snd.add(progress_sample);
+    snd.write();
+
+    progress_pixel_samples = 0;
+    progress_time = time_dt();
   }
 
-  void task_release_tile(RenderTile &tile)
+  void task_update_progress_sample(long pixel_samples, int sample)
   {
     thread_scoped_lock acquire_lock(acquire_mutex);
 
-    if (tile.buffer)
-      tile.buffer = ptr_imap[tile.buffer];
+    /* Progress is reported for every sample of every tile, so accumulate it to avoid flooding
+     * the network with small messages. */
+    progress_pixel_samples += pixel_samples;
+    progress_sample = sample;
 
-    {
-      thread_scoped_lock lock(rpc_lock);
-      RPCSend snd(socket, &error_func, "release_tile");
-      snd.add(tile);
-      snd.write();
-      lock.unlock();
+    if (time_dt() - progress_time >= 0.1) {
+      send_progress();
     }
+  }
 
-    do {
-      if (blocked_waiting)
-        listen_step();
+  void task_update_tile_sample(RenderTile &tile)
+  {
+    thread_scoped_lock acquire_lock(acquire_mutex);
 
-      /* todo: avoid busy wait loop */
-      thread_scoped_lock lock(rpc_lock);
+    RenderTile client_tile = tile;
 
-      if (!acquire_queue.empty()) {
-        AcquireEntry entry = acquire_queue.front();
-        acquire_queue.pop_front();
+    if (client_tile.buffer)
+      client_tile.buffer = ptr_imap[client_tile.buffer];
 
-        if (entry.name == "release_tile") {
-          lock.unlock();
-          break;
-        }
-        else {
-          cout << "Error: unexpected release RPC receive call \"" + entry.name + "\"\n";
-        }
-      }
-    } while (acquire_queue.empty() && !stop);
+    /* The client copies the intermediate result from the device while we wait. */
+    RPCSend snd(socket, &error_func, "update_tile_sample");
+    snd.add(client_tile);
+    snd.write();
+
+    wait_reply();
+  }
+
+  void task_release_tile(RenderTile &tile)
+  {
+    thread_scoped_lock acquire_lock(acquire_mutex);
+
+    send_progress();
+    num_released_tiles++;
+
+    if (tile.buffer)
+      tile.buffer = ptr_imap[tile.buffer];
+
+    RPCSend snd(socket, &error_func, "release_tile");
+    snd.add(tile);
+    snd.write();
+
+    wait_reply();
   }
 
   bool task_get_cancel()
@@ -760,13 +994,23 @@ class DeviceServer {
   PtrMap ptr_imap;
   DataMap mem_data;
 
-  struct AcquireEntry {
-    string name;
-    RenderTile tile;
-  };
+  /* data cache shared by all connections */
+  NetworkDataCache &cache;
 
+  /* Tile requests and their replies. All calls to the client from device threads are made
+   * while holding acquire_mutex, so there is at most one outstanding request. */
   thread_mutex acquire_mutex;
-  list<AcquireEntry> acquire_queue;
+  list<RenderTile> tile_queue;
+  bool reply_received;
+
+  /* throughput measurement for tile prefetching */
+  int num_released_tiles;
+  double task_start_time;
+
+  /* accumulated progress not sent to the client yet */
+  long progress_pixel_samples;
+  int progress_sample;
+  double progress_time;
 
   bool stop;
   bool blocked_waiting;
@@ -777,16 +1021,19 @@ class DeviceServer {
   /* todo: free memory and device (osl) on network error */
 };
 
-void Device::server_run()
+void Device::server_run(int port)
 {
   try {
     /* starts thread that responds to discovery requests */
     ServerDiscovery discovery;
 
+    /* cache scene data across connections */
+    NetworkDataCache cache(NETWORK_CACHE_MAX_SIZE);
+
     for (;;) {
       /* accept connection */
       boost::asio::io_service io_service;
-      tcp::acceptor acceptor(io_service, tcp::endpoint(tcp::v4(), SERVER_PORT));
+      tcp::acceptor acceptor(io_service, tcp::endpoint(tcp::v4(), port));
 
       tcp::socket socket(io_service);
       acceptor.accept(socket);
@@ -794,7 +1041,7 @@ void Device::server_run()
       string remote_address = socket.remote_endpoint().address().to_string();
       printf("Connected to remote client at: %s\n", remote_address.c_str());
 
-      DeviceServer server(this, socket);
+      DeviceServer server(this, socket, cache);
       server.listen();
 
       printf("Disconnected.\n");
@@ -37,9 +37,12 @@
 
 #  include "util/util_foreach.h"
 #  include "util/util_list.h"
+#  include "util/util_logging.h"
 #  include "util/util_map.h"
+#  include "util/util_md5.h"
 #  include "util/util_param.h"
 #  include "util/util_string.h"
+#  include "util/util_thread.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -56,6 +59,17 @@ static const int DISCOVER_PORT = 5121;
 static const string DISCOVER_REQUEST_MSG = "REQUEST_RENDER_SERVER_IP";
 static const string DISCOVER_REPLY_MSG = "REPLY_RENDER_SERVER_IP";
 
+/* Device memory of at least this size is identified by its content hash, so servers can reuse
+ * data received in an earlier session instead of transferring it again. */
+static const size_t NETWORK_CACHE_MIN_SIZE = 1024 * 1024;
+/* Maximum amount of memory a server uses to cache data across sessions. */
+static const size_t NETWORK_CACHE_MAX_SIZE = (size_t)4 * 1024 * 1024 * 1024;
+
+/* Servers request as many tiles at once as they render in this time, measured by their
+ * throughput, to hide network latency without holding on to work other servers could do. */
+static const double NETWORK_PREFETCH_TIME = 0.25;
+static const int NETWORK_PREFETCH_MAX_TILES = 16;
+
 #  if 0
 typedef boost::archive::text_oarchive o_archive;
 typedef boost::archive::text_iarchive i_archive;
@@ -118,7 +132,7 @@ class RPCSend {
   {
     archive &name_;
     error_func = e;
-    fprintf(stderr, "rpc send %s\n", name.c_str());
+    VLOG(4) << "RPC send " << name;
   }
 
   ~RPCSend()
@@ -148,16 +162,34 @@ class RPCSend {
     archive &task.shader_input &task.shader_output &task.shader_eval_type;
     archive &task.shader_x &task.shader_w;
     archive &task.need_finish_queue;
+    archive &task.tile_types &task.pass_stride &task.integrator_branched;
+    archive &task.adaptive_sampling.use &task.adaptive_sampling.adaptive_step;
+    archive &task.adaptive_sampling.min_samples;
   }
 
   void add(const RenderTile &tile)
   {
-    archive &tile.x &tile.y &tile.w &tile.h;
+    int task = (int)tile.task;
+    archive &task &tile.x &tile.y &tile.w &tile.h;
     archive &tile.start_sample &tile.num_samples &tile.sample;
-    archive &tile.resolution &tile.offset &tile.stride;
+    archive &tile.resolution &tile.offset &tile.stride &tile.tile_index;
     archive &tile.buffer;
   }
 
+  void add(const DeviceRequestedFeatures &requested_features)
+  {
+    archive &requested_features.experimental &requested_features.max_nodes_group;
+    archive &requested_features.nodes_features &requested_features.use_hair;
+    archive &requested_features.use_object_motion &requested_features.use_camera_motion;
+    archive &requested_features.use_baking &requested_features.use_subsurface;
+    archive &requested_features.use_volume &requested_features.use_integrator_branched;
+    archive &requested_features.use_patch_evaluation &requested_features.use_transparent;
+    archive &requested_features.use_shadow_tricks &requested_features.use_principled;
+    archive &requested_features.use_denoising &requested_features.use_shader_raytrace;
+    archive &requested_features.use_true_displacement;
+    archive &requested_features.use_background_light;
+  }
+
   void write()
   {
     boost::system::error_code error;
@@ -246,7 +278,7 @@ class RPCReceive {
           archive = new i_archive(*archive_stream);
 
           *archive &name;
-          fprintf(stderr, "rpc receive %s\n", name.c_str());
+          VLOG(4) << "RPC receive " << name;
         }
         else {
           error_func->network_error("Network receive error: data size doesn't match header");
@@ -312,20 +344,40 @@ class RPCReceive {
     *archive &task.shader_input &task.shader_output &task.shader_eval_type;
     *archive &task.shader_x &task.shader_w;
     *archive &task.need_finish_queue;
+    *archive &task.tile_types &task.pass_stride &task.integrator_branched;
+    *archive &task.adaptive_sampling.use &task.adaptive_sampling.adaptive_step;
+    *archive &task.adaptive_sampling.min_samples;
 
     task.type = (DeviceTask::Type)type;
   }
 
   void read(RenderTile &tile)
   {
-    *archive &tile.x &tile.y &tile.w &tile.h;
+    int task;
+
+    *archive &task &tile.x &tile.y &tile.w &tile.h;
     *archive &tile.start_sample &tile.num_samples &tile.sample;
-    *archive &tile.resolution &tile.offset &tile.stride;
+    *archive &tile.resolution &tile.offset &tile.stride &tile.tile_index;
     *archive &tile.buffer;
 
+    tile.task = (RenderTile::Task)task;
     tile.buffers = NULL;
   }
 
+  void read(DeviceRequestedFeatures &requested_features)
+  {
+    *archive &requested_features.experimental &requested_features.max_nodes_group;
+    *archive &requested_features.nodes_features &requested_features.use_hair;
+    *archive &requested_features.use_object_motion &requested_features.use_camera_motion;
+    *archive &requested_features.use_baking &requested_features.use_subsurface;
+    *archive &requested_features.use_volume &requested_features.use_integrator_branched;
+    *archive &requested_features.use_patch_evaluation &requested_features.use_transparent;
+    *archive &requested_features.use_shadow_tricks &requested_features.use_principled;
+    *archive &requested_features.use_denoising &requested_features.use_shader_raytrace;
+    *archive &requested_features.use_true_displacement;
+    *archive &requested_features.use_background_light;
+  }
+
   string name;
 
  protected:
@@ -336,6 +388,40 @@ class RPCReceive {
   NetworkError *error_func;
 };
 
+/* Parse a server address of the form host[:port]. */
+
+static inline void network_address_parse(const string &address, string &host, int &port)
+{
+  size_t pos = address.rfind(':');
+
+  if (pos != string::npos) {
+    host = address.substr(0, pos);
+    port = atoi(address.substr(pos + 1).c_str());
+  }
+  else {
+    host = address;
+    port = SERVER_PORT;
+  }
+}
+
+/* Content hash of device memory, used to identify data cached on servers. */
+
+static inline string network_data_hash(const void *data, size_t size)
+{
+  MD5Hash md5;
+  const uint8_t *bytes = (const uint8_t *)data;
+
+  /* MD5Hash takes sizes as int, so feed large buffers in chunks. */
+  while (size > 0) {
+    const int chunk = (size > (size_t)(1 << 30)) ? (1 << 30) : (int)size;
+    md5.append(bytes, chunk);
+    bytes += chunk;
+    size -= chunk;
+  }
+
+  return md5.get_hex();
+}
+
 /* Server auto discovery */
 
 class ServerDiscovery {
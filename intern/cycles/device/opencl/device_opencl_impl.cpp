@@ -1293,7 +1293,9 @@ void OpenCLDevice::flush_texture_buffers()
 
     MemoryManager::BufferDescriptor desc = memory_manager.get_descriptor(slot.name);
     info.data = desc.offset;
+    info.grid_info = 0;
     info.cl_buffer = desc.device_buffer;
+    info.grid_type = IMAGE_GRID_TYPE_DEFAULT;
 
     if (string_startswith(slot.name, "__tex_image")) {
       device_memory *mem = textures[slot.name];
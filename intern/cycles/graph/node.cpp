@@ -133,7 +133,7 @@ void Node::set(const SocketType &input, const Transform &value)
 
 void Node::set(const SocketType &input, Node *value)
 {
-  assert(input.type == SocketType::TRANSFORM);
+  assert(input.type == SocketType::NODE);
   get_socket_value<Node *>(this, input) = value;
 }
 
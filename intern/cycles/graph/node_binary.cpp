@@ -0,0 +1,310 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "graph/node_binary.h"
+
+#include "util/util_foreach.h"
+#include "util/util_transform.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Node references are stored as index into the nodes written before, -1 for none. */
+
+void BinaryWriter::write_node_ref(const Node *node)
+{
+  int index = -1;
+
+  if (node) {
+    map<const Node *, int>::iterator it = node_index.find(node);
+    if (it != node_index.end()) {
+      index = it->second;
+    }
+    else {
+      fprintf(stderr, "Reference to unknown node \"%s\" not written.\n", node->name.c_str());
+    }
+  }
+
+  write(index);
+}
+
+Node *BinaryReader::read_node_ref()
+{
+  int index = -1;
+  read(index);
+
+  if (index < -1 || index >= (int)nodes.size()) {
+    error = true;
+    return NULL;
+  }
+
+  return (index == -1) ? NULL : nodes[index];
+}
+
+template<typename T>
+static void binary_write_value_array(BinaryWriter &writer, const array<T> &value)
+{
+  writer.write_array(value.data(), value.size());
+}
+
+template<typename T>
+static void binary_read_value_array(BinaryReader &reader, Node *node, const SocketType &socket)
+{
+  array<T> value;
+  if (reader.read_array(value)) {
+    node->set(socket, value);
+  }
+}
+
+template<typename T>
+static void binary_read_value(BinaryReader &reader, Node *node, const SocketType &socket)
+{
+  T value;
+  if (reader.read(value)) {
+    node->set(socket, value);
+  }
+}
+
+static bool binary_socket_skip(const SocketType &socket)
+{
+  return (socket.type == SocketType::CLOSURE || socket.type == SocketType::UNDEFINED);
+}
+
+void binary_write_node(BinaryWriter &writer, const Node *node)
+{
+  writer.write_string(node->type->name.string());
+  writer.write_string(node->name.string());
+
+  int num_sockets = 0;
+  foreach (const SocketType &socket, node->type->inputs) {
+    num_sockets += (binary_socket_skip(socket)) ? 0 : 1;
+  }
+  writer.write(num_sockets);
+
+  foreach (const SocketType &socket, node->type->inputs) {
+    if (binary_socket_skip(socket)) {
+      continue;
+    }
+
+    switch (socket.type) {
+      case SocketType::BOOLEAN:
+        writer.write(node->get_bool(socket));
+        break;
+      case SocketType::FLOAT:
+        writer.write(node->get_float(socket));
+        break;
+      case SocketType::INT:
+      case SocketType::ENUM:
+        writer.write(node->get_int(socket));
+        break;
+      case SocketType::UINT:
+        writer.write(node->get_uint(socket));
+        break;
+      case SocketType::COLOR:
+      case SocketType::VECTOR:
+      case SocketType::POINT:
+      case SocketType::NORMAL:
+        writer.write(node->get_float3(socket));
+        break;
+      case SocketType::POINT2:
+        writer.write(node->get_float2(socket));
+        break;
+      case SocketType::STRING:
+        writer.write_string(node->get_string(socket).string());
+        break;
+      case SocketType::TRANSFORM:
+        writer.write(node->get_transform(socket));
+        break;
+      case SocketType::NODE:
+        writer.write_node_ref(node->get_node(socket));
+        break;
+      case SocketType::BOOLEAN_ARRAY:
+        binary_write_value_array(writer, node->get_bool_array(socket));
+        break;
+      case SocketType::FLOAT_ARRAY:
+        binary_write_value_array(writer, node->get_float_array(socket));
+        break;
+      case SocketType::INT_ARRAY:
+        binary_write_value_array(writer, node->get_int_array(socket));
+        break;
+      case SocketType::COLOR_ARRAY:
+      case SocketType::VECTOR_ARRAY:
+      case SocketType::POINT_ARRAY:
+      case SocketType::NORMAL_ARRAY:
+        binary_write_value_array(writer, node->get_float3_array(socket));
+        break;
+      case SocketType::POINT2_ARRAY:
+        binary_write_value_array(writer, node->get_float2_array(socket));
+        break;
+      case SocketType::TRANSFORM_ARRAY:
+        binary_write_value_array(writer, node->get_transform_array(socket));
+        break;
+      case SocketType::STRING_ARRAY: {
+        const array<ustring> &value = node->get_string_array(socket);
+        writer.write((uint64_t)value.size());
+        for (size_t i = 0; i < value.size(); i++) {
+          writer.write_string(value[i].string());
+        }
+        break;
+      }
+      case SocketType::NODE_ARRAY: {
+        const array<Node *> &value = node->get_node_array(socket);
+        writer.write((uint64_t)value.size());
+        for (size_t i = 0; i < value.size(); i++) {
+          writer.write_node_ref(value[i]);
+        }
+        break;
+      }
+      case SocketType::CLOSURE:
+      case SocketType::UNDEFINED:
+        break;
+    }
+  }
+
+  const int index = writer.node_index.size();
+  writer.node_index[node] = index;
+}
+
+bool binary_read_node(BinaryReader &reader, Node *node)
+{
+  string type_name, name;
+  int num_sockets = 0;
+
+  reader.read_string(type_name);
+  reader.read_string(name);
+  reader.read(num_sockets);
+
+  /* Socket values are stored without names, so the node type must match exactly. */
+  int expected_num_sockets = 0;
+  foreach (const SocketType &socket, node->type->inputs) {
+    expected_num_sockets += (binary_socket_skip(socket)) ? 0 : 1;
+  }
+
+  if (reader.error || type_name != node->type->name.string() ||
+      num_sockets != expected_num_sockets) {
+    fprintf(stderr, "Node type mismatch reading \"%s\".\n", type_name.c_str());
+    reader.error = true;
+    return false;
+  }
+
+  node->name = ustring(name);
+
+  foreach (const SocketType &socket, node->type->inputs) {
+    if (binary_socket_skip(socket)) {
+      continue;
+    }
+
+    switch (socket.type) {
+      case SocketType::BOOLEAN:
+        binary_read_value<bool>(reader, node, socket);
+        break;
+      case SocketType::FLOAT:
+        binary_read_value<float>(reader, node, socket);
+        break;
+      case SocketType::INT:
+      case SocketType::ENUM:
+        binary_read_value<int>(reader, node, socket);
+        break;
+      case SocketType::UINT:
+        binary_read_value<uint>(reader, node, socket);
+        break;
+      case SocketType::COLOR:
+      case SocketType::VECTOR:
+      case SocketType::POINT:
+      case SocketType::NORMAL:
+        binary_read_value<float3>(reader, node, socket);
+        break;
+      case SocketType::POINT2:
+        binary_read_value<float2>(reader, node, socket);
+        break;
+      case SocketType::STRING: {
+        string value;
+        if (reader.read_string(value)) {
+          node->set(socket, ustring(value));
+        }
+        break;
+      }
+      case SocketType::TRANSFORM:
+        binary_read_value<Transform>(reader, node, socket);
+        break;
+      case SocketType::NODE: {
+        Node *value = reader.read_node_ref();
+        if (value == NULL || value->is_a(*(socket.node_type))) {
+          node->set(socket, value);
+        }
+        break;
+      }
+      case SocketType::BOOLEAN_ARRAY:
+        binary_read_value_array<bool>(reader, node, socket);
+        break;
+      case SocketType::FLOAT_ARRAY:
+        binary_read_value_array<float>(reader, node, socket);
+        break;
+      case SocketType::INT_ARRAY:
+        binary_read_value_array<int>(reader, node, socket);
+        break;
+      case SocketType::COLOR_ARRAY:
+      case SocketType::VECTOR_ARRAY:
+      case SocketType::POINT_ARRAY:
+      case SocketType::NORMAL_ARRAY:
+        binary_read_value_array<float3>(reader, node, socket);
+        break;
+      case SocketType::POINT2_ARRAY:
+        binary_read_value_array<float2>(reader, node, socket);
+        break;
+      case SocketType::TRANSFORM_ARRAY:
+        binary_read_value_array<Transform>(reader, node, socket);
+        break;
+      case SocketType::STRING_ARRAY: {
+        uint64_t length = 0;
+        reader.read(length);
+
+        array<ustring> value;
+        for (uint64_t i = 0; i < length && !reader.error; i++) {
+          string str;
+          reader.read_string(str);
+          value.push_back_slow(ustring(str));
+        }
+        node->set(socket, value);
+        break;
+      }
+      case SocketType::NODE_ARRAY: {
+        uint64_t length = 0;
+        reader.read(length);
+
+        array<Node *> value;
+        for (uint64_t i = 0; i < length && !reader.error; i++) {
+          Node *value_node = reader.read_node_ref();
+          value.push_back_slow((value_node && value_node->is_a(*(socket.node_type))) ? value_node :
+                                                                                   NULL);
+        }
+        node->set(socket, value);
+        break;
+      }
+      case SocketType::CLOSURE:
+      case SocketType::UNDEFINED:
+        break;
+    }
+  }
+
+  if (reader.error) {
+    return false;
+  }
+
+  reader.nodes.push_back(node);
+  return true;
+}
+
+CCL_NAMESPACE_END
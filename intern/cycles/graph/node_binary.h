@@ -0,0 +1,130 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "graph/node.h"
+
+#include "util/util_array.h"
+#include "util/util_map.h"
+#include "util/util_string.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Binary serialization of nodes, based on the same socket reflection as the XML
+ * reader and writer. Values are stored in their in-memory layout, so data can only
+ * be read back by the same build it was written with. It is meant for caching, not
+ * as an interchange format. */
+
+struct BinaryWriter {
+  vector<uint8_t> buffer;
+
+  /* Index of nodes written so far, to store references between nodes. */
+  map<const Node *, int> node_index;
+
+  void write(const void *data, size_t size)
+  {
+    const uint8_t *bytes = (const uint8_t *)data;
+    buffer.insert(buffer.end(), bytes, bytes + size);
+  }
+
+  template<typename T> void write(const T &value)
+  {
+    write(&value, sizeof(T));
+  }
+
+  void write_string(const string &value)
+  {
+    write((uint64_t)value.size());
+    write(value.data(), value.size());
+  }
+
+  template<typename T> void write_array(const T *data, size_t size)
+  {
+    write((uint64_t)size);
+    write(data, sizeof(T) * size);
+  }
+
+  void write_node_ref(const Node *node);
+};
+
+struct BinaryReader {
+  const uint8_t *data;
+  size_t size;
+  size_t offset;
+  bool error;
+
+  /* Nodes read so far, in the same order as written. */
+  vector<Node *> nodes;
+
+  BinaryReader(const uint8_t *data, size_t size)
+      : data(data), size(size), offset(0), error(false)
+  {
+  }
+
+  bool read(void *value, size_t value_size)
+  {
+    if (error || value_size > size - offset) {
+      error = true;
+      return false;
+    }
+
+    memcpy(value, data + offset, value_size);
+    offset += value_size;
+    return true;
+  }
+
+  template<typename T> bool read(T &value)
+  {
+    return read(&value, sizeof(T));
+  }
+
+  bool read_string(string &value)
+  {
+    uint64_t length = 0;
+    if (!read(length) || length > size - offset) {
+      error = true;
+      return false;
+    }
+
+    value.assign((const char *)data + offset, length);
+    offset += length;
+    return true;
+  }
+
+  /* Read directly into array or vector memory, without intermediate copies. */
+  template<typename T> bool read_array(T &value)
+  {
+    const size_t element_size = sizeof(*value.data());
+    uint64_t length = 0;
+
+    if (!read(length) || length > (size - offset) / element_size) {
+      error = true;
+      return false;
+    }
+
+    value.resize(length);
+    return read(value.data(), element_size * length);
+  }
+
+  Node *read_node_ref();
+};
+
+void binary_write_node(BinaryWriter &writer, const Node *node);
+bool binary_read_node(BinaryReader &reader, Node *node);
+
+CCL_NAMESPACE_END
@@ -34,11 +34,15 @@ CCL_NAMESPACE_BEGIN
     if ((object) != PRIM_NONE) { \
       profiling_helper.set_object(object); \
     }
+#  define PROFILING_SVM_INIT(kg) ProfilingSVMHelper profiling_svm_helper(&kg->profiler)
+#  define PROFILING_SVM_NODE(offset) profiling_svm_helper.set_svm_node(offset)
 #else
 #  define PROFILING_INIT(kg, event)
 #  define PROFILING_EVENT(event)
 #  define PROFILING_SHADER(shader)
 #  define PROFILING_OBJECT(object)
+#  define PROFILING_SVM_INIT(kg)
+#  define PROFILING_SVM_NODE(offset)
 #endif /* __KERNEL_CPU__ */
 
 CCL_NAMESPACE_END
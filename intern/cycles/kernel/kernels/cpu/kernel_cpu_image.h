@@ -251,8 +251,40 @@ template<typename T> struct TextureInterpolator {
     }
   }
 
+  /* ********  3D voxel access ******** */
+
+  static ccl_always_inline float4 read_dense(const TextureInfo &info, int x, int y, int z)
+  {
+    const T *data = (const T *)info.data;
+    return read(data[x + info.width * ((size_t)y + info.height * (size_t)z)]);
+  }
+
+  static ccl_always_inline float4 read_sparse(const TextureInfo &info, int x, int y, int z)
+  {
+    const int *offsets = (const int *)info.grid_info;
+    const int tiles_x = TEX_SPARSE_NUM_TILES(info.width);
+    const int tiles_y = TEX_SPARSE_NUM_TILES(info.height);
+    const int tile = offsets[(x >> TEX_SPARSE_TILE_SHIFT) +
+                             tiles_x * ((y >> TEX_SPARSE_TILE_SHIFT) +
+                                        tiles_y * (z >> TEX_SPARSE_TILE_SHIFT))];
+    if (tile == TEX_SPARSE_EMPTY_TILE) {
+      return make_float4(0.0f, 0.0f, 0.0f, 0.0f);
+    }
+    const T *data = (const T *)info.data + (size_t)tile * TEX_SPARSE_TILE_VOXELS;
+    return read(data[(x & TEX_SPARSE_TILE_MASK) +
+                     TEX_SPARSE_TILE_SIZE * ((y & TEX_SPARSE_TILE_MASK) +
+                                             TEX_SPARSE_TILE_SIZE * (z & TEX_SPARSE_TILE_MASK))]);
+  }
+
+  template<bool sparse>
+  static ccl_always_inline float4 read_voxel(const TextureInfo &info, int x, int y, int z)
+  {
+    return (sparse) ? read_sparse(info, x, y, z) : read_dense(info, x, y, z);
+  }
+
   /* ********  3D interpolation ******** */
 
+  template<bool sparse>
   static ccl_always_inline float4 interp_3d_closest(const TextureInfo &info,
                                                     float x,
                                                     float y,
@@ -288,10 +320,10 @@ template<typename T> struct TextureInterpolator {
         return make_float4(0.0f, 0.0f, 0.0f, 0.0f);
     }
 
-    const T *data = (const T *)info.data;
-    return read(data[ix + iy * width + iz * width * height]);
+    return read_voxel<sparse>(info, ix, iy, iz);
   }
 
+  template<bool sparse>
   static ccl_always_inline float4 interp_3d_linear(const TextureInfo &info,
                                                    float x,
                                                    float y,
@@ -336,19 +368,17 @@ template<typename T> struct TextureInterpolator {
         return make_float4(0.0f, 0.0f, 0.0f, 0.0f);
     }
 
-    const T *data = (const T *)info.data;
     float4 r;
 
-    r = (1.0f - tz) * (1.0f - ty) * (1.0f - tx) *
-        read(data[ix + iy * width + iz * width * height]);
-    r += (1.0f - tz) * (1.0f - ty) * tx * read(data[nix + iy * width + iz * width * height]);
-    r += (1.0f - tz) * ty * (1.0f - tx) * read(data[ix + niy * width + iz * width * height]);
-    r += (1.0f - tz) * ty * tx * read(data[nix + niy * width + iz * width * height]);
+    r = (1.0f - tz) * (1.0f - ty) * (1.0f - tx) * read_voxel<sparse>(info, ix, iy, iz);
+    r += (1.0f - tz) * (1.0f - ty) * tx * read_voxel<sparse>(info, nix, iy, iz);
+    r += (1.0f - tz) * ty * (1.0f - tx) * read_voxel<sparse>(info, ix, niy, iz);
+    r += (1.0f - tz) * ty * tx * read_voxel<sparse>(info, nix, niy, iz);
 
-    r += tz * (1.0f - ty) * (1.0f - tx) * read(data[ix + iy * width + niz * width * height]);
-    r += tz * (1.0f - ty) * tx * read(data[nix + iy * width + niz * width * height]);
-    r += tz * ty * (1.0f - tx) * read(data[ix + niy * width + niz * width * height]);
-    r += tz * ty * tx * read(data[nix + niy * width + niz * width * height]);
+    r += tz * (1.0f - ty) * (1.0f - tx) * read_voxel<sparse>(info, ix, iy, niz);
+    r += tz * (1.0f - ty) * tx * read_voxel<sparse>(info, nix, iy, niz);
+    r += tz * ty * (1.0f - tx) * read_voxel<sparse>(info, ix, niy, niz);
+    r += tz * ty * tx * read_voxel<sparse>(info, nix, niy, niz);
 
     return r;
   }
@@ -359,6 +389,7 @@ template<typename T> struct TextureInterpolator {
    * Only happens for AVX2 kernel and global __KERNEL_SSE__ vectorization
    * enabled.
    */
+  template<bool sparse>
 #if defined(__GNUC__) || defined(__clang__)
   static ccl_always_inline
 #else
@@ -424,15 +455,14 @@ template<typename T> struct TextureInterpolator {
     }
 
     const int xc[4] = {pix, ix, nix, nnix};
-    const int yc[4] = {width * piy, width * iy, width * niy, width * nniy};
-    const int zc[4] = {
-        width * height * piz, width * height * iz, width * height * niz, width * height * nniz};
+    const int yc[4] = {piy, iy, niy, nniy};
+    const int zc[4] = {piz, iz, niz, nniz};
     float u[4], v[4], w[4];
 
     /* Some helper macro to keep code reasonable size,
      * let compiler to inline all the matrix multiplications.
      */
-#define DATA(x, y, z) (read(data[xc[x] + yc[y] + zc[z]]))
+#define DATA(x, y, z) (read_voxel<sparse>(info, xc[x], yc[y], zc[z]))
 #define COL_TERM(col, row) \
   (v[col] * (u[0] * DATA(0, col, row) + u[1] * DATA(1, col, row) + u[2] * DATA(2, col, row) + \
              u[3] * DATA(3, col, row)))
@@ -444,7 +474,6 @@ template<typename T> struct TextureInterpolator {
     SET_CUBIC_SPLINE_WEIGHTS(w, tz);
 
     /* Actual interpolation. */
-    const T *data = (const T *)info.data;
     return ROW_TERM(0) + ROW_TERM(1) + ROW_TERM(2) + ROW_TERM(3);
 
 #undef COL_TERM
@@ -452,20 +481,30 @@ template<typename T> struct TextureInterpolator {
 #undef DATA
   }
 
+  template<bool sparse>
+  static ccl_always_inline float4 interp_3d_grid(
+      const TextureInfo &info, float x, float y, float z, InterpolationType interp)
+  {
+    switch ((interp == INTERPOLATION_NONE) ? info.interpolation : interp) {
+      case INTERPOLATION_CLOSEST:
+        return interp_3d_closest<sparse>(info, x, y, z);
+      case INTERPOLATION_LINEAR:
+        return interp_3d_linear<sparse>(info, x, y, z);
+      default:
+        return interp_3d_tricubic<sparse>(info, x, y, z);
+    }
+  }
+
   static ccl_always_inline float4
   interp_3d(const TextureInfo &info, float x, float y, float z, InterpolationType interp)
   {
     if (UNLIKELY(!info.data))
       return make_float4(0.0f, 0.0f, 0.0f, 0.0f);
 
-    switch ((interp == INTERPOLATION_NONE) ? info.interpolation : interp) {
-      case INTERPOLATION_CLOSEST:
-        return interp_3d_closest(info, x, y, z);
-      case INTERPOLATION_LINEAR:
-        return interp_3d_linear(info, x, y, z);
-      default:
-        return interp_3d_tricubic(info, x, y, z);
+    if (info.grid_type == IMAGE_GRID_TYPE_SPARSE) {
+      return interp_3d_grid<true>(info, x, y, z, interp);
     }
+    return interp_3d_grid<false>(info, x, y, z, interp);
   }
 #undef SET_CUBIC_SPLINE_WEIGHTS
 };
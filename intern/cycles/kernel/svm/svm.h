@@ -227,7 +227,10 @@ ccl_device_noinline void svm_eval_nodes(KernelGlobals *kg,
   float stack[SVM_STACK_SIZE];
   int offset = sd->shader & SHADER_MASK;
 
+  PROFILING_SVM_INIT(kg);
+
   while (1) {
+    PROFILING_SVM_NODE(offset);
     uint4 node = read_node(kg, &offset);
 
     switch (node.x) {
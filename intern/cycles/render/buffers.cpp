@@ -17,6 +17,7 @@
 #include <stdlib.h>
 
 #include "render/buffers.h"
+#include "render/stats.h"
 #include "device/device.h"
 
 #include "util/util_foreach.h"
@@ -105,6 +106,30 @@ int BufferParams::get_denoising_prefiltered_offset()
   return offset;
 }
 
+void BufferParams::collect_statistics(RenderStats *stats)
+{
+  const size_t num_pixels = (size_t)full_width * full_height;
+
+  foreach (const Pass &pass, passes) {
+    if (pass.components == 0) {
+      continue;
+    }
+
+    const string name = (pass.name.empty()) ? string_printf("Pass %d", (int)pass.type) :
+                                              pass.name;
+    stats->buffers.passes.add_entry(
+        NamedSizeEntry(name, num_pixels * pass.components * sizeof(float)));
+  }
+
+  /* Denoising data and the padding of every pixel to a multiple of 4 floats. */
+  const int extra_size = get_passes_size() - get_denoising_offset();
+  if (extra_size > 0) {
+    stats->buffers.passes.add_entry(
+        NamedSizeEntry((denoising_data_pass) ? "Denoising data" : "Padding",
+                       num_pixels * extra_size * sizeof(float)));
+  }
+}
+
 /* Render Buffer Task */
 
 RenderTile::RenderTile()
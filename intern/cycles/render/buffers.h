@@ -31,6 +31,7 @@
 CCL_NAMESPACE_BEGIN
 
 class Device;
+class RenderStats;
 struct DeviceDrawParams;
 struct float4;
 
@@ -67,6 +68,8 @@ class BufferParams {
   int get_passes_size();
   int get_denoising_offset();
   int get_denoising_prefiltered_offset();
+
+  void collect_statistics(RenderStats *stats);
 };
 
 /* Render Buffers */
@@ -50,6 +50,16 @@ bool isfinite(uint16_t /*value*/)
   return true;
 }
 
+/* Voxels which are skipped when building sparse grids. */
+bool voxel_is_empty(float value)
+{
+  return value == 0.0f;
+}
+bool voxel_is_empty(const float4 &value)
+{
+  return value.x == 0.0f && value.y == 0.0f && value.z == 0.0f && value.w == 0.0f;
+}
+
 /* The lower three bits of a device texture slot number indicate its type.
  * These functions convert the slot ids from ImageManager "images" ones
  * to device ones and vice verse.
@@ -103,6 +113,7 @@ ImageManager::ImageManager(const DeviceInfo &info)
   /* Set image limits */
   max_num_images = TEX_NUM_MAX;
   has_half_images = info.has_half_images;
+  has_sparse_volumes = info.has_sparse_volumes;
 
   for (size_t type = 0; type < IMAGE_DATA_NUM_TYPES; type++) {
     tex_num_images[type] = 0;
@@ -713,6 +724,116 @@ bool ImageManager::file_load_image(Image *img,
   return true;
 }
 
+/* Convert a dense 3D texture to a sparse grid, where only tiles containing
+ * non-empty voxels are stored. The texture is left untouched when this would
+ * not save memory. */
+template<typename DeviceType>
+bool ImageManager::create_sparse_grid(Device *device, device_vector<DeviceType> &tex_img)
+{
+  const int width = tex_img.data_width;
+  const int height = tex_img.data_height;
+  const int depth = tex_img.data_depth;
+
+  if (depth <= 1) {
+    return false;
+  }
+
+  const int tiles_x = TEX_SPARSE_NUM_TILES(width);
+  const int tiles_y = TEX_SPARSE_NUM_TILES(height);
+  const int tiles_z = TEX_SPARSE_NUM_TILES(depth);
+  const size_t num_tiles = ((size_t)tiles_x) * tiles_y * tiles_z;
+  const DeviceType *dense = tex_img.data();
+
+  /* Find tiles with at least one non-empty voxel. */
+  vector<int> offsets(num_tiles, TEX_SPARSE_EMPTY_TILE);
+  int num_active_tiles = 0;
+
+  for (int tz = 0, tile = 0; tz < tiles_z; tz++) {
+    for (int ty = 0; ty < tiles_y; ty++) {
+      for (int tx = 0; tx < tiles_x; tx++, tile++) {
+        const int x0 = tx * TEX_SPARSE_TILE_SIZE, x1 = min(x0 + TEX_SPARSE_TILE_SIZE, width);
+        const int y0 = ty * TEX_SPARSE_TILE_SIZE, y1 = min(y0 + TEX_SPARSE_TILE_SIZE, height);
+        const int z0 = tz * TEX_SPARSE_TILE_SIZE, z1 = min(z0 + TEX_SPARSE_TILE_SIZE, depth);
+        bool is_empty = true;
+
+        for (int z = z0; z < z1 && is_empty; z++) {
+          for (int y = y0; y < y1 && is_empty; y++) {
+            const DeviceType *row = dense + width * ((size_t)y + ((size_t)height) * z);
+            for (int x = x0; x < x1; x++) {
+              if (!voxel_is_empty(row[x])) {
+                is_empty = false;
+                break;
+              }
+            }
+          }
+        }
+
+        if (!is_empty) {
+          offsets[tile] = num_active_tiles++;
+        }
+      }
+    }
+  }
+
+  const size_t sparse_size = ((size_t)num_active_tiles) * TEX_SPARSE_TILE_VOXELS;
+  const size_t sparse_memory_size = sparse_size * sizeof(DeviceType) + num_tiles * sizeof(int);
+  if (sparse_memory_size >= tex_img.memory_size()) {
+    return false;
+  }
+
+  /* Pack active tiles, voxels outside of the grid bounds are left empty. */
+  vector<DeviceType> sparse(sparse_size);
+  memset(sparse.data(), 0, sparse_size * sizeof(DeviceType));
+
+  for (int tz = 0, tile = 0; tz < tiles_z; tz++) {
+    for (int ty = 0; ty < tiles_y; ty++) {
+      for (int tx = 0; tx < tiles_x; tx++, tile++) {
+        if (offsets[tile] == TEX_SPARSE_EMPTY_TILE) {
+          continue;
+        }
+
+        DeviceType *tile_data = &sparse[((size_t)offsets[tile]) * TEX_SPARSE_TILE_VOXELS];
+        const int x0 = tx * TEX_SPARSE_TILE_SIZE, x1 = min(x0 + TEX_SPARSE_TILE_SIZE, width);
+        const int y0 = ty * TEX_SPARSE_TILE_SIZE, y1 = min(y0 + TEX_SPARSE_TILE_SIZE, height);
+        const int z0 = tz * TEX_SPARSE_TILE_SIZE, z1 = min(z0 + TEX_SPARSE_TILE_SIZE, depth);
+
+        for (int z = z0; z < z1; z++) {
+          for (int y = y0; y < y1; y++) {
+            const DeviceType *row = dense + width * ((size_t)y + ((size_t)height) * z);
+            DeviceType *tile_row = tile_data + TEX_SPARSE_TILE_SIZE *
+                                                   ((y - y0) + TEX_SPARSE_TILE_SIZE * (z - z0));
+            memcpy(tile_row, row + x0, (x1 - x0) * sizeof(DeviceType));
+          }
+        }
+      }
+    }
+  }
+
+  VLOG(1) << "Sparse grid " << tex_img.name << ": " << num_active_tiles << " of " << num_tiles
+          << " tiles active, " << string_human_readable_size(tex_img.memory_size()) << " dense, "
+          << string_human_readable_size(sparse_memory_size) << " sparse.";
+
+  thread_scoped_lock device_lock(device_mutex);
+
+  device_vector<int> *tex_grid = new device_vector<int>(
+      device, "__tex_image_sparse_grid", MEM_READ_ONLY);
+  int *grid_offsets = tex_grid->alloc(num_tiles);
+  memcpy(grid_offsets, offsets.data(), num_tiles * sizeof(int));
+  tex_grid->copy_to_device();
+
+  DeviceType *pixels = tex_img.alloc(sparse_size);
+  memcpy(pixels, sparse.data(), sparse_size * sizeof(DeviceType));
+
+  /* Voxel lookups still use the dense resolution. */
+  tex_img.data_width = width;
+  tex_img.data_height = height;
+  tex_img.data_depth = depth;
+  tex_img.grid_type = IMAGE_GRID_TYPE_SPARSE;
+  tex_img.grid_info = tex_grid;
+
+  return true;
+}
+
 static void image_set_device_memory(ImageManager::Image *img, device_memory *mem)
 {
   img->mem = mem;
@@ -720,6 +841,15 @@ static void image_set_device_memory(ImageManager::Image *img, device_memory *mem
   mem->extension = img->key.extension;
 }
 
+static void image_free_device_memory(ImageManager::Image *img)
+{
+  /* Sparse grid offsets are owned by the texture memory. */
+  device_memory *grid_info = img->mem->grid_info;
+  delete img->mem;
+  delete grid_info;
+  img->mem = NULL;
+}
+
 void ImageManager::device_load_image(
     Device *device, Scene *scene, ImageDataType type, int slot, Progress *progress)
 {
@@ -743,8 +873,7 @@ void ImageManager::device_load_image(
   /* Free previous texture in slot. */
   if (img->mem) {
     thread_scoped_lock device_lock(device_mutex);
-    delete img->mem;
-    img->mem = NULL;
+    image_free_device_memory(img);
   }
 
   /* Create new texture. */
@@ -762,6 +891,9 @@ void ImageManager::device_load_image(
       pixels[2] = TEX_IMAGE_MISSING_B;
       pixels[3] = TEX_IMAGE_MISSING_A;
     }
+    else if (has_sparse_volumes) {
+      create_sparse_grid(device, *tex_img);
+    }
 
     image_set_device_memory(img, tex_img);
 
@@ -779,6 +911,9 @@ void ImageManager::device_load_image(
 
       pixels[0] = TEX_IMAGE_MISSING_R;
     }
+    else if (has_sparse_volumes) {
+      create_sparse_grid(device, *tex_img);
+    }
 
     image_set_device_memory(img, tex_img);
 
@@ -913,7 +1048,7 @@ void ImageManager::device_free_image(Device *, ImageDataType type, int slot)
 
     if (img->mem) {
       thread_scoped_lock device_lock(device_mutex);
-      delete img->mem;
+      image_free_device_memory(img);
     }
 
     delete img;
@@ -1030,8 +1165,12 @@ void ImageManager::collect_statistics(RenderStats *stats)
 {
   for (int type = 0; type < IMAGE_DATA_NUM_TYPES; type++) {
     foreach (const Image *image, images[type]) {
+      size_t mem_size = image->mem->memory_size();
+      if (image->mem->grid_info) {
+        mem_size += image->mem->grid_info->memory_size();
+      }
       stats->image.textures.add_entry(
-          NamedSizeEntry(path_filename(image->key.filename), image->mem->memory_size()));
+          NamedSizeEntry(path_filename(image->key.filename), mem_size));
     }
   }
 }
@@ -170,6 +170,7 @@ class ImageManager {
   int tex_num_images[IMAGE_DATA_NUM_TYPES];
   int max_num_images;
   bool has_half_images;
+  bool has_sparse_volumes;
 
   thread_mutex device_mutex;
   int animation_frame;
@@ -185,6 +186,9 @@ class ImageManager {
                        int texture_limit,
                        device_vector<DeviceType> &tex_img);
 
+  template<typename DeviceType>
+  bool create_sparse_grid(Device *device, device_vector<DeviceType> &tex_img);
+
   void metadata_detect_colorspace(ImageMetaData &metadata, const char *file_format);
 
   void device_load_image(
@@ -360,6 +360,21 @@ void VolumeMeshBuilder::convert_quads_to_tris(const vector<QuadData> &quads,
 struct VoxelAttributeGrid {
   float *data;
   int channels;
+  /* Tile offsets for sparse grids, NULL for dense grids. */
+  int *offsets;
+
+  /* Voxel data of a tile, NULL if the tile is empty. For dense grids this is
+   * the start of the grid, since voxels are indexed with dense coordinates. */
+  const float *tile_data(int tile) const
+  {
+    if (offsets == NULL) {
+      return data;
+    }
+    else if (offsets[tile] == TEX_SPARSE_EMPTY_TILE) {
+      return NULL;
+    }
+    return data + ((size_t)offsets[tile]) * TEX_SPARSE_TILE_VOXELS * channels;
+  }
 };
 
 void GeometryManager::create_volume_mesh(Scene *scene, Mesh *mesh, Progress &progress)
@@ -394,6 +409,9 @@ void GeometryManager::create_volume_mesh(Scene *scene, Mesh *mesh, Progress &pro
     VoxelAttributeGrid voxel_grid;
     voxel_grid.data = static_cast<float *>(image_memory->host_pointer);
     voxel_grid.channels = image_memory->data_elements;
+    voxel_grid.offsets = (image_memory->grid_type == IMAGE_GRID_TYPE_SPARSE) ?
+                             static_cast<int *>(image_memory->grid_info->host_pointer) :
+                             NULL;
     voxel_grids.push_back(voxel_grid);
   }
 
@@ -443,23 +461,49 @@ void GeometryManager::create_volume_mesh(Scene *scene, Mesh *mesh, Progress &pro
   volume_params.cell_size = cell_size;
   volume_params.pad_size = pad_size;
 
-  /* Build bounding mesh around non-empty volume cells. */
+  /* Build bounding mesh around non-empty volume cells. Voxels are visited tile by
+   * tile, so that empty tiles of sparse grids can be skipped entirely. */
   VolumeMeshBuilder builder(&volume_params);
   const float isovalue = mesh->volume_isovalue;
+  const int3 tiles = make_int3(TEX_SPARSE_NUM_TILES(resolution.x),
+                               TEX_SPARSE_NUM_TILES(resolution.y),
+                               TEX_SPARSE_NUM_TILES(resolution.z));
 
-  for (int z = 0; z < resolution.z; ++z) {
-    for (int y = 0; y < resolution.y; ++y) {
-      for (int x = 0; x < resolution.x; ++x) {
-        size_t voxel_index = compute_voxel_index(resolution, x, y, z);
+  for (int tz = 0, tile = 0; tz < tiles.z; ++tz) {
+    for (int ty = 0; ty < tiles.y; ++ty) {
+      for (int tx = 0; tx < tiles.x; ++tx, ++tile) {
+        const int x0 = tx * TEX_SPARSE_TILE_SIZE, x1 = min(x0 + TEX_SPARSE_TILE_SIZE, resolution.x);
+        const int y0 = ty * TEX_SPARSE_TILE_SIZE, y1 = min(y0 + TEX_SPARSE_TILE_SIZE, resolution.y);
+        const int z0 = tz * TEX_SPARSE_TILE_SIZE, z1 = min(z0 + TEX_SPARSE_TILE_SIZE, resolution.z);
 
         for (size_t i = 0; i < voxel_grids.size(); ++i) {
           const VoxelAttributeGrid &voxel_grid = voxel_grids[i];
+          const float *data = voxel_grid.tile_data(tile);
           const int channels = voxel_grid.channels;
 
-          for (int c = 0; c < channels; c++) {
-            if (voxel_grid.data[voxel_index * channels + c] >= isovalue) {
-              builder.add_node_with_padding(x, y, z);
-              break;
+          if (data == NULL) {
+            continue;
+          }
+
+          for (int z = z0; z < z1; ++z) {
+            for (int y = y0; y < y1; ++y) {
+              for (int x = x0; x < x1; ++x) {
+                size_t voxel_index;
+                if (voxel_grid.offsets) {
+                  voxel_index = (x - x0) + TEX_SPARSE_TILE_SIZE *
+                                               ((y - y0) + TEX_SPARSE_TILE_SIZE * (z - z0));
+                }
+                else {
+                  voxel_index = compute_voxel_index(resolution, x, y, z);
+                }
+
+                for (int c = 0; c < channels; c++) {
+                  if (data[voxel_index * channels + c] >= isovalue) {
+                    builder.add_node_with_padding(x, y, z);
+                    break;
+                  }
+                }
+              }
             }
           }
         }
@@ -499,9 +543,18 @@ void GeometryManager::create_volume_mesh(Scene *scene, Mesh *mesh, Progress &pro
                  (1024.0 * 1024.0)
           << "Mb.";
 
-  VLOG(1) << "Memory usage volume grid: "
-          << (resolution.x * resolution.y * resolution.z * sizeof(float)) / (1024.0 * 1024.0)
-          << "Mb.";
+  size_t grid_memory_size = 0;
+  foreach (Attribute &attr, mesh->attributes.attributes) {
+    if (attr.element == ATTR_ELEMENT_VOXEL) {
+      device_memory *image_memory = scene->image_manager->image_memory(attr.data_voxel()->slot);
+      grid_memory_size += image_memory->memory_size();
+      if (image_memory->grid_info) {
+        grid_memory_size += image_memory->grid_info->memory_size();
+      }
+    }
+  }
+
+  VLOG(1) << "Memory usage volume grid: " << grid_memory_size / (1024.0 * 1024.0) << "Mb.";
 }
 
 CCL_NAMESPACE_END
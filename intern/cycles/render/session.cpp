@@ -278,7 +278,9 @@ void Session::run_gpu()
       /* update scene */
       scoped_timer update_timer;
       if (update_scene()) {
-        profiler.reset(scene->shaders.size(), scene->objects.size());
+        profiler.reset(scene->shaders.size(),
+                       scene->objects.size(),
+                       (params.use_profiling) ? scene->dscene.svm_nodes.size() : 0);
       }
       progress.add_skip_time(update_timer, params.background);
 
@@ -672,7 +674,9 @@ void Session::run_cpu()
       /* update scene */
       scoped_timer update_timer;
       if (update_scene()) {
-        profiler.reset(scene->shaders.size(), scene->objects.size());
+        profiler.reset(scene->shaders.size(),
+                       scene->objects.size(),
+                       (params.use_profiling) ? scene->dscene.svm_nodes.size() : 0);
       }
       progress.add_skip_time(update_timer, params.background);
 
@@ -1256,6 +1260,7 @@ void Session::device_free()
 void Session::collect_statistics(RenderStats *render_stats)
 {
   scene->collect_statistics(render_stats);
+  tile_manager.params.collect_statistics(render_stats);
   if (params.use_profiling && (params.device.type == DEVICE_CPU)) {
     render_stats->collect_profiling(scene, profiler);
   }
@@ -159,6 +159,13 @@ class Shader : public Node {
  * From this the SVM and OSL shader managers are derived, that do the actual
  * shader compiling and device updating. */
 
+/* Shader node an SVM node was compiled from, used for profiling. */
+struct SVMNodeInfo {
+  ustring shader_name;
+  ustring node_name;
+  ustring node_type;
+};
+
 class ShaderManager {
  public:
   bool need_update;
@@ -173,6 +180,13 @@ class ShaderManager {
     return false;
   }
 
+  /* Shader node the SVM node at the given offset was compiled from,
+   * or NULL if unknown. */
+  virtual const SVMNodeInfo *get_svm_node_info(int /*offset*/)
+  {
+    return NULL;
+  }
+
   /* device update */
   virtual void device_update(Device *device,
                              DeviceScene *dscene,
@@ -16,6 +16,7 @@
 
 #include "render/stats.h"
 #include "render/object.h"
+#include "render/shader.h"
 #include "util/util_algorithm.h"
 #include "util/util_foreach.h"
 #include "util/util_string.h"
@@ -224,6 +225,20 @@ string ImageStats::full_report(int indent_level)
   return result;
 }
 
+/* Render buffer statistics. */
+
+BufferStats::BufferStats()
+{
+}
+
+string BufferStats::full_report(int indent_level)
+{
+  const string indent(indent_level * kIndentNumSpaces, ' ');
+  string result = "";
+  result += indent + "Passes:\n" + passes.full_report(indent_level + 1);
+  return result;
+}
+
 /* Overall statistics. */
 
 RenderStats::RenderStats()
@@ -299,6 +314,28 @@ void RenderStats::collect_profiling(Scene *scene, Profiler &prof)
       objects.add(object->name, samples, hits);
     }
   }
+
+  /* SVM nodes are accumulated both per node type and per node instance,
+   * multiple SVM nodes may be generated for the same shader node. */
+  svm_node_types.entries.clear();
+  svm_nodes.entries.clear();
+  for (int offset = 0; offset < prof.get_num_svm_nodes(); offset++) {
+    uint64_t samples, hits;
+    if (!prof.get_svm_node(offset, samples, hits)) {
+      continue;
+    }
+    const SVMNodeInfo *info = scene->shader_manager->get_svm_node_info(offset);
+    if (info == NULL) {
+      continue;
+    }
+    svm_node_types.add(info->node_type, samples, hits);
+    svm_nodes.add(ustring(string_printf("%s: %s",
+                                        info->shader_name.c_str(),
+                                        info->node_name.empty() ? info->node_type.c_str() :
+                                                                  info->node_name.c_str())),
+                  samples,
+                  hits);
+  }
 }
 
 string RenderStats::full_report()
@@ -306,10 +343,15 @@ string RenderStats::full_report()
   string result = "";
   result += "Mesh statistics:\n" + mesh.full_report(1);
   result += "Image statistics:\n" + image.full_report(1);
+  result += "Render buffer statistics:\n" + buffers.full_report(1);
   if (has_profiling) {
     result += "Kernel statistics:\n" + kernel.full_report(1);
     result += "Shader statistics:\n" + shaders.full_report(1);
     result += "Object statistics:\n" + objects.full_report(1);
+    if (!svm_nodes.entries.empty()) {
+      result += "SVM node type statistics:\n" + svm_node_types.full_report(1);
+      result += "SVM node statistics:\n" + svm_nodes.full_report(1);
+    }
   }
   else {
     result += "Profiling information not available (only works with CPU rendering)";
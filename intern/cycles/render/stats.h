@@ -135,6 +135,17 @@ class ImageStats {
   NamedSizeStats textures;
 };
 
+/* Statistics about render buffer passes, for the full frame. */
+class BufferStats {
+ public:
+  BufferStats();
+
+  /* Generate full human-readable report. */
+  string full_report(int indent_level = 0);
+
+  NamedSizeStats passes;
+};
+
 /* Render process statistics. */
 class RenderStats {
  public:
@@ -150,9 +161,12 @@ class RenderStats {
 
   MeshStats mesh;
   ImageStats image;
+  BufferStats buffers;
   NamedNestedSampleStats kernel;
   NamedSampleCountStats shaders;
   NamedSampleCountStats objects;
+  NamedSampleCountStats svm_node_types;
+  NamedSampleCountStats svm_nodes;
 };
 
 CCL_NAMESPACE_END
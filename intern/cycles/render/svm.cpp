@@ -49,7 +49,8 @@ void SVMShaderManager::reset(Scene * /*scene*/)
 void SVMShaderManager::device_update_shader(Scene *scene,
                                             Shader *shader,
                                             Progress *progress,
-                                            array<int4> *svm_nodes)
+                                            array<int4> *svm_nodes,
+                                            vector<SVMNodeInfo> *svm_node_info)
 {
   if (progress->get_cancel()) {
     return;
@@ -57,11 +58,12 @@ void SVMShaderManager::device_update_shader(Scene *scene,
   assert(shader->graph);
 
   svm_nodes->push_back_slow(make_int4(NODE_SHADER_JUMP, 0, 0, 0));
+  svm_node_info->push_back(SVMNodeInfo());
 
   SVMCompiler::Summary summary;
   SVMCompiler compiler(scene);
   compiler.background = (shader == scene->background->get_shader(scene));
-  compiler.compile(shader, *svm_nodes, 0, &summary);
+  compiler.compile(shader, *svm_nodes, 0, &summary, svm_node_info);
 
   VLOG(2) << "Compilation summary:\n"
           << "Shader name: " << shader->name << "\n"
@@ -91,13 +93,15 @@ void SVMShaderManager::device_update(Device *device,
   /* Build all shaders. */
   TaskPool task_pool;
   vector<array<int4>> shader_svm_nodes(num_shaders);
+  vector<vector<SVMNodeInfo>> shader_svm_node_info(num_shaders);
   for (int i = 0; i < num_shaders; i++) {
     task_pool.push(function_bind(&SVMShaderManager::device_update_shader,
                                  this,
                                  scene,
                                  scene->shaders[i],
                                  &progress,
-                                 &shader_svm_nodes[i]),
+                                 &shader_svm_nodes[i],
+                                 &shader_svm_node_info[i]),
                    false);
   }
   task_pool.wait_work();
@@ -141,11 +145,16 @@ void SVMShaderManager::device_update(Device *device,
 
   /* Copy the nodes of each shader into the correct location. */
   svm_nodes += num_shaders;
+  svm_node_info.assign(num_shaders, SVMNodeInfo());
   for (int i = 0; i < num_shaders; i++) {
     int shader_size = shader_svm_nodes[i].size() - 1;
 
     memcpy(svm_nodes, &shader_svm_nodes[i][1], sizeof(int4) * shader_size);
     svm_nodes += shader_size;
+
+    svm_node_info.insert(svm_node_info.end(),
+                         shader_svm_node_info[i].begin() + 1,
+                         shader_svm_node_info[i].end());
   }
 
   if (progress.get_cancel()) {
@@ -167,6 +176,16 @@ void SVMShaderManager::device_free(Device *device, DeviceScene *dscene, Scene *s
   device_free_common(device, dscene, scene);
 
   dscene->svm_nodes.free();
+  svm_node_info.clear();
+}
+
+const SVMNodeInfo *SVMShaderManager::get_svm_node_info(int offset)
+{
+  if (offset < 0 || offset >= svm_node_info.size()) {
+    return NULL;
+  }
+  const SVMNodeInfo &info = svm_node_info[offset];
+  return (info.node_type.empty()) ? NULL : &info;
 }
 
 /* Graph Compiler */
@@ -434,9 +453,23 @@ void SVMCompiler::find_dependencies(ShaderNodeSet &dependencies,
   }
 }
 
+void SVMCompiler::tag_svm_node_info(ShaderNode *node)
+{
+  /* Attribute all SVM nodes added since the last call to the given node. */
+  SVMNodeInfo info;
+  if (node) {
+    info.shader_name = current_shader->name;
+    info.node_name = node->name;
+    info.node_type = node->type->name;
+  }
+  current_svm_node_info.resize(current_svm_nodes.size(), info);
+}
+
 void SVMCompiler::generate_node(ShaderNode *node, ShaderNodeSet &done)
 {
+  tag_svm_node_info(NULL);
   node->compile(*this);
+  tag_svm_node_info(node);
   stack_clear_users(node, done);
   stack_clear_temporary(node);
 
@@ -742,6 +775,7 @@ void SVMCompiler::compile_type(Shader *shader, ShaderGraph *graph, ShaderType ty
   /* clear all compiler state */
   memset((void *)&active_stack, 0, sizeof(active_stack));
   current_svm_nodes.clear();
+  current_svm_node_info.clear();
 
   foreach (ShaderNode *node, graph->nodes) {
     foreach (ShaderInput *input, node->inputs)
@@ -790,7 +824,9 @@ void SVMCompiler::compile_type(Shader *shader, ShaderGraph *graph, ShaderType ty
     }
 
     /* compile output node */
+    tag_svm_node_info(NULL);
     output->compile(*this);
+    tag_svm_node_info(output);
 
     if (type == SHADER_TYPE_SURFACE) {
       vector<OutputAOVNode *> aov_outputs;
@@ -825,6 +861,7 @@ void SVMCompiler::compile_type(Shader *shader, ShaderGraph *graph, ShaderType ty
   /* if compile failed, generate empty shader */
   if (compile_failed) {
     current_svm_nodes.clear();
+    current_svm_node_info.clear();
     compile_failed = false;
   }
 
@@ -833,9 +870,15 @@ void SVMCompiler::compile_type(Shader *shader, ShaderGraph *graph, ShaderType ty
   if (type != SHADER_TYPE_BUMP) {
     add_node(NODE_END, 0, 0, 0);
   }
+
+  tag_svm_node_info(NULL);
 }
 
-void SVMCompiler::compile(Shader *shader, array<int4> &svm_nodes, int index, Summary *summary)
+void SVMCompiler::compile(Shader *shader,
+                          array<int4> &svm_nodes,
+                          int index,
+                          Summary *summary,
+                          vector<SVMNodeInfo> *svm_node_info)
 {
   /* copy graph for shader with bump mapping */
   ShaderNode *output = shader->graph->output();
@@ -877,6 +920,10 @@ void SVMCompiler::compile(Shader *shader, array<int4> &svm_nodes, int index, Sum
     compile_type(shader, shader->graph, SHADER_TYPE_BUMP);
     svm_nodes[index].y = svm_nodes.size();
     svm_nodes.append(current_svm_nodes);
+    if (svm_node_info) {
+      svm_node_info->insert(
+          svm_node_info->end(), current_svm_node_info.begin(), current_svm_node_info.end());
+    }
   }
 
   /* generate surface shader */
@@ -889,6 +936,10 @@ void SVMCompiler::compile(Shader *shader, array<int4> &svm_nodes, int index, Sum
       svm_nodes[index].y = svm_nodes.size();
     }
     svm_nodes.append(current_svm_nodes);
+    if (svm_node_info) {
+      svm_node_info->insert(
+          svm_node_info->end(), current_svm_node_info.begin(), current_svm_node_info.end());
+    }
   }
 
   /* generate volume shader */
@@ -897,6 +948,10 @@ void SVMCompiler::compile(Shader *shader, array<int4> &svm_nodes, int index, Sum
     compile_type(shader, shader->graph, SHADER_TYPE_VOLUME);
     svm_nodes[index].z = svm_nodes.size();
     svm_nodes.append(current_svm_nodes);
+    if (svm_node_info) {
+      svm_node_info->insert(
+          svm_node_info->end(), current_svm_node_info.begin(), current_svm_node_info.end());
+    }
   }
 
   /* generate displacement shader */
@@ -905,6 +960,10 @@ void SVMCompiler::compile(Shader *shader, array<int4> &svm_nodes, int index, Sum
     compile_type(shader, shader->graph, SHADER_TYPE_DISPLACEMENT);
     svm_nodes[index].w = svm_nodes.size();
     svm_nodes.append(current_svm_nodes);
+    if (svm_node_info) {
+      svm_node_info->insert(
+          svm_node_info->end(), current_svm_node_info.begin(), current_svm_node_info.end());
+    }
   }
 
   /* Fill in summary information. */
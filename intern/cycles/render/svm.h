@@ -49,11 +49,17 @@ class SVMShaderManager : public ShaderManager {
   void device_update(Device *device, DeviceScene *dscene, Scene *scene, Progress &progress);
   void device_free(Device *device, DeviceScene *dscene, Scene *scene);
 
+  const SVMNodeInfo *get_svm_node_info(int offset);
+
  protected:
   void device_update_shader(Scene *scene,
                             Shader *shader,
                             Progress *progress,
-                            array<int4> *svm_nodes);
+                            array<int4> *svm_nodes,
+                            vector<SVMNodeInfo> *svm_node_info);
+
+  /* Shader node info for every node in __svm_nodes. */
+  vector<SVMNodeInfo> svm_node_info;
 };
 
 /* Graph Compiler */
@@ -94,7 +100,11 @@ class SVMCompiler {
   };
 
   SVMCompiler(Scene *scene);
-  void compile(Shader *shader, array<int4> &svm_nodes, int index, Summary *summary = NULL);
+  void compile(Shader *shader,
+               array<int4> &svm_nodes,
+               int index,
+               Summary *summary = NULL,
+               vector<SVMNodeInfo> *svm_node_info = NULL);
 
   int stack_assign(ShaderOutput *output);
   int stack_assign(ShaderInput *input);
@@ -200,6 +210,7 @@ class SVMCompiler {
                          ShaderInput *input,
                          ShaderNode *skip_node = NULL);
   void generate_node(ShaderNode *node, ShaderNodeSet &done);
+  void tag_svm_node_info(ShaderNode *node);
   void generate_aov_node(ShaderNode *node, CompilerState *state);
   void generate_closure_node(ShaderNode *node, CompilerState *state);
   void generated_shared_closure_nodes(ShaderNode *root_node,
@@ -215,6 +226,7 @@ class SVMCompiler {
   void compile_type(Shader *shader, ShaderGraph *graph, ShaderType type);
 
   array<int4> current_svm_nodes;
+  vector<SVMNodeInfo> current_svm_node_info;
   ShaderType current_type;
   Shader *current_shader;
   Stack active_stack;
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "device/device.h"
+#include "render/buffers.h"
+#include "render/film.h"
+#include "render/stats.h"
+#include "util/util_foreach.h"
+#include "util/util_profiling.h"
+#include "util/util_stats.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+const int kWidth = 4;
+const int kHeight = 4;
+const int kNumSamples = 4096;
+
+const float kEmission[3] = {8.0f, 0.01f, 0.5f};
+const float kNormal[3] = {0.3f, -0.6f, 0.742f};
+const float kObjectId = 3001.0f;
+
+class RenderBuffersTest : public testing::Test {
+ protected:
+  Stats stats;
+  Profiler profiler;
+  DeviceInfo device_info;
+  Device *device_cpu;
+
+  virtual void SetUp()
+  {
+    device_cpu = Device::create(device_info, stats, profiler, true);
+  }
+
+  virtual void TearDown()
+  {
+    delete device_cpu;
+  }
+
+  static BufferParams buffer_params()
+  {
+    BufferParams params;
+    params.width = params.full_width = kWidth;
+    params.height = params.full_height = kHeight;
+    Pass::add(PASS_EMISSION, params.passes, "Emit");
+    Pass::add(PASS_NORMAL, params.passes, "Normal");
+    Pass::add(PASS_OBJECT_ID, params.passes, "IndexOB");
+    return params;
+  }
+
+  /* Accumulate constant valued passes in the render buffers the same way the kernel does, and
+   * read back a pass as the final result. */
+  vector<float> render_pass(const string &name, int components)
+  {
+    BufferParams params = buffer_params();
+    RenderBuffers buffers(device_cpu);
+    buffers.reset(params);
+
+    const int pass_stride = params.get_passes_size();
+    int pass_offset = 0;
+    foreach (const Pass &pass, params.passes) {
+      for (int i = 0; i < kWidth * kHeight; i++) {
+        float *in = buffers.buffer.data() + i * pass_stride + pass_offset;
+        if (pass.type == PASS_OBJECT_ID) {
+          /* Only written by the first sample. */
+          in[0] = kObjectId;
+          continue;
+        }
+        const float *value = (pass.type == PASS_EMISSION) ? kEmission : kNormal;
+        for (int sample = 0; sample < kNumSamples; sample++) {
+          for (int c = 0; c < 3; c++) {
+            in[c] += value[c];
+          }
+        }
+      }
+      pass_offset += pass.components;
+    }
+
+    vector<float> pixels(kWidth * kHeight * components);
+    EXPECT_TRUE(buffers.get_pass_rect(name, 1.0f, kNumSamples, components, &pixels[0]));
+    return pixels;
+  }
+};
+
+}  // namespace
+
+TEST_F(RenderBuffersTest, pass_rect)
+{
+  vector<float> emission = render_pass("Emit", 3);
+  vector<float> normal = render_pass("Normal", 3);
+  vector<float> id = render_pass("IndexOB", 1);
+  for (int i = 0; i < kWidth * kHeight; i++) {
+    for (int c = 0; c < 3; c++) {
+      EXPECT_NEAR(emission[i * 3 + c], kEmission[c], kEmission[c] * 1e-3f);
+      EXPECT_NEAR(normal[i * 3 + c], kNormal[c], fabsf(kNormal[c]) * 1e-3f);
+    }
+    EXPECT_EQ(id[i], kObjectId);
+  }
+}
+
+/* The statistics list the memory the render buffers actually allocate for each pass. */
+TEST_F(RenderBuffersTest, statistics)
+{
+  BufferParams params = buffer_params();
+  RenderBuffers buffers(device_cpu);
+  buffers.reset(params);
+
+  RenderStats render_stats;
+  params.collect_statistics(&render_stats);
+
+  /* The passes, followed by the padding of the pixels. */
+  const NamedSizeStats &passes = render_stats.buffers.passes;
+  ASSERT_EQ(passes.entries.size(), params.passes.size() + 1);
+  for (size_t i = 0; i < params.passes.size(); i++) {
+    EXPECT_EQ(passes.entries[i].name, params.passes[i].name);
+    EXPECT_EQ(passes.entries[i].size,
+              sizeof(float) * kWidth * kHeight * params.passes[i].components);
+  }
+  EXPECT_EQ(passes.total_size, buffers.buffer.size() * sizeof(float));
+}
+
+CCL_NAMESPACE_END
@@ -39,6 +39,7 @@ void Profiler::run()
       uint32_t cur_event = state->event;
       int32_t cur_shader = state->shader;
       int32_t cur_object = state->object;
+      int32_t cur_svm_node = state->svm_node;
 
       /* The state reads/writes should be atomic, but just to be sure
        * check the values for validity anyways. */
@@ -59,6 +60,10 @@ void Profiler::run()
       if (cur_object >= 0 && cur_object < object_samples.size()) {
         object_samples[cur_object]++;
       }
+
+      if (cur_svm_node >= 0 && cur_svm_node < svm_node_samples.size()) {
+        svm_node_samples[cur_svm_node]++;
+      }
     }
     lock.unlock();
 
@@ -71,7 +76,7 @@ void Profiler::run()
   }
 }
 
-void Profiler::reset(int num_shaders, int num_objects)
+void Profiler::reset(int num_shaders, int num_objects, int num_svm_nodes)
 {
   bool running = (worker != NULL);
   if (running) {
@@ -81,10 +86,12 @@ void Profiler::reset(int num_shaders, int num_objects)
   /* Resize and clear the accumulation vectors. */
   shader_hits.assign(num_shaders, 0);
   object_hits.assign(num_objects, 0);
+  svm_node_hits.assign(num_svm_nodes, 0);
 
   event_samples.assign(PROFILING_NUM_EVENTS, 0);
   shader_samples.assign(num_shaders, 0);
   object_samples.assign(num_objects, 0);
+  svm_node_samples.assign(num_svm_nodes, 0);
 
   if (running) {
     start();
@@ -120,11 +127,13 @@ void Profiler::add_state(ProfilingState *state)
   /* Resize thread-local hit counters. */
   state->shader_hits.assign(shader_hits.size(), 0);
   state->object_hits.assign(object_hits.size(), 0);
+  state->svm_node_hits.assign(svm_node_hits.size(), 0);
 
   /* Initialize the state. */
   state->event = PROFILING_UNKNOWN;
   state->shader = -1;
   state->object = -1;
+  state->svm_node = -1;
   state->active = true;
 }
 
@@ -146,6 +155,11 @@ void Profiler::remove_state(ProfilingState *state)
   for (int i = 0; i < object_hits.size(); i++) {
     object_hits[i] += state->object_hits[i];
   }
+
+  assert(svm_node_hits.size() == state->svm_node_hits.size());
+  for (int i = 0; i < svm_node_hits.size(); i++) {
+    svm_node_hits[i] += state->svm_node_hits[i];
+  }
 }
 
 uint64_t Profiler::get_event(ProfilingEvent event)
@@ -176,4 +190,20 @@ bool Profiler::get_object(int object, uint64_t &samples, uint64_t &hits)
   return true;
 }
 
+bool Profiler::get_svm_node(int svm_node, uint64_t &samples, uint64_t &hits)
+{
+  assert(worker == NULL);
+  if (svm_node_samples[svm_node] == 0) {
+    return false;
+  }
+  samples = svm_node_samples[svm_node];
+  hits = svm_node_hits[svm_node];
+  return true;
+}
+
+int Profiler::get_num_svm_nodes()
+{
+  return svm_node_samples.size();
+}
+
 CCL_NAMESPACE_END
@@ -82,10 +82,12 @@ struct ProfilingState {
   volatile uint32_t event = PROFILING_UNKNOWN;
   volatile int32_t shader = -1;
   volatile int32_t object = -1;
+  volatile int32_t svm_node = -1;
   volatile bool active = false;
 
   vector<uint64_t> shader_hits;
   vector<uint64_t> object_hits;
+  vector<uint64_t> svm_node_hits;
 };
 
 class Profiler {
@@ -93,7 +95,8 @@ class Profiler {
   Profiler();
   ~Profiler();
 
-  void reset(int num_shaders, int num_objects);
+  /* SVM node instrumentation is only done when num_svm_nodes is non-zero. */
+  void reset(int num_shaders, int num_objects, int num_svm_nodes = 0);
 
   void start();
   void stop();
@@ -104,6 +107,8 @@ class Profiler {
   uint64_t get_event(ProfilingEvent event);
   bool get_shader(int shader, uint64_t &samples, uint64_t &hits);
   bool get_object(int object, uint64_t &samples, uint64_t &hits);
+  bool get_svm_node(int svm_node, uint64_t &samples, uint64_t &hits);
+  int get_num_svm_nodes();
 
  protected:
   void run();
@@ -114,13 +119,16 @@ class Profiler {
   vector<uint64_t> event_samples;
   vector<uint64_t> shader_samples;
   vector<uint64_t> object_samples;
+  vector<uint64_t> svm_node_samples;
 
   /* Tracks the total amounts every object/shader was hit.
    * Used to evaluate relative cost, written by the render thread.
    * Indexed by the shader and object IDs that the kernel also uses
-   * to index __object_flag and __shaders. */
+   * to index __object_flag and __shaders. SVM nodes are indexed by
+   * their offset in __svm_nodes. */
   vector<uint64_t> shader_hits;
   vector<uint64_t> object_hits;
+  vector<uint64_t> svm_node_hits;
 
   volatile bool do_stop_worker;
   thread *worker;
@@ -170,6 +178,32 @@ class ProfilingHelper {
   uint32_t previous_event;
 };
 
+/* Tracks the SVM node currently being executed by the shader interpreter. */
+class ProfilingSVMHelper {
+ public:
+  ProfilingSVMHelper(ProfilingState *state) : state(state)
+  {
+  }
+
+  inline void set_svm_node(int svm_node)
+  {
+    if (svm_node < state->svm_node_hits.size()) {
+      state->svm_node = svm_node;
+      if (state->active) {
+        state->svm_node_hits[svm_node]++;
+      }
+    }
+  }
+
+  ~ProfilingSVMHelper()
+  {
+    state->svm_node = -1;
+  }
+
+ private:
+  ProfilingState *state;
+};
+
 CCL_NAMESPACE_END
 
 #endif /* __UTIL_PROFILING_H__ */
@@ -74,6 +74,30 @@ typedef enum ImageAlphaType {
 #define IMAGE_DATA_TYPE_SHIFT 3
 #define IMAGE_DATA_TYPE_MASK 0x7
 
+/* Grid types for 3D textures.
+ *
+ * Defines how voxels are laid out in memory. */
+typedef enum ImageGridType {
+  /* All voxels stored densely, in x, y, z order. */
+  IMAGE_GRID_TYPE_DEFAULT = 0,
+  /* Voxels grouped in cubic tiles, only tiles containing non-empty voxels
+   * are stored. A separate offsets array maps tile indices to the start of
+   * the packed tile, or TEX_SPARSE_EMPTY_TILE. */
+  IMAGE_GRID_TYPE_SPARSE = 1,
+
+  IMAGE_GRID_NUM_TYPES,
+} ImageGridType;
+
+/* Sparse grid tile layout, must be a power of two. */
+#define TEX_SPARSE_TILE_SHIFT 3
+#define TEX_SPARSE_TILE_SIZE (1 << TEX_SPARSE_TILE_SHIFT)
+#define TEX_SPARSE_TILE_MASK (TEX_SPARSE_TILE_SIZE - 1)
+#define TEX_SPARSE_TILE_VOXELS (TEX_SPARSE_TILE_SIZE * TEX_SPARSE_TILE_SIZE * TEX_SPARSE_TILE_SIZE)
+#define TEX_SPARSE_EMPTY_TILE -1
+
+/* Number of tiles needed to cover the given number of voxels along one axis. */
+#define TEX_SPARSE_NUM_TILES(size) (((size) + TEX_SPARSE_TILE_MASK) >> TEX_SPARSE_TILE_SHIFT)
+
 /* Extension types for textures.
  *
  * Defines how the image is extrapolated past its original bounds. */
@@ -91,12 +115,16 @@ typedef enum ExtensionType {
 typedef struct TextureInfo {
   /* Pointer, offset or texture depending on device. */
   uint64_t data;
+  /* Pointer to the tile offsets of sparse grids, zero otherwise. */
+  uint64_t grid_info;
   /* Buffer number for OpenCL. */
   uint cl_buffer;
   /* Interpolation and extension type. */
   uint interpolation, extension;
   /* Dimensions. */
   uint width, height, depth;
+  /* Voxel layout of 3D textures. */
+  uint grid_type;
 } TextureInfo;
 
 CCL_NAMESPACE_END
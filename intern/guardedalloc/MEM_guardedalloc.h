@@ -192,6 +192,12 @@ extern size_t (*MEM_get_memory_in_use)(void);
 extern size_t (*MEM_get_mapped_memory_in_use)(void);
 /** Get amount of memory blocks in use. */
 extern unsigned int (*MEM_get_memory_blocks_in_use)(void);
+/**
+ * Get the memory allocated for the blocks in use. Unlike #MEM_get_memory_in_use, which counts
+ * the requested lengths, this includes the rounding of small blocks to their size class. */
+extern size_t (*MEM_get_memory_allocated)(void);
+/** Get the memory of freed blocks kept by the allocator for reuse, not included in the above. */
+extern size_t (*MEM_get_memory_cached)(void);
 
 /** Reset the peak memory statistic to zero. */
 extern void (*MEM_reset_peak_memory)(void);
@@ -61,6 +61,8 @@ void (*MEM_set_memory_debug)(void) = MEM_lockfree_set_memory_debug;
 size_t (*MEM_get_memory_in_use)(void) = MEM_lockfree_get_memory_in_use;
 size_t (*MEM_get_mapped_memory_in_use)(void) = MEM_lockfree_get_mapped_memory_in_use;
 unsigned int (*MEM_get_memory_blocks_in_use)(void) = MEM_lockfree_get_memory_blocks_in_use;
+size_t (*MEM_get_memory_allocated)(void) = MEM_lockfree_get_memory_allocated;
+size_t (*MEM_get_memory_cached)(void) = MEM_lockfree_get_memory_cached;
 void (*MEM_reset_peak_memory)(void) = MEM_lockfree_reset_peak_memory;
 size_t (*MEM_get_peak_memory)(void) = MEM_lockfree_get_peak_memory;
 
@@ -123,6 +125,8 @@ void MEM_use_guarded_allocator(void)
   MEM_get_memory_in_use = MEM_guarded_get_memory_in_use;
   MEM_get_mapped_memory_in_use = MEM_guarded_get_mapped_memory_in_use;
   MEM_get_memory_blocks_in_use = MEM_guarded_get_memory_blocks_in_use;
+  MEM_get_memory_allocated = MEM_guarded_get_memory_allocated;
+  MEM_get_memory_cached = MEM_guarded_get_memory_cached;
   MEM_reset_peak_memory = MEM_guarded_reset_peak_memory;
   MEM_get_peak_memory = MEM_guarded_get_peak_memory;
 
@@ -1292,6 +1292,18 @@ unsigned int MEM_guarded_get_memory_blocks_in_use(void)
   return _totblock;
 }
 
+/* Blocks are allocated with their exact length. */
+size_t MEM_guarded_get_memory_allocated(void)
+{
+  return MEM_guarded_get_memory_in_use();
+}
+
+/* Freed blocks are not kept for reuse. */
+size_t MEM_guarded_get_memory_cached(void)
+{
+  return 0;
+}
+
 #ifndef NDEBUG
 const char *MEM_guarded_name_ptr(void *vmemh)
 {
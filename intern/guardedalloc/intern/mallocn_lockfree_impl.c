@@ -25,6 +25,24 @@
 #include <stdarg.h>
 #include <sys/types.h>
 
+/* Keep freed small blocks in thread-local caches, to hand them out again without going through
+ * the system allocator. Not on Windows, where the system heap already has per thread caches
+ * (and there is no portable thread exit callback), nor for memory checkers, which the reuse
+ * would hide use after free errors from. */
+#if !defined(WIN32) && !defined(WITH_MEM_VALGRIND) && !defined(__SANITIZE_ADDRESS__)
+#  if defined(__has_feature)
+#    if !__has_feature(address_sanitizer)
+#      define USE_THREAD_CACHE
+#    endif
+#  else
+#    define USE_THREAD_CACHE
+#  endif
+#endif
+
+#ifdef USE_THREAD_CACHE
+#  include <pthread.h>
+#endif
+
 #include "MEM_guardedalloc.h"
 
 /* to ensure strict conversions */
@@ -45,6 +63,10 @@ typedef struct MemHeadAligned {
 
 static unsigned int totblock = 0;
 static size_t mem_in_use = 0, mmap_in_use = 0, peak_mem = 0;
+/* Memory of freed blocks kept for reuse by any thread, not counted in #mem_in_use. */
+static size_t mem_cached = 0;
+/* Memory added to the blocks in use by rounding them up to their size class. */
+static size_t mem_class_padding = 0;
 static bool malloc_debug_memset = false;
 
 static void (*error_callback)(const char *) = NULL;
@@ -107,6 +129,246 @@ static void mem_unlock_thread(void)
 }
 #endif
 
+/* -------------------------------------------------------------------- */
+/** \name Thread Cache
+ *
+ * Blocks up to #MEM_CACHE_LEN_MAX are allocated rounded up to one of #MEM_CACHE_CLASS_LEN size
+ * classes. When freed, they go to a list per size class of the freeing thread, the next
+ * allocation of that class on the thread takes them from there.
+ * Full lists are moved as a batch to a depot shared by all threads, where threads with empty
+ * lists take them from, so memory allocated by one thread and freed by another flows back.
+ *
+ * Only blocks in use are counted in #mem_in_use, as without the cache, with their requested
+ * length. Their rounding up to the size class is counted in #mem_class_padding. Cached blocks,
+ * in the lists of the threads and in the depot, are counted in #mem_cached.
+ * \{ */
+
+#ifdef USE_THREAD_CACHE
+
+#  define MEM_CACHE_CLASS_STEP 16
+#  define MEM_CACHE_CLASS_LEN 32
+#  define MEM_CACHE_LEN_MAX (MEM_CACHE_CLASS_STEP * MEM_CACHE_CLASS_LEN)
+/* Memory kept per size class, by every thread and in the depot. */
+#  define MEM_CACHE_BIN_BYTES 8192
+#  define MEM_CACHE_DEPOT_BATCHES_MAX 32
+
+/* Stored in the data of a cached block, which is always large enough. */
+typedef struct MemCacheBlock {
+  struct MemCacheBlock *next;
+  /* Only used by the first block of a batch in the depot. */
+  struct MemCacheBlock *batch_next;
+} MemCacheBlock;
+
+typedef struct MemCacheBin {
+  MemCacheBlock *first;
+  unsigned int len;
+} MemCacheBin;
+
+typedef struct MemThreadCache {
+  MemCacheBin bins[MEM_CACHE_CLASS_LEN];
+} MemThreadCache;
+
+typedef struct MemCacheDepot {
+  unsigned int lock;
+  unsigned int batches_len;
+  MemCacheBlock *batches;
+  /* Keep the locks of different classes on their own cache line. */
+  char _pad[64 - sizeof(unsigned int) * 2 - sizeof(void *)];
+} MemCacheDepot;
+
+static MemCacheDepot mem_cache_depot[MEM_CACHE_CLASS_LEN];
+
+static pthread_key_t thread_cache_key;
+static pthread_once_t thread_cache_key_once = PTHREAD_ONCE_INIT;
+/* Set once the thread cache was freed on thread exit, for frees from later exit callbacks. */
+#  define THREAD_CACHE_EXITED ((MemThreadCache *)1)
+
+MEM_INLINE unsigned int mem_cache_class(size_t len)
+{
+  return len ? (unsigned int)((len - 1) / MEM_CACHE_CLASS_STEP) : 0;
+}
+
+MEM_INLINE size_t mem_cache_class_size(unsigned int size_class)
+{
+  return (size_t)(size_class + 1) * MEM_CACHE_CLASS_STEP;
+}
+
+MEM_INLINE unsigned int mem_cache_bin_len_max(unsigned int size_class)
+{
+  const unsigned int len_max = MEM_CACHE_BIN_BYTES / (unsigned int)mem_cache_class_size(
+                                                         size_class);
+  return len_max > 8 ? len_max : 8;
+}
+
+/* Size to allocate for \a len bytes, so the block can be cached and reused for its class. */
+MEM_INLINE size_t mem_alloc_len(size_t len)
+{
+  return (len <= MEM_CACHE_LEN_MAX) ? mem_cache_class_size(mem_cache_class(len)) : len;
+}
+
+MEM_INLINE void mem_cache_depot_lock(MemCacheDepot *depot)
+{
+  while (atomic_cas_u(&depot->lock, 0, 1) != 0) {
+    /* pass */
+  }
+}
+
+MEM_INLINE void mem_cache_depot_unlock(MemCacheDepot *depot)
+{
+  atomic_cas_u(&depot->lock, 1, 0);
+}
+
+static void mem_cache_blocks_free(MemCacheBlock *block)
+{
+  while (block) {
+    MemCacheBlock *block_next = block->next;
+    free(MEMHEAD_FROM_PTR(block));
+    block = block_next;
+  }
+}
+
+static void mem_cache_depot_push(unsigned int size_class, MemCacheBlock *first, unsigned int len)
+{
+  MemCacheDepot *depot = &mem_cache_depot[size_class];
+  bool stored = false;
+
+  /* The batch length is kept in the #MemHead of its first block, unused while cached. */
+  MEMHEAD_FROM_PTR(first)->len = len;
+
+  mem_cache_depot_lock(depot);
+  if (depot->batches_len < MEM_CACHE_DEPOT_BATCHES_MAX) {
+    first->batch_next = depot->batches;
+    depot->batches = first;
+    depot->batches_len++;
+    stored = true;
+  }
+  mem_cache_depot_unlock(depot);
+
+  if (!stored) {
+    atomic_sub_and_fetch_z(&mem_cached, mem_cache_class_size(size_class) * len);
+    mem_cache_blocks_free(first);
+  }
+}
+
+static MemCacheBlock *mem_cache_depot_pop(unsigned int size_class, unsigned int *r_len)
+{
+  MemCacheDepot *depot = &mem_cache_depot[size_class];
+  MemCacheBlock *first = NULL;
+
+  /* Skip the lock when there is obviously nothing to take. */
+  if (depot->batches == NULL) {
+    return NULL;
+  }
+
+  mem_cache_depot_lock(depot);
+  if (depot->batches) {
+    first = depot->batches;
+    depot->batches = first->batch_next;
+    depot->batches_len--;
+  }
+  mem_cache_depot_unlock(depot);
+
+  if (first) {
+    *r_len = (unsigned int)MEMHEAD_FROM_PTR(first)->len;
+  }
+  return first;
+}
+
+static void thread_cache_exit(void *value)
+{
+  MemThreadCache *cache = value;
+  if (cache == THREAD_CACHE_EXITED) {
+    /* The value is cleared before calling this, set it again for frees from exit callbacks
+     * called after this one, which would allocate a new cache otherwise. */
+    pthread_setspecific(thread_cache_key, THREAD_CACHE_EXITED);
+    return;
+  }
+  for (unsigned int size_class = 0; size_class < MEM_CACHE_CLASS_LEN; size_class++) {
+    MemCacheBin *bin = &cache->bins[size_class];
+    if (bin->first) {
+      mem_cache_depot_push(size_class, bin->first, bin->len);
+    }
+  }
+  free(cache);
+  pthread_setspecific(thread_cache_key, THREAD_CACHE_EXITED);
+}
+
+static void thread_cache_key_create(void)
+{
+  pthread_key_create(&thread_cache_key, thread_cache_exit);
+}
+
+MEM_INLINE MemThreadCache *thread_cache_get(void)
+{
+  pthread_once(&thread_cache_key_once, thread_cache_key_create);
+  MemThreadCache *cache = pthread_getspecific(thread_cache_key);
+  if (UNLIKELY(cache == NULL)) {
+    cache = calloc(1, sizeof(*cache));
+    if (cache) {
+      pthread_setspecific(thread_cache_key, cache);
+    }
+  }
+  else if (UNLIKELY(cache == THREAD_CACHE_EXITED)) {
+    return NULL;
+  }
+  return cache;
+}
+
+/* Take a cached block for \a len bytes (at most #MEM_CACHE_LEN_MAX). */
+MEM_INLINE MemHead *thread_cache_pop(size_t len)
+{
+  MemThreadCache *cache = thread_cache_get();
+  if (UNLIKELY(cache == NULL)) {
+    return NULL;
+  }
+  const unsigned int size_class = mem_cache_class(len);
+  MemCacheBin *bin = &cache->bins[size_class];
+  if (bin->first == NULL) {
+    bin->first = mem_cache_depot_pop(size_class, &bin->len);
+    if (bin->first == NULL) {
+      return NULL;
+    }
+  }
+  MemCacheBlock *block = bin->first;
+  bin->first = block->next;
+  bin->len--;
+  atomic_sub_and_fetch_z(&mem_cached, mem_cache_class_size(size_class));
+  return MEMHEAD_FROM_PTR(block);
+}
+
+/* Keep a block of \a len bytes (at most #MEM_CACHE_LEN_MAX) for reuse. */
+MEM_INLINE bool thread_cache_push(MemHead *memh, size_t len)
+{
+  MemThreadCache *cache = thread_cache_get();
+  if (UNLIKELY(cache == NULL)) {
+    return false;
+  }
+  const unsigned int size_class = mem_cache_class(len);
+  MemCacheBin *bin = &cache->bins[size_class];
+  if (bin->len == mem_cache_bin_len_max(size_class)) {
+    mem_cache_depot_push(size_class, bin->first, bin->len);
+    bin->first = NULL;
+    bin->len = 0;
+  }
+  MemCacheBlock *block = (MemCacheBlock *)PTR_FROM_MEMHEAD(memh);
+  block->next = bin->first;
+  bin->first = block;
+  bin->len++;
+  atomic_add_and_fetch_z(&mem_cached, mem_cache_class_size(size_class));
+  return true;
+}
+
+#else
+
+MEM_INLINE size_t mem_alloc_len(size_t len)
+{
+  return len;
+}
+
+#endif /* USE_THREAD_CACHE */
+
+/** \} */
+
 size_t MEM_lockfree_allocN_len(const void *vmemh)
 {
   if (vmemh) {
@@ -153,6 +415,14 @@ void MEM_lockfree_freeN(void *vmemh)
       MemHeadAligned *memh_aligned = MEMHEAD_ALIGNED_FROM_PTR(vmemh);
       aligned_free(MEMHEAD_REAL_PTR(memh_aligned));
     }
+#ifdef USE_THREAD_CACHE
+    else if (len <= MEM_CACHE_LEN_MAX) {
+      atomic_sub_and_fetch_z(&mem_class_padding, mem_alloc_len(len) - len);
+      if (!thread_cache_push(memh, len)) {
+        free(memh);
+      }
+    }
+#endif
     else {
       free(memh);
     }
@@ -264,12 +534,23 @@ void *MEM_lockfree_callocN(size_t len, const char *str)
 
   len = SIZET_ALIGN_4(len);
 
-  memh = (MemHead *)calloc(1, len + sizeof(MemHead));
+#ifdef USE_THREAD_CACHE
+  if (len <= MEM_CACHE_LEN_MAX && (memh = thread_cache_pop(len))) {
+    memset(memh + 1, 0, len);
+  }
+  else
+#endif
+  {
+    memh = (MemHead *)calloc(1, mem_alloc_len(len) + sizeof(MemHead));
+  }
 
   if (LIKELY(memh)) {
     memh->len = len;
     atomic_add_and_fetch_u(&totblock, 1);
     atomic_add_and_fetch_z(&mem_in_use, len);
+#ifdef USE_THREAD_CACHE
+    atomic_add_and_fetch_z(&mem_class_padding, mem_alloc_len(len) - len);
+#endif
     update_maximum(&peak_mem, mem_in_use);
 
     return PTR_FROM_MEMHEAD(memh);
@@ -305,7 +586,12 @@ void *MEM_lockfree_mallocN(size_t len, const char *str)
 
   len = SIZET_ALIGN_4(len);
 
-  memh = (MemHead *)malloc(len + sizeof(MemHead));
+#ifdef USE_THREAD_CACHE
+  if (len > MEM_CACHE_LEN_MAX || (memh = thread_cache_pop(len)) == NULL)
+#endif
+  {
+    memh = (MemHead *)malloc(mem_alloc_len(len) + sizeof(MemHead));
+  }
 
   if (LIKELY(memh)) {
     if (UNLIKELY(malloc_debug_memset && len)) {
@@ -315,6 +601,9 @@ void *MEM_lockfree_mallocN(size_t len, const char *str)
     memh->len = len;
     atomic_add_and_fetch_u(&totblock, 1);
     atomic_add_and_fetch_z(&mem_in_use, len);
+#ifdef USE_THREAD_CACHE
+    atomic_add_and_fetch_z(&mem_class_padding, mem_alloc_len(len) - len);
+#endif
     update_maximum(&peak_mem, mem_in_use);
 
     return PTR_FROM_MEMHEAD(memh);
@@ -456,6 +745,9 @@ void MEM_lockfree_printmemlist_stats(void)
 {
   printf("\ntotal memory len: %.3f MB\n", (double)mem_in_use / (double)(1024 * 1024));
   printf("peak memory len: %.3f MB\n", (double)peak_mem / (double)(1024 * 1024));
+  printf("size class padding len: %.3f MB\n",
+         (double)mem_class_padding / (double)(1024 * 1024));
+  printf("cached memory len: %.3f MB\n", (double)mem_cached / (double)(1024 * 1024));
   printf(
       "\nFor more detailed per-block statistics run Blender with memory debugging command line "
       "argument.\n");
@@ -502,6 +794,16 @@ unsigned int MEM_lockfree_get_memory_blocks_in_use(void)
   return totblock;
 }
 
+size_t MEM_lockfree_get_memory_allocated(void)
+{
+  return mem_in_use + mem_class_padding;
+}
+
+size_t MEM_lockfree_get_memory_cached(void)
+{
+  return mem_cached;
+}
+
 /* dummy */
 void MEM_lockfree_reset_peak_memory(void)
 {
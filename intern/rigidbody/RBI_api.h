@@ -80,6 +80,9 @@ void RB_dworld_set_gravity(rbDynamicsWorld *world, const float g_in[3]);
 void RB_dworld_set_solver_iterations(rbDynamicsWorld *world, int num_solver_iterations);
 /* Split Impulse */
 void RB_dworld_set_split_impulse(rbDynamicsWorld *world, int split_impulse);
+/* Threading, islands are solved on num_threads threads. In deterministic mode the result does
+ * not depend on the number of threads. */
+void RB_dworld_set_threading(rbDynamicsWorld *world, int num_threads, int deterministic);
 
 /* Simulation ----------------------- */
 
@@ -67,8 +67,10 @@
 #include "BulletCollision/Gimpact/btGImpactCollisionAlgorithm.h"
 #include "BulletCollision/CollisionShapes/btScaledBvhTriangleMeshShape.h"
 
+#include "rb_threaded_world.h"
+
 struct rbDynamicsWorld {
-  btDiscreteDynamicsWorld *dynamicsWorld;
+  rbThreadedDynamicsWorld *dynamicsWorld;
   btDefaultCollisionConfiguration *collisionConfiguration;
   btDispatcher *dispatcher;
   btBroadphaseInterface *pairCache;
@@ -153,7 +155,7 @@ rbDynamicsWorld *RB_dworld_new(const float gravity[3])
   world->constraintSolver = new btSequentialImpulseConstraintSolver();
 
   /* world */
-  world->dynamicsWorld = new btDiscreteDynamicsWorld(
+  world->dynamicsWorld = new rbThreadedDynamicsWorld(
       world->dispatcher, world->pairCache, world->constraintSolver, world->collisionConfiguration);
 
   RB_dworld_set_gravity(world, gravity);
@@ -202,6 +204,12 @@ void RB_dworld_set_split_impulse(rbDynamicsWorld *world, int split_impulse)
   info.m_splitImpulse = split_impulse;
 }
 
+/* Threading */
+void RB_dworld_set_threading(rbDynamicsWorld *world, int num_threads, int deterministic)
+{
+  world->dynamicsWorld->setThreading(num_threads, deterministic != 0);
+}
+
 /* Simulation ----------------------- */
 
 void RB_dworld_step_simulation(rbDynamicsWorld *world,
@@ -0,0 +1,520 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 Blender Foundation
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup RigidBody
+ * \brief Threaded dynamics world for Bullet
+ */
+
+#include <algorithm>
+#include <atomic>
+
+#include "BulletCollision/CollisionDispatch/btSimulationIslandManager.h"
+
+#include "rb_threaded_world.h"
+
+/* Below this many bodies, integration is not worth distributing over threads. */
+#define RB_INTEGRATE_MIN_BODIES 256
+#define RB_INTEGRATE_GRAIN_SIZE 64
+
+/* ********************************** */
+/* Thread Pool */
+
+rbThreadPool::rbThreadPool(int num_threads)
+    : m_func(NULL), m_generation(0), m_num_running(0), m_stop(false)
+{
+  for (int i = 1; i < num_threads; i++) {
+    m_threads.push_back(std::thread(&rbThreadPool::worker, this, i));
+  }
+}
+
+rbThreadPool::~rbThreadPool()
+{
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_start_cond.notify_all();
+
+  for (size_t i = 0; i < m_threads.size(); i++) {
+    m_threads[i].join();
+  }
+}
+
+void rbThreadPool::run(const std::function<void(int)> &func)
+{
+  if (m_threads.empty()) {
+    func(0);
+    return;
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_func = &func;
+    m_num_running = (int)m_threads.size();
+    m_generation++;
+  }
+  m_start_cond.notify_all();
+
+  func(0);
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_done_cond.wait(lock, [this] { return m_num_running == 0; });
+  m_func = NULL;
+}
+
+void rbThreadPool::worker(int thread_index)
+{
+  unsigned int generation = 0;
+
+  for (;;) {
+    const std::function<void(int)> *func;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_start_cond.wait(lock, [&] { return m_stop || m_generation != generation; });
+      if (m_stop) {
+        return;
+      }
+      generation = m_generation;
+      func = m_func;
+    }
+
+    (*func)(thread_index);
+
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      if (--m_num_running == 0) {
+        m_done_cond.notify_one();
+      }
+    }
+  }
+}
+
+/* ********************************** */
+/* Island Solving */
+
+/* Solver and scratch arrays owned by one thread. */
+struct rbSolverThreadData {
+  btSequentialImpulseConstraintSolver solver;
+  btAlignedObjectArray<btCollisionObject *> bodies;
+  btAlignedObjectArray<btPersistentManifold *> manifolds;
+  btAlignedObjectArray<btTypedConstraint *> constraints;
+
+  void clear()
+  {
+    bodies.resize(0);
+    manifolds.resize(0);
+    constraints.resize(0);
+  }
+
+  BT_DECLARE_ALIGNED_ALLOCATOR();
+};
+
+/* Same island assignment as the discrete world uses for constraints. */
+static int rb_constraint_island_id(const btTypedConstraint *constraint)
+{
+  const btCollisionObject &ob0 = constraint->getRigidBodyA();
+  const btCollisionObject &ob1 = constraint->getRigidBodyB();
+
+  return (ob0.getIslandTag() >= 0) ? ob0.getIslandTag() : ob1.getIslandTag();
+}
+
+struct rbConstraintIslandSortPredicate {
+  bool operator()(const btTypedConstraint *lhs, const btTypedConstraint *rhs) const
+  {
+    return rb_constraint_island_id(lhs) < rb_constraint_island_id(rhs);
+  }
+};
+
+/* Gathers the islands that are awake, the island manager reuses its body array per island so
+ * everything is copied out. */
+struct rbIslandCollector : public btSimulationIslandManager::IslandCallback {
+  rbThreadedDynamicsWorld *world;
+
+  explicit rbIslandCollector(rbThreadedDynamicsWorld *world) : world(world)
+  {
+  }
+
+  virtual void processIsland(btCollisionObject **bodies,
+                             int numBodies,
+                             btPersistentManifold **manifolds,
+                             int numManifolds,
+                             int islandId)
+  {
+    world->addIsland(bodies, numBodies, manifolds, numManifolds, islandId);
+  }
+};
+
+static bool rb_manifold_touches_kinematic(const btPersistentManifold *manifold)
+{
+  return manifold->getBody0()->isKinematicObject() || manifold->getBody1()->isKinematicObject();
+}
+
+static bool rb_constraint_touches_kinematic(const btTypedConstraint *constraint)
+{
+  return constraint->getRigidBodyA().isKinematicObject() ||
+         constraint->getRigidBodyB().isKinematicObject();
+}
+
+/* ********************************** */
+/* Threaded World */
+
+rbThreadedDynamicsWorld::rbThreadedDynamicsWorld(btDispatcher *dispatcher,
+                                                 btBroadphaseInterface *pairCache,
+                                                 btConstraintSolver *constraintSolver,
+                                                 btCollisionConfiguration *collisionConfiguration)
+    : btDiscreteDynamicsWorld(dispatcher, pairCache, constraintSolver, collisionConfiguration),
+      m_pool(NULL),
+      m_deterministic(false)
+{
+  setThreading(1, false);
+}
+
+rbThreadedDynamicsWorld::~rbThreadedDynamicsWorld()
+{
+  delete m_pool;
+
+  for (size_t i = 0; i < m_thread_data.size(); i++) {
+    delete m_thread_data[i];
+  }
+}
+
+void rbThreadedDynamicsWorld::setThreading(int num_threads, bool deterministic)
+{
+  num_threads = std::max(num_threads, 1);
+  m_deterministic = deterministic;
+
+  if (m_pool && m_pool->num_threads() == num_threads) {
+    return;
+  }
+
+  delete m_pool;
+  for (size_t i = 0; i < m_thread_data.size(); i++) {
+    delete m_thread_data[i];
+  }
+
+  m_pool = new rbThreadPool(num_threads);
+  m_thread_data.resize(num_threads);
+  for (int i = 0; i < num_threads; i++) {
+    m_thread_data[i] = new rbSolverThreadData();
+  }
+}
+
+bool rbThreadedDynamicsWorld::useThreadedSolver() const
+{
+  /* Deterministic mode always takes the threaded code path, so that a single thread gives the
+   * same result as many. */
+  return (m_pool->num_threads() > 1 || m_deterministic) && m_islandManager->getSplitIslands();
+}
+
+bool rbThreadedDynamicsWorld::useThreadedIntegration() const
+{
+  if (m_pool->num_threads() == 1 || m_nonStaticRigidBodies.size() < RB_INTEGRATE_MIN_BODIES) {
+    return false;
+  }
+
+  /* Continuous collision clamps motion with sweep tests against the collision world, and
+   * speculative restitution applies impulses to pairs of bodies. */
+  if (m_applySpeculativeContactRestitution) {
+    return false;
+  }
+  if (getDispatchInfo().m_useContinuous) {
+    for (int i = 0; i < m_nonStaticRigidBodies.size(); i++) {
+      if (m_nonStaticRigidBodies[i]->getCcdSquareMotionThreshold() != btScalar(0)) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+void rbThreadedDynamicsWorld::parallelFor(int num_items,
+                                          int grain_size,
+                                          const std::function<void(int, int)> &func)
+{
+  std::atomic<int> next(0);
+
+  m_pool->run([&](int /*thread_index*/) {
+    for (;;) {
+      const int start = next.fetch_add(grain_size);
+      if (start >= num_items) {
+        break;
+      }
+      func(start, std::min(start + grain_size, num_items));
+    }
+  });
+}
+
+/* Integration ---------------------- */
+
+void rbThreadedDynamicsWorld::predictUnconstraintMotion(btScalar timeStep)
+{
+  if (!useThreadedIntegration()) {
+    btDiscreteDynamicsWorld::predictUnconstraintMotion(timeStep);
+    return;
+  }
+
+  parallelFor(m_nonStaticRigidBodies.size(), RB_INTEGRATE_GRAIN_SIZE, [&](int start, int end) {
+    for (int i = start; i < end; i++) {
+      btRigidBody *body = m_nonStaticRigidBodies[i];
+      if (!body->isStaticOrKinematicObject()) {
+        body->applyDamping(timeStep);
+        body->predictIntegratedTransform(timeStep, body->getInterpolationWorldTransform());
+      }
+    }
+  });
+}
+
+void rbThreadedDynamicsWorld::integrateTransforms(btScalar timeStep)
+{
+  if (!useThreadedIntegration()) {
+    btDiscreteDynamicsWorld::integrateTransforms(timeStep);
+    return;
+  }
+
+  parallelFor(m_nonStaticRigidBodies.size(), RB_INTEGRATE_GRAIN_SIZE, [&](int start, int end) {
+    btTransform predictedTrans;
+    for (int i = start; i < end; i++) {
+      btRigidBody *body = m_nonStaticRigidBodies[i];
+      body->setHitFraction(1.0f);
+
+      if (body->isActive() && !body->isStaticOrKinematicObject()) {
+        body->predictIntegratedTransform(timeStep, predictedTrans);
+        body->proceedToTransform(predictedTrans);
+      }
+    }
+  });
+}
+
+/* Constraint Solving --------------- */
+
+void rbThreadedDynamicsWorld::addIsland(btCollisionObject **bodies,
+                                        int numBodies,
+                                        btPersistentManifold **manifolds,
+                                        int numManifolds,
+                                        int islandId)
+{
+  rbIsland island;
+  island.island_id = islandId;
+  island.body_start = m_island_bodies.size();
+  island.num_bodies = numBodies;
+  island.manifold_start = m_island_manifolds.size();
+  island.num_manifolds = numManifolds;
+  island.constraint_start = 0;
+  island.num_constraints = 0;
+  island.touches_kinematic = false;
+
+  for (int i = 0; i < numBodies; i++) {
+    m_island_bodies.push_back(bodies[i]);
+  }
+  for (int i = 0; i < numManifolds; i++) {
+    m_island_manifolds.push_back(manifolds[i]);
+    island.touches_kinematic |= rb_manifold_touches_kinematic(manifolds[i]);
+  }
+
+  m_islands.push_back(island);
+}
+
+void rbThreadedDynamicsWorld::assignConstraintsToIslands()
+{
+  m_sortedConstraints.resize(m_constraints.size());
+  for (int i = 0; i < m_constraints.size(); i++) {
+    m_sortedConstraints[i] = m_constraints[i];
+  }
+  m_sortedConstraints.quickSort(rbConstraintIslandSortPredicate());
+
+  /* Islands arrive in increasing island id order, so both lists can be walked together. */
+  int c = 0;
+  for (size_t i = 0; i < m_islands.size(); i++) {
+    rbIsland &island = m_islands[i];
+
+    while (c < m_sortedConstraints.size() &&
+           rb_constraint_island_id(m_sortedConstraints[c]) < island.island_id) {
+      c++;
+    }
+
+    island.constraint_start = m_island_constraints.size();
+    while (c < m_sortedConstraints.size() &&
+           rb_constraint_island_id(m_sortedConstraints[c]) == island.island_id) {
+      btTypedConstraint *constraint = m_sortedConstraints[c];
+      m_island_constraints.push_back(constraint);
+      island.touches_kinematic |= rb_constraint_touches_kinematic(constraint);
+      c++;
+    }
+    island.num_constraints = m_island_constraints.size() - island.constraint_start;
+  }
+}
+
+static void rb_batch_add_island(rbSolverThreadData &data,
+                                const rbIsland &island,
+                                const btAlignedObjectArray<btCollisionObject *> &bodies,
+                                const btAlignedObjectArray<btPersistentManifold *> &manifolds,
+                                const btAlignedObjectArray<btTypedConstraint *> &constraints)
+{
+  for (int i = 0; i < island.num_bodies; i++) {
+    data.bodies.push_back(bodies[island.body_start + i]);
+  }
+  for (int i = 0; i < island.num_manifolds; i++) {
+    data.manifolds.push_back(manifolds[island.manifold_start + i]);
+  }
+  for (int i = 0; i < island.num_constraints; i++) {
+    data.constraints.push_back(constraints[island.constraint_start + i]);
+  }
+}
+
+/* Same batching rule as the islands callback of the discrete world. */
+static bool rb_batch_is_full(const rbSolverThreadData &data, const btContactSolverInfo &info)
+{
+  return (data.constraints.size() + data.manifolds.size()) > info.m_minimumSolverBatchSize;
+}
+
+void rbThreadedDynamicsWorld::solveBatch(rbSolverThreadData &data,
+                                         btContactSolverInfo &solverInfo)
+{
+  if (data.bodies.size() == 0) {
+    return;
+  }
+
+  if (m_deterministic) {
+    /* Reset the random seed used for solver order randomization. */
+    data.solver.reset();
+  }
+
+  data.solver.solveGroup(&data.bodies[0],
+                         data.bodies.size(),
+                         data.manifolds.size() ? &data.manifolds[0] : NULL,
+                         data.manifolds.size(),
+                         data.constraints.size() ? &data.constraints[0] : NULL,
+                         data.constraints.size(),
+                         solverInfo,
+                         m_debugDrawer,
+                         m_dispatcher1);
+  data.clear();
+}
+
+/* Batches are formed in island order, independent of the number of threads. */
+void rbThreadedDynamicsWorld::solveIslandsOrdered(const std::vector<int> &islands,
+                                                  btContactSolverInfo &solverInfo)
+{
+  std::vector<int> batch_starts;
+  int batch_size = 0;
+
+  for (size_t i = 0; i < islands.size(); i++) {
+    const rbIsland &island = m_islands[islands[i]];
+    if (batch_size == 0) {
+      batch_starts.push_back((int)i);
+    }
+    batch_size += island.num_constraints + island.num_manifolds;
+    if (batch_size > solverInfo.m_minimumSolverBatchSize) {
+      batch_size = 0;
+    }
+  }
+  batch_starts.push_back((int)islands.size());
+
+  const int num_batches = (int)batch_starts.size() - 1;
+  std::atomic<int> next(0);
+
+  m_pool->run([&](int thread_index) {
+    rbSolverThreadData &data = *m_thread_data[thread_index];
+    for (int batch = next++; batch < num_batches; batch = next++) {
+      for (int i = batch_starts[batch]; i < batch_starts[batch + 1]; i++) {
+        rb_batch_add_island(
+            data, m_islands[islands[i]], m_island_bodies, m_island_manifolds, m_island_constraints);
+      }
+      solveBatch(data, solverInfo);
+    }
+  });
+}
+
+/* Each thread batches the islands it picks up, largest islands first. */
+void rbThreadedDynamicsWorld::solveIslandsDynamic(const std::vector<int> &islands,
+                                                  btContactSolverInfo &solverInfo)
+{
+  std::vector<int> sorted_islands(islands);
+  std::sort(sorted_islands.begin(), sorted_islands.end(), [this](int a, int b) {
+    return (m_islands[a].num_constraints + m_islands[a].num_manifolds) >
+           (m_islands[b].num_constraints + m_islands[b].num_manifolds);
+  });
+
+  const int num_islands = (int)sorted_islands.size();
+  std::atomic<int> next(0);
+
+  m_pool->run([&](int thread_index) {
+    rbSolverThreadData &data = *m_thread_data[thread_index];
+    for (int i = next++; i < num_islands; i = next++) {
+      rb_batch_add_island(data,
+                          m_islands[sorted_islands[i]],
+                          m_island_bodies,
+                          m_island_manifolds,
+                          m_island_constraints);
+      if (rb_batch_is_full(data, solverInfo)) {
+        solveBatch(data, solverInfo);
+      }
+    }
+    solveBatch(data, solverInfo);
+  });
+}
+
+void rbThreadedDynamicsWorld::solveConstraints(btContactSolverInfo &solverInfo)
+{
+  if (!useThreadedSolver()) {
+    btDiscreteDynamicsWorld::solveConstraints(solverInfo);
+    return;
+  }
+
+  m_island_bodies.resize(0);
+  m_island_manifolds.resize(0);
+  m_island_constraints.resize(0);
+  m_islands.clear();
+
+  rbIslandCollector collector(this);
+  m_islandManager->buildAndProcessIslands(getCollisionWorld()->getDispatcher(),
+                                          getCollisionWorld(),
+                                          &collector);
+  assignConstraintsToIslands();
+
+  /* Islands touching kinematic bodies are solved on this thread afterwards. */
+  std::vector<int> parallel_islands, serial_islands;
+  for (size_t i = 0; i < m_islands.size(); i++) {
+    if (m_islands[i].touches_kinematic) {
+      serial_islands.push_back((int)i);
+    }
+    else {
+      parallel_islands.push_back((int)i);
+    }
+  }
+
+  if (m_deterministic) {
+    solveIslandsOrdered(parallel_islands, solverInfo);
+  }
+  else {
+    solveIslandsDynamic(parallel_islands, solverInfo);
+  }
+
+  rbSolverThreadData &data = *m_thread_data[0];
+  for (size_t i = 0; i < serial_islands.size(); i++) {
+    rb_batch_add_island(
+        data, m_islands[serial_islands[i]], m_island_bodies, m_island_manifolds, m_island_constraints);
+    if (rb_batch_is_full(data, solverInfo)) {
+      solveBatch(data, solverInfo);
+    }
+  }
+  solveBatch(data, solverInfo);
+}
@@ -0,0 +1,124 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 Blender Foundation
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup RigidBody
+ * \brief Threaded dynamics world for Bullet
+ */
+
+#ifndef __RB_THREADED_WORLD_H__
+#define __RB_THREADED_WORLD_H__
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "btBulletDynamicsCommon.h"
+
+/* Fork-join pool of persistent worker threads. The calling thread takes part in the work as
+ * thread 0, so a pool of one thread runs everything inline. */
+class rbThreadPool {
+ public:
+  explicit rbThreadPool(int num_threads);
+  ~rbThreadPool();
+
+  int num_threads() const
+  {
+    return (int)m_threads.size() + 1;
+  }
+
+  /* Run func(thread_index) once on every thread and wait for all of them to finish. */
+  void run(const std::function<void(int)> &func);
+
+ private:
+  void worker(int thread_index);
+
+  std::vector<std::thread> m_threads;
+  std::mutex m_mutex;
+  std::condition_variable m_start_cond;
+  std::condition_variable m_done_cond;
+  const std::function<void(int)> *m_func;
+  unsigned int m_generation;
+  int m_num_running;
+  bool m_stop;
+};
+
+struct rbSolverThreadData;
+
+/* Simulation island, as a range in the arrays gathered by the threaded world. */
+struct rbIsland {
+  int island_id;
+  int body_start, num_bodies;
+  int manifold_start, num_manifolds;
+  int constraint_start, num_constraints;
+  /* Kinematic bodies are shared between islands, and the solver writes to them. */
+  bool touches_kinematic;
+};
+
+/* Discrete dynamics world which integrates bodies and solves simulation islands on multiple
+ * threads. Bullet 2.84 has no multithreaded world of its own, collision detection stays
+ * single threaded since the narrowphase algorithms share solver state.
+ *
+ * In deterministic mode islands are grouped into solver batches in island order, the same way
+ * the single threaded world does it, so results do not depend on the number of threads.
+ * Otherwise each thread batches the islands it picks up, which balances load better. */
+class rbThreadedDynamicsWorld : public btDiscreteDynamicsWorld {
+ public:
+  rbThreadedDynamicsWorld(btDispatcher *dispatcher,
+                          btBroadphaseInterface *pairCache,
+                          btConstraintSolver *constraintSolver,
+                          btCollisionConfiguration *collisionConfiguration);
+  virtual ~rbThreadedDynamicsWorld();
+
+  void setThreading(int num_threads, bool deterministic);
+
+  void addIsland(btCollisionObject **bodies,
+                 int numBodies,
+                 btPersistentManifold **manifolds,
+                 int numManifolds,
+                 int islandId);
+
+ protected:
+  virtual void predictUnconstraintMotion(btScalar timeStep);
+  virtual void integrateTransforms(btScalar timeStep);
+  virtual void solveConstraints(btContactSolverInfo &solverInfo);
+
+ private:
+  bool useThreadedSolver() const;
+  bool useThreadedIntegration() const;
+  void parallelFor(int num_items, int grain_size, const std::function<void(int, int)> &func);
+  void assignConstraintsToIslands();
+  void solveBatch(rbSolverThreadData &data, btContactSolverInfo &solverInfo);
+  void solveIslandsOrdered(const std::vector<int> &islands, btContactSolverInfo &solverInfo);
+  void solveIslandsDynamic(const std::vector<int> &islands, btContactSolverInfo &solverInfo);
+
+  rbThreadPool *m_pool;
+  std::vector<rbSolverThreadData *> m_thread_data;
+  bool m_deterministic;
+
+  /* Islands gathered for the current step. */
+  btAlignedObjectArray<btCollisionObject *> m_island_bodies;
+  btAlignedObjectArray<btPersistentManifold *> m_island_manifolds;
+  btAlignedObjectArray<btTypedConstraint *> m_island_constraints;
+  std::vector<rbIsland> m_islands;
+};
+
+#endif /* __RB_THREADED_WORLD_H__ */
@@ -185,6 +185,9 @@ class DATA_PT_modifiers(ModifierButtonsPanel, Panel):
         if md.use_custom_profile:
             layout.template_curveprofile(md, "custom_profile")
 
+        layout.separator()
+        layout.prop(md, "use_cache_result")
+
     def BOOLEAN(self, layout, _ob, md):
         split = layout.split()
 
@@ -201,6 +204,9 @@ class DATA_PT_modifiers(ModifierButtonsPanel, Panel):
         if bpy.app.debug:
             layout.prop(md, "debug_options")
 
+        layout.separator()
+        layout.prop(md, "use_cache_result")
+
     def BUILD(self, layout, _ob, md):
         split = layout.split()
 
@@ -1263,6 +1269,9 @@ class DATA_PT_modifiers(ModifierButtonsPanel, Panel):
         row.active = md.use_remove_disconnected
         row.prop(md, "threshold")
 
+        layout.separator()
+        layout.prop(md, "use_cache_result")
+
     @staticmethod
     def vertex_weight_mask(layout, ob, md):
         layout.label(text="Influence/Mask Options:")
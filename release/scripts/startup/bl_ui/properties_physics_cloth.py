@@ -243,6 +243,29 @@ class PHYSICS_PT_cloth_pressure(PhysicButtonsPanel, Panel):
         col.prop_search(cloth, "vertex_group_pressure", ob, "vertex_groups", text="Vertex Group")
 
 
+class PHYSICS_PT_cloth_solver(PhysicButtonsPanel, Panel):
+    bl_label = "Solver"
+    bl_parent_id = 'PHYSICS_PT_cloth'
+    bl_options = {'DEFAULT_CLOSED'}
+    COMPAT_ENGINES = {'BLENDER_RENDER', 'BLENDER_EEVEE', 'BLENDER_WORKBENCH'}
+
+    def draw(self, context):
+        layout = self.layout
+        layout.use_property_split = True
+
+        md = context.cloth
+        cloth = md.settings
+
+        layout.active = cloth_panel_enabled(md)
+
+        col = layout.column()
+        col.prop(cloth, "linear_solver")
+
+        sub = col.column()
+        sub.active = cloth.linear_solver == 'BLOCK_CSR'
+        sub.prop(cloth, "preconditioner")
+
+
 class PHYSICS_PT_cloth_cache(PhysicButtonsPanel, Panel):
     bl_label = "Cache"
     bl_parent_id = 'PHYSICS_PT_cloth'
@@ -389,6 +412,9 @@ class PHYSICS_PT_cloth_self_collision(PhysicButtonsPanel, Panel):
         col = flow.column()
         col.prop(cloth, "self_impulse_clamp")
 
+        col = flow.column()
+        col.prop(cloth, "use_self_collision_continuous")
+
         col = flow.column()
         col.prop_search(cloth, "vertex_group_self_collisions", ob, "vertex_groups", text="Vertex Group")
 
@@ -466,6 +492,7 @@ classes = (
     PHYSICS_PT_cloth_damping,
     PHYSICS_PT_cloth_internal_springs,
     PHYSICS_PT_cloth_pressure,
+    PHYSICS_PT_cloth_solver,
     PHYSICS_PT_cloth_cache,
     PHYSICS_PT_cloth_shape,
     PHYSICS_PT_cloth_collision,
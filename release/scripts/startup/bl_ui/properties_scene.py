@@ -399,6 +399,12 @@ class SCENE_PT_rigid_body_world_settings(RigidBodySubPanel, Panel):
             col.prop(rbw, "steps_per_second", text="Steps Per Second")
             col.prop(rbw, "solver_iterations", text="Solver Iterations")
 
+            col = col.column()
+            col.prop(rbw, "threading_mode")
+            sub = col.column()
+            sub.active = rbw.threading_mode != 'SINGLE'
+            sub.prop(rbw, "threads")
+
 
 class SCENE_PT_rigid_body_cache(RigidBodySubPanel, Panel):
     bl_label = "Cache"
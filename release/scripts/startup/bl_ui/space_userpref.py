@@ -601,6 +601,7 @@ class USERPREF_PT_system_memory(SystemPanel, CenterAlignMixIn, Panel):
         flow = layout.grid_flow(row_major=False, columns=0, even_columns=True, even_rows=False, align=False)
 
         flow.prop(system, "memory_cache_limit", text="Sequencer Cache Limit")
+        flow.prop(system, "modifier_cache_limit", text="Modifier Cache Limit")
         flow.prop(system, "scrollback", text="Console Scrollback Lines")
 
         layout.separator()
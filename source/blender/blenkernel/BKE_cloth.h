@@ -67,6 +67,9 @@ typedef struct ClothSolverResult {
   int max_iterations, min_iterations;
   float avg_iterations;
   float max_error, min_error, avg_error;
+
+  /* Collision detection and response time per substep, in seconds. */
+  float max_collision_time, avg_collision_time;
 } ClothSolverResult;
 
 /**
@@ -228,10 +231,26 @@ typedef enum {
   CLOTH_BENDING_ANGULAR = 1,
 } CLOTH_BENDING_MODEL;
 
+/* ClothSimSettings.linear_solver. */
+typedef enum {
+  /** Single threaded conjugate gradient on the sparse block list. */
+  CLOTH_LINEAR_SOLVER_CG = 0,
+  /** Multi-threaded preconditioned conjugate gradient on a block CSR matrix. */
+  CLOTH_LINEAR_SOLVER_BLOCK_CSR = 1,
+} CLOTH_LINEAR_SOLVER;
+
+/* ClothSimSettings.preconditioner. */
+typedef enum {
+  CLOTH_PRECONDITIONER_NONE = 0,
+  CLOTH_PRECONDITIONER_JACOBI = 1,
+  CLOTH_PRECONDITIONER_BLOCK_JACOBI = 2,
+} CLOTH_PRECONDITIONER;
+
 /* COLLISION FLAGS */
 typedef enum {
-  CLOTH_COLLSETTINGS_FLAG_ENABLED = (1 << 1), /* enables cloth - object collisions */
-  CLOTH_COLLSETTINGS_FLAG_SELF = (1 << 2),    /* enables selfcollisions */
+  CLOTH_COLLSETTINGS_FLAG_ENABLED = (1 << 1),         /* enables cloth - object collisions */
+  CLOTH_COLLSETTINGS_FLAG_SELF = (1 << 2),            /* enables selfcollisions */
+  CLOTH_COLLSETTINGS_FLAG_SELF_CONTINUOUS = (1 << 3), /* swept bounds for selfcollisions */
 } CLOTH_COLLISIONSETTINGS_FLAGS;
 
 /* Spring types as defined in the paper.*/
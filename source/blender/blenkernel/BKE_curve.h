@@ -48,6 +48,8 @@ typedef struct CurveCache {
   ListBase bev;
   ListBase deformed_nurbs;
   struct Path *path;
+  /** Time the last metaball tessellation took (in seconds), metaball objects only. */
+  double mball_tessellate_time;
 } CurveCache;
 
 /* Definitions needed for shape keys */
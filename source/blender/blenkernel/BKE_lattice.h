@@ -30,9 +30,11 @@
 extern "C" {
 #endif
 
+struct ArmatureDeformVertsData;
 struct BPoint;
 struct Depsgraph;
 struct Lattice;
+struct LatticeDeformVertsData;
 struct MDeformVert;
 struct Main;
 struct Mesh;
@@ -87,6 +89,31 @@ void armature_deform_verts(struct Object *armOb,
                            const char *defgrp_name,
                            struct bGPDstroke *gps);
 
+/* Deformation split in preparation and evaluation of vertex ranges,
+ * for evaluating chains of deform modifiers block by block. */
+struct LatticeDeformVertsData *lattice_deform_verts_prepare(struct Object *laOb,
+                                                           struct Object *target,
+                                                           struct Mesh *mesh,
+                                                           short flag,
+                                                           const char *vgroup,
+                                                           float influence);
+void lattice_deform_verts_range(const struct LatticeDeformVertsData *data,
+                                float (*vert_coords)[3],
+                                int start,
+                                int end);
+void lattice_deform_verts_free(struct LatticeDeformVertsData *data);
+
+struct ArmatureDeformVertsData *armature_deform_verts_prepare(struct Object *armOb,
+                                                             struct Object *target,
+                                                             const struct Mesh *mesh,
+                                                             int deformflag,
+                                                             const char *defgrp_name);
+void armature_deform_verts_range(const struct ArmatureDeformVertsData *data,
+                                 float (*vert_coords)[3],
+                                 int start,
+                                 int end);
+void armature_deform_verts_free(struct ArmatureDeformVertsData *data);
+
 float (*BKE_lattice_vert_coords_alloc(const struct Lattice *lt, int *r_vert_len))[3];
 void BKE_lattice_vert_coords_get(const struct Lattice *lt, float (*vert_coords)[3]);
 void BKE_lattice_vert_coords_apply_with_mat4(struct Lattice *lt,
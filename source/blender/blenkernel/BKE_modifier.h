@@ -141,6 +141,16 @@ typedef struct ModifierEvalContext {
   ModifierApplyFlag flag;
 } ModifierEvalContext;
 
+/* Deformation of a range of vertices, prepared by deformVertsBlockPrepare. */
+typedef struct ModifierDeformBlock {
+  /* Deform vertices from start to end (exclusive), called from multiple threads at once for
+   * different ranges. Must only read and write the coordinates within its own range. */
+  void (*deform)(void *userdata, float (*vertexCos)[3], int start, int end);
+  /* Free userdata, optional. */
+  void (*free)(void *userdata);
+  void *userdata;
+} ModifierDeformBlock;
+
 typedef struct ModifierTypeInfo {
   /* The user visible name for this modifier */
   char name[32];
@@ -204,6 +214,21 @@ typedef struct ModifierTypeInfo {
                            float (*defMats)[3][3],
                            int numVerts);
 
+  /* Prepare deformVerts to be evaluated in blocks of vertices, so a chain of deform
+   * modifiers can be applied block by block while the coordinates stay in cache.
+   *
+   * Everything which does not depend on the vertex coordinates is computed here. Return
+   * false when the deformation needs all coordinates at once (to compute bounds for
+   * example), deformVerts is used then.
+   *
+   * This function is optional.
+   */
+  bool (*deformVertsBlockPrepare)(struct ModifierData *md,
+                                  const struct ModifierEvalContext *ctx,
+                                  struct Mesh *mesh,
+                                  int numVerts,
+                                  struct ModifierDeformBlock *r_block);
+
   /********************* Non-deform modifier functions *********************/
 
   /* For non-deform types: apply the modifier and return a mesh object.
@@ -465,6 +490,51 @@ void modwrap_deformVertsEM(ModifierData *md,
 struct Mesh *BKE_modifier_get_evaluated_mesh_from_evaluated_object(struct Object *ob_eval,
                                                                    const bool get_cage_mesh);
 
+/* Consecutive deform modifiers evaluated together in blocks of vertices. */
+typedef struct ModifierDeformChain {
+  struct ModifierDeformChainItem *items;
+  int items_len, items_alloc;
+} ModifierDeformChain;
+
+bool modifier_deform_chain_add(ModifierDeformChain *chain,
+                               struct ModifierData *md,
+                               struct Mesh *mesh);
+void modifier_deform_chain_flush(ModifierDeformChain *chain,
+                                 const struct ModifierEvalContext *mectx,
+                                 float (*vertexCos)[3],
+                                 int numVerts);
+void modifier_deform_chain_free(ModifierDeformChain *chain);
+
+/* modifier_cache.c */
+
+/* Key of the modifier stack evaluated up to some modifier, built from the input mesh and the
+ * settings of every modifier up to that point. */
+typedef struct ModifierStackKey {
+  unsigned int hash[2];
+  /* False when the result can not be cached, for example because a modifier depends on time. */
+  bool is_valid;
+} ModifierStackKey;
+
+void BKE_modifier_stack_key_init(ModifierStackKey *key,
+                                 struct Object *ob,
+                                 const struct Mesh *mesh,
+                                 const float (*vert_coords)[3]);
+void BKE_modifier_stack_key_add(ModifierStackKey *key,
+                                struct Object *ob,
+                                struct ModifierData *md,
+                                const struct CustomData_MeshMasks *mask);
+
+struct Mesh *BKE_modifier_stack_cache_lookup(struct Object *ob,
+                                             struct ModifierData *md,
+                                             const ModifierStackKey *key);
+void BKE_modifier_stack_cache_store(struct Object *ob,
+                                    struct ModifierData *md,
+                                    const ModifierStackKey *key,
+                                    struct Mesh *mesh);
+void BKE_modifier_stack_cache_free_unused(struct Object *ob);
+void BKE_modifier_stack_cache_free(struct Object *ob);
+size_t BKE_modifier_stack_cache_memory_in_use(void);
+
 #ifdef __cplusplus
 }
 #endif
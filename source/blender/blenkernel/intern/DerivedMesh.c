@@ -860,6 +860,102 @@ static void mesh_calc_finalize(const Mesh *mesh_input, Mesh *mesh_eval)
   mesh_eval->edit_mesh = mesh_input->edit_mesh;
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Cached Modifier Results
+ *
+ * Modifiers with #eModifierFlag_CacheResult keep a copy of their result, evaluation continues
+ * from the last cached result whose key matches the current stack, see modifier_cache.c.
+ * \{ */
+
+/* Number of modifiers starting at md when any of them caches its result, zero otherwise. */
+static int mesh_stack_cache_len(Scene *scene,
+                                ModifierData *md,
+                                CDMaskLink *md_datamask,
+                                const CustomData_MeshMasks *final_datamask,
+                                const int required_mode)
+{
+  const CustomData_MeshMasks *masks[2] = {final_datamask, NULL};
+  bool use_cache = false;
+  int len = 0;
+
+  for (; md; md = md->next, md_datamask = md_datamask->next, len++) {
+    masks[1] = &md_datamask->mask;
+    /* Generated coordinates are evaluated along with the stack and are not cached. */
+    for (int i = 0; i < ARRAY_SIZE(masks); i++) {
+      if (masks[i]->vmask & (CD_MASK_ORCO | CD_MASK_CLOTH_ORCO)) {
+        return 0;
+      }
+    }
+    if ((md->flag & eModifierFlag_CacheResult) && modifier_isEnabled(scene, md, required_mode)) {
+      use_cache = true;
+    }
+  }
+
+  return use_cache ? len : 0;
+}
+
+/**
+ * Compute keys of the stack up to every modifier starting at md, stored in r_keys by position.
+ * The loop mirrors the one in #mesh_calc_modifiers.
+ *
+ * \return The last modifier with a cached result matching its key.
+ */
+static ModifierData *mesh_stack_cache_find(Scene *scene,
+                                           Object *ob,
+                                           ModifierData *md,
+                                           CDMaskLink *md_datamask,
+                                           const int required_mode,
+                                           const int useDeform,
+                                           const Mesh *mesh_input,
+                                           const float (*deformed_verts)[3],
+                                           ModifierStackKey *r_keys,
+                                           Mesh **r_mesh)
+{
+  ModifierData *md_cached = NULL;
+  bool have_non_onlydeform_modifiers_appled = false;
+  ModifierStackKey key;
+
+  *r_mesh = NULL;
+  BKE_modifier_stack_key_init(&key, ob, mesh_input, deformed_verts);
+
+  for (int i = 0; md && key.is_valid; md = md->next, md_datamask = md_datamask->next, i++) {
+    const ModifierTypeInfo *mti = modifierType_getInfo(md->type);
+
+    if (!modifier_isEnabled(scene, md, required_mode)) {
+      continue;
+    }
+    if (mti->type == eModifierTypeType_OnlyDeform && !useDeform) {
+      continue;
+    }
+    if ((mti->flags & eModifierTypeFlag_RequiresOriginalData) &&
+        have_non_onlydeform_modifiers_appled) {
+      continue;
+    }
+    if (useDeform < 0 && mti->dependsOnTime && mti->dependsOnTime(md)) {
+      continue;
+    }
+
+    BKE_modifier_stack_key_add(&key, ob, md, &md_datamask->mask);
+    r_keys[i] = key;
+
+    if (mti->type != eModifierTypeType_OnlyDeform) {
+      have_non_onlydeform_modifiers_appled = true;
+
+      if (md->flag & eModifierFlag_CacheResult) {
+        Mesh *mesh_cached = BKE_modifier_stack_cache_lookup(ob, md, &key);
+        if (mesh_cached) {
+          md_cached = md;
+          *r_mesh = mesh_cached;
+        }
+      }
+    }
+  }
+
+  return md_cached;
+}
+
+/** \} */
+
 static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
                                 Scene *scene,
                                 Object *ob,
@@ -889,6 +985,9 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
   int num_deformed_verts = mesh_input->totvert;
   bool isPrevDeform = false;
 
+  /* Consecutive deform modifiers waiting to be applied to deformed_verts in one pass. */
+  ModifierDeformChain deform_chain = {NULL};
+
   /* Mesh with constructive modifiers but no deformation applied. Tracked
    * along with final mesh if undeformed / orco coordinates are requested
    * for texturing. */
@@ -964,6 +1063,7 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
           deformed_verts = BKE_mesh_vert_coords_alloc(mesh_input, &num_deformed_verts);
         }
         else if (isPrevDeform && mti->dependsOnNormals && mti->dependsOnNormals(md)) {
+          modifier_deform_chain_flush(&deform_chain, &mectx, deformed_verts, num_deformed_verts);
           if (mesh_final == NULL) {
             mesh_final = BKE_mesh_copy_for_eval(mesh_input, true);
             ASSERT_IS_VALID_MESH(mesh_final);
@@ -971,7 +1071,10 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
           BKE_mesh_vert_coords_apply(mesh_final, deformed_verts);
         }
 
-        modwrap_deformVerts(md, &mectx, mesh_final, deformed_verts, num_deformed_verts);
+        if (!modifier_deform_chain_add(&deform_chain, md, mesh_final)) {
+          modifier_deform_chain_flush(&deform_chain, &mectx, deformed_verts, num_deformed_verts);
+          modwrap_deformVerts(md, &mectx, mesh_final, deformed_verts, num_deformed_verts);
+        }
 
         isPrevDeform = true;
       }
@@ -985,6 +1088,8 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
       }
     }
 
+    modifier_deform_chain_flush(&deform_chain, &mectx, deformed_verts, num_deformed_verts);
+
     /* Result of all leading deforming modifiers is cached for
      * places that wish to use the original mesh but with deformed
      * coordinates (like vertex paint). */
@@ -997,9 +1102,51 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
     }
   }
 
-  /* Apply all remaining constructive and deforming modifiers. */
   bool have_non_onlydeform_modifiers_appled = false;
-  for (; md; md = md->next, md_datamask = md_datamask->next) {
+
+  /* Continue from the last cached result of the stack when it is still valid. Caching is skipped
+   * in modes which need mapping or evaluate the stack partially. */
+  ModifierStackKey *stack_keys = NULL;
+  int stack_index = 0;
+  const bool use_stack_cache = (use_cache && !need_mapping && !sculpt_mode && index == -1 &&
+                                previewmd == NULL);
+  if (use_stack_cache) {
+    const int stack_len = mesh_stack_cache_len(
+        scene, md, md_datamask, &final_datamask, required_mode);
+    if (stack_len) {
+      stack_keys = MEM_calloc_arrayN(stack_len, sizeof(*stack_keys), __func__);
+
+      Mesh *mesh_cached;
+      ModifierData *md_cached = mesh_stack_cache_find(scene,
+                                                      ob,
+                                                      md,
+                                                      md_datamask,
+                                                      required_mode,
+                                                      useDeform,
+                                                      mesh_input,
+                                                      (const float(*)[3])deformed_verts,
+                                                      stack_keys,
+                                                      &mesh_cached);
+      if (md_cached) {
+        while (md != md_cached->next) {
+          md = md->next;
+          md_datamask = md_datamask->next;
+          stack_index++;
+        }
+
+        if (mesh_final) {
+          BKE_id_free(NULL, mesh_final);
+        }
+        mesh_final = BKE_mesh_copy_for_eval(mesh_cached, false);
+        MEM_SAFE_FREE(deformed_verts);
+        have_non_onlydeform_modifiers_appled = true;
+        isPrevDeform = false;
+      }
+    }
+  }
+
+  /* Apply all remaining constructive and deforming modifiers. */
+  for (; md; md = md->next, md_datamask = md_datamask->next, stack_index++) {
     const ModifierTypeInfo *mti = modifierType_getInfo(md->type);
 
     if (!modifier_isEnabled(scene, md, required_mode)) {
@@ -1087,15 +1234,20 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
       /* if this is not the last modifier in the stack then recalculate the normals
        * to avoid giving bogus normals to the next modifier see: [#23673] */
       else if (isPrevDeform && mti->dependsOnNormals && mti->dependsOnNormals(md)) {
+        modifier_deform_chain_flush(&deform_chain, &mectx, deformed_verts, num_deformed_verts);
         if (mesh_final == NULL) {
           mesh_final = BKE_mesh_copy_for_eval(mesh_input, true);
           ASSERT_IS_VALID_MESH(mesh_final);
         }
         BKE_mesh_vert_coords_apply(mesh_final, deformed_verts);
       }
-      modwrap_deformVerts(md, &mectx, mesh_final, deformed_verts, num_deformed_verts);
+      if (!modifier_deform_chain_add(&deform_chain, md, mesh_final)) {
+        modifier_deform_chain_flush(&deform_chain, &mectx, deformed_verts, num_deformed_verts);
+        modwrap_deformVerts(md, &mectx, mesh_final, deformed_verts, num_deformed_verts);
+      }
     }
     else {
+      modifier_deform_chain_flush(&deform_chain, &mectx, deformed_verts, num_deformed_verts);
       have_non_onlydeform_modifiers_appled = true;
 
       /* determine which data layers are needed by following modifiers */
@@ -1258,6 +1410,10 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
       }
 
       mesh_final->runtime.deformed_only = false;
+
+      if (stack_keys && (md->flag & eModifierFlag_CacheResult)) {
+        BKE_modifier_stack_cache_store(ob, md, &stack_keys[stack_index], mesh_final);
+      }
     }
 
     isPrevDeform = (mti->type == eModifierTypeType_OnlyDeform);
@@ -1272,6 +1428,14 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
     }
   }
 
+  modifier_deform_chain_flush(&deform_chain, &mectx, deformed_verts, num_deformed_verts);
+  modifier_deform_chain_free(&deform_chain);
+
+  if (use_stack_cache) {
+    BKE_modifier_stack_cache_free_unused(ob);
+  }
+  MEM_SAFE_FREE(stack_keys);
+
   BLI_linklist_free((LinkNode *)datamasks, NULL);
 
   for (md = firstmd; md; md = md->next) {
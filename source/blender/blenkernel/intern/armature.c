@@ -1475,7 +1475,7 @@ static void pchan_bone_deform(bPoseChannel *pchan,
   (*contrib) += weight;
 }
 
-typedef struct ArmatureUserdata {
+typedef struct ArmatureDeformVertsData {
   Object *armOb;
   Object *target;
   const Mesh *mesh;
@@ -1498,13 +1498,13 @@ typedef struct ArmatureUserdata {
 
   float premat[4][4];
   float postmat[4][4];
-} ArmatureUserdata;
+} ArmatureDeformVertsData;
 
 static void armature_vert_task(void *__restrict userdata,
                                const int i,
                                const TaskParallelTLS *__restrict UNUSED(tls))
 {
-  const ArmatureUserdata *data = userdata;
+  const ArmatureDeformVertsData *data = userdata;
   float(*const vertexCos)[3] = data->vertexCos;
   float(*const defMats)[3][3] = data->defMats;
   float(*const prevCos)[3] = data->prevCos;
@@ -1671,16 +1671,14 @@ static void armature_vert_task(void *__restrict userdata,
   }
 }
 
-void armature_deform_verts(Object *armOb,
-                           Object *target,
-                           const Mesh *mesh,
-                           float (*vertexCos)[3],
-                           float (*defMats)[3][3],
-                           int numVerts,
-                           int deformflag,
-                           float (*prevCos)[3],
-                           const char *defgrp_name,
-                           bGPDstroke *gps)
+/* Fill in everything but the coordinate arrays, returns false if there is nothing to deform. */
+static bool armature_deform_data_init(ArmatureDeformVertsData *data,
+                                      Object *armOb,
+                                      Object *target,
+                                      const Mesh *mesh,
+                                      int deformflag,
+                                      const char *defgrp_name,
+                                      bGPDstroke *gps)
 {
   bArmature *arm = armOb->data;
   bPoseChannel **defnrToPC = NULL;
@@ -1696,7 +1694,7 @@ void armature_deform_verts(Object *armOb,
 
   /* in editmode, or not an armature */
   if (arm->edbo || (armOb->pose == NULL)) {
-    return;
+    return false;
   }
 
   if ((armOb->pose->flag & POSE_RECALC) != 0) {
@@ -1764,35 +1762,96 @@ void armature_deform_verts(Object *armOb,
     }
   }
 
-  ArmatureUserdata data = {.armOb = armOb,
-                           .target = target,
-                           .mesh = mesh,
-                           .vertexCos = vertexCos,
-                           .defMats = defMats,
-                           .prevCos = prevCos,
-                           .use_envelope = use_envelope,
-                           .use_quaternion = use_quaternion,
-                           .invert_vgroup = invert_vgroup,
-                           .use_dverts = use_dverts,
-                           .armature_def_nr = armature_def_nr,
-                           .target_totvert = target_totvert,
-                           .dverts = dverts,
-                           .defbase_tot = defbase_tot,
-                           .defnrToPC = defnrToPC};
+  *data = (ArmatureDeformVertsData){
+      .armOb = armOb,
+      .target = target,
+      .mesh = mesh,
+      .use_envelope = use_envelope,
+      .use_quaternion = use_quaternion,
+      .invert_vgroup = invert_vgroup,
+      .use_dverts = use_dverts,
+      .armature_def_nr = armature_def_nr,
+      .target_totvert = target_totvert,
+      .dverts = dverts,
+      .defbase_tot = defbase_tot,
+      .defnrToPC = defnrToPC,
+  };
 
   float obinv[4][4];
   invert_m4_m4(obinv, target->obmat);
 
-  mul_m4_m4m4(data.postmat, obinv, armOb->obmat);
-  invert_m4_m4(data.premat, data.postmat);
+  mul_m4_m4m4(data->postmat, obinv, armOb->obmat);
+  invert_m4_m4(data->premat, data->postmat);
+
+  return true;
+}
+
+void armature_deform_verts(Object *armOb,
+                           Object *target,
+                           const Mesh *mesh,
+                           float (*vertexCos)[3],
+                           float (*defMats)[3][3],
+                           int numVerts,
+                           int deformflag,
+                           float (*prevCos)[3],
+                           const char *defgrp_name,
+                           bGPDstroke *gps)
+{
+  ArmatureDeformVertsData data;
+
+  if (!armature_deform_data_init(&data, armOb, target, mesh, deformflag, defgrp_name, gps)) {
+    return;
+  }
+
+  data.vertexCos = vertexCos;
+  data.defMats = defMats;
+  data.prevCos = prevCos;
 
   TaskParallelSettings settings;
   BLI_parallel_range_settings_defaults(&settings);
   settings.min_iter_per_thread = 32;
   BLI_task_parallel_range(0, numVerts, &data, armature_vert_task, &settings);
 
-  if (defnrToPC) {
-    MEM_freeN(defnrToPC);
+  if (data.defnrToPC) {
+    MEM_freeN(data.defnrToPC);
+  }
+}
+
+/**
+ * Split version of #armature_deform_verts, for deforming vertices in blocks.
+ * Returns NULL when the armature does not deform anything.
+ */
+ArmatureDeformVertsData *armature_deform_verts_prepare(
+    Object *armOb, Object *target, const Mesh *mesh, int deformflag, const char *defgrp_name)
+{
+  ArmatureDeformVertsData *data = MEM_mallocN(sizeof(*data), __func__);
+
+  if (!armature_deform_data_init(data, armOb, target, mesh, deformflag, defgrp_name, NULL)) {
+    MEM_freeN(data);
+    return NULL;
+  }
+
+  return data;
+}
+
+void armature_deform_verts_range(const ArmatureDeformVertsData *data,
+                                 float (*vertexCos)[3],
+                                 int start,
+                                 int end)
+{
+  ArmatureDeformVertsData range_data = *data;
+  range_data.vertexCos = vertexCos;
+
+  for (int i = start; i < end; i++) {
+    armature_vert_task(&range_data, i, NULL);
+  }
+}
+
+void armature_deform_verts_free(ArmatureDeformVertsData *data)
+{
+  if (data) {
+    MEM_SAFE_FREE(data->defnrToPC);
+    MEM_freeN(data);
   }
 }
 
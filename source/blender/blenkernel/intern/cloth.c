@@ -160,6 +160,9 @@ void cloth_init(ClothModifierData *clmd)
 
   clmd->sim_parms->bending_model = CLOTH_BENDING_ANGULAR;
 
+  clmd->sim_parms->linear_solver = CLOTH_LINEAR_SOLVER_CG;
+  clmd->sim_parms->preconditioner = CLOTH_PRECONDITIONER_BLOCK_JACOBI;
+
   if (!clmd->sim_parms->effector_weights) {
     clmd->sim_parms->effector_weights = BKE_effector_add_weights(NULL);
   }
@@ -414,6 +417,24 @@ static int do_step_cloth(
   return ret;
 }
 
+/* Copy the solver statistics to the original modifier. The cache info is only updated when it
+ * is displayed, from the original object, see #PTCACHE_FLAG_INFO_DIRTY. */
+static void cloth_solver_result_to_original(Depsgraph *depsgraph, ClothModifierData *clmd)
+{
+  ClothModifierData *clmd_orig = (ClothModifierData *)modifier_get_original(&clmd->modifier);
+
+  if (clmd_orig == clmd || clmd->solver_result == NULL || !DEG_is_active(depsgraph)) {
+    return;
+  }
+
+  if (clmd_orig->solver_result == NULL) {
+    clmd_orig->solver_result = MEM_dupallocN(clmd->solver_result);
+  }
+  else {
+    *clmd_orig->solver_result = *clmd->solver_result;
+  }
+}
+
 /************************************************
  * clothModifier_do - main simulation function
  ************************************************/
@@ -518,6 +539,7 @@ void clothModifier_do(ClothModifierData *clmd,
   }
   else {
     BKE_ptcache_write(&pid, framenr);
+    cloth_solver_result_to_original(depsgraph, clmd);
   }
 
   cloth_to_object(ob, clmd, vertexCos);
@@ -35,6 +35,7 @@
 #include "BLI_blenlib.h"
 #include "BLI_linklist.h"
 #include "BLI_math.h"
+#include "BLI_math_bits.h"
 #include "BLI_task.h"
 #include "BLI_threads.h"
 #include "BLI_ghash.h"
@@ -74,6 +75,23 @@ typedef struct SelfColDetectData {
   bool collided;
 } SelfColDetectData;
 
+typedef struct SelfColResponseData {
+  ClothModifierData *clmd;
+  CollPair *collisions;
+  const int *pair_index;
+  float dt;
+  bool result;
+} SelfColResponseData;
+
+typedef struct ImpulseApplyData {
+  ClothVertex *verts;
+  int applied;
+} ImpulseApplyData;
+
+/* Self collision pairs are split into this many independent sets (colors) for parallel
+ * impulse resolution, remaining pairs are resolved serially. */
+#define SELFCOL_MAX_COLORS 32
+
 /***********************************
  * Collision modifier code start
  ***********************************/
@@ -903,106 +921,127 @@ static void cloth_selfcollision_impulse_vert(const float clamp_sq,
   vert->impulse_count++;
 }
 
-static int cloth_selfcollision_response_static(ClothModifierData *clmd,
-                                               CollPair *collpair,
-                                               uint collision_count,
-                                               const float dt)
+/* Compute the impulses of a single self collision pair and merge them into its vertices.
+ * Only the vertices of this pair are written, so pairs without shared vertices can be
+ * processed in parallel. */
+static bool cloth_selfcollision_response_pair(ClothModifierData *clmd,
+                                              CollPair *collpair,
+                                              const float dt)
 {
-  int result = 0;
-  Cloth *cloth1;
+  Cloth *cloth1 = clmd->clothObject;
   float w1, w2, w3, u1, u2, u3;
   float v1[3], v2[3], relativeVelocity[3];
   float magrelVel;
+  float ia[3][3] = {{0.0f}};
+  float ib[3][3] = {{0.0f}};
+  bool result = false;
 
-  cloth1 = clmd->clothObject;
+  /* Only handle static collisions here. */
+  if (collpair->flag & (COLLISION_IN_FUTURE | COLLISION_INACTIVE)) {
+    return false;
+  }
 
-  for (int i = 0; i < collision_count; i++, collpair++) {
-    float ia[3][3] = {{0.0f}};
-    float ib[3][3] = {{0.0f}};
+  /* Compute barycentric coordinates for both collision points. */
+  collision_compute_barycentric(collpair->pa,
+                                cloth1->verts[collpair->ap1].tx,
+                                cloth1->verts[collpair->ap2].tx,
+                                cloth1->verts[collpair->ap3].tx,
+                                &w1,
+                                &w2,
+                                &w3);
 
-    /* Only handle static collisions here. */
-    if (collpair->flag & (COLLISION_IN_FUTURE | COLLISION_INACTIVE)) {
-      continue;
-    }
+  collision_compute_barycentric(collpair->pb,
+                                cloth1->verts[collpair->bp1].tx,
+                                cloth1->verts[collpair->bp2].tx,
+                                cloth1->verts[collpair->bp3].tx,
+                                &u1,
+                                &u2,
+                                &u3);
 
-    /* Compute barycentric coordinates for both collision points. */
-    collision_compute_barycentric(collpair->pa,
-                                  cloth1->verts[collpair->ap1].tx,
-                                  cloth1->verts[collpair->ap2].tx,
-                                  cloth1->verts[collpair->ap3].tx,
-                                  &w1,
-                                  &w2,
-                                  &w3);
+  /* Calculate relative "velocity". */
+  collision_interpolateOnTriangle(v1,
+                                  cloth1->verts[collpair->ap1].tv,
+                                  cloth1->verts[collpair->ap2].tv,
+                                  cloth1->verts[collpair->ap3].tv,
+                                  w1,
+                                  w2,
+                                  w3);
+
+  collision_interpolateOnTriangle(v2,
+                                  cloth1->verts[collpair->bp1].tv,
+                                  cloth1->verts[collpair->bp2].tv,
+                                  cloth1->verts[collpair->bp3].tv,
+                                  u1,
+                                  u2,
+                                  u3);
 
-    collision_compute_barycentric(collpair->pb,
-                                  cloth1->verts[collpair->bp1].tx,
-                                  cloth1->verts[collpair->bp2].tx,
-                                  cloth1->verts[collpair->bp3].tx,
-                                  &u1,
-                                  &u2,
-                                  &u3);
+  sub_v3_v3v3(relativeVelocity, v2, v1);
 
-    /* Calculate relative "velocity". */
-    collision_interpolateOnTriangle(v1,
-                                    cloth1->verts[collpair->ap1].tv,
-                                    cloth1->verts[collpair->ap2].tv,
-                                    cloth1->verts[collpair->ap3].tv,
-                                    w1,
-                                    w2,
-                                    w3);
+  /* Calculate the normal component of the relative velocity
+   * (actually only the magnitude - the direction is stored in 'normal'). */
+  magrelVel = dot_v3v3(relativeVelocity, collpair->normal);
 
-    collision_interpolateOnTriangle(v2,
-                                    cloth1->verts[collpair->bp1].tv,
-                                    cloth1->verts[collpair->bp2].tv,
-                                    cloth1->verts[collpair->bp3].tv,
-                                    u1,
-                                    u2,
-                                    u3);
+  /* TODO: Impulses should be weighed by mass as this is self col,
+   * this has to be done after mass distribution is implemented. */
 
-    sub_v3_v3v3(relativeVelocity, v2, v1);
+  /* If magrelVel < 0 the edges are approaching each other. */
+  if (magrelVel > 0.0f) {
+    /* Calculate Impulse magnitude to stop all motion in normal direction. */
+    float magtangent = 0, repulse = 0, d = 0;
+    double impulse = 0.0;
+    float vrel_t_pre[3];
+    float temp[3], time_multiplier;
 
-    /* Calculate the normal component of the relative velocity
-     * (actually only the magnitude - the direction is stored in 'normal'). */
-    magrelVel = dot_v3v3(relativeVelocity, collpair->normal);
+    /* Calculate tangential velocity. */
+    copy_v3_v3(temp, collpair->normal);
+    mul_v3_fl(temp, magrelVel);
+    sub_v3_v3v3(vrel_t_pre, relativeVelocity, temp);
 
-    /* TODO: Impulses should be weighed by mass as this is self col,
-     * this has to be done after mass distribution is implemented. */
+    /* Decrease in magnitude of relative tangential velocity due to coulomb friction
+     * in original formula "magrelVel" should be the
+     * "change of relative velocity in normal direction". */
+    magtangent = min_ff(clmd->coll_parms->self_friction * 0.01f * magrelVel, len_v3(vrel_t_pre));
 
-    /* If magrelVel < 0 the edges are approaching each other. */
-    if (magrelVel > 0.0f) {
-      /* Calculate Impulse magnitude to stop all motion in normal direction. */
-      float magtangent = 0, repulse = 0, d = 0;
-      double impulse = 0.0;
-      float vrel_t_pre[3];
-      float temp[3], time_multiplier;
+    /* Apply friction impulse. */
+    if (magtangent > ALMOST_ZERO) {
+      normalize_v3(vrel_t_pre);
 
-      /* Calculate tangential velocity. */
-      copy_v3_v3(temp, collpair->normal);
-      mul_v3_fl(temp, magrelVel);
-      sub_v3_v3v3(vrel_t_pre, relativeVelocity, temp);
+      impulse = magtangent / 1.5;
 
-      /* Decrease in magnitude of relative tangential velocity due to coulomb friction
-       * in original formula "magrelVel" should be the
-       * "change of relative velocity in normal direction". */
-      magtangent = min_ff(clmd->coll_parms->self_friction * 0.01f * magrelVel, len_v3(vrel_t_pre));
+      VECADDMUL(ia[0], vrel_t_pre, w1 * impulse);
+      VECADDMUL(ia[1], vrel_t_pre, w2 * impulse);
+      VECADDMUL(ia[2], vrel_t_pre, w3 * impulse);
 
-      /* Apply friction impulse. */
-      if (magtangent > ALMOST_ZERO) {
-        normalize_v3(vrel_t_pre);
+      VECADDMUL(ib[0], vrel_t_pre, -u1 * impulse);
+      VECADDMUL(ib[1], vrel_t_pre, -u2 * impulse);
+      VECADDMUL(ib[2], vrel_t_pre, -u3 * impulse);
+    }
 
-        impulse = magtangent / 1.5;
+    /* Apply velocity stopping impulse. */
+    impulse = magrelVel / 3.0f;
 
-        VECADDMUL(ia[0], vrel_t_pre, w1 * impulse);
-        VECADDMUL(ia[1], vrel_t_pre, w2 * impulse);
-        VECADDMUL(ia[2], vrel_t_pre, w3 * impulse);
+    VECADDMUL(ia[0], collpair->normal, w1 * impulse);
+    VECADDMUL(ia[1], collpair->normal, w2 * impulse);
+    VECADDMUL(ia[2], collpair->normal, w3 * impulse);
 
-        VECADDMUL(ib[0], vrel_t_pre, -u1 * impulse);
-        VECADDMUL(ib[1], vrel_t_pre, -u2 * impulse);
-        VECADDMUL(ib[2], vrel_t_pre, -u3 * impulse);
+    VECADDMUL(ib[0], collpair->normal, -u1 * impulse);
+    VECADDMUL(ib[1], collpair->normal, -u2 * impulse);
+    VECADDMUL(ib[2], collpair->normal, -u3 * impulse);
+
+    time_multiplier = 1.0f / (clmd->sim_parms->dt * clmd->sim_parms->timescale);
+
+    d = clmd->coll_parms->selfepsilon * 8.0f / 9.0f * 2.0f - collpair->distance;
+
+    if ((magrelVel < 0.1f * d * time_multiplier) && (d > ALMOST_ZERO)) {
+      repulse = MIN2(d / time_multiplier, 0.1f * d * time_multiplier - magrelVel);
+
+      if (impulse > ALMOST_ZERO) {
+        repulse = min_ff(repulse, 5.0 * impulse);
       }
 
-      /* Apply velocity stopping impulse. */
-      impulse = magrelVel / 3.0f;
+      repulse = max_ff(impulse, repulse);
+
+      impulse = repulse / 1.5f;
 
       VECADDMUL(ia[0], collpair->normal, w1 * impulse);
       VECADDMUL(ia[1], collpair->normal, w2 * impulse);
@@ -1011,68 +1050,44 @@ static int cloth_selfcollision_response_static(ClothModifierData *clmd,
       VECADDMUL(ib[0], collpair->normal, -u1 * impulse);
       VECADDMUL(ib[1], collpair->normal, -u2 * impulse);
       VECADDMUL(ib[2], collpair->normal, -u3 * impulse);
-
-      time_multiplier = 1.0f / (clmd->sim_parms->dt * clmd->sim_parms->timescale);
-
-      d = clmd->coll_parms->selfepsilon * 8.0f / 9.0f * 2.0f - collpair->distance;
-
-      if ((magrelVel < 0.1f * d * time_multiplier) && (d > ALMOST_ZERO)) {
-        repulse = MIN2(d / time_multiplier, 0.1f * d * time_multiplier - magrelVel);
-
-        if (impulse > ALMOST_ZERO) {
-          repulse = min_ff(repulse, 5.0 * impulse);
-        }
-
-        repulse = max_ff(impulse, repulse);
-
-        impulse = repulse / 1.5f;
-
-        VECADDMUL(ia[0], collpair->normal, w1 * impulse);
-        VECADDMUL(ia[1], collpair->normal, w2 * impulse);
-        VECADDMUL(ia[2], collpair->normal, w3 * impulse);
-
-        VECADDMUL(ib[0], collpair->normal, -u1 * impulse);
-        VECADDMUL(ib[1], collpair->normal, -u2 * impulse);
-        VECADDMUL(ib[2], collpair->normal, -u3 * impulse);
-      }
-
-      result = 1;
     }
-    else {
-      float time_multiplier = 1.0f / (clmd->sim_parms->dt * clmd->sim_parms->timescale);
-      float d;
 
-      d = clmd->coll_parms->selfepsilon * 8.0f / 9.0f * 2.0f - collpair->distance;
+    result = true;
+  }
+  else {
+    float time_multiplier = 1.0f / (clmd->sim_parms->dt * clmd->sim_parms->timescale);
+    float d;
 
-      if (d > ALMOST_ZERO) {
-        /* Stay on the safe side and clamp repulse. */
-        float repulse = d * 1.0f / time_multiplier;
-        float impulse = repulse / 9.0f;
+    d = clmd->coll_parms->selfepsilon * 8.0f / 9.0f * 2.0f - collpair->distance;
 
-        VECADDMUL(ia[0], collpair->normal, w1 * impulse);
-        VECADDMUL(ia[1], collpair->normal, w2 * impulse);
-        VECADDMUL(ia[2], collpair->normal, w3 * impulse);
+    if (d > ALMOST_ZERO) {
+      /* Stay on the safe side and clamp repulse. */
+      float repulse = d * 1.0f / time_multiplier;
+      float impulse = repulse / 9.0f;
 
-        VECADDMUL(ib[0], collpair->normal, -u1 * impulse);
-        VECADDMUL(ib[1], collpair->normal, -u2 * impulse);
-        VECADDMUL(ib[2], collpair->normal, -u3 * impulse);
+      VECADDMUL(ia[0], collpair->normal, w1 * impulse);
+      VECADDMUL(ia[1], collpair->normal, w2 * impulse);
+      VECADDMUL(ia[2], collpair->normal, w3 * impulse);
 
-        result = 1;
-      }
+      VECADDMUL(ib[0], collpair->normal, -u1 * impulse);
+      VECADDMUL(ib[1], collpair->normal, -u2 * impulse);
+      VECADDMUL(ib[2], collpair->normal, -u3 * impulse);
+
+      result = true;
     }
+  }
 
-    if (result) {
-      float clamp_sq = clmd->coll_parms->self_clamp * dt;
-      clamp_sq *= clamp_sq;
+  if (result) {
+    float clamp_sq = clmd->coll_parms->self_clamp * dt;
+    clamp_sq *= clamp_sq;
 
-      cloth_selfcollision_impulse_vert(clamp_sq, ia[0], &cloth1->verts[collpair->ap1]);
-      cloth_selfcollision_impulse_vert(clamp_sq, ia[1], &cloth1->verts[collpair->ap2]);
-      cloth_selfcollision_impulse_vert(clamp_sq, ia[2], &cloth1->verts[collpair->ap3]);
+    cloth_selfcollision_impulse_vert(clamp_sq, ia[0], &cloth1->verts[collpair->ap1]);
+    cloth_selfcollision_impulse_vert(clamp_sq, ia[1], &cloth1->verts[collpair->ap2]);
+    cloth_selfcollision_impulse_vert(clamp_sq, ia[2], &cloth1->verts[collpair->ap3]);
 
-      cloth_selfcollision_impulse_vert(clamp_sq, ib[0], &cloth1->verts[collpair->bp1]);
-      cloth_selfcollision_impulse_vert(clamp_sq, ib[1], &cloth1->verts[collpair->bp2]);
-      cloth_selfcollision_impulse_vert(clamp_sq, ib[2], &cloth1->verts[collpair->bp3]);
-    }
+    cloth_selfcollision_impulse_vert(clamp_sq, ib[0], &cloth1->verts[collpair->bp1]);
+    cloth_selfcollision_impulse_vert(clamp_sq, ib[1], &cloth1->verts[collpair->bp2]);
+    cloth_selfcollision_impulse_vert(clamp_sq, ib[2], &cloth1->verts[collpair->bp3]);
   }
 
   return result;
@@ -1504,6 +1519,53 @@ static bool cloth_bvh_selfcollisions_nearcheck(ClothModifierData *clmd,
   return data.collided;
 }
 
+static void cloth_collision_impulse_apply_cb(void *__restrict userdata,
+                                             const int index,
+                                             const TaskParallelTLS *__restrict tls)
+{
+  ImpulseApplyData *data = (ImpulseApplyData *)userdata;
+  ClothVertex *vert = &data->verts[index];
+
+  /* Calculate "velocities" (just xnew = xold + v; no dt in v). */
+  if (vert->impulse_count) {
+    add_v3_v3(vert->tv, vert->impulse);
+    add_v3_v3(vert->dcvel, vert->impulse);
+    zero_v3(vert->impulse);
+    vert->impulse_count = 0;
+
+    (*(int *)tls->userdata_chunk)++;
+  }
+}
+
+static void cloth_collision_impulse_apply_finalize(void *__restrict userdata,
+                                                   void *__restrict userdata_chunk)
+{
+  ImpulseApplyData *data = (ImpulseApplyData *)userdata;
+  data->applied += *(int *)userdata_chunk;
+}
+
+/* Apply the accumulated impulses to the vertex velocities, returns the number of vertices
+ * that received an impulse. */
+static int cloth_collision_impulse_apply(Cloth *cloth)
+{
+  ImpulseApplyData data = {
+      .verts = cloth->verts,
+      .applied = 0,
+  };
+  int applied_chunk = 0;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (cloth->mvert_num > 1024);
+  settings.userdata_chunk = &applied_chunk;
+  settings.userdata_chunk_size = sizeof(applied_chunk);
+  settings.func_finalize = cloth_collision_impulse_apply_finalize;
+  BLI_task_parallel_range(
+      0, cloth->mvert_num, &data, cloth_collision_impulse_apply_cb, &settings);
+
+  return data.applied;
+}
+
 static int cloth_bvh_objcollisions_resolve(ClothModifierData *clmd,
                                            Object **collobjs,
                                            CollPair **collisions,
@@ -1511,15 +1573,10 @@ static int cloth_bvh_objcollisions_resolve(ClothModifierData *clmd,
                                            const uint numcollobj,
                                            const float dt)
 {
-  Cloth *cloth = clmd->clothObject;
-  int i = 0, j = 0, mvert_num = 0;
-  ClothVertex *verts = NULL;
+  int i = 0, j = 0;
   int ret = 0;
   int result = 0;
 
-  mvert_num = clmd->clothObject->mvert_num;
-  verts = cloth->verts;
-
   result = 1;
 
   for (j = 0; j < 2; j++) {
@@ -1538,17 +1595,7 @@ static int cloth_bvh_objcollisions_resolve(ClothModifierData *clmd,
 
     /* Apply impulses in parallel. */
     if (result) {
-      for (i = 0; i < mvert_num; i++) {
-        // calculate "velocities" (just xnew = xold + v; no dt in v)
-        if (verts[i].impulse_count) {
-          add_v3_v3(verts[i].tv, verts[i].impulse);
-          add_v3_v3(verts[i].dcvel, verts[i].impulse);
-          zero_v3(verts[i].impulse);
-          verts[i].impulse_count = 0;
-
-          ret++;
-        }
-      }
+      ret += cloth_collision_impulse_apply(clmd->clothObject);
     }
     else {
       break;
@@ -1557,44 +1604,153 @@ static int cloth_bvh_objcollisions_resolve(ClothModifierData *clmd,
   return ret;
 }
 
+/* Greedy graph coloring of the active self collision pairs, so that no two pairs of the same
+ * color share a vertex. Pair indices are sorted by color into r_pair_index, the pairs of color c
+ * are in the range [r_color_offset[c], r_color_offset[c + 1]). The last color holds the pairs
+ * that did not fit into SELFCOL_MAX_COLORS. */
+static void cloth_selfcollision_color_pairs(const Cloth *cloth,
+                                            const CollPair *collisions,
+                                            const int collision_count,
+                                            int *r_pair_index,
+                                            int r_color_offset[SELFCOL_MAX_COLORS + 2])
+{
+  uint *vert_colors = MEM_calloc_arrayN(cloth->mvert_num, sizeof(uint), __func__);
+  int *pair_color = MEM_malloc_arrayN(collision_count, sizeof(int), __func__);
+  int color_count[SELFCOL_MAX_COLORS + 1] = {0};
+
+  for (int i = 0; i < collision_count; i++) {
+    const CollPair *collpair = &collisions[i];
+
+    if (collpair->flag & (COLLISION_IN_FUTURE | COLLISION_INACTIVE)) {
+      pair_color[i] = -1;
+      continue;
+    }
+
+    const uint pair_verts[6] = {
+        collpair->ap1, collpair->ap2, collpair->ap3, collpair->bp1, collpair->bp2, collpair->bp3};
+    uint used = 0;
+    int color = SELFCOL_MAX_COLORS;
+
+    for (int k = 0; k < 6; k++) {
+      used |= vert_colors[pair_verts[k]];
+    }
+
+    if (used != UINT_MAX) {
+      color = (int)bitscan_forward_uint(~used);
+
+      for (int k = 0; k < 6; k++) {
+        vert_colors[pair_verts[k]] |= (1u << color);
+      }
+    }
+
+    pair_color[i] = color;
+    color_count[color]++;
+  }
+
+  r_color_offset[0] = 0;
+  for (int c = 0; c <= SELFCOL_MAX_COLORS; c++) {
+    r_color_offset[c + 1] = r_color_offset[c] + color_count[c];
+    color_count[c] = r_color_offset[c];
+  }
+
+  for (int i = 0; i < collision_count; i++) {
+    if (pair_color[i] >= 0) {
+      r_pair_index[color_count[pair_color[i]]++] = i;
+    }
+  }
+
+  MEM_freeN(vert_colors);
+  MEM_freeN(pair_color);
+}
+
+static void cloth_selfcollision_response_cb(void *__restrict userdata,
+                                            const int index,
+                                            const TaskParallelTLS *__restrict tls)
+{
+  SelfColResponseData *data = (SelfColResponseData *)userdata;
+  CollPair *collpair = &data->collisions[data->pair_index[index]];
+
+  if (cloth_selfcollision_response_pair(data->clmd, collpair, data->dt)) {
+    *(bool *)tls->userdata_chunk = true;
+  }
+}
+
+static void cloth_selfcollision_response_finalize(void *__restrict userdata,
+                                                  void *__restrict userdata_chunk)
+{
+  SelfColResponseData *data = (SelfColResponseData *)userdata;
+  data->result |= *(bool *)userdata_chunk;
+}
+
+static bool cloth_selfcollision_response_static(ClothModifierData *clmd,
+                                                CollPair *collisions,
+                                                const int *pair_index,
+                                                const int color_offset[SELFCOL_MAX_COLORS + 2],
+                                                const float dt)
+{
+  SelfColResponseData data = {
+      .clmd = clmd,
+      .collisions = collisions,
+      .dt = dt,
+      .result = false,
+  };
+  bool result_chunk = false;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 64;
+  settings.userdata_chunk = &result_chunk;
+  settings.userdata_chunk_size = sizeof(result_chunk);
+  settings.func_finalize = cloth_selfcollision_response_finalize;
+
+  /* Pairs of one color don't share vertices, so their impulses can be merged without locking.
+   * Colors are processed in order, which keeps the result independent of thread scheduling. */
+  for (int c = 0; c < SELFCOL_MAX_COLORS; c++) {
+    const int num_pairs = color_offset[c + 1] - color_offset[c];
+
+    if (num_pairs == 0) {
+      /* Greedy coloring leaves no gaps, higher colors are empty too. */
+      break;
+    }
+
+    data.pair_index = pair_index + color_offset[c];
+    BLI_task_parallel_range(0, num_pairs, &data, cloth_selfcollision_response_cb, &settings);
+  }
+
+  for (int i = color_offset[SELFCOL_MAX_COLORS]; i < color_offset[SELFCOL_MAX_COLORS + 1]; i++) {
+    if (cloth_selfcollision_response_pair(clmd, &collisions[pair_index[i]], dt)) {
+      data.result = true;
+    }
+  }
+
+  return data.result;
+}
+
 static int cloth_bvh_selfcollisions_resolve(ClothModifierData *clmd,
                                             CollPair *collisions,
                                             int collision_count,
                                             const float dt)
 {
-  Cloth *cloth = clmd->clothObject;
-  int i = 0, j = 0, mvert_num = 0;
-  ClothVertex *verts = NULL;
+  int *pair_index = MEM_malloc_arrayN(collision_count, sizeof(int), __func__);
+  int color_offset[SELFCOL_MAX_COLORS + 2];
+  int j = 0;
   int ret = 0;
-  int result = 0;
 
-  mvert_num = clmd->clothObject->mvert_num;
-  verts = cloth->verts;
+  cloth_selfcollision_color_pairs(
+      clmd->clothObject, collisions, collision_count, pair_index, color_offset);
 
   for (j = 0; j < 2; j++) {
-    result = 0;
-
-    result += cloth_selfcollision_response_static(clmd, collisions, collision_count, dt);
-
     /* Apply impulses in parallel. */
-    if (result) {
-      for (i = 0; i < mvert_num; i++) {
-        if (verts[i].impulse_count) {
-          // VECADDMUL ( verts[i].tv, verts[i].impulse, 1.0f / verts[i].impulse_count );
-          add_v3_v3(verts[i].tv, verts[i].impulse);
-          add_v3_v3(verts[i].dcvel, verts[i].impulse);
-          zero_v3(verts[i].impulse);
-          verts[i].impulse_count = 0;
-
-          ret++;
-        }
-      }
+    if (cloth_selfcollision_response_static(clmd, collisions, pair_index, color_offset, dt)) {
+      ret += cloth_collision_impulse_apply(clmd->clothObject);
     }
-
-    if (!result) {
+    else {
       break;
     }
   }
+
+  MEM_freeN(pair_index);
+
   return ret;
 }
 
@@ -1675,10 +1831,19 @@ int cloth_bvh_collision(
   }
 
   if (clmd->coll_parms->flags & CLOTH_COLLSETTINGS_FLAG_SELF) {
-    bvhtree_update_from_cloth(clmd, false, true);
-
-    overlap_self = BLI_bvhtree_overlap(
-        cloth->bvhselftree, cloth->bvhselftree, &coll_count_self, cloth_bvh_self_overlap_cb, clmd);
+    /* With continuous collision the bounds cover the motion from the previous step, so pairs
+     * stay in the list while the collision rounds below move vertices back along that path. */
+    const bool use_swept = (clmd->coll_parms->flags & CLOTH_COLLSETTINGS_FLAG_SELF_CONTINUOUS);
+    bvhtree_update_from_cloth(clmd, use_swept, true);
+
+    /* Pairs are gathered in per-thread buffers and concatenated. */
+    overlap_self = BLI_bvhtree_overlap_ex(cloth->bvhselftree,
+                                          cloth->bvhselftree,
+                                          &coll_count_self,
+                                          cloth_bvh_self_overlap_cb,
+                                          clmd,
+                                          0,
+                                          BVH_OVERLAP_USE_THREADING | BVH_OVERLAP_RETURN_PAIRS);
   }
 
   do {
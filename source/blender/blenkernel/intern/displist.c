@@ -42,6 +42,8 @@
 #include "BLI_string.h"
 #include "BLI_utildefines.h"
 
+#include "PIL_time.h"
+
 #include "BKE_displist.h"
 #include "BKE_object.h"
 #include "BKE_lib_id.h"
@@ -778,7 +780,9 @@ void BKE_displist_make_mball(Depsgraph *depsgraph, Scene *scene, Object *ob)
       ob->runtime.curve_cache = MEM_callocN(sizeof(CurveCache), "CurveCache for MBall");
     }
 
+    const double time_start = PIL_check_seconds_timer();
     BKE_mball_polygonize(depsgraph, scene, ob, &ob->runtime.curve_cache->disp);
+    ob->runtime.curve_cache->mball_tessellate_time = PIL_check_seconds_timer() - time_start;
     BKE_mball_texspace_calc(ob);
 
     object_deform_mball(ob, &ob->runtime.curve_cache->disp);
@@ -897,20 +897,20 @@ void curve_deform_vector(
   mul_m4_v3(cd.objectspace, vec);
 }
 
-typedef struct LatticeDeformUserdata {
+typedef struct LatticeDeformVertsData {
   LatticeDeformData *lattice_deform_data;
   float (*vert_coords)[3];
   MDeformVert *dvert;
   int defgrp_index;
   float fac;
   bool invert_vgroup;
-} LatticeDeformUserdata;
+} LatticeDeformVertsData;
 
 static void lattice_deform_vert_task(void *__restrict userdata,
                                      const int index,
                                      const TaskParallelTLS *__restrict UNUSED(tls))
 {
-  const LatticeDeformUserdata *data = userdata;
+  const LatticeDeformVertsData *data = userdata;
 
   if (data->dvert != NULL) {
     const float weight = data->invert_vgroup ?
@@ -926,25 +926,21 @@ static void lattice_deform_vert_task(void *__restrict userdata,
   }
 }
 
-void lattice_deform_verts(Object *laOb,
-                          Object *target,
-                          Mesh *mesh,
-                          float (*vert_coords)[3],
-                          int numVerts,
-                          short flag,
-                          const char *vgroup,
-                          float fac)
+static bool lattice_deform_data_init(LatticeDeformVertsData *data,
+                                     Object *laOb,
+                                     Object *target,
+                                     Mesh *mesh,
+                                     short flag,
+                                     const char *vgroup,
+                                     float fac)
 {
-  LatticeDeformData *lattice_deform_data;
   MDeformVert *dvert = NULL;
   int defgrp_index = -1;
 
   if (laOb->type != OB_LATTICE) {
-    return;
+    return false;
   }
 
-  lattice_deform_data = init_latt_deform(laOb, target);
-
   /* Check whether to use vertex groups (only possible if target is a Mesh or Lattice).
    * We want either a Mesh/Lattice with no derived data, or derived data with deformverts.
    */
@@ -965,21 +961,78 @@ void lattice_deform_verts(Object *laOb,
     }
   }
 
-  LatticeDeformUserdata data = {
-      .lattice_deform_data = lattice_deform_data,
-      .vert_coords = vert_coords,
+  *data = (LatticeDeformVertsData){
+      .lattice_deform_data = init_latt_deform(laOb, target),
       .dvert = dvert,
       .defgrp_index = defgrp_index,
       .fac = fac,
       .invert_vgroup = (flag & MOD_LATTICE_INVERT_VGROUP) != 0,
   };
 
+  return true;
+}
+
+void lattice_deform_verts(Object *laOb,
+                          Object *target,
+                          Mesh *mesh,
+                          float (*vert_coords)[3],
+                          int numVerts,
+                          short flag,
+                          const char *vgroup,
+                          float fac)
+{
+  LatticeDeformVertsData data;
+
+  if (!lattice_deform_data_init(&data, laOb, target, mesh, flag, vgroup, fac)) {
+    return;
+  }
+
+  data.vert_coords = vert_coords;
+
   TaskParallelSettings settings;
   BLI_parallel_range_settings_defaults(&settings);
   settings.min_iter_per_thread = 32;
   BLI_task_parallel_range(0, numVerts, &data, lattice_deform_vert_task, &settings);
 
-  end_latt_deform(lattice_deform_data);
+  end_latt_deform(data.lattice_deform_data);
+}
+
+/**
+ * Split version of #lattice_deform_verts, for deforming vertices in blocks.
+ * Returns NULL when the object is not a lattice.
+ */
+LatticeDeformVertsData *lattice_deform_verts_prepare(
+    Object *laOb, Object *target, Mesh *mesh, short flag, const char *vgroup, float fac)
+{
+  LatticeDeformVertsData *data = MEM_mallocN(sizeof(*data), __func__);
+
+  if (!lattice_deform_data_init(data, laOb, target, mesh, flag, vgroup, fac)) {
+    MEM_freeN(data);
+    return NULL;
+  }
+
+  return data;
+}
+
+void lattice_deform_verts_range(const LatticeDeformVertsData *data,
+                                float (*vert_coords)[3],
+                                int start,
+                                int end)
+{
+  LatticeDeformVertsData range_data = *data;
+  range_data.vert_coords = vert_coords;
+
+  for (int i = start; i < end; i++) {
+    lattice_deform_vert_task(&range_data, i, NULL);
+  }
+}
+
+void lattice_deform_verts_free(LatticeDeformVertsData *data)
+{
+  if (data) {
+    end_latt_deform(data->lattice_deform_data);
+    MEM_freeN(data);
+  }
 }
 
 bool object_deform_mball(Object *ob, ListBase *dispbase)
@@ -39,6 +39,7 @@
 #include "BLI_string_utils.h"
 #include "BLI_utildefines.h"
 #include "BLI_memarena.h"
+#include "BLI_task.h"
 
 #include "BKE_global.h"
 
@@ -67,10 +68,9 @@ typedef struct cube { /* partitioning cell (cube) */
   CORNER *corners[8]; /* eight corners */
 } CUBE;
 
-typedef struct cubes { /* linked list of cubes acting as stack */
-  CUBE cube;           /* a single cube */
-  struct cubes *next;  /* remaining elements */
-} CUBES;
+typedef struct pendingvertex { /* vertex which position and normal aren't computed yet */
+  const CORNER *c1, *c2;       /* corners of the edge the vertex lies on */
+} PENDINGVERTEX;
 
 typedef struct centerlist { /* list of cube locations */
   int i, j, k;              /* cube location */
@@ -114,13 +114,26 @@ typedef struct process {     /* parameters, storage */
   MetaballBVHNode metaball_bvh; /* The simplest bvh */
   Box allbb;                    /* Bounding box of all metaelems */
 
-  MetaballBVHNode **bvh_queue; /* Queue used during bvh traversal */
-  unsigned int bvh_queue_size;
+  unsigned int bvh_queue_size; /* Size of the queue used during bvh traversal */
+
+  /* Cubes waiting for polygonization, the surface is followed one layer of cubes at a time.
+   * All corners of a layer are evaluated (in parallel) before its cubes are polygonized. */
+  CUBE *cubes;
+  unsigned int cubes_len, cubes_alloc;
+
+  /* Corners which function value isn't computed yet. */
+  CORNER **corners_pending;
+  unsigned int corners_pending_len, corners_pending_alloc;
+
+  /* Vertices added by the current layer, computed in parallel once the layer is done. */
+  PENDINGVERTEX *verts_pending;
+  unsigned int verts_pending_first; /* index of the vertex of the first pending item */
 
-  CUBES *cubes;         /* stack of cubes waiting for polygonization */
   CENTERLIST **centers; /* cube center hash table */
   CORNER **corners;     /* corner value hash table */
   EDGELIST **edges;     /* edge and vertex id hash table */
+  unsigned int hashbit; /* bits per axis used by the hash tables */
+  unsigned int totcorner;
 
   int (*indices)[4];     /* output indices */
   unsigned int totindex; /* size of memory allocated for indices */
@@ -138,7 +151,11 @@ typedef struct process {     /* parameters, storage */
 static int vertid(PROCESS *process, const CORNER *c1, const CORNER *c2);
 static void add_cube(PROCESS *process, int i, int j, int k);
 static void make_face(PROCESS *process, int i1, int i2, int i3, int i4);
-static void converge(PROCESS *process, const CORNER *c1, const CORNER *c2, float r_p[3]);
+static void converge(const PROCESS *process,
+                     MetaballBVHNode **bvh_queue,
+                     const CORNER *c1,
+                     const CORNER *c2,
+                     float r_p[3]);
 
 /* ******************* SIMPLE BVH ********************* */
 
@@ -291,10 +308,15 @@ static void build_bvh_spatial(PROCESS *process,
  * (i-0.5)*size, (j-0.5)*size, (k-0.5)*size)
  */
 
-#define HASHBIT (5)
-#define HASHSIZE (size_t)(1 << (3 * HASHBIT)) /*! < hash table size (32768) */
+/* The hash tables start with 32768 buckets and grow with the number of corners,
+ * so big surfaces don't end up with long lists in every bucket. */
+#define HASHBIT_MIN (5)
+#define HASHBIT_MAX (7)
+#define HASHSIZE(bit) ((size_t)1 << (3 * (bit))) /*! < hash table size */
 
-#define HASH(i, j, k) ((((((i)&31) << 5) | ((j)&31)) << 5) | ((k)&31))
+#define HASH_AXIS(i, bit) ((unsigned int)(i) & ((1u << (bit)) - 1))
+#define HASH(i, j, k, bit) \
+  ((((HASH_AXIS(i, bit) << (bit)) | HASH_AXIS(j, bit)) << (bit)) | HASH_AXIS(k, bit))
 
 #define MB_BIT(i, bit) (((i) >> (bit)) & 1)
 // #define FLIP(i, bit) ((i) ^ 1 << (bit)) /* flip the given bit of i */
@@ -406,24 +428,27 @@ static float densfunc(const MetaElem *ball, float x, float y, float z)
 /**
  * Computes density at given position form all metaballs which contain this point in their box.
  * Traverses BVH using a queue.
+ *
+ * \param bvh_queue: Queue of #PROCESS.bvh_queue_size nodes, each thread needs its own.
  */
-static float metaball(PROCESS *process, float x, float y, float z)
+static float metaball(
+    const PROCESS *process, MetaballBVHNode **bvh_queue, float x, float y, float z)
 {
   int i;
   float dens = 0.0f;
   unsigned int front = 0, back = 0;
-  MetaballBVHNode *node;
+  const MetaballBVHNode *node;
 
-  process->bvh_queue[front++] = &process->metaball_bvh;
+  bvh_queue[front++] = (MetaballBVHNode *)&process->metaball_bvh;
 
   while (front != back) {
-    node = process->bvh_queue[back++];
+    node = bvh_queue[back++];
 
     for (i = 0; i < 2; i++) {
       if ((node->bb[i].min[0] <= x) && (node->bb[i].max[0] >= x) && (node->bb[i].min[1] <= y) &&
           (node->bb[i].max[1] >= y) && (node->bb[i].min[2] <= z) && (node->bb[i].max[2] >= z)) {
         if (node->child[i]) {
-          process->bvh_queue[front++] = node->child[i];
+          bvh_queue[front++] = node->child[i];
         }
         else {
           dens += densfunc(node->bb[i].ml, x, y, z);
@@ -442,10 +467,6 @@ static void make_face(PROCESS *process, int i1, int i2, int i3, int i4)
 {
   int *cur;
 
-#ifdef USE_ACCUM_NORMAL
-  float n[3];
-#endif
-
   if (UNLIKELY(process->totindex == process->curindex)) {
     process->totindex += 4096;
     process->indices = MEM_reallocN(process->indices, sizeof(int[4]) * process->totindex);
@@ -459,34 +480,49 @@ static void make_face(PROCESS *process, int i1, int i2, int i3, int i4)
   cur[1] = i2;
   cur[2] = i3;
   cur[3] = i4;
+}
 
 #ifdef USE_ACCUM_NORMAL
-  if (i4 == i3) {
-    normal_tri_v3(n, process->co[i1], process->co[i2], process->co[i3]);
-    accumulate_vertex_normals_v3(process->no[i1],
-                                 process->no[i2],
-                                 process->no[i3],
-                                 NULL,
-                                 n,
-                                 process->co[i1],
-                                 process->co[i2],
-                                 process->co[i3],
-                                 NULL);
-  }
-  else {
-    normal_quad_v3(n, process->co[i1], process->co[i2], process->co[i3], process->co[i4]);
-    accumulate_vertex_normals_v3(process->no[i1],
-                                 process->no[i2],
-                                 process->no[i3],
-                                 process->no[i4],
-                                 n,
-                                 process->co[i1],
-                                 process->co[i2],
-                                 process->co[i3],
-                                 process->co[i4]);
+/**
+ * Accumulates face normals to the vertices,
+ * done once all vertex positions are known.
+ */
+static void accumulate_normals(PROCESS *process)
+{
+  unsigned int a;
+  float n[3];
+
+  for (a = 0; a < process->curindex; a++) {
+    const int *cur = process->indices[a];
+    const int i1 = cur[0], i2 = cur[1], i3 = cur[2], i4 = cur[3];
+
+    if (i4 == i3) {
+      normal_tri_v3(n, process->co[i1], process->co[i2], process->co[i3]);
+      accumulate_vertex_normals_v3(process->no[i1],
+                                   process->no[i2],
+                                   process->no[i3],
+                                   NULL,
+                                   n,
+                                   process->co[i1],
+                                   process->co[i2],
+                                   process->co[i3],
+                                   NULL);
+    }
+    else {
+      normal_quad_v3(n, process->co[i1], process->co[i2], process->co[i3], process->co[i4]);
+      accumulate_vertex_normals_v3(process->no[i1],
+                                   process->no[i2],
+                                   process->no[i3],
+                                   process->no[i4],
+                                   n,
+                                   process->co[i1],
+                                   process->co[i2],
+                                   process->co[i3],
+                                   process->co[i4]);
+    }
   }
-#endif
 }
+#endif
 
 /* Frees allocated memory */
 static void freepolygonize(PROCESS *process)
@@ -503,8 +539,14 @@ static void freepolygonize(PROCESS *process)
   if (process->mainb) {
     MEM_freeN(process->mainb);
   }
-  if (process->bvh_queue) {
-    MEM_freeN(process->bvh_queue);
+  if (process->cubes) {
+    MEM_freeN(process->cubes);
+  }
+  if (process->corners_pending) {
+    MEM_freeN(process->corners_pending);
+  }
+  if (process->verts_pending) {
+    MEM_freeN(process->verts_pending);
   }
   if (process->pgn_elements) {
     BLI_memarena_free(process->pgn_elements);
@@ -668,18 +710,67 @@ static void docube(PROCESS *process, CUBE *cube)
   }
 }
 
+/**
+ * Moves everything in the hash tables to bigger ones.
+ */
+static void hash_tables_grow(PROCESS *process)
+{
+  const unsigned int hashbit = process->hashbit + 1;
+  CENTERLIST **centers = MEM_callocN(HASHSIZE(hashbit) * sizeof(CENTERLIST *), "mbproc->centers");
+  CORNER **corners = MEM_callocN(HASHSIZE(hashbit) * sizeof(CORNER *), "mbproc->corners");
+  EDGELIST **edges = MEM_callocN(2 * HASHSIZE(hashbit) * sizeof(EDGELIST *), "mbproc->edges");
+  size_t index;
+
+  for (index = 0; index < HASHSIZE(process->hashbit); index++) {
+    CENTERLIST *l, *l_next;
+    CORNER *c, *c_next;
+
+    for (l = process->centers[index]; l; l = l_next) {
+      const unsigned int index_new = HASH(l->i, l->j, l->k, hashbit);
+      l_next = l->next;
+      l->next = centers[index_new];
+      centers[index_new] = l;
+    }
+    for (c = process->corners[index]; c; c = c_next) {
+      const unsigned int index_new = HASH(c->i, c->j, c->k, hashbit);
+      c_next = c->next;
+      c->next = corners[index_new];
+      corners[index_new] = c;
+    }
+  }
+  for (index = 0; index < 2 * HASHSIZE(process->hashbit); index++) {
+    EDGELIST *q, *q_next;
+
+    for (q = process->edges[index]; q; q = q_next) {
+      const unsigned int index_new = HASH(q->i1, q->j1, q->k1, hashbit) +
+                                     HASH(q->i2, q->j2, q->k2, hashbit);
+      q_next = q->next;
+      q->next = edges[index_new];
+      edges[index_new] = q;
+    }
+  }
+
+  MEM_freeN(process->centers);
+  MEM_freeN(process->corners);
+  MEM_freeN(process->edges);
+  process->centers = centers;
+  process->corners = corners;
+  process->edges = edges;
+  process->hashbit = hashbit;
+}
+
 /**
  * return corner with the given lattice location
- * set (and cache) its function value
+ * new corners are cached, their function value is computed later by #corners_pending_eval
  */
 static CORNER *setcorner(PROCESS *process, int i, int j, int k)
 {
   /* for speed, do corner value caching here */
   CORNER *c;
-  int index;
+  unsigned int index;
 
   /* does corner exist? */
-  index = HASH(i, j, k);
+  index = HASH(i, j, k, process->hashbit);
   c = process->corners[index];
 
   for (; c != NULL; c = c->next) {
@@ -697,11 +788,23 @@ static CORNER *setcorner(PROCESS *process, int i, int j, int k)
   c->k = k;
   c->co[2] = ((float)k - 0.5f) * process->size;
 
-  c->value = metaball(process, c->co[0], c->co[1], c->co[2]);
+  c->value = 0.0f;
+
+  if (UNLIKELY(process->corners_pending_len == process->corners_pending_alloc)) {
+    process->corners_pending_alloc = process->corners_pending_alloc * 2 + 4096;
+    process->corners_pending = MEM_reallocN(
+        process->corners_pending, sizeof(CORNER *) * process->corners_pending_alloc);
+  }
+  process->corners_pending[process->corners_pending_len++] = c;
 
   c->next = process->corners[index];
   process->corners[index] = c;
 
+  if (UNLIKELY(++process->totcorner > HASHSIZE(process->hashbit)) &&
+      (process->hashbit < HASHBIT_MAX)) {
+    hash_tables_grow(process);
+  }
+
   return c;
 }
 
@@ -860,12 +963,13 @@ void BKE_mball_cubeTable_free(void)
 /**
  * Inserts cube at lattice i, j, k into hash table, marking it as "done"
  */
-static int setcenter(PROCESS *process, CENTERLIST *table[], const int i, const int j, const int k)
+static int setcenter(PROCESS *process, const int i, const int j, const int k)
 {
-  int index;
+  CENTERLIST **table = process->centers;
+  unsigned int index;
   CENTERLIST *newc, *l, *q;
 
-  index = HASH(i, j, k);
+  index = HASH(i, j, k, process->hashbit);
   q = table[index];
 
   for (l = q; l != NULL; l = l->next) {
@@ -889,7 +993,7 @@ static int setcenter(PROCESS *process, CENTERLIST *table[], const int i, const i
  */
 static void setedge(PROCESS *process, int i1, int j1, int k1, int i2, int j2, int k2, int vid)
 {
-  int index;
+  unsigned int index;
   EDGELIST *newe;
 
   if (i1 > i2 || (i1 == i2 && (j1 > j2 || (j1 == j2 && k1 > k2)))) {
@@ -903,7 +1007,7 @@ static void setedge(PROCESS *process, int i1, int j1, int k1, int i2, int j2, in
     k1 = k2;
     k2 = t;
   }
-  index = HASH(i1, j1, k1) + HASH(i2, j2, k2);
+  index = HASH(i1, j1, k1, process->hashbit) + HASH(i2, j2, k2, process->hashbit);
   newe = BLI_memarena_alloc(process->pgn_elements, sizeof(EDGELIST));
 
   newe->i1 = i1;
@@ -920,7 +1024,7 @@ static void setedge(PROCESS *process, int i1, int j1, int k1, int i2, int j2, in
 /**
  * \return vertex id for edge; return -1 if not set
  */
-static int getedge(EDGELIST *table[], int i1, int j1, int k1, int i2, int j2, int k2)
+static int getedge(const PROCESS *process, int i1, int j1, int k1, int i2, int j2, int k2)
 {
   EDGELIST *q;
 
@@ -935,7 +1039,7 @@ static int getedge(EDGELIST *table[], int i1, int j1, int k1, int i2, int j2, in
     k1 = k2;
     k2 = t;
   }
-  q = table[HASH(i1, j1, k1) + HASH(i2, j2, k2)];
+  q = process->edges[HASH(i1, j1, k1, process->hashbit) + HASH(i2, j2, k2, process->hashbit)];
   for (; q != NULL; q = q->next) {
     if (q->i1 == i1 && q->j1 == j1 && q->k1 == k1 && q->i2 == i2 && q->j2 == j2 && q->k2 == k2) {
       return q->vid;
@@ -945,20 +1049,26 @@ static int getedge(EDGELIST *table[], int i1, int j1, int k1, int i2, int j2, in
 }
 
 /**
- * Adds a vertex, expands memory if needed.
+ * Adds a vertex lying between two corners, expands memory if needed.
+ * Its position and normal are computed by #verts_pending_eval.
  */
-static void addtovertices(PROCESS *process, const float v[3], const float no[3])
+static int addtovertices(PROCESS *process, const CORNER *c1, const CORNER *c2)
 {
+  PENDINGVERTEX *pv;
+
   if (process->curvertex == process->totvertex) {
     process->totvertex += 4096;
     process->co = MEM_reallocN(process->co, process->totvertex * sizeof(float[3]));
     process->no = MEM_reallocN(process->no, process->totvertex * sizeof(float[3]));
+    process->verts_pending = MEM_reallocN(process->verts_pending,
+                                          process->totvertex * sizeof(PENDINGVERTEX));
   }
 
-  copy_v3_v3(process->co[process->curvertex], v);
-  copy_v3_v3(process->no[process->curvertex], no);
+  pv = &process->verts_pending[process->curvertex - process->verts_pending_first];
+  pv->c1 = c1;
+  pv->c2 = c2;
 
-  process->curvertex++;
+  return (int)process->curvertex++;
 }
 
 #ifndef USE_ACCUM_NORMAL
@@ -967,41 +1077,35 @@ static void addtovertices(PROCESS *process, const float v[3], const float no[3])
  *
  * \note Doesn't do normalization!
  */
-static void vnormal(PROCESS *process, const float point[3], float r_no[3])
+static void vnormal(const PROCESS *process,
+                    MetaballBVHNode **bvh_queue,
+                    const float point[3],
+                    float r_no[3])
 {
   const float delta = process->delta;
-  const float f = metaball(process, point[0], point[1], point[2]);
+  const float f = metaball(process, bvh_queue, point[0], point[1], point[2]);
 
-  r_no[0] = metaball(process, point[0] + delta, point[1], point[2]) - f;
-  r_no[1] = metaball(process, point[0], point[1] + delta, point[2]) - f;
-  r_no[2] = metaball(process, point[0], point[1], point[2] + delta) - f;
+  r_no[0] = metaball(process, bvh_queue, point[0] + delta, point[1], point[2]) - f;
+  r_no[1] = metaball(process, bvh_queue, point[0], point[1] + delta, point[2]) - f;
+  r_no[2] = metaball(process, bvh_queue, point[0], point[1], point[2] + delta) - f;
 }
 #endif /* USE_ACCUM_NORMAL */
 
 /**
  * \return the id of vertex between two corners.
  *
- * If it wasn't previously computed, does #converge() and adds vertex to process.
+ * If it wasn't previously computed, adds vertex to process,
+ * #converge() is done later for all vertices of the layer.
  */
 static int vertid(PROCESS *process, const CORNER *c1, const CORNER *c2)
 {
-  float v[3], no[3];
-  int vid = getedge(process->edges, c1->i, c1->j, c1->k, c2->i, c2->j, c2->k);
+  int vid = getedge(process, c1->i, c1->j, c1->k, c2->i, c2->j, c2->k);
 
   if (vid != -1) {
     return vid; /* previously computed */
   }
 
-  converge(process, c1, c2, v); /* position */
-
-#ifdef USE_ACCUM_NORMAL
-  zero_v3(no);
-#else
-  vnormal(process, v, no);
-#endif
-
-  addtovertices(process, v, no); /* save vertex */
-  vid = (int)process->curvertex - 1;
+  vid = addtovertices(process, c1, c2); /* save vertex */
   setedge(process, c1->i, c1->j, c1->k, c2->i, c2->j, c2->k, vid);
 
   return vid;
@@ -1011,7 +1115,11 @@ static int vertid(PROCESS *process, const CORNER *c1, const CORNER *c2)
  * Given two corners, computes approximation of surface intersection point between them.
  * In case of small threshold, do bisection.
  */
-static void converge(PROCESS *process, const CORNER *c1, const CORNER *c2, float r_p[3])
+static void converge(const PROCESS *process,
+                     MetaballBVHNode **bvh_queue,
+                     const CORNER *c1,
+                     const CORNER *c2,
+                     float r_p[3])
 {
   float tmp, dens;
   unsigned int i;
@@ -1033,7 +1141,7 @@ static void converge(PROCESS *process, const CORNER *c1, const CORNER *c2, float
 
   for (i = 0; i < process->converge_res; i++) {
     interp_v3_v3v3(r_p, c1_co, c2_co, 0.5f);
-    dens = metaball(process, r_p[0], r_p[1], r_p[2]);
+    dens = metaball(process, bvh_queue, r_p[0], r_p[1], r_p[2]);
 
     if (dens > 0.0f) {
       c1_value = dens;
@@ -1050,28 +1158,28 @@ static void converge(PROCESS *process, const CORNER *c1, const CORNER *c2, float
 }
 
 /**
- * Adds cube at given lattice position to cube stack of process.
+ * Adds cube at given lattice position to the next layer of cubes.
  */
 static void add_cube(PROCESS *process, int i, int j, int k)
 {
-  CUBES *ncube;
+  CUBE *ncube;
   int n;
 
   /* test if cube has been found before */
-  if (setcenter(process, process->centers, i, j, k) == 0) {
-    /* push cube on stack: */
-    ncube = BLI_memarena_alloc(process->pgn_elements, sizeof(CUBES));
-    ncube->next = process->cubes;
-    process->cubes = ncube;
+  if (setcenter(process, i, j, k) == 0) {
+    if (UNLIKELY(process->cubes_len == process->cubes_alloc)) {
+      process->cubes_alloc = process->cubes_alloc * 2 + 1024;
+      process->cubes = MEM_reallocN(process->cubes, sizeof(CUBE) * process->cubes_alloc);
+    }
+    ncube = &process->cubes[process->cubes_len++];
 
-    ncube->cube.i = i;
-    ncube->cube.j = j;
-    ncube->cube.k = k;
+    ncube->i = i;
+    ncube->j = j;
+    ncube->k = k;
 
     /* set corners of initial cube: */
     for (n = 0; n < 8; n++) {
-      ncube->cube.corners[n] = setcorner(
-          process, i + MB_BIT(n, 2), j + MB_BIT(n, 1), k + MB_BIT(n, 0));
+      ncube->corners[n] = setcorner(process, i + MB_BIT(n, 2), j + MB_BIT(n, 1), k + MB_BIT(n, 0));
     }
   }
 }
@@ -1096,14 +1204,33 @@ static void closest_latice(int r[3], const float pos[3], const float size)
   r[2] = (int)floorf(pos[2] / size + 1.0f);
 }
 
+/**
+ * Function value at a lattice location, the same as #setcorner computes for its corner.
+ */
+static float lattice_value(
+    const PROCESS *process, MetaballBVHNode **bvh_queue, const int i, const int j, const int k)
+{
+  return metaball(process,
+                  bvh_queue,
+                  ((float)i - 0.5f) * process->size,
+                  ((float)j - 0.5f) * process->size,
+                  ((float)k - 0.5f) * process->size);
+}
+
 /**
  * Find at most 26 cubes to start polygonization from.
+ *
+ * \return the number of cubes written to \a r_cubes.
  */
-static void find_first_points(PROCESS *process, const unsigned int em)
+static unsigned int find_first_points(const PROCESS *process,
+                                      MetaballBVHNode **bvh_queue,
+                                      const unsigned int em,
+                                      int r_cubes[26][3])
 {
   const MetaElem *ml;
   int center[3], lbn[3], rtf[3], it[3], dir[3], add[3];
   float tmp[3], a, b;
+  unsigned int cubes_len = 0;
 
   ml = process->mainb[em];
 
@@ -1121,20 +1248,20 @@ static void find_first_points(PROCESS *process, const unsigned int em)
 
         copy_v3_v3_int(it, center);
 
-        b = setcorner(process, it[0], it[1], it[2])->value;
+        b = lattice_value(process, bvh_queue, it[0], it[1], it[2]);
         do {
           it[0] += dir[0];
           it[1] += dir[1];
           it[2] += dir[2];
           a = b;
-          b = setcorner(process, it[0], it[1], it[2])->value;
+          b = lattice_value(process, bvh_queue, it[0], it[1], it[2]);
 
           if (a * b < 0.0f) {
             add[0] = it[0] - dir[0];
             add[1] = it[1] - dir[1];
             add[2] = it[2] - dir[2];
             DO_MIN(it, add);
-            add_cube(process, add[0], add[1], add[2]);
+            copy_v3_v3_int(r_cubes[cubes_len++], add);
             break;
           }
         } while ((it[0] > lbn[0]) && (it[1] > lbn[1]) && (it[2] > lbn[2]) && (it[0] < rtf[0]) &&
@@ -1142,37 +1269,204 @@ static void find_first_points(PROCESS *process, const unsigned int em)
       }
     }
   }
+
+  return cubes_len;
+}
+
+/* **************** PARALLEL EVALUATION ************************ */
+
+/**
+ * The function values, the search for first points and the vertex positions are computed
+ * in parallel, everything which creates topology (and so decides on the order of the output)
+ * runs on a single thread, so the result is the same for any number of threads.
+ */
+
+typedef struct PolygonizeTLS {
+  MetaballBVHNode **bvh_queue;
+} PolygonizeTLS;
+
+typedef struct PolygonizeData {
+  const PROCESS *process;
+  /* Used by #find_first_points_cb. */
+  int (*first_cubes)[26][3];
+  unsigned int *first_cubes_len;
+} PolygonizeData;
+
+static MetaballBVHNode **polygonize_tls_bvh_queue(const PROCESS *process, PolygonizeTLS *tls)
+{
+  if (tls->bvh_queue == NULL) {
+    tls->bvh_queue = MEM_mallocN(sizeof(MetaballBVHNode *) * process->bvh_queue_size, __func__);
+  }
+  return tls->bvh_queue;
+}
+
+static void polygonize_tls_finalize(void *__restrict UNUSED(userdata),
+                                    void *__restrict userdata_chunk)
+{
+  PolygonizeTLS *tls = userdata_chunk;
+  if (tls->bvh_queue) {
+    MEM_freeN(tls->bvh_queue);
+  }
+}
+
+static void polygonize_parallel_range(PROCESS *process,
+                                      PolygonizeData *data,
+                                      const unsigned int len,
+                                      TaskParallelRangeFunc func)
+{
+  PolygonizeTLS tls = {NULL};
+  TaskParallelSettings settings;
+
+  data->process = process;
+
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (len > 256);
+  settings.min_iter_per_thread = 64;
+  settings.userdata_chunk = &tls;
+  settings.userdata_chunk_size = sizeof(tls);
+  settings.func_finalize = polygonize_tls_finalize;
+  BLI_task_parallel_range(0, (int)len, data, func, &settings);
+}
+
+static void find_first_points_cb(void *__restrict userdata,
+                                 const int i,
+                                 const TaskParallelTLS *__restrict tls)
+{
+  PolygonizeData *data = userdata;
+  MetaballBVHNode **bvh_queue = polygonize_tls_bvh_queue(data->process, tls->userdata_chunk);
+
+  data->first_cubes_len[i] = find_first_points(
+      data->process, bvh_queue, (unsigned int)i, data->first_cubes[i]);
+}
+
+static void corners_pending_eval_cb(void *__restrict userdata,
+                                    const int i,
+                                    const TaskParallelTLS *__restrict tls)
+{
+  PolygonizeData *data = userdata;
+  const PROCESS *process = data->process;
+  MetaballBVHNode **bvh_queue = polygonize_tls_bvh_queue(process, tls->userdata_chunk);
+  CORNER *c = process->corners_pending[i];
+
+  c->value = metaball(process, bvh_queue, c->co[0], c->co[1], c->co[2]);
+}
+
+static void verts_pending_eval_cb(void *__restrict userdata,
+                                  const int i,
+                                  const TaskParallelTLS *__restrict tls)
+{
+  PolygonizeData *data = userdata;
+  const PROCESS *process = data->process;
+  MetaballBVHNode **bvh_queue = polygonize_tls_bvh_queue(process, tls->userdata_chunk);
+  const PENDINGVERTEX *pv = &process->verts_pending[i];
+  const unsigned int vid = process->verts_pending_first + (unsigned int)i;
+
+  converge(process, bvh_queue, pv->c1, pv->c2, process->co[vid]); /* position */
+
+#ifdef USE_ACCUM_NORMAL
+  zero_v3(process->no[vid]);
+#else
+  vnormal(process, bvh_queue, process->co[vid], process->no[vid]);
+#endif
+}
+
+/**
+ * Adds the cubes found around all metaelems, in the order of the metaelems.
+ */
+static void find_first_points_all(PROCESS *process)
+{
+  PolygonizeData data = {NULL};
+  unsigned int em, n;
+
+  data.first_cubes = MEM_mallocN(sizeof(*data.first_cubes) * process->totelem, __func__);
+  data.first_cubes_len = MEM_mallocN(sizeof(*data.first_cubes_len) * process->totelem,
+                                     __func__);
+
+  polygonize_parallel_range(process, &data, process->totelem, find_first_points_cb);
+
+  for (em = 0; em < process->totelem; em++) {
+    for (n = 0; n < data.first_cubes_len[em]; n++) {
+      add_cube(process, UNPACK3(data.first_cubes[em][n]));
+    }
+  }
+
+  MEM_freeN(data.first_cubes);
+  MEM_freeN(data.first_cubes_len);
+}
+
+/**
+ * Computes the function value of all corners added since the last call.
+ */
+static void corners_pending_eval(PROCESS *process)
+{
+  PolygonizeData data = {NULL};
+
+  polygonize_parallel_range(
+      process, &data, process->corners_pending_len, corners_pending_eval_cb);
+  process->corners_pending_len = 0;
+}
+
+/**
+ * Computes position and normal of all vertices added since the last call.
+ */
+static void verts_pending_eval(PROCESS *process)
+{
+  PolygonizeData data = {NULL};
+
+  polygonize_parallel_range(process,
+                            &data,
+                            process->curvertex - process->verts_pending_first,
+                            verts_pending_eval_cb);
+  process->verts_pending_first = process->curvertex;
 }
 
 /**
  * The main polygonization proc.
  * Allocates memory, makes cubetable,
  * finds starting surface points
- * and processes cubes on the stack until none left.
+ * and processes cubes layer by layer until none left.
  */
 static void polygonize(PROCESS *process)
 {
-  CUBE c;
+  CUBE *layer = NULL;
+  unsigned int layer_alloc = 0;
   unsigned int i;
 
-  process->centers = MEM_callocN(HASHSIZE * sizeof(CENTERLIST *), "mbproc->centers");
-  process->corners = MEM_callocN(HASHSIZE * sizeof(CORNER *), "mbproc->corners");
-  process->edges = MEM_callocN(2 * HASHSIZE * sizeof(EDGELIST *), "mbproc->edges");
-  process->bvh_queue = MEM_callocN(sizeof(MetaballBVHNode *) * process->bvh_queue_size,
-                                   "Metaball BVH Queue");
+  process->hashbit = HASHBIT_MIN;
+  process->centers = MEM_callocN(HASHSIZE(process->hashbit) * sizeof(CENTERLIST *),
+                                 "mbproc->centers");
+  process->corners = MEM_callocN(HASHSIZE(process->hashbit) * sizeof(CORNER *),
+                                 "mbproc->corners");
+  process->edges = MEM_callocN(2 * HASHSIZE(process->hashbit) * sizeof(EDGELIST *),
+                               "mbproc->edges");
 
   makecubetable();
 
-  for (i = 0; i < process->totelem; i++) {
-    find_first_points(process, i);
-  }
+  find_first_points_all(process);
+
+  while (process->cubes_len != 0) {
+    /* Cubes added while polygonizing this layer make up the next one. */
+    const unsigned int layer_len = process->cubes_len;
+    SWAP(CUBE *, layer, process->cubes);
+    SWAP(unsigned int, layer_alloc, process->cubes_alloc);
+    process->cubes_len = 0;
 
-  while (process->cubes != NULL) {
-    c = process->cubes->cube;
-    process->cubes = process->cubes->next;
+    corners_pending_eval(process);
 
-    docube(process, &c);
+    for (i = 0; i < layer_len; i++) {
+      docube(process, &layer[i]);
+    }
+
+    verts_pending_eval(process);
+  }
+
+  if (layer) {
+    MEM_freeN(layer);
   }
+
+#ifdef USE_ACCUM_NORMAL
+  accumulate_normals(process);
+#endif
 }
 
 /**
@@ -41,9 +41,11 @@
 #include "BLI_utildefines.h"
 #include "BLI_listbase.h"
 #include "BLI_linklist.h"
+#include "BLI_math_base.h"
 #include "BLI_path_util.h"
 #include "BLI_string.h"
 #include "BLI_string_utils.h"
+#include "BLI_task.h"
 
 #include "BLT_translation.h"
 
@@ -1041,3 +1043,143 @@ struct ModifierData *modifier_get_evaluated(Depsgraph *depsgraph, Object *object
   }
   return modifiers_findByName(object_eval, md->name);
 }
+
+/* -------------------------------------------------------------------- */
+/** \name Fused Deform Modifiers
+ *
+ * Consecutive deform modifiers which can be evaluated in blocks of vertices are queued,
+ * and applied together once the chain ends: all modifiers of the chain deform one block
+ * before moving on to the next one. This way the coordinates stay in cache for the whole
+ * chain, instead of passing over the entire coordinate array once per modifier.
+ * \{ */
+
+/* Number of vertices deformed at once, small enough for the coordinates to stay in cache. */
+#define DEFORM_CHAIN_BLOCK_SIZE 1024
+
+typedef struct ModifierDeformChainItem {
+  ModifierData *md;
+  Mesh *mesh;
+} ModifierDeformChainItem;
+
+typedef struct DeformChainBlockData {
+  const ModifierDeformBlock *blocks;
+  int blocks_len;
+  float (*vertexCos)[3];
+  int numVerts;
+} DeformChainBlockData;
+
+/* Queue a deform modifier, returns false if it has to be applied on its own. */
+bool modifier_deform_chain_add(ModifierDeformChain *chain, ModifierData *md, Mesh *mesh)
+{
+  const ModifierTypeInfo *mti = modifierType_getInfo(md->type);
+
+  if (mti->deformVertsBlockPrepare == NULL ||
+      (mti->dependsOnNormals && mti->dependsOnNormals(md))) {
+    return false;
+  }
+
+  if (chain->items_len == chain->items_alloc) {
+    chain->items_alloc = max_ii(chain->items_alloc * 2, 8);
+    chain->items = MEM_reallocN(chain->items, sizeof(*chain->items) * chain->items_alloc);
+  }
+
+  chain->items[chain->items_len++] = (ModifierDeformChainItem){md, mesh};
+  return true;
+}
+
+static void deform_chain_block_cb(void *__restrict userdata,
+                                  const int index,
+                                  const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const DeformChainBlockData *data = userdata;
+  const int start = index * DEFORM_CHAIN_BLOCK_SIZE;
+  const int end = min_ii(start + DEFORM_CHAIN_BLOCK_SIZE, data->numVerts);
+
+  for (int i = 0; i < data->blocks_len; i++) {
+    const ModifierDeformBlock *block = &data->blocks[i];
+    if (block->deform) {
+      block->deform(block->userdata, data->vertexCos, start, end);
+    }
+  }
+}
+
+static void deform_chain_blocks_apply(ModifierDeformBlock *blocks,
+                                      int blocks_len,
+                                      float (*vertexCos)[3],
+                                      int numVerts)
+{
+  DeformChainBlockData data = {
+      .blocks = blocks,
+      .blocks_len = blocks_len,
+      .vertexCos = vertexCos,
+      .numVerts = numVerts,
+  };
+  const int num_blocks = (numVerts + DEFORM_CHAIN_BLOCK_SIZE - 1) / DEFORM_CHAIN_BLOCK_SIZE;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (num_blocks > 1);
+  BLI_task_parallel_range(0, num_blocks, &data, deform_chain_block_cb, &settings);
+
+  for (int i = 0; i < blocks_len; i++) {
+    if (blocks[i].free) {
+      blocks[i].free(blocks[i].userdata);
+    }
+  }
+}
+
+/* Apply all queued modifiers to the coordinates. */
+void modifier_deform_chain_flush(ModifierDeformChain *chain,
+                                 const ModifierEvalContext *mectx,
+                                 float (*vertexCos)[3],
+                                 int numVerts)
+{
+  if (chain->items_len == 0) {
+    return;
+  }
+
+  /* Nothing to fuse, the modifier is typically threaded on its own. */
+  if (chain->items_len == 1) {
+    ModifierDeformChainItem *item = &chain->items[0];
+    modwrap_deformVerts(item->md, mectx, item->mesh, vertexCos, numVerts);
+    chain->items_len = 0;
+    return;
+  }
+
+  ModifierDeformBlock *blocks = MEM_malloc_arrayN(chain->items_len, sizeof(*blocks), __func__);
+  int blocks_len = 0;
+
+  for (int i = 0; i < chain->items_len; i++) {
+    ModifierDeformChainItem *item = &chain->items[i];
+    const ModifierTypeInfo *mti = modifierType_getInfo(item->md->type);
+    ModifierDeformBlock *block = &blocks[blocks_len];
+
+    memset(block, 0, sizeof(*block));
+    if (mti->deformVertsBlockPrepare(item->md, mectx, item->mesh, numVerts, block)) {
+      blocks_len++;
+    }
+    else {
+      /* Apply what was fused so far, to keep the order of the stack. */
+      if (blocks_len) {
+        deform_chain_blocks_apply(blocks, blocks_len, vertexCos, numVerts);
+        blocks_len = 0;
+      }
+      modwrap_deformVerts(item->md, mectx, item->mesh, vertexCos, numVerts);
+    }
+  }
+
+  if (blocks_len) {
+    deform_chain_blocks_apply(blocks, blocks_len, vertexCos, numVerts);
+  }
+
+  MEM_freeN(blocks);
+  chain->items_len = 0;
+}
+
+void modifier_deform_chain_free(ModifierDeformChain *chain)
+{
+  BLI_assert(chain->items_len == 0);
+  MEM_SAFE_FREE(chain->items);
+}
+
+/** \} */
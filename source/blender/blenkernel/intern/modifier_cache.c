@@ -0,0 +1,539 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup bke
+ *
+ * Cached intermediate results of the modifier stack.
+ *
+ * Modifiers flagged with #eModifierFlag_CacheResult keep a copy of their result, so editing a
+ * modifier further down the stack can continue from that copy instead of evaluating the whole
+ * stack again. A result is only reused when the key of the stack up to that modifier matches,
+ * the key covers the input mesh, the settings of every modifier up to that point (read through
+ * RNA) and the meshes and transforms of referenced objects.
+ *
+ * Memory used by cached results is shared by all objects and limited by
+ * #UserDef.modifier_cache_limit, results which do not fit are simply not cached.
+ */
+
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_hash_mm2a.h"
+#include "BLI_listbase.h"
+#include "BLI_math_base.h"
+#include "BLI_string.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_types.h"
+#include "DNA_userdef_types.h"
+
+#include "BKE_customdata.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+#include "BKE_modifier.h"
+
+#include "RNA_access.h"
+
+#include "atomic_ops.h"
+
+typedef struct ModifierStackCacheEntry {
+  struct ModifierStackCacheEntry *next, *prev;
+  /* Original modifier the result belongs to, only used for comparison. */
+  const ModifierData *md_orig;
+  ModifierStackKey key;
+  Mesh *mesh;
+  size_t mem_size;
+  /* Result was used or stored by the last evaluation. */
+  bool is_used;
+} ModifierStackCacheEntry;
+
+typedef struct ModifierStackCache {
+  ListBase entries;
+} ModifierStackCache;
+
+/* Memory used by cached results of all objects. */
+static size_t modifier_stack_cache_mem_in_use = 0;
+
+/* Depth up to which nested structs and collections of modifier settings are part of the key. */
+#define KEY_RNA_MAX_DEPTH 3
+
+/* -------------------------------------------------------------------- */
+/** \name Stack Keys
+ * \{ */
+
+typedef struct KeyHasher {
+  BLI_HashMurmur2A mm2[2];
+} KeyHasher;
+
+static void key_hasher_begin(KeyHasher *hasher, const ModifierStackKey *key)
+{
+  BLI_hash_mm2a_init(&hasher->mm2[0], key->hash[0]);
+  BLI_hash_mm2a_init(&hasher->mm2[1], key->hash[1]);
+}
+
+static void key_hasher_add(KeyHasher *hasher, const void *data, size_t size)
+{
+  BLI_hash_mm2a_add(&hasher->mm2[0], data, size);
+  BLI_hash_mm2a_add(&hasher->mm2[1], data, size);
+}
+
+static void key_hasher_add_int(KeyHasher *hasher, int value)
+{
+  BLI_hash_mm2a_add_int(&hasher->mm2[0], value);
+  BLI_hash_mm2a_add_int(&hasher->mm2[1], value);
+}
+
+static void key_hasher_add_string(KeyHasher *hasher, const char *str)
+{
+  key_hasher_add(hasher, str, strlen(str) + 1);
+}
+
+static void key_hasher_end(KeyHasher *hasher, ModifierStackKey *key)
+{
+  key->hash[0] = BLI_hash_mm2a_end(&hasher->mm2[0]);
+  key->hash[1] = BLI_hash_mm2a_end(&hasher->mm2[1]);
+}
+
+static bool key_hash_customdata(KeyHasher *hasher, const CustomData *data, const int totelem)
+{
+  key_hasher_add_int(hasher, totelem);
+  key_hasher_add_int(hasher, data->totlayer);
+
+  for (int i = 0; i < data->totlayer; i++) {
+    const CustomDataLayer *layer = &data->layers[i];
+
+    /* Layers that point to further data which is not worth hashing. */
+    if (ELEM(layer->type, CD_MDISPS, CD_GRID_PAINT_MASK)) {
+      return false;
+    }
+
+    key_hasher_add_int(hasher, layer->type);
+    key_hasher_add_int(hasher, layer->active);
+    key_hasher_add_int(hasher, layer->active_rnd);
+    key_hasher_add_string(hasher, layer->name);
+
+    if (layer->data == NULL) {
+      continue;
+    }
+
+    if (layer->type == CD_MDEFORMVERT) {
+      const MDeformVert *dvert = layer->data;
+      for (int j = 0; j < totelem; j++) {
+        key_hasher_add_int(hasher, dvert[j].totweight);
+        if (dvert[j].dw) {
+          key_hasher_add(hasher, dvert[j].dw, sizeof(*dvert[j].dw) * dvert[j].totweight);
+        }
+      }
+    }
+    else {
+      key_hasher_add(hasher, layer->data, (size_t)CustomData_sizeof(layer->type) * totelem);
+    }
+  }
+
+  return true;
+}
+
+static bool key_hash_mesh(KeyHasher *hasher, const Mesh *mesh)
+{
+  return (key_hash_customdata(hasher, &mesh->vdata, mesh->totvert) &&
+          key_hash_customdata(hasher, &mesh->edata, mesh->totedge) &&
+          key_hash_customdata(hasher, &mesh->ldata, mesh->totloop) &&
+          key_hash_customdata(hasher, &mesh->pdata, mesh->totpoly));
+}
+
+static void key_hash_rna_struct(KeyHasher *hasher, PointerRNA *ptr, const int depth);
+
+static void key_hash_rna_property(KeyHasher *hasher,
+                                  PointerRNA *ptr,
+                                  PropertyRNA *prop,
+                                  const int depth)
+{
+  const PropertyType type = RNA_property_type(prop);
+  const int len = RNA_property_array_length(ptr, prop);
+
+  key_hasher_add_string(hasher, RNA_property_identifier(prop));
+
+  switch (type) {
+    case PROP_BOOLEAN:
+    case PROP_INT:
+    case PROP_FLOAT: {
+      if (len == 0) {
+        if (type == PROP_BOOLEAN) {
+          key_hasher_add_int(hasher, RNA_property_boolean_get(ptr, prop));
+        }
+        else if (type == PROP_INT) {
+          key_hasher_add_int(hasher, RNA_property_int_get(ptr, prop));
+        }
+        else {
+          const float value = RNA_property_float_get(ptr, prop);
+          key_hasher_add(hasher, &value, sizeof(value));
+        }
+        break;
+      }
+
+      /* Large enough for any of the value types. */
+      int fixed_values[64];
+      void *values = (len <= (int)ARRAY_SIZE(fixed_values)) ?
+                         fixed_values :
+                         MEM_mallocN(sizeof(int) * (size_t)len, __func__);
+      size_t size;
+      if (type == PROP_BOOLEAN) {
+        RNA_property_boolean_get_array(ptr, prop, values);
+        size = sizeof(bool) * (size_t)len;
+      }
+      else if (type == PROP_INT) {
+        RNA_property_int_get_array(ptr, prop, values);
+        size = sizeof(int) * (size_t)len;
+      }
+      else {
+        RNA_property_float_get_array(ptr, prop, values);
+        size = sizeof(float) * (size_t)len;
+      }
+      key_hasher_add(hasher, values, size);
+      if (values != fixed_values) {
+        MEM_freeN(values);
+      }
+      break;
+    }
+    case PROP_ENUM:
+      key_hasher_add_int(hasher, RNA_property_enum_get(ptr, prop));
+      break;
+    case PROP_STRING: {
+      char fixed_buf[256];
+      int str_len;
+      char *str = RNA_property_string_get_alloc(
+          ptr, prop, fixed_buf, sizeof(fixed_buf), &str_len);
+      key_hasher_add(hasher, str, (size_t)str_len);
+      if (str != fixed_buf) {
+        MEM_freeN(str);
+      }
+      break;
+    }
+    case PROP_POINTER: {
+      PointerRNA value = RNA_property_pointer_get(ptr, prop);
+      if (value.data == NULL || RNA_struct_is_ID(value.type)) {
+        /* Data of referenced objects is added separately, see #key_add_id_link. */
+        key_hasher_add(hasher, &value.data, sizeof(value.data));
+      }
+      else if (depth > 0) {
+        key_hash_rna_struct(hasher, &value, depth - 1);
+      }
+      break;
+    }
+    case PROP_COLLECTION: {
+      key_hasher_add_int(hasher, RNA_property_collection_length(ptr, prop));
+      if (depth > 0) {
+        RNA_PROP_BEGIN (ptr, itemptr, prop) {
+          key_hash_rna_struct(hasher, &itemptr, depth - 1);
+        }
+        RNA_PROP_END;
+      }
+      break;
+    }
+  }
+}
+
+static void key_hash_rna_struct(KeyHasher *hasher, PointerRNA *ptr, const int depth)
+{
+  RNA_STRUCT_BEGIN_SKIP_RNA_TYPE (ptr, prop) {
+    const char *identifier = RNA_property_identifier(prop);
+    /* Settings which have no influence on the result. */
+    if (STR_ELEM(identifier, "name", "show_expanded", "use_cache_result")) {
+      continue;
+    }
+    key_hash_rna_property(hasher, ptr, prop, depth);
+  }
+  RNA_STRUCT_END;
+}
+
+typedef struct KeyIDLinkData {
+  KeyHasher *hasher;
+  bool is_valid;
+} KeyIDLinkData;
+
+static void key_add_id_link(void *userData, Object *ob, ID **idpoin, int UNUSED(cb_flag))
+{
+  KeyIDLinkData *data = userData;
+  ID *id = *idpoin;
+
+  if (id == NULL || !data->is_valid) {
+    return;
+  }
+
+  /* Only data of mesh objects and transforms of empties can be part of the key. */
+  if (GS(id->name) != ID_OB || !ELEM(((Object *)id)->type, OB_MESH, OB_EMPTY)) {
+    data->is_valid = false;
+    return;
+  }
+
+  Object *ob_ref = (Object *)id;
+  key_hasher_add(data->hasher, ob->obmat, sizeof(ob->obmat));
+  key_hasher_add(data->hasher, ob_ref->obmat, sizeof(ob_ref->obmat));
+
+  if (ob_ref->type == OB_MESH) {
+    Mesh *mesh_ref = BKE_modifier_get_evaluated_mesh_from_evaluated_object(ob_ref, false);
+    if (mesh_ref == NULL || !key_hash_mesh(data->hasher, mesh_ref)) {
+      data->is_valid = false;
+    }
+  }
+}
+
+/**
+ * Initialize the key from the input of the modifier stack.
+ *
+ * \param vert_coords: Deformed coordinates of the mesh, may be NULL.
+ */
+void BKE_modifier_stack_key_init(ModifierStackKey *key,
+                                 Object *ob,
+                                 const Mesh *mesh,
+                                 const float (*vert_coords)[3])
+{
+  KeyHasher hasher;
+
+  key->hash[0] = 0x1c8a3f47;
+  key->hash[1] = 0x6e2b90d5;
+
+  key_hasher_begin(&hasher, key);
+
+  key->is_valid = key_hash_mesh(&hasher, mesh);
+  if (vert_coords) {
+    key_hasher_add(&hasher, vert_coords, sizeof(*vert_coords) * (size_t)mesh->totvert);
+  }
+
+  /* Modifiers refer to vertex groups and materials of the object by name and index. */
+  LISTBASE_FOREACH (bDeformGroup *, dg, &ob->defbase) {
+    key_hasher_add_string(&hasher, dg->name);
+  }
+  key_hasher_add_int(&hasher, ob->totcol);
+
+  key_hasher_end(&hasher, key);
+}
+
+/**
+ * Extend the key with a modifier evaluated on top of the stack.
+ *
+ * Once a modifier can not be part of a key, for example because it depends on time or on data
+ * of other objects which is not hashed, the key stays invalid for the rest of the stack.
+ */
+void BKE_modifier_stack_key_add(ModifierStackKey *key,
+                                Object *ob,
+                                ModifierData *md,
+                                const CustomData_MeshMasks *mask)
+{
+  const ModifierTypeInfo *mti = modifierType_getInfo(md->type);
+
+  if (!key->is_valid) {
+    return;
+  }
+
+  if ((mti->dependsOnTime && mti->dependsOnTime(md)) ||
+      ELEM(md->type,
+           eModifierType_DynamicPaint,
+           eModifierType_Multires,
+           eModifierType_ParticleSystem,
+           eModifierType_ParticleInstance)) {
+    key->is_valid = false;
+    return;
+  }
+
+  KeyHasher hasher;
+  key_hasher_begin(&hasher, key);
+
+  key_hasher_add_int(&hasher, md->type);
+  key_hasher_add_int(&hasher, md->mode & ~eModifierMode_Expanded);
+  key_hasher_add_int(&hasher, md->flag & ~eModifierFlag_CacheResult);
+  /* Layers which are copied along depend on modifiers further down the stack. */
+  key_hasher_add(&hasher, mask, sizeof(*mask));
+
+  PointerRNA ptr;
+  RNA_pointer_create(&ob->id, &RNA_Modifier, md, &ptr);
+  key_hash_rna_struct(&hasher, &ptr, KEY_RNA_MAX_DEPTH);
+
+  KeyIDLinkData data = {&hasher, true};
+  if (mti->foreachIDLink) {
+    mti->foreachIDLink(md, ob, key_add_id_link, &data);
+  }
+  else if (mti->foreachObjectLink) {
+    /* Signatures are compatible, see #ObjectWalkFunc. */
+    mti->foreachObjectLink(md, ob, (ObjectWalkFunc)key_add_id_link, &data);
+  }
+
+  key_hasher_end(&hasher, key);
+  key->is_valid = data.is_valid;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Cached Results
+ * \{ */
+
+static size_t mesh_memory_size(const Mesh *mesh)
+{
+  const CustomData *datas[4] = {&mesh->vdata, &mesh->edata, &mesh->ldata, &mesh->pdata};
+  const int totelems[4] = {mesh->totvert, mesh->totedge, mesh->totloop, mesh->totpoly};
+  size_t size = sizeof(Mesh);
+
+  for (int i = 0; i < (int)ARRAY_SIZE(datas); i++) {
+    for (int j = 0; j < datas[i]->totlayer; j++) {
+      const CustomDataLayer *layer = &datas[i]->layers[j];
+      size += (size_t)CustomData_sizeof(layer->type) * totelems[i];
+
+      if (layer->type == CD_MDEFORMVERT && layer->data) {
+        const MDeformVert *dvert = layer->data;
+        for (int k = 0; k < totelems[i]; k++) {
+          size += sizeof(*dvert[k].dw) * dvert[k].totweight;
+        }
+      }
+    }
+  }
+
+  return size;
+}
+
+static ModifierStackCacheEntry *stack_cache_entry_find(Object *ob, const ModifierData *md_orig)
+{
+  ModifierStackCache *cache = ob->runtime.modifier_stack_cache;
+  if (cache == NULL) {
+    return NULL;
+  }
+  LISTBASE_FOREACH (ModifierStackCacheEntry *, entry, &cache->entries) {
+    if (entry->md_orig == md_orig) {
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+static void stack_cache_entry_free(ModifierStackCache *cache, ModifierStackCacheEntry *entry)
+{
+  atomic_sub_and_fetch_z(&modifier_stack_cache_mem_in_use, entry->mem_size);
+  BKE_id_free(NULL, entry->mesh);
+  BLI_freelinkN(&cache->entries, entry);
+}
+
+/**
+ * Get the cached result of a modifier when it was evaluated with the same key, the returned mesh
+ * is owned by the cache and has to be copied before use.
+ */
+Mesh *BKE_modifier_stack_cache_lookup(Object *ob, ModifierData *md, const ModifierStackKey *key)
+{
+  if (!key->is_valid) {
+    return NULL;
+  }
+
+  ModifierStackCacheEntry *entry = stack_cache_entry_find(ob, modifier_get_original(md));
+  if (entry == NULL || memcmp(entry->key.hash, key->hash, sizeof(key->hash)) != 0) {
+    return NULL;
+  }
+
+  entry->is_used = true;
+  return entry->mesh;
+}
+
+/**
+ * Store a copy of the result of a modifier, replacing any result it had before.
+ * Nothing is stored when the memory limit would be exceeded.
+ */
+void BKE_modifier_stack_cache_store(Object *ob,
+                                    ModifierData *md,
+                                    const ModifierStackKey *key,
+                                    Mesh *mesh)
+{
+  const ModifierData *md_orig = modifier_get_original(md);
+  ModifierStackCache *cache = ob->runtime.modifier_stack_cache;
+
+  if (!key->is_valid) {
+    return;
+  }
+
+  ModifierStackCacheEntry *entry = stack_cache_entry_find(ob, md_orig);
+  if (entry) {
+    stack_cache_entry_free(cache, entry);
+  }
+
+  const size_t mem_size = mesh_memory_size(mesh);
+  const size_t mem_limit = (size_t)max_ii(U.modifier_cache_limit, 0) * 1024 * 1024;
+  if (atomic_add_and_fetch_z(&modifier_stack_cache_mem_in_use, mem_size) > mem_limit) {
+    atomic_sub_and_fetch_z(&modifier_stack_cache_mem_in_use, mem_size);
+    return;
+  }
+
+  if (cache == NULL) {
+    cache = ob->runtime.modifier_stack_cache = MEM_callocN(sizeof(*cache), __func__);
+  }
+
+  entry = MEM_callocN(sizeof(*entry), __func__);
+  entry->md_orig = md_orig;
+  entry->key = *key;
+  entry->mesh = BKE_mesh_copy_for_eval(mesh, false);
+  entry->mem_size = mem_size;
+  entry->is_used = true;
+  BLI_addtail(&cache->entries, entry);
+}
+
+/**
+ * Free results which were neither used nor stored since the last call, which happens when the
+ * stack before a modifier changed or the modifier stopped caching its result.
+ */
+void BKE_modifier_stack_cache_free_unused(Object *ob)
+{
+  ModifierStackCache *cache = ob->runtime.modifier_stack_cache;
+  if (cache == NULL) {
+    return;
+  }
+
+  LISTBASE_FOREACH_MUTABLE (ModifierStackCacheEntry *, entry, &cache->entries) {
+    if (entry->is_used) {
+      entry->is_used = false;
+    }
+    else {
+      stack_cache_entry_free(cache, entry);
+    }
+  }
+
+  if (BLI_listbase_is_empty(&cache->entries)) {
+    MEM_freeN(cache);
+    ob->runtime.modifier_stack_cache = NULL;
+  }
+}
+
+void BKE_modifier_stack_cache_free(Object *ob)
+{
+  ModifierStackCache *cache = ob->runtime.modifier_stack_cache;
+  if (cache == NULL) {
+    return;
+  }
+
+  LISTBASE_FOREACH_MUTABLE (ModifierStackCacheEntry *, entry, &cache->entries) {
+    stack_cache_entry_free(cache, entry);
+  }
+  MEM_freeN(cache);
+  ob->runtime.modifier_stack_cache = NULL;
+}
+
+/* Memory used by cached results of all objects, in bytes. */
+size_t BKE_modifier_stack_cache_memory_in_use(void)
+{
+  return atomic_add_and_fetch_z(&modifier_stack_cache_mem_in_use, 0);
+}
+
+/** \} */
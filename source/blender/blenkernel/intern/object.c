@@ -320,6 +320,9 @@ static void object_free_data(ID *id)
     ob->runtime.curve_cache = NULL;
   }
 
+  /* Free cached results of the modifier stack. */
+  BKE_modifier_stack_cache_free(ob);
+
   BKE_previewimg_free(&ob->preview);
 }
 
@@ -3964,6 +3967,7 @@ void BKE_object_runtime_reset_on_copy(Object *object, const int UNUSED(flag))
   runtime->mesh_deform_eval = NULL;
   runtime->curve_cache = NULL;
   runtime->gpencil_cache = NULL;
+  runtime->modifier_stack_cache = NULL;
 }
 
 /*
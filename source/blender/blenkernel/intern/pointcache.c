@@ -4553,6 +4553,18 @@ void BKE_ptcache_update_info(PTCacheID *pid)
                  formatted_mem);
   }
 
+  if (pid->type == PTCACHE_TYPE_CLOTH) {
+    ClothModifierData *clmd = pid->calldata;
+    /* Solver results are copied to the original modifier, see clothModifier_do(). */
+    if (clmd->solver_result && clmd->solver_result->avg_collision_time > 0.0f) {
+      const size_t mem_info_len = strlen(mem_info);
+      BLI_snprintf(mem_info + mem_info_len,
+                   sizeof(mem_info) - mem_info_len,
+                   TIP_(", collisions %.1f ms per step"),
+                   clmd->solver_result->avg_collision_time * 1000.0f);
+    }
+  }
+
   if (cache->flag & PTCACHE_OUTDATED) {
     BLI_snprintf(cache->info, sizeof(cache->info), TIP_("%s, cache is outdated!"), mem_info);
   }
@@ -35,6 +35,7 @@
 
 #include "BLI_math.h"
 #include "BLI_listbase.h"
+#include "BLI_threads.h"
 
 #ifdef WITH_BULLET
 #  include "RBI_api.h"
@@ -1558,6 +1559,18 @@ static void rigidbody_update_sim_world(Scene *scene, RigidBodyWorld *rbw)
   /* update gravity, since this RNA setting is not part of RigidBody settings */
   RB_dworld_set_gravity(rbw->shared->physics_world, adj_gravity);
 
+  /* threading, resolving the automatic thread count here so it follows the system */
+  if (rbw->threading_mode == RBW_THREADING_SINGLE) {
+    RB_dworld_set_threading(rbw->shared->physics_world, 1, false);
+  }
+  else {
+    const int num_threads = (rbw->num_threads > 0) ? rbw->num_threads :
+                                                      BLI_system_thread_count();
+    RB_dworld_set_threading(rbw->shared->physics_world,
+                            num_threads,
+                            rbw->threading_mode == RBW_THREADING_DETERMINISTIC);
+  }
+
   /* update object array in case there are changes */
   rigidbody_update_ob_array(rbw);
 }
@@ -58,8 +58,11 @@
 #include "BLI_math.h"
 #include "BLI_utildefines.h"
 #include "BLI_listbase.h"
+#include "BLI_buffer.h"
 #include "BLI_ghash.h"
-#include "BLI_threads.h"
+#include "BLI_kdopbvh.h"
+#include "BLI_sort_utils.h"
+#include "BLI_task.h"
 
 #include "BKE_collection.h"
 #include "BKE_collision.h"
@@ -121,6 +124,14 @@ typedef struct SBScratch {
   int totface;
   float aabbmin[3], aabbmax[3];
   ReferenceState Ref;
+  /* Structure of arrays copy of the point state, read by the force loops. */
+  float (*pos)[3];
+  float (*vec)[3];
+  float *colball;
+  int totpoint;
+  /* Force of each spring acting on its first point, the second point gets the opposite. */
+  float (*spring_force)[3];
+  int totspring;
 } SBScratch;
 
 typedef struct SB_thread_context {
@@ -128,14 +139,10 @@ typedef struct SB_thread_context {
   Object *ob;
   float forcetime;
   float timenow;
-  int ifirst;
-  int ilast;
   ListBase *effectors;
   int do_deflector;
   float fieldfactor;
   float windfactor;
-  int nr;
-  int tot;
 } SB_thread_context;
 
 #define MID_PRESERVE 1
@@ -271,11 +278,62 @@ typedef struct ccd_Mesh {
   const MVertTri *tri;
   int safety;
   ccdf_minmax *mima;
+  /* Tree over the triangle bounds in mima. */
+  BVHTree *bvhtree;
   /* Axis Aligned Bounding Box AABB */
   float bbmin[3];
   float bbmax[3];
 } ccd_Mesh;
 
+/* Small radius for point queries, the tree only reports bounds strictly within range. */
+#define CCD_POINT_QUERY_RADIUS 1e-6f
+
+static void ccd_mesh_bvhtree_update(ccd_Mesh *pccd_M, const bool is_new)
+{
+  const ccdf_minmax *mima = pccd_M->mima;
+
+  for (int i = 0; i < pccd_M->tri_num; i++, mima++) {
+    const float co[2][3] = {{mima->minx, mima->miny, mima->minz},
+                            {mima->maxx, mima->maxy, mima->maxz}};
+    if (is_new) {
+      BLI_bvhtree_insert(pccd_M->bvhtree, i, co[0], 2);
+    }
+    else {
+      BLI_bvhtree_update_node(pccd_M->bvhtree, i, co[0], NULL, 2);
+    }
+  }
+
+  if (is_new) {
+    BLI_bvhtree_balance(pccd_M->bvhtree);
+  }
+  else {
+    BLI_bvhtree_update_tree(pccd_M->bvhtree);
+  }
+}
+
+static void ccd_mesh_find_tris_cb(void *userdata,
+                                  int index,
+                                  const float UNUSED(co[3]),
+                                  float UNUSED(dist_sq))
+{
+  BLI_Buffer *tris = userdata;
+  BLI_buffer_append(tris, int, index);
+}
+
+/* Collect the triangles whose bounds may be within radius of co, in ascending index order so
+ * forces are accumulated in the same order as a linear scan over all triangles. */
+static void ccd_mesh_find_tris(const ccd_Mesh *ccdm,
+                               const float co[3],
+                               const float radius,
+                               BLI_Buffer *r_tris)
+{
+  BLI_buffer_clear(r_tris);
+  BLI_bvhtree_range_query(ccdm->bvhtree, co, radius, ccd_mesh_find_tris_cb, r_tris);
+  if (r_tris->count > 1) {
+    qsort(r_tris->data, r_tris->count, sizeof(int), BLI_sortutil_cmp_int);
+  }
+}
+
 static ccd_Mesh *ccd_mesh_make(Object *ob)
 {
   CollisionModifierData *cmd;
@@ -361,6 +419,9 @@ static ccd_Mesh *ccd_mesh_make(Object *ob)
     mima->maxz = max_ff(mima->maxz, v[2] + hull);
   }
 
+  pccd_M->bvhtree = BLI_bvhtree_new(pccd_M->tri_num, 0.0f, 4, 6);
+  ccd_mesh_bvhtree_update(pccd_M, true);
+
   return pccd_M;
 }
 static void ccd_mesh_update(Object *ob, ccd_Mesh *pccd_M)
@@ -481,7 +542,8 @@ static void ccd_mesh_update(Object *ob, ccd_Mesh *pccd_M)
     mima->maxy = max_ff(mima->maxy, v[1] + hull);
     mima->maxz = max_ff(mima->maxz, v[2] + hull);
   }
-  return;
+
+  ccd_mesh_bvhtree_update(pccd_M, false);
 }
 
 static void ccd_mesh_free(ccd_Mesh *ccdm)
@@ -494,6 +556,7 @@ static void ccd_mesh_free(ccd_Mesh *ccdm)
       MEM_freeN((void *)ccdm->mprevvert);
     }
     MEM_freeN(ccdm->mima);
+    BLI_bvhtree_free(ccdm->bvhtree);
     MEM_freeN(ccdm);
     ccdm = NULL;
   }
@@ -911,6 +974,10 @@ static void free_scratch(SoftBody *sb)
     if (sb->scratch->Ref.ivert) {
       MEM_freeN(sb->scratch->Ref.ivert);
     }
+    MEM_SAFE_FREE(sb->scratch->pos);
+    MEM_SAFE_FREE(sb->scratch->vec);
+    MEM_SAFE_FREE(sb->scratch->colball);
+    MEM_SAFE_FREE(sb->scratch->spring_force);
     MEM_freeN(sb->scratch);
     sb->scratch = NULL;
   }
@@ -1336,12 +1403,19 @@ static int sb_detect_edge_collisionCached(float edge_v1[3],
   GHash *hash;
   GHashIterator *ihash;
   float nv1[3], nv2[3], nv3[3], edge1[3], edge2[3], d_nvect[3], aabbmin[3], aabbmax[3];
+  float center[3], radius;
   float t, el;
-  int a, deflected = 0;
+  int deflected = 0;
+  BLI_buffer_declare_static(int, tris, BLI_BUFFER_NOP, 64);
 
+  INIT_MINMAX(aabbmin, aabbmax);
   minmax_v3v3_v3(aabbmin, aabbmax, edge_v1);
   minmax_v3v3_v3(aabbmin, aabbmax, edge_v2);
 
+  /* Sphere around the edge bounds, any triangle bounds overlapping them are within range. */
+  mid_v3_v3v3(center, aabbmin, aabbmax);
+  radius = 0.5f * len_v3v3(aabbmin, aabbmax) * 1.001f + CCD_POINT_QUERY_RADIUS;
+
   el = len_v3v3(edge_v1, edge_v2);
 
   hash = vertexowner->soft->scratch->colliderhash;
@@ -1361,9 +1435,6 @@ static int sb_detect_edge_collisionCached(float edge_v1[3],
         if (ccdm) {
           mvert = ccdm->mvert;
           mprevvert = ccdm->mprevvert;
-          vt = ccdm->tri;
-          mima = ccdm->mima;
-          a = ccdm->tri_num;
 
           if ((aabbmax[0] < ccdm->bbmin[0]) || (aabbmax[1] < ccdm->bbmin[1]) ||
               (aabbmax[2] < ccdm->bbmin[2]) || (aabbmin[0] > ccdm->bbmax[0]) ||
@@ -1380,13 +1451,16 @@ static int sb_detect_edge_collisionCached(float edge_v1[3],
           continue;
         }
 
-        /* use mesh*/
-        while (a--) {
+        /* use mesh, only the triangles near the edge */
+        ccd_mesh_find_tris(ccdm, center, radius, &tris);
+        for (int i = 0; i < tris.count; i++) {
+          const int tri_index = BLI_buffer_at(&tris, int, i);
+          mima = &ccdm->mima[tri_index];
+          vt = &ccdm->tri[tri_index];
+
           if ((aabbmax[0] < mima->minx) || (aabbmin[0] > mima->maxx) ||
               (aabbmax[1] < mima->miny) || (aabbmin[1] > mima->maxy) ||
               (aabbmax[2] < mima->minz) || (aabbmin[2] > mima->maxz)) {
-            mima++;
-            vt++;
             continue;
           }
 
@@ -1426,163 +1500,116 @@ static int sb_detect_edge_collisionCached(float edge_v1[3],
             *damp = ob->pd->pdef_sbdamp;
             deflected = 2;
           }
-
-          mima++;
-          vt++;
-        } /* while a */
+        } /* for tris */
       }   /* if (ob->pd && ob->pd->deflect) */
       BLI_ghashIterator_step(ihash);
     }
   } /* while () */
   BLI_ghashIterator_free(ihash);
+  BLI_buffer_free(&tris);
   return deflected;
 }
 
 static void _scan_for_ext_spring_forces(
-    Scene *scene, Object *ob, float timenow, int ifirst, int ilast, struct ListBase *effectors)
+    Scene *scene, Object *ob, float timenow, int a, struct ListBase *effectors)
 {
   SoftBody *sb = ob->soft;
-  int a;
+  BodySpring *bs = &sb->bspring[a];
   float damp;
   float feedback[3];
 
-  if (sb && sb->totspring) {
-    for (a = ifirst; a < ilast; a++) {
-      BodySpring *bs = &sb->bspring[a];
-      bs->ext_force[0] = bs->ext_force[1] = bs->ext_force[2] = 0.0f;
-      feedback[0] = feedback[1] = feedback[2] = 0.0f;
-      bs->flag &= ~BSF_INTERSECT;
+  bs->ext_force[0] = bs->ext_force[1] = bs->ext_force[2] = 0.0f;
+  feedback[0] = feedback[1] = feedback[2] = 0.0f;
+  bs->flag &= ~BSF_INTERSECT;
+
+  if (bs->springtype == SB_EDGE) {
+    /* +++ springs colliding */
+    if (ob->softflag & OB_SB_EDGECOLL) {
+      if (sb_detect_edge_collisionCached(
+              sb->bpoint[bs->v1].pos, sb->bpoint[bs->v2].pos, &damp, feedback, ob, timenow)) {
+        add_v3_v3(bs->ext_force, feedback);
+        bs->flag |= BSF_INTERSECT;
+        // bs->cf=damp;
+        bs->cf = sb->choke * 0.01f;
+      }
+    }
+    /* ---- springs colliding */
 
-      if (bs->springtype == SB_EDGE) {
-        /* +++ springs colliding */
-        if (ob->softflag & OB_SB_EDGECOLL) {
-          if (sb_detect_edge_collisionCached(
-                  sb->bpoint[bs->v1].pos, sb->bpoint[bs->v2].pos, &damp, feedback, ob, timenow)) {
-            add_v3_v3(bs->ext_force, feedback);
-            bs->flag |= BSF_INTERSECT;
-            // bs->cf=damp;
-            bs->cf = sb->choke * 0.01f;
-          }
-        }
-        /* ---- springs colliding */
-
-        /* +++ springs seeing wind ... n stuff depending on their orientation*/
-        /* note we don't use sb->mediafrict but use sb->aeroedge for magnitude of effect*/
-        if (sb->aeroedge) {
-          float vel[3], sp[3], pr[3], force[3];
-          float f, windfactor = 0.25f;
-          /*see if we have wind*/
-          if (effectors) {
-            EffectedPoint epoint;
-            float speed[3] = {0.0f, 0.0f, 0.0f};
-            float pos[3];
-            mid_v3_v3v3(pos, sb->bpoint[bs->v1].pos, sb->bpoint[bs->v2].pos);
-            mid_v3_v3v3(vel, sb->bpoint[bs->v1].vec, sb->bpoint[bs->v2].vec);
-            pd_point_from_soft(scene, pos, vel, -1, &epoint);
-            BKE_effectors_apply(effectors, NULL, sb->effector_weights, &epoint, force, speed);
-
-            mul_v3_fl(speed, windfactor);
-            add_v3_v3(vel, speed);
-          }
-          /* media in rest */
-          else {
-            add_v3_v3v3(vel, sb->bpoint[bs->v1].vec, sb->bpoint[bs->v2].vec);
-          }
-          f = normalize_v3(vel);
-          f = -0.0001f * f * f * sb->aeroedge;
-          /* (todo) add a nice angle dependent function done for now BUT */
-          /* still there could be some nice drag/lift function, but who needs it */
-
-          sub_v3_v3v3(sp, sb->bpoint[bs->v1].pos, sb->bpoint[bs->v2].pos);
-          project_v3_v3v3(pr, vel, sp);
-          sub_v3_v3(vel, pr);
-          normalize_v3(vel);
-          if (ob->softflag & OB_SB_AERO_ANGLE) {
-            normalize_v3(sp);
-            madd_v3_v3fl(bs->ext_force, vel, f * (1.0f - fabsf(dot_v3v3(vel, sp))));
-          }
-          else {
-            madd_v3_v3fl(bs->ext_force, vel, f);  // to keep compatible with 2.45 release files
-          }
-        }
-        /* --- springs seeing wind */
+    /* +++ springs seeing wind ... n stuff depending on their orientation*/
+    /* note we don't use sb->mediafrict but use sb->aeroedge for magnitude of effect*/
+    if (sb->aeroedge) {
+      float vel[3], sp[3], pr[3], force[3];
+      float f, windfactor = 0.25f;
+      /*see if we have wind*/
+      if (effectors) {
+        EffectedPoint epoint;
+        float speed[3] = {0.0f, 0.0f, 0.0f};
+        float pos[3];
+        mid_v3_v3v3(pos, sb->bpoint[bs->v1].pos, sb->bpoint[bs->v2].pos);
+        mid_v3_v3v3(vel, sb->bpoint[bs->v1].vec, sb->bpoint[bs->v2].vec);
+        pd_point_from_soft(scene, pos, vel, -1, &epoint);
+        BKE_effectors_apply(effectors, NULL, sb->effector_weights, &epoint, force, speed);
+
+        mul_v3_fl(speed, windfactor);
+        add_v3_v3(vel, speed);
+      }
+      /* media in rest */
+      else {
+        add_v3_v3v3(vel, sb->bpoint[bs->v1].vec, sb->bpoint[bs->v2].vec);
+      }
+      f = normalize_v3(vel);
+      f = -0.0001f * f * f * sb->aeroedge;
+      /* (todo) add a nice angle dependent function done for now BUT */
+      /* still there could be some nice drag/lift function, but who needs it */
+
+      sub_v3_v3v3(sp, sb->bpoint[bs->v1].pos, sb->bpoint[bs->v2].pos);
+      project_v3_v3v3(pr, vel, sp);
+      sub_v3_v3(vel, pr);
+      normalize_v3(vel);
+      if (ob->softflag & OB_SB_AERO_ANGLE) {
+        normalize_v3(sp);
+        madd_v3_v3fl(bs->ext_force, vel, f * (1.0f - fabsf(dot_v3v3(vel, sp))));
+      }
+      else {
+        madd_v3_v3fl(bs->ext_force, vel, f);  // to keep compatible with 2.45 release files
       }
     }
+    /* --- springs seeing wind */
   }
 }
 
-static void *exec_scan_for_ext_spring_forces(void *data)
+static void scan_for_ext_spring_forces_cb(void *__restrict userdata,
+                                          const int a,
+                                          const TaskParallelTLS *__restrict UNUSED(tls))
 {
-  SB_thread_context *pctx = (SB_thread_context *)data;
-  _scan_for_ext_spring_forces(
-      pctx->scene, pctx->ob, pctx->timenow, pctx->ifirst, pctx->ilast, pctx->effectors);
-  return NULL;
+  SB_thread_context *pctx = (SB_thread_context *)userdata;
+  _scan_for_ext_spring_forces(pctx->scene, pctx->ob, pctx->timenow, a, pctx->effectors);
 }
 
 static void sb_sfesf_threads_run(struct Depsgraph *depsgraph,
                                  Scene *scene,
                                  struct Object *ob,
-                                 float timenow,
-                                 int totsprings,
-                                 int *UNUSED(ptr_to_break_func(void)))
-{
-  ListBase threads;
-  SB_thread_context *sb_threads;
-  int i, totthread, left, dec;
-
-  /* wild guess .. may increase with better thread management 'above'
-   * or even be UI option sb->spawn_cf_threads_nopts */
-  int lowsprings = 100;
-
-  ListBase *effectors = BKE_effectors_create(depsgraph, ob, NULL, ob->soft->effector_weights);
-
-  /* figure the number of threads while preventing pretty pointless threading overhead */
-  totthread = BKE_scene_num_threads(scene);
-  /* what if we got zillions of CPUs running but less to spread*/
-  while ((totsprings / totthread < lowsprings) && (totthread > 1)) {
-    totthread--;
-  }
-
-  sb_threads = MEM_callocN(sizeof(SB_thread_context) * totthread, "SBSpringsThread");
-  memset(sb_threads, 0, sizeof(SB_thread_context) * totthread);
-  left = totsprings;
-  dec = totsprings / totthread + 1;
-  for (i = 0; i < totthread; i++) {
-    sb_threads[i].scene = scene;
-    sb_threads[i].ob = ob;
-    sb_threads[i].forcetime = 0.0;  // not used here
-    sb_threads[i].timenow = timenow;
-    sb_threads[i].ilast = left;
-    left = left - dec;
-    if (left > 0) {
-      sb_threads[i].ifirst = left;
-    }
-    else {
-      sb_threads[i].ifirst = 0;
-    }
-    sb_threads[i].effectors = effectors;
-    sb_threads[i].do_deflector = false;  // not used here
-    sb_threads[i].fieldfactor = 0.0f;    // not used here
-    sb_threads[i].windfactor = 0.0f;     // not used here
-    sb_threads[i].nr = i;
-    sb_threads[i].tot = totthread;
+                                 float timenow)
+{
+  SoftBody *sb = ob->soft;
+  SB_thread_context ctx = {NULL};
+
+  if (sb->totspring == 0) {
+    return;
   }
-  if (totthread > 1) {
-    BLI_threadpool_init(&threads, exec_scan_for_ext_spring_forces, totthread);
 
-    for (i = 0; i < totthread; i++) {
-      BLI_threadpool_insert(&threads, &sb_threads[i]);
-    }
+  ctx.scene = scene;
+  ctx.ob = ob;
+  ctx.timenow = timenow;
+  ctx.effectors = BKE_effectors_create(depsgraph, ob, NULL, sb->effector_weights);
 
-    BLI_threadpool_end(&threads);
-  }
-  else {
-    exec_scan_for_ext_spring_forces(&sb_threads[0]);
-  }
-  /* clean up */
-  MEM_freeN(sb_threads);
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  /* wild guess .. may increase with better thread management 'above' */
+  settings.min_iter_per_thread = 100;
+  BLI_task_parallel_range(0, sb->totspring, &ctx, scan_for_ext_spring_forces_cb, &settings);
 
-  BKE_effectors_free(effectors);
+  BKE_effectors_free(ctx.effectors);
 }
 
 /* --- the spring external section*/
@@ -1635,7 +1662,8 @@ static int sb_detect_vertex_collisionCached(float opco[3],
       mindistedge = 1000.0f, outerforceaccu[3], innerforceaccu[3], facedist,
       /* n_mag, */ /* UNUSED */ force_mag_norm, minx, miny, minz, maxx, maxy, maxz,
       innerfacethickness = -0.5f, outerfacethickness = 0.2f, ee = 5.0f, ff = 0.1f, fa = 1;
-  int a, deflected = 0, cavel = 0, ci = 0;
+  int deflected = 0, cavel = 0, ci = 0;
+  BLI_buffer_declare_static(int, tris, BLI_BUFFER_NOP, 64);
   /* init */
   *intrusion = 0.0f;
   hash = vertexowner->soft->scratch->colliderhash;
@@ -1658,9 +1686,6 @@ static int sb_detect_vertex_collisionCached(float opco[3],
         if (ccdm) {
           mvert = ccdm->mvert;
           mprevvert = ccdm->mprevvert;
-          vt = ccdm->tri;
-          mima = ccdm->mima;
-          a = ccdm->tri_num;
 
           minx = ccdm->bbmin[0];
           miny = ccdm->bbmin[1];
@@ -1692,12 +1717,15 @@ static int sb_detect_vertex_collisionCached(float opco[3],
         fa *= fa;
         fa = 1.0f / fa;
         avel[0] = avel[1] = avel[2] = 0.0f;
-        /* use mesh*/
-        while (a--) {
+        /* use mesh, only the triangles whose bounds contain the vertex */
+        ccd_mesh_find_tris(ccdm, opco, CCD_POINT_QUERY_RADIUS, &tris);
+        for (int i = 0; i < tris.count; i++) {
+          const int tri_index = BLI_buffer_at(&tris, int, i);
+          mima = &ccdm->mima[tri_index];
+          vt = &ccdm->tri[tri_index];
+
           if ((opco[0] < mima->minx) || (opco[0] > mima->maxx) || (opco[1] < mima->miny) ||
               (opco[1] > mima->maxy) || (opco[2] < mima->minz) || (opco[2] > mima->maxz)) {
-            mima++;
-            vt++;
             continue;
           }
 
@@ -1768,10 +1796,7 @@ static int sb_detect_vertex_collisionCached(float opco[3],
               ci++;
             }
           }
-
-          mima++;
-          vt++;
-        } /* while a */
+        } /* for tris */
       }   /* if (ob->pd && ob->pd->deflect) */
       BLI_ghashIterator_step(ihash);
     }
@@ -1797,6 +1822,7 @@ static int sb_detect_vertex_collisionCached(float opco[3],
   }
 
   BLI_ghashIterator_free(ihash);
+  BLI_buffer_free(&tris);
   if (cavel) {
     mul_v3_fl(avel, 1.0f / (float)cavel);
   }
@@ -1874,42 +1900,19 @@ static void dfdv_goal(int ia, int ic, float factor)
 }
 #endif /* if 0 */
 
-static void sb_spring_force(
-    Object *ob, int bpi, BodySpring *bs, float iks, float UNUSED(forcetime))
+/* Force of a spring acting on its first point, the second point gets the opposite force.
+ * Reads the point state from the scratch arrays. */
+static void sb_spring_force(Object *ob, const BodySpring *bs, float r_force[3])
 {
   SoftBody *sb = ob->soft; /* is supposed to be there */
-  BodyPoint *bp1, *bp2;
+  const float(*pos)[3] = sb->scratch->pos;
+  const float(*vec)[3] = sb->scratch->vec;
 
   float dir[3], dvel[3];
-  float distance, forcefactor, kd, absvel, projvel, kw;
-#if 0 /* UNUSED */
-  int ia, ic;
-#endif
-  /* prepare depending on which side of the spring we are on */
-  if (bpi == bs->v1) {
-    bp1 = &sb->bpoint[bs->v1];
-    bp2 = &sb->bpoint[bs->v2];
-#if 0 /* UNUSED */
-    ia = 3 * bs->v1;
-    ic = 3 * bs->v2;
-#endif
-  }
-  else if (bpi == bs->v2) {
-    bp1 = &sb->bpoint[bs->v2];
-    bp2 = &sb->bpoint[bs->v1];
-#if 0 /* UNUSED */
-    ia = 3 * bs->v2;
-    ic = 3 * bs->v1;
-#endif
-  }
-  else {
-    /* TODO make this debug option */
-    CLOG_WARN(&LOG, "bodypoint <bpi> is not attached to spring  <*bs>");
-    return;
-  }
+  float distance, forcefactor, kd, absvel, projvel, kw, iks;
 
   /* do bp1 <--> bp2 elastic */
-  sub_v3_v3v3(dir, bp1->pos, bp2->pos);
+  sub_v3_v3v3(dir, pos[bs->v1], pos[bs->v2]);
   distance = normalize_v3(dir);
   if (bs->len < distance) {
     iks = 1.0f / (1.0f - sb->inspring) - 1.0f; /* inner spring constants function */
@@ -1924,7 +1927,7 @@ static void sb_spring_force(
   else {
     forcefactor = iks;
   }
-  kw = (bp1->springweight + bp2->springweight) / 2.0f;
+  kw = (sb->bpoint[bs->v1].springweight + sb->bpoint[bs->v2].springweight) / 2.0f;
   kw = kw * kw;
   kw = kw * kw;
   switch (bs->springtype) {
@@ -1942,326 +1945,297 @@ static void sb_spring_force(
       break;
   }
 
-  madd_v3_v3fl(bp1->force, dir, (bs->len - distance) * forcefactor);
+  mul_v3_v3fl(r_force, dir, (bs->len - distance) * forcefactor);
 
   /* do bp1 <--> bp2 viscous */
-  sub_v3_v3v3(dvel, bp1->vec, bp2->vec);
+  sub_v3_v3v3(dvel, vec[bs->v1], vec[bs->v2]);
   kd = sb->infrict * sb_fric_force_scale(ob);
   absvel = normalize_v3(dvel);
   projvel = dot_v3v3(dir, dvel);
   kd *= absvel * projvel;
-  madd_v3_v3fl(bp1->force, dir, -kd);
+  madd_v3_v3fl(r_force, dir, -kd);
 }
 
-/* since this is definitely the most CPU consuming task here .. try to spread it */
-/* core function _softbody_calc_forces_slice_in_a_thread */
-/* result is int to be able to flag user break */
-static int _softbody_calc_forces_slice_in_a_thread(Scene *scene,
-                                                   Object *ob,
-                                                   float forcetime,
-                                                   float timenow,
-                                                   int ifirst,
-                                                   int ilast,
-                                                   int *UNUSED(ptr_to_break_func(void)),
-                                                   ListBase *effectors,
-                                                   int do_deflector,
-                                                   float fieldfactor,
-                                                   float windfactor)
-{
-  float iks;
-  int bb, do_selfcollision, do_springcollision, do_aero;
-  int number_of_points_here = ilast - ifirst;
-  SoftBody *sb = ob->soft; /* is supposed to be there */
-  BodyPoint *bp;
+/* Make sure the scratch arrays match the current point and spring count. */
+static void sb_scratch_ensure_arrays(SoftBody *sb)
+{
+  SBScratch *scratch = sb->scratch;
 
-  /* initialize */
-  if (sb) {
-    /* check conditions for various options */
-    /* +++ could be done on object level to squeeze out the last bits of it */
-    do_selfcollision = ((ob->softflag & OB_SB_EDGES) && (sb->bspring) &&
-                        (ob->softflag & OB_SB_SELF));
-    do_springcollision = do_deflector && (ob->softflag & OB_SB_EDGES) &&
-                         (ob->softflag & OB_SB_EDGECOLL);
-    do_aero = ((sb->aeroedge) && (ob->softflag & OB_SB_EDGES));
-    /* --- could be done on object level to squeeze out the last bits of it */
-  }
-  else {
-    CLOG_ERROR(&LOG, "expected a SB here");
-    return (999);
+  if (scratch->totpoint != sb->totpoint) {
+    MEM_SAFE_FREE(scratch->pos);
+    MEM_SAFE_FREE(scratch->vec);
+    MEM_SAFE_FREE(scratch->colball);
+    if (sb->totpoint) {
+      scratch->pos = MEM_malloc_arrayN(sb->totpoint, sizeof(*scratch->pos), "SBScratch pos");
+      scratch->vec = MEM_malloc_arrayN(sb->totpoint, sizeof(*scratch->vec), "SBScratch vec");
+      scratch->colball = MEM_malloc_arrayN(
+          sb->totpoint, sizeof(*scratch->colball), "SBScratch colball");
+    }
+    scratch->totpoint = sb->totpoint;
   }
 
-  /* debugerin */
-  if (sb->totpoint < ifirst) {
-    printf("Aye 998");
-    return (998);
+  if (scratch->totspring != sb->totspring) {
+    MEM_SAFE_FREE(scratch->spring_force);
+    if (sb->totspring) {
+      scratch->spring_force = MEM_malloc_arrayN(
+          sb->totspring, sizeof(*scratch->spring_force), "SBScratch spring_force");
+    }
+    scratch->totspring = sb->totspring;
   }
-  /* debugerin */
+}
 
-  bp = &sb->bpoint[ifirst];
-  for (bb = number_of_points_here; bb > 0; bb--, bp++) {
-    /* clear forces  accumulator */
-    bp->force[0] = bp->force[1] = bp->force[2] = 0.0;
-    /* naive ball self collision */
-    /* needs to be done if goal snaps or not */
-    if (do_selfcollision) {
-      int attached;
-      BodyPoint *obp;
-      BodySpring *bs;
-      int c, b;
-      float velcenter[3], dvel[3], def[3];
-      float distance;
-      float compare;
-      float bstune = sb->ballstiff;
-
-      /* Running in a slice we must not assume anything done with obp
-       * neither alter the data of obp. */
-      for (c = sb->totpoint, obp = sb->bpoint; c > 0; c--, obp++) {
-        compare = (obp->colball + bp->colball);
-        sub_v3_v3v3(def, bp->pos, obp->pos);
-        /* rather check the AABBoxes before ever calculating the real distance */
-        /* mathematically it is completely nuts, but performance is pretty much (3) times faster */
-        if ((ABS(def[0]) > compare) || (ABS(def[1]) > compare) || (ABS(def[2]) > compare)) {
-          continue;
-        }
-        distance = normalize_v3(def);
-        if (distance < compare) {
-          /* exclude body points attached with a spring */
-          attached = 0;
-          for (b = obp->nofsprings; b > 0; b--) {
-            bs = sb->bspring + obp->springs[b - 1];
-            if ((ilast - bb == bs->v2) || (ilast - bb == bs->v1)) {
-              attached = 1;
-              continue;
-            }
-          }
-          if (!attached) {
-            float f = bstune / (distance) + bstune / (compare * compare) * distance -
-                      2.0f * bstune / compare;
+static void sb_scratch_points_cb(void *__restrict userdata,
+                                 const int a,
+                                 const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  SoftBody *sb = (SoftBody *)userdata;
+  const BodyPoint *bp = &sb->bpoint[a];
+
+  copy_v3_v3(sb->scratch->pos[a], bp->pos);
+  copy_v3_v3(sb->scratch->vec[a], bp->vec);
+  sb->scratch->colball[a] = bp->colball;
+}
 
-            mid_v3_v3v3(velcenter, bp->vec, obp->vec);
-            sub_v3_v3v3(dvel, velcenter, bp->vec);
-            mul_v3_fl(dvel, _final_mass(ob, bp));
+static void sb_spring_force_cb(void *__restrict userdata,
+                               const int a,
+                               const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  Object *ob = (Object *)userdata;
+  SoftBody *sb = ob->soft;
 
-            madd_v3_v3fl(bp->force, def, f * (1.0f - sb->balldamp));
-            madd_v3_v3fl(bp->force, dvel, sb->balldamp);
-          }
-        }
+  sb_spring_force(ob, &sb->bspring[a], sb->scratch->spring_force[a]);
+}
+
+typedef struct SBCalcForcesTLS {
+  bool do_fuzzy;
+} SBCalcForcesTLS;
+
+/* since this is definitely the most CPU consuming task here .. try to spread it */
+static void softbody_calc_forces_point(SB_thread_context *pctx, const int a, SBCalcForcesTLS *tls)
+{
+  Scene *scene = pctx->scene;
+  Object *ob = pctx->ob;
+  SoftBody *sb = ob->soft; /* is supposed to be there */
+  BodyPoint *bp = &sb->bpoint[a];
+  const float forcetime = pctx->forcetime;
+  const int do_deflector = pctx->do_deflector;
+  int do_selfcollision, do_springcollision, do_aero;
+
+  /* check conditions for various options */
+  do_selfcollision = ((ob->softflag & OB_SB_EDGES) && (sb->bspring) &&
+                      (ob->softflag & OB_SB_SELF));
+  do_springcollision = do_deflector && (ob->softflag & OB_SB_EDGES) &&
+                       (ob->softflag & OB_SB_EDGECOLL);
+  do_aero = ((sb->aeroedge) && (ob->softflag & OB_SB_EDGES));
+
+  /* clear forces  accumulator */
+  bp->force[0] = bp->force[1] = bp->force[2] = 0.0;
+  /* naive ball self collision */
+  /* needs to be done if goal snaps or not */
+  if (do_selfcollision) {
+    const float(*pos)[3] = sb->scratch->pos;
+    const float(*vec)[3] = sb->scratch->vec;
+    const float *colball = sb->scratch->colball;
+    int attached;
+    BodyPoint *obp;
+    BodySpring *bs;
+    int c, b;
+    float velcenter[3], dvel[3], def[3];
+    float distance;
+    float compare;
+    float bstune = sb->ballstiff;
+
+    /* Running in parallel we must not assume anything done with obp
+     * neither alter the data of obp. */
+    for (c = 0; c < sb->totpoint; c++) {
+      compare = (colball[c] + colball[a]);
+      sub_v3_v3v3(def, pos[a], pos[c]);
+      /* rather check the AABBoxes before ever calculating the real distance */
+      /* mathematically it is completely nuts, but performance is pretty much (3) times faster */
+      if ((ABS(def[0]) > compare) || (ABS(def[1]) > compare) || (ABS(def[2]) > compare)) {
+        continue;
       }
-    }
-    /* naive ball self collision done */
-
-    if (_final_goal(ob, bp) < SOFTGOALSNAP) { /* omit this bp when it snaps */
-      float auxvect[3];
-      float velgoal[3];
-
-      /* do goal stuff */
-      if (ob->softflag & OB_SB_GOAL) {
-        /* true elastic goal */
-        float ks, kd;
-        sub_v3_v3v3(auxvect, bp->pos, bp->origT);
-        ks = 1.0f / (1.0f - _final_goal(ob, bp) * sb->goalspring) - 1.0f;
-        bp->force[0] += -ks * (auxvect[0]);
-        bp->force[1] += -ks * (auxvect[1]);
-        bp->force[2] += -ks * (auxvect[2]);
-
-        /* calculate damping forces generated by goals*/
-        sub_v3_v3v3(velgoal, bp->origS, bp->origE);
-        kd = sb->goalfrict * sb_fric_force_scale(ob);
-        add_v3_v3v3(auxvect, velgoal, bp->vec);
-
-        if (forcetime >
-            0.0f) { /* make sure friction does not become rocket motor on time reversal */
-          bp->force[0] -= kd * (auxvect[0]);
-          bp->force[1] -= kd * (auxvect[1]);
-          bp->force[2] -= kd * (auxvect[2]);
+      distance = normalize_v3(def);
+      if (distance < compare) {
+        /* exclude body points attached with a spring */
+        obp = &sb->bpoint[c];
+        attached = 0;
+        for (b = obp->nofsprings; b > 0; b--) {
+          bs = sb->bspring + obp->springs[b - 1];
+          if ((a == bs->v2) || (a == bs->v1)) {
+            attached = 1;
+            continue;
+          }
         }
-        else {
-          bp->force[0] -= kd * (velgoal[0] - bp->vec[0]);
-          bp->force[1] -= kd * (velgoal[1] - bp->vec[1]);
-          bp->force[2] -= kd * (velgoal[2] - bp->vec[2]);
+        if (!attached) {
+          float f = bstune / (distance) + bstune / (compare * compare) * distance -
+                    2.0f * bstune / compare;
+
+          mid_v3_v3v3(velcenter, vec[a], vec[c]);
+          sub_v3_v3v3(dvel, velcenter, vec[a]);
+          mul_v3_fl(dvel, _final_mass(ob, bp));
+
+          madd_v3_v3fl(bp->force, def, f * (1.0f - sb->balldamp));
+          madd_v3_v3fl(bp->force, dvel, sb->balldamp);
         }
       }
-      /* done goal stuff */
-
-      /* gravitation */
-      if (scene->physics_settings.flag & PHYS_GLOBAL_GRAVITY) {
-        float gravity[3];
-        copy_v3_v3(gravity, scene->physics_settings.gravity);
+    }
+  }
+  /* naive ball self collision done */
 
-        /* Individual mass of node here. */
-        mul_v3_fl(gravity,
-                  sb_grav_force_scale(ob) * _final_mass(ob, bp) *
-                      sb->effector_weights->global_gravity);
+  if (_final_goal(ob, bp) < SOFTGOALSNAP) { /* omit this bp when it snaps */
+    float auxvect[3];
+    float velgoal[3];
 
-        add_v3_v3(bp->force, gravity);
+    /* do goal stuff */
+    if (ob->softflag & OB_SB_GOAL) {
+      /* true elastic goal */
+      float ks, kd;
+      sub_v3_v3v3(auxvect, bp->pos, bp->origT);
+      ks = 1.0f / (1.0f - _final_goal(ob, bp) * sb->goalspring) - 1.0f;
+      bp->force[0] += -ks * (auxvect[0]);
+      bp->force[1] += -ks * (auxvect[1]);
+      bp->force[2] += -ks * (auxvect[2]);
+
+      /* calculate damping forces generated by goals*/
+      sub_v3_v3v3(velgoal, bp->origS, bp->origE);
+      kd = sb->goalfrict * sb_fric_force_scale(ob);
+      add_v3_v3v3(auxvect, velgoal, bp->vec);
+
+      if (forcetime >
+          0.0f) { /* make sure friction does not become rocket motor on time reversal */
+        bp->force[0] -= kd * (auxvect[0]);
+        bp->force[1] -= kd * (auxvect[1]);
+        bp->force[2] -= kd * (auxvect[2]);
+      }
+      else {
+        bp->force[0] -= kd * (velgoal[0] - bp->vec[0]);
+        bp->force[1] -= kd * (velgoal[1] - bp->vec[1]);
+        bp->force[2] -= kd * (velgoal[2] - bp->vec[2]);
       }
+    }
+    /* done goal stuff */
 
-      /* particle field & vortex */
-      if (effectors) {
-        EffectedPoint epoint;
-        float kd;
-        float force[3] = {0.0f, 0.0f, 0.0f};
-        float speed[3] = {0.0f, 0.0f, 0.0f};
+    /* gravitation */
+    if (scene->physics_settings.flag & PHYS_GLOBAL_GRAVITY) {
+      float gravity[3];
+      copy_v3_v3(gravity, scene->physics_settings.gravity);
 
-        /* just for calling function once */
-        float eval_sb_fric_force_scale = sb_fric_force_scale(ob);
+      /* Individual mass of node here. */
+      mul_v3_fl(gravity,
+                sb_grav_force_scale(ob) * _final_mass(ob, bp) *
+                    sb->effector_weights->global_gravity);
 
-        pd_point_from_soft(scene, bp->pos, bp->vec, sb->bpoint - bp, &epoint);
-        BKE_effectors_apply(effectors, NULL, sb->effector_weights, &epoint, force, speed);
+      add_v3_v3(bp->force, gravity);
+    }
 
-        /* apply forcefield*/
-        mul_v3_fl(force, fieldfactor * eval_sb_fric_force_scale);
-        add_v3_v3(bp->force, force);
+    /* particle field & vortex */
+    if (pctx->effectors) {
+      EffectedPoint epoint;
+      float kd;
+      float force[3] = {0.0f, 0.0f, 0.0f};
+      float speed[3] = {0.0f, 0.0f, 0.0f};
 
-        /* BP friction in moving media */
-        kd = sb->mediafrict * eval_sb_fric_force_scale;
-        bp->force[0] -= kd * (bp->vec[0] + windfactor * speed[0] / eval_sb_fric_force_scale);
-        bp->force[1] -= kd * (bp->vec[1] + windfactor * speed[1] / eval_sb_fric_force_scale);
-        bp->force[2] -= kd * (bp->vec[2] + windfactor * speed[2] / eval_sb_fric_force_scale);
-        /* now we'll have nice centrifugal effect for vortex */
-      }
-      else {
-        /* BP friction in media (not) moving*/
-        float kd = sb->mediafrict * sb_fric_force_scale(ob);
-        /* assume it to be proportional to actual velocity */
-        bp->force[0] -= bp->vec[0] * kd;
-        bp->force[1] -= bp->vec[1] * kd;
-        bp->force[2] -= bp->vec[2] * kd;
-        /* friction in media done */
-      }
-      /* +++cached collision targets */
-      bp->choke = 0.0f;
-      bp->choke2 = 0.0f;
-      bp->loc_flag &= ~SBF_DOFUZZY;
-      if (do_deflector && !(bp->loc_flag & SBF_OUTOFCOLLISION)) {
-        float cfforce[3], defforce[3] = {0.0f, 0.0f, 0.0f}, vel[3] = {0.0f, 0.0f, 0.0f},
-                          facenormal[3], cf = 1.0f, intrusion;
-        float kd = 1.0f;
-
-        if (sb_deflect_face(ob, bp->pos, facenormal, defforce, &cf, timenow, vel, &intrusion)) {
-          if (intrusion < 0.0f) {
-            sb->scratch->flag |= SBF_DOFUZZY;
-            bp->loc_flag |= SBF_DOFUZZY;
-            bp->choke = sb->choke * 0.01f;
-          }
+      /* just for calling function once */
+      float eval_sb_fric_force_scale = sb_fric_force_scale(ob);
 
-          sub_v3_v3v3(cfforce, bp->vec, vel);
-          madd_v3_v3fl(bp->force, cfforce, -cf * 50.0f);
+      pd_point_from_soft(scene, bp->pos, bp->vec, sb->bpoint - bp, &epoint);
+      BKE_effectors_apply(pctx->effectors, NULL, sb->effector_weights, &epoint, force, speed);
 
-          madd_v3_v3fl(bp->force, defforce, kd);
-        }
-      }
-      /* ---cached collision targets */
-
-      /* +++springs */
-      iks = 1.0f / (1.0f - sb->inspring) - 1.0f; /* inner spring constants function */
-      if (ob->softflag & OB_SB_EDGES) {
-        if (sb->bspring) { /* spring list exists at all ? */
-          int b;
-          BodySpring *bs;
-          for (b = bp->nofsprings; b > 0; b--) {
-            bs = sb->bspring + bp->springs[b - 1];
-            if (do_springcollision || do_aero) {
-              add_v3_v3(bp->force, bs->ext_force);
-              if (bs->flag & BSF_INTERSECT) {
-                bp->choke = bs->cf;
-              }
-            }
-            // sb_spring_force(Object *ob, int bpi, BodySpring *bs, float iks, float forcetime)
-            sb_spring_force(ob, ilast - bb, bs, iks, forcetime);
-          } /* loop springs */
-        }   /* existing spring list */
-      }     /*any edges*/
-      /* ---springs */
-    }       /*omit on snap */
-  }         /*loop all bp's*/
-  return 0; /*done fine*/
-}
-
-static void *exec_softbody_calc_forces(void *data)
-{
-  SB_thread_context *pctx = (SB_thread_context *)data;
-  _softbody_calc_forces_slice_in_a_thread(pctx->scene,
-                                          pctx->ob,
-                                          pctx->forcetime,
-                                          pctx->timenow,
-                                          pctx->ifirst,
-                                          pctx->ilast,
-                                          NULL,
-                                          pctx->effectors,
-                                          pctx->do_deflector,
-                                          pctx->fieldfactor,
-                                          pctx->windfactor);
-  return NULL;
-}
-
-static void sb_cf_threads_run(Scene *scene,
-                              Object *ob,
-                              float forcetime,
-                              float timenow,
-                              int totpoint,
-                              int *UNUSED(ptr_to_break_func(void)),
-                              struct ListBase *effectors,
-                              int do_deflector,
-                              float fieldfactor,
-                              float windfactor)
-{
-  ListBase threads;
-  SB_thread_context *sb_threads;
-  int i, totthread, left, dec;
-
-  /* wild guess .. may increase with better thread management 'above'
-   * or even be UI option sb->spawn_cf_threads_nopts. */
-  int lowpoints = 100;
-
-  /* figure the number of threads while preventing pretty pointless threading overhead */
-  totthread = BKE_scene_num_threads(scene);
-  /* what if we got zillions of CPUs running but less to spread*/
-  while ((totpoint / totthread < lowpoints) && (totthread > 1)) {
-    totthread--;
-  }
-
-  /* printf("sb_cf_threads_run spawning %d threads\n", totthread); */
-
-  sb_threads = MEM_callocN(sizeof(SB_thread_context) * totthread, "SBThread");
-  memset(sb_threads, 0, sizeof(SB_thread_context) * totthread);
-  left = totpoint;
-  dec = totpoint / totthread + 1;
-  for (i = 0; i < totthread; i++) {
-    sb_threads[i].scene = scene;
-    sb_threads[i].ob = ob;
-    sb_threads[i].forcetime = forcetime;
-    sb_threads[i].timenow = timenow;
-    sb_threads[i].ilast = left;
-    left = left - dec;
-    if (left > 0) {
-      sb_threads[i].ifirst = left;
+      /* apply forcefield*/
+      mul_v3_fl(force, pctx->fieldfactor * eval_sb_fric_force_scale);
+      add_v3_v3(bp->force, force);
+
+      /* BP friction in moving media */
+      kd = sb->mediafrict * eval_sb_fric_force_scale;
+      bp->force[0] -= kd * (bp->vec[0] + pctx->windfactor * speed[0] / eval_sb_fric_force_scale);
+      bp->force[1] -= kd * (bp->vec[1] + pctx->windfactor * speed[1] / eval_sb_fric_force_scale);
+      bp->force[2] -= kd * (bp->vec[2] + pctx->windfactor * speed[2] / eval_sb_fric_force_scale);
+      /* now we'll have nice centrifugal effect for vortex */
     }
     else {
-      sb_threads[i].ifirst = 0;
-    }
-    sb_threads[i].effectors = effectors;
-    sb_threads[i].do_deflector = do_deflector;
-    sb_threads[i].fieldfactor = fieldfactor;
-    sb_threads[i].windfactor = windfactor;
-    sb_threads[i].nr = i;
-    sb_threads[i].tot = totthread;
-  }
+      /* BP friction in media (not) moving*/
+      float kd = sb->mediafrict * sb_fric_force_scale(ob);
+      /* assume it to be proportional to actual velocity */
+      bp->force[0] -= bp->vec[0] * kd;
+      bp->force[1] -= bp->vec[1] * kd;
+      bp->force[2] -= bp->vec[2] * kd;
+      /* friction in media done */
+    }
+    /* +++cached collision targets */
+    bp->choke = 0.0f;
+    bp->choke2 = 0.0f;
+    bp->loc_flag &= ~SBF_DOFUZZY;
+    if (do_deflector && !(bp->loc_flag & SBF_OUTOFCOLLISION)) {
+      float cfforce[3], defforce[3] = {0.0f, 0.0f, 0.0f}, vel[3] = {0.0f, 0.0f, 0.0f},
+                        facenormal[3], cf = 1.0f, intrusion;
+      float kd = 1.0f;
+
+      if (sb_deflect_face(
+              ob, bp->pos, facenormal, defforce, &cf, pctx->timenow, vel, &intrusion)) {
+        if (intrusion < 0.0f) {
+          tls->do_fuzzy = true;
+          bp->loc_flag |= SBF_DOFUZZY;
+          bp->choke = sb->choke * 0.01f;
+        }
 
-  if (totthread > 1) {
-    BLI_threadpool_init(&threads, exec_softbody_calc_forces, totthread);
+        sub_v3_v3v3(cfforce, bp->vec, vel);
+        madd_v3_v3fl(bp->force, cfforce, -cf * 50.0f);
 
-    for (i = 0; i < totthread; i++) {
-      BLI_threadpool_insert(&threads, &sb_threads[i]);
+        madd_v3_v3fl(bp->force, defforce, kd);
+      }
     }
+    /* ---cached collision targets */
+
+    /* +++springs */
+    if (ob->softflag & OB_SB_EDGES) {
+      if (sb->bspring) { /* spring list exists at all ? */
+        const float(*spring_force)[3] = sb->scratch->spring_force;
+        int b;
+        BodySpring *bs;
+        for (b = bp->nofsprings; b > 0; b--) {
+          const int spring_index = bp->springs[b - 1];
+          bs = sb->bspring + spring_index;
+          if (do_springcollision || do_aero) {
+            add_v3_v3(bp->force, bs->ext_force);
+            if (bs->flag & BSF_INTERSECT) {
+              bp->choke = bs->cf;
+            }
+          }
+          /* spring forces were computed once per spring, gather them here */
+          if (a == bs->v1) {
+            add_v3_v3(bp->force, spring_force[spring_index]);
+          }
+          else if (a == bs->v2) {
+            sub_v3_v3(bp->force, spring_force[spring_index]);
+          }
+          else {
+            /* TODO make this debug option */
+            CLOG_WARN(&LOG, "bodypoint <bpi> is not attached to spring  <*bs>");
+          }
+        } /* loop springs */
+      }   /* existing spring list */
+    }     /*any edges*/
+    /* ---springs */
+  }       /*omit on snap */
+}
 
-    BLI_threadpool_end(&threads);
-  }
-  else {
-    exec_softbody_calc_forces(&sb_threads[0]);
+static void softbody_calc_forces_cb(void *__restrict userdata,
+                                    const int a,
+                                    const TaskParallelTLS *__restrict tls)
+{
+  softbody_calc_forces_point((SB_thread_context *)userdata, a, tls->userdata_chunk);
+}
+
+static void softbody_calc_forces_finalize(void *__restrict userdata,
+                                          void *__restrict userdata_chunk)
+{
+  SB_thread_context *pctx = (SB_thread_context *)userdata;
+  SBCalcForcesTLS *tls = (SBCalcForcesTLS *)userdata_chunk;
+
+  if (tls->do_fuzzy) {
+    pctx->ob->soft->scratch->flag |= SBF_DOFUZZY;
   }
-  /* clean up */
-  MEM_freeN(sb_threads);
 }
 
 static void softbody_calc_forces(
@@ -2271,48 +2245,58 @@ static void softbody_calc_forces(
    * this will ruin adaptive stepsize AKA heun! (BM)
    */
   SoftBody *sb = ob->soft; /* is supposed to be there */
-  /*BodyPoint *bproot;*/   /* UNUSED */
-  /* float gravity; */     /* UNUSED */
-  /* float iks; */
-  float fieldfactor = -1.0f, windfactor = 0.25;
-  int do_deflector /*, do_selfcollision*/, do_springcollision, do_aero;
+  SB_thread_context ctx = {NULL};
+  SBCalcForcesTLS tls = {false};
+  TaskParallelSettings settings;
+  int do_deflector, do_springcollision, do_aero;
 
-  /* gravity = sb->grav * sb_grav_force_scale(ob); */ /* UNUSED */
+  if (sb == NULL || sb->scratch == NULL) {
+    CLOG_ERROR(&LOG, "expected a SB here");
+    return;
+  }
 
   /* check conditions for various options */
   do_deflector = query_external_colliders(depsgraph, sb->collision_group);
-#if 0
-  do_selfcollision=((ob->softflag & OB_SB_EDGES) && (sb->bspring)&& (ob->softflag & OB_SB_SELF));
-#endif
   do_springcollision = do_deflector && (ob->softflag & OB_SB_EDGES) &&
                        (ob->softflag & OB_SB_EDGECOLL);
   do_aero = ((sb->aeroedge) && (ob->softflag & OB_SB_EDGES));
 
-  /* iks  = 1.0f/(1.0f-sb->inspring)-1.0f; */ /* inner spring constants function */ /* UNUSED */
-  /* bproot= sb->bpoint; */ /* need this for proper spring addressing */            /* UNUSED */
+  /* wild guess .. may increase with better thread management 'above' */
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 100;
+
+  /* copy point state to the scratch arrays, read by the springs and self collision */
+  sb_scratch_ensure_arrays(sb);
+  BLI_task_parallel_range(0, sb->totpoint, sb, sb_scratch_points_cb, &settings);
 
   if (do_springcollision || do_aero) {
-    sb_sfesf_threads_run(depsgraph, scene, ob, timenow, sb->totspring, NULL);
+    sb_sfesf_threads_run(depsgraph, scene, ob, timenow);
+  }
+
+  /* each spring once, so the points only need to gather */
+  if ((ob->softflag & OB_SB_EDGES) && sb->bspring) {
+    BLI_task_parallel_range(0, sb->totspring, ob, sb_spring_force_cb, &settings);
   }
 
   /* after spring scan because it uses Effoctors too */
-  ListBase *effectors = BKE_effectors_create(depsgraph, ob, NULL, sb->effector_weights);
+  ctx.scene = scene;
+  ctx.ob = ob;
+  ctx.forcetime = forcetime;
+  ctx.timenow = timenow;
+  ctx.effectors = BKE_effectors_create(depsgraph, ob, NULL, sb->effector_weights);
+  ctx.fieldfactor = -1.0f;
+  ctx.windfactor = 0.25f;
 
   if (do_deflector) {
     float defforce[3];
     do_deflector = sb_detect_aabb_collisionCached(defforce, ob, timenow);
   }
+  ctx.do_deflector = do_deflector;
 
-  sb_cf_threads_run(scene,
-                    ob,
-                    forcetime,
-                    timenow,
-                    sb->totpoint,
-                    NULL,
-                    effectors,
-                    do_deflector,
-                    fieldfactor,
-                    windfactor);
+  settings.userdata_chunk = &tls;
+  settings.userdata_chunk_size = sizeof(tls);
+  settings.func_finalize = softbody_calc_forces_finalize;
+  BLI_task_parallel_range(0, sb->totpoint, &ctx, softbody_calc_forces_cb, &settings);
 
   /* finally add forces caused by face collision */
   if (ob->softflag & OB_SB_FACECOLL) {
@@ -2320,163 +2304,192 @@ static void softbody_calc_forces(
   }
 
   /* finish matrix and solve */
-  BKE_effectors_free(effectors);
+  BKE_effectors_free(ctx.effectors);
 }
 
-static void softbody_apply_forces(Object *ob, float forcetime, int mode, float *err, int mid_flags)
-{
-  /* time evolution */
-  /* actually does an explicit euler step mode == 0 */
-  /* or heun ~ 2nd order runge-kutta steps, mode 1, 2 */
-  SoftBody *sb = ob->soft; /* is supposed to be there */
-  BodyPoint *bp;
-  float dx[3] = {0}, dv[3], aabbmin[3], aabbmax[3], cm[3] = {0.0f, 0.0f, 0.0f};
-  float timeovermass /*, freezeloc=0.00001f, freezeforce=0.00000000001f*/;
-  float maxerrpos = 0.0f, maxerrvel = 0.0f;
-  int a, fuzzy = 0;
-
-  forcetime *= sb_time_scale(ob);
+typedef struct SBApplyForcesTLS {
+  float aabbmin[3], aabbmax[3];
+  float maxerrpos, maxerrvel;
+  bool fuzzy;
+} SBApplyForcesTLS;
 
-  aabbmin[0] = aabbmin[1] = aabbmin[2] = 1e20f;
-  aabbmax[0] = aabbmax[1] = aabbmax[2] = -1e20f;
+typedef struct SBApplyForcesContext {
+  Object *ob;
+  float forcetime;
+  int mode;
+  int mid_flags;
+  /* Statistics of all points, reduced from the per thread data. */
+  SBApplyForcesTLS result;
+} SBApplyForcesContext;
+
+static void softbody_apply_forces_cb(void *__restrict userdata,
+                                     const int a,
+                                     const TaskParallelTLS *__restrict tls)
+{
+  const SBApplyForcesContext *ctx = (const SBApplyForcesContext *)userdata;
+  SBApplyForcesTLS *data = (SBApplyForcesTLS *)tls->userdata_chunk;
+  Object *ob = ctx->ob;
+  SoftBody *sb = ob->soft;
+  BodyPoint *bp = &sb->bpoint[a];
+  const float forcetime = ctx->forcetime;
+  const int mode = ctx->mode;
+  float dx[3] = {0}, dv[3];
+  float timeovermass;
 
-  /* old one with homogeneous masses  */
+  /* Now we have individual masses. */
   /* claim a minimum mass for vertex */
-#if 0
-  if (sb->nodemass > 0.009999f) {
-    timeovermass = forcetime / sb->nodemass;
+  if (_final_mass(ob, bp) > 0.009999f) {
+    timeovermass = forcetime / _final_mass(ob, bp);
   }
   else {
     timeovermass = forcetime / 0.009999f;
   }
-#endif
 
-  for (a = sb->totpoint, bp = sb->bpoint; a > 0; a--, bp++) {
-    /* Now we have individual masses. */
-    /* claim a minimum mass for vertex */
-    if (_final_mass(ob, bp) > 0.009999f) {
-      timeovermass = forcetime / _final_mass(ob, bp);
+  if (_final_goal(ob, bp) < SOFTGOALSNAP) {
+    /* this makes t~ = t */
+    if (ctx->mid_flags & MID_PRESERVE) {
+      copy_v3_v3(dx, bp->vec);
+    }
+
+    /**
+     * So here is:
+     * <pre>
+     * (v)' = a(cceleration) =
+     *     sum(F_springs)/m + gravitation + some friction forces + more forces.
+     * </pre>
+     *
+     * The ( ... )' operator denotes derivate respective time.
+     *
+     * The euler step for velocity then becomes:
+     * <pre>
+     * v(t + dt) = v(t) + a(t) * dt
+     * </pre>
+     */
+    mul_v3_fl(bp->force, timeovermass); /* individual mass of node here */
+    /* some nasty if's to have heun in here too */
+    copy_v3_v3(dv, bp->force);
+
+    if (mode == 1) {
+      copy_v3_v3(bp->prevvec, bp->vec);
+      copy_v3_v3(bp->prevdv, dv);
+    }
+
+    if (mode == 2) {
+      /* be optimistic and execute step */
+      bp->vec[0] = bp->prevvec[0] + 0.5f * (dv[0] + bp->prevdv[0]);
+      bp->vec[1] = bp->prevvec[1] + 0.5f * (dv[1] + bp->prevdv[1]);
+      bp->vec[2] = bp->prevvec[2] + 0.5f * (dv[2] + bp->prevdv[2]);
+      /* compare euler to heun to estimate error for step sizing */
+      data->maxerrvel = max_ff(data->maxerrvel, fabsf(dv[0] - bp->prevdv[0]));
+      data->maxerrvel = max_ff(data->maxerrvel, fabsf(dv[1] - bp->prevdv[1]));
+      data->maxerrvel = max_ff(data->maxerrvel, fabsf(dv[2] - bp->prevdv[2]));
     }
     else {
-      timeovermass = forcetime / 0.009999f;
+      add_v3_v3(bp->vec, bp->force);
     }
 
-    if (_final_goal(ob, bp) < SOFTGOALSNAP) {
-      /* this makes t~ = t */
-      if (mid_flags & MID_PRESERVE) {
-        copy_v3_v3(dx, bp->vec);
-      }
+    /* this makes t~ = t+dt */
+    if (!(ctx->mid_flags & MID_PRESERVE)) {
+      copy_v3_v3(dx, bp->vec);
+    }
 
-      /**
-       * So here is:
-       * <pre>
-       * (v)' = a(cceleration) =
-       *     sum(F_springs)/m + gravitation + some friction forces + more forces.
-       * </pre>
-       *
-       * The ( ... )' operator denotes derivate respective time.
-       *
-       * The euler step for velocity then becomes:
-       * <pre>
-       * v(t + dt) = v(t) + a(t) * dt
-       * </pre>
-       */
-      mul_v3_fl(bp->force, timeovermass); /* individual mass of node here */
-      /* some nasty if's to have heun in here too */
-      copy_v3_v3(dv, bp->force);
-
-      if (mode == 1) {
-        copy_v3_v3(bp->prevvec, bp->vec);
-        copy_v3_v3(bp->prevdv, dv);
-      }
+    /* so here is (x)'= v(elocity) */
+    /* the euler step for location then becomes */
+    /* x(t + dt) = x(t) + v(t~) * dt */
+    mul_v3_fl(dx, forcetime);
 
-      if (mode == 2) {
-        /* be optimistic and execute step */
-        bp->vec[0] = bp->prevvec[0] + 0.5f * (dv[0] + bp->prevdv[0]);
-        bp->vec[1] = bp->prevvec[1] + 0.5f * (dv[1] + bp->prevdv[1]);
-        bp->vec[2] = bp->prevvec[2] + 0.5f * (dv[2] + bp->prevdv[2]);
-        /* compare euler to heun to estimate error for step sizing */
-        maxerrvel = max_ff(maxerrvel, fabsf(dv[0] - bp->prevdv[0]));
-        maxerrvel = max_ff(maxerrvel, fabsf(dv[1] - bp->prevdv[1]));
-        maxerrvel = max_ff(maxerrvel, fabsf(dv[2] - bp->prevdv[2]));
-      }
-      else {
-        add_v3_v3(bp->vec, bp->force);
+    /* again some nasty if's to have heun in here too */
+    if (mode == 1) {
+      copy_v3_v3(bp->prevpos, bp->pos);
+      copy_v3_v3(bp->prevdx, dx);
+    }
+
+    if (mode == 2) {
+      bp->pos[0] = bp->prevpos[0] + 0.5f * (dx[0] + bp->prevdx[0]);
+      bp->pos[1] = bp->prevpos[1] + 0.5f * (dx[1] + bp->prevdx[1]);
+      bp->pos[2] = bp->prevpos[2] + 0.5f * (dx[2] + bp->prevdx[2]);
+      data->maxerrpos = max_ff(data->maxerrpos, fabsf(dx[0] - bp->prevdx[0]));
+      data->maxerrpos = max_ff(data->maxerrpos, fabsf(dx[1] - bp->prevdx[1]));
+      data->maxerrpos = max_ff(data->maxerrpos, fabsf(dx[2] - bp->prevdx[2]));
+
+      /* bp->choke is set when we need to pull a vertex or edge out of the collider.
+       * the collider object signals to get out by pushing hard. on the other hand
+       * we don't want to end up in deep space so we add some <viscosity>
+       * to balance that out */
+      if (bp->choke2 > 0.0f) {
+        mul_v3_fl(bp->vec, (1.0f - bp->choke2));
       }
-
-      /* this makes t~ = t+dt */
-      if (!(mid_flags & MID_PRESERVE)) {
-        copy_v3_v3(dx, bp->vec);
+      if (bp->choke > 0.0f) {
+        mul_v3_fl(bp->vec, (1.0f - bp->choke));
       }
+    }
+    else {
+      add_v3_v3(bp->pos, dx);
+    }
+  } /*snap*/
+  /* so while we are looping BPs anyway do statistics on the fly */
+  minmax_v3v3_v3(data->aabbmin, data->aabbmax, bp->pos);
+  if (bp->loc_flag & SBF_DOFUZZY) {
+    data->fuzzy = true;
+  }
+}
 
-      /* so here is (x)'= v(elocity) */
-      /* the euler step for location then becomes */
-      /* x(t + dt) = x(t) + v(t~) * dt */
-      mul_v3_fl(dx, forcetime);
+static void softbody_apply_forces_finalize(void *__restrict userdata,
+                                           void *__restrict userdata_chunk)
+{
+  SBApplyForcesTLS *result = &((SBApplyForcesContext *)userdata)->result;
+  const SBApplyForcesTLS *data = (const SBApplyForcesTLS *)userdata_chunk;
 
-      /* the freezer coming sooner or later */
-#if 0
-      if ((dot_v3v3(dx, dx) < freezeloc) && (dot_v3v3(bp->force, bp->force) < freezeforce)) {
-        bp->frozen /= 2;
-      }
-      else {
-        bp->frozen = min_ff(bp->frozen * 1.05f, 1.0f);
-      }
-      mul_v3_fl(dx, bp->frozen);
-#endif
-      /* again some nasty if's to have heun in here too */
-      if (mode == 1) {
-        copy_v3_v3(bp->prevpos, bp->pos);
-        copy_v3_v3(bp->prevdx, dx);
-      }
+  /* only minimum and maximum values, so the result does not depend on thread scheduling */
+  minmax_v3v3_v3(result->aabbmin, result->aabbmax, data->aabbmin);
+  minmax_v3v3_v3(result->aabbmin, result->aabbmax, data->aabbmax);
+  result->maxerrpos = max_ff(result->maxerrpos, data->maxerrpos);
+  result->maxerrvel = max_ff(result->maxerrvel, data->maxerrvel);
+  result->fuzzy |= data->fuzzy;
+}
 
-      if (mode == 2) {
-        bp->pos[0] = bp->prevpos[0] + 0.5f * (dx[0] + bp->prevdx[0]);
-        bp->pos[1] = bp->prevpos[1] + 0.5f * (dx[1] + bp->prevdx[1]);
-        bp->pos[2] = bp->prevpos[2] + 0.5f * (dx[2] + bp->prevdx[2]);
-        maxerrpos = max_ff(maxerrpos, fabsf(dx[0] - bp->prevdx[0]));
-        maxerrpos = max_ff(maxerrpos, fabsf(dx[1] - bp->prevdx[1]));
-        maxerrpos = max_ff(maxerrpos, fabsf(dx[2] - bp->prevdx[2]));
-
-        /* bp->choke is set when we need to pull a vertex or edge out of the collider.
-         * the collider object signals to get out by pushing hard. on the other hand
-         * we don't want to end up in deep space so we add some <viscosity>
-         * to balance that out */
-        if (bp->choke2 > 0.0f) {
-          mul_v3_fl(bp->vec, (1.0f - bp->choke2));
-        }
-        if (bp->choke > 0.0f) {
-          mul_v3_fl(bp->vec, (1.0f - bp->choke));
-        }
-      }
-      else {
-        add_v3_v3(bp->pos, dx);
-      }
-    } /*snap*/
-    /* so while we are looping BPs anyway do statistics on the fly */
-    minmax_v3v3_v3(aabbmin, aabbmax, bp->pos);
-    if (bp->loc_flag & SBF_DOFUZZY) {
-      fuzzy = 1;
-    }
-  } /*for*/
+static void softbody_apply_forces(Object *ob, float forcetime, int mode, float *err, int mid_flags)
+{
+  /* time evolution */
+  /* actually does an explicit euler step mode == 0 */
+  /* or heun ~ 2nd order runge-kutta steps, mode 1, 2 */
+  SoftBody *sb = ob->soft; /* is supposed to be there */
+  SBApplyForcesContext ctx;
+  SBApplyForcesTLS tls;
+  TaskParallelSettings settings;
+
+  tls.aabbmin[0] = tls.aabbmin[1] = tls.aabbmin[2] = 1e20f;
+  tls.aabbmax[0] = tls.aabbmax[1] = tls.aabbmax[2] = -1e20f;
+  tls.maxerrpos = tls.maxerrvel = 0.0f;
+  tls.fuzzy = false;
+
+  ctx.ob = ob;
+  ctx.forcetime = forcetime * sb_time_scale(ob);
+  ctx.mode = mode;
+  ctx.mid_flags = mid_flags;
+  ctx.result = tls;
+
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 100;
+  settings.userdata_chunk = &tls;
+  settings.userdata_chunk_size = sizeof(tls);
+  settings.func_finalize = softbody_apply_forces_finalize;
+  BLI_task_parallel_range(0, sb->totpoint, &ctx, softbody_apply_forces_cb, &settings);
 
-  if (sb->totpoint) {
-    mul_v3_fl(cm, 1.0f / sb->totpoint);
-  }
   if (sb->scratch) {
-    copy_v3_v3(sb->scratch->aabbmin, aabbmin);
-    copy_v3_v3(sb->scratch->aabbmax, aabbmax);
+    copy_v3_v3(sb->scratch->aabbmin, ctx.result.aabbmin);
+    copy_v3_v3(sb->scratch->aabbmax, ctx.result.aabbmax);
   }
 
   if (err) { /* so step size will be controlled by biggest difference in slope */
     if (sb->solverflags & SBSO_OLDERR) {
-      *err = max_ff(maxerrpos, maxerrvel);
+      *err = max_ff(ctx.result.maxerrpos, ctx.result.maxerrvel);
     }
     else {
-      *err = maxerrpos;
+      *err = ctx.result.maxerrpos;
     }
     // printf("EP %f EV %f\n", maxerrpos, maxerrvel);
-    if (fuzzy) {
+    if (ctx.result.fuzzy) {
       *err /= sb->fuzzyness;
     }
   }
@@ -0,0 +1,45 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __BLI_BYTE_PLANES_H__
+#define __BLI_BYTE_PLANES_H__
+
+/** \file
+ * \ingroup bli
+ * \brief Compact storage of arrays which are mostly zero, such as the difference of two states.
+ */
+
+#include "BLI_sys_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+size_t BLI_byte_planes_pack(const void *values,
+                            const size_t values_len,
+                            const size_t stride,
+                            void **r_packed);
+void BLI_byte_planes_unpack(const void *packed,
+                            const size_t values_len,
+                            const size_t stride,
+                            void *r_values);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BLI_BYTE_PLANES_H__ */
@@ -0,0 +1,110 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __BLI_CONCURRENT_MAP_H__
+#define __BLI_CONCURRENT_MAP_H__
+
+/** \file
+ * \ingroup bli
+ * \brief A hash map that can be added to and looked up from multiple threads at once,
+ * without locks.
+ *
+ * Keys and values are pointers, keys are hashed and compared with the same callbacks as #GHash.
+ * The table uses open addressing with groups of slots probed together, like #BLI::Map.
+ * When it gets too full, a larger table is allocated and the entries are moved over by all
+ * threads using the map at that time, while additions and lookups keep working.
+ *
+ * Entries can't be removed and a value can't be replaced once added,
+ * so every thread sees the same value for a key.
+ * Tables the map has grown out of are only freed with the map.
+ */
+
+#include "BLI_compiler_attrs.h"
+#include "BLI_ghash.h"
+#include "BLI_sys_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct ConcurrentMap ConcurrentMap;
+
+typedef void (*ConcurrentMapForeachFP)(void *key, void *val, void *userdata);
+
+/* -------------------------------------------------------------------- */
+/** \name NOT Safe for Threads
+ * \{ */
+
+ConcurrentMap *BLI_concurrent_map_new(GHashHashFP hashfp,
+                                      GHashCmpFP cmpfp,
+                                      const char *info,
+                                      const uint nentries_reserve) ATTR_MALLOC
+    ATTR_WARN_UNUSED_RESULT;
+void BLI_concurrent_map_free(ConcurrentMap *map,
+                             GHashKeyFreeFP keyfreefp,
+                             GHashValFreeFP valfreefp) ATTR_NONNULL(1);
+
+/**
+ * Call \a func for every entry, in no particular order.
+ */
+void BLI_concurrent_map_foreach(ConcurrentMap *map, ConcurrentMapForeachFP func, void *userdata)
+    ATTR_NONNULL(1, 2);
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Safe for Threads
+ * \{ */
+
+/**
+ * Add \a key with \a val, unless \a key is already in the map.
+ *
+ * \return true when the entry was added.
+ */
+bool BLI_concurrent_map_add(ConcurrentMap *map, void *key, void *val) ATTR_NONNULL(1);
+
+/**
+ * Add \a key with \a val, unless \a key is already in the map.
+ * Only one of the threads adding the same key at once succeeds,
+ * the others get the value it added.
+ *
+ * \param r_val: The value in the map after the call, \a val or the value already stored.
+ * \return true when \a key was already in the map.
+ */
+bool BLI_concurrent_map_ensure(ConcurrentMap *map, void *key, void *val, void **r_val)
+    ATTR_NONNULL(1, 4);
+
+void *BLI_concurrent_map_lookup(const ConcurrentMap *map, const void *key) ATTR_NONNULL(1)
+    ATTR_WARN_UNUSED_RESULT;
+void *BLI_concurrent_map_lookup_default(const ConcurrentMap *map,
+                                        const void *key,
+                                        void *val_default) ATTR_NONNULL(1)
+    ATTR_WARN_UNUSED_RESULT;
+bool BLI_concurrent_map_haskey(const ConcurrentMap *map, const void *key) ATTR_NONNULL(1)
+    ATTR_WARN_UNUSED_RESULT;
+
+/**
+ * Number of entries, only exact while no other thread is adding to the map.
+ */
+uint BLI_concurrent_map_len(const ConcurrentMap *map) ATTR_NONNULL(1) ATTR_WARN_UNUSED_RESULT;
+
+/** \} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BLI_CONCURRENT_MAP_H__ */
@@ -89,6 +89,11 @@ typedef struct BVHTreeRayHit {
   float dist;
 } BVHTreeRayHit;
 
+enum {
+  /* Split branches using the surface area heuristic instead of at the median,
+   * slower to build, faster to ray-cast when the geometry is unevenly distributed. */
+  BVH_BALANCE_SAH = (1 << 0),
+};
 enum {
   /* Use a priority queue to process nodes in the optimal order (for slow callbacks) */
   BVH_OVERLAP_USE_THREADING = (1 << 0),
@@ -105,6 +110,9 @@ enum {
 #define BVH_RAYCAST_DEFAULT (BVH_RAYCAST_WATERTIGHT)
 #define BVH_RAYCAST_DIST_MAX (FLT_MAX / 2.0f)
 
+/* Number of rays #BLI_bvhtree_ray_cast_packet traverses the tree with together. */
+#define BVH_RAYCAST_PACKET_SIZE 4
+
 /* callback must update nearest in case it finds a nearest result */
 typedef void (*BVHTree_NearestPointCallback)(void *userdata,
                                              int index,
@@ -148,6 +156,7 @@ void BLI_bvhtree_free(BVHTree *tree);
 
 /* construct: first insert points, then call balance */
 void BLI_bvhtree_insert(BVHTree *tree, int index, const float co[3], int numpoints);
+void BLI_bvhtree_balance_ex(BVHTree *tree, const int flag);
 void BLI_bvhtree_balance(BVHTree *tree);
 
 /* update: first update points/nodes, then call update_tree to refit the bounding volumes */
@@ -215,6 +224,16 @@ int BLI_bvhtree_ray_cast(BVHTree *tree,
                          BVHTree_RayCastCallback callback,
                          void *userdata);
 
+void BLI_bvhtree_ray_cast_packet(BVHTree *tree,
+                                 const float (*co)[3],
+                                 const float (*dir)[3],
+                                 const int rays_len,
+                                 float radius,
+                                 BVHTreeRayHit *hits,
+                                 BVHTree_RayCastCallback callback,
+                                 void *userdata,
+                                 int flag);
+
 void BLI_bvhtree_ray_cast_all_ex(BVHTree *tree,
                                  const float co[3],
                                  const float dir[3],
@@ -84,6 +84,14 @@ enum {
    * order of allocation when no chunks have been freed.
    */
   BLI_MEMPOOL_ALLOW_ITER = (1 << 0),
+  /** Allow allocating and freeing elements from multiple threads at once.
+   *
+   * \note Each thread allocates from its own list of free elements, filled by new chunks
+   * and the elements it frees. Elements freed by other threads than the one allocating them
+   * are moved to a list shared by all threads once there are enough of them.
+   * Other functions are still not thread safe.
+   */
+  BLI_MEMPOOL_THREAD_SAFE = (1 << 1),
 };
 
 void BLI_mempool_iternew(BLI_mempool *pool, BLI_mempool_iter *iter) ATTR_NONNULL();
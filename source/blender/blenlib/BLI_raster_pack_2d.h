@@ -0,0 +1,69 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __BLI_RASTER_PACK_2D_H__
+#define __BLI_RASTER_PACK_2D_H__
+
+/** \file
+ * \ingroup bli
+ * \brief Pack 2D islands by their shape instead of their bounding box,
+ * using a coarse occupancy grid searched on multiple threads.
+ */
+
+#include "BLI_compiler_attrs.h"
+#include "BLI_sys_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct RasterPackIsland {
+  /** Triangles making up the island shape. */
+  const float (*tris)[3][2];
+  uint tris_len;
+
+  /** Result: the island is rotated by \a angle around the origin, then moved by \a offset. */
+  float angle;
+  float offset[2];
+} RasterPackIsland;
+
+typedef struct RasterPackParams {
+  /** Number of grid cells along the side of a square with the total island area. */
+  int resolution;
+  /** Number of rotations tried for every island, evenly spaced over a full turn. */
+  int rotations;
+  /** Minimum distance between islands. */
+  float margin;
+  /** Stop trying other layouts once this fraction of the packed area is covered by islands. */
+  float efficiency_target;
+  /** Time limit in seconds, zero for none. Once reached, the remaining islands are put on
+   * shelves above the others instead of being fitted into gaps. */
+  double time_limit;
+} RasterPackParams;
+
+void BLI_raster_pack_2d_params_defaults(RasterPackParams *params) ATTR_NONNULL();
+
+void BLI_raster_pack_2d(RasterPackIsland *islands,
+                        const uint islands_len,
+                        const RasterPackParams *params,
+                        float *r_tot_width,
+                        float *r_tot_height) ATTR_NONNULL(3, 4, 5);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BLI_RASTER_PACK_2D_H__ */
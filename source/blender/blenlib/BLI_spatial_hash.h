@@ -0,0 +1,61 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __BLI_SPATIAL_HASH_H__
+#define __BLI_SPATIAL_HASH_H__
+
+/** \file
+ * \ingroup bli
+ * \brief Find points within a distance of each other using a uniform grid,
+ * built and searched on multiple threads.
+ */
+
+#include "BLI_bitmap.h"
+#include "BLI_compiler_attrs.h"
+#include "BLI_sys_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int BLI_spatial_hash_3d_calc_duplicates(const float *co,
+                                        const size_t co_stride,
+                                        const uint co_len,
+                                        const float range,
+                                        int *duplicates) ATTR_NONNULL(1, 5);
+
+int BLI_spatial_hash_3d_calc_clusters(const float *co,
+                                      const size_t co_stride,
+                                      const uint co_len,
+                                      const BLI_bitmap *mask,
+                                      const float range,
+                                      const uint max_neighbors,
+                                      int *r_clusters) ATTR_NONNULL(1, 7);
+
+void BLI_spatial_hash_3d_find_nearest(const float *co,
+                                      const size_t co_stride,
+                                      const uint co_len,
+                                      const float *co_query,
+                                      const size_t co_query_stride,
+                                      const uint co_query_len,
+                                      const float range,
+                                      int *r_nearest) ATTR_NONNULL(1, 4, 8);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BLI_SPATIAL_HASH_H__ */
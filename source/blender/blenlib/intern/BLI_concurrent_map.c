@@ -0,0 +1,467 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup bli
+ *
+ * Every slot has a 32 bit state next to the array of entries,
+ * the states of a group of slots share a cache line and are checked before touching any key.
+ * A slot is claimed by swapping its state from empty to reserved,
+ * then the key and value are written and the state is set to the upper bits of the hash.
+ *
+ * Growing: once half of the slots are used, a table twice the size is allocated and linked
+ * from the full one. From then on, threads adding to the map close the empty slots they come
+ * across instead of using them, and take chunks of slots to copy over to the next table.
+ * Copied slots are flagged so lookups of their keys continue in the next table.
+ * When all chunks are done, the map starts its operations from the next table.
+ */
+
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_concurrent_map.h"
+#include "BLI_utildefines.h"
+
+#include "BLI_strict_flags.h"
+
+#include "atomic_ops.h"
+
+/* Slots probed together, their states fill half a cache line. */
+#define SLOTS_PER_GROUP 8
+#define SLOTS_LEN_MIN (SLOTS_PER_GROUP * 2)
+/* Number of slots copied to the next table at once by one thread. */
+#define MIGRATE_CHUNK_SLOTS 1024
+
+#define CACHE_LINE_SIZE 64
+
+/* Slot states, see #slot_state_set for slots with an entry. */
+#define SLOT_EMPTY 0u
+/* Empty slot closed while the table grows, the key can only be in the next table. */
+#define SLOT_EMPTY_MOVED 1u
+/* Key and value are being written. */
+#define SLOT_RESERVED 2u
+#define SLOT_SET 4u
+/* Flag for slots with an entry, that was copied to the next table. */
+#define SLOT_MOVED 1u
+#define SLOT_HASH_MASK (~7u)
+
+typedef struct MapEntry {
+  void *key;
+  void *val;
+} MapEntry;
+
+typedef struct MapTable {
+  uint32_t *states;
+  MapEntry *entries;
+  uint32_t slots_len;
+  /** Start growing once this many slots are used. */
+  uint32_t used_grow;
+  /** Wait for the next table before using more slots than this. */
+  uint32_t used_max;
+  uint32_t chunks_len;
+  /** Table the entries are moved to, set once when growing. */
+  struct MapTable *next;
+
+  /* Counters changed by all threads, kept off the cache line read by every probe. */
+  char _pad0[CACHE_LINE_SIZE];
+  /** Slots with an entry, and the ones threads are about to claim. */
+  uint32_t used;
+  char _pad1[CACHE_LINE_SIZE];
+  uint32_t chunks_claimed;
+  uint32_t chunks_done;
+  /** Number of entries copied to the next table. */
+  uint32_t moved;
+} MapTable;
+
+struct ConcurrentMap {
+  GHashHashFP hashfp;
+  GHashCmpFP cmpfp;
+  const char *info;
+  /** Table operations start from, advanced once all its entries are in the next table. */
+  MapTable *table;
+  /** Oldest table, the newer ones follow #MapTable.next. */
+  MapTable *table_first;
+};
+
+typedef enum eProbeResult {
+  PROBE_FOUND = 0,
+  PROBE_ADDED,
+  PROBE_NOT_FOUND,
+  PROBE_NEXT_TABLE,
+} eProbeResult;
+
+/* -------------------------------------------------------------------- */
+/** \name Internal Utilities
+ * \{ */
+
+/* Reads of values other threads write, #atomic_ops.h only has read-modify-write operations. */
+BLI_INLINE uint32_t load_uint32(const uint32_t *v)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return __atomic_load_n(v, __ATOMIC_ACQUIRE);
+#else
+  return *(const volatile uint32_t *)v;
+#endif
+}
+
+BLI_INLINE MapTable *load_table(MapTable *const *v)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return __atomic_load_n(v, __ATOMIC_ACQUIRE);
+#else
+  return *(MapTable *const volatile *)v;
+#endif
+}
+
+BLI_INLINE uint32_t map_hash(const ConcurrentMap *map, const void *key)
+{
+  /* Mix all bits into the lower ones used for the slot index and the upper ones stored in the
+   * slot state (MurmurHash3 finalizer), many #GHashHashFP leave either of them constant. */
+  uint32_t hash = map->hashfp(key);
+  hash ^= hash >> 16;
+  hash *= 0x85ebca6bu;
+  hash ^= hash >> 13;
+  hash *= 0xc2b2ae35u;
+  hash ^= hash >> 16;
+  return hash;
+}
+
+BLI_INLINE uint32_t slot_state_set(const uint32_t hash)
+{
+  return (hash & SLOT_HASH_MASK) | SLOT_SET;
+}
+
+static MapTable *table_new(const uint32_t slots_len, const char *info)
+{
+  MapTable *table = MEM_callocN(sizeof(*table), info);
+  table->states = MEM_mallocN_aligned(sizeof(*table->states) * slots_len, CACHE_LINE_SIZE, info);
+  table->entries = MEM_mallocN(sizeof(*table->entries) * slots_len, info);
+  memset(table->states, 0, sizeof(*table->states) * slots_len);
+  table->slots_len = slots_len;
+  table->used_grow = slots_len / 2;
+  table->used_max = slots_len - slots_len / 4;
+  table->chunks_len = (slots_len + MIGRATE_CHUNK_SLOTS - 1) / MIGRATE_CHUNK_SLOTS;
+  return table;
+}
+
+static void table_free(MapTable *table)
+{
+  MEM_freeN(table->states);
+  MEM_freeN(table->entries);
+  MEM_freeN(table);
+}
+
+static void table_grow(MapTable *table, const char *info)
+{
+  MapTable *next = table_new(table->slots_len * 2, info);
+  if (atomic_cas_ptr((void **)&table->next, NULL, next) != NULL) {
+    table_free(next);
+  }
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Probing
+ * \{ */
+
+/**
+ * Look for \a key in \a table only, adding it when \a do_add is set and the table isn't growing.
+ */
+static eProbeResult table_probe(const ConcurrentMap *map,
+                                MapTable *table,
+                                const uint32_t hash,
+                                void *key,
+                                void *val,
+                                const bool do_add,
+                                void **r_val)
+{
+  const uint32_t state_set = slot_state_set(hash);
+  const uint32_t slots_mask = table->slots_len - 1;
+  uint32_t hash_iter = hash;
+  uint32_t perturb = hash;
+
+  while (true) {
+    const uint32_t slot_group = (hash_iter & slots_mask) & ~(uint32_t)(SLOTS_PER_GROUP - 1);
+    const uint32_t offset_init = hash_iter & (SLOTS_PER_GROUP - 1);
+    uint32_t offset = offset_init;
+    do {
+      const uint32_t slot = slot_group + offset;
+      uint32_t *state_p = &table->states[slot];
+      while (true) {
+        const uint32_t state = load_uint32(state_p);
+        if (state == SLOT_EMPTY) {
+          if (!do_add) {
+            return PROBE_NOT_FOUND;
+          }
+          if (load_table(&table->next) != NULL) {
+            /* Growing, keep new entries out of this table. */
+            atomic_cas_uint32(state_p, SLOT_EMPTY, SLOT_EMPTY_MOVED);
+            continue;
+          }
+          /* Count the slot as used before claiming it, so threads adding at the same time
+           * can't fill the table past #MapTable.used_max. */
+          const uint32_t used = atomic_add_and_fetch_uint32(&table->used, 1);
+          if (UNLIKELY(used > table->used_max)) {
+            /* Another thread is allocating the next table. */
+            atomic_sub_and_fetch_uint32(&table->used, 1);
+            continue;
+          }
+          if (atomic_cas_uint32(state_p, SLOT_EMPTY, SLOT_RESERVED) != SLOT_EMPTY) {
+            atomic_sub_and_fetch_uint32(&table->used, 1);
+            continue;
+          }
+          table->entries[slot].key = key;
+          table->entries[slot].val = val;
+          atomic_cas_uint32(state_p, SLOT_RESERVED, state_set);
+          /* Other threads may give back their count, so #MapTable.used_grow can be passed
+           * without any thread getting it exactly. */
+          if (used >= table->used_grow && load_table(&table->next) == NULL) {
+            table_grow(table, map->info);
+          }
+          *r_val = val;
+          return PROBE_ADDED;
+        }
+        if (state == SLOT_EMPTY_MOVED) {
+          return PROBE_NEXT_TABLE;
+        }
+        if (state == SLOT_RESERVED) {
+          /* The key being written may be the same. */
+          continue;
+        }
+        if ((state & ~SLOT_MOVED) == state_set &&
+            map->cmpfp(key, table->entries[slot].key) == false) {
+          if (state & SLOT_MOVED) {
+            return PROBE_NEXT_TABLE;
+          }
+          *r_val = table->entries[slot].val;
+          return PROBE_FOUND;
+        }
+        break;
+      }
+      offset = (offset + 1) & (SLOTS_PER_GROUP - 1);
+    } while (offset != offset_init);
+
+    perturb >>= 5;
+    hash_iter = hash_iter * 5 + 1 + perturb;
+  }
+}
+
+static void table_migrate_help(ConcurrentMap *map, MapTable *table);
+
+static eProbeResult map_probe(ConcurrentMap *map,
+                              MapTable *table,
+                              const uint32_t hash,
+                              void *key,
+                              void *val,
+                              const bool do_add,
+                              void **r_val)
+{
+  while (true) {
+    if (do_add && load_table(&table->next) != NULL) {
+      table_migrate_help(map, table);
+    }
+    const eProbeResult result = table_probe(map, table, hash, key, val, do_add, r_val);
+    if (result != PROBE_NEXT_TABLE) {
+      return result;
+    }
+    table = load_table(&table->next);
+  }
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Growing
+ * \{ */
+
+/* Start from the newest table whose predecessors were all moved. */
+static void map_table_advance(ConcurrentMap *map)
+{
+  MapTable *table = load_table(&map->table);
+  while (table->next != NULL && load_uint32(&table->chunks_done) == table->chunks_len) {
+    atomic_cas_ptr((void **)&map->table, table, table->next);
+    table = load_table(&map->table);
+  }
+}
+
+static void table_migrate_chunk(ConcurrentMap *map, MapTable *table, const uint32_t chunk)
+{
+  MapTable *next = table->next;
+  const uint32_t slot_end = MIN2((chunk + 1) * MIGRATE_CHUNK_SLOTS, table->slots_len);
+  uint32_t moved = 0;
+
+  for (uint32_t slot = chunk * MIGRATE_CHUNK_SLOTS; slot < slot_end; slot++) {
+    uint32_t *state_p = &table->states[slot];
+    while (true) {
+      const uint32_t state = load_uint32(state_p);
+      if (state == SLOT_EMPTY) {
+        if (atomic_cas_uint32(state_p, SLOT_EMPTY, SLOT_EMPTY_MOVED) != SLOT_EMPTY) {
+          continue;
+        }
+      }
+      else if (state == SLOT_RESERVED) {
+        continue;
+      }
+      else if ((state & SLOT_SET) && !(state & SLOT_MOVED)) {
+        MapEntry *entry = &table->entries[slot];
+        void *val_dummy;
+        map_probe(map, next, map_hash(map, entry->key), entry->key, entry->val, true, &val_dummy);
+        atomic_cas_uint32(state_p, state, state | SLOT_MOVED);
+        moved++;
+      }
+      break;
+    }
+  }
+
+  atomic_add_and_fetch_uint32(&table->moved, moved);
+  if (atomic_add_and_fetch_uint32(&table->chunks_done, 1) == table->chunks_len) {
+    map_table_advance(map);
+  }
+}
+
+static void table_migrate_help(ConcurrentMap *map, MapTable *table)
+{
+  while (load_uint32(&table->chunks_claimed) < table->chunks_len) {
+    const uint32_t chunk = atomic_fetch_and_add_uint32(&table->chunks_claimed, 1);
+    if (chunk >= table->chunks_len) {
+      break;
+    }
+    table_migrate_chunk(map, table, chunk);
+  }
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Public API
+ * \{ */
+
+ConcurrentMap *BLI_concurrent_map_new(GHashHashFP hashfp,
+                                      GHashCmpFP cmpfp,
+                                      const char *info,
+                                      const uint nentries_reserve)
+{
+  ConcurrentMap *map = MEM_mallocN(sizeof(*map), info);
+  uint32_t slots_len = SLOTS_LEN_MIN;
+  while (slots_len / 2 <= nentries_reserve) {
+    slots_len *= 2;
+  }
+  map->hashfp = hashfp;
+  map->cmpfp = cmpfp;
+  map->info = info;
+  map->table = map->table_first = table_new(slots_len, info);
+  return map;
+}
+
+void BLI_concurrent_map_free(ConcurrentMap *map,
+                             GHashKeyFreeFP keyfreefp,
+                             GHashValFreeFP valfreefp)
+{
+  MapTable *table = map->table_first;
+  while (table != NULL) {
+    MapTable *next = table->next;
+    if (keyfreefp || valfreefp) {
+      for (uint32_t slot = 0; slot < table->slots_len; slot++) {
+        const uint32_t state = table->states[slot];
+        if ((state & SLOT_SET) && !(state & SLOT_MOVED)) {
+          if (keyfreefp) {
+            keyfreefp(table->entries[slot].key);
+          }
+          if (valfreefp) {
+            valfreefp(table->entries[slot].val);
+          }
+        }
+      }
+    }
+    table_free(table);
+    table = next;
+  }
+  MEM_freeN(map);
+}
+
+void BLI_concurrent_map_foreach(ConcurrentMap *map, ConcurrentMapForeachFP func, void *userdata)
+{
+  for (MapTable *table = map->table_first; table != NULL; table = table->next) {
+    for (uint32_t slot = 0; slot < table->slots_len; slot++) {
+      const uint32_t state = table->states[slot];
+      if ((state & SLOT_SET) && !(state & SLOT_MOVED)) {
+        func(table->entries[slot].key, table->entries[slot].val, userdata);
+      }
+    }
+  }
+}
+
+bool BLI_concurrent_map_add(ConcurrentMap *map, void *key, void *val)
+{
+  void *val_dummy;
+  return map_probe(
+             map, load_table(&map->table), map_hash(map, key), key, val, true, &val_dummy) ==
+         PROBE_ADDED;
+}
+
+bool BLI_concurrent_map_ensure(ConcurrentMap *map, void *key, void *val, void **r_val)
+{
+  return map_probe(map, load_table(&map->table), map_hash(map, key), key, val, true, r_val) ==
+         PROBE_FOUND;
+}
+
+void *BLI_concurrent_map_lookup_default(const ConcurrentMap *map,
+                                        const void *key,
+                                        void *val_default)
+{
+  void *val;
+  /* Lookups don't write to the map. */
+  if (map_probe((ConcurrentMap *)map,
+                load_table(&map->table),
+                map_hash(map, key),
+                (void *)key,
+                NULL,
+                false,
+                &val) == PROBE_FOUND) {
+    return val;
+  }
+  return val_default;
+}
+
+void *BLI_concurrent_map_lookup(const ConcurrentMap *map, const void *key)
+{
+  return BLI_concurrent_map_lookup_default(map, key, NULL);
+}
+
+bool BLI_concurrent_map_haskey(const ConcurrentMap *map, const void *key)
+{
+  void *val;
+  return map_probe((ConcurrentMap *)map,
+                   load_table(&map->table),
+                   map_hash(map, key),
+                   (void *)key,
+                   NULL,
+                   false,
+                   &val) == PROBE_FOUND;
+}
+
+uint BLI_concurrent_map_len(const ConcurrentMap *map)
+{
+  uint len = 0;
+  for (MapTable *table = map->table_first; table != NULL; table = load_table(&table->next)) {
+    len += load_uint32(&table->used) - load_uint32(&table->moved);
+  }
+  return len;
+}
+
+/** \} */
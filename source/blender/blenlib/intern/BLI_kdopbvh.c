@@ -30,6 +30,8 @@
  *
  * - Ray-cast:
  *   #BLI_bvhtree_ray_cast, #BVHRayCastData
+ * - Ray-cast many coherent rays:
+ *   #BLI_bvhtree_ray_cast_packet, #BVHRayPacketData
  * - Nearest point on surface:
  *   #BLI_bvhtree_find_nearest, #BVHNearestData
  * - Overlapping 2 trees:
@@ -40,6 +42,10 @@
 
 #include <assert.h>
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 #include "MEM_guardedalloc.h"
 
 #include "BLI_utildefines.h"
@@ -859,6 +865,284 @@ static void non_recursive_bvh_div_nodes(const BVHTree *tree,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name SAH Tree Build
+ *
+ * Instead of the implicit tree, split the leafs where the surface area heuristic estimates
+ * ray-casts are cheapest: the area of each side's bounds weighted by its number of leafs,
+ * evaluated for #BVH_SAH_BINS planes along each axis.
+ *
+ * Binary splits are collapsed into nodes of up to `tree_type` children by splitting the child
+ * with the largest area again. The tree isn't balanced, branches are numbered as they are
+ * created so children always come after their parent, as #BLI_bvhtree_update_tree expects.
+ * \{ */
+
+#define BVH_SAH_BINS 16
+
+/* Split at the median beyond this depth, so degenerate input can't make the tree too deep. */
+#define BVH_SAH_DEPTH_MAX 48
+
+typedef struct BVHSAHGroup {
+  /** Range of leafs. */
+  int begin, end;
+  int depth;
+  /** Bounds on the x, y & z axis, same layout as #BVHNode.bv. */
+  float bounds[6];
+} BVHSAHGroup;
+
+typedef struct BVHSAHTask {
+  int branch;
+  int begin, end;
+  int depth;
+} BVHSAHTask;
+
+static void sah_bounds_init(float bounds[6])
+{
+  for (int axis = 0; axis < 3; axis++) {
+    bounds[2 * axis] = FLT_MAX;
+    bounds[2 * axis + 1] = -FLT_MAX;
+  }
+}
+
+static void sah_bounds_add(float bounds[6], const float bv[6])
+{
+  for (int axis = 0; axis < 3; axis++) {
+    bounds[2 * axis] = min_ff(bounds[2 * axis], bv[2 * axis]);
+    bounds[2 * axis + 1] = max_ff(bounds[2 * axis + 1], bv[2 * axis + 1]);
+  }
+}
+
+/* Half the surface area, enough to compare costs. */
+static float sah_bounds_area(const float bounds[6])
+{
+  const float x = bounds[1] - bounds[0];
+  const float y = bounds[3] - bounds[2];
+  const float z = bounds[5] - bounds[4];
+  if (x < 0.0f) {
+    return 0.0f;
+  }
+  return x * y + y * z + z * x;
+}
+
+BLI_INLINE float sah_centroid(const BVHNode *node, const int axis)
+{
+  return (node->bv[2 * axis] + node->bv[2 * axis + 1]) * 0.5f;
+}
+
+BLI_INLINE int sah_bin_index(const float centroid, const float centroid_min, const float scale)
+{
+  const int bin = (int)((centroid - centroid_min) * scale);
+  return min_ii(bin, BVH_SAH_BINS - 1);
+}
+
+/**
+ * Split \a group in two, partitioning its leafs along the axis of the split.
+ *
+ * \return the axis of the split.
+ */
+static int sah_split(BVHNode **leafs_array, const BVHSAHGroup *group, BVHSAHGroup r_groups[2])
+{
+  float centroid_bounds[6];
+  int i, axis;
+
+  sah_bounds_init(centroid_bounds);
+  for (i = group->begin; i < group->end; i++) {
+    for (axis = 0; axis < 3; axis++) {
+      const float centroid = sah_centroid(leafs_array[i], axis);
+      centroid_bounds[2 * axis] = min_ff(centroid_bounds[2 * axis], centroid);
+      centroid_bounds[2 * axis + 1] = max_ff(centroid_bounds[2 * axis + 1], centroid);
+    }
+  }
+
+  float cost_best = FLT_MAX;
+  int split_axis = -1, split_bin = 0;
+  float split_scale = 0.0f;
+
+  if (group->depth < BVH_SAH_DEPTH_MAX) {
+    for (axis = 0; axis < 3; axis++) {
+      const float extent = centroid_bounds[2 * axis + 1] - centroid_bounds[2 * axis];
+      if (!(extent > 0.0f)) {
+        continue;
+      }
+      const float scale = (float)BVH_SAH_BINS / extent;
+
+      int bin_len[BVH_SAH_BINS] = {0};
+      float bin_bounds[BVH_SAH_BINS][6];
+      for (i = 0; i < BVH_SAH_BINS; i++) {
+        sah_bounds_init(bin_bounds[i]);
+      }
+      for (i = group->begin; i < group->end; i++) {
+        const int bin = sah_bin_index(
+            sah_centroid(leafs_array[i], axis), centroid_bounds[2 * axis], scale);
+        bin_len[bin]++;
+        sah_bounds_add(bin_bounds[bin], leafs_array[i]->bv);
+      }
+
+      /* Cost of the right side for every split, sweeping from the right. */
+      float cost_right[BVH_SAH_BINS];
+      float bounds[6];
+      int len = 0;
+      sah_bounds_init(bounds);
+      for (i = BVH_SAH_BINS - 1; i > 0; i--) {
+        sah_bounds_add(bounds, bin_bounds[i]);
+        len += bin_len[i];
+        cost_right[i] = sah_bounds_area(bounds) * (float)len;
+      }
+
+      len = 0;
+      sah_bounds_init(bounds);
+      for (i = 1; i < BVH_SAH_BINS; i++) {
+        sah_bounds_add(bounds, bin_bounds[i - 1]);
+        len += bin_len[i - 1];
+        if (len == 0 || len == group->end - group->begin) {
+          continue;
+        }
+        const float cost = sah_bounds_area(bounds) * (float)len + cost_right[i];
+        if (cost < cost_best) {
+          cost_best = cost;
+          split_axis = axis;
+          split_bin = i;
+          split_scale = scale;
+        }
+      }
+    }
+  }
+
+  int mid;
+  if (split_axis != -1) {
+    const float centroid_min = centroid_bounds[2 * split_axis];
+    int j = group->end;
+    i = group->begin;
+    while (i < j) {
+      if (sah_bin_index(sah_centroid(leafs_array[i], split_axis), centroid_min, split_scale) <
+          split_bin) {
+        i++;
+      }
+      else {
+        j--;
+        SWAP(BVHNode *, leafs_array[i], leafs_array[j]);
+      }
+    }
+    mid = i;
+  }
+  else {
+    /* All centroids in the same place or the tree is getting too deep. */
+    split_axis = get_largest_axis(centroid_bounds) / 2;
+    mid = (group->begin + group->end) / 2;
+    partition_nth_element(leafs_array, group->begin, group->end, mid, split_axis * 2);
+  }
+
+  r_groups[0].begin = group->begin;
+  r_groups[0].end = mid;
+  r_groups[1].begin = mid;
+  r_groups[1].end = group->end;
+  for (int side = 0; side < 2; side++) {
+    r_groups[side].depth = group->depth + 1;
+    sah_bounds_init(r_groups[side].bounds);
+    for (i = r_groups[side].begin; i < r_groups[side].end; i++) {
+      sah_bounds_add(r_groups[side].bounds, leafs_array[i]->bv);
+    }
+  }
+
+  return split_axis;
+}
+
+/**
+ * Build a tree from the given leafs splitting them using the surface area heuristic,
+ * the branches are created on \a branches_array, starting at index 1 like the implicit tree.
+ *
+ * \return the number of branches.
+ */
+static int sah_bvh_div_nodes(const BVHTree *tree,
+                             BVHNode *branches_array,
+                             BVHNode **leafs_array,
+                             int num_leafs)
+{
+  BVHSAHTask *stack = MEM_mallocN(sizeof(*stack) * (size_t)num_leafs, __func__);
+  int stack_len = 0;
+  int num_branches = 1;
+
+  BLI_assert(num_leafs > 1);
+  BLI_assert(leafs_array == tree->nodes);
+
+  branches_array[1].parent = NULL;
+  stack[stack_len++] = (BVHSAHTask){.branch = 1, .begin = 0, .end = num_leafs, .depth = 0};
+
+  while (stack_len) {
+    const BVHSAHTask task = stack[--stack_len];
+    BVHNode *parent = &branches_array[task.branch];
+    BVHSAHGroup groups[MAX_TREETYPE];
+    int groups_len = 1;
+    int k;
+
+    refit_kdop_hull(tree, parent, task.begin, task.end);
+
+    groups[0].begin = task.begin;
+    groups[0].end = task.end;
+    groups[0].depth = task.depth;
+    sah_bounds_init(groups[0].bounds);
+    for (k = task.begin; k < task.end; k++) {
+      sah_bounds_add(groups[0].bounds, leafs_array[k]->bv);
+    }
+
+    /* Split the children with the largest area, until all children are used. */
+    while (groups_len < tree->tree_type) {
+      int split_index = -1;
+      float split_area = -1.0f;
+      for (k = 0; k < groups_len; k++) {
+        if (groups[k].end - groups[k].begin > 1) {
+          const float area = sah_bounds_area(groups[k].bounds);
+          if (area > split_area) {
+            split_area = area;
+            split_index = k;
+          }
+        }
+      }
+      if (split_index == -1) {
+        break;
+      }
+
+      BVHSAHGroup groups_split[2];
+      const int split_axis = sah_split(leafs_array, &groups[split_index], groups_split);
+      if (groups_len == 1) {
+        /* Save split axis (this can be used on raytracing to speedup the query time) */
+        parent->main_axis = (char)split_axis;
+      }
+
+      memmove(&groups[split_index + 2],
+              &groups[split_index + 1],
+              sizeof(*groups) * (size_t)(groups_len - split_index - 1));
+      groups[split_index] = groups_split[0];
+      groups[split_index + 1] = groups_split[1];
+      groups_len++;
+    }
+
+    for (k = 0; k < groups_len; k++) {
+      if (groups[k].end - groups[k].begin > 1) {
+        const int branch = ++num_branches;
+        parent->children[k] = &branches_array[branch];
+        stack[stack_len++] = (BVHSAHTask){
+            .branch = branch,
+            .begin = groups[k].begin,
+            .end = groups[k].end,
+            .depth = groups[k].depth,
+        };
+      }
+      else {
+        parent->children[k] = leafs_array[groups[k].begin];
+      }
+      parent->children[k]->parent = parent;
+    }
+    parent->totnode = (char)groups_len;
+  }
+
+  MEM_freeN(stack);
+
+  return num_branches;
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name BLI_bvhtree API
  * \{ */
@@ -949,21 +1233,61 @@ void BLI_bvhtree_free(BVHTree *tree)
   }
 }
 
-void BLI_bvhtree_balance(BVHTree *tree)
+/**
+ * Grow the node arrays to hold \a numnodes nodes, this moves the nodes
+ * so it's only possible before the tree is balanced.
+ */
+static void bvhtree_nodes_reserve(BVHTree *tree, const int numnodes)
 {
-  BVHNode **leafs_array = tree->nodes;
+  int i;
 
+  BLI_assert(tree->totbranch == 0);
+
+  if ((size_t)numnodes <= MEM_allocN_len(tree->nodearray) / sizeof(*tree->nodearray)) {
+    return;
+  }
+
+  tree->nodes = MEM_recallocN(tree->nodes, sizeof(BVHNode *) * (size_t)numnodes);
+  tree->nodebv = MEM_recallocN(tree->nodebv, sizeof(float) * (size_t)(tree->axis * numnodes));
+  tree->nodechild = MEM_recallocN(tree->nodechild,
+                                  sizeof(BVHNode *) * (size_t)(tree->tree_type * numnodes));
+  tree->nodearray = MEM_recallocN(tree->nodearray, sizeof(BVHNode) * (size_t)numnodes);
+
+  /* link the dynamic bv and child links */
+  for (i = 0; i < numnodes; i++) {
+    tree->nodearray[i].bv = &tree->nodebv[i * tree->axis];
+    tree->nodearray[i].children = &tree->nodechild[i * tree->tree_type];
+  }
+  for (i = 0; i < tree->totleaf; i++) {
+    tree->nodes[i] = &tree->nodearray[i];
+  }
+}
+
+/**
+ * \param flag: #BVH_BALANCE_SAH to split the leafs using the surface area heuristic,
+ * this allocates more branches and the tree can be deeper, but ray-casts visit less nodes.
+ */
+void BLI_bvhtree_balance_ex(BVHTree *tree, const int flag)
+{
   /* This function should only be called once
    * (some big bug goes here if its being called more than once per tree) */
   BLI_assert(tree->totbranch == 0);
 
-  /* Build the implicit tree */
-  non_recursive_bvh_div_nodes(
-      tree, tree->nodearray + (tree->totleaf - 1), leafs_array, tree->totleaf);
+  if ((flag & BVH_BALANCE_SAH) && (tree->totleaf > tree->tree_type)) {
+    /* In the worst case every branch has only two children. */
+    bvhtree_nodes_reserve(tree, 2 * tree->totleaf - 1);
+    tree->totbranch = sah_bvh_div_nodes(
+        tree, tree->nodearray + (tree->totleaf - 1), tree->nodes, tree->totleaf);
+  }
+  else {
+    /* Build the implicit tree */
+    non_recursive_bvh_div_nodes(
+        tree, tree->nodearray + (tree->totleaf - 1), tree->nodes, tree->totleaf);
+    tree->totbranch = implicit_needed_branches(tree->tree_type, tree->totleaf);
+  }
 
   /* current code expects the branches to be linked to the nodes array
    * we perform that linkage here */
-  tree->totbranch = implicit_needed_branches(tree->tree_type, tree->totleaf);
   for (int i = 0; i < tree->totbranch; i++) {
     tree->nodes[tree->totleaf + i] = &tree->nodearray[tree->totleaf + i];
   }
@@ -981,6 +1305,11 @@ void BLI_bvhtree_balance(BVHTree *tree)
 #endif
 }
 
+void BLI_bvhtree_balance(BVHTree *tree)
+{
+  BLI_bvhtree_balance_ex(tree, 0);
+}
+
 void BLI_bvhtree_insert(BVHTree *tree, int index, const float co[3], int numpoints)
 {
   axis_t axis_iter;
@@ -1989,6 +2318,238 @@ void BLI_bvhtree_ray_cast_all(BVHTree *tree,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name BLI_bvhtree_ray_cast_packet
+ *
+ * Ray-cast #BVH_RAYCAST_PACKET_SIZE rays together, testing the bounds of each node against
+ * all rays of the packet at once (using SSE when available).
+ * Rays that start close together and point in similar directions (such as rays cast from
+ * a view, or along a normal from neighboring vertices) visit mostly the same nodes,
+ * so this saves walking the tree for each of them.
+ *
+ * \{ */
+
+typedef struct BVHRayPacketData {
+  const BVHTree *tree;
+
+  BVHTree_RayCastCallback callback;
+  void *userdata;
+
+  /* Stored per axis for the bounds test,
+   * unused lanes are set up so they never hit (#BVHRayPacketData.hit_dist is -FLT_MAX). */
+  float origin[3][BVH_RAYCAST_PACKET_SIZE];
+  float idot_axis[3][BVH_RAYCAST_PACKET_SIZE];
+  float hit_dist[BVH_RAYCAST_PACKET_SIZE];
+
+  /** Minimum distance to the bounding volume, rays with a radius don't hit behind the origin. */
+  float dist_min;
+  float radius;
+  /** Sum of the ray directions, to pick the loop direction to dive into the tree. */
+  float dir_sum[3];
+
+  int rays_len;
+  BVHTreeRay ray[BVH_RAYCAST_PACKET_SIZE];
+#ifdef USE_KDOPBVH_WATERTIGHT
+  struct IsectRayPrecalc isect_precalc[BVH_RAYCAST_PACKET_SIZE];
+#endif
+  BVHTreeRayHit *hit;
+} BVHRayPacketData;
+
+/**
+ * Test the rays against the bounding volume of a node,
+ * same as #fast_ray_nearest_hit and #ray_nearest_hit for rays with a radius.
+ *
+ * \return a bit for every ray that hits.
+ */
+static int ray_packet_nearest_hit(const BVHRayPacketData *data,
+                                  const float bv[6],
+                                  float r_dist[BVH_RAYCAST_PACKET_SIZE])
+{
+#ifdef __SSE2__
+  __m128 dist_near = _mm_set1_ps(data->dist_min);
+  __m128 dist_far = _mm_set1_ps(FLT_MAX);
+
+  for (int i = 0; i < 3; i++) {
+    const __m128 origin = _mm_loadu_ps(data->origin[i]);
+    const __m128 idot_axis = _mm_loadu_ps(data->idot_axis[i]);
+    const __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(bv[2 * i] - data->radius), origin),
+                                 idot_axis);
+    const __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(bv[2 * i + 1] + data->radius), origin),
+                                 idot_axis);
+    dist_near = _mm_max_ps(dist_near, _mm_min_ps(t1, t2));
+    dist_far = _mm_min_ps(dist_far, _mm_max_ps(t1, t2));
+  }
+
+  const __m128 hit = _mm_and_ps(
+      _mm_and_ps(_mm_cmple_ps(dist_near, dist_far), _mm_cmpge_ps(dist_far, _mm_setzero_ps())),
+      _mm_cmplt_ps(dist_near, _mm_loadu_ps(data->hit_dist)));
+
+  _mm_storeu_ps(r_dist, dist_near);
+  return _mm_movemask_ps(hit);
+#else
+  int mask = 0;
+
+  for (int lane = 0; lane < BVH_RAYCAST_PACKET_SIZE; lane++) {
+    float dist_near = data->dist_min;
+    float dist_far = FLT_MAX;
+
+    for (int i = 0; i < 3; i++) {
+      const float t1 = (bv[2 * i] - data->radius - data->origin[i][lane]) *
+                       data->idot_axis[i][lane];
+      const float t2 = (bv[2 * i + 1] + data->radius - data->origin[i][lane]) *
+                       data->idot_axis[i][lane];
+      dist_near = max_ff(dist_near, min_ff(t1, t2));
+      dist_far = min_ff(dist_far, max_ff(t1, t2));
+    }
+
+    if (dist_near <= dist_far && dist_far >= 0.0f && dist_near < data->hit_dist[lane]) {
+      mask |= 1 << lane;
+    }
+    r_dist[lane] = dist_near;
+  }
+  return mask;
+#endif
+}
+
+static void dfs_raycast_packet(BVHRayPacketData *data, const BVHNode *node)
+{
+  float dist[BVH_RAYCAST_PACKET_SIZE];
+  int i;
+
+  const int mask = ray_packet_nearest_hit(data, node->bv, dist);
+  if (mask == 0) {
+    return;
+  }
+
+  if (node->totnode == 0) {
+    for (i = 0; i < data->rays_len; i++) {
+      if (mask & (1 << i)) {
+        BVHTreeRayHit *hit = &data->hit[i];
+        if (data->callback) {
+          data->callback(data->userdata, node->index, &data->ray[i], hit);
+        }
+        else {
+          hit->index = node->index;
+          hit->dist = dist[i];
+          madd_v3_v3v3fl(hit->co, data->ray[i].origin, data->ray[i].direction, dist[i]);
+        }
+        data->hit_dist[i] = hit->dist;
+      }
+    }
+  }
+  else {
+    /* pick loop direction to dive into the tree (based on ray direction and split axis) */
+    if (data->dir_sum[node->main_axis] > 0.0f) {
+      for (i = 0; i != node->totnode; i++) {
+        dfs_raycast_packet(data, node->children[i]);
+      }
+    }
+    else {
+      for (i = node->totnode - 1; i >= 0; i--) {
+        dfs_raycast_packet(data, node->children[i]);
+      }
+    }
+  }
+}
+
+static void bvhtree_ray_packet_data_precalc(BVHRayPacketData *data,
+                                            const float (*co)[3],
+                                            const float (*dir)[3],
+                                            BVHTreeRayHit *hits,
+                                            const int rays_len,
+                                            int flag)
+{
+  int lane, i;
+
+  data->rays_len = rays_len;
+  data->hit = hits;
+  zero_v3(data->dir_sum);
+
+  for (lane = 0; lane < BVH_RAYCAST_PACKET_SIZE; lane++) {
+    if (lane >= rays_len) {
+      for (i = 0; i < 3; i++) {
+        data->origin[i][lane] = 0.0f;
+        data->idot_axis[i][lane] = 0.0f;
+      }
+      data->hit_dist[lane] = -FLT_MAX;
+      continue;
+    }
+
+    BVHTreeRay *ray = &data->ray[lane];
+
+    BLI_ASSERT_UNIT_V3(dir[lane]);
+
+    copy_v3_v3(ray->origin, co[lane]);
+    copy_v3_v3(ray->direction, dir[lane]);
+    ray->radius = data->radius;
+    add_v3_v3(data->dir_sum, ray->direction);
+
+    for (i = 0; i < 3; i++) {
+      data->origin[i][lane] = ray->origin[i];
+      /* Same as #bvhtree_ray_cast_data_precalc, the kdop axes 0-2 are the x, y & z axis. */
+      data->idot_axis[i][lane] = (fabsf(ray->direction[i]) < FLT_EPSILON) ?
+                                     FLT_MAX :
+                                     1.0f / ray->direction[i];
+    }
+    data->hit_dist[lane] = hits[lane].dist;
+
+#ifdef USE_KDOPBVH_WATERTIGHT
+    if (flag & BVH_RAYCAST_WATERTIGHT) {
+      isect_ray_tri_watertight_v3_precalc(&data->isect_precalc[lane], ray->direction);
+      ray->isect_precalc = &data->isect_precalc[lane];
+    }
+    else {
+      ray->isect_precalc = NULL;
+    }
+#else
+    UNUSED_VARS(flag);
+#endif
+  }
+}
+
+/**
+ * Ray-cast many rays, giving the same results as calling #BLI_bvhtree_ray_cast_ex for each.
+ * Rays are traversed in packets of #BVH_RAYCAST_PACKET_SIZE,
+ * so neighboring rays in the arrays should be coherent to benefit from this.
+ *
+ * \param hits: One hit for every ray, initialized like the \a hit argument of
+ * #BLI_bvhtree_ray_cast_ex (index -1 and the maximum distance to search).
+ * The \a callback can find the ray being cast from the hit pointer.
+ */
+void BLI_bvhtree_ray_cast_packet(BVHTree *tree,
+                                 const float (*co)[3],
+                                 const float (*dir)[3],
+                                 const int rays_len,
+                                 float radius,
+                                 BVHTreeRayHit *hits,
+                                 BVHTree_RayCastCallback callback,
+                                 void *userdata,
+                                 int flag)
+{
+  BVHRayPacketData data;
+  BVHNode *root = tree->nodes[tree->totleaf];
+
+  if (root == NULL) {
+    return;
+  }
+
+  data.tree = tree;
+
+  data.callback = callback;
+  data.userdata = userdata;
+
+  data.radius = radius;
+  data.dist_min = (radius == 0.0f) ? -FLT_MAX : 0.0f;
+
+  for (int i = 0; i < rays_len; i += BVH_RAYCAST_PACKET_SIZE) {
+    bvhtree_ray_packet_data_precalc(
+        &data, &co[i], &dir[i], &hits[i], min_ii(rays_len - i, BVH_RAYCAST_PACKET_SIZE), flag);
+    dfs_raycast_packet(&data, root);
+  }
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name BLI_bvhtree_range_query
  *
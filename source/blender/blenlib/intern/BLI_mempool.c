@@ -27,6 +27,8 @@
  * - Freeing chunks.
  * - Iterating over allocated chunks
  *   (optionally when using the #BLI_MEMPOOL_ALLOW_ITER flag).
+ * - Allocating and freeing from multiple threads
+ *   (optionally when using the #BLI_MEMPOOL_THREAD_SAFE flag).
  */
 
 #include <string.h>
@@ -37,6 +39,7 @@
 #include "BLI_utildefines.h"
 
 #include "BLI_mempool.h" /* own include */
+#include "BLI_threads.h"
 
 #include "MEM_guardedalloc.h"
 
@@ -98,6 +101,30 @@ typedef struct BLI_freenode {
   intptr_t freeword;
 } BLI_freenode;
 
+/**
+ * Free elements of the threads using a #BLI_MEMPOOL_THREAD_SAFE pool.
+ * Threads are assigned one of #MEMPOOL_THREADS by the order they first use any pool in,
+ * more threads share them.
+ *
+ * Threads freeing elements other threads allocated give them back to #BLI_mempool.free once
+ * they have #MEMPOOL_THREAD_FREE_MAX, threads that run out take up to a chunk worth from there
+ * before allocating a new chunk.
+ */
+typedef struct BLI_mempool_thread {
+  /** Spin lock, see #mempool_lock. */
+  uint lock;
+  uint free_len;
+  BLI_freenode *free;
+  BLI_freenode *free_tail;
+  /** Elements allocated minus elements freed by the thread, negative when it frees more. */
+  int totused;
+  /* Keep the data of different threads on their own cache line. */
+  char _pad[64];
+} BLI_mempool_thread;
+
+#define MEMPOOL_THREADS 64
+#define MEMPOOL_THREAD_FREE_MAX(pool) ((pool)->pchunk * 2)
+
 /**
  * A chunk of memory in the mempool stored in
  * #BLI_mempool.chunks as a double linked list.
@@ -135,6 +162,14 @@ struct BLI_mempool {
   /** Number of elements allocated in total. */
   uint totalloc;
 #endif
+
+  /** Only for #BLI_MEMPOOL_THREAD_SAFE, used instead of totused,
+   * #BLI_mempool.free is then shared by all threads. */
+  BLI_mempool_thread *threads;
+  BLI_freenode *free_tail;
+  uint free_len;
+  /** Protects #BLI_mempool.chunks and #BLI_mempool.free from multiple threads. */
+  uint chunks_lock;
 };
 
 #define MEMPOOL_ELEM_SIZE_MIN (sizeof(void *) * 2)
@@ -184,24 +219,10 @@ static BLI_mempool_chunk *mempool_chunk_alloc(BLI_mempool *pool)
   return MEM_mallocN(sizeof(BLI_mempool_chunk) + (size_t)pool->csize, "BLI_Mempool Chunk");
 }
 
-/**
- * Initialize a chunk and add into \a pool->chunks
- *
- * \param pool: The pool to add the chunk into.
- * \param mpchunk: The new uninitialized chunk (can be malloc'd)
- * \param last_tail: The last element of the previous chunk
- * (used when building free chunks initially)
- * \return The last chunk,
- */
-static BLI_freenode *mempool_chunk_add(BLI_mempool *pool,
-                                       BLI_mempool_chunk *mpchunk,
-                                       BLI_freenode *last_tail)
+static void mempool_chunk_append(BLI_mempool *pool, BLI_mempool_chunk *mpchunk)
 {
-  const uint esize = pool->esize;
-  BLI_freenode *curnode = CHUNK_DATA(mpchunk);
-  uint j;
+  mpchunk->next = NULL;
 
-  /* append */
   if (pool->chunk_tail) {
     pool->chunk_tail->next = mpchunk;
   }
@@ -210,12 +231,19 @@ static BLI_freenode *mempool_chunk_add(BLI_mempool *pool,
     pool->chunks = mpchunk;
   }
 
-  mpchunk->next = NULL;
   pool->chunk_tail = mpchunk;
+}
 
-  if (UNLIKELY(pool->free == NULL)) {
-    pool->free = curnode;
-  }
+/**
+ * Link all elements of a new chunk as free elements.
+ *
+ * \return The last element.
+ */
+static BLI_freenode *mempool_chunk_free_init(const BLI_mempool *pool, BLI_mempool_chunk *mpchunk)
+{
+  const uint esize = pool->esize;
+  BLI_freenode *curnode = CHUNK_DATA(mpchunk);
+  uint j;
 
   /* loop through the allocated data, building the pointer structures */
   j = pool->pchunk;
@@ -238,6 +266,32 @@ static BLI_freenode *mempool_chunk_add(BLI_mempool *pool,
   curnode = NODE_STEP_PREV(curnode);
   curnode->next = NULL;
 
+  return curnode;
+}
+
+/**
+ * Initialize a chunk and add into \a pool->chunks
+ *
+ * \param pool: The pool to add the chunk into.
+ * \param mpchunk: The new uninitialized chunk (can be malloc'd)
+ * \param last_tail: The last element of the previous chunk
+ * (used when building free chunks initially)
+ * \return The last chunk,
+ */
+static BLI_freenode *mempool_chunk_add(BLI_mempool *pool,
+                                       BLI_mempool_chunk *mpchunk,
+                                       BLI_freenode *last_tail)
+{
+  BLI_freenode *curnode;
+
+  mempool_chunk_append(pool, mpchunk);
+
+  if (UNLIKELY(pool->free == NULL)) {
+    pool->free = CHUNK_DATA(mpchunk);
+  }
+
+  curnode = mempool_chunk_free_init(pool, mpchunk);
+
 #ifdef USE_TOTALLOC
   pool->totalloc += pool->pchunk;
 #endif
@@ -265,6 +319,155 @@ static void mempool_chunk_free_all(BLI_mempool_chunk *mpchunk)
   }
 }
 
+/* Not using #SpinLock, makesdna builds this file without the rest of BLI_threads. */
+BLI_INLINE void mempool_lock(uint *lock)
+{
+  while (atomic_cas_u(lock, 0, 1) != 0) {
+    /* pass */
+  }
+}
+
+BLI_INLINE void mempool_unlock(uint *lock)
+{
+  atomic_cas_u(lock, 1, 0);
+}
+
+#ifndef __APPLE__
+static ThreadLocal(uint) mempool_thread_index = 0;
+static uint mempool_thread_index_last = 0;
+#endif
+
+BLI_INLINE BLI_mempool_thread *mempool_thread_get(BLI_mempool *pool)
+{
+#ifdef __APPLE__
+  /* Thread local storage needs a key created up front here, spread the threads by ID instead. */
+  const uint64_t id = (uint64_t)(uintptr_t)pthread_self();
+  const uint index = (uint)((id * 0x9E3779B97F4A7C15ull) >> 32);
+#else
+  if (UNLIKELY(mempool_thread_index == 0)) {
+    mempool_thread_index = atomic_add_and_fetch_u(&mempool_thread_index_last, 1);
+  }
+  const uint index = mempool_thread_index;
+#endif
+  return &pool->threads[index % MEMPOOL_THREADS];
+}
+
+/**
+ * Share the free elements of the pool with all threads.
+ */
+static void mempool_threads_reset(BLI_mempool *pool)
+{
+  for (uint i = 0; i < MEMPOOL_THREADS; i++) {
+    pool->threads[i].free = NULL;
+    pool->threads[i].free_tail = NULL;
+    pool->threads[i].free_len = 0;
+    pool->threads[i].totused = 0;
+  }
+  pool->free_tail = NULL;
+  pool->free_len = 0;
+  for (BLI_freenode *curnode = pool->free; curnode; curnode = curnode->next) {
+    pool->free_tail = curnode;
+    pool->free_len++;
+  }
+}
+
+/**
+ * Take shared free elements, the thread has none left. At most a chunk worth, so the thread
+ * stays below #MEMPOOL_THREAD_FREE_MAX and leaves the rest to other threads.
+ */
+static void mempool_thread_free_take(BLI_mempool *pool, BLI_mempool_thread *thread)
+{
+  mempool_lock(&pool->chunks_lock);
+  if (pool->free_len <= pool->pchunk) {
+    thread->free = pool->free;
+    thread->free_tail = pool->free_tail;
+    thread->free_len = pool->free_len;
+    pool->free = NULL;
+    pool->free_tail = NULL;
+    pool->free_len = 0;
+  }
+  else {
+    BLI_freenode *free_tail = pool->free;
+    for (uint i = 1; i < pool->pchunk; i++) {
+      free_tail = free_tail->next;
+    }
+    thread->free = pool->free;
+    thread->free_tail = free_tail;
+    thread->free_len = pool->pchunk;
+    pool->free = free_tail->next;
+    pool->free_len -= pool->pchunk;
+    free_tail->next = NULL;
+  }
+  mempool_unlock(&pool->chunks_lock);
+}
+
+/**
+ * Give all free elements of the thread back to the shared ones.
+ */
+static void mempool_thread_free_give(BLI_mempool *pool, BLI_mempool_thread *thread)
+{
+  mempool_lock(&pool->chunks_lock);
+  thread->free_tail->next = pool->free;
+  if (pool->free == NULL) {
+    pool->free_tail = thread->free_tail;
+  }
+  pool->free = thread->free;
+  pool->free_len += thread->free_len;
+  mempool_unlock(&pool->chunks_lock);
+  thread->free = NULL;
+  thread->free_tail = NULL;
+  thread->free_len = 0;
+}
+
+static void *mempool_alloc_threadsafe(BLI_mempool *pool)
+{
+  BLI_mempool_thread *thread = mempool_thread_get(pool);
+  BLI_freenode *free_pop;
+
+  mempool_lock(&thread->lock);
+
+  /* Skip the lock when there is obviously nothing to take. */
+  if (UNLIKELY(thread->free == NULL) && pool->free != NULL) {
+    mempool_thread_free_take(pool, thread);
+  }
+
+  if (UNLIKELY(thread->free == NULL)) {
+    /* The new chunk is only used by this thread, add it before handing out elements
+     * so other threads can find the elements when freeing them. */
+    BLI_mempool_chunk *mpchunk = mempool_chunk_alloc(pool);
+    thread->free_tail = mempool_chunk_free_init(pool, mpchunk);
+    mempool_lock(&pool->chunks_lock);
+    mempool_chunk_append(pool, mpchunk);
+#ifdef USE_TOTALLOC
+    pool->totalloc += pool->pchunk;
+#endif
+    mempool_unlock(&pool->chunks_lock);
+    thread->free = CHUNK_DATA(mpchunk);
+    thread->free_len = pool->pchunk;
+  }
+
+  free_pop = thread->free;
+
+  if (pool->flag & BLI_MEMPOOL_ALLOW_ITER) {
+    free_pop->freeword = USEDWORD;
+  }
+
+  thread->free = free_pop->next;
+  thread->free_len--;
+  if (thread->free == NULL) {
+    thread->free_tail = NULL;
+  }
+  thread->totused++;
+
+  mempool_unlock(&thread->lock);
+
+#ifdef WITH_MEM_VALGRIND
+  VALGRIND_MEMPOOL_ALLOC(pool, free_pop, pool->esize);
+#endif
+
+  return (void *)free_pop;
+}
+
 BLI_mempool *BLI_mempool_create(uint esize, uint totelem, uint pchunk, uint flag)
 {
   BLI_mempool *pool;
@@ -315,6 +518,7 @@ BLI_mempool *BLI_mempool_create(uint esize, uint totelem, uint pchunk, uint flag
   pool->totalloc = 0;
 #endif
   pool->totused = 0;
+  pool->threads = NULL;
 
   if (totelem) {
     /* Allocate the actual chunks. */
@@ -324,6 +528,15 @@ BLI_mempool *BLI_mempool_create(uint esize, uint totelem, uint pchunk, uint flag
     }
   }
 
+  if (flag & BLI_MEMPOOL_THREAD_SAFE) {
+    pool->threads = MEM_mallocN_aligned(sizeof(*pool->threads) * MEMPOOL_THREADS, 64, __func__);
+    for (i = 0; i < MEMPOOL_THREADS; i++) {
+      pool->threads[i].lock = 0;
+    }
+    pool->chunks_lock = 0;
+    mempool_threads_reset(pool);
+  }
+
 #ifdef WITH_MEM_VALGRIND
   VALGRIND_CREATE_MEMPOOL(pool, 0, false);
 #endif
@@ -335,6 +548,10 @@ void *BLI_mempool_alloc(BLI_mempool *pool)
 {
   BLI_freenode *free_pop;
 
+  if (pool->flag & BLI_MEMPOOL_THREAD_SAFE) {
+    return mempool_alloc_threadsafe(pool);
+  }
+
   if (UNLIKELY(pool->free == NULL)) {
     /* Need to allocate a new chunk. */
     BLI_mempool_chunk *mpchunk = mempool_chunk_alloc(pool);
@@ -404,6 +621,27 @@ void BLI_mempool_free(BLI_mempool *pool, void *addr)
     newhead->freeword = FREEWORD;
   }
 
+  if (pool->flag & BLI_MEMPOOL_THREAD_SAFE) {
+    /* Keep all chunks, other threads may be using them. */
+    BLI_mempool_thread *thread = mempool_thread_get(pool);
+    mempool_lock(&thread->lock);
+    if (thread->free == NULL) {
+      thread->free_tail = newhead;
+    }
+    newhead->next = thread->free;
+    thread->free = newhead;
+    thread->totused--;
+    if (UNLIKELY(++thread->free_len >= MEMPOOL_THREAD_FREE_MAX(pool))) {
+      mempool_thread_free_give(pool, thread);
+    }
+    mempool_unlock(&thread->lock);
+
+#ifdef WITH_MEM_VALGRIND
+    VALGRIND_MEMPOOL_FREE(pool, addr);
+#endif
+    return;
+  }
+
   newhead->next = pool->free;
   pool->free = newhead;
 
@@ -453,6 +691,13 @@ void BLI_mempool_free(BLI_mempool *pool, void *addr)
 
 int BLI_mempool_len(BLI_mempool *pool)
 {
+  if (pool->flag & BLI_MEMPOOL_THREAD_SAFE) {
+    int totused = 0;
+    for (uint i = 0; i < MEMPOOL_THREADS; i++) {
+      totused += pool->threads[i].totused;
+    }
+    return totused;
+  }
   return (int)pool->totused;
 }
 
@@ -460,7 +705,7 @@ void *BLI_mempool_findelem(BLI_mempool *pool, uint index)
 {
   BLI_assert(pool->flag & BLI_MEMPOOL_ALLOW_ITER);
 
-  if (index < pool->totused) {
+  if (index < (uint)BLI_mempool_len(pool)) {
     /* We could have some faster mem chunk stepping code inline. */
     BLI_mempool_iter iter;
     void *elem;
@@ -491,7 +736,7 @@ void BLI_mempool_as_table(BLI_mempool *pool, void **data)
   while ((elem = BLI_mempool_iterstep(&iter))) {
     *p++ = elem;
   }
-  BLI_assert((uint)(p - data) == pool->totused);
+  BLI_assert((uint)(p - data) == (uint)BLI_mempool_len(pool));
 }
 
 /**
@@ -499,7 +744,7 @@ void BLI_mempool_as_table(BLI_mempool *pool, void **data)
  */
 void **BLI_mempool_as_tableN(BLI_mempool *pool, const char *allocstr)
 {
-  void **data = MEM_mallocN((size_t)pool->totused * sizeof(void *), allocstr);
+  void **data = MEM_mallocN((size_t)BLI_mempool_len(pool) * sizeof(void *), allocstr);
   BLI_mempool_as_table(pool, data);
   return data;
 }
@@ -518,7 +763,7 @@ void BLI_mempool_as_array(BLI_mempool *pool, void *data)
     memcpy(p, elem, (size_t)esize);
     p = NODE_STEP_NEXT(p);
   }
-  BLI_assert((uint)(p - (char *)data) == pool->totused * esize);
+  BLI_assert((uint)(p - (char *)data) == (uint)BLI_mempool_len(pool) * esize);
 }
 
 /**
@@ -526,7 +771,7 @@ void BLI_mempool_as_array(BLI_mempool *pool, void *data)
  */
 void *BLI_mempool_as_arrayN(BLI_mempool *pool, const char *allocstr)
 {
-  char *data = MEM_malloc_arrayN(pool->totused, pool->esize, allocstr);
+  char *data = MEM_malloc_arrayN((size_t)BLI_mempool_len(pool), pool->esize, allocstr);
   BLI_mempool_as_array(pool, data);
   return data;
 }
@@ -741,6 +986,10 @@ void BLI_mempool_clear_ex(BLI_mempool *pool, const int totelem_reserve)
     chunks_temp = mpchunk->next;
     last_tail = mempool_chunk_add(pool, mpchunk, last_tail);
   }
+
+  if (pool->flag & BLI_MEMPOOL_THREAD_SAFE) {
+    mempool_threads_reset(pool);
+  }
 }
 
 /**
@@ -758,6 +1007,10 @@ void BLI_mempool_destroy(BLI_mempool *pool)
 {
   mempool_chunk_free_all(pool->chunks);
 
+  if (pool->flag & BLI_MEMPOOL_THREAD_SAFE) {
+    MEM_freeN(pool->threads);
+  }
+
 #ifdef WITH_MEM_VALGRIND
   VALGRIND_DESTROY_MEMPOOL(pool);
 #endif
@@ -0,0 +1,172 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+/** \file
+ * \ingroup bli
+ *
+ * The bytes of the values are split into planes, the first byte of every value followed by the
+ * second byte of every value and so on. For a delta (the XOR of two states for e.g.) sign and
+ * exponent bytes mostly stay zero, as do the values that didn't change. The planes are then
+ * stored as pairs of literal bytes and zero runs, both prefixed by their length.
+ */
+
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_byte_planes.h"
+#include "BLI_utildefines.h"
+
+#include "BLI_strict_flags.h"
+
+/* Zero runs shorter than this are kept in the literal bytes. */
+#define ZERO_RUN_MIN 8
+
+static uchar *varint_pack(uchar *dst, size_t value)
+{
+  while (value >= 0x80) {
+    *dst++ = (uchar)(value | 0x80);
+    value >>= 7;
+  }
+  *dst++ = (uchar)value;
+  return dst;
+}
+
+static const uchar *varint_unpack(const uchar *src, size_t *r_value)
+{
+  size_t value = 0;
+  uint shift = 0;
+  while (*src & 0x80) {
+    value |= (size_t)(*src++ & 0x7f) << shift;
+    shift += 7;
+  }
+  value |= (size_t)(*src++) << shift;
+  *r_value = value;
+  return src;
+}
+
+/**
+ * Store \a src as pairs of literal bytes and zero runs.
+ * \a dst needs #zero_runs_pack_bound bytes.
+ */
+static size_t zero_runs_pack(const uchar *src, const size_t len, uchar *dst)
+{
+  uchar *dst_start = dst;
+  size_t i = 0;
+
+  while (i < len) {
+    size_t literal_end = i, zero_end;
+    while (true) {
+      while (literal_end < len && src[literal_end] != 0) {
+        literal_end++;
+      }
+      zero_end = literal_end;
+      while (zero_end < len && src[zero_end] == 0) {
+        zero_end++;
+      }
+      if (zero_end == len || zero_end - literal_end >= ZERO_RUN_MIN) {
+        break;
+      }
+      literal_end = zero_end;
+    }
+
+    dst = varint_pack(dst, literal_end - i);
+    memcpy(dst, &src[i], literal_end - i);
+    dst += literal_end - i;
+    dst = varint_pack(dst, zero_end - literal_end);
+    i = zero_end;
+  }
+
+  return (size_t)(dst - dst_start);
+}
+
+/* Every pair but the last consumes at least #ZERO_RUN_MIN bytes. */
+static size_t zero_runs_pack_bound(const size_t len)
+{
+  return len + len / 3 + 16;
+}
+
+static void zero_runs_unpack(const uchar *src, uchar *dst, const size_t len)
+{
+  size_t i = 0;
+
+  while (i < len) {
+    size_t literal_len, zero_len;
+    src = varint_unpack(src, &literal_len);
+    memcpy(&dst[i], src, literal_len);
+    src += literal_len;
+    i += literal_len;
+    src = varint_unpack(src, &zero_len);
+    memset(&dst[i], 0, zero_len);
+    i += zero_len;
+  }
+  BLI_assert(i == len);
+}
+
+/**
+ * Pack \a values_len values of \a stride bytes each.
+ *
+ * \param r_packed: Set to the packed data, owned by the caller.
+ * \return The size of the packed data.
+ */
+size_t BLI_byte_planes_pack(const void *values,
+                            const size_t values_len,
+                            const size_t stride,
+                            void **r_packed)
+{
+  const uchar *bytes = values;
+  const size_t planes_len = stride * values_len;
+  uchar *planes = MEM_mallocN(MAX2(planes_len, (size_t)1), __func__);
+
+  for (size_t b = 0; b < stride; b++) {
+    uchar *plane = &planes[b * values_len];
+    for (size_t i = 0; i < values_len; i++) {
+      plane[i] = bytes[i * stride + b];
+    }
+  }
+
+  uchar *packed = MEM_mallocN(zero_runs_pack_bound(planes_len), __func__);
+  const size_t packed_size = zero_runs_pack(planes, planes_len, packed);
+  MEM_freeN(planes);
+
+  *r_packed = MEM_reallocN(packed, MAX2(packed_size, (size_t)1));
+  return packed_size;
+}
+
+/**
+ * Unpack the values packed by #BLI_byte_planes_pack into \a r_values,
+ * which holds \a values_len values of \a stride bytes each.
+ */
+void BLI_byte_planes_unpack(const void *packed,
+                            const size_t values_len,
+                            const size_t stride,
+                            void *r_values)
+{
+  uchar *bytes = r_values;
+  const size_t planes_len = stride * values_len;
+  uchar *planes = MEM_mallocN(MAX2(planes_len, (size_t)1), __func__);
+
+  zero_runs_unpack(packed, planes, planes_len);
+  for (size_t b = 0; b < stride; b++) {
+    const uchar *plane = &planes[b * values_len];
+    for (size_t i = 0; i < values_len; i++) {
+      bytes[i * stride + b] = plane[i];
+    }
+  }
+
+  MEM_freeN(planes);
+}
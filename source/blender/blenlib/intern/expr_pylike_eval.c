@@ -29,14 +29,15 @@
  *  - Literals:
  *      floating point and decimal integer.
  *  - Constants:
- *      pi, True, False
+ *      pi, e, tau, True, False
  *  - Operators:
- *      +, -, *, /, ==, !=, <, <=, >, >=, and, or, not, ternary if
+ *      +, -, *, /, //, %, **, ==, !=, <, <=, >, >=, and, or, not, ternary if
  *  - Functions:
  *      min, max, radians, degrees,
- *      abs, fabs, floor, ceil, trunc, int,
+ *      abs, fabs, floor, ceil, trunc, int, round, float, bool,
  *      sin, cos, tan, asin, acos, atan, atan2,
- *      exp, log, sqrt, pow, fmod
+ *      sinh, cosh, tanh, asinh, acosh, atanh,
+ *      exp, log, log10, log2, sqrt, pow, fmod, hypot, copysign
  *
  * The implementation has no global state and can be used multi-threaded.
  */
@@ -316,6 +317,68 @@ static double op_sub(double a, double b)
   return a - b;
 }
 
+/* Python modulo, the result has the sign of the divisor. */
+static double op_mod(double a, double b)
+{
+  double mod = fmod(a, b);
+
+  if (mod != 0.0 && (b < 0.0) != (mod < 0.0)) {
+    mod += b;
+  }
+
+  return mod;
+}
+
+/* Python floor division, the same as CPython's `float_floor_div`. */
+static double op_floor_div(double a, double b)
+{
+  double mod = fmod(a, b);
+  double div = (a - mod) / b;
+
+  if (mod != 0.0 && (b < 0.0) != (mod < 0.0)) {
+    div -= 1.0;
+  }
+
+  if (div != 0.0) {
+    double floordiv = floor(div);
+
+    if (div - floordiv > 0.5) {
+      floordiv += 1.0;
+    }
+
+    return floordiv;
+  }
+
+  return copysign(0.0, a / b);
+}
+
+static double op_log_base(double a, double b)
+{
+  return log(a) / log(b);
+}
+
+/* Python 3 rounds halfway cases to the even neighbor. */
+static double op_round(double arg)
+{
+  double result = round(arg);
+
+  if (fabs(arg - trunc(arg)) == 0.5) {
+    result = 2.0 * round(arg * 0.5);
+  }
+
+  return result;
+}
+
+static double op_float(double arg)
+{
+  return arg;
+}
+
+static double op_bool(double arg)
+{
+  return arg ? 1.0 : 0.0;
+}
+
 static double op_radians(double arg)
 {
   return arg * M_PI / 180.0;
@@ -367,7 +430,13 @@ typedef struct BuiltinConstDef {
 } BuiltinConstDef;
 
 static BuiltinConstDef builtin_consts[] = {
-    {"pi", M_PI}, {"True", 1.0}, {"False", 0.0}, {NULL, 0.0}};
+    {"pi", M_PI},
+    {"e", M_E},
+    {"tau", M_PI * 2.0},
+    {"True", 1.0},
+    {"False", 0.0},
+    {NULL, 0.0},
+};
 
 typedef struct BuiltinOpDef {
   const char *name;
@@ -391,6 +460,9 @@ static BuiltinOpDef builtin_ops[] = {
     {"ceil", OPCODE_FUNC1, ceil},
     {"trunc", OPCODE_FUNC1, trunc},
     {"int", OPCODE_FUNC1, trunc},
+    {"round", OPCODE_FUNC1, op_round},
+    {"float", OPCODE_FUNC1, op_float},
+    {"bool", OPCODE_FUNC1, op_bool},
     {"sin", OPCODE_FUNC1, sin},
     {"cos", OPCODE_FUNC1, cos},
     {"tan", OPCODE_FUNC1, tan},
@@ -398,11 +470,23 @@ static BuiltinOpDef builtin_ops[] = {
     {"acos", OPCODE_FUNC1, acos},
     {"atan", OPCODE_FUNC1, atan},
     {"atan2", OPCODE_FUNC2, atan2},
+    {"sinh", OPCODE_FUNC1, sinh},
+    {"cosh", OPCODE_FUNC1, cosh},
+    {"tanh", OPCODE_FUNC1, tanh},
+    {"asinh", OPCODE_FUNC1, asinh},
+    {"acosh", OPCODE_FUNC1, acosh},
+    {"atanh", OPCODE_FUNC1, atanh},
     {"exp", OPCODE_FUNC1, exp},
+    /* Functions with an optional argument are listed once for each argument count. */
     {"log", OPCODE_FUNC1, log},
+    {"log", OPCODE_FUNC2, op_log_base},
+    {"log10", OPCODE_FUNC1, log10},
+    {"log2", OPCODE_FUNC1, log2},
     {"sqrt", OPCODE_FUNC1, sqrt},
     {"pow", OPCODE_FUNC2, pow},
     {"fmod", OPCODE_FUNC2, fmod},
+    {"hypot", OPCODE_FUNC2, hypot},
+    {"copysign", OPCODE_FUNC2, copysign},
     {NULL, OPCODE_CONST, NULL},
 };
 
@@ -428,6 +512,8 @@ static BuiltinOpDef builtin_ops[] = {
 #define TOKEN_LE MAKE_CHAR2('<', '=')
 #define TOKEN_NE MAKE_CHAR2('!', '=')
 #define TOKEN_EQ MAKE_CHAR2('=', '=')
+#define TOKEN_POW MAKE_CHAR2('*', '*')
+#define TOKEN_FLOORDIV MAKE_CHAR2('/', '/')
 #define TOKEN_AND MAKE_CHAR2('A', 'N')
 #define TOKEN_OR MAKE_CHAR2('O', 'R')
 #define TOKEN_NOT MAKE_CHAR2('N', 'O')
@@ -435,6 +521,7 @@ static BuiltinOpDef builtin_ops[] = {
 #define TOKEN_ELSE MAKE_CHAR2('E', 'L')
 
 static const char *token_eq_characters = "!=><";
+static const char *token_double_characters = "*/";
 static const char *token_characters = "~`!@#$%^&*+-=/\\?:;<>(){}[]|.,\"'";
 
 typedef struct KeywordTokenDef {
@@ -639,6 +726,13 @@ static bool parse_next_token(ExprParseState *state)
     return true;
   }
 
+  /* ** and // tokens */
+  if (state->cur[0] == state->cur[1] && strchr(token_double_characters, state->cur[0])) {
+    state->token = MAKE_CHAR2(state->cur[0], state->cur[1]);
+    state->cur += 2;
+    return true;
+  }
+
   /* Special characters (single character tokens) */
   if (strchr(token_characters, *state->cur)) {
     state->token = *state->cur++;
@@ -711,19 +805,23 @@ static int parse_function_args(ExprParseState *state)
   }
 }
 
-static bool parse_unary(ExprParseState *state)
+static int parse_builtin_op_args(const BuiltinOpDef *op)
+{
+  switch (op->op) {
+    case OPCODE_FUNC1:
+      return 1;
+    case OPCODE_FUNC2:
+      return 2;
+    default:
+      return -1;
+  }
+}
+
+static bool parse_primary(ExprParseState *state)
 {
   int i;
 
   switch (state->token) {
-    case '+':
-      return parse_next_token(state) && parse_unary(state);
-
-    case '-':
-      CHECK_ERROR(parse_next_token(state) && parse_unary(state));
-      parse_add_func(state, OPCODE_FUNC1, 1, op_negate);
-      return true;
-
     case '(':
       return parse_next_token(state) && parse_expr(state) && state->token == ')' &&
              parse_next_token(state);
@@ -753,9 +851,17 @@ static bool parse_unary(ExprParseState *state)
       /* Ordinary builtin functions. */
       for (i = 0; builtin_ops[i].name; i++) {
         if (STREQ(state->tokenbuf, builtin_ops[i].name)) {
+          const char *name = builtin_ops[i].name;
           int args = parse_function_args(state);
 
-          return parse_add_func(state, builtin_ops[i].op, args, builtin_ops[i].funcptr);
+          /* Find the variant taking this many arguments. */
+          for (; builtin_ops[i].name && STREQ(builtin_ops[i].name, name); i++) {
+            if (parse_builtin_op_args(&builtin_ops[i]) == args) {
+              return parse_add_func(state, builtin_ops[i].op, args, builtin_ops[i].funcptr);
+            }
+          }
+
+          return false;
         }
       }
 
@@ -783,6 +889,38 @@ static bool parse_unary(ExprParseState *state)
   }
 }
 
+static bool parse_unary(ExprParseState *state);
+
+/* The power operator binds tighter than a unary operator on its left, but not on its right:
+ * "-2 ** -1" is "-(2 ** (-1))". */
+static bool parse_power(ExprParseState *state)
+{
+  CHECK_ERROR(parse_primary(state));
+
+  if (state->token == TOKEN_POW) {
+    CHECK_ERROR(parse_next_token(state) && parse_unary(state));
+    parse_add_func(state, OPCODE_FUNC2, 2, pow);
+  }
+
+  return true;
+}
+
+static bool parse_unary(ExprParseState *state)
+{
+  switch (state->token) {
+    case '+':
+      return parse_next_token(state) && parse_unary(state);
+
+    case '-':
+      CHECK_ERROR(parse_next_token(state) && parse_unary(state));
+      parse_add_func(state, OPCODE_FUNC1, 1, op_negate);
+      return true;
+
+    default:
+      return parse_power(state);
+  }
+}
+
 static bool parse_mul(ExprParseState *state)
 {
   CHECK_ERROR(parse_unary(state));
@@ -799,6 +937,16 @@ static bool parse_mul(ExprParseState *state)
         parse_add_func(state, OPCODE_FUNC2, 2, op_div);
         break;
 
+      case TOKEN_FLOORDIV:
+        CHECK_ERROR(parse_next_token(state) && parse_unary(state));
+        parse_add_func(state, OPCODE_FUNC2, 2, op_floor_div);
+        break;
+
+      case '%':
+        CHECK_ERROR(parse_next_token(state) && parse_unary(state));
+        parse_add_func(state, OPCODE_FUNC2, 2, op_mod);
+        break;
+
       default:
         return true;
     }
@@ -0,0 +1,733 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup bli
+ *
+ * Every island is rasterized into a bit mask for each rotation, conservatively and grown by
+ * half the margin, so islands whose masks don't overlap are at least the margin apart.
+ *
+ * Islands are placed largest first into a grid of fixed width that grows upwards,
+ * at the position and rotation which keeps the top of the island lowest.
+ * Rows are searched in parallel, rows which can't improve on a position already found
+ * are skipped. The best position is picked in row order, so the layout doesn't depend on
+ * the number of threads.
+ *
+ * Several grid widths are tried, converging to a square layout, until the efficiency target
+ * or time limit is reached.
+ */
+
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_math_base.h"
+#include "BLI_math_bits.h"
+#include "BLI_math_vector.h"
+#include "BLI_raster_pack_2d.h"
+#include "BLI_task.h"
+#include "BLI_utildefines.h"
+
+#include "PIL_time.h"
+
+#include "atomic_ops.h"
+
+#include "BLI_strict_flags.h"
+
+#define WORD_BITS 64
+#define ROW_WORDS(width) (((width) + (WORD_BITS - 1)) / WORD_BITS)
+
+/* Grid widths tried before settling for the best layout. */
+#define PACK_PASSES_MAX 8
+
+/* -------------------------------------------------------------------- */
+/** \name Island Masks
+ * \{ */
+
+typedef struct RasterMask {
+  /** Size in cells. */
+  int width, height;
+  int row_words;
+  /** Number of occupied cells. */
+  int cells;
+  /** Position of the first cell in rotated island space. */
+  float origin[2];
+  uint64_t *bits;
+  /** Longest run of occupied cells in every row. */
+  int *runs;
+} RasterMask;
+
+typedef struct RasterIsland {
+  /** One mask for every rotation. */
+  RasterMask *masks;
+  /** Lowest mask width and height over all rotations. */
+  int width_min, height_min;
+  int height_max;
+  uint index;
+} RasterIsland;
+
+/**
+ * Longest run of cells with the given state in a row.
+ */
+static int raster_row_run_longest(const uint64_t *row, const int width, const bool occupied)
+{
+  int run = 0, run_longest = 0;
+  for (int x = 0; x < width; x++) {
+    if (((row[x / WORD_BITS] >> (x % WORD_BITS)) & 1) == occupied) {
+      run++;
+      run_longest = max_ii(run_longest, run);
+    }
+    else {
+      run = 0;
+    }
+  }
+  return run_longest;
+}
+
+/**
+ * Separating axis test between a triangle and an axis aligned box.
+ */
+static bool raster_tri_box_overlap(const float tri[3][2], const float min[2], const float max[2])
+{
+  for (int axis = 0; axis < 2; axis++) {
+    if (max_fff(tri[0][axis], tri[1][axis], tri[2][axis]) < min[axis] ||
+        min_fff(tri[0][axis], tri[1][axis], tri[2][axis]) > max[axis]) {
+      return false;
+    }
+  }
+
+  for (int i = 0; i < 3; i++) {
+    const float *a = tri[i], *b = tri[(i + 1) % 3], *c = tri[(i + 2) % 3];
+    const float n[2] = {a[1] - b[1], b[0] - a[0]};
+    const float d = dot_v2v2(n, a);
+    /* Extent of the box along the edge normal, relative to the edge. */
+    const float box_lo = n[0] * ((n[0] > 0.0f) ? min[0] : max[0]) +
+                         n[1] * ((n[1] > 0.0f) ? min[1] : max[1]) - d;
+    const float box_hi = n[0] * ((n[0] > 0.0f) ? max[0] : min[0]) +
+                         n[1] * ((n[1] > 0.0f) ? max[1] : min[1]) - d;
+
+    if ((dot_v2v2(n, c) - d >= 0.0f) ? (box_hi < 0.0f) : (box_lo > 0.0f)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void raster_mask_build(RasterMask *mask,
+                              const RasterPackIsland *island,
+                              const float angle,
+                              const float cell_size,
+                              const float half_margin)
+{
+  const float cosine = cosf(angle), sine = sinf(angle);
+  float(*tris)[3][2] = MEM_mallocN(sizeof(*tris) * MAX2(island->tris_len, 1u), __func__);
+  float min[2], max[2];
+
+  INIT_MINMAX2(min, max);
+  for (uint i = 0; i < island->tris_len; i++) {
+    for (int j = 0; j < 3; j++) {
+      const float *co = island->tris[i][j];
+      tris[i][j][0] = cosine * co[0] - sine * co[1];
+      tris[i][j][1] = sine * co[0] + cosine * co[1];
+      minmax_v2v2_v2(min, max, tris[i][j]);
+    }
+  }
+  if (island->tris_len == 0) {
+    zero_v2(min);
+    zero_v2(max);
+  }
+
+  mask->origin[0] = min[0] - half_margin;
+  mask->origin[1] = min[1] - half_margin;
+  mask->width = max_ii(1, (int)ceilf((max[0] - min[0] + 2.0f * half_margin) / cell_size));
+  mask->height = max_ii(1, (int)ceilf((max[1] - min[1] + 2.0f * half_margin) / cell_size));
+  mask->row_words = ROW_WORDS(mask->width);
+  mask->bits = MEM_callocN(sizeof(*mask->bits) * (size_t)(mask->row_words * mask->height),
+                           __func__);
+  mask->cells = 0;
+
+  for (uint i = 0; i < island->tris_len; i++) {
+    float tri_min[2], tri_max[2];
+    INIT_MINMAX2(tri_min, tri_max);
+    for (int j = 0; j < 3; j++) {
+      minmax_v2v2_v2(tri_min, tri_max, tris[i][j]);
+    }
+
+    const int x_min = max_ii(0, (int)floorf((tri_min[0] - min[0]) / cell_size) - 1);
+    const int y_min = max_ii(0, (int)floorf((tri_min[1] - min[1]) / cell_size) - 1);
+    const int x_max = min_ii(mask->width - 1,
+                             (int)((tri_max[0] - mask->origin[0] + half_margin) / cell_size));
+    const int y_max = min_ii(mask->height - 1,
+                             (int)((tri_max[1] - mask->origin[1] + half_margin) / cell_size));
+
+    for (int y = y_min; y <= y_max; y++) {
+      uint64_t *row = mask->bits + y * mask->row_words;
+      for (int x = x_min; x <= x_max; x++) {
+        uint64_t *word = &row[x / WORD_BITS];
+        const uint64_t bit = (uint64_t)1 << (x % WORD_BITS);
+        if (*word & bit) {
+          continue;
+        }
+        /* The cell grown by half the margin. */
+        const float box_min[2] = {mask->origin[0] + (float)x * cell_size - half_margin,
+                                  mask->origin[1] + (float)y * cell_size - half_margin};
+        const float box_max[2] = {box_min[0] + cell_size + 2.0f * half_margin,
+                                  box_min[1] + cell_size + 2.0f * half_margin};
+        if (raster_tri_box_overlap(tris[i], box_min, box_max)) {
+          *word |= bit;
+          mask->cells++;
+        }
+      }
+    }
+  }
+
+  mask->runs = MEM_mallocN(sizeof(*mask->runs) * (size_t)mask->height, __func__);
+  for (int y = 0; y < mask->height; y++) {
+    mask->runs[y] = raster_row_run_longest(mask->bits + y * mask->row_words, mask->width, true);
+  }
+
+  MEM_freeN(tris);
+}
+
+typedef struct RasterMaskBuildData {
+  const RasterPackIsland *islands;
+  RasterIsland *raster_islands;
+  int rotations;
+  float cell_size;
+  float half_margin;
+} RasterMaskBuildData;
+
+static void raster_masks_build_cb(void *__restrict userdata,
+                                  const int i,
+                                  const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const RasterMaskBuildData *data = userdata;
+  RasterIsland *raster_island = &data->raster_islands[i];
+
+  raster_island->index = (uint)i;
+  raster_island->masks = MEM_mallocN(sizeof(RasterMask) * (size_t)data->rotations, __func__);
+  raster_island->width_min = raster_island->height_min = INT_MAX;
+  raster_island->height_max = 0;
+
+  for (int r = 0; r < data->rotations; r++) {
+    RasterMask *mask = &raster_island->masks[r];
+    raster_mask_build(mask,
+                      &data->islands[i],
+                      (float)(2.0 * M_PI) * (float)r / (float)data->rotations,
+                      data->cell_size,
+                      data->half_margin);
+    raster_island->width_min = min_ii(raster_island->width_min, mask->width);
+    raster_island->height_min = min_ii(raster_island->height_min, mask->height);
+    raster_island->height_max = max_ii(raster_island->height_max, mask->height);
+  }
+}
+
+static int raster_island_cmp(const void *a_, const void *b_)
+{
+  const RasterIsland *a = a_, *b = b_;
+  /* Largest first, keep the input order otherwise. */
+  if (a->masks[0].cells != b->masks[0].cells) {
+    return (a->masks[0].cells > b->masks[0].cells) ? -1 : 1;
+  }
+  return (a->index > b->index) ? 1 : ((a->index < b->index) ? -1 : 0);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Occupancy Grid
+ * \{ */
+
+typedef struct RasterGrid {
+  /** Fixed width in cells. */
+  int width;
+  /** Words per row, with padding so masks can be tested at any position without bounds checks. */
+  int row_words;
+  int rows_alloc;
+  /** Rows containing islands, everything above is empty. */
+  int rows_used;
+  /** All rows below are completely occupied. */
+  int rows_full;
+  /** Columns containing islands. */
+  int width_used;
+  uint64_t *bits;
+  /** Longest run of free cells in every row, to skip rows without testing every position. */
+  int *runs;
+} RasterGrid;
+
+typedef struct RasterPlacement {
+  int x, y, rotation;
+} RasterPlacement;
+
+static void raster_grid_init(RasterGrid *grid, const int width, const int rows_alloc)
+{
+  grid->width = width;
+  grid->row_words = ROW_WORDS(width) + 2;
+  grid->rows_alloc = max_ii(rows_alloc, 1);
+  grid->rows_used = 0;
+  grid->rows_full = 0;
+  grid->width_used = 0;
+  grid->bits = MEM_callocN(sizeof(*grid->bits) * (size_t)(grid->row_words * grid->rows_alloc),
+                           __func__);
+  grid->runs = MEM_mallocN(sizeof(*grid->runs) * (size_t)grid->rows_alloc, __func__);
+  for (int y = 0; y < grid->rows_alloc; y++) {
+    grid->runs[y] = width;
+  }
+}
+
+static void raster_grid_free(RasterGrid *grid)
+{
+  MEM_freeN(grid->bits);
+  MEM_freeN(grid->runs);
+}
+
+/**
+ * Test the longest runs of free cells first, this rules out most rows which are nearly full.
+ */
+static bool raster_grid_fits_rows(const RasterGrid *grid, const RasterMask *mask, const int y)
+{
+  const int rows = min_ii(mask->height, grid->rows_used - y);
+  for (int j = 0; j < rows; j++) {
+    if (mask->runs[j] > grid->runs[y + j]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Find the first position in row \a y where the mask fits, -1 if there is none.
+ *
+ * All positions are tested at once, as bits of \a candidates: for every occupied cell of the
+ * mask, the positions which would put it on an occupied cell of the grid are removed.
+ */
+static int raster_grid_find_x(const RasterGrid *grid,
+                              const RasterMask *mask,
+                              const int y,
+                              uint64_t *candidates)
+{
+  const int positions = grid->width - mask->width + 1;
+  const int words = ROW_WORDS(positions);
+  const int rows = min_ii(mask->height, grid->rows_used - y);
+
+  for (int k = 0; k < words; k++) {
+    candidates[k] = UINT64_MAX;
+  }
+  if (positions % WORD_BITS) {
+    candidates[words - 1] = ((uint64_t)1 << (positions % WORD_BITS)) - 1;
+  }
+
+  for (int j = 0; j < rows; j++) {
+    const uint64_t *grid_row = grid->bits + (y + j) * grid->row_words;
+    const uint64_t *mask_row = mask->bits + j * mask->row_words;
+    for (int b = 0; b < mask->width; b++) {
+      const int word = b / WORD_BITS, shift = b % WORD_BITS;
+      if (((mask_row[word] >> shift) & 1) == 0) {
+        continue;
+      }
+      uint64_t any = 0;
+      for (int k = 0; k < words; k++) {
+        uint64_t occupied = grid_row[k + word] >> shift;
+        if (shift) {
+          occupied |= grid_row[k + word + 1] << (WORD_BITS - shift);
+        }
+        candidates[k] &= ~occupied;
+        any |= candidates[k];
+      }
+      if (any == 0) {
+        return -1;
+      }
+    }
+  }
+
+  for (int k = 0; k < words; k++) {
+    if (candidates[k]) {
+      const uint low = (uint)(candidates[k] & UINT32_MAX);
+      return k * WORD_BITS + (int)(low ? bitscan_forward_uint(low) :
+                                         32 + bitscan_forward_uint((uint)(candidates[k] >> 32)));
+    }
+  }
+  return -1;
+}
+
+static void raster_grid_insert(RasterGrid *grid, const RasterMask *mask, const int x, const int y)
+{
+  const int word = x / WORD_BITS, shift = x % WORD_BITS;
+
+  if (y + mask->height > grid->rows_alloc) {
+    const int rows_alloc = max_ii(y + mask->height, grid->rows_alloc * 2);
+    grid->bits = MEM_recallocN(grid->bits,
+                               sizeof(*grid->bits) * (size_t)(grid->row_words * rows_alloc));
+    grid->runs = MEM_reallocN(grid->runs, sizeof(*grid->runs) * (size_t)rows_alloc);
+    for (int j = grid->rows_alloc; j < rows_alloc; j++) {
+      grid->runs[j] = grid->width;
+    }
+    grid->rows_alloc = rows_alloc;
+  }
+
+  for (int j = 0; j < mask->height; j++) {
+    uint64_t *grid_row = grid->bits + (y + j) * grid->row_words + word;
+    const uint64_t *mask_row = mask->bits + j * mask->row_words;
+    for (int k = 0; k < mask->row_words; k++) {
+      grid_row[k] |= mask_row[k] << shift;
+      if (shift) {
+        grid_row[k + 1] |= mask_row[k] >> (WORD_BITS - shift);
+      }
+    }
+    grid->runs[y + j] = raster_row_run_longest(
+        grid->bits + (y + j) * grid->row_words, grid->width, false);
+  }
+
+  grid->rows_used = max_ii(grid->rows_used, y + mask->height);
+  grid->width_used = max_ii(grid->width_used, x + mask->width);
+  while (grid->rows_full < grid->rows_used && grid->runs[grid->rows_full] == 0) {
+    grid->rows_full++;
+  }
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Placement Search
+ * \{ */
+
+typedef struct RasterSearchData {
+  const RasterGrid *grid;
+  const RasterIsland *island;
+  int rotations;
+  int y_start;
+  /** Best position found in every row, x is -1 when nothing fits. */
+  RasterPlacement *row_best;
+  /** Lowest island top found so far, only used to skip rows. */
+  int top_best;
+} RasterSearchData;
+
+typedef struct RasterSearchTLS {
+  /** Positions in a row which are still possible, one bit each. */
+  uint64_t *candidates;
+} RasterSearchTLS;
+
+static void raster_search_row_cb(void *__restrict userdata,
+                                 const int iter,
+                                 const TaskParallelTLS *__restrict tls)
+{
+  RasterSearchData *data = userdata;
+  RasterSearchTLS *search_tls = tls->userdata_chunk;
+  const RasterGrid *grid = data->grid;
+  const int y = data->y_start + iter;
+  RasterPlacement *best = &data->row_best[iter];
+  int top_best = INT_MAX;
+
+  best->x = -1;
+
+  /* Ties are still searched, so the result doesn't depend on which rows are skipped. */
+  if (y + data->island->height_min > data->top_best) {
+    return;
+  }
+
+  if (search_tls->candidates == NULL) {
+    search_tls->candidates = MEM_mallocN(sizeof(uint64_t) * (size_t)ROW_WORDS(grid->width),
+                                         __func__);
+  }
+
+  for (int r = 0; r < data->rotations; r++) {
+    const RasterMask *mask = &data->island->masks[r];
+    const int top = y + mask->height;
+
+    if (mask->width > grid->width || top > top_best || top > data->top_best ||
+        !raster_grid_fits_rows(grid, mask, y)) {
+      continue;
+    }
+    const int x = raster_grid_find_x(grid, mask, y, search_tls->candidates);
+    if (x != -1 && (top < top_best || x < best->x)) {
+      top_best = top;
+      best->x = x;
+      best->y = y;
+      best->rotation = r;
+    }
+  }
+
+  if (best->x != -1) {
+    int top_old = data->top_best;
+    while (top_best < top_old) {
+      const int top_prev = atomic_cas_int32((int32_t *)&data->top_best, top_old, top_best);
+      if (top_prev == top_old) {
+        break;
+      }
+      top_old = top_prev;
+    }
+  }
+}
+
+static void raster_search_finalize_cb(void *__restrict UNUSED(userdata), void *__restrict chunk)
+{
+  RasterSearchTLS *search_tls = chunk;
+  if (search_tls->candidates) {
+    MEM_freeN(search_tls->candidates);
+  }
+}
+
+static void raster_search(const RasterGrid *grid,
+                          const RasterIsland *island,
+                          const int rotations,
+                          RasterPlacement *row_best,
+                          RasterPlacement *r_placement)
+{
+  /* Everything fits above the used rows, so there is no need to look further. */
+  const int rows = grid->rows_used - grid->rows_full + 1;
+  RasterSearchData data = {
+      .grid = grid,
+      .island = island,
+      .rotations = rotations,
+      .y_start = grid->rows_full,
+      .row_best = row_best,
+      .top_best = INT_MAX,
+  };
+
+  RasterSearchTLS search_tls = {NULL};
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (rows > 4);
+  settings.userdata_chunk = &search_tls;
+  settings.userdata_chunk_size = sizeof(search_tls);
+  settings.func_finalize = raster_search_finalize_cb;
+  /* Rows are handed out in order, so early rows find the positions later rows are skipped by. */
+  settings.min_iter_per_thread = 1;
+  settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+  BLI_task_parallel_range(0, rows, &data, raster_search_row_cb, &settings);
+
+  int top_best = INT_MAX;
+  r_placement->x = -1;
+  for (int i = 0; i < rows; i++) {
+    const RasterPlacement *placement = &row_best[i];
+    if (placement->x != -1) {
+      const int top = placement->y + island->masks[placement->rotation].height;
+      if (top < top_best) {
+        top_best = top;
+        *r_placement = *placement;
+      }
+    }
+  }
+  BLI_assert(r_placement->x != -1);
+}
+
+/**
+ * Place all islands into a grid of the given width,
+ * \a r_width and \a r_height are set to the size of the layout in cells.
+ */
+static void raster_pack_pass(const RasterIsland *raster_islands,
+                             const uint islands_len,
+                             const int rotations,
+                             const int width,
+                             const double time_end,
+                             RasterPlacement *r_placements,
+                             int *r_width,
+                             int *r_height)
+{
+  RasterGrid grid;
+  int rows_max = 1;
+  bool use_shelves = false;
+  int shelf_x = 0, shelf_y = 0, shelf_height = 0;
+
+  /* Every island raises the layout by at most its own height. */
+  for (uint i = 0; i < islands_len; i++) {
+    rows_max += raster_islands[i].height_max;
+  }
+  raster_grid_init(&grid, width, min_ii(rows_max, width * 2));
+
+  RasterPlacement *row_best = MEM_mallocN(sizeof(*row_best) * (size_t)(rows_max + 1), __func__);
+
+  for (uint i = 0; i < islands_len; i++) {
+    const RasterIsland *island = &raster_islands[i];
+    RasterPlacement *placement = &r_placements[island->index];
+
+    if (!use_shelves && time_end != 0.0 && PIL_check_seconds_timer() > time_end) {
+      use_shelves = true;
+      shelf_y = grid.rows_used;
+    }
+
+    if (use_shelves) {
+      /* Out of time, put islands next to each other above everything else. */
+      int r = 0;
+      while (island->masks[r].width > width) {
+        r++;
+      }
+      const RasterMask *mask = &island->masks[r];
+      if (shelf_x + mask->width > width) {
+        shelf_y += shelf_height;
+        shelf_x = shelf_height = 0;
+      }
+      placement->x = shelf_x;
+      placement->y = shelf_y;
+      placement->rotation = r;
+      shelf_x += mask->width;
+      shelf_height = max_ii(shelf_height, mask->height);
+    }
+    else {
+      raster_search(&grid, island, rotations, row_best, placement);
+    }
+
+    raster_grid_insert(&grid, &island->masks[placement->rotation], placement->x, placement->y);
+  }
+
+  *r_width = grid.width_used;
+  *r_height = grid.rows_used;
+
+  MEM_freeN(row_best);
+  raster_grid_free(&grid);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Public API
+ * \{ */
+
+void BLI_raster_pack_2d_params_defaults(RasterPackParams *params)
+{
+  params->resolution = 256;
+  params->rotations = 4;
+  params->margin = 0.0f;
+  params->efficiency_target = 0.9f;
+  params->time_limit = 0.0;
+}
+
+/**
+ * Pack islands by their shape, rasterized into an occupancy grid.
+ *
+ * \param r_tot_width, r_tot_height: The size of the packed layout,
+ * island positions are in the range [0, r_tot_width] x [0, r_tot_height].
+ */
+void BLI_raster_pack_2d(RasterPackIsland *islands,
+                        const uint islands_len,
+                        const RasterPackParams *params,
+                        float *r_tot_width,
+                        float *r_tot_height)
+{
+  const double time_start = PIL_check_seconds_timer();
+  const double time_end = (params->time_limit > 0.0) ? time_start + params->time_limit : 0.0;
+  const int rotations = max_ii(params->rotations, 1);
+  const float half_margin = max_ff(params->margin, 0.0f) * 0.5f;
+
+  *r_tot_width = *r_tot_height = 0.0f;
+  if (islands_len == 0) {
+    return;
+  }
+
+  /* Choose the cell size from the total area, so the amount of work doesn't depend on scale. */
+  double area = 0.0;
+  for (uint i = 0; i < islands_len; i++) {
+    for (uint j = 0; j < islands[i].tris_len; j++) {
+      const float(*tri)[2] = islands[i].tris[j];
+      area += (double)fabsf(cross_tri_v2(tri[0], tri[1], tri[2])) * 0.5;
+    }
+  }
+  float cell_size = (float)sqrt(area) / (float)max_ii(params->resolution, 1);
+  if (!(cell_size > 0.0f)) {
+    cell_size = max_ff(half_margin * 2.0f, 1.0f);
+  }
+
+  RasterIsland *raster_islands = MEM_mallocN(sizeof(*raster_islands) * islands_len, __func__);
+  {
+    RasterMaskBuildData data = {
+        .islands = islands,
+        .raster_islands = raster_islands,
+        .rotations = rotations,
+        .cell_size = cell_size,
+        .half_margin = half_margin,
+    };
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.use_threading = (islands_len > 16);
+    BLI_task_parallel_range(0, (int)islands_len, &data, raster_masks_build_cb, &settings);
+  }
+
+  qsort(raster_islands, islands_len, sizeof(*raster_islands), raster_island_cmp);
+
+  double cells = 0.0;
+  int width_min = 1;
+  for (uint i = 0; i < islands_len; i++) {
+    cells += (double)raster_islands[i].masks[0].cells;
+    width_min = max_ii(width_min, raster_islands[i].width_min);
+  }
+
+  RasterPlacement *placements = MEM_mallocN(sizeof(*placements) * islands_len, __func__);
+  RasterPlacement *placements_best = MEM_mallocN(sizeof(*placements) * islands_len, __func__);
+  int side_best = INT_MAX, width_best = 0, height_best = 0;
+  int width = max_ii(width_min, (int)ceil(sqrt(cells)));
+
+  for (int pass = 0; pass < PACK_PASSES_MAX; pass++) {
+    int width_used, height_used;
+    raster_pack_pass(raster_islands,
+                     islands_len,
+                     rotations,
+                     width,
+                     time_end,
+                     placements,
+                     &width_used,
+                     &height_used);
+
+    const int side = max_ii(width_used, height_used);
+    if (side < side_best) {
+      side_best = side;
+      width_best = width_used;
+      height_best = height_used;
+      SWAP(RasterPlacement *, placements, placements_best);
+    }
+
+    if (cells / ((double)side_best * (double)side_best) >= (double)params->efficiency_target ||
+        (time_end != 0.0 && PIL_check_seconds_timer() > time_end)) {
+      break;
+    }
+
+    /* Aim for a square layout. */
+    const int width_next = max_ii(width_min, (int)sqrt((double)width * (double)height_used));
+    if (width_next == width) {
+      break;
+    }
+    width = width_next;
+  }
+
+  for (uint i = 0; i < islands_len; i++) {
+    const RasterIsland *raster_island = &raster_islands[i];
+    const RasterPlacement *placement = &placements_best[raster_island->index];
+    const RasterMask *mask = &raster_island->masks[placement->rotation];
+    RasterPackIsland *island = &islands[raster_island->index];
+
+    island->angle = (float)(2.0 * M_PI) * (float)placement->rotation / (float)rotations;
+    island->offset[0] = (float)placement->x * cell_size - mask->origin[0];
+    island->offset[1] = (float)placement->y * cell_size - mask->origin[1];
+
+    for (int r = 0; r < rotations; r++) {
+      MEM_freeN(raster_island->masks[r].bits);
+      MEM_freeN(raster_island->masks[r].runs);
+    }
+    MEM_freeN(raster_island->masks);
+  }
+
+  *r_tot_width = (float)width_best * cell_size;
+  *r_tot_height = (float)height_best * cell_size;
+
+  MEM_freeN(placements);
+  MEM_freeN(placements_best);
+  MEM_freeN(raster_islands);
+}
+
+/** \} */
@@ -0,0 +1,626 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup bli
+ *
+ * Points are hashed into a uniform grid with cells twice the size of the search range,
+ * so the points within range of a point are always in the 2x2x2 block of cells around it.
+ *
+ * Building the grid and finding which points have any others in range is done on multiple
+ * threads. Resolving which points are merged into which is done on a single thread, in index
+ * order, searching the grid again only for points which have others in range. Results are the
+ * same for any number of threads, and no lists of neighbors are kept.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_math_base.h"
+#include "BLI_math_vector.h"
+#include "BLI_spatial_hash.h"
+#include "BLI_task.h"
+#include "BLI_utildefines.h"
+
+#include "BLI_strict_flags.h"
+
+/* Cell size used when the range is zero, only points at the same location are found then. */
+#define CELL_SIZE_MIN 1e-6f
+/* Limit cell coordinates so far away points share cells instead of overflowing. */
+#define CELL_COORD_MAX (1 << 30)
+
+#define BUCKET_UNSET ((uint)-1)
+
+/* Points per task when searching in parallel. */
+#define POINTS_PER_TASK 1024
+
+/* Coordinates are stored with the index so searching a bucket reads memory in order,
+ * instead of jumping around the input array. */
+typedef struct SpatialHashPoint {
+  float co[3];
+  uint index;
+} SpatialHashPoint;
+
+typedef struct SpatialHash {
+  const char *co;
+  size_t co_stride;
+  uint co_len;
+
+  float cell_size_inv;
+  float range;
+  float range_sq;
+
+  uint bucket_mask;
+  /* Range of #SpatialHash.points in each bucket, 'bucket_start[bucket_mask + 1]' is the end. */
+  uint *bucket_start;
+  /* Points ordered by bucket, in index order within each bucket. */
+  SpatialHashPoint *points;
+  uint points_len;
+  /* Bucket of each point, #BUCKET_UNSET when it's masked out. */
+  uint *point_bucket;
+} SpatialHash;
+
+BLI_INLINE const float *spatial_hash_co(const SpatialHash *sh, const uint index)
+{
+  return (const float *)(sh->co + (size_t)index * sh->co_stride);
+}
+
+BLI_INLINE void spatial_hash_cell(const SpatialHash *sh, const float co[3], int r_cell[3])
+{
+  for (uint j = 0; j < 3; j++) {
+    const float f = floorf(co[j] * sh->cell_size_inv);
+    r_cell[j] = (int)clamp_f(f, (float)-CELL_COORD_MAX, (float)CELL_COORD_MAX);
+  }
+}
+
+BLI_INLINE uint spatial_hash_bucket(const SpatialHash *sh, const int x, const int y, const int z)
+{
+  /* Blocks of 2x2x2 cells use consecutive buckets, so the cells searched around a point
+   * are mostly next to each other in memory. */
+  const uint bx = (uint)(x + CELL_COORD_MAX), by = (uint)(y + CELL_COORD_MAX),
+             bz = (uint)(z + CELL_COORD_MAX);
+  /* Cell coordinates of points on a regular grid are multiples of each other,
+   * mix the bits so they don't all end up in a few buckets. */
+  uint h = ((bx >> 1) * 0x9E3779B1u) ^ ((by >> 1) * 0x85EBCA77u) ^ ((bz >> 1) * 0xC2B2AE3Du);
+  h ^= h >> 15;
+  h *= 0x2C1B3C6Du;
+  h ^= h >> 12;
+  return ((h << 3) | (bx & 1) | ((by & 1) << 1) | ((bz & 1) << 2)) & sh->bucket_mask;
+}
+
+/* -------------------------------------------------------------------- */
+/** \name Build
+ * \{ */
+
+typedef struct SpatialHashBuildData {
+  SpatialHash *sh;
+  const BLI_bitmap *mask;
+} SpatialHashBuildData;
+
+static void spatial_hash_point_bucket_cb(void *__restrict userdata,
+                                         const int i,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  SpatialHashBuildData *data = userdata;
+  SpatialHash *sh = data->sh;
+  const uint index = (uint)i;
+
+  if (data->mask && !BLI_BITMAP_TEST(data->mask, index)) {
+    sh->point_bucket[index] = BUCKET_UNSET;
+    return;
+  }
+
+  int cell[3];
+  spatial_hash_cell(sh, spatial_hash_co(sh, index), cell);
+  sh->point_bucket[index] = spatial_hash_bucket(sh, UNPACK3(cell));
+}
+
+static void spatial_hash_build(SpatialHash *sh,
+                               const float *co,
+                               const size_t co_stride,
+                               const uint co_len,
+                               const BLI_bitmap *mask,
+                               const float range)
+{
+  const uint buckets_len = power_of_2_max_u(MAX2(co_len, 1u));
+
+  sh->co = (const char *)co;
+  sh->co_stride = co_stride;
+  sh->co_len = co_len;
+  sh->cell_size_inv = 1.0f / max_ff(range * 2.0f, CELL_SIZE_MIN);
+  sh->range = range;
+  sh->range_sq = SQUARE(range);
+  sh->bucket_mask = buckets_len - 1;
+  sh->bucket_start = MEM_calloc_arrayN(buckets_len + 1, sizeof(*sh->bucket_start), __func__);
+  sh->points = MEM_malloc_arrayN(co_len, sizeof(*sh->points), __func__);
+  sh->point_bucket = MEM_malloc_arrayN(co_len, sizeof(*sh->point_bucket), __func__);
+
+  {
+    SpatialHashBuildData data = {
+        .sh = sh,
+        .mask = mask,
+    };
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.min_iter_per_thread = POINTS_PER_TASK;
+    BLI_task_parallel_range(0, (int)co_len, &data, spatial_hash_point_bucket_cb, &settings);
+  }
+
+  /* Counting sort of the points by bucket. */
+  for (uint i = 0; i < co_len; i++) {
+    if (sh->point_bucket[i] != BUCKET_UNSET) {
+      sh->bucket_start[sh->point_bucket[i] + 1]++;
+    }
+  }
+  for (uint bucket = 0; bucket < buckets_len; bucket++) {
+    sh->bucket_start[bucket + 1] += sh->bucket_start[bucket];
+  }
+  sh->points_len = sh->bucket_start[buckets_len];
+
+  uint *bucket_fill = MEM_dupallocN(sh->bucket_start);
+  for (uint i = 0; i < co_len; i++) {
+    if (sh->point_bucket[i] != BUCKET_UNSET) {
+      SpatialHashPoint *point = &sh->points[bucket_fill[sh->point_bucket[i]]++];
+      copy_v3_v3(point->co, spatial_hash_co(sh, i));
+      point->index = i;
+    }
+  }
+  MEM_freeN(bucket_fill);
+}
+
+static void spatial_hash_free(SpatialHash *sh)
+{
+  MEM_freeN(sh->bucket_start);
+  MEM_freeN(sh->points);
+  MEM_freeN(sh->point_bucket);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Neighbor Search
+ * \{ */
+
+/**
+ * Find the buckets of the cells within range of \a co, without repeating any.
+ *
+ * \return The number of buckets written to \a r_buckets.
+ */
+static uint spatial_hash_buckets_in_range(const SpatialHash *sh,
+                                          const float co[3],
+                                          uint r_buckets[27])
+{
+  uint buckets_len = 0;
+  float co_min[3], co_max[3];
+  int cell_min[3], cell_max[3];
+
+  /* Cells are twice the range, this spans one or two cells on each axis
+   * (padded a little so rounding never skips a cell). */
+  const float range_pad = sh->range * 1.0001f;
+  copy_v3_v3(co_min, co);
+  copy_v3_v3(co_max, co);
+  add_v3_fl(co_min, -range_pad);
+  add_v3_fl(co_max, range_pad);
+  spatial_hash_cell(sh, co_min, cell_min);
+  spatial_hash_cell(sh, co_max, cell_max);
+
+  for (int x = cell_min[0]; x <= cell_max[0]; x++) {
+    for (int y = cell_min[1]; y <= cell_max[1]; y++) {
+      for (int z = cell_min[2]; z <= cell_max[2]; z++) {
+        const uint bucket = spatial_hash_bucket(sh, x, y, z);
+
+        /* Different cells may share a bucket, only search it once. */
+        bool is_visited = false;
+        for (uint k = 0; k < buckets_len; k++) {
+          if (r_buckets[k] == bucket) {
+            is_visited = true;
+            break;
+          }
+        }
+        if (!is_visited) {
+          r_buckets[buckets_len++] = bucket;
+        }
+      }
+    }
+  }
+
+  return buckets_len;
+}
+
+BLI_INLINE bool spatial_hash_is_neighbor(const SpatialHash *sh,
+                                         const float co[3],
+                                         const uint index,
+                                         const bool only_higher,
+                                         const SpatialHashPoint *other)
+{
+  if ((other->index == index) || (only_higher && other->index < index)) {
+    return false;
+  }
+  return len_squared_v3v3(co, other->co) <= sh->range_sq;
+}
+
+/**
+ * Check if any point is within range of \a point (not including itself).
+ *
+ * \param only_higher: Only check points with a higher index.
+ */
+static bool spatial_hash_has_neighbors(const SpatialHash *sh,
+                                       const SpatialHashPoint *point,
+                                       const bool only_higher)
+{
+  uint buckets[27];
+  const uint buckets_len = spatial_hash_buckets_in_range(sh, point->co, buckets);
+
+  for (uint k = 0; k < buckets_len; k++) {
+    const SpatialHashPoint *other = &sh->points[sh->bucket_start[buckets[k]]];
+    const SpatialHashPoint *other_end = &sh->points[sh->bucket_start[buckets[k] + 1]];
+    for (; other != other_end; other++) {
+      if (spatial_hash_is_neighbor(sh, point->co, point->index, only_higher, other)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/**
+ * Find the points within range of point \a index (not including itself).
+ *
+ * \param only_higher: Only find points with a higher index, to find each pair once.
+ * \param r_neighbors: Array to fill, neighbors past \a neighbors_max are counted but not stored.
+ */
+static uint spatial_hash_find_neighbors(const SpatialHash *sh,
+                                        const uint index,
+                                        const bool only_higher,
+                                        uint *r_neighbors,
+                                        const uint neighbors_max)
+{
+  const float *co = spatial_hash_co(sh, index);
+  uint buckets[27];
+  const uint buckets_len = spatial_hash_buckets_in_range(sh, co, buckets);
+  uint neighbors_len = 0;
+
+  for (uint k = 0; k < buckets_len; k++) {
+    const SpatialHashPoint *other = &sh->points[sh->bucket_start[buckets[k]]];
+    const SpatialHashPoint *other_end = &sh->points[sh->bucket_start[buckets[k] + 1]];
+    for (; other != other_end; other++) {
+      if (spatial_hash_is_neighbor(sh, co, index, only_higher, other)) {
+        if (neighbors_len < neighbors_max) {
+          r_neighbors[neighbors_len] = other->index;
+        }
+        neighbors_len++;
+      }
+    }
+  }
+
+  return neighbors_len;
+}
+
+/**
+ * Find the closest point within range of \a co,
+ * the lowest index wins when several are at the same distance.
+ */
+static int spatial_hash_find_nearest(const SpatialHash *sh, const float co[3])
+{
+  uint buckets[27];
+  const uint buckets_len = spatial_hash_buckets_in_range(sh, co, buckets);
+  int best_index = -1;
+  float best_dist_sq = sh->range_sq;
+
+  for (uint k = 0; k < buckets_len; k++) {
+    const SpatialHashPoint *other = &sh->points[sh->bucket_start[buckets[k]]];
+    const SpatialHashPoint *other_end = &sh->points[sh->bucket_start[buckets[k] + 1]];
+    for (; other != other_end; other++) {
+      const float dist_sq = len_squared_v3v3(co, other->co);
+      if ((dist_sq < best_dist_sq) ||
+          ((dist_sq == best_dist_sq) && (best_index == -1 || (int)other->index < best_index))) {
+        best_dist_sq = dist_sq;
+        best_index = (int)other->index;
+      }
+    }
+  }
+  return best_index;
+}
+
+/* Storage for the neighbors of one point at a time, grown as needed. */
+typedef struct SpatialHashNeighbors {
+  uint *neighbors;
+  uint neighbors_alloc;
+} SpatialHashNeighbors;
+
+/**
+ * Find the neighbors of point \a index, see #spatial_hash_find_neighbors.
+ *
+ * \return The number of neighbors, stored in `neighbors->neighbors`.
+ */
+static uint spatial_hash_neighbors_find(const SpatialHash *sh,
+                                        const uint index,
+                                        const bool only_higher,
+                                        SpatialHashNeighbors *neighbors)
+{
+  uint len = spatial_hash_find_neighbors(
+      sh, index, only_higher, neighbors->neighbors, neighbors->neighbors_alloc);
+  if (len > neighbors->neighbors_alloc) {
+    /* Didn't fit, grow the buffer and search again. */
+    neighbors->neighbors_alloc = MAX2(neighbors->neighbors_alloc * 2, len);
+    neighbors->neighbors = MEM_reallocN(neighbors->neighbors,
+                                        sizeof(uint) * neighbors->neighbors_alloc);
+    len = spatial_hash_find_neighbors(
+        sh, index, only_higher, neighbors->neighbors, neighbors->neighbors_alloc);
+  }
+  return len;
+}
+
+typedef struct SpatialHashSearchData {
+  const SpatialHash *sh;
+  bool only_higher;
+  bool *r_has_neighbors;
+} SpatialHashSearchData;
+
+static void spatial_hash_has_neighbors_cb(void *__restrict userdata,
+                                          const int i,
+                                          const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  SpatialHashSearchData *data = userdata;
+  const SpatialHashPoint *point = &data->sh->points[i];
+
+  data->r_has_neighbors[point->index] = spatial_hash_has_neighbors(
+      data->sh, point, data->only_higher);
+}
+
+/**
+ * Find which points have any others in range, searching in bucket order so points in the same
+ * cell look at the same buckets one after another.
+ *
+ * \return An array of the length of the input, masked out points are false.
+ */
+static bool *spatial_hash_has_neighbors_calc(const SpatialHash *sh, const bool only_higher)
+{
+  SpatialHashSearchData data = {
+      .sh = sh,
+      .only_higher = only_higher,
+      .r_has_neighbors = MEM_calloc_arrayN(sh->co_len, sizeof(bool), __func__),
+  };
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = POINTS_PER_TASK;
+  BLI_task_parallel_range(
+      0, (int)sh->points_len, &data, spatial_hash_has_neighbors_cb, &settings);
+
+  return data.r_has_neighbors;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Public API
+ * \{ */
+
+/**
+ * Find duplicate points in \a range, this gives the same result as
+ * #BLI_kdtree_3d_calc_duplicates_fast using index order.
+ *
+ * \param co: The coordinates of the first point, others follow every \a co_stride bytes.
+ * \param duplicates: An array of int's the length of \a co_len.
+ * Values initialized to -1 are candidates to me merged.
+ * Setting the index to it's own position in the array prevents it from being touched,
+ * although it can still be used as a target.
+ * \returns The number of merges found (includes any merges already in the \a duplicates array).
+ *
+ * \note Merging is always a single step (target indices wont be marked for merging).
+ */
+int BLI_spatial_hash_3d_calc_duplicates(const float *co,
+                                        const size_t co_stride,
+                                        const uint co_len,
+                                        const float range,
+                                        int *duplicates)
+{
+  SpatialHash sh;
+  SpatialHashNeighbors neighbors = {NULL, 0};
+  int found = 0;
+
+  if (co_len == 0) {
+    return 0;
+  }
+
+  spatial_hash_build(&sh, co, co_stride, co_len, NULL, range);
+  bool *has_neighbors = spatial_hash_has_neighbors_calc(&sh, false);
+
+  for (uint i = 0; i < co_len; i++) {
+    const int index = (int)i;
+    if (has_neighbors[i] && ELEM(duplicates[index], -1, index)) {
+      const int found_prev = found;
+      const uint neighbors_len = spatial_hash_neighbors_find(&sh, i, false, &neighbors);
+      for (uint k = 0; k < neighbors_len; k++) {
+        const uint index_other = neighbors.neighbors[k];
+        if (duplicates[index_other] == -1) {
+          duplicates[index_other] = index;
+          found++;
+        }
+      }
+      if (found != found_prev) {
+        /* Prevent chains of doubles. */
+        duplicates[index] = index;
+      }
+    }
+  }
+
+  MEM_SAFE_FREE(neighbors.neighbors);
+  MEM_freeN(has_neighbors);
+  spatial_hash_free(&sh);
+
+  return found;
+}
+
+static int cmp_uint(const void *a_p, const void *b_p)
+{
+  const uint a = *(const uint *)a_p;
+  const uint b = *(const uint *)b_p;
+  return (a > b) - (a < b);
+}
+
+static uint cluster_find_root(uint *parent, uint index)
+{
+  while (parent[index] != index) {
+    /* Path halving. */
+    parent[index] = parent[parent[index]];
+    index = parent[index];
+  }
+  return index;
+}
+
+/**
+ * Group points which are within \a range of each other, directly or through other points.
+ *
+ * \param mask: Only points enabled in the mask are used, may be NULL.
+ * \param max_neighbors: Limit the number of points each point is joined with,
+ * points with the lowest indices are used first. Zero for no limit.
+ * \param r_clusters: An array of int's the length of \a co_len. Filled with the lowest index of
+ * the cluster each point belongs to, or -1 for points without any others in range.
+ * \returns The number of points merged into another (not counting the cluster's first point).
+ */
+int BLI_spatial_hash_3d_calc_clusters(const float *co,
+                                      const size_t co_stride,
+                                      const uint co_len,
+                                      const BLI_bitmap *mask,
+                                      const float range,
+                                      const uint max_neighbors,
+                                      int *r_clusters)
+{
+  SpatialHash sh;
+  SpatialHashNeighbors neighbors = {NULL, 0};
+  int merged_len = 0;
+
+  if (co_len == 0) {
+    return 0;
+  }
+
+  spatial_hash_build(&sh, co, co_stride, co_len, mask, range);
+  bool *has_neighbors = spatial_hash_has_neighbors_calc(&sh, true);
+
+  /* Union-find where the root is always the lowest index of the cluster. */
+  uint *parent = MEM_malloc_arrayN(co_len, sizeof(*parent), __func__);
+  for (uint i = 0; i < co_len; i++) {
+    parent[i] = i;
+  }
+
+  for (uint i = 0; i < co_len; i++) {
+    if (!has_neighbors[i]) {
+      continue;
+    }
+    uint neighbors_len = spatial_hash_neighbors_find(&sh, i, true, &neighbors);
+    if (max_neighbors != 0 && neighbors_len > max_neighbors) {
+      /* Use the neighbors with the lowest indices. */
+      qsort(neighbors.neighbors, neighbors_len, sizeof(uint), cmp_uint);
+      neighbors_len = max_neighbors;
+    }
+    for (uint k = 0; k < neighbors_len; k++) {
+      const uint root_a = cluster_find_root(parent, i);
+      const uint root_b = cluster_find_root(parent, neighbors.neighbors[k]);
+      if (root_a < root_b) {
+        parent[root_b] = root_a;
+      }
+      else if (root_b < root_a) {
+        parent[root_a] = root_b;
+      }
+    }
+  }
+
+  MEM_SAFE_FREE(neighbors.neighbors);
+  MEM_freeN(has_neighbors);
+  spatial_hash_free(&sh);
+
+  /* Points which are their own root only belong to a cluster when others were merged in. */
+  for (uint i = 0; i < co_len; i++) {
+    r_clusters[i] = -1;
+  }
+  for (uint i = 0; i < co_len; i++) {
+    const uint root = cluster_find_root(parent, i);
+    if (root != i) {
+      r_clusters[i] = (int)root;
+      r_clusters[root] = (int)root;
+      merged_len++;
+    }
+  }
+
+  MEM_freeN(parent);
+
+  return merged_len;
+}
+
+typedef struct SpatialHashNearestData {
+  const SpatialHash *sh;
+  const char *co_query;
+  size_t co_query_stride;
+  int *r_nearest;
+} SpatialHashNearestData;
+
+static void spatial_hash_find_nearest_cb(void *__restrict userdata,
+                                         const int i,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  SpatialHashNearestData *data = userdata;
+  const float *co = (const float *)(data->co_query + (size_t)i * data->co_query_stride);
+  data->r_nearest[i] = spatial_hash_find_nearest(data->sh, co);
+}
+
+/**
+ * Find the closest point to each query point within \a range,
+ * the lowest index wins when several are at the same distance.
+ *
+ * \param co: The coordinates of the points to find, others follow every \a co_stride bytes.
+ * \param co_query: The coordinates of the query points, others follow every
+ * \a co_query_stride bytes.
+ * \param r_nearest: An array of int's the length of \a co_query_len. Filled with the index of
+ * the closest point in \a co, or -1 when none is in range.
+ */
+void BLI_spatial_hash_3d_find_nearest(const float *co,
+                                      const size_t co_stride,
+                                      const uint co_len,
+                                      const float *co_query,
+                                      const size_t co_query_stride,
+                                      const uint co_query_len,
+                                      const float range,
+                                      int *r_nearest)
+{
+  SpatialHash sh;
+
+  if (co_len == 0) {
+    for (uint i = 0; i < co_query_len; i++) {
+      r_nearest[i] = -1;
+    }
+    return;
+  }
+
+  spatial_hash_build(&sh, co, co_stride, co_len, NULL, range);
+
+  SpatialHashNearestData data = {
+      .sh = &sh,
+      .co_query = (const char *)co_query,
+      .co_query_stride = co_query_stride,
+      .r_nearest = r_nearest,
+  };
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = POINTS_PER_TASK;
+  BLI_task_parallel_range(0, (int)co_query_len, &data, spatial_hash_find_nearest_cb, &settings);
+
+  spatial_hash_free(&sh);
+}
+
+/** \} */
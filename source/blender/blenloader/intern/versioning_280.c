@@ -4531,5 +4531,25 @@ void blo_do_versions_280(FileData *fd, Library *UNUSED(lib), Main *bmain)
         }
       }
     }
+
+    if (!DNA_struct_elem_find(fd->filesdna, "ClothSimSettings", "short", "preconditioner")) {
+      for (Object *ob = bmain->objects.first; ob; ob = ob->id.next) {
+        for (ModifierData *md = ob->modifiers.first; md; md = md->next) {
+          ClothModifierData *clmd = NULL;
+          if (md->type == eModifierType_Cloth) {
+            clmd = (ClothModifierData *)md;
+          }
+          else if (md->type == eModifierType_ParticleSystem) {
+            ParticleSystemModifierData *psmd = (ParticleSystemModifierData *)md;
+            ParticleSystem *psys = psmd->psys;
+            clmd = psys->clmd;
+          }
+          if (clmd != NULL && clmd->sim_parms != NULL) {
+            clmd->sim_parms->linear_solver = CLOTH_LINEAR_SOLVER_CG;
+            clmd->sim_parms->preconditioner = CLOTH_PRECONDITIONER_BLOCK_JACOBI;
+          }
+        }
+      }
+    }
   }
 }
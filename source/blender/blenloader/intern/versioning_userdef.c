@@ -731,6 +731,9 @@ void BLO_version_defaults_userpref_blend(Main *bmain, UserDef *userdef)
    */
   {
     /* Keep this block, even when empty. */
+    if (userdef->modifier_cache_limit == 0) {
+      userdef->modifier_cache_limit = U_default.modifier_cache_limit;
+    }
   }
 
   if (userdef->pixelsize == 0.0f) {
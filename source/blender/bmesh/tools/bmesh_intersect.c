@@ -33,11 +33,13 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "BLI_alloca.h"
+#include "BLI_bitmap.h"
 #include "BLI_math.h"
-#include "BLI_utildefines.h"
 #include "BLI_memarena.h"
-#include "BLI_alloca.h"
 #include "BLI_sort_utils.h"
+#include "BLI_task.h"
+#include "BLI_utildefines.h"
 
 #include "BLI_linklist_stack.h"
 #include "BLI_utildefines_stack.h"
@@ -75,6 +77,8 @@
 // #define USE_PARANOID
 /* use accelerated overlap check */
 #define USE_BVH
+/* test overlapping triangles and cast rays for inside/outside checks on multiple threads */
+#define USE_PARALLEL
 
 // #define USE_DUMP
 
@@ -120,9 +124,16 @@ struct ISectEpsilon {
   float eps_margin, eps_margin_sq;
 };
 
+/* Result of #intersect_line_tri, computed ahead of time. */
+struct ISectEdgeTriResult {
+  float ix[3];
+  enum ISectType side;
+};
+
 struct ISectState {
   BMesh *bm;
   GHash *edgetri_cache;    /* int[4]: BMVert */
+  BLI_bitmap *edgetri_verts; /* vertex indices used by keys in 'edgetri_cache' */
   GHash *edge_verts;       /* BMEdge: LinkList(of verts), new and original edges */
   GHash *face_edges;       /* BMFace-index: LinkList(of edges), only original faces */
   GSet *wire_edges;        /* BMEdge  (could use tags instead) */
@@ -344,6 +355,10 @@ static enum ISectType intersect_line_tri(const float p0[3],
   return IX_NONE;
 }
 
+/**
+ * \param precalc: Result of #intersect_line_tri for this edge and triangle when it was computed
+ * ahead of time, otherwise NULL.
+ */
 static BMVert *bm_isect_edge_tri(struct ISectState *s,
                                  BMVert *e_v0,
                                  BMVert *e_v1,
@@ -351,6 +366,7 @@ static BMVert *bm_isect_edge_tri(struct ISectState *s,
                                  const int t_index,
                                  const float *t_cos[3],
                                  const float t_nor[3],
+                                 const struct ISectEdgeTriResult *precalc,
                                  enum ISectType *r_side)
 {
   BMesh *bm = s->bm;
@@ -410,21 +426,31 @@ static BMVert *bm_isect_edge_tri(struct ISectState *s,
 #undef KEY_SET
 #undef KEY_EDGE_TRI_ORDER
 
-  for (i = 0; i < ARRAY_SIZE(k_arr); i++) {
-    BMVert *iv;
+  /* All keys contain this edge, skip the lookups when its vertices are in none. */
+  if (BLI_BITMAP_TEST(s->edgetri_verts, BM_elem_index_get(e_v0)) &&
+      BLI_BITMAP_TEST(s->edgetri_verts, BM_elem_index_get(e_v1))) {
+    for (i = 0; i < ARRAY_SIZE(k_arr); i++) {
+      BMVert *iv;
 
-    iv = BLI_ghash_lookup(s->edgetri_cache, k_arr[i]);
+      iv = BLI_ghash_lookup(s->edgetri_cache, k_arr[i]);
 
-    if (iv) {
+      if (iv) {
 #ifdef USE_DUMP
-      printf("# cache hit (%d, %d, %d, %d)\n", UNPACK4(k_arr[i]));
+        printf("# cache hit (%d, %d, %d, %d)\n", UNPACK4(k_arr[i]));
 #endif
-      *r_side = (enum ISectType)i;
-      return iv;
+        *r_side = (enum ISectType)i;
+        return iv;
+      }
     }
   }
 
-  *r_side = intersect_line_tri(e_v0->co, e_v1->co, t_cos, t_nor, ix, &s->epsilon);
+  if (precalc) {
+    *r_side = precalc->side;
+    copy_v3_v3(ix, precalc->ix);
+  }
+  else {
+    *r_side = intersect_line_tri(e_v0->co, e_v1->co, t_cos, t_nor, ix, &s->epsilon);
+  }
   if (*r_side != IX_NONE) {
     BMVert *iv;
     BMEdge *e;
@@ -466,6 +492,14 @@ static BMVert *bm_isect_edge_tri(struct ISectState *s,
       int *k = BLI_memarena_alloc(s->mem_arena, sizeof(int[4]));
       memcpy(k, k_arr[*r_side], sizeof(int[4]));
       BLI_ghash_insert(s->edgetri_cache, k, iv);
+
+      /* The edge-triangle key stores the triangle index, the others two edges. */
+      BLI_BITMAP_ENABLE(s->edgetri_verts, k[0]);
+      BLI_BITMAP_ENABLE(s->edgetri_verts, k[1]);
+      if (*r_side != IX_EDGE_TRI) {
+        BLI_BITMAP_ENABLE(s->edgetri_verts, k[2]);
+        BLI_BITMAP_ENABLE(s->edgetri_verts, k[3]);
+      }
     }
 
     return iv;
@@ -507,9 +541,16 @@ static bool bm_loop_filter_fn(const BMLoop *l, void *user_data)
 
 /**
  * Return true if we have any intersections.
+ *
+ * \param edge_tri_results: Results of #bm_isect_tri_tri_precalc for triangles whose vertices
+ * don't touch each other, otherwise NULL.
  */
-static void bm_isect_tri_tri(
-    struct ISectState *s, int a_index, int b_index, BMLoop **a, BMLoop **b)
+static void bm_isect_tri_tri(struct ISectState *s,
+                             int a_index,
+                             int b_index,
+                             BMLoop **a,
+                             BMLoop **b,
+                             const struct ISectEdgeTriResult *edge_tri_results)
 {
   BMFace *f_a = (*a)->f;
   BMFace *f_b = (*b)->f;
@@ -552,6 +593,11 @@ static void bm_isect_tri_tri(
   } \
   ((void)0)
 
+  if (edge_tri_results) {
+    /* Vertex checks were done when computing the results. */
+    goto edge_tri;
+  }
+
   /* vert-vert
    * --------- */
   {
@@ -729,6 +775,7 @@ static void bm_isect_tri_tri(
     goto finally;
   }
 
+edge_tri:
   normal_tri_v3(f_a_nor, UNPACK3(f_a_cos));
   normal_tri_v3(f_b_nor, UNPACK3(f_b_cos));
 
@@ -745,8 +792,15 @@ static void bm_isect_tri_tri(
         continue;
       }
 
-      iv = bm_isect_edge_tri(
-          s, fv_a[i_a_e0], fv_a[i_a_e1], fv_b, b_index, f_b_cos, f_b_nor, &side);
+      iv = bm_isect_edge_tri(s,
+                             fv_a[i_a_e0],
+                             fv_a[i_a_e1],
+                             fv_b,
+                             b_index,
+                             f_b_cos,
+                             f_b_nor,
+                             edge_tri_results ? &edge_tri_results[i_a_e0] : NULL,
+                             &side);
       if (iv) {
         STACK_PUSH_TEST_A(iv);
         STACK_PUSH_TEST_B(iv);
@@ -766,8 +820,15 @@ static void bm_isect_tri_tri(
         continue;
       }
 
-      iv = bm_isect_edge_tri(
-          s, fv_b[i_b_e0], fv_b[i_b_e1], fv_a, a_index, f_a_cos, f_a_nor, &side);
+      iv = bm_isect_edge_tri(s,
+                             fv_b[i_b_e0],
+                             fv_b[i_b_e1],
+                             fv_a,
+                             a_index,
+                             f_a_cos,
+                             f_a_nor,
+                             edge_tri_results ? &edge_tri_results[3 + i_b_e0] : NULL,
+                             &side);
       if (iv) {
         STACK_PUSH_TEST_A(iv);
         STACK_PUSH_TEST_B(iv);
@@ -835,6 +896,281 @@ finally:
   }
 }
 
+#ifdef USE_PARALLEL
+
+/* -------------------------------------------------------------------- */
+/** \name Parallel Triangle Pair Tests
+ *
+ * Overlapping triangle pairs are tested in blocks on multiple threads, without changing the
+ * mesh. Only pairs which touch or intersect are then handled by #bm_isect_tri_tri, in the same
+ * order as before, so the result does not depend on the number of threads.
+ * \{ */
+
+/* Triangle pairs tested per task. */
+#  define ISECT_PAIR_BLOCK_SIZE 1024
+
+/* Bits 0-5: #intersect_line_tri found an intersection for that edge of the pair,
+ * edges of triangle A against triangle B first. */
+#  define ISECT_PAIR_EDGE_TRI_MASK ((1 << 6) - 1)
+/* Triangles share a vertex, nothing to do. */
+#  define ISECT_PAIR_SKIP (1 << 6)
+/* Vertices of the triangles touch, left to #bm_isect_tri_tri. */
+#  define ISECT_PAIR_TOUCH (1 << 7)
+
+struct ISectPairBlock {
+  /* Results of the intersecting edges of all pairs in the block, in order. */
+  struct ISectEdgeTriResult *results;
+  uint results_len, results_alloc;
+};
+
+struct ISectPairData {
+  BMLoop *(*looptris)[3];
+  const BVHTreeOverlap *overlap;
+  uint overlap_tot;
+  const struct ISectEpsilon *epsilon;
+
+  uchar *pair_flag;
+  struct ISectPairBlock *blocks;
+};
+
+/**
+ * Check if any vertex of one triangle touches the other triangle,
+ * the same tests #bm_isect_tri_tri runs before intersecting edges.
+ */
+static bool isect_tri_tri_verts_touch(const float *f_a_cos[3],
+                                      const float *f_b_cos[3],
+                                      const struct ISectEpsilon *e)
+{
+  const float **cos_pair[2] = {f_a_cos, f_b_cos};
+
+  for (uint i_a = 0; i_a < 3; i_a++) {
+    for (uint i_b = 0; i_b < 3; i_b++) {
+      if (len_squared_v3v3(f_a_cos[i_a], f_b_cos[i_b]) <= e->eps2x_sq) {
+        return true;
+      }
+    }
+  }
+
+  /* vert-edge, both ways */
+  for (uint side = 0; side < 2; side++) {
+    const float **v_cos = cos_pair[side];
+    const float **e_cos = cos_pair[!side];
+    for (uint i_v = 0; i_v < 3; i_v++) {
+      for (uint i_e0 = 0; i_e0 < 3; i_e0++) {
+        const uint i_e1 = (i_e0 + 1) % 3;
+        const float fac = line_point_factor_v3(v_cos[i_v], e_cos[i_e0], e_cos[i_e1]);
+        if ((fac > 0.0f - e->eps) && (fac < 1.0f + e->eps)) {
+          float ix[3];
+          interp_v3_v3v3(ix, e_cos[i_e0], e_cos[i_e1], fac);
+          if (len_squared_v3v3(ix, v_cos[i_v]) <= e->eps2x_sq) {
+            return true;
+          }
+        }
+      }
+    }
+  }
+
+  /* vert-tri, both ways */
+  for (uint side = 0; side < 2; side++) {
+    const float **v_cos = cos_pair[side];
+    const float **t_cos = cos_pair[!side];
+    float t_scale[3][3];
+
+    copy_v3_v3(t_scale[0], t_cos[0]);
+    copy_v3_v3(t_scale[1], t_cos[1]);
+    copy_v3_v3(t_scale[2], t_cos[2]);
+    tri_v3_scale(UNPACK3(t_scale), 1.0f - e->eps2x);
+
+    for (uint i_v = 0; i_v < 3; i_v++) {
+      float ix[3];
+      if (isect_point_tri_v3(v_cos[i_v], UNPACK3(t_scale), ix)) {
+        if (len_squared_v3v3(ix, v_cos[i_v]) <= e->eps2x_sq) {
+          return true;
+        }
+      }
+    }
+  }
+
+  return false;
+}
+
+/**
+ * Run the geometric tests of #bm_isect_tri_tri which don't depend on previously tested pairs.
+ *
+ * \return #ISECT_PAIR_SKIP, #ISECT_PAIR_TOUCH or the edges intersecting the other triangle,
+ * whose results are written to \a r_results.
+ */
+static uchar bm_isect_tri_tri_precalc(const struct ISectEpsilon *e,
+                                      BMLoop **a,
+                                      BMLoop **b,
+                                      struct ISectEdgeTriResult r_results[6])
+{
+  BMVert *fv_a[3] = {UNPACK3_EX(, a, ->v)};
+  BMVert *fv_b[3] = {UNPACK3_EX(, b, ->v)};
+  const float *f_a_cos[3] = {UNPACK3_EX(, fv_a, ->co)};
+  const float *f_b_cos[3] = {UNPACK3_EX(, fv_b, ->co)};
+  BMVert **fv_pair[2] = {fv_a, fv_b};
+  const float **cos_pair[2] = {f_a_cos, f_b_cos};
+  float nor_pair[2][3];
+  uchar flag = 0;
+
+  if (UNLIKELY(ELEM(fv_a[0], UNPACK3(fv_b)) || ELEM(fv_a[1], UNPACK3(fv_b)) ||
+               ELEM(fv_a[2], UNPACK3(fv_b)))) {
+    return ISECT_PAIR_SKIP;
+  }
+
+  if (isect_tri_tri_verts_touch(f_a_cos, f_b_cos, e)) {
+    return ISECT_PAIR_TOUCH;
+  }
+
+  normal_tri_v3(nor_pair[0], UNPACK3(f_a_cos));
+  normal_tri_v3(nor_pair[1], UNPACK3(f_b_cos));
+
+  for (uint side = 0; side < 2; side++) {
+    for (uint i_e0 = 0; i_e0 < 3; i_e0++) {
+      const uint i_result = side * 3 + i_e0;
+      BMVert *e_v0 = fv_pair[side][i_e0];
+      BMVert *e_v1 = fv_pair[side][(i_e0 + 1) % 3];
+
+      /* Same order as #bm_isect_edge_tri. */
+      if (BM_elem_index_get(e_v0) > BM_elem_index_get(e_v1)) {
+        SWAP(BMVert *, e_v0, e_v1);
+      }
+
+      struct ISectEdgeTriResult *result = &r_results[i_result];
+      result->side = intersect_line_tri(
+          e_v0->co, e_v1->co, cos_pair[!side], nor_pair[!side], result->ix, e);
+      if (result->side != IX_NONE) {
+        flag |= (uchar)(1 << i_result);
+      }
+    }
+  }
+
+  return flag;
+}
+
+static void bm_isect_pair_block_cb(void *__restrict userdata,
+                                   const int block_index,
+                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  struct ISectPairData *data = userdata;
+  struct ISectPairBlock *block = &data->blocks[block_index];
+  const uint start = (uint)block_index * ISECT_PAIR_BLOCK_SIZE;
+  const uint end = MIN2(start + ISECT_PAIR_BLOCK_SIZE, data->overlap_tot);
+
+  for (uint i = start; i < end; i++) {
+    struct ISectEdgeTriResult results[6];
+    const uchar flag = bm_isect_tri_tri_precalc(data->epsilon,
+                                                data->looptris[data->overlap[i].indexA],
+                                                data->looptris[data->overlap[i].indexB],
+                                                results);
+    data->pair_flag[i] = flag;
+
+    if (flag & ISECT_PAIR_EDGE_TRI_MASK) {
+      for (uint j = 0; j < 6; j++) {
+        if ((flag & (1 << j)) == 0) {
+          continue;
+        }
+        if (block->results_len == block->results_alloc) {
+          block->results_alloc = block->results_alloc ? block->results_alloc * 2 : 16;
+          block->results = MEM_reallocN(block->results,
+                                        sizeof(*block->results) * block->results_alloc);
+        }
+        block->results[block->results_len++] = results[j];
+      }
+    }
+  }
+}
+
+/* True when an edge of the pair is part of a key in 'edgetri_cache',
+ * so #bm_isect_tri_tri may reuse a vertex even though no edge intersects. */
+static bool bm_isect_tri_tri_has_cached_edge(struct ISectState *s, BMLoop **a, BMLoop **b)
+{
+  BMLoop **tri_pair[2] = {a, b};
+
+  for (uint side = 0; side < 2; side++) {
+    for (uint i_e0 = 0; i_e0 < 3; i_e0++) {
+      const uint i_e1 = (i_e0 + 1) % 3;
+      if (BLI_BITMAP_TEST(s->edgetri_verts, BM_elem_index_get(tri_pair[side][i_e0]->v)) &&
+          BLI_BITMAP_TEST(s->edgetri_verts, BM_elem_index_get(tri_pair[side][i_e1]->v))) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+static void bm_isect_tri_tri_overlap(struct ISectState *s,
+                                     BMLoop *(*looptris)[3],
+                                     const BVHTreeOverlap *overlap,
+                                     const uint overlap_tot)
+{
+  const uint blocks_len = (overlap_tot + ISECT_PAIR_BLOCK_SIZE - 1) / ISECT_PAIR_BLOCK_SIZE;
+
+  struct ISectPairData data = {
+      .looptris = looptris,
+      .overlap = overlap,
+      .overlap_tot = overlap_tot,
+      .epsilon = &s->epsilon,
+      .pair_flag = MEM_mallocN(sizeof(*data.pair_flag) * overlap_tot, __func__),
+      .blocks = MEM_callocN(sizeof(*data.blocks) * blocks_len, __func__),
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (blocks_len > 1);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, (int)blocks_len, &data, bm_isect_pair_block_cb, &settings);
+
+  for (uint block_index = 0; block_index < blocks_len; block_index++) {
+    struct ISectPairBlock *block = &data.blocks[block_index];
+    const uint start = block_index * ISECT_PAIR_BLOCK_SIZE;
+    const uint end = MIN2(start + ISECT_PAIR_BLOCK_SIZE, overlap_tot);
+    uint results_index = 0;
+
+    for (uint i = start; i < end; i++) {
+      const uchar flag = data.pair_flag[i];
+      const int i_a = overlap[i].indexA;
+      const int i_b = overlap[i].indexB;
+
+#  ifdef USE_DUMP
+      printf("  ((%d, %d), (\n", i_a, i_b);
+#  endif
+      if (flag & ISECT_PAIR_SKIP) {
+        /* pass */
+      }
+      else if (flag & ISECT_PAIR_TOUCH) {
+        bm_isect_tri_tri(s, i_a, i_b, looptris[i_a], looptris[i_b], NULL);
+      }
+      else if (flag || bm_isect_tri_tri_has_cached_edge(s, looptris[i_a], looptris[i_b])) {
+        struct ISectEdgeTriResult results[6];
+        for (uint j = 0; j < 6; j++) {
+          if (flag & (1 << j)) {
+            results[j] = block->results[results_index++];
+          }
+          else {
+            results[j].side = IX_NONE;
+          }
+        }
+        bm_isect_tri_tri(s, i_a, i_b, looptris[i_a], looptris[i_b], results);
+      }
+#  ifdef USE_DUMP
+      printf(")),\n");
+#  endif
+    }
+    BLI_assert(results_index == block->results_len);
+
+    MEM_SAFE_FREE(block->results);
+  }
+
+  MEM_freeN(data.pair_flag);
+  MEM_freeN(data.blocks);
+}
+
+/** \} */
+
+#endif /* USE_PARALLEL */
+
 #ifdef USE_BVH
 
 struct RaycastData {
@@ -940,6 +1276,46 @@ static int isect_bvhtree_point_v3(BVHTree *tree, const float **looptris, const f
   return num_isect;
 }
 
+struct GroupSideData {
+  BMFace **ftable;
+  const int *groups_array;
+  const int (*group_index)[2];
+  int (*test_fn)(BMFace *f, void *user_data);
+  void *user_data;
+  BVHTree **tree_pair;
+  const float **looptri_coords;
+
+  /* Side of each face-group (-1 to skip) and the number of hits casting to the other side. */
+  int (*r_side_hits)[2];
+};
+
+/* Only reads the mesh, so all face-groups can be tested at once. */
+static void bm_isect_group_side_cb(void *__restrict userdata,
+                                   const int group,
+                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  struct GroupSideData *data = userdata;
+  /* for now assyme this is an OK face to test with (not degenerate!) */
+  BMFace *f = data->ftable[data->groups_array[data->group_index[group][0]]];
+  float co[3];
+  int side = data->test_fn(f, data->user_data);
+
+  if (side == -1) {
+    data->r_side_hits[group][0] = -1;
+    data->r_side_hits[group][1] = 0;
+    return;
+  }
+  BLI_assert(ELEM(side, 0, 1));
+  side = !side;
+
+  // BM_face_calc_center_median(f, co);
+  BM_face_calc_point_in_face(f, co);
+
+  data->r_side_hits[group][0] = side;
+  data->r_side_hits[group][1] = isect_bvhtree_point_v3(
+      data->tree_pair[side], data->looptri_coords, co);
+}
+
 #endif /* USE_BVH */
 
 /**
@@ -948,21 +1324,24 @@ static int isect_bvhtree_point_v3(BVHTree *tree, const float **looptris, const f
  *
  * \param test_fn: Return value: -1: skip, 0: tree_a, 1: tree_b (use_self == false)
  * \param boolean_mode: -1: no-boolean, 0: intersection... see #BMESH_ISECT_BOOLEAN_ISECT.
+ * \param use_threading: Test overlapping triangles and face-groups on multiple threads,
+ * the result is the same as without threading.
  * \return true if the mesh is changed (intersections cut or faces removed from boolean).
  */
-bool BM_mesh_intersect(BMesh *bm,
-                       struct BMLoop *(*looptris)[3],
-                       const int looptris_tot,
-                       int (*test_fn)(BMFace *f, void *user_data),
-                       void *user_data,
-                       const bool use_self,
-                       const bool use_separate,
-                       const bool use_dissolve,
-                       const bool use_island_connect,
-                       const bool use_partial_connect,
-                       const bool use_edge_tag,
-                       const int boolean_mode,
-                       const float eps)
+bool BM_mesh_intersect_ex(BMesh *bm,
+                          struct BMLoop *(*looptris)[3],
+                          const int looptris_tot,
+                          int (*test_fn)(BMFace *f, void *user_data),
+                          void *user_data,
+                          const bool use_self,
+                          const bool use_separate,
+                          const bool use_dissolve,
+                          const bool use_island_connect,
+                          const bool use_partial_connect,
+                          const bool use_edge_tag,
+                          const int boolean_mode,
+                          const float eps,
+                          const bool use_threading)
 {
   struct ISectState s;
   const int totface_orig = bm->totface;
@@ -985,6 +1364,7 @@ bool BM_mesh_intersect(BMesh *bm,
 
   s.edgetri_cache = BLI_ghash_new(
       BLI_ghashutil_inthash_v4_p, BLI_ghashutil_inthash_v4_cmp, __func__);
+  s.edgetri_verts = BLI_BITMAP_NEW((size_t)bm->totvert, __func__);
 
   s.edge_verts = BLI_ghash_ptr_new(__func__);
   s.face_edges = BLI_ghash_int_new(__func__);
@@ -1093,20 +1473,29 @@ bool BM_mesh_intersect(BMesh *bm,
   overlap = BLI_bvhtree_overlap_ex(tree_b, tree_a, &tree_overlap_tot, NULL, NULL, 0, flag);
 
   if (overlap) {
-    uint i;
+#  ifdef USE_PARALLEL
+    if (use_threading) {
+      bm_isect_tri_tri_overlap(&s, looptris, overlap, tree_overlap_tot);
+    }
+    else
+#  endif
+    {
+      uint i;
 
-    for (i = 0; i < tree_overlap_tot; i++) {
+      for (i = 0; i < tree_overlap_tot; i++) {
 #  ifdef USE_DUMP
-      printf("  ((%d, %d), (\n", overlap[i].indexA, overlap[i].indexB);
+        printf("  ((%d, %d), (\n", overlap[i].indexA, overlap[i].indexB);
 #  endif
-      bm_isect_tri_tri(&s,
-                       overlap[i].indexA,
-                       overlap[i].indexB,
-                       looptris[overlap[i].indexA],
-                       looptris[overlap[i].indexB]);
+        bm_isect_tri_tri(&s,
+                         overlap[i].indexA,
+                         overlap[i].indexB,
+                         looptris[overlap[i].indexA],
+                         looptris[overlap[i].indexB],
+                         NULL);
 #  ifdef USE_DUMP
-      printf(")),\n");
+        printf(")),\n");
 #  endif
+      }
     }
     MEM_freeN(overlap);
   }
@@ -1140,7 +1529,7 @@ bool BM_mesh_intersect(BMesh *bm,
 #  ifdef USE_DUMP
         printf("  ((%d, %d), (", i_a, i_b);
 #  endif
-        bm_isect_tri_tri(&s, i_a, i_b, looptris[i_a], looptris[i_b]);
+        bm_isect_tri_tri(&s, i_a, i_b, looptris[i_a], looptris[i_b], NULL);
 #  ifdef USE_DUMP
         printf(")),\n");
 #  endif
@@ -1523,28 +1912,38 @@ bool BM_mesh_intersect(BMesh *bm,
 #endif
 
     /* Check if island is inside/outside */
+    int(*group_side_hits)[2] = MEM_mallocN(sizeof(*group_side_hits) * (size_t)group_tot,
+                                            __func__);
+    {
+      struct GroupSideData data = {
+          .ftable = ftable,
+          .groups_array = groups_array,
+          .group_index = group_index,
+          .test_fn = test_fn,
+          .user_data = user_data,
+          .tree_pair = tree_pair,
+          .looptri_coords = looptri_coords,
+          .r_side_hits = group_side_hits,
+      };
+      TaskParallelSettings settings;
+      BLI_parallel_range_settings_defaults(&settings);
+      settings.use_threading = use_threading && (group_tot > 1);
+      settings.min_iter_per_thread = 1;
+      BLI_task_parallel_range(0, group_tot, &data, bm_isect_group_side_cb, &settings);
+    }
+
     for (i = 0; i < group_tot; i++) {
       int fg = group_index[i][0];
       int fg_end = group_index[i][1] + fg;
       bool do_remove, do_flip;
 
       {
-        /* for now assyme this is an OK face to test with (not degenerate!) */
-        BMFace *f = ftable[groups_array[fg]];
-        float co[3];
-        int hits;
-        int side = test_fn(f, user_data);
+        const int side = group_side_hits[i][0];
+        const int hits = group_side_hits[i][1];
 
         if (side == -1) {
           continue;
         }
-        BLI_assert(ELEM(side, 0, 1));
-        side = !side;
-
-        // BM_face_calc_center_median(f, co);
-        BM_face_calc_point_in_face(f, co);
-
-        hits = isect_bvhtree_point_v3(tree_pair[side], looptri_coords, co);
 
         switch (boolean_mode) {
           case BMESH_ISECT_BOOLEAN_ISECT:
@@ -1578,6 +1977,7 @@ bool BM_mesh_intersect(BMesh *bm,
       has_edit_boolean |= (do_flip || do_remove);
     }
 
+    MEM_freeN(group_side_hits);
     MEM_freeN(groups_array);
     MEM_freeN(group_index);
 
@@ -1636,6 +2036,7 @@ bool BM_mesh_intersect(BMesh *bm,
 
   /* cleanup */
   BLI_ghash_free(s.edgetri_cache, NULL, NULL);
+  MEM_freeN(s.edgetri_verts);
 
   BLI_ghash_free(s.edge_verts, NULL, NULL);
   BLI_ghash_free(s.face_edges, NULL, NULL);
@@ -1645,3 +2046,33 @@ bool BM_mesh_intersect(BMesh *bm,
 
   return (has_edit_isect || has_edit_boolean);
 }
+
+bool BM_mesh_intersect(BMesh *bm,
+                       struct BMLoop *(*looptris)[3],
+                       const int looptris_tot,
+                       int (*test_fn)(BMFace *f, void *user_data),
+                       void *user_data,
+                       const bool use_self,
+                       const bool use_separate,
+                       const bool use_dissolve,
+                       const bool use_island_connect,
+                       const bool use_partial_connect,
+                       const bool use_edge_tag,
+                       const int boolean_mode,
+                       const float eps)
+{
+  return BM_mesh_intersect_ex(bm,
+                              looptris,
+                              looptris_tot,
+                              test_fn,
+                              user_data,
+                              use_self,
+                              use_separate,
+                              use_dissolve,
+                              use_island_connect,
+                              use_partial_connect,
+                              use_edge_tag,
+                              boolean_mode,
+                              eps,
+                              true);
+}
@@ -34,6 +34,20 @@ bool BM_mesh_intersect(BMesh *bm,
                        const bool use_edge_tag,
                        const int boolean_mode,
                        const float eps);
+bool BM_mesh_intersect_ex(BMesh *bm,
+                          struct BMLoop *(*looptris)[3],
+                          const int looptris_tot,
+                          int (*test_fn)(BMFace *f, void *user_data),
+                          void *user_data,
+                          const bool use_self,
+                          const bool use_separate,
+                          const bool use_dissolve,
+                          const bool use_island_connect,
+                          const bool use_partial_connect,
+                          const bool use_edge_tag,
+                          const int boolean_mode,
+                          const float eps,
+                          const bool use_threading);
 
 enum {
   BMESH_ISECT_BOOLEAN_NONE = -1,
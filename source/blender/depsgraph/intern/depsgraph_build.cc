@@ -217,6 +217,15 @@ static void graph_build_finalize_common(DEG::Depsgraph *deg_graph, Main *bmain)
   /* Flush visibility layer and re-schedule nodes for update. */
   DEG::deg_graph_build_finalize(bmain, deg_graph);
   DEG_graph_on_visible_update(bmain, reinterpret_cast<::Depsgraph *>(deg_graph), false);
+  if (G.debug & G_DEBUG_DEPSGRAPH_BUILD) {
+    size_t drivers, drivers_simple;
+    DEG_stats_drivers(reinterpret_cast<::Depsgraph *>(deg_graph), &drivers, &drivers_simple);
+    if (drivers != 0) {
+      printf("Depsgraph has %d drivers, %d of them evaluated without Python.\n",
+             (int)drivers,
+             (int)drivers_simple);
+    }
+  }
 #if 0
   if (!DEG_debug_consistency_check(deg_graph)) {
     printf("Consistency validation failed, ABORTING!\n");
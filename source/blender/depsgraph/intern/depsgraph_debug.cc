@@ -25,11 +25,16 @@
 
 #include "BLI_utildefines.h"
 #include "BLI_ghash.h"
+#include "BLI_listbase.h"
 
 extern "C" {
+#include "DNA_anim_types.h"
 #include "DNA_scene_types.h"
 } /* extern "C" */
 
+#include "BKE_animsys.h"
+#include "BKE_fcurve.h"
+
 #include "DNA_object_types.h"
 
 #include "DEG_depsgraph.h"
@@ -247,6 +252,40 @@ void DEG_stats_simple(const Depsgraph *graph,
   }
 }
 
+/**
+ * Count the drivers of the datablocks in the depsgraph.
+ * \param[out] r_drivers         The number of drivers
+ * \param[out] r_drivers_simple  The number of drivers evaluated without Python,
+ *                               which run in parallel without taking the global lock.
+ */
+void DEG_stats_drivers(const Depsgraph *graph, size_t *r_drivers, size_t *r_drivers_simple)
+{
+  const DEG::Depsgraph *deg_graph = reinterpret_cast<const DEG::Depsgraph *>(graph);
+  size_t tot_drivers = 0;
+  size_t tot_drivers_simple = 0;
+
+  for (DEG::IDNode *id_node : deg_graph->id_nodes) {
+    AnimData *adt = BKE_animdata_from_id(id_node->id_orig);
+    if (adt == nullptr) {
+      continue;
+    }
+    LISTBASE_FOREACH (FCurve *, fcu, &adt->drivers) {
+      ChannelDriver *driver = fcu->driver;
+      if (driver == nullptr) {
+        continue;
+      }
+      tot_drivers++;
+      if (driver->type != DRIVER_TYPE_PYTHON || driver->expression[0] == '\0' ||
+          BKE_driver_has_simple_expression(driver)) {
+        tot_drivers_simple++;
+      }
+    }
+  }
+
+  *r_drivers = tot_drivers;
+  *r_drivers_simple = tot_drivers_simple;
+}
+
 static DEG::string depsgraph_name_for_logging(struct Depsgraph *depsgraph)
 {
   const char *name = DEG_debug_name_get(depsgraph);
@@ -324,6 +324,12 @@ typedef struct SculptUndoNode {
   /* Sculpt Face Sets */
   int *face_sets;
 
+  /* Coordinates or mask packed once the stroke is done, replacing co/mask (see
+   * #sculpt_undo_pack_nodes). NULL with is_packed set when nothing changed. */
+  unsigned char *packed;
+  size_t packed_size;
+  bool is_packed;
+
   size_t undo_size;
 } SculptUndoNode;
 
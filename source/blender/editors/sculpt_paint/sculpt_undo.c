@@ -26,6 +26,7 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "BLI_byte_planes.h"
 #include "BLI_math.h"
 #include "BLI_utildefines.h"
 #include "BLI_string.h"
@@ -46,6 +47,7 @@
 #include "BKE_multires.h"
 #include "BKE_paint.h"
 #include "BKE_key.h"
+#include "BKE_lib_id.h"
 #include "BKE_mesh.h"
 #include "BKE_scene.h"
 #include "BKE_subsurf.h"
@@ -63,13 +65,22 @@
 #include "ED_sculpt.h"
 #include "ED_undo.h"
 
+#include "CLG_log.h"
+
 #include "bmesh.h"
 #include "sculpt_intern.h"
 
+static CLG_LogRef LOG = {"ed.undo.sculpt"};
+
 typedef struct UndoSculpt {
   ListBase nodes;
 
   size_t undo_size;
+  /* Size before packing, only for reporting. */
+  size_t undo_size_unpacked;
+
+  /* Object the PBVH nodes were pushed for, only used to pack them once the stroke is done. */
+  Object *ob;
 } UndoSculpt;
 
 static UndoSculpt *sculpt_undo_get_nodes(void);
@@ -141,6 +152,199 @@ static bool sculpt_undo_restore_deformed(
   }
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Packed Coordinates & Mask
+ *
+ * Once the stroke is done the values stored in coordinate and mask nodes are only needed to
+ * undo, so they get packed: XOR'ed with the current values only the vertices the stroke changed
+ * are left non-zero, which #BLI_byte_planes_pack stores compactly.
+ *
+ * Restoring XOR's the same delta into the mesh, which swaps between both states just like
+ * the unpacked nodes do, so undo and redo don't need to pack again.
+ * \{ */
+
+static int sculpt_undo_packed_stride(const SculptUndoNode *unode)
+{
+  return (unode->type == SCULPT_UNDO_COORDS) ? sizeof(float[3]) : sizeof(float);
+}
+
+/* Number of values restored, the verts shared with other nodes are skipped for regular meshes. */
+static int sculpt_undo_packed_len(const SculptUndoNode *unode)
+{
+  return unode->maxvert ? unode->totvert : unode->totgrid * unode->gridsize * unode->gridsize;
+}
+
+/**
+ * Only nodes restored into the mesh or grids directly are packed, deformed meshes and shape
+ * keys keep their values as they are.
+ */
+static bool sculpt_undo_node_can_pack(const SculptSession *ss, const SculptUndoNode *unode)
+{
+  if (unode->node == NULL || unode->orig_co != NULL || ss->shapekey_active != NULL) {
+    return false;
+  }
+
+  if (unode->type == SCULPT_UNDO_COORDS) {
+    if (unode->co == NULL) {
+      return false;
+    }
+  }
+  else if (unode->type == SCULPT_UNDO_MASK) {
+    if (unode->mask == NULL || (unode->maxvert && ss->vmask == NULL)) {
+      return false;
+    }
+  }
+  else {
+    return false;
+  }
+
+  if (unode->maxvert) {
+    return ss->bm == NULL && ss->mvert != NULL && ss->totvert == unode->maxvert;
+  }
+  if (unode->maxgrid) {
+    return ss->subdiv_ccg != NULL && ss->subdiv_ccg->num_grids == unode->maxgrid &&
+           ss->subdiv_ccg->grid_size == unode->gridsize;
+  }
+  return false;
+}
+
+/* Current value of the vertex \a i of the node, in the same order as the stored values. */
+static float *sculpt_undo_packed_value(SculptSession *ss,
+                                       const CCGKey *key,
+                                       const SculptUndoNode *unode,
+                                       const int i)
+{
+  if (unode->maxvert) {
+    const int vert = unode->index[i];
+    return (unode->type == SCULPT_UNDO_COORDS) ? ss->mvert[vert].co : &ss->vmask[vert];
+  }
+  else {
+    const int grid_area = unode->gridsize * unode->gridsize;
+    CCGElem *grid = ss->subdiv_ccg->grids[unode->grids[i / grid_area]];
+    return (unode->type == SCULPT_UNDO_COORDS) ? CCG_elem_offset_co(key, grid, i % grid_area) :
+                                                 CCG_elem_offset_mask(key, grid, i % grid_area);
+  }
+}
+
+typedef struct SculptUndoPackData {
+  SculptSession *ss;
+  CCGKey key;
+  SculptUndoNode **nodes;
+} SculptUndoPackData;
+
+static void sculpt_undo_pack_task_cb(void *__restrict userdata,
+                                     const int n,
+                                     const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  SculptUndoPackData *data = userdata;
+  SculptUndoNode *unode = data->nodes[n];
+  const int stride = sculpt_undo_packed_stride(unode);
+  const int values_len = sculpt_undo_packed_len(unode);
+  const size_t delta_len = (size_t)stride * (size_t)values_len;
+  const uchar *stored = (unode->type == SCULPT_UNDO_COORDS) ? (uchar *)unode->co :
+                                                              (uchar *)unode->mask;
+  uchar *delta = MEM_mallocN(delta_len, __func__);
+  bool changed = false;
+
+  for (int i = 0; i < values_len; i++) {
+    const uchar *current = (uchar *)sculpt_undo_packed_value(data->ss, &data->key, unode, i);
+    const uchar *value = &stored[i * stride];
+    uchar *value_delta = &delta[i * stride];
+    for (int b = 0; b < stride; b++) {
+      value_delta[b] = value[b] ^ current[b];
+      changed |= (value_delta[b] != 0);
+    }
+  }
+
+  if (changed) {
+    void *packed;
+    unode->packed_size = BLI_byte_planes_pack(delta, (size_t)values_len, (size_t)stride, &packed);
+    unode->packed = packed;
+  }
+  MEM_freeN(delta);
+
+  MEM_SAFE_FREE(unode->co);
+  MEM_SAFE_FREE(unode->mask);
+  unode->is_packed = true;
+}
+
+/**
+ * Pack the coordinates and masks of the nodes pushed during the stroke, this needs the PBVH
+ * nodes to still be valid.
+ */
+static void sculpt_undo_pack_nodes(UndoSculpt *usculpt)
+{
+  SculptUndoNode *unode = usculpt->nodes.first;
+  Object *ob = usculpt->ob;
+  usculpt->ob = NULL;
+  if (unode == NULL || unode->node == NULL) {
+    return;
+  }
+
+  if (ob == NULL || ob->sculpt == NULL || ob->sculpt->pbvh == NULL) {
+    return;
+  }
+  SculptSession *ss = ob->sculpt;
+
+  SculptUndoPackData data = {.ss = ss};
+  int nodes_len = 0;
+  data.nodes = MEM_mallocN(sizeof(*data.nodes) * BLI_listbase_count(&usculpt->nodes), __func__);
+  for (; unode; unode = unode->next) {
+    if (STREQ(unode->idname, ob->id.name) && sculpt_undo_node_can_pack(ss, unode)) {
+      data.nodes[nodes_len++] = unode;
+      usculpt->undo_size -= MEM_allocN_len(unode->co ? (void *)unode->co : (void *)unode->mask);
+    }
+  }
+  if (ss->subdiv_ccg) {
+    BKE_subdiv_ccg_key_top_level(&data.key, ss->subdiv_ccg);
+  }
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  /* Nodes differ a lot in how much the stroke changed. */
+  settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+  BLI_task_parallel_range(0, nodes_len, &data, sculpt_undo_pack_task_cb, &settings);
+
+  for (int i = 0; i < nodes_len; i++) {
+    usculpt->undo_size += data.nodes[i]->packed_size;
+  }
+  MEM_freeN(data.nodes);
+}
+
+/**
+ * Unpack the delta of a packed node.
+ * NULL when the stroke didn't change anything in the node.
+ */
+static uchar *sculpt_undo_unpack(const SculptUndoNode *unode)
+{
+  if (unode->packed == NULL) {
+    return NULL;
+  }
+
+  const int stride = sculpt_undo_packed_stride(unode);
+  const int values_len = sculpt_undo_packed_len(unode);
+  uchar *delta = MEM_mallocN((size_t)stride * (size_t)values_len, __func__);
+  BLI_byte_planes_unpack(unode->packed, (size_t)values_len, (size_t)stride, delta);
+  return delta;
+}
+
+/* Apply the delta of one value, returns true when it changed. */
+static bool sculpt_undo_delta_apply(float *value, const uchar *delta, const int stride)
+{
+  uchar *bytes = (uchar *)value;
+  bool changed = false;
+  for (int b = 0; b < stride; b++) {
+    if (delta[b]) {
+      bytes[b] ^= delta[b];
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+/** \} */
+
 static bool sculpt_undo_restore_coords(bContext *C, Depsgraph *depsgraph, SculptUndoNode *unode)
 {
   ViewLayer *view_layer = CTX_data_view_layer(C);
@@ -191,6 +395,16 @@ static bool sculpt_undo_restore_coords(bContext *C, Depsgraph *depsgraph, Sculpt
           }
         }
       }
+      else if (unode->is_packed) {
+        uchar *delta = sculpt_undo_unpack(unode);
+        if (delta) {
+          for (int i = 0; i < unode->totvert; i++) {
+            sculpt_undo_delta_apply(
+                vertCos[index[i]], &delta[i * sizeof(float[3])], sizeof(float[3]));
+          }
+          MEM_freeN(delta);
+        }
+      }
       else {
         for (int i = 0; i < unode->totvert; i++) {
           swap_v3_v3(vertCos[index[i]], unode->co[i]);
@@ -221,6 +435,18 @@ static bool sculpt_undo_restore_coords(bContext *C, Depsgraph *depsgraph, Sculpt
           }
         }
       }
+      else if (unode->is_packed) {
+        uchar *delta = sculpt_undo_unpack(unode);
+        if (delta) {
+          for (int i = 0; i < unode->totvert; i++) {
+            if (sculpt_undo_delta_apply(
+                    mvert[index[i]].co, &delta[i * sizeof(float[3])], sizeof(float[3]))) {
+              mvert[index[i]].flag |= ME_VERT_PBVH_UPDATE;
+            }
+          }
+          MEM_freeN(delta);
+        }
+      }
       else {
         for (int i = 0; i < unode->totvert; i++) {
           swap_v3_v3(mvert[index[i]].co, unode->co[i]);
@@ -240,6 +466,23 @@ static bool sculpt_undo_restore_coords(bContext *C, Depsgraph *depsgraph, Sculpt
     gridsize = subdiv_ccg->grid_size;
     BKE_subdiv_ccg_key_top_level(&key, subdiv_ccg);
 
+    if (unode->is_packed) {
+      uchar *delta = sculpt_undo_unpack(unode);
+      if (delta) {
+        const uchar *delta_iter = delta;
+        for (int j = 0; j < unode->totgrid; j++) {
+          grid = grids[unode->grids[j]];
+
+          for (int i = 0; i < gridsize * gridsize; i++, delta_iter += sizeof(float[3])) {
+            sculpt_undo_delta_apply(
+                CCG_elem_offset_co(&key, grid, i), delta_iter, sizeof(float[3]));
+          }
+        }
+        MEM_freeN(delta);
+      }
+      return true;
+    }
+
     co = unode->co;
     for (int j = 0; j < unode->totgrid; j++) {
       grid = grids[unode->grids[j]];
@@ -300,6 +543,20 @@ static bool sculpt_undo_restore_mask(bContext *C, SculptUndoNode *unode)
     mvert = ss->mvert;
     vmask = ss->vmask;
 
+    if (unode->is_packed) {
+      uchar *delta = sculpt_undo_unpack(unode);
+      if (delta) {
+        for (int i = 0; i < unode->totvert; i++) {
+          if (sculpt_undo_delta_apply(
+                  &vmask[index[i]], &delta[i * sizeof(float)], sizeof(float))) {
+            mvert[index[i]].flag |= ME_VERT_PBVH_UPDATE;
+          }
+        }
+        MEM_freeN(delta);
+      }
+      return true;
+    }
+
     for (int i = 0; i < unode->totvert; i++) {
       if (vmask[index[i]] != unode->mask[i]) {
         SWAP(float, vmask[index[i]], unode->mask[i]);
@@ -318,6 +575,23 @@ static bool sculpt_undo_restore_mask(bContext *C, SculptUndoNode *unode)
     gridsize = subdiv_ccg->grid_size;
     BKE_subdiv_ccg_key_top_level(&key, subdiv_ccg);
 
+    if (unode->is_packed) {
+      uchar *delta = sculpt_undo_unpack(unode);
+      if (delta) {
+        const uchar *delta_iter = delta;
+        for (int j = 0; j < unode->totgrid; j++) {
+          grid = grids[unode->grids[j]];
+
+          for (int i = 0; i < gridsize * gridsize; i++, delta_iter += sizeof(float)) {
+            sculpt_undo_delta_apply(
+                CCG_elem_offset_mask(&key, grid, i), delta_iter, sizeof(float));
+          }
+        }
+        MEM_freeN(delta);
+      }
+      return true;
+    }
+
     mask = unode->mask;
     for (int j = 0; j < unode->totgrid; j++) {
       grid = grids[unode->grids[j]];
@@ -753,6 +1027,9 @@ static void sculpt_undo_free_list(ListBase *lb)
     if (unode->face_sets) {
       MEM_freeN(unode->face_sets);
     }
+    if (unode->packed) {
+      MEM_freeN(unode->packed);
+    }
 
     MEM_freeN(unode);
 
@@ -846,7 +1123,7 @@ static SculptUndoNode *sculpt_undo_alloc_node(Object *ob, PBVHNode *node, Sculpt
       unode->co = MEM_mapallocN(sizeof(float[3]) * allvert, "SculptUndoNode.co");
       unode->no = MEM_mapallocN(sizeof(short[3]) * allvert, "SculptUndoNode.no");
 
-      usculpt->undo_size = (sizeof(float[3]) + sizeof(short[3]) + sizeof(int)) * allvert;
+      usculpt->undo_size += (sizeof(float[3]) + sizeof(short[3]) + sizeof(int)) * allvert;
       break;
     case SCULPT_UNDO_HIDDEN:
       if (maxgrid) {
@@ -860,7 +1137,7 @@ static SculptUndoNode *sculpt_undo_alloc_node(Object *ob, PBVHNode *node, Sculpt
     case SCULPT_UNDO_MASK:
       unode->mask = MEM_mapallocN(sizeof(float) * allvert, "SculptUndoNode.mask");
 
-      usculpt->undo_size += (sizeof(float) * sizeof(int)) * allvert;
+      usculpt->undo_size += (sizeof(float) + sizeof(int)) * allvert;
 
       break;
     case SCULPT_UNDO_DYNTOPO_BEGIN:
@@ -873,6 +1150,7 @@ static SculptUndoNode *sculpt_undo_alloc_node(Object *ob, PBVHNode *node, Sculpt
   }
 
   BLI_addtail(&usculpt->nodes, unode);
+  usculpt->ob = ob;
 
   if (maxgrid) {
     /* Multires. */
@@ -1195,13 +1473,20 @@ void SCULPT_undo_push_end(void)
   UndoSculpt *usculpt = sculpt_undo_get_nodes();
   SculptUndoNode *unode;
 
+  usculpt->undo_size_unpacked = usculpt->undo_size;
+
   /* We don't need normals in the undo stack. */
   for (unode = usculpt->nodes.first; unode; unode = unode->next) {
     if (unode->no) {
+      usculpt->undo_size -= MEM_allocN_len(unode->no);
       MEM_freeN(unode->no);
       unode->no = NULL;
     }
+  }
+
+  sculpt_undo_pack_nodes(usculpt);
 
+  for (unode = usculpt->nodes.first; unode; unode = unode->next) {
     if (unode->node) {
       BKE_pbvh_node_layer_disp_free(unode->node);
     }
@@ -1241,6 +1526,12 @@ static bool sculpt_undosys_step_encode(struct bContext *UNUSED(C),
    * to the current 'SculptUndoStep' added by encode_init. */
   SculptUndoStep *us = (SculptUndoStep *)us_p;
   us->step.data_size = us->data.undo_size;
+  CLOG_INFO(&LOG,
+            1,
+            "name='%s', data_size=%zu, unpacked=%zu",
+            us->step.name,
+            us->data.undo_size,
+            us->data.undo_size_unpacked);
 
   SculptUndoNode *unode = us->data.nodes.last;
   if (unode && unode->type == SCULPT_UNDO_DYNTOPO_END) {
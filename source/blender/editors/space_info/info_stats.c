@@ -47,6 +47,7 @@
 #include "BKE_key.h"
 #include "BKE_layer.h"
 #include "BKE_main.h"
+#include "BKE_modifier.h"
 #include "BKE_paint.h"
 #include "BKE_particle.h"
 #include "BKE_editmesh.h"
@@ -74,6 +75,8 @@ typedef struct SceneStats {
   uint64_t totlamp, totlampsel;
   uint64_t tottri;
   uint64_t totgplayer, totgpframe, totgpstroke, totgppoint;
+  /* Time spent tessellating metaballs on the last update, in seconds. */
+  double mball_tessellate_time;
 
   char infostr[MAX_INFO_LEN];
 } SceneStats;
@@ -174,6 +177,10 @@ static void stats_object(Object *ob, SceneStats *stats, GSet *objects_gset)
         }
 
         BKE_displist_count(&ob->runtime.curve_cache->disp, &totv, &totf, &tottri);
+
+        if (ob->type == OB_MBALL) {
+          stats->mball_tessellate_time += ob->runtime.curve_cache->mball_tessellate_time;
+        }
       }
 
       stats->totvert += totv;
@@ -396,7 +403,7 @@ static void stats_update(Depsgraph *depsgraph, ViewLayer *view_layer)
 
 static void stats_string(ViewLayer *view_layer)
 {
-#define MAX_INFO_MEM_LEN 64
+#define MAX_INFO_MEM_LEN 96
   SceneStats *stats = view_layer->stats;
   SceneStatsFmt stats_fmt;
   LayerCollection *layer_collection = view_layer->active_collection;
@@ -449,7 +456,14 @@ static void stats_string(ViewLayer *view_layer)
 
   if (mmap_in_use) {
     BLI_str_format_byte_unit(formatted_mem, mmap_in_use, false);
-    BLI_snprintf(memstr + ofs, MAX_INFO_MEM_LEN - ofs, TIP_(" (%s)"), formatted_mem);
+    ofs += BLI_snprintf(memstr + ofs, MAX_INFO_MEM_LEN - ofs, TIP_(" (%s)"), formatted_mem);
+  }
+
+  const size_t modifier_cache_in_use = BKE_modifier_stack_cache_memory_in_use();
+  if (modifier_cache_in_use) {
+    BLI_str_format_byte_unit(formatted_mem, modifier_cache_in_use, false);
+    BLI_snprintf(
+        memstr + ofs, MAX_INFO_MEM_LEN - ofs, TIP_(" | Modifier Cache: %s"), formatted_mem);
   }
 
   if (GPU_mem_stats_supported()) {
@@ -551,14 +565,22 @@ static void stats_string(ViewLayer *view_layer)
   else {
     ofs += BLI_snprintf(s + ofs,
                         MAX_INFO_LEN - ofs,
-                        TIP_("Verts:%s | Faces:%s | Tris:%s | Objects:%s/%s%s%s"),
+                        TIP_("Verts:%s | Faces:%s | Tris:%s | Objects:%s/%s"),
                         stats_fmt.totvert,
                         stats_fmt.totface,
                         stats_fmt.tottri,
                         stats_fmt.totobjsel,
-                        stats_fmt.totobj,
-                        memstr,
-                        gpumemstr);
+                        stats_fmt.totobj);
+
+    if (stats->mball_tessellate_time > 0.0) {
+      ofs += BLI_snprintf(s + ofs,
+                          MAX_INFO_LEN - ofs,
+                          TIP_(" | Metaballs:%.1f ms"),
+                          stats->mball_tessellate_time * 1000.0);
+    }
+
+    ofs += BLI_strncpy_rlen(s + ofs, memstr, MAX_INFO_LEN - ofs);
+    ofs += BLI_strncpy_rlen(s + ofs, gpumemstr, MAX_INFO_LEN - ofs);
   }
 
   ofs += BLI_snprintf(s + ofs, MAX_INFO_LEN - ofs, " | %s", versionstr);
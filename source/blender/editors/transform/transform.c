@@ -71,6 +71,12 @@
  * and being able to set it to zero is handy. */
 // #define USE_NUM_NO_ZERO
 
+/* Print the time spent creating the transform data and applying every update. */
+// #define DEBUG_TIME
+#ifdef DEBUG_TIME
+#  include "PIL_time.h"
+#endif
+
 static void drawTransformApply(const struct bContext *C, ARegion *region, void *arg);
 
 static void initSnapSpatial(TransInfo *t, float r_snap[3]);
@@ -2030,8 +2036,18 @@ bool initTransform(bContext *C, TransInfo *t, wmOperator *op, const wmEvent *eve
                                                      t);
   }
 
+#ifdef DEBUG_TIME
+  const double time_start = PIL_check_seconds_timer();
+#endif
+
   createTransData(C, t);  // make TransData structs from selection
 
+#ifdef DEBUG_TIME
+  printf("transform init: %d elements, %f seconds\n",
+         t->data_len_all,
+         PIL_check_seconds_timer() - time_start);
+#endif
+
   if ((t->options & CTX_SCULPT) && !(t->options & CTX_PAINT_CURVE)) {
     ED_sculpt_init_transform(C);
   }
@@ -2233,7 +2249,18 @@ void transformApply(bContext *C, TransInfo *t)
   if ((t->redraw & TREDRAW_HARD) || (t->draw_handle_apply == NULL && (t->redraw & TREDRAW_SOFT))) {
     selectConstraint(t);
     if (t->transform) {
+#ifdef DEBUG_TIME
+      const double time_start = PIL_check_seconds_timer();
+#endif
+
       t->transform(t, t->mval);  // calls recalcData()
+
+#ifdef DEBUG_TIME
+      printf("transform update: %d elements, %f seconds\n",
+             t->data_len_all,
+             PIL_check_seconds_timer() - time_start);
+#endif
+
       viewRedrawForce(C, t);
     }
     t->redraw = TREDRAW_NOTHING;
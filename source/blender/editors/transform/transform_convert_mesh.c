@@ -27,11 +27,13 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 #include "BLI_alloca.h"
 #include "BLI_bitmap.h"
 #include "BLI_math.h"
 #include "BLI_memarena.h"
-#include "BLI_linklist_stack.h"
+#include "BLI_task.h"
 
 #include "BKE_context.h"
 #include "BKE_crazyspace.h"
@@ -70,12 +72,42 @@ struct TransIslandData {
  *
  * \{ */
 
+/* Threading a pass over the queue only pays off for large queues. */
+#define CONNECTIVITY_DIST_PARALLEL_MIN 1024
+
+/**
+ * The distance and original index are stored together so both are updated by a single atomic
+ * operation. Distances are never negative, so their bits compare like unsigned integers,
+ * the index breaks ties so the result doesn't depend on which thread gets there first.
+ */
+BLI_INLINE uint64_t dist_index_pack(const float dist, const int index)
+{
+  union {
+    float f;
+    uint32_t u;
+  } dist_bits = {.f = dist};
+  return ((uint64_t)dist_bits.u << 32) | (uint32_t)index;
+}
+
+BLI_INLINE float dist_index_unpack_dist(const uint64_t dist_index)
+{
+  union {
+    float f;
+    uint32_t u;
+  } dist_bits = {.u = (uint32_t)(dist_index >> 32)};
+  return dist_bits.f;
+}
+
+BLI_INLINE int dist_index_unpack_index(const uint64_t dist_index)
+{
+  return (int)(dist_index & 0xffffffff);
+}
+
 static bool bmesh_test_dist_add(BMVert *v,
                                 BMVert *v_other,
-                                float *dists,
+                                uint64_t *dists,
                                 const float *dists_prev,
                                 /* optionally track original index */
-                                int *index,
                                 const int *index_prev,
                                 const float mtx[3][3])
 {
@@ -89,35 +121,120 @@ static bool bmesh_test_dist_add(BMVert *v,
     mul_m3_v3(mtx, vec);
 
     dist_other = dists_prev[i] + len_v3(vec);
-    if (dist_other < dists[i_other]) {
-      dists[i_other] = dist_other;
-      if (index != NULL) {
-        index[i_other] = index_prev[i];
+    const uint64_t dist_index_other = dist_index_pack(dist_other,
+                                                      index_prev ? index_prev[i] : 0);
+    uint64_t dist_index_prev = dists[i_other];
+    while (dist_index_other < dist_index_prev) {
+      const uint64_t dist_index_found = atomic_cas_uint64(
+          &dists[i_other], dist_index_prev, dist_index_other);
+      if (dist_index_found == dist_index_prev) {
+        return true;
       }
-      return true;
+      dist_index_prev = dist_index_found;
     }
   }
 
   return false;
 }
 
+struct ConnectivityDistData {
+  const float (*mtx)[3];
+  uint64_t *dists;
+  const float *dists_prev;
+  const int *index_prev;
+  /* Set for the verts in 'queue_next', so they're not added twice. */
+  uint8_t *queued;
+
+  BMVert **queue;
+  BMVert **queue_next;
+  uint32_t queue_next_len;
+};
+
+static void connectivity_dist_queue_add(struct ConnectivityDistData *data, BMVert *v)
+{
+  if (atomic_fetch_and_or_uint8(&data->queued[BM_elem_index_get(v)], 1) == 0) {
+    const uint32_t queue_index = atomic_fetch_and_add_uint32(&data->queue_next_len, 1);
+    data->queue_next[queue_index] = v;
+  }
+}
+
+static void connectivity_dist_step_fn(void *__restrict userdata,
+                                      const int iter,
+                                      const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  struct ConnectivityDistData *data = userdata;
+  BMVert *v = data->queue[iter];
+
+  BLI_assert(dist_index_unpack_dist(data->dists[BM_elem_index_get(v)]) != FLT_MAX);
+
+  /* connected edge-verts */
+  if (v->e != NULL) {
+    BMEdge *e_iter, *e_first;
+
+    e_iter = e_first = v->e;
+
+    /* would normally use BM_EDGES_OF_VERT, but this runs so often,
+     * its faster to iterate on the data directly */
+    do {
+
+      if (BM_elem_flag_test(e_iter, BM_ELEM_HIDDEN) == 0) {
+
+        /* edge distance */
+        {
+          BMVert *v_other = BM_edge_other_vert(e_iter, v);
+          if (bmesh_test_dist_add(
+                  v, v_other, data->dists, data->dists_prev, data->index_prev, data->mtx)) {
+            connectivity_dist_queue_add(data, v_other);
+          }
+        }
+
+        /* face distance */
+        if (e_iter->l) {
+          BMLoop *l_iter_radial, *l_first_radial;
+          /**
+           * imaginary edge diagonally across quad.
+           * \note This takes advantage of the rules of winding that we
+           * know 2 or more of a verts edges wont reference the same face twice.
+           * Also, if the edge is hidden, the face will be hidden too.
+           */
+          l_iter_radial = l_first_radial = e_iter->l;
+
+          do {
+            if ((l_iter_radial->v == v) && (l_iter_radial->f->len == 4) &&
+                (BM_elem_flag_test(l_iter_radial->f, BM_ELEM_HIDDEN) == 0)) {
+              BMVert *v_other = l_iter_radial->next->next->v;
+              if (bmesh_test_dist_add(
+                      v, v_other, data->dists, data->dists_prev, data->index_prev, data->mtx)) {
+                connectivity_dist_queue_add(data, v_other);
+              }
+            }
+          } while ((l_iter_radial = l_iter_radial->radial_next) != l_first_radial);
+        }
+      }
+    } while ((e_iter = BM_DISK_EDGE_NEXT(e_iter, v)) != e_first);
+  }
+}
+
 /**
  * \param mtx: Measure distance in this space.
  * \param dists: Store the closest connected distance to selected vertices.
  * \param index: Optionally store the original index we're measuring the distance to (can be NULL).
+ *
+ * Distances spread out from the selection one step at a time,
+ * the verts reached by a step are handled in parallel.
  */
 static void editmesh_set_connectivity_distance(BMesh *bm,
                                                const float mtx[3][3],
                                                float *dists,
                                                int *index)
 {
-  BLI_LINKSTACK_DECLARE(queue, BMVert *);
-
-  /* any BM_ELEM_TAG'd vertex is in 'queue_next', so we don't add in twice */
-  BLI_LINKSTACK_DECLARE(queue_next, BMVert *);
+  struct ConnectivityDistData data = {.mtx = mtx};
+  uint32_t queue_len = 0;
 
-  BLI_LINKSTACK_INIT(queue);
-  BLI_LINKSTACK_INIT(queue_next);
+  data.dists = MEM_mallocN(sizeof(*data.dists) * bm->totvert, __func__);
+  data.queue = MEM_mallocN(sizeof(*data.queue) * bm->totvert, __func__);
+  data.queue_next = MEM_mallocN(sizeof(*data.queue_next) * bm->totvert, __func__);
+  data.queued = MEM_callocN(sizeof(*data.queued) * bm->totvert, __func__);
 
   {
     BMIter viter;
@@ -131,19 +248,17 @@ static void editmesh_set_connectivity_distance(BMesh *bm,
 
       if (BM_elem_flag_test(v, BM_ELEM_SELECT) == 0 || BM_elem_flag_test(v, BM_ELEM_HIDDEN)) {
         dist = FLT_MAX;
-        if (index != NULL) {
-          index[i] = i;
-        }
       }
       else {
-        BLI_LINKSTACK_PUSH(queue, v);
+        data.queue[queue_len++] = v;
         dist = 0.0f;
-        if (index != NULL) {
-          index[i] = i;
-        }
+      }
+      if (index != NULL) {
+        index[i] = i;
       }
 
       dists[i] = dist;
+      data.dists[i] = dist_index_pack(dist, index ? i : 0);
     }
     bm->elem_index_dirty &= ~BM_VERT;
   }
@@ -151,96 +266,44 @@ static void editmesh_set_connectivity_distance(BMesh *bm,
   /* need to be very careful of feedback loops here, store previous dist's to avoid feedback */
   float *dists_prev = MEM_dupallocN(dists);
   int *index_prev = MEM_dupallocN(index); /* may be NULL */
-
-  do {
-    BMVert *v;
-    LinkNode *lnk;
-
-    /* this is correct but slow to do each iteration,
-     * instead sync the dist's while clearing BM_ELEM_TAG (below) */
-#if 0
-    memcpy(dists_prev, dists, sizeof(float) * bm->totvert);
-#endif
-
-    while ((v = BLI_LINKSTACK_POP(queue))) {
-      BLI_assert(dists[BM_elem_index_get(v)] != FLT_MAX);
-
-      /* connected edge-verts */
-      if (v->e != NULL) {
-        BMEdge *e_iter, *e_first;
-
-        e_iter = e_first = v->e;
-
-        /* would normally use BM_EDGES_OF_VERT, but this runs so often,
-         * its faster to iterate on the data directly */
-        do {
-
-          if (BM_elem_flag_test(e_iter, BM_ELEM_HIDDEN) == 0) {
-
-            /* edge distance */
-            {
-              BMVert *v_other = BM_edge_other_vert(e_iter, v);
-              if (bmesh_test_dist_add(v, v_other, dists, dists_prev, index, index_prev, mtx)) {
-                if (BM_elem_flag_test(v_other, BM_ELEM_TAG) == 0) {
-                  BM_elem_flag_enable(v_other, BM_ELEM_TAG);
-                  BLI_LINKSTACK_PUSH(queue_next, v_other);
-                }
-              }
-            }
-
-            /* face distance */
-            if (e_iter->l) {
-              BMLoop *l_iter_radial, *l_first_radial;
-              /**
-               * imaginary edge diagonally across quad.
-               * \note This takes advantage of the rules of winding that we
-               * know 2 or more of a verts edges wont reference the same face twice.
-               * Also, if the edge is hidden, the face will be hidden too.
-               */
-              l_iter_radial = l_first_radial = e_iter->l;
-
-              do {
-                if ((l_iter_radial->v == v) && (l_iter_radial->f->len == 4) &&
-                    (BM_elem_flag_test(l_iter_radial->f, BM_ELEM_HIDDEN) == 0)) {
-                  BMVert *v_other = l_iter_radial->next->next->v;
-                  if (bmesh_test_dist_add(v, v_other, dists, dists_prev, index, index_prev, mtx)) {
-                    if (BM_elem_flag_test(v_other, BM_ELEM_TAG) == 0) {
-                      BM_elem_flag_enable(v_other, BM_ELEM_TAG);
-                      BLI_LINKSTACK_PUSH(queue_next, v_other);
-                    }
-                  }
-                }
-              } while ((l_iter_radial = l_iter_radial->radial_next) != l_first_radial);
-            }
-          }
-        } while ((e_iter = BM_DISK_EDGE_NEXT(e_iter, v)) != e_first);
-      }
-    }
-
-    /* clear for the next loop */
-    for (lnk = queue_next; lnk; lnk = lnk->next) {
-      BMVert *v_link = lnk->link;
-      const int i = BM_elem_index_get(v_link);
-
-      BM_elem_flag_disable(v_link, BM_ELEM_TAG);
-
-      /* keep in sync, avoid having to do full memcpy each iteration */
-      dists_prev[i] = dists[i];
+  data.dists_prev = dists_prev;
+  data.index_prev = index_prev;
+
+  while (queue_len) {
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.use_threading = queue_len >= CONNECTIVITY_DIST_PARALLEL_MIN;
+    settings.min_iter_per_thread = CONNECTIVITY_DIST_PARALLEL_MIN;
+
+    data.queue_next_len = 0;
+    BLI_task_parallel_range(0, (int)queue_len, &data, connectivity_dist_step_fn, &settings);
+
+    /* clear for the next loop,
+     * keep in sync, avoid having to do full memcpy each iteration */
+    for (uint32_t i = 0; i < data.queue_next_len; i++) {
+      const int v_index = BM_elem_index_get(data.queue_next[i]);
+      data.queued[v_index] = 0;
+      dists_prev[v_index] = dist_index_unpack_dist(data.dists[v_index]);
       if (index != NULL) {
-        index_prev[i] = index[i];
+        index_prev[v_index] = dist_index_unpack_index(data.dists[v_index]);
       }
     }
 
-    BLI_LINKSTACK_SWAP(queue, queue_next);
-
-    /* none should be tagged now since 'queue_next' is empty */
-    BLI_assert(BM_iter_mesh_count_flag(BM_VERTS_OF_MESH, bm, BM_ELEM_TAG, true) == 0);
-
-  } while (BLI_LINKSTACK_SIZE(queue));
+    SWAP(BMVert **, data.queue, data.queue_next);
+    queue_len = data.queue_next_len;
+  }
 
-  BLI_LINKSTACK_FREE(queue);
-  BLI_LINKSTACK_FREE(queue_next);
+  for (int i = 0; i < bm->totvert; i++) {
+    dists[i] = dist_index_unpack_dist(data.dists[i]);
+    if (index != NULL) {
+      index[i] = dist_index_unpack_index(data.dists[i]);
+    }
+  }
 
+  MEM_freeN(data.dists);
+  MEM_freeN(data.queue);
+  MEM_freeN(data.queue_next);
+  MEM_freeN(data.queued);
   MEM_freeN(dists_prev);
   if (index_prev != NULL) {
     MEM_freeN(index_prev);
@@ -49,6 +49,7 @@
 #include "BLI_math.h"
 #include "BLI_blenlib.h"
 #include "BLI_rand.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "PIL_time.h"
@@ -2288,10 +2289,98 @@ const TransCenterData *transformCenter_from_type(TransInfo *t, int around)
   return cd;
 }
 
+static void transdata_elem_prop_ratio(TransInfo *t, TransData *td, const bool connected)
+{
+  float dist;
+
+  if (td->flag & TD_SELECTED) {
+    td->factor = 1.0f;
+  }
+  else if ((connected && (td->flag & TD_NOTCONNECTED || td->dist > t->prop_size)) ||
+           (connected == 0 && td->rdist > t->prop_size)) {
+    /*
+     * The elements are sorted according to their dist member in the array,
+     * that means we can stop when it finds one element outside of the propsize.
+     * do not set 'td->flag |= TD_NOACTION', the prop circle is being changed.
+     */
+
+    td->factor = 0.0f;
+    restoreElement(td);
+  }
+  else {
+    /* Use rdist for falloff calculations, it is the real distance */
+    td->flag &= ~TD_NOACTION;
+
+    if (connected) {
+      dist = (t->prop_size - td->dist) / t->prop_size;
+    }
+    else {
+      dist = (t->prop_size - td->rdist) / t->prop_size;
+    }
+
+    /*
+     * Clamp to positive numbers.
+     * Certain corner cases with connectivity and individual centers
+     * can give values of rdist larger than propsize.
+     */
+    if (dist < 0.0f) {
+      dist = 0.0f;
+    }
+
+    switch (t->prop_mode) {
+      case PROP_SHARP:
+        td->factor = dist * dist;
+        break;
+      case PROP_SMOOTH:
+        td->factor = 3.0f * dist * dist - 2.0f * dist * dist * dist;
+        break;
+      case PROP_ROOT:
+        td->factor = sqrtf(dist);
+        break;
+      case PROP_LIN:
+        td->factor = dist;
+        break;
+      case PROP_CONST:
+        td->factor = 1.0f;
+        break;
+      case PROP_SPHERE:
+        td->factor = sqrtf(2 * dist - dist * dist);
+        break;
+      case PROP_RANDOM:
+        if (t->rng == NULL) {
+          /* Lazy initialization. */
+          uint rng_seed = (uint)(PIL_check_seconds_timer_i() & UINT_MAX);
+          t->rng = BLI_rng_new(rng_seed);
+        }
+        td->factor = BLI_rng_get_float(t->rng) * dist;
+        break;
+      case PROP_INVSQUARE:
+        td->factor = dist * (2.0f - dist);
+        break;
+      default:
+        td->factor = 1;
+        break;
+    }
+  }
+}
+
+struct TransDataArgs_PropRatio {
+  TransInfo *t;
+  TransDataContainer *tc;
+  bool connected;
+};
+
+static void transdata_elem_prop_ratio_fn(void *__restrict iter_data_v,
+                                         const int iter,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  struct TransDataArgs_PropRatio *data = iter_data_v;
+  transdata_elem_prop_ratio(data->t, &data->tc->data[iter], data->connected);
+}
+
 void calculatePropRatio(TransInfo *t)
 {
   int i;
-  float dist;
   const bool connected = (t->flag & T_PROP_CONNECTED) != 0;
 
   t->proptext[0] = '\0';
@@ -2299,78 +2388,19 @@ void calculatePropRatio(TransInfo *t)
   if (t->flag & T_PROP_EDIT) {
     const char *pet_id = NULL;
     FOREACH_TRANS_DATA_CONTAINER (t, tc) {
-      TransData *td = tc->data;
-      for (i = 0; i < tc->data_len; i++, td++) {
-        if (td->flag & TD_SELECTED) {
-          td->factor = 1.0f;
-        }
-        else if ((connected && (td->flag & TD_NOTCONNECTED || td->dist > t->prop_size)) ||
-                 (connected == 0 && td->rdist > t->prop_size)) {
-          /*
-           * The elements are sorted according to their dist member in the array,
-           * that means we can stop when it finds one element outside of the propsize.
-           * do not set 'td->flag |= TD_NOACTION', the prop circle is being changed.
-           */
-
-          td->factor = 0.0f;
-          restoreElement(td);
-        }
-        else {
-          /* Use rdist for falloff calculations, it is the real distance */
-          td->flag &= ~TD_NOACTION;
-
-          if (connected) {
-            dist = (t->prop_size - td->dist) / t->prop_size;
-          }
-          else {
-            dist = (t->prop_size - td->rdist) / t->prop_size;
-          }
-
-          /*
-           * Clamp to positive numbers.
-           * Certain corner cases with connectivity and individual centers
-           * can give values of rdist larger than propsize.
-           */
-          if (dist < 0.0f) {
-            dist = 0.0f;
-          }
-
-          switch (t->prop_mode) {
-            case PROP_SHARP:
-              td->factor = dist * dist;
-              break;
-            case PROP_SMOOTH:
-              td->factor = 3.0f * dist * dist - 2.0f * dist * dist * dist;
-              break;
-            case PROP_ROOT:
-              td->factor = sqrtf(dist);
-              break;
-            case PROP_LIN:
-              td->factor = dist;
-              break;
-            case PROP_CONST:
-              td->factor = 1.0f;
-              break;
-            case PROP_SPHERE:
-              td->factor = sqrtf(2 * dist - dist * dist);
-              break;
-            case PROP_RANDOM:
-              if (t->rng == NULL) {
-                /* Lazy initialization. */
-                uint rng_seed = (uint)(PIL_check_seconds_timer_i() & UINT_MAX);
-                t->rng = BLI_rng_new(rng_seed);
-              }
-              td->factor = BLI_rng_get_float(t->rng) * dist;
-              break;
-            case PROP_INVSQUARE:
-              td->factor = dist * (2.0f - dist);
-              break;
-            default:
-              td->factor = 1;
-              break;
-          }
-        }
-      }
+      struct TransDataArgs_PropRatio data = {
+          .t = t,
+          .tc = tc,
+          .connected = connected,
+      };
+
+      TaskParallelSettings settings;
+      transform_data_parallel_settings(t, tc, &settings);
+      /* Random falloff draws from a single generator, in order. */
+      if (t->prop_mode == PROP_RANDOM) {
+        settings.use_threading = false;
+      }
+      BLI_task_parallel_range(0, tc->data_len, &data, transdata_elem_prop_ratio_fn, &settings);
     }
 
     switch (t->prop_mode) {
@@ -32,6 +32,7 @@
 #include "BLI_listbase.h"
 #include "BLI_math.h"
 #include "BLI_string.h"
+#include "BLI_task.h"
 
 #include "BKE_constraint.h"
 #include "BKE_context.h"
@@ -1007,6 +1008,31 @@ void ElementResize(TransInfo *t, TransDataContainer *tc, TransData *td, float ma
 }
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/* Transform (Parallel Utils) */
+
+/** \name Transform Parallel Utils
+ * \{ */
+
+/* Threading the per element loops only pays off for large selections. */
+#define TRANSFORM_PARALLEL_ELEM_MIN 1024
+
+/**
+ * Settings to apply a transformation to the elements of \a tc using #BLI_task_parallel_range.
+ * The elements are independent of each other, only the per element grease pencil options
+ * also update #TransInfo.values_final so they always run on a single thread.
+ */
+void transform_data_parallel_settings(const TransInfo *t,
+                                      const TransDataContainer *tc,
+                                      TaskParallelSettings *settings)
+{
+  BLI_parallel_range_settings_defaults(settings);
+  settings->use_threading = (tc->data_len >= TRANSFORM_PARALLEL_ELEM_MIN) &&
+                            (t->options & CTX_GPENCIL_STROKES) == 0;
+  settings->min_iter_per_thread = TRANSFORM_PARALLEL_ELEM_MIN;
+}
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /* Transform (Frame Utils) */
 
@@ -27,6 +27,7 @@
 
 struct AnimData;
 struct LinkNode;
+struct TaskParallelSettings;
 struct TransInfo;
 struct TransDataContainer;
 struct TransData;
@@ -58,6 +59,9 @@ short getAnimEdit_SnapMode(TransInfo *t);
 void doAnimEdit_SnapFrame(
     TransInfo *t, TransData *td, TransData2D *td2d, struct AnimData *adt, short autosnap);
 void transform_mode_init(TransInfo *t, struct wmOperator *op, const int mode);
+void transform_data_parallel_settings(const TransInfo *t,
+                                      const TransDataContainer *tc,
+                                      struct TaskParallelSettings *settings);
 
 /* transform_mode_align.c */
 void initAlign(TransInfo *t);
@@ -24,6 +24,7 @@
 #include <stdlib.h>
 
 #include "BLI_math.h"
+#include "BLI_task.h"
 
 #include "BKE_context.h"
 #include "BKE_unit.h"
@@ -44,6 +45,24 @@
 /** \name Transform Resize
  * \{ */
 
+struct TransDataArgs_Resize {
+  TransInfo *t;
+  TransDataContainer *tc;
+  float mat[3][3];
+};
+
+static void transdata_elem_resize_fn(void *__restrict iter_data_v,
+                                     const int iter,
+                                     const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  struct TransDataArgs_Resize *data = iter_data_v;
+  TransData *td = &data->tc->data[iter];
+  if (td->flag & (TD_NOACTION | TD_SKIP)) {
+    return;
+  }
+  ElementResize(data->t, data->tc, td, data->mat);
+}
+
 static void applyResize(TransInfo *t, const int UNUSED(mval[2]))
 {
   float mat[3][3];
@@ -91,18 +110,15 @@ static void applyResize(TransInfo *t, const int UNUSED(mval[2]))
   copy_m3_m3(t->mat, mat);  // used in gizmo
 
   FOREACH_TRANS_DATA_CONTAINER (t, tc) {
-    TransData *td = tc->data;
-    for (i = 0; i < tc->data_len; i++, td++) {
-      if (td->flag & TD_NOACTION) {
-        break;
-      }
-
-      if (td->flag & TD_SKIP) {
-        continue;
-      }
-
-      ElementResize(t, tc, td, mat);
-    }
+    struct TransDataArgs_Resize data = {
+        .t = t,
+        .tc = tc,
+    };
+    copy_m3_m3(data.mat, mat);
+
+    TaskParallelSettings settings;
+    transform_data_parallel_settings(t, tc, &settings);
+    BLI_task_parallel_range(0, tc->data_len, &data, transdata_elem_resize_fn, &settings);
   }
 
   /* evil hack - redo resize if cliping needed */
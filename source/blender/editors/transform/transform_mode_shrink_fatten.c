@@ -25,6 +25,7 @@
 
 #include "BLI_math.h"
 #include "BLI_string.h"
+#include "BLI_task.h"
 
 #include "BKE_context.h"
 #include "BKE_unit.h"
@@ -47,10 +48,40 @@
 /** \name Transform Shrink-Fatten
  * \{ */
 
+static void transdata_elem_shrink_fatten(const TransInfo *t,
+                                         TransData *td,
+                                         const float distance)
+{
+  /* get the final offset */
+  float tdistance = distance * td->factor;
+  if (td->ext && (t->flag & T_ALT_TRANSFORM) != 0) {
+    tdistance *= td->ext->isize[0]; /* shell factor */
+  }
+
+  madd_v3_v3v3fl(td->loc, td->iloc, td->axismtx[2], tdistance);
+}
+
+struct TransDataArgs_ShrinkFatten {
+  const TransInfo *t;
+  const TransDataContainer *tc;
+  float distance;
+};
+
+static void transdata_elem_shrink_fatten_fn(void *__restrict iter_data_v,
+                                            const int iter,
+                                            const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  struct TransDataArgs_ShrinkFatten *data = iter_data_v;
+  TransData *td = &data->tc->data[iter];
+  if (td->flag & (TD_NOACTION | TD_SKIP)) {
+    return;
+  }
+  transdata_elem_shrink_fatten(data->t, td, data->distance);
+}
+
 static void applyShrinkFatten(TransInfo *t, const int UNUSED(mval[2]))
 {
   float distance;
-  int i;
   char str[UI_MAX_DRAW_STR];
   size_t ofs = 0;
 
@@ -92,25 +123,15 @@ static void applyShrinkFatten(TransInfo *t, const int UNUSED(mval[2]))
   /* done with header string */
 
   FOREACH_TRANS_DATA_CONTAINER (t, tc) {
-    TransData *td = tc->data;
-    for (i = 0; i < tc->data_len; i++, td++) {
-      float tdistance; /* temp dist */
-      if (td->flag & TD_NOACTION) {
-        break;
-      }
-
-      if (td->flag & TD_SKIP) {
-        continue;
-      }
-
-      /* get the final offset */
-      tdistance = distance * td->factor;
-      if (td->ext && (t->flag & T_ALT_TRANSFORM) != 0) {
-        tdistance *= td->ext->isize[0]; /* shell factor */
-      }
-
-      madd_v3_v3v3fl(td->loc, td->iloc, td->axismtx[2], tdistance);
-    }
+    struct TransDataArgs_ShrinkFatten data = {
+        .t = t,
+        .tc = tc,
+        .distance = distance,
+    };
+
+    TaskParallelSettings settings;
+    transform_data_parallel_settings(t, tc, &settings);
+    BLI_task_parallel_range(0, tc->data_len, &data, transdata_elem_shrink_fatten_fn, &settings);
   }
 
   recalcData(t);
@@ -24,6 +24,7 @@
 #include <stdlib.h>
 
 #include "BLI_math.h"
+#include "BLI_task.h"
 #include "BLI_string.h"
 
 #include "BKE_context.h"
@@ -45,11 +46,43 @@
 /** \name Transform ToSphere
  * \{ */
 
-static void applyToSphere(TransInfo *t, const int UNUSED(mval[2]))
+static void transdata_elem_to_sphere(const TransInfo *t,
+                                     const TransDataContainer *tc,
+                                     TransData *td,
+                                     const float ratio)
 {
   float vec[3];
-  float ratio, radius;
-  int i;
+  sub_v3_v3v3(vec, td->iloc, tc->center_local);
+
+  const float radius = normalize_v3(vec);
+  const float tratio = ratio * td->factor;
+
+  mul_v3_fl(vec, radius * (1.0f - tratio) + t->val * tratio);
+
+  add_v3_v3v3(td->loc, tc->center_local, vec);
+}
+
+struct TransDataArgs_ToSphere {
+  const TransInfo *t;
+  const TransDataContainer *tc;
+  float ratio;
+};
+
+static void transdata_elem_to_sphere_fn(void *__restrict iter_data_v,
+                                        const int iter,
+                                        const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  struct TransDataArgs_ToSphere *data = iter_data_v;
+  TransData *td = &data->tc->data[iter];
+  if (td->flag & (TD_NOACTION | TD_SKIP)) {
+    return;
+  }
+  transdata_elem_to_sphere(data->t, data->tc, td, data->ratio);
+}
+
+static void applyToSphere(TransInfo *t, const int UNUSED(mval[2]))
+{
+  float ratio;
   char str[UI_MAX_DRAW_STR];
 
   ratio = t->values[0];
@@ -76,27 +109,15 @@ static void applyToSphere(TransInfo *t, const int UNUSED(mval[2]))
   }
 
   FOREACH_TRANS_DATA_CONTAINER (t, tc) {
-    TransData *td = tc->data;
-    for (i = 0; i < tc->data_len; i++, td++) {
-      float tratio;
-      if (td->flag & TD_NOACTION) {
-        break;
-      }
-
-      if (td->flag & TD_SKIP) {
-        continue;
-      }
-
-      sub_v3_v3v3(vec, td->iloc, tc->center_local);
-
-      radius = normalize_v3(vec);
-
-      tratio = ratio * td->factor;
-
-      mul_v3_fl(vec, radius * (1.0f - tratio) + t->val * tratio);
-
-      add_v3_v3v3(td->loc, tc->center_local, vec);
-    }
+    struct TransDataArgs_ToSphere data = {
+        .t = t,
+        .tc = tc,
+        .ratio = ratio,
+    };
+
+    TaskParallelSettings settings;
+    transform_data_parallel_settings(t, tc, &settings);
+    BLI_task_parallel_range(0, tc->data_len, &data, transdata_elem_to_sphere_fn, &settings);
   }
 
   recalcData(t);
@@ -29,6 +29,8 @@
 #include "BLI_convexhull_2d.h"
 #include "BLI_polyfill_2d.h"
 #include "BLI_polyfill_2d_beautify.h"
+#include "BLI_raster_pack_2d.h"
+#include "BLI_task.h"
 
 #include "uvedit_parametrizer.h"
 
@@ -4546,47 +4548,96 @@ void param_construct_end(ParamHandle *handle, ParamBool fill, ParamBool impl)
   phandle->state = PHANDLE_STATE_CONSTRUCTED;
 }
 
-void param_lscm_begin(ParamHandle *handle, ParamBool live, ParamBool abf)
+int param_chart_count(ParamHandle *handle)
 {
   PHandle *phandle = (PHandle *)handle;
+
+  param_assert(phandle->state != PHANDLE_STATE_ALLOCATED);
+
+  return phandle->ncharts;
+}
+
+/* Charts share no data, so they are solved in parallel. Every chart gets its own solver and
+ * results are written to the chart only, so they don't depend on the number of threads. */
+
+typedef struct PLscmTaskData {
+  PHandle *handle;
+  PBool live, abf;
+} PLscmTaskData;
+
+static void p_lscm_begin_task_cb(void *__restrict userdata,
+                                 const int i,
+                                 const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  PLscmTaskData *data = userdata;
+  PChart *chart = data->handle->charts[i];
   PFace *f;
-  int i;
 
-  param_assert(phandle->state == PHANDLE_STATE_CONSTRUCTED);
-  phandle->state = PHANDLE_STATE_LSCM;
+  for (f = chart->faces; f; f = f->nextlink) {
+    p_face_backup_uvs(f);
+  }
+  p_chart_lscm_begin(chart, data->live, data->abf);
+}
 
-  for (i = 0; i < phandle->ncharts; i++) {
-    for (f = phandle->charts[i]->faces; f; f = f->nextlink) {
-      p_face_backup_uvs(f);
+static void p_lscm_solve_task_cb(void *__restrict userdata,
+                                 const int i,
+                                 const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  PLscmTaskData *data = userdata;
+  PChart *chart = data->handle->charts[i];
+  PBool result;
+
+  if (chart->u.lscm.context) {
+    result = p_chart_lscm_solve(data->handle, chart);
+
+    if (result && !(chart->flag & PCHART_HAS_PINS)) {
+      p_chart_rotate_minimum_area(chart);
+    }
+
+    if (!result || (chart->u.lscm.pin1)) {
+      p_chart_lscm_end(chart);
     }
-    p_chart_lscm_begin(phandle->charts[i], (PBool)live, (PBool)abf);
   }
 }
 
-void param_lscm_solve(ParamHandle *handle)
+static void p_lscm_charts_parallel(PHandle *phandle,
+                                   PLscmTaskData *data,
+                                   TaskParallelRangeFunc func)
+{
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (phandle->ncharts > 1);
+  /* Chart sizes vary a lot, hand them out one by one to balance the load. */
+  settings.min_iter_per_thread = 1;
+  settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+  BLI_task_parallel_range(0, phandle->ncharts, data, func, &settings);
+}
+
+void param_lscm_begin(ParamHandle *handle, ParamBool live, ParamBool abf)
 {
   PHandle *phandle = (PHandle *)handle;
-  PChart *chart;
-  int i;
-  PBool result;
+  PLscmTaskData data = {
+      .handle = phandle,
+      .live = (PBool)live,
+      .abf = (PBool)abf,
+  };
 
-  param_assert(phandle->state == PHANDLE_STATE_LSCM);
+  param_assert(phandle->state == PHANDLE_STATE_CONSTRUCTED);
+  phandle->state = PHANDLE_STATE_LSCM;
 
-  for (i = 0; i < phandle->ncharts; i++) {
-    chart = phandle->charts[i];
+  p_lscm_charts_parallel(phandle, &data, p_lscm_begin_task_cb);
+}
 
-    if (chart->u.lscm.context) {
-      result = p_chart_lscm_solve(phandle, chart);
+void param_lscm_solve(ParamHandle *handle)
+{
+  PHandle *phandle = (PHandle *)handle;
+  PLscmTaskData data = {
+      .handle = phandle,
+  };
 
-      if (result && !(chart->flag & PCHART_HAS_PINS)) {
-        p_chart_rotate_minimum_area(chart);
-      }
+  param_assert(phandle->state == PHANDLE_STATE_LSCM);
 
-      if (!result || (chart->u.lscm.pin1)) {
-        p_chart_lscm_end(chart);
-      }
-    }
-  }
+  p_lscm_charts_parallel(phandle, &data, p_lscm_solve_task_cb);
 }
 
 void param_lscm_end(ParamHandle *handle)
@@ -4722,7 +4773,7 @@ static void param_pack_rotate(ParamHandle *handle, bool ignore_pinned)
   }
 }
 
-void param_pack(ParamHandle *handle, float margin, bool do_rotate, bool ignore_pinned)
+static void p_pack_boxes(PHandle *phandle, float margin, bool ignore_pinned)
 {
   /* box packing variables */
   BoxPack *boxarray, *box;
@@ -4733,21 +4784,6 @@ void param_pack(ParamHandle *handle, float margin, bool do_rotate, bool ignore_p
   float trans[2];
   double area = 0.0;
 
-  PHandle *phandle = (PHandle *)handle;
-
-  if (phandle->ncharts == 0) {
-    return;
-  }
-
-  /* this could be its own function */
-  if (do_rotate) {
-    param_pack_rotate(handle, ignore_pinned);
-  }
-
-  if (phandle->aspx != phandle->aspy) {
-    param_scale(handle, 1.0f / phandle->aspx, 1.0f / phandle->aspy);
-  }
-
   /* we may not use all these boxes */
   boxarray = MEM_mallocN(phandle->ncharts * sizeof(BoxPack), "BoxPack box");
 
@@ -4820,6 +4856,115 @@ void param_pack(ParamHandle *handle, float margin, bool do_rotate, bool ignore_p
     p_chart_uv_scale(chart, scale);
   }
   MEM_freeN(boxarray);
+}
+
+static void p_pack_shapes(PHandle *phandle, float margin, bool do_rotate, bool ignore_pinned)
+{
+  RasterPackIsland *islands;
+  RasterPackParams params;
+  float(*tris)[3][2];
+  float tot_width, tot_height, scale;
+
+  PChart *chart;
+  PFace *f;
+  int i, islands_len = 0, tris_len = 0;
+  float minv[2], maxv[2];
+  double area = 0.0;
+
+  for (i = 0; i < phandle->ncharts; i++) {
+    tris_len += phandle->charts[i]->nfaces;
+  }
+
+  islands = MEM_mallocN(sizeof(*islands) * phandle->ncharts, "RasterPackIsland");
+  tris = MEM_mallocN(sizeof(*tris) * MAX2(tris_len, 1), "RasterPackIsland tris");
+  tris_len = 0;
+
+  for (i = 0; i < phandle->ncharts; i++) {
+    chart = phandle->charts[i];
+
+    if (ignore_pinned && (chart->flag & PCHART_HAS_PINS)) {
+      continue;
+    }
+
+    islands[islands_len].tris = &tris[tris_len];
+    islands[islands_len].tris_len = (uint)chart->nfaces;
+    islands_len++;
+
+    for (f = chart->faces; f; f = f->nextlink) {
+      PEdge *e1 = f->edge, *e2 = e1->next, *e3 = e2->next;
+      copy_v2_v2(tris[tris_len][0], e1->vert->uv);
+      copy_v2_v2(tris[tris_len][1], e2->vert->uv);
+      copy_v2_v2(tris[tris_len][2], e3->vert->uv);
+      tris_len++;
+    }
+
+    if (margin > 0.0f) {
+      p_chart_uv_bbox(chart, minv, maxv);
+      area += (double)sqrtf((maxv[0] - minv[0]) * (maxv[1] - minv[1]));
+    }
+  }
+
+  BLI_raster_pack_2d_params_defaults(&params);
+  /* Same spacing as the box packer, which adds the margin on every side of a chart. */
+  params.margin = (margin * (float)area) * 0.1f * 2.0f;
+  /* Charts are already rotated to fit their bounds best, keep them axis aligned. */
+  params.rotations = do_rotate ? 4 : 1;
+  /* Keep some detail for every chart when there are many of them. */
+  params.resolution = max_ii(params.resolution, (int)sqrtf((float)islands_len) * 8);
+  params.time_limit = 10.0;
+
+  BLI_raster_pack_2d(islands, (uint)islands_len, &params, &tot_width, &tot_height);
+
+  scale = 1.0f / max_ff(max_ff(tot_width, tot_height), FLT_EPSILON);
+  islands_len = 0;
+
+  for (i = 0; i < phandle->ncharts; i++) {
+    RasterPackIsland *island;
+    float mat[2][2];
+
+    chart = phandle->charts[i];
+
+    if (ignore_pinned && (chart->flag & PCHART_HAS_PINS)) {
+      continue;
+    }
+
+    island = &islands[islands_len++];
+    if (island->angle != 0.0f) {
+      angle_to_mat2(mat, island->angle);
+      p_chart_uv_transform(chart, mat);
+    }
+    p_chart_uv_translate(chart, island->offset);
+    p_chart_uv_scale(chart, scale);
+  }
+
+  MEM_freeN(tris);
+  MEM_freeN(islands);
+}
+
+void param_pack(
+    ParamHandle *handle, float margin, bool do_rotate, bool ignore_pinned, bool use_shape)
+{
+  PHandle *phandle = (PHandle *)handle;
+
+  if (phandle->ncharts == 0) {
+    return;
+  }
+
+  /* this could be its own function */
+  if (do_rotate) {
+    param_pack_rotate(handle, ignore_pinned);
+  }
+
+  if (phandle->aspx != phandle->aspy) {
+    param_scale(handle, 1.0f / phandle->aspx, 1.0f / phandle->aspy);
+  }
+
+  if (use_shape) {
+    p_pack_shapes(phandle, margin, do_rotate, ignore_pinned);
+  }
+  else {
+    p_pack_boxes(phandle, margin, ignore_pinned);
+  }
 
   if (phandle->aspx != phandle->aspy) {
     param_scale(handle, phandle->aspx, phandle->aspy);
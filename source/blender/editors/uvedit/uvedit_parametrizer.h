@@ -63,9 +63,13 @@ void param_edge_set_seam(ParamHandle *handle, ParamKey *vkeys);
 void param_construct_end(ParamHandle *handle, ParamBool fill, ParamBool impl);
 void param_delete(ParamHandle *chart);
 
+/* Number of charts after construction. */
+int param_chart_count(ParamHandle *handle);
+
 /* Least Squares Conformal Maps:
  * -----------------------------
  * - charts with less than two pinned vertices are assigned 2 pins
+ * - charts are solved in parallel, results don't depend on the number of threads
  * - lscm is divided in three steps:
  * - begin: compute matrix and it's factorization (expensive)
  * - solve using pinned coordinates (cheap)
@@ -89,9 +93,13 @@ void param_stretch_end(ParamHandle *handle);
 
 void param_smooth_area(ParamHandle *handle);
 
-/* Packing */
+/* Packing
+ * - use_shape packs the shapes of charts rather than their bounding boxes,
+ *   using less space but taking longer
+ */
 
-void param_pack(ParamHandle *handle, float margin, bool do_rotate, bool ignore_pinned);
+void param_pack(
+    ParamHandle *handle, float margin, bool do_rotate, bool ignore_pinned, bool use_shape);
 
 /* Average area for all charts */
 
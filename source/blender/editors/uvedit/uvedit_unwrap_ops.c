@@ -924,7 +924,7 @@ static void uvedit_pack_islands(const Scene *scene, Object *ob, BMesh *bm)
 
   ParamHandle *handle;
   handle = construct_param_handle(scene, ob, bm, &options);
-  param_pack(handle, scene->toolsettings->uvcalc_margin, rotate, ignore_pinned);
+  param_pack(handle, scene->toolsettings->uvcalc_margin, rotate, ignore_pinned, false);
   param_flush(handle);
   param_delete(handle);
 }
@@ -934,11 +934,12 @@ static void uvedit_pack_islands_multi(const Scene *scene,
                                       const uint objects_len,
                                       const UnwrapOptions *options,
                                       bool rotate,
-                                      bool ignore_pinned)
+                                      bool ignore_pinned,
+                                      bool use_shape)
 {
   ParamHandle *handle;
   handle = construct_param_handle_multi(scene, objects, objects_len, options);
-  param_pack(handle, scene->toolsettings->uvcalc_margin, rotate, ignore_pinned);
+  param_pack(handle, scene->toolsettings->uvcalc_margin, rotate, ignore_pinned, use_shape);
   param_flush(handle);
   param_delete(handle);
 
@@ -962,6 +963,7 @@ static int pack_islands_exec(bContext *C, wmOperator *op)
   };
 
   bool rotate = RNA_boolean_get(op->ptr, "rotate");
+  bool use_shape = RNA_boolean_get(op->ptr, "use_shape");
   bool ignore_pinned = false;
 
   uint objects_len = 0;
@@ -980,7 +982,8 @@ static int pack_islands_exec(bContext *C, wmOperator *op)
     RNA_float_set(op->ptr, "margin", scene->toolsettings->uvcalc_margin);
   }
 
-  uvedit_pack_islands_multi(scene, objects, objects_len, &options, rotate, ignore_pinned);
+  uvedit_pack_islands_multi(
+      scene, objects, objects_len, &options, rotate, ignore_pinned, use_shape);
 
   MEM_freeN(objects);
 
@@ -1004,6 +1007,12 @@ void UV_OT_pack_islands(wmOperatorType *ot)
   RNA_def_boolean(ot->srna, "rotate", true, "Rotate", "Rotate islands for best fit");
   RNA_def_float_factor(
       ot->srna, "margin", 0.001f, 0.0f, 1.0f, "Margin", "Space between islands", 0.0f, 1.0f);
+  RNA_def_boolean(ot->srna,
+                  "use_shape",
+                  false,
+                  "Pack Shapes",
+                  "Pack the shapes of islands rather than their bounding boxes, "
+                  "using less space but taking longer");
 }
 
 /* ******************** Average Islands Scale operator **************** */
@@ -1545,7 +1554,10 @@ static void uv_map_clip_correct(const Scene *scene, Object *ob, wmOperator *op)
 /* ******************** Unwrap operator **************** */
 
 /* Assumes UV Map exists, doesn't run update funcs. */
-static void uvedit_unwrap(const Scene *scene, Object *obedit, const UnwrapOptions *options)
+static void uvedit_unwrap(const Scene *scene,
+                          Object *obedit,
+                          const UnwrapOptions *options,
+                          int *r_count_charts)
 {
   BMEditMesh *em = BKE_editmesh_from_object(obedit);
   if (!CustomData_has_layer(&em->bm->ldata, CD_MLOOPUV)) {
@@ -1567,6 +1579,10 @@ static void uvedit_unwrap(const Scene *scene, Object *obedit, const UnwrapOption
   param_lscm_solve(handle);
   param_lscm_end(handle);
 
+  if (r_count_charts) {
+    *r_count_charts += param_chart_count(handle);
+  }
+
   param_average(handle, true);
 
   param_flush(handle);
@@ -1577,11 +1593,12 @@ static void uvedit_unwrap(const Scene *scene, Object *obedit, const UnwrapOption
 static void uvedit_unwrap_multi(const Scene *scene,
                                 Object **objects,
                                 const int objects_len,
-                                const UnwrapOptions *options)
+                                const UnwrapOptions *options,
+                                int *r_count_charts)
 {
   for (uint ob_index = 0; ob_index < objects_len; ob_index++) {
     Object *obedit = objects[ob_index];
-    uvedit_unwrap(scene, obedit, options);
+    uvedit_unwrap(scene, obedit, options, r_count_charts);
     DEG_id_tag_update(obedit->data, ID_RECALC_GEOMETRY);
     WM_main_add_notifier(NC_GEOM | ND_DATA, obedit->data);
   }
@@ -1600,8 +1617,9 @@ void ED_uvedit_live_unwrap(const Scene *scene, Object **objects, int objects_len
     bool rotate = true;
     bool ignore_pinned = true;
 
-    uvedit_unwrap_multi(scene, objects, objects_len, &options);
-    uvedit_pack_islands_multi(scene, objects, objects_len, &options, rotate, ignore_pinned);
+    uvedit_unwrap_multi(scene, objects, objects_len, &options, NULL);
+    uvedit_pack_islands_multi(
+        scene, objects, objects_len, &options, rotate, ignore_pinned, false);
   }
 }
 
@@ -1728,8 +1746,18 @@ static int unwrap_exec(bContext *C, wmOperator *op)
   }
 
   /* execute unwrap */
-  uvedit_unwrap_multi(scene, objects, objects_len, &options);
-  uvedit_pack_islands_multi(scene, objects, objects_len, &options, rotate, ignore_pinned);
+  const double time_start = PIL_check_seconds_timer();
+  int count_charts = 0;
+
+  uvedit_unwrap_multi(scene, objects, objects_len, &options, &count_charts);
+  uvedit_pack_islands_multi(
+      scene, objects, objects_len, &options, rotate, ignore_pinned, false);
+
+  BKE_reportf(op->reports,
+              RPT_INFO,
+              "Unwrapped %d island(s) in %.3f seconds",
+              count_charts,
+              PIL_check_seconds_timer() - time_start);
 
   MEM_freeN(objects);
 
@@ -171,7 +171,10 @@ typedef struct ClothSimSettings {
   float internal_compression;
   float max_internal_tension;
   float max_internal_compression;
-  char _pad0[4];
+  /** Linear solver used by the implicit integrator, see CLOTH_LINEAR_SOLVER. */
+  short linear_solver;
+  /** Preconditioner for the block CSR solver, see CLOTH_PRECONDITIONER. */
+  short preconditioner;
 
 } ClothSimSettings;
 
@@ -130,6 +130,9 @@ typedef enum {
   eModifierFlag_OverrideLibrary_Local = (1 << 0),
   /* This modifier does not own its caches, but instead shares them with another modifier. */
   eModifierFlag_SharedCaches = (1 << 1),
+  /* Keep a copy of the result of this modifier, so edits further down the stack can start from
+   * it instead of re-evaluating the modifiers before it. */
+  eModifierFlag_CacheResult = (1 << 2),
 } ModifierFlag;
 
 /* not a real modifier */
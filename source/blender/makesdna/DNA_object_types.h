@@ -183,6 +183,9 @@ typedef struct Object_Runtime {
   /** Runtime grease pencil evaluated data created by modifiers */
   struct bGPDframe *gpencil_evaluated_frames;
 
+  /** Cached intermediate results of the modifier stack, see #eModifierFlag_CacheResult. */
+  struct ModifierStackCache *modifier_stack_cache;
+
   unsigned short local_collections_bits;
   short _pad2[3];
 } Object_Runtime;
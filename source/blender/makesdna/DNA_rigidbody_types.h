@@ -63,7 +63,10 @@ typedef struct RigidBodyWorld {
   /** Group containing objects to use for Rigid Body Constraint.s*/
   struct Collection *constraints;
 
-  char _pad[4];
+  /** Number of threads used to step the simulation, 0 for automatic. */
+  short num_threads;
+  /** (eRigidBodyWorld_ThreadingMode) how the simulation is distributed over threads. */
+  short threading_mode;
   /** Last frame world was evaluated for (internal). */
   float ltime;
 
@@ -97,6 +100,16 @@ typedef enum eRigidBodyWorld_Flag {
   RBW_FLAG_USE_SPLIT_IMPULSE = (1 << 2),
 } eRigidBodyWorld_Flag;
 
+/* Threading modes for RigidBodyWorld */
+typedef enum eRigidBodyWorld_ThreadingMode {
+  /* step the simulation on a single thread */
+  RBW_THREADING_SINGLE = 0,
+  /* solve islands in parallel, with results independent of the number of threads */
+  RBW_THREADING_DETERMINISTIC = 1,
+  /* solve islands in parallel, balancing load at the cost of reproducibility */
+  RBW_THREADING_FAST = 2,
+} eRigidBodyWorld_ThreadingMode;
+
 /* ******************************** */
 /* RigidBody Object */
 
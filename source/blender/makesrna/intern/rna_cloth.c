@@ -527,6 +527,20 @@ static void rna_def_cloth_solver_result(BlenderRNA *brna)
   RNA_def_property_clear_flag(prop, PROP_EDITABLE);
   RNA_def_property_ui_text(prop, "Average Error", "Average error during substeps");
 
+  prop = RNA_def_property(srna, "max_collision_time", PROP_FLOAT, PROP_NONE);
+  RNA_def_property_float_sdna(prop, NULL, "max_collision_time");
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(prop,
+                           "Maximum Collision Time",
+                           "Maximum time in seconds spent on collisions during substeps");
+
+  prop = RNA_def_property(srna, "avg_collision_time", PROP_FLOAT, PROP_NONE);
+  RNA_def_property_float_sdna(prop, NULL, "avg_collision_time");
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(prop,
+                           "Average Collision Time",
+                           "Average time in seconds spent on collisions during substeps");
+
   prop = RNA_def_property(srna, "max_iterations", PROP_INT, PROP_NONE);
   RNA_def_property_int_sdna(prop, NULL, "max_iterations");
   RNA_def_property_clear_flag(prop, PROP_EDITABLE);
@@ -560,6 +574,35 @@ static void rna_def_cloth_sim_settings(BlenderRNA *brna)
       {0, NULL, 0, NULL, NULL},
   };
 
+  static const EnumPropertyItem prop_linear_solver_items[] = {
+      {CLOTH_LINEAR_SOLVER_CG,
+       "CG",
+       0,
+       "Conjugate Gradient",
+       "Single threaded conjugate gradient solver (legacy)"},
+      {CLOTH_LINEAR_SOLVER_BLOCK_CSR,
+       "BLOCK_CSR",
+       0,
+       "Parallel Block CSR",
+       "Multi-threaded preconditioned conjugate gradient solver, faster for dense meshes"},
+      {0, NULL, 0, NULL, NULL},
+  };
+
+  static const EnumPropertyItem prop_preconditioner_items[] = {
+      {CLOTH_PRECONDITIONER_NONE, "NONE", 0, "None", "No preconditioning"},
+      {CLOTH_PRECONDITIONER_JACOBI,
+       "JACOBI",
+       0,
+       "Jacobi",
+       "Scale by the inverse of the matrix diagonal"},
+      {CLOTH_PRECONDITIONER_BLOCK_JACOBI,
+       "BLOCK_JACOBI",
+       0,
+       "Block Jacobi",
+       "Multiply by the inverse of the 3x3 diagonal block of each vertex"},
+      {0, NULL, 0, NULL, NULL},
+  };
+
   srna = RNA_def_struct(brna, "ClothSettings", NULL);
   RNA_def_struct_ui_text(srna, "Cloth Settings", "Cloth simulation settings for an object");
   RNA_def_struct_sdna(srna, "ClothSimSettings");
@@ -874,6 +917,24 @@ static void rna_def_cloth_sim_settings(BlenderRNA *brna)
   RNA_def_property_update(prop, 0, "rna_cloth_update");
   RNA_def_property_clear_flag(prop, PROP_ANIMATABLE);
 
+  prop = RNA_def_property(srna, "linear_solver", PROP_ENUM, PROP_NONE);
+  RNA_def_property_enum_sdna(prop, NULL, "linear_solver");
+  RNA_def_property_enum_items(prop, prop_linear_solver_items);
+  RNA_def_property_ui_text(
+      prop, "Solver", "Linear solver used for the implicit integration of each step");
+  RNA_def_property_update(prop, 0, "rna_cloth_update");
+  RNA_def_property_clear_flag(prop, PROP_ANIMATABLE);
+
+  prop = RNA_def_property(srna, "preconditioner", PROP_ENUM, PROP_NONE);
+  RNA_def_property_enum_sdna(prop, NULL, "preconditioner");
+  RNA_def_property_enum_items(prop, prop_preconditioner_items);
+  RNA_def_property_ui_text(prop,
+                           "Preconditioner",
+                           "Preconditioner of the parallel solver, reduces the number of "
+                           "iterations for stiff cloth");
+  RNA_def_property_update(prop, 0, "rna_cloth_update");
+  RNA_def_property_clear_flag(prop, PROP_ANIMATABLE);
+
   prop = RNA_def_property(srna, "use_internal_springs", PROP_BOOLEAN, PROP_NONE);
   RNA_def_property_boolean_sdna(prop, NULL, "flags", CLOTH_SIMSETTINGS_FLAG_INTERNAL_SPRINGS);
   RNA_def_property_ui_text(prop,
@@ -1119,6 +1180,14 @@ static void rna_def_cloth_collision_settings(BlenderRNA *brna)
   RNA_def_property_ui_text(prop, "Enable Self Collision", "Enable self collisions");
   RNA_def_property_update(prop, 0, "rna_cloth_update");
 
+  prop = RNA_def_property(srna, "use_self_collision_continuous", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flags", CLOTH_COLLSETTINGS_FLAG_SELF_CONTINUOUS);
+  RNA_def_property_ui_text(prop,
+                           "Continuous",
+                           "Find self collisions from the motion over the whole step instead of "
+                           "only the end positions, for fast moving layered cloth");
+  RNA_def_property_update(prop, 0, "rna_cloth_update");
+
   prop = RNA_def_property(srna, "self_distance_min", PROP_FLOAT, PROP_DISTANCE);
   RNA_def_property_float_sdna(prop, NULL, "selfepsilon");
   RNA_def_property_range(prop, 0.001f, 0.1f);
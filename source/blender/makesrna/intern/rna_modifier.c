@@ -6445,6 +6445,14 @@ void RNA_def_modifier(BlenderRNA *brna)
   RNA_def_property_ui_icon(prop, ICON_SURFACE_DATA, 0);
   RNA_def_property_update(prop, 0, "rna_Modifier_update");
 
+  prop = RNA_def_property(srna, "use_cache_result", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flag", eModifierFlag_CacheResult);
+  RNA_def_property_ui_text(prop,
+                           "Cache Result",
+                           "Keep a copy of the result of this modifier, so changes to modifiers "
+                           "further down the stack do not re-evaluate it (uses extra memory)");
+  RNA_def_property_update(prop, 0, "rna_Modifier_update");
+
   /* types */
   rna_def_modifier_subsurf(brna);
   rna_def_modifier_lattice(brna);
@@ -134,6 +134,24 @@ static const EnumPropertyItem rigidbody_mesh_source_items[] = {
     {RBO_MESH_FINAL, "FINAL", 0, "Final", "All modifiers"},
     {0, NULL, 0, NULL, NULL},
 };
+
+/* threading mode for stepping the simulation */
+static const EnumPropertyItem rigidbody_world_threading_mode_items[] = {
+    {RBW_THREADING_SINGLE, "SINGLE", 0, "Single", "Step the simulation on a single thread"},
+    {RBW_THREADING_DETERMINISTIC,
+     "DETERMINISTIC",
+     0,
+     "Deterministic",
+     "Solve simulation islands on multiple threads, with results that do not depend on the "
+     "number of threads so bakes are reproducible"},
+    {RBW_THREADING_FAST,
+     "FAST",
+     0,
+     "Fast",
+     "Solve simulation islands on multiple threads with better load balancing, results may "
+     "differ slightly between runs"},
+    {0, NULL, 0, NULL, NULL},
+};
 #endif
 
 #ifdef RNA_RUNTIME
@@ -925,6 +943,22 @@ static void rna_def_rigidbody_world(BlenderRNA *brna)
       "stability a little so use only when necessary)");
   RNA_def_property_update(prop, NC_SCENE, "rna_RigidBodyWorld_reset");
 
+  /* threading */
+  prop = RNA_def_property(srna, "threading_mode", PROP_ENUM, PROP_NONE);
+  RNA_def_property_enum_sdna(prop, NULL, "threading_mode");
+  RNA_def_property_enum_items(prop, rigidbody_world_threading_mode_items);
+  RNA_def_property_ui_text(
+      prop, "Threading", "How the simulation is distributed over multiple threads");
+  RNA_def_property_update(prop, NC_SCENE, "rna_RigidBodyWorld_reset");
+
+  prop = RNA_def_property(srna, "threads", PROP_INT, PROP_NONE);
+  RNA_def_property_int_sdna(prop, NULL, "num_threads");
+  RNA_def_property_range(prop, 0, 1024);
+  RNA_def_property_ui_range(prop, 0, 64, 1, -1);
+  RNA_def_property_ui_text(
+      prop, "Threads", "Number of threads to step the simulation with (0 for automatic)");
+  RNA_def_property_update(prop, NC_SCENE, "rna_RigidBodyWorld_reset");
+
   /* cache */
   prop = RNA_def_property(srna, "point_cache", PROP_POINTER, PROP_NONE);
   RNA_def_property_flag(prop, PROP_NEVER_NULL);
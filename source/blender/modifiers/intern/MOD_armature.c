@@ -152,6 +152,36 @@ static void deformVerts(ModifierData *md,
   }
 }
 
+static void deform_block_armature(void *userdata, float (*vertexCos)[3], int start, int end)
+{
+  armature_deform_verts_range(userdata, vertexCos, start, end);
+}
+
+static void deform_block_armature_free(void *userdata)
+{
+  armature_deform_verts_free(userdata);
+}
+
+static bool deformVertsBlockPrepare(ModifierData *md,
+                                    const ModifierEvalContext *ctx,
+                                    Mesh *mesh,
+                                    int UNUSED(numVerts),
+                                    ModifierDeformBlock *r_block)
+{
+  ArmatureModifierData *amd = (ArmatureModifierData *)md;
+
+  /* Multi modifier blending works on the coordinates of all vertices at once. */
+  if (amd->prevCos || MOD_previous_vcos_needed(md)) {
+    return false;
+  }
+
+  r_block->userdata = armature_deform_verts_prepare(
+      amd->object, ctx->object, mesh, amd->deformflag, amd->defgrp_name);
+  r_block->deform = r_block->userdata ? deform_block_armature : NULL;
+  r_block->free = deform_block_armature_free;
+  return true;
+}
+
 static void deformVertsEM(ModifierData *md,
                           const ModifierEvalContext *ctx,
                           struct BMEditMesh *em,
@@ -253,6 +283,7 @@ ModifierTypeInfo modifierType_Armature = {
     /* deformMatrices */ deformMatrices,
     /* deformVertsEM */ deformVertsEM,
     /* deformMatricesEM */ deformMatricesEM,
+    /* deformVertsBlockPrepare */ deformVertsBlockPrepare,
     /* applyModifier */ NULL,
 
     /* initData */ initData,
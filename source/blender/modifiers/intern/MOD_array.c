@@ -23,11 +23,15 @@
  * Array modifier: duplicates the object multiple times along an axis.
  */
 
+#include <stdio.h>
+
 #include "MEM_guardedalloc.h"
 
 #include "BLI_utildefines.h"
 
 #include "BLI_math.h"
+#include "BLI_spatial_hash.h"
+#include "BLI_task.h"
 
 #include "DNA_curve_types.h"
 #include "DNA_mesh_types.h"
@@ -37,6 +41,7 @@
 
 #include "BKE_displist.h"
 #include "BKE_curve.h"
+#include "BKE_global.h" /* only to check G.debug */
 #include "BKE_lib_id.h"
 #include "BKE_lib_query.h"
 #include "BKE_modifier.h"
@@ -48,6 +53,8 @@
 #include "DEG_depsgraph.h"
 #include "DEG_depsgraph_query.h"
 
+#include "PIL_time.h"
+
 static void initData(ModifierData *md)
 {
   ArrayModifierData *amd = (ArrayModifierData *)md;
@@ -105,46 +112,12 @@ static void updateDepsgraph(ModifierData *md, const ModifierUpdateDepsgraphConte
   }
 }
 
-BLI_INLINE float sum_v3(const float v[3])
-{
-  return v[0] + v[1] + v[2];
-}
-
-/* Structure used for sorting vertices, when processing doubles */
-typedef struct SortVertsElem {
-  int vertex_num; /* The original index of the vertex, prior to sorting */
-  float co[3];    /* Its coordinates */
-  float sum_co;   /* sum_v3(co), just so we don't do the sum many times.  */
-} SortVertsElem;
-
-static int svert_sum_cmp(const void *e1, const void *e2)
-{
-  const SortVertsElem *sv1 = e1;
-  const SortVertsElem *sv2 = e2;
-
-  if (sv1->sum_co > sv2->sum_co) {
-    return 1;
-  }
-  else if (sv1->sum_co < sv2->sum_co) {
-    return -1;
-  }
-  else {
-    return 0;
-  }
-}
-
-static void svert_from_mvert(SortVertsElem *sv,
-                             const MVert *mv,
-                             const int i_begin,
-                             const int i_end)
-{
-  int i;
-  for (i = i_begin; i < i_end; i++, sv++, mv++) {
-    sv->vertex_num = i;
-    copy_v3_v3(sv->co, mv->co);
-    sv->sum_co = sum_v3(mv->co);
-  }
-}
+/* -------------------------------------------------------------------- */
+/** \name Merge Doubles
+ *
+ * Target vertices are put in a spatial hash (see #BLI_spatial_hash_3d_find_nearest),
+ * so each source vertex only has to be compared with the targets in the neighboring cells.
+ * \{ */
 
 /**
  * Take as inputs two sets of verts, to be processed for detection of doubles and mapping.
@@ -161,112 +134,51 @@ static void dm_mvert_map_doubles(int *doubles_map,
                                  const int source_num_verts,
                                  const float dist)
 {
-  const float dist3 = ((float)M_SQRT3 + 0.00005f) * dist; /* Just above sqrt(3) */
-  int i_source, i_target, i_target_low_bound, target_end, source_end;
-  SortVertsElem *sorted_verts_target, *sorted_verts_source;
-  SortVertsElem *sve_source, *sve_target, *sve_target_low_bound;
-  bool target_scan_completed;
-
-  target_end = target_start + target_num_verts;
-  source_end = source_start + source_num_verts;
-
-  /* build array of MVerts to be tested for merging */
-  sorted_verts_target = MEM_malloc_arrayN(target_num_verts, sizeof(SortVertsElem), __func__);
-  sorted_verts_source = MEM_malloc_arrayN(source_num_verts, sizeof(SortVertsElem), __func__);
-
-  /* Copy target vertices index and cos into SortVertsElem array */
-  svert_from_mvert(sorted_verts_target, mverts + target_start, target_start, target_end);
-
-  /* Copy source vertices index and cos into SortVertsElem array */
-  svert_from_mvert(sorted_verts_source, mverts + source_start, source_start, source_end);
-
-  /* sort arrays according to sum of vertex coordinates (sumco) */
-  qsort(sorted_verts_target, target_num_verts, sizeof(SortVertsElem), svert_sum_cmp);
-  qsort(sorted_verts_source, source_num_verts, sizeof(SortVertsElem), svert_sum_cmp);
-
-  sve_target_low_bound = sorted_verts_target;
-  i_target_low_bound = 0;
-  target_scan_completed = false;
-
-  /* Scan source vertices, in SortVertsElem sorted array, */
-  /* all the while maintaining the lower bound of possible doubles in target vertices */
-  for (i_source = 0, sve_source = sorted_verts_source; i_source < source_num_verts;
-       i_source++, sve_source++) {
-    int best_target_vertex = -1;
-    float best_dist_sq = dist * dist;
-    float sve_source_sumco;
-
-    /* If source has already been assigned to a target (in an earlier call, with other chunks) */
-    if (doubles_map[sve_source->vertex_num] != -1) {
-      continue;
-    }
+  int *nearest;
 
-    /* If target fully scanned already, then all remaining source vertices cannot have a double */
-    if (target_scan_completed) {
-      doubles_map[sve_source->vertex_num] = -1;
-      continue;
-    }
+  if (target_num_verts == 0 || source_num_verts == 0) {
+    return;
+  }
 
-    sve_source_sumco = sum_v3(sve_source->co);
+  /* The nearest targets don't depend on the map, so they are found for all vertices at once. */
+  nearest = MEM_malloc_arrayN(source_num_verts, sizeof(*nearest), __func__);
+  BLI_spatial_hash_3d_find_nearest(mverts[target_start].co,
+                                   sizeof(*mverts),
+                                   (uint)target_num_verts,
+                                   mverts[source_start].co,
+                                   sizeof(*mverts),
+                                   (uint)source_num_verts,
+                                   dist,
+                                   nearest);
 
-    /* Skip all target vertices that are more than dist3 lower in terms of sumco */
-    /* and advance the overall lower bound, applicable to all remaining vertices as well. */
-    while ((i_target_low_bound < target_num_verts) &&
-           (sve_target_low_bound->sum_co < sve_source_sumco - dist3)) {
-      i_target_low_bound++;
-      sve_target_low_bound++;
-    }
-    /* If end of target list reached, then no more possible doubles */
-    if (i_target_low_bound >= target_num_verts) {
-      doubles_map[sve_source->vertex_num] = -1;
-      target_scan_completed = true;
+  for (int i = 0; i < source_num_verts; i++) {
+    const int v_index = source_start + i;
+    int best_target_vertex = (nearest[i] != -1) ? target_start + nearest[i] : -1;
+
+    if (doubles_map[v_index] != -1) {
       continue;
     }
-    /* Test target candidates starting at the low bound of possible doubles,
-     * ordered in terms of sumco. */
-    i_target = i_target_low_bound;
-    sve_target = sve_target_low_bound;
-
-    /* i_target will scan vertices in the
-     * [v_source_sumco - dist3;  v_source_sumco + dist3] range */
-
-    while ((i_target < target_num_verts) && (sve_target->sum_co <= sve_source_sumco + dist3)) {
-      /* Testing distance for candidate double in target */
-      /* v_target is within dist3 of v_source in terms of sumco;  check real distance */
-      float dist_sq;
-      if ((dist_sq = len_squared_v3v3(sve_source->co, sve_target->co)) <= best_dist_sq) {
-        /* Potential double found */
-        best_dist_sq = dist_sq;
-        best_target_vertex = sve_target->vertex_num;
-
-        /* If target is already mapped, we only follow that mapping if final target remains
-         * close enough from current vert (otherwise no mapping at all).
-         * Note that if we later find another target closer than this one, then we check it.
-         * But if other potential targets are farther,
-         * then there will be no mapping at all for this source. */
-        while (best_target_vertex != -1 &&
-               !ELEM(doubles_map[best_target_vertex], -1, best_target_vertex)) {
-          if (compare_len_v3v3(mverts[sve_source->vertex_num].co,
-                               mverts[doubles_map[best_target_vertex]].co,
-                               dist)) {
-            best_target_vertex = doubles_map[best_target_vertex];
-          }
-          else {
-            best_target_vertex = -1;
-          }
-        }
+
+    /* If target is already mapped, we only follow that mapping if final target remains
+     * close enough from current vert (otherwise no mapping at all). */
+    while (best_target_vertex != -1 &&
+           !ELEM(doubles_map[best_target_vertex], -1, best_target_vertex)) {
+      if (compare_len_v3v3(
+              mverts[v_index].co, mverts[doubles_map[best_target_vertex]].co, dist)) {
+        best_target_vertex = doubles_map[best_target_vertex];
+      }
+      else {
+        best_target_vertex = -1;
       }
-      i_target++;
-      sve_target++;
     }
-    /* End of candidate scan: if none found then no doubles */
-    doubles_map[sve_source->vertex_num] = best_target_vertex;
+    doubles_map[v_index] = best_target_vertex;
   }
 
-  MEM_freeN(sorted_verts_source);
-  MEM_freeN(sorted_verts_target);
+  MEM_freeN(nearest);
 }
 
+/** \} */
+
 static void mesh_merge_transform(Mesh *result,
                                  Mesh *cap_mesh,
                                  const float cap_offset[4][4],
@@ -349,25 +261,131 @@ static void mesh_merge_transform(Mesh *result,
   }
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Copy Chunks
+ *
+ * All offsets are known up-front, so each copy of the mesh writes its own range of the result
+ * and the copies can be made in parallel.
+ * \{ */
+
+typedef struct ArrayChunkData {
+  const Mesh *mesh;
+  Mesh *result;
+  /* Cumulative offset of each copy. */
+  const float (*chunk_offsets)[4][4];
+  const float *uv_offset;
+  int chunk_nverts, chunk_nedges, chunk_nloops, chunk_npolys;
+  bool use_recalc_normals;
+} ArrayChunkData;
+
+static void array_chunk_copy_cb(void *__restrict userdata,
+                                const int c,
+                                const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const ArrayChunkData *data = userdata;
+  const Mesh *mesh = data->mesh;
+  Mesh *result = data->result;
+  const int chunk_nverts = data->chunk_nverts;
+  const int chunk_nedges = data->chunk_nedges;
+  const int chunk_nloops = data->chunk_nloops;
+  const int chunk_npolys = data->chunk_npolys;
+  const float(*current_offset)[4] = data->chunk_offsets[c];
+  MVert *mv;
+  MEdge *me;
+  MLoop *ml;
+  MPoly *mp;
+  int i;
+
+  /* copy customdata to new geometry */
+  CustomData_copy_data(&mesh->vdata, &result->vdata, 0, c * chunk_nverts, chunk_nverts);
+  CustomData_copy_data(&mesh->edata, &result->edata, 0, c * chunk_nedges, chunk_nedges);
+  CustomData_copy_data(&mesh->ldata, &result->ldata, 0, c * chunk_nloops, chunk_nloops);
+  CustomData_copy_data(&mesh->pdata, &result->pdata, 0, c * chunk_npolys, chunk_npolys);
+
+  /* apply offset to all new verts */
+  mv = result->mvert + c * chunk_nverts;
+  for (i = 0; i < chunk_nverts; i++, mv++) {
+    mul_m4_v3(current_offset, mv->co);
+
+    /* We have to correct normals too, if we do not tag them as dirty! */
+    if (!data->use_recalc_normals) {
+      float no[3];
+      normal_short_to_float_v3(no, mv->no);
+      mul_mat3_m4_v3(current_offset, no);
+      normalize_v3(no);
+      normal_float_to_short_v3(mv->no, no);
+    }
+  }
+
+  /* adjust edge vertex indices */
+  me = result->medge + c * chunk_nedges;
+  for (i = 0; i < chunk_nedges; i++, me++) {
+    me->v1 += c * chunk_nverts;
+    me->v2 += c * chunk_nverts;
+  }
+
+  mp = result->mpoly + c * chunk_npolys;
+  for (i = 0; i < chunk_npolys; i++, mp++) {
+    mp->loopstart += c * chunk_nloops;
+  }
+
+  /* adjust loop vertex and edge indices */
+  ml = result->mloop + c * chunk_nloops;
+  for (i = 0; i < chunk_nloops; i++, ml++) {
+    ml->v += c * chunk_nverts;
+    ml->e += c * chunk_nedges;
+  }
+
+  /* handle UVs */
+  if (data->uv_offset != NULL) {
+    const int totuv = CustomData_number_of_layers(&result->ldata, CD_MLOOPUV);
+    const float uv_offset[2] = {
+        data->uv_offset[0] * (float)c,
+        data->uv_offset[1] * (float)c,
+    };
+    for (i = 0; i < totuv; i++) {
+      MLoopUV *dmloopuv = CustomData_get_layer_n(&result->ldata, CD_MLOOPUV, i);
+      dmloopuv += c * chunk_nloops;
+      for (int l_index = chunk_nloops; l_index-- != 0; dmloopuv++) {
+        dmloopuv->uv[0] += uv_offset[0];
+        dmloopuv->uv[1] += uv_offset[1];
+      }
+    }
+  }
+}
+
+/** \} */
+
+/* Size of the custom data of a mesh, which includes its vertices, edges, loops and polygons. */
+static size_t mesh_customdata_size(const Mesh *mesh)
+{
+  const CustomData *cdata[4] = {&mesh->vdata, &mesh->edata, &mesh->ldata, &mesh->pdata};
+  const int cdata_len[4] = {mesh->totvert, mesh->totedge, mesh->totloop, mesh->totpoly};
+  size_t size = 0;
+
+  for (int i = 0; i < ARRAY_SIZE(cdata); i++) {
+    for (int j = 0; j < cdata[i]->totlayer; j++) {
+      size += (size_t)CustomData_sizeof(cdata[i]->layers[j].type) * (size_t)cdata_len[i];
+    }
+  }
+  return size;
+}
+
 static Mesh *arrayModifier_doArray(ArrayModifierData *amd,
                                    const ModifierEvalContext *ctx,
                                    Mesh *mesh)
 {
   const float eps = 1e-6f;
   const MVert *src_mvert;
-  MVert *mv, *mv_prev, *result_dm_verts;
+  MVert *result_dm_verts;
 
-  MEdge *me;
-  MLoop *ml;
-  MPoly *mp;
   int i, j, c, count;
   float length = amd->length;
   /* offset matrix */
   float offset[4][4];
   float scale[3];
   bool offset_has_scale;
-  float current_offset[4][4];
-  float final_offset[4][4];
+  float(*chunk_offsets)[4][4];
   int *full_doubles_map = NULL;
   int tot_doubles;
 
@@ -388,6 +406,10 @@ static Mesh *arrayModifier_doArray(ArrayModifierData *amd,
   int *vgroup_end_cap_remap = NULL;
   int vgroup_end_cap_remap_len = 0;
 
+  const bool use_debug_report = (G.debug & G_DEBUG) != 0;
+  const double time_start = use_debug_report ? PIL_check_seconds_timer() : 0.0;
+  size_t mem_copies = 0;
+
   chunk_nverts = mesh->totvert;
   chunk_nedges = mesh->totedge;
   chunk_nloops = mesh->totloop;
@@ -533,118 +555,75 @@ static Mesh *arrayModifier_doArray(ArrayModifierData *amd,
   first_chunk_start = 0;
   first_chunk_nverts = chunk_nverts;
 
-  unit_m4(current_offset);
+  /* Cumulative offsets, in the same order as applying them one copy after another. */
+  chunk_offsets = MEM_malloc_arrayN(count, sizeof(*chunk_offsets), __func__);
+  unit_m4(chunk_offsets[0]);
   for (c = 1; c < count; c++) {
-    /* copy customdata to new geometry */
-    CustomData_copy_data(&mesh->vdata, &result->vdata, 0, c * chunk_nverts, chunk_nverts);
-    CustomData_copy_data(&mesh->edata, &result->edata, 0, c * chunk_nedges, chunk_nedges);
-    CustomData_copy_data(&mesh->ldata, &result->ldata, 0, c * chunk_nloops, chunk_nloops);
-    CustomData_copy_data(&mesh->pdata, &result->pdata, 0, c * chunk_npolys, chunk_npolys);
-
-    mv_prev = result_dm_verts;
-    mv = mv_prev + c * chunk_nverts;
-
-    /* recalculate cumulative offset here */
-    mul_m4_m4m4(current_offset, current_offset, offset);
-
-    /* apply offset to all new verts */
-    for (i = 0; i < chunk_nverts; i++, mv++, mv_prev++) {
-      mul_m4_v3(current_offset, mv->co);
-
-      /* We have to correct normals too, if we do not tag them as dirty! */
-      if (!use_recalc_normals) {
-        float no[3];
-        normal_short_to_float_v3(no, mv->no);
-        mul_mat3_m4_v3(current_offset, no);
-        normalize_v3(no);
-        normal_float_to_short_v3(mv->no, no);
-      }
-    }
-
-    /* adjust edge vertex indices */
-    me = result->medge + c * chunk_nedges;
-    for (i = 0; i < chunk_nedges; i++, me++) {
-      me->v1 += c * chunk_nverts;
-      me->v2 += c * chunk_nverts;
-    }
-
-    mp = result->mpoly + c * chunk_npolys;
-    for (i = 0; i < chunk_npolys; i++, mp++) {
-      mp->loopstart += c * chunk_nloops;
-    }
-
-    /* adjust loop vertex and edge indices */
-    ml = result->mloop + c * chunk_nloops;
-    for (i = 0; i < chunk_nloops; i++, ml++) {
-      ml->v += c * chunk_nverts;
-      ml->e += c * chunk_nedges;
-    }
-
-    /* Handle merge between chunk n and n-1 */
-    if (use_merge && (c >= 1)) {
-      if (!offset_has_scale && (c >= 2)) {
-        /* Mapping chunk 3 to chunk 2 is a translation of mapping 2 to 1
-         * ... that is except if scaling makes the distance grow */
-        int k;
-        int this_chunk_index = c * chunk_nverts;
-        int prev_chunk_index = (c - 1) * chunk_nverts;
-        for (k = 0; k < chunk_nverts; k++, this_chunk_index++, prev_chunk_index++) {
-          int target = full_doubles_map[prev_chunk_index];
-          if (target != -1) {
-            target += chunk_nverts; /* translate mapping */
-            while (target != -1 && !ELEM(full_doubles_map[target], -1, target)) {
-              /* If target is already mapped, we only follow that mapping if final target remains
-               * close enough from current vert (otherwise no mapping at all). */
-              if (compare_len_v3v3(result_dm_verts[this_chunk_index].co,
-                                   result_dm_verts[full_doubles_map[target]].co,
-                                   amd->merge_dist)) {
-                target = full_doubles_map[target];
-              }
-              else {
-                target = -1;
-              }
+    mul_m4_m4m4(chunk_offsets[c], chunk_offsets[c - 1], offset);
+  }
+
+  {
+    const bool use_uv_offset = (chunk_nloops > 0 && is_zero_v2(amd->uv_offset) == false);
+    ArrayChunkData data = {
+        .mesh = mesh,
+        .result = result,
+        .chunk_offsets = (const float(*)[4][4])chunk_offsets,
+        .uv_offset = use_uv_offset ? amd->uv_offset : NULL,
+        .chunk_nverts = chunk_nverts,
+        .chunk_nedges = chunk_nedges,
+        .chunk_nloops = chunk_nloops,
+        .chunk_npolys = chunk_npolys,
+        .use_recalc_normals = use_recalc_normals,
+    };
+    const int chunk_nelems = chunk_nverts + chunk_nedges + chunk_nloops + chunk_npolys;
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.min_iter_per_thread = max_ii(1, 4096 / max_ii(chunk_nelems, 1));
+    BLI_task_parallel_range(1, count, &data, array_chunk_copy_cb, &settings);
+  }
+
+  /* Handle merge between chunk n and n-1 */
+  for (c = 1; use_merge && c < count; c++) {
+    if (!offset_has_scale && (c >= 2)) {
+      /* Mapping chunk 3 to chunk 2 is a translation of mapping 2 to 1
+       * ... that is except if scaling makes the distance grow */
+      int k;
+      int this_chunk_index = c * chunk_nverts;
+      int prev_chunk_index = (c - 1) * chunk_nverts;
+      for (k = 0; k < chunk_nverts; k++, this_chunk_index++, prev_chunk_index++) {
+        int target = full_doubles_map[prev_chunk_index];
+        if (target != -1) {
+          target += chunk_nverts; /* translate mapping */
+          while (target != -1 && !ELEM(full_doubles_map[target], -1, target)) {
+            /* If target is already mapped, we only follow that mapping if final target remains
+             * close enough from current vert (otherwise no mapping at all). */
+            if (compare_len_v3v3(result_dm_verts[this_chunk_index].co,
+                                 result_dm_verts[full_doubles_map[target]].co,
+                                 amd->merge_dist)) {
+              target = full_doubles_map[target];
+            }
+            else {
+              target = -1;
             }
           }
-          full_doubles_map[this_chunk_index] = target;
         }
-      }
-      else {
-        dm_mvert_map_doubles(full_doubles_map,
-                             result_dm_verts,
-                             (c - 1) * chunk_nverts,
-                             chunk_nverts,
-                             c * chunk_nverts,
-                             chunk_nverts,
-                             amd->merge_dist);
+        full_doubles_map[this_chunk_index] = target;
       }
     }
-  }
-
-  /* handle UVs */
-  if (chunk_nloops > 0 && is_zero_v2(amd->uv_offset) == false) {
-    const int totuv = CustomData_number_of_layers(&result->ldata, CD_MLOOPUV);
-    for (i = 0; i < totuv; i++) {
-      MLoopUV *dmloopuv = CustomData_get_layer_n(&result->ldata, CD_MLOOPUV, i);
-      dmloopuv += chunk_nloops;
-      for (c = 1; c < count; c++) {
-        const float uv_offset[2] = {
-            amd->uv_offset[0] * (float)c,
-            amd->uv_offset[1] * (float)c,
-        };
-        int l_index = chunk_nloops;
-        for (; l_index-- != 0; dmloopuv++) {
-          dmloopuv->uv[0] += uv_offset[0];
-          dmloopuv->uv[1] += uv_offset[1];
-        }
-      }
+    else {
+      dm_mvert_map_doubles(full_doubles_map,
+                           result_dm_verts,
+                           (c - 1) * chunk_nverts,
+                           chunk_nverts,
+                           c * chunk_nverts,
+                           chunk_nverts,
+                           amd->merge_dist);
     }
   }
 
   last_chunk_start = (count - 1) * chunk_nverts;
   last_chunk_nverts = chunk_nverts;
 
-  copy_m4_m4(final_offset, current_offset);
-
   if (use_merge && (amd->flags & MOD_ARR_MERGEFINAL) && (count > 1)) {
     /* Merge first and last copies */
     dm_mvert_map_doubles(full_doubles_map,
@@ -689,7 +668,7 @@ static Mesh *arrayModifier_doArray(ArrayModifierData *amd,
   if (end_cap_mesh) {
     float end_offset[4][4];
     int end_cap_start = result_nverts - end_cap_nverts;
-    mul_m4_m4m4(end_offset, current_offset, offset);
+    mul_m4_m4m4(end_offset, chunk_offsets[count - 1], offset);
     mesh_merge_transform(result,
                          end_cap_mesh,
                          end_offset,
@@ -716,6 +695,16 @@ static Mesh *arrayModifier_doArray(ArrayModifierData *amd,
   }
   /* done capping */
 
+  MEM_freeN(chunk_offsets);
+
+  if (use_debug_report) {
+    /* Memory held by the copies and the doubles map before merging. */
+    mem_copies = mesh_customdata_size(result);
+    if (full_doubles_map) {
+      mem_copies += sizeof(*full_doubles_map) * (size_t)result_nverts;
+    }
+  }
+
   /* Handle merging */
   tot_doubles = 0;
   if (use_merge) {
@@ -751,6 +740,16 @@ static Mesh *arrayModifier_doArray(ArrayModifierData *amd,
     result->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
   }
 
+  if (use_debug_report) {
+    printf("%s: %d copies, %d vertices (%d merged) in %.4fs, %.2f MiB for copies\n",
+           __func__,
+           count,
+           result->totvert,
+           tot_doubles,
+           PIL_check_seconds_timer() - time_start,
+           (double)mem_copies / (1024.0 * 1024.0));
+  }
+
   if (vgroup_start_cap_remap) {
     MEM_freeN(vgroup_start_cap_remap);
   }
@@ -807,6 +806,7 @@ ModifierTypeInfo modifierType_Array = {
     /* deformMatrices */ NULL,
     /* deformVertsEM */ NULL,
     /* deformMatricesEM */ NULL,
+    /* deformVertsBlockPrepare */ NULL,
     /* applyModifier */ applyModifier,
 
     /* initData */ initData,
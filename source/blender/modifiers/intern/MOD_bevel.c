@@ -275,6 +275,7 @@ ModifierTypeInfo modifierType_Bevel = {
     /* deformMatrices */ NULL,
     /* deformVertsEM */ NULL,
     /* deformMatricesEM */ NULL,
+    /* deformVertsBlockPrepare */ NULL,
     /* applyModifier */ applyModifier,
     /* initData */ initData,
     /* requiredDataMask */ requiredDataMask,
@@ -359,6 +359,7 @@ ModifierTypeInfo modifierType_Boolean = {
     /* deformMatrices */ NULL,
     /* deformVertsEM */ NULL,
     /* deformMatricesEM */ NULL,
+    /* deformVertsBlockPrepare */ NULL,
     /* applyModifier */ applyModifier,
 
     /* initData */ initData,
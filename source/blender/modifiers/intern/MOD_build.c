@@ -288,6 +288,7 @@ ModifierTypeInfo modifierType_Build = {
     /* deformMatrices */ NULL,
     /* deformVertsEM */ NULL,
     /* deformMatricesEM */ NULL,
+    /* deformVertsBlockPrepare */ NULL,
     /* applyModifier */ applyModifier,
 
     /* initData */ initData,
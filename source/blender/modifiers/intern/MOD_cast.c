@@ -522,6 +522,7 @@ ModifierTypeInfo modifierType_Cast = {
     /* deformMatrices */ NULL,
     /* deformVertsEM */ deformVertsEM,
     /* deformMatricesEM */ NULL,
+    /* deformVertsBlockPrepare */ NULL,
     /* applyModifier */ NULL,
 
     /* initData */ initData,
@@ -263,6 +263,7 @@ ModifierTypeInfo modifierType_Cloth = {
     /* deformMatrices */ NULL,
     /* deformVertsEM */ NULL,
     /* deformMatricesEM */ NULL,
+    /* deformVertsBlockPrepare */ NULL,
     /* applyModifier */ NULL,
 
     /* initData */ initData,
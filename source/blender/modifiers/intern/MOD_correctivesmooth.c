@@ -775,6 +775,7 @@ ModifierTypeInfo modifierType_CorrectiveSmooth = {
     /* deformMatrices */ NULL,
     /* deformVertsEM */ deformVertsEM,
     /* deformMatricesEM */ NULL,
+    /* deformVertsBlockPrepare */ NULL,
     /* applyModifier */ NULL,
 
     /* initData */ initData,
@@ -163,6 +163,7 @@ ModifierTypeInfo modifierType_Curve = {
     /* deformMatrices */ NULL,
     /* deformVertsEM */ deformVertsEM,
     /* deformMatricesEM */ NULL,
+    /* deformVertsBlockPrepare */ NULL,
     /* applyModifier */ NULL,
 
     /* initData */ initData,
@@ -249,6 +249,7 @@ ModifierTypeInfo modifierType_DataTransfer = {
     /* deformMatrices */ NULL,
     /* deformVertsEM */ NULL,
     /* deformMatricesEM */ NULL,
+    /* deformVertsBlockPrepare */ NULL,
     /* applyModifier */ applyModifier,
 
     /* initData */ initData,
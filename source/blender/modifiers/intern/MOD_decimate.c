@@ -228,6 +228,7 @@ ModifierTypeInfo modifierType_Decimate = {
     /* deformMatrices */ NULL,
     /* deformVertsEM */ NULL,
     /* deformMatricesEM */ NULL,
+    /* deformVertsBlockPrepare */ NULL,
     /* applyModifier */ applyModifier,
 
     /* initData */ initData,
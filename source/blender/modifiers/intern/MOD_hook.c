@@ -250,18 +250,16 @@ static void hook_co_apply(struct HookData_cb *hd, const int j)
   }
 }
 
-static void deformVerts_do(HookModifierData *hmd,
-                           const ModifierEvalContext *UNUSED(ctx),
+/* Initialize all members of hd, except for the vertex coordinates. */
+static void hook_data_init(HookModifierData *hmd,
                            Object *ob,
                            Mesh *mesh,
-                           float (*vertexCos)[3],
-                           int numVerts)
+                           struct HookData_cb *r_hd)
 {
+  struct HookData_cb hd;
   Object *ob_target = hmd->object;
   bPoseChannel *pchan = BKE_pose_channel_find_name(ob_target->pose, hmd->subtarget);
   float dmat[4][4];
-  int i, *index_pt;
-  struct HookData_cb hd;
   const bool invert_vgroup = (hmd->flag & MOD_HOOK_INVERT_VGROUP) != 0;
 
   if (hmd->curfalloff == NULL) {
@@ -274,7 +272,7 @@ static void deformVerts_do(HookModifierData *hmd,
   }
 
   /* Generic data needed for applying per-vertex calculations (initialize all members) */
-  hd.vertexCos = vertexCos;
+  hd.vertexCos = NULL;
   MOD_get_vgroup(ob, mesh, hmd->name, &hd.dvert, &hd.defgrp_index);
 
   hd.curfalloff = hmd->curfalloff;
@@ -311,6 +309,22 @@ static void deformVerts_do(HookModifierData *hmd,
   mul_m4_series(hd.mat, ob->imat, dmat, hmd->parentinv);
   /* --- done with 'hd' init --- */
 
+  *r_hd = hd;
+}
+
+static void deformVerts_do(HookModifierData *hmd,
+                           const ModifierEvalContext *UNUSED(ctx),
+                           Object *ob,
+                           Mesh *mesh,
+                           float (*vertexCos)[3],
+                           int numVerts)
+{
+  int i, *index_pt;
+  struct HookData_cb hd;
+
+  hook_data_init(hmd, ob, mesh, &hd);
+  hd.vertexCos = vertexCos;
+
   /* Regarding index range checking below.
    *
    * This should always be true and I don't generally like
@@ -370,6 +384,68 @@ static void deformVerts(struct ModifierData *md,
   }
 }
 
+typedef struct HookBlockData {
+  struct HookData_cb hd;
+  Mesh *mesh_src;
+  /* Mesh created for the vertex group lookup, freed with the block. */
+  bool free_mesh_src;
+} HookBlockData;
+
+static void deform_block_hook(void *userdata, float (*vertexCos)[3], int start, int end)
+{
+  HookBlockData *data = userdata;
+  struct HookData_cb hd = data->hd;
+
+  hd.vertexCos = vertexCos;
+  for (int i = start; i < end; i++) {
+    hook_co_apply(&hd, i);
+  }
+}
+
+static void deform_block_hook_free(void *userdata)
+{
+  HookBlockData *data = userdata;
+
+  if (data->free_mesh_src) {
+    BKE_id_free(NULL, data->mesh_src);
+  }
+  MEM_freeN(data);
+}
+
+static bool deformVertsBlockPrepare(struct ModifierData *md,
+                                    const struct ModifierEvalContext *ctx,
+                                    struct Mesh *mesh,
+                                    int numVerts,
+                                    ModifierDeformBlock *r_block)
+{
+  HookModifierData *hmd = (HookModifierData *)md;
+
+  /* Hooks with vertex indices only touch a few vertices, there is nothing to gain. */
+  if (hmd->indexar) {
+    return false;
+  }
+
+  r_block->deform = NULL;
+  r_block->free = NULL;
+  r_block->userdata = NULL;
+
+  if (hmd->force == 0.0f) {
+    return true;
+  }
+
+  HookBlockData *data = MEM_callocN(sizeof(*data), __func__);
+  data->mesh_src = MOD_deform_mesh_eval_get(
+      ctx->object, NULL, mesh, NULL, numVerts, false, false);
+  data->free_mesh_src = !ELEM(data->mesh_src, NULL, mesh);
+  hook_data_init(hmd, ctx->object, data->mesh_src, &data->hd);
+
+  r_block->userdata = data;
+  r_block->free = deform_block_hook_free;
+  /* Without a vertex group deformVerts does nothing either. */
+  r_block->deform = data->hd.dvert ? deform_block_hook : NULL;
+  return true;
+}
+
 static void deformVertsEM(struct ModifierData *md,
                           const struct ModifierEvalContext *ctx,
                           struct BMEditMesh *editData,
@@ -401,6 +477,7 @@ ModifierTypeInfo modifierType_Hook = {
     /* deformMatrices */ NULL,
     /* deformVertsEM */ deformVertsEM,
     /* deformMatricesEM */ NULL,
+    /* deformVertsBlockPrepare */ deformVertsBlockPrepare,
     /* applyModifier */ NULL,
 
     /* initData */ initData,
@@ -115,6 +115,37 @@ static void deformVerts(ModifierData *md,
   }
 }
 
+static void deform_block_lattice(void *userdata, float (*vertexCos)[3], int start, int end)
+{
+  lattice_deform_verts_range(userdata, vertexCos, start, end);
+}
+
+static void deform_block_lattice_free(void *userdata)
+{
+  lattice_deform_verts_free(userdata);
+}
+
+static bool deformVertsBlockPrepare(ModifierData *md,
+                                    const ModifierEvalContext *ctx,
+                                    struct Mesh *mesh,
+                                    int UNUSED(numVerts),
+                                    ModifierDeformBlock *r_block)
+{
+  LatticeModifierData *lmd = (LatticeModifierData *)md;
+
+  if (MOD_previous_vcos_needed(md)) {
+    return false;
+  }
+
+  /* Without a mesh the vertex groups are read from the object data, so there is no need
+   * to create a mesh like deformVerts does. */
+  r_block->userdata = lattice_deform_verts_prepare(
+      lmd->object, ctx->object, mesh, lmd->flag, lmd->name, lmd->strength);
+  r_block->deform = r_block->userdata ? deform_block_lattice : NULL;
+  r_block->free = deform_block_lattice_free;
+  return true;
+}
+
 static void deformVertsEM(ModifierData *md,
                           const ModifierEvalContext *ctx,
                           struct BMEditMesh *em,
@@ -146,6 +177,7 @@ ModifierTypeInfo modifierType_Lattice = {
     /* deformMatrices */ NULL,
     /* deformVertsEM */ deformVertsEM,
     /* deformMatricesEM */ NULL,
+    /* deformVertsBlockPrepare */ deformVertsBlockPrepare,
     /* applyModifier */ NULL,
 
     /* initData */ initData,
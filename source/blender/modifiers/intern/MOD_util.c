@@ -168,6 +168,16 @@ void MOD_previous_vcos_store(ModifierData *md, float (*vertexCos)[3])
   /* lattice/mesh modifier too */
 }
 
+/* True when MOD_previous_vcos_store would store coordinates for the next modifier. */
+bool MOD_previous_vcos_needed(ModifierData *md)
+{
+  if ((md = md->next) && md->type == eModifierType_Armature) {
+    ArmatureModifierData *amd = (ArmatureModifierData *)md;
+    return (amd->multi && amd->prevCos == NULL);
+  }
+  return false;
+}
+
 /* returns a mesh if mesh == NULL, for deforming modifiers that need it */
 Mesh *MOD_deform_mesh_eval_get(Object *ob,
                                struct BMEditMesh *em,
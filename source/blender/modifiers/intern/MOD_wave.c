@@ -136,28 +136,45 @@ static bool dependsOnNormals(ModifierData *md)
   return (wmd->flag & MOD_WAVE_NORM) != 0;
 }
 
-static void waveModifier_do(WaveModifierData *md,
-                            const ModifierEvalContext *ctx,
-                            Object *ob,
-                            Mesh *mesh,
-                            float (*vertexCos)[3],
-                            int numVerts)
-{
-  WaveModifierData *wmd = (WaveModifierData *)md;
-  MVert *mvert = NULL;
+/* Everything needed to displace a single vertex, independent of the vertex coordinates. */
+typedef struct WaveData {
+  WaveModifierData *wmd;
+  MVert *mvert;
   MDeformVert *dvert;
   int defgrp_index;
-  float ctime = DEG_get_ctime(ctx->depsgraph);
-  float minfac = (float)(1.0 / exp(wmd->width * wmd->narrow * wmd->width * wmd->narrow));
+  bool invert_group;
+  float ctime;
+  float minfac;
+  float lifefac;
+  int wmd_axis;
+  float falloff;
+  float falloff_inv;
+  Tex *tex_target;
+  struct Scene *scene;
+  float (*tex_co)[3];
+} WaveData;
+
+static void wave_data_init(WaveModifierData *wmd,
+                           const ModifierEvalContext *ctx,
+                           Object *ob,
+                           Mesh *mesh,
+                           WaveData *r_data)
+{
+  WaveData data = {NULL};
   float lifefac = wmd->height;
-  float(*tex_co)[3] = NULL;
-  const int wmd_axis = wmd->flag & (MOD_WAVE_X | MOD_WAVE_Y);
-  const float falloff = wmd->falloff;
-  float falloff_fac = 1.0f; /* when falloff == 0.0f this stays at 1.0f */
-  const bool invert_group = (wmd->flag & MOD_WAVE_INVERT_VGROUP) != 0;
+
+  data.wmd = wmd;
+  data.ctime = DEG_get_ctime(ctx->depsgraph);
+  data.minfac = (float)(1.0 / exp(wmd->width * wmd->narrow * wmd->width * wmd->narrow));
+  data.wmd_axis = wmd->flag & (MOD_WAVE_X | MOD_WAVE_Y);
+  data.falloff = wmd->falloff;
+  /* avoid divide by zero checks within the loop */
+  data.falloff_inv = data.falloff != 0.0f ? 1.0f / data.falloff : 1.0f;
+  data.invert_group = (wmd->flag & MOD_WAVE_INVERT_VGROUP) != 0;
+  data.scene = DEG_get_evaluated_scene(ctx->depsgraph);
 
   if ((wmd->flag & MOD_WAVE_NORM) && (mesh != NULL)) {
-    mvert = mesh->mvert;
+    data.mvert = mesh->mvert;
   }
 
   if (wmd->objectcenter != NULL) {
@@ -171,14 +188,14 @@ static void waveModifier_do(WaveModifierData *md,
   }
 
   /* get the index of the deform group */
-  MOD_get_vgroup(ob, mesh, wmd->defgrp_name, &dvert, &defgrp_index);
+  MOD_get_vgroup(ob, mesh, wmd->defgrp_name, &data.dvert, &data.defgrp_index);
 
   if (wmd->damp == 0.0f) {
     wmd->damp = 10.0f;
   }
 
   if (wmd->lifetime != 0.0f) {
-    float x = ctime - wmd->timeoffs;
+    float x = data.ctime - wmd->timeoffs;
 
     if (x > wmd->lifetime) {
       lifefac = x - wmd->lifetime;
@@ -191,114 +208,139 @@ static void waveModifier_do(WaveModifierData *md,
       }
     }
   }
+  data.lifefac = lifefac;
 
-  Tex *tex_target = wmd->texture;
-  if (mesh != NULL && tex_target != NULL) {
-    tex_co = MEM_malloc_arrayN(numVerts, sizeof(*tex_co), "waveModifier_do tex_co");
-    MOD_get_texture_coords((MappingInfoModifierData *)wmd, ctx, ob, mesh, vertexCos, tex_co);
+  *r_data = data;
+}
 
-    MOD_init_texture((MappingInfoModifierData *)wmd, ctx);
+static void wave_co_apply(const WaveData *data, float co[3], const int i)
+{
+  const WaveModifierData *wmd = data->wmd;
+  const float ctime = data->ctime;
+  const int wmd_axis = data->wmd_axis;
+  const float lifefac = data->lifefac;
+  float x = co[0] - wmd->startx;
+  float y = co[1] - wmd->starty;
+  float amplit = 0.0f;
+  float def_weight = 1.0f;
+  float falloff_fac = 1.0f; /* when falloff == 0.0f this stays at 1.0f */
+
+  /* get weights */
+  if (data->dvert) {
+    def_weight = data->invert_group ?
+                     1.0f - BKE_defvert_find_weight(&data->dvert[i], data->defgrp_index) :
+                     BKE_defvert_find_weight(&data->dvert[i], data->defgrp_index);
+
+    /* if this vert isn't in the vgroup, don't deform it */
+    if (def_weight == 0.0f) {
+      return;
+    }
   }
 
-  if (lifefac != 0.0f) {
-    /* avoid divide by zero checks within the loop */
-    float falloff_inv = falloff != 0.0f ? 1.0f / falloff : 1.0f;
-    int i;
+  switch (wmd_axis) {
+    case MOD_WAVE_X | MOD_WAVE_Y:
+      amplit = sqrtf(x * x + y * y);
+      break;
+    case MOD_WAVE_X:
+      amplit = x;
+      break;
+    case MOD_WAVE_Y:
+      amplit = y;
+      break;
+  }
 
-    for (i = 0; i < numVerts; i++) {
-      float *co = vertexCos[i];
-      float x = co[0] - wmd->startx;
-      float y = co[1] - wmd->starty;
-      float amplit = 0.0f;
-      float def_weight = 1.0f;
-
-      /* get weights */
-      if (dvert) {
-        def_weight = invert_group ? 1.0f - BKE_defvert_find_weight(&dvert[i], defgrp_index) :
-                                    BKE_defvert_find_weight(&dvert[i], defgrp_index);
-
-        /* if this vert isn't in the vgroup, don't deform it */
-        if (def_weight == 0.0f) {
-          continue;
-        }
-      }
+  /* this way it makes nice circles */
+  amplit -= (ctime - wmd->timeoffs) * wmd->speed;
 
-      switch (wmd_axis) {
-        case MOD_WAVE_X | MOD_WAVE_Y:
-          amplit = sqrtf(x * x + y * y);
-          break;
-        case MOD_WAVE_X:
-          amplit = x;
-          break;
-        case MOD_WAVE_Y:
-          amplit = y;
-          break;
-      }
+  if (wmd->flag & MOD_WAVE_CYCL) {
+    amplit = (float)fmodf(amplit - wmd->width, 2.0f * wmd->width) + wmd->width;
+  }
 
-      /* this way it makes nice circles */
-      amplit -= (ctime - wmd->timeoffs) * wmd->speed;
+  if (data->falloff != 0.0f) {
+    float dist = 0.0f;
+
+    switch (wmd_axis) {
+      case MOD_WAVE_X | MOD_WAVE_Y:
+        dist = sqrtf(x * x + y * y);
+        break;
+      case MOD_WAVE_X:
+        dist = fabsf(x);
+        break;
+      case MOD_WAVE_Y:
+        dist = fabsf(y);
+        break;
+    }
 
-      if (wmd->flag & MOD_WAVE_CYCL) {
-        amplit = (float)fmodf(amplit - wmd->width, 2.0f * wmd->width) + wmd->width;
-      }
+    falloff_fac = (1.0f - (dist * data->falloff_inv));
+    CLAMP(falloff_fac, 0.0f, 1.0f);
+  }
 
-      if (falloff != 0.0f) {
-        float dist = 0.0f;
-
-        switch (wmd_axis) {
-          case MOD_WAVE_X | MOD_WAVE_Y:
-            dist = sqrtf(x * x + y * y);
-            break;
-          case MOD_WAVE_X:
-            dist = fabsf(x);
-            break;
-          case MOD_WAVE_Y:
-            dist = fabsf(y);
-            break;
-        }
-
-        falloff_fac = (1.0f - (dist * falloff_inv));
-        CLAMP(falloff_fac, 0.0f, 1.0f);
-      }
+  /* GAUSSIAN */
+  if ((falloff_fac != 0.0f) && (amplit > -wmd->width) && (amplit < wmd->width)) {
+    amplit = amplit * wmd->narrow;
+    amplit = (float)(1.0f / expf(amplit * amplit) - data->minfac);
+
+    /*apply texture*/
+    if (data->tex_co) {
+      TexResult texres;
+      texres.nor = NULL;
+      BKE_texture_get_value(data->scene, data->tex_target, data->tex_co[i], &texres, false);
+      amplit *= texres.tin;
+    }
+
+    /*apply weight & falloff */
+    amplit *= def_weight * falloff_fac;
 
-      /* GAUSSIAN */
-      if ((falloff_fac != 0.0f) && (amplit > -wmd->width) && (amplit < wmd->width)) {
-        amplit = amplit * wmd->narrow;
-        amplit = (float)(1.0f / expf(amplit * amplit) - minfac);
-
-        /*apply texture*/
-        if (tex_co) {
-          Scene *scene = DEG_get_evaluated_scene(ctx->depsgraph);
-          TexResult texres;
-          texres.nor = NULL;
-          BKE_texture_get_value(scene, tex_target, tex_co[i], &texres, false);
-          amplit *= texres.tin;
-        }
-
-        /*apply weight & falloff */
-        amplit *= def_weight * falloff_fac;
-
-        if (mvert) {
-          /* move along normals */
-          if (wmd->flag & MOD_WAVE_NORM_X) {
-            co[0] += (lifefac * amplit) * mvert[i].no[0] / 32767.0f;
-          }
-          if (wmd->flag & MOD_WAVE_NORM_Y) {
-            co[1] += (lifefac * amplit) * mvert[i].no[1] / 32767.0f;
-          }
-          if (wmd->flag & MOD_WAVE_NORM_Z) {
-            co[2] += (lifefac * amplit) * mvert[i].no[2] / 32767.0f;
-          }
-        }
-        else {
-          /* move along local z axis */
-          co[2] += lifefac * amplit;
-        }
+    if (data->mvert) {
+      const MVert *mvert = data->mvert;
+      /* move along normals */
+      if (wmd->flag & MOD_WAVE_NORM_X) {
+        co[0] += (lifefac * amplit) * mvert[i].no[0] / 32767.0f;
+      }
+      if (wmd->flag & MOD_WAVE_NORM_Y) {
+        co[1] += (lifefac * amplit) * mvert[i].no[1] / 32767.0f;
       }
+      if (wmd->flag & MOD_WAVE_NORM_Z) {
+        co[2] += (lifefac * amplit) * mvert[i].no[2] / 32767.0f;
+      }
+    }
+    else {
+      /* move along local z axis */
+      co[2] += lifefac * amplit;
+    }
+  }
+}
+
+static void waveModifier_do(WaveModifierData *md,
+                            const ModifierEvalContext *ctx,
+                            Object *ob,
+                            Mesh *mesh,
+                            float (*vertexCos)[3],
+                            int numVerts)
+{
+  WaveModifierData *wmd = (WaveModifierData *)md;
+  WaveData data;
+
+  wave_data_init(wmd, ctx, ob, mesh, &data);
+
+  Tex *tex_target = wmd->texture;
+  if (mesh != NULL && tex_target != NULL) {
+    data.tex_co = MEM_malloc_arrayN(numVerts, sizeof(*data.tex_co), "waveModifier_do tex_co");
+    MOD_get_texture_coords((MappingInfoModifierData *)wmd, ctx, ob, mesh, vertexCos, data.tex_co);
+    data.tex_target = tex_target;
+
+    MOD_init_texture((MappingInfoModifierData *)wmd, ctx);
+  }
+
+  if (data.lifefac != 0.0f) {
+    int i;
+
+    for (i = 0; i < numVerts; i++) {
+      wave_co_apply(&data, vertexCos[i], i);
     }
   }
 
-  MEM_SAFE_FREE(tex_co);
+  MEM_SAFE_FREE(data.tex_co);
 }
 
 static void deformVerts(ModifierData *md,
@@ -324,6 +366,59 @@ static void deformVerts(ModifierData *md,
   }
 }
 
+typedef struct WaveBlockData {
+  WaveData data;
+  Mesh *mesh_src;
+  /* Mesh created for the vertex group lookup, freed with the block. */
+  bool free_mesh_src;
+} WaveBlockData;
+
+static void deform_block_wave(void *userdata, float (*vertexCos)[3], int start, int end)
+{
+  const WaveBlockData *block = userdata;
+
+  for (int i = start; i < end; i++) {
+    wave_co_apply(&block->data, vertexCos[i], i);
+  }
+}
+
+static void deform_block_wave_free(void *userdata)
+{
+  WaveBlockData *block = userdata;
+
+  if (block->free_mesh_src) {
+    BKE_id_free(NULL, block->mesh_src);
+  }
+  MEM_freeN(block);
+}
+
+static bool deformVertsBlockPrepare(ModifierData *md,
+                                    const ModifierEvalContext *ctx,
+                                    Mesh *mesh,
+                                    int numVerts,
+                                    ModifierDeformBlock *r_block)
+{
+  WaveModifierData *wmd = (WaveModifierData *)md;
+
+  /* Normals and texture coordinates depend on the deformed coordinates of all vertices. */
+  if ((wmd->flag & MOD_WAVE_NORM) || wmd->texture != NULL) {
+    return false;
+  }
+
+  WaveBlockData *block = MEM_callocN(sizeof(*block), __func__);
+  if (wmd->defgrp_name[0] != '\0') {
+    block->mesh_src = MOD_deform_mesh_eval_get(
+        ctx->object, NULL, mesh, NULL, numVerts, false, false);
+    block->free_mesh_src = !ELEM(block->mesh_src, NULL, mesh);
+  }
+  wave_data_init(wmd, ctx, ctx->object, block->mesh_src, &block->data);
+
+  r_block->userdata = block;
+  r_block->free = deform_block_wave_free;
+  r_block->deform = (block->data.lifefac != 0.0f) ? deform_block_wave : NULL;
+  return true;
+}
+
 static void deformVertsEM(ModifierData *md,
                           const ModifierEvalContext *ctx,
                           struct BMEditMesh *editData,
@@ -363,6 +458,7 @@ ModifierTypeInfo modifierType_Wave = {
     /* deformMatrices */ NULL,
     /* deformVertsEM */ deformVertsEM,
     /* deformMatricesEM */ NULL,
+    /* deformVertsBlockPrepare */ deformVertsBlockPrepare,
     /* applyModifier */ NULL,
 
     /* initData */ initData,
@@ -43,6 +43,9 @@ typedef enum eMassSpringSolverStatus {
 
 struct Implicit_Data *BPH_mass_spring_solver_create(int numverts, int numsprings);
 void BPH_mass_spring_solver_free(struct Implicit_Data *id);
+void BPH_mass_spring_solver_set_method(struct Implicit_Data *id,
+                                       int linear_solver,
+                                       int preconditioner);
 int BPH_mass_spring_solver_numvert(struct Implicit_Data *id);
 
 int BPH_cloth_solver_init(struct Object *ob, struct ClothModifierData *clmd);
@@ -38,6 +38,8 @@ extern "C" {
 #include "BKE_cloth.h"
 #include "BKE_collision.h"
 #include "BKE_effect.h"
+
+#include "PIL_time.h"
 }
 
 #include "BPH_mass_spring.h"
@@ -1088,6 +1090,7 @@ static void cloth_clear_result(ClothModifierData *clmd)
   sres->max_error = sres->min_error = sres->avg_error = 0.0f;
   sres->max_iterations = sres->min_iterations = 0;
   sres->avg_iterations = 0.0f;
+  sres->max_collision_time = sres->avg_collision_time = 0.0f;
 }
 
 static void cloth_record_result(ClothModifierData *clmd, ImplicitSolverResult *result, float dt)
@@ -1120,6 +1123,14 @@ static void cloth_record_result(ClothModifierData *clmd, ImplicitSolverResult *r
   sres->status |= result->status;
 }
 
+static void cloth_record_collision_time(ClothModifierData *clmd, double time, float dt)
+{
+  ClothSolverResult *sres = clmd->solver_result;
+
+  sres->max_collision_time = max_ff(sres->max_collision_time, (float)time);
+  sres->avg_collision_time += (float)time * dt;
+}
+
 int BPH_cloth_solve(
     Depsgraph *depsgraph, Object *ob, float frame, ClothModifierData *clmd, ListBase *effectors)
 {
@@ -1146,6 +1157,9 @@ int BPH_cloth_solve(
   }
   cloth_clear_result(clmd);
 
+  BPH_mass_spring_solver_set_method(
+      id, clmd->sim_parms->linear_solver, clmd->sim_parms->preconditioner);
+
   if (clmd->sim_parms->vgroup_mass > 0) { /* Do goal stuff. */
     for (i = 0; i < mvert_num; i++) {
       // update velocities with constrained velocities from pinned verts
@@ -1177,7 +1191,9 @@ int BPH_cloth_solve(
     cloth_record_result(clmd, &result, dt);
 
     /* Calculate collision impulses. */
+    const double collision_start = PIL_check_seconds_timer();
     cloth_solve_collisions(depsgraph, ob, clmd, step, dt);
+    cloth_record_collision_time(clmd, PIL_check_seconds_timer() - collision_start, dt);
 
     if (is_hair) {
       cloth_continuum_step(clmd, dt);
@@ -34,6 +34,7 @@
 #  include "DNA_texture_types.h"
 
 #  include "BLI_math.h"
+#  include "BLI_task.h"
 #  include "BLI_utildefines.h"
 
 #  include "BKE_cloth.h"
@@ -652,6 +653,103 @@ DO_INLINE void subadd_bfmatrixS_bfmatrixS(
   }
 }
 
+/* ==== Block CSR matrix ==== */
+
+/* Compressed sparse row layout of the symmetric system matrix. Unlike fmatrix3x3 lists, both
+ * triangles are stored, so each row can be multiplied independently of the others and the
+ * product can be computed in parallel without write conflicts. Each row starts with its
+ * diagonal block. */
+typedef struct BlockCSRMatrix {
+  int num_rows;
+  int max_blocks;
+  int *row_offset; /* num_rows + 1 offsets into the block arrays */
+  int *row_fill;   /* temporary fill counter per row */
+  int *col;
+  float (*m)[3][3];
+} BlockCSRMatrix;
+
+static BlockCSRMatrix *create_block_csr(unsigned int verts, unsigned int springs)
+{
+  BlockCSRMatrix *csr = MEM_callocN(sizeof(BlockCSRMatrix), "cloth_implicit_csr");
+
+  csr->num_rows = verts;
+  csr->max_blocks = verts + 2 * springs;
+  csr->row_offset = MEM_mallocN(sizeof(int) * (verts + 1), "cloth_implicit_csr_rows");
+  csr->row_fill = MEM_mallocN(sizeof(int) * verts, "cloth_implicit_csr_fill");
+  csr->col = MEM_mallocN(sizeof(int) * csr->max_blocks, "cloth_implicit_csr_cols");
+  csr->m = MEM_mallocN(sizeof(float[3][3]) * csr->max_blocks, "cloth_implicit_csr_blocks");
+
+  return csr;
+}
+
+static void del_block_csr(BlockCSRMatrix *csr)
+{
+  if (csr != NULL) {
+    MEM_freeN(csr->row_offset);
+    MEM_freeN(csr->row_fill);
+    MEM_freeN(csr->col);
+    MEM_freeN(csr->m);
+    MEM_freeN(csr);
+  }
+}
+
+/* Convert the first num_blocks off-diagonal blocks of a big matrix to CSR.
+ * Stored off-diagonal blocks are the lower triangle, the transpose goes into the upper. */
+static void block_csr_from_bfmatrix(BlockCSRMatrix *csr, fmatrix3x3 *from, int num_blocks)
+{
+  const int numverts = from[0].vcount;
+  const int totblock = numverts + num_blocks;
+  int *row_offset = csr->row_offset;
+  int *row_fill = csr->row_fill;
+  int i;
+
+  BLI_assert(csr->num_rows == numverts);
+  BLI_assert(numverts + 2 * num_blocks <= csr->max_blocks);
+
+  for (i = 0; i < numverts; i++) {
+    row_fill[i] = 1;
+  }
+  for (i = numverts; i < totblock; i++) {
+    row_fill[from[i].r]++;
+    row_fill[from[i].c]++;
+  }
+
+  row_offset[0] = 0;
+  for (i = 0; i < numverts; i++) {
+    row_offset[i + 1] = row_offset[i] + row_fill[i];
+    row_fill[i] = row_offset[i];
+  }
+
+  for (i = 0; i < numverts; i++) {
+    const int k = row_fill[i]++;
+    csr->col[k] = i;
+    copy_m3_m3(csr->m[k], from[i].m);
+  }
+  for (i = numverts; i < totblock; i++) {
+    const int r = from[i].r, c = from[i].c;
+    int k;
+
+    k = row_fill[r]++;
+    csr->col[k] = c;
+    copy_m3_m3(csr->m[k], from[i].m);
+
+    k = row_fill[c]++;
+    csr->col[k] = r;
+    transpose_m3_m3(csr->m[k], from[i].m);
+  }
+}
+
+BLI_INLINE void block_csr_mul_row(float r[3], const BlockCSRMatrix *csr, int row, lfVector *v)
+{
+  const int end = csr->row_offset[row + 1];
+  int k;
+
+  zero_v3(r);
+  for (k = csr->row_offset[row]; k < end; k++) {
+    muladd_fmatrix_fvector(r, csr->m[k], v[csr->col[k]]);
+  }
+}
+
 ///////////////////////////////////////////////////////////////////
 // simulator start
 ///////////////////////////////////////////////////////////////////
@@ -677,6 +775,11 @@ typedef struct Implicit_Data {
   lfVector *z;          /* target velocity in constrained directions */
   fmatrix3x3 *S;        /* filtering matrix for constraints */
   fmatrix3x3 *P, *Pinv; /* pre-conditioning matrix */
+
+  /* solver selection, see CLOTH_LINEAR_SOLVER and CLOTH_PRECONDITIONER */
+  int linear_solver;
+  int preconditioner;
+  BlockCSRMatrix *csr; /* A in block CSR layout, allocated on demand */
 } Implicit_Data;
 
 Implicit_Data *BPH_mass_spring_solver_create(int numverts, int numsprings)
@@ -718,6 +821,7 @@ void BPH_mass_spring_solver_free(Implicit_Data *id)
   del_bfmatrix(id->Pinv);
   del_bfmatrix(id->bigI);
   del_bfmatrix(id->M);
+  del_block_csr(id->csr);
 
   del_lfvector(id->X);
   del_lfvector(id->Xnew);
@@ -731,6 +835,16 @@ void BPH_mass_spring_solver_free(Implicit_Data *id)
   MEM_freeN(id);
 }
 
+void BPH_mass_spring_solver_set_method(Implicit_Data *id, int linear_solver, int preconditioner)
+{
+  id->linear_solver = linear_solver;
+  id->preconditioner = preconditioner;
+
+  if (linear_solver == CLOTH_LINEAR_SOLVER_BLOCK_CSR && id->csr == NULL) {
+    id->csr = create_block_csr(id->A[0].vcount, id->A[0].scount);
+  }
+}
+
 /* ==== Transformation from/to root reference frames ==== */
 
 BLI_INLINE void world_to_root_v3(Implicit_Data *data, int index, float r[3], const float v[3])
@@ -933,6 +1047,242 @@ static int cg_filtered(lfVector *ldV,
          conjgrad_looplimit;  // true means we reached desired accuracy in given time - ie stable
 }
 
+/* ==== Parallel preconditioned CG on the block CSR matrix ==== */
+
+/* Rows are processed in fixed size chunks. Reductions first sum within each chunk and then
+ * over chunks in order, so results don't depend on thread scheduling. */
+#  define CG_CSR_CHUNK_SIZE 1024
+
+typedef struct CGBlockCSRData {
+  const BlockCSRMatrix *A;
+  fmatrix3x3 *S;
+  fmatrix3x3 *Pinv;
+  int preconditioner;
+  int numverts;
+
+  lfVector *x, *b, *r, *c, *q, *s;
+  float alpha, beta;
+
+  /* per chunk partial sums */
+  double *dot_a, *dot_b;
+} CGBlockCSRData;
+
+BLI_INLINE void cg_csr_chunk_range(const CGBlockCSRData *data, int chunk, int *r_start, int *r_end)
+{
+  *r_start = chunk * CG_CSR_CHUNK_SIZE;
+  *r_end = min_ii(*r_start + CG_CSR_CHUNK_SIZE, data->numverts);
+}
+
+/* h = filter(P^-1 * v) */
+BLI_INLINE void cg_csr_precondition(const CGBlockCSRData *data, int i, float h[3], float v[3])
+{
+  if (data->preconditioner == CLOTH_PRECONDITIONER_NONE) {
+    copy_v3_v3(h, v);
+  }
+  else {
+    mul_v3_m3v3(h, data->Pinv[i].m, v);
+    mul_m3_v3(data->S[i].m, h);
+  }
+}
+
+static void cg_csr_build_preconditioner(const CGBlockCSRData *data, int i)
+{
+  const BlockCSRMatrix *A = data->A;
+  float(*diag)[3] = A->m[A->row_offset[i]];
+  float(*pinv)[3] = data->Pinv[i].m;
+
+  BLI_assert(A->col[A->row_offset[i]] == i);
+
+  switch (data->preconditioner) {
+    case CLOTH_PRECONDITIONER_JACOBI:
+      zero_m3(pinv);
+      for (int k = 0; k < 3; k++) {
+        pinv[k][k] = (fabsf(diag[k][k]) > FLT_EPSILON) ? 1.0f / diag[k][k] : 1.0f;
+      }
+      break;
+    case CLOTH_PRECONDITIONER_BLOCK_JACOBI:
+      if (!invert_m3_m3(pinv, diag)) {
+        unit_m3(pinv);
+      }
+      break;
+  }
+}
+
+/* Initial residual r = filter(B - A * dV) and search direction c = filter(P^-1 * r),
+ * with the norms of the filtered B and of the residual. */
+static void cg_csr_init_cb(void *__restrict userdata,
+                           const int chunk,
+                           const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  CGBlockCSRData *data = userdata;
+  double dot_b = 0.0, dot_r = 0.0;
+  float fb[3], h[3], Ax[3];
+  int start, end;
+
+  cg_csr_chunk_range(data, chunk, &start, &end);
+
+  for (int i = start; i < end; i++) {
+    if (data->preconditioner != CLOTH_PRECONDITIONER_NONE) {
+      cg_csr_build_preconditioner(data, i);
+    }
+
+    mul_v3_m3v3(fb, data->S[i].m, data->b[i]);
+    cg_csr_precondition(data, i, h, fb);
+    dot_b += dot_v3v3(fb, h);
+
+    block_csr_mul_row(Ax, data->A, i, data->x);
+    sub_v3_v3v3(data->r[i], data->b[i], Ax);
+    mul_m3_v3(data->S[i].m, data->r[i]);
+
+    cg_csr_precondition(data, i, data->c[i], data->r[i]);
+    dot_r += dot_v3v3(data->r[i], data->c[i]);
+  }
+
+  data->dot_a[chunk] = dot_b;
+  data->dot_b[chunk] = dot_r;
+}
+
+/* q = filter(A * c) */
+static void cg_csr_mul_cb(void *__restrict userdata,
+                          const int chunk,
+                          const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  CGBlockCSRData *data = userdata;
+  double dot = 0.0;
+  int start, end;
+
+  cg_csr_chunk_range(data, chunk, &start, &end);
+
+  for (int i = start; i < end; i++) {
+    block_csr_mul_row(data->q[i], data->A, i, data->c);
+    mul_m3_v3(data->S[i].m, data->q[i]);
+    dot += dot_v3v3(data->c[i], data->q[i]);
+  }
+
+  data->dot_a[chunk] = dot;
+}
+
+/* dV += alpha * c, r -= alpha * q, s = filter(P^-1 * r) */
+static void cg_csr_update_cb(void *__restrict userdata,
+                             const int chunk,
+                             const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  CGBlockCSRData *data = userdata;
+  const float alpha = data->alpha;
+  double dot = 0.0;
+  int start, end;
+
+  cg_csr_chunk_range(data, chunk, &start, &end);
+
+  for (int i = start; i < end; i++) {
+    madd_v3_v3fl(data->x[i], data->c[i], alpha);
+    madd_v3_v3fl(data->r[i], data->q[i], -alpha);
+
+    cg_csr_precondition(data, i, data->s[i], data->r[i]);
+    dot += dot_v3v3(data->r[i], data->s[i]);
+  }
+
+  data->dot_a[chunk] = dot;
+}
+
+/* c = filter(s + beta * c) */
+static void cg_csr_direction_cb(void *__restrict userdata,
+                                const int chunk,
+                                const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  CGBlockCSRData *data = userdata;
+  const float beta = data->beta;
+  int start, end;
+
+  cg_csr_chunk_range(data, chunk, &start, &end);
+
+  for (int i = start; i < end; i++) {
+    madd_v3_v3v3fl(data->c[i], data->s[i], data->c[i], beta);
+    mul_m3_v3(data->S[i].m, data->c[i]);
+  }
+}
+
+static float cg_csr_sum_chunks(const double *partial, int num_chunks)
+{
+  double sum = 0.0;
+  for (int i = 0; i < num_chunks; i++) {
+    sum += partial[i];
+  }
+  return (float)sum;
+}
+
+/* Same algorithm and convergence criterion as cg_filtered, using the block CSR matrix and
+ * an optional preconditioner. */
+static int cg_filtered_block_csr(Implicit_Data *id,
+                                 int num_blocks,
+                                 ImplicitSolverResult *result)
+{
+  const unsigned int conjgrad_looplimit = 100;
+  const float conjgrad_epsilon = 0.01f;
+  unsigned int conjgrad_loopcount = 0;
+
+  const int numverts = id->A[0].vcount;
+  const int num_chunks = (numverts + CG_CSR_CHUNK_SIZE - 1) / CG_CSR_CHUNK_SIZE;
+  float delta0, delta_new, delta_old, delta_target;
+
+  block_csr_from_bfmatrix(id->csr, id->A, num_blocks);
+
+  CGBlockCSRData data = {
+      .A = id->csr,
+      .S = id->S,
+      .Pinv = id->Pinv,
+      .preconditioner = id->preconditioner,
+      .numverts = numverts,
+      .x = id->dV,
+      .b = id->B,
+      .r = create_lfvector(numverts),
+      .c = create_lfvector(numverts),
+      .q = create_lfvector(numverts),
+      .s = create_lfvector(numverts),
+      .dot_a = MEM_mallocN(sizeof(double) * num_chunks, "cg_csr_dot_a"),
+      .dot_b = MEM_mallocN(sizeof(double) * num_chunks, "cg_csr_dot_b"),
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (num_chunks > 1);
+
+  cp_lfvector(id->dV, id->z, numverts);
+
+  BLI_task_parallel_range(0, num_chunks, &data, cg_csr_init_cb, &settings);
+  delta0 = cg_csr_sum_chunks(data.dot_a, num_chunks);
+  delta_new = cg_csr_sum_chunks(data.dot_b, num_chunks);
+  delta_target = conjgrad_epsilon * conjgrad_epsilon * delta0;
+
+  while (delta_new > delta_target && conjgrad_loopcount < conjgrad_looplimit) {
+    BLI_task_parallel_range(0, num_chunks, &data, cg_csr_mul_cb, &settings);
+    data.alpha = delta_new / cg_csr_sum_chunks(data.dot_a, num_chunks);
+
+    BLI_task_parallel_range(0, num_chunks, &data, cg_csr_update_cb, &settings);
+    delta_old = delta_new;
+    delta_new = cg_csr_sum_chunks(data.dot_a, num_chunks);
+
+    data.beta = delta_new / delta_old;
+    BLI_task_parallel_range(0, num_chunks, &data, cg_csr_direction_cb, &settings);
+
+    conjgrad_loopcount++;
+  }
+
+  del_lfvector(data.r);
+  del_lfvector(data.c);
+  del_lfvector(data.q);
+  del_lfvector(data.s);
+  MEM_freeN(data.dot_a);
+  MEM_freeN(data.dot_b);
+
+  result->status = conjgrad_loopcount < conjgrad_looplimit ? BPH_SOLVER_SUCCESS :
+                                                             BPH_SOLVER_NO_CONVERGENCE;
+  result->iterations = conjgrad_loopcount;
+  result->error = delta0 > 0.0f ? sqrtf(delta_new / delta0) : 0.0f;
+
+  return conjgrad_loopcount < conjgrad_looplimit;
+}
+
 #  if 0
 // block diagonalizer
 DO_INLINE void BuildPPinv(fmatrix3x3 *lA, fmatrix3x3 *P, fmatrix3x3 *Pinv)
@@ -1159,13 +1509,18 @@ bool BPH_mass_spring_solve_velocities(Implicit_Data *data, float dt, ImplicitSol
 #  endif
 
   /* Conjugate gradient algorithm to solve Ax=b. */
-  cg_filtered(data->dV, data->A, data->B, data->z, data->S, result);
+  if (data->linear_solver == CLOTH_LINEAR_SOLVER_BLOCK_CSR && data->csr != NULL) {
+    cg_filtered_block_csr(data, data->num_blocks, result);
+  }
+  else {
+    cg_filtered(data->dV, data->A, data->B, data->z, data->S, result);
+  }
 
   // cg_filtered_pre(id->dV, id->A, id->B, id->z, id->S, id->P, id->Pinv, id->bigI);
 
 #  ifdef DEBUG_TIME
   double end = PIL_check_seconds_timer();
-  printf("cg_filtered calc time: %f\n", (float)(end - start));
+  printf("cg_filtered calc time: %f, iterations: %d\n", (float)(end - start), result->iterations);
 #  endif
 
   // advance velocities
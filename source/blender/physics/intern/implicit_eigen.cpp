@@ -473,6 +473,13 @@ void BPH_mass_spring_solver_free(Implicit_Data *id)
   }
 }
 
+void BPH_mass_spring_solver_set_method(Implicit_Data *UNUSED(id),
+                                       int UNUSED(linear_solver),
+                                       int UNUSED(preconditioner))
+{
+  /* Eigen uses its own constrained CG solver, there is nothing to select. */
+}
+
 int BPH_mass_spring_solver_numvert(Implicit_Data *id)
 {
   if (id) {
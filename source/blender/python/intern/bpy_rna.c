@@ -70,6 +70,7 @@
 /* Only for types. */
 #include "BKE_node.h"
 
+#include "DEG_depsgraph.h"
 #include "DEG_depsgraph_query.h"
 
 #include "../generic/idprop_py_api.h" /* For IDprop lookups. */
@@ -5424,6 +5425,269 @@ static PyObject *pyrna_prop_collection_foreach_set(BPy_PropertyRNA *self, PyObje
   return foreach_getset(self, args, 1);
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Collection Buffer View
+ *
+ * Exposes the raw array behind a collection attribute (mesh vertex coordinates for e.g.)
+ * through the Python buffer protocol. Every export is a single copy of the array, written back
+ * when the buffer is released, so it stays valid when the collection is resized or freed
+ * while the buffer is in use.
+ * \{ */
+
+typedef struct BPy_PropertyCollectionViewRNA {
+  PyObject_HEAD
+  /**
+   * The collection the data is looked up from, the view can't be used once it's invalidated
+   * (see #pyrna_invalidate), the data itself is owned by its ID.
+   */
+  BPy_PropertyRNA *collection;
+  PropertyRNA *itemprop;
+  /** Don't allow writing, releasing the buffer doesn't run any update then. */
+  bool readonly;
+
+  /** The array when the view was created, checked every time the data is accessed. */
+  void *array;
+  /** Stride of the items in #BPy_PropertyCollectionViewRNA.array. */
+  Py_ssize_t array_stride;
+  int ndim;
+  Py_ssize_t itemsize;
+  Py_ssize_t shape[2];
+  Py_ssize_t strides[2];
+  char format[2];
+} BPy_PropertyCollectionViewRNA;
+
+static PyTypeObject pyrna_prop_collection_view_Type = BLANK_PYTHON_TYPE;
+
+static char foreach_raw_type_format(RawPropertyType raw_type, bool attr_signed)
+{
+  switch (raw_type) {
+    case PROP_RAW_CHAR:
+      return attr_signed ? 'b' : 'B';
+    case PROP_RAW_SHORT:
+      return attr_signed ? 'h' : 'H';
+    case PROP_RAW_INT:
+      return attr_signed ? 'i' : 'I';
+    case PROP_RAW_BOOLEAN:
+      return '?';
+    case PROP_RAW_FLOAT:
+      return 'f';
+    case PROP_RAW_DOUBLE:
+      return 'd';
+    case PROP_RAW_UNSET:
+      break;
+  }
+  return '\0';
+}
+
+/**
+ * Check the collection still exists and its array is the one the view was created for,
+ * it's reallocated when the collection is resized for e.g.
+ */
+static bool pyrna_prop_collection_view_is_valid(BPy_PropertyCollectionViewRNA *self)
+{
+  BPy_PropertyRNA *collection = self->collection;
+  RawArray raw;
+
+  if (collection->ptr.type == NULL) {
+    return false;
+  }
+  if (self->array == NULL) {
+    return (RNA_property_collection_length(&collection->ptr, collection->prop) == 0);
+  }
+  return (RNA_property_collection_raw_array(
+              &collection->ptr, collection->prop, self->itemprop, &raw) &&
+          (raw.array == self->array) && (raw.len == self->shape[0]));
+}
+
+static int pyrna_prop_collection_view_getbuffer(BPy_PropertyCollectionViewRNA *self,
+                                                Py_buffer *view,
+                                                int flags)
+{
+  const Py_ssize_t row_size = self->strides[0];
+  void *data = NULL;
+
+  if (pyrna_prop_validity_check(self->collection) == -1) {
+    return -1;
+  }
+  if (!pyrna_prop_collection_view_is_valid(self)) {
+    PyErr_SetString(PyExc_BufferError,
+                    "foreach_view: the collection data has changed, call foreach_view() again");
+    return -1;
+  }
+  if (self->readonly && (flags & PyBUF_WRITABLE)) {
+    PyErr_SetString(PyExc_BufferError, "foreach_view: buffer is read-only");
+    return -1;
+  }
+
+  if (self->array) {
+    const char *src = self->array;
+    char *dst = data = MEM_mallocN((size_t)(row_size * self->shape[0]), __func__);
+    for (Py_ssize_t i = 0; i < self->shape[0]; i++) {
+      memcpy(&dst[i * row_size], &src[i * self->array_stride], (size_t)row_size);
+    }
+  }
+
+  view->obj = (PyObject *)self;
+  Py_INCREF(self);
+  /* Python expects a valid pointer, even for an empty buffer. */
+  view->buf = data ? data : (void *)self->shape;
+  view->itemsize = self->itemsize;
+  view->len = row_size * self->shape[0];
+  view->readonly = self->readonly;
+  view->format = (flags & PyBUF_FORMAT) ? self->format : NULL;
+  view->ndim = self->ndim;
+  view->shape = (flags & PyBUF_ND) ? self->shape : NULL;
+  view->strides = ((flags & PyBUF_STRIDES) == PyBUF_STRIDES) ? self->strides : NULL;
+  view->suboffsets = NULL;
+  view->internal = data;
+  return 0;
+}
+
+static void pyrna_prop_collection_view_releasebuffer(BPy_PropertyCollectionViewRNA *self,
+                                                     Py_buffer *view)
+{
+  BPy_PropertyRNA *collection = self->collection;
+  const Py_ssize_t row_size = self->strides[0];
+  const char *src = view->internal;
+  PointerRNA itemptr;
+  bContext *C;
+
+  if (src == NULL) {
+    return;
+  }
+
+  /* A writable buffer may have been written to, copy it back and run the update of the
+   * attribute. Nothing is written when the data was freed or reallocated in the meantime. */
+  if (self->readonly || !pyrna_prop_collection_view_is_valid(self) ||
+      !RNA_property_collection_lookup_int(&collection->ptr, collection->prop, 0, &itemptr)) {
+    MEM_freeN(view->internal);
+    return;
+  }
+
+  char *dst = self->array;
+  for (Py_ssize_t i = 0; i < self->shape[0]; i++) {
+    memcpy(&dst[i * self->array_stride], &src[i * row_size], (size_t)row_size);
+  }
+  MEM_freeN(view->internal);
+
+  C = BPy_GetContext();
+  if (C && RNA_property_update_check(self->itemprop)) {
+    RNA_property_update(C, &itemptr, self->itemprop);
+  }
+  else if (itemptr.owner_id) {
+    DEG_id_tag_update(itemptr.owner_id, 0);
+  }
+}
+
+static void pyrna_prop_collection_view_dealloc(BPy_PropertyCollectionViewRNA *self)
+{
+  Py_DECREF(self->collection);
+  PyObject_DEL(self);
+}
+
+static PyBufferProcs pyrna_prop_collection_view_as_buffer = {
+    (getbufferproc)pyrna_prop_collection_view_getbuffer,
+    (releasebufferproc)pyrna_prop_collection_view_releasebuffer,
+};
+
+PyDoc_STRVAR(
+    pyrna_prop_collection_foreach_view_doc,
+    ".. method:: foreach_view(attr, readonly=False)\n"
+    "\n"
+    "   Access an attribute of all items in the collection without copying.\n"
+    "\n"
+    "   :arg attr: The attribute, only attributes stored in a single array are supported,\n"
+    "      other attributes raise an :class:`AttributeError`, "
+    "use :class:`foreach_get` and :class:`foreach_set` for those.\n"
+    "   :type attr: string\n"
+    "   :arg readonly: Only allow reading the attribute, no update is run then.\n"
+    "   :type readonly: bool\n"
+    "   :return: A copy of the attribute, with one row per item for array attributes.\n"
+    "      Releasing a writable view (:class:`memoryview.release` or a ``with`` statement) "
+    "writes it back and runs the update of the attribute.\n"
+    "      Nothing is written back when the collection was resized or its data freed "
+    "in the meantime.\n"
+    "   :rtype: :class:`memoryview`\n");
+static PyObject *pyrna_prop_collection_foreach_view(BPy_PropertyRNA *self,
+                                                    PyObject *args,
+                                                    PyObject *kw)
+{
+  BPy_PropertyCollectionViewRNA *view;
+  PyObject *ret;
+  const char *attr;
+  bool readonly = false;
+  PointerRNA itemptr_base;
+  PropertyRNA *itemprop;
+  RawArray raw;
+  int attr_tot;
+
+  static const char *const _keywords[] = {"attr", "readonly", NULL};
+  static _PyArg_Parser _parser = {"s|$O&:foreach_view", _keywords, 0};
+
+  PYRNA_PROP_CHECK_OBJ(self);
+
+  if (!_PyArg_ParseTupleAndKeywordsFast(args, kw, &_parser, &attr, PyC_ParseBool, &readonly)) {
+    return NULL;
+  }
+
+  RNA_pointer_create(NULL, RNA_property_pointer_type(&self->ptr, self->prop), NULL, &itemptr_base);
+  itemprop = RNA_struct_find_property(&itemptr_base, attr);
+  if (itemprop == NULL) {
+    PyErr_Format(PyExc_AttributeError,
+                 "foreach_view '%.200s.%.200s[...]' elements have no attribute '%.200s'",
+                 RNA_struct_identifier(self->ptr.type),
+                 RNA_property_identifier(self->prop),
+                 attr);
+    return NULL;
+  }
+
+  if ((RNA_property_flag(itemprop) & PROP_DYNAMIC) ||
+      !RNA_property_collection_raw_array(&self->ptr, self->prop, itemprop, &raw)) {
+    PyErr_Format(PyExc_AttributeError,
+                 "foreach_view '%.200s.%.200s[...].%.200s' can't be accessed directly, "
+                 "use foreach_get/set instead",
+                 RNA_struct_identifier(self->ptr.type),
+                 RNA_property_identifier(self->prop),
+                 attr);
+    return NULL;
+  }
+
+  /* The type of an empty collection isn't set, use the one of the attribute. */
+  raw.type = RNA_property_raw_type(itemprop);
+  attr_tot = RNA_property_array_length(&itemptr_base, itemprop);
+
+  view = PyObject_New(BPy_PropertyCollectionViewRNA, &pyrna_prop_collection_view_Type);
+  view->collection = self;
+  Py_INCREF(self);
+  view->itemprop = itemprop;
+  view->readonly = readonly;
+
+  view->array = (raw.len != 0) ? raw.array : NULL;
+  view->itemsize = RNA_raw_type_sizeof(raw.type);
+  view->format[0] = foreach_raw_type_format(
+      raw.type, RNA_property_subtype(itemprop) != PROP_UNSIGNED);
+  view->format[1] = '\0';
+  view->shape[0] = raw.len;
+  view->array_stride = raw.stride;
+  /* The exported copy is contiguous. */
+  view->strides[0] = view->itemsize * MAX2(attr_tot, 1);
+  if (attr_tot == 0) {
+    view->ndim = 1;
+  }
+  else {
+    view->ndim = 2;
+    view->shape[1] = attr_tot;
+    view->strides[1] = view->itemsize;
+  }
+
+  /* The memory-view holds the only reference to the view. */
+  ret = PyMemoryView_FromObject((PyObject *)view);
+  Py_DECREF(view);
+  return ret;
+}
+
+/** \} */
+
 /* A bit of a kludge, make a list out of a collection or array,
  * then return the list's iter function, not especially fast, but convenient for now. */
 static PyObject *pyrna_prop_array_iter(BPy_PropertyArrayRNA *self)
@@ -5584,6 +5848,10 @@ static struct PyMethodDef pyrna_prop_collection_methods[] = {
      (PyCFunction)pyrna_prop_collection_foreach_set,
      METH_VARARGS,
      pyrna_prop_collection_foreach_set_doc},
+    {"foreach_view",
+     (PyCFunction)pyrna_prop_collection_foreach_view,
+     METH_VARARGS | METH_KEYWORDS,
+     pyrna_prop_collection_foreach_view_doc},
 
     {"keys", (PyCFunction)pyrna_prop_collection_keys, METH_NOARGS, pyrna_prop_collection_keys_doc},
     {"items",
@@ -7451,6 +7719,15 @@ void BPY_rna_init(void)
     return;
   }
 #endif
+
+  pyrna_prop_collection_view_Type.tp_name = "bpy_prop_collection_view";
+  pyrna_prop_collection_view_Type.tp_basicsize = sizeof(BPy_PropertyCollectionViewRNA);
+  pyrna_prop_collection_view_Type.tp_dealloc = (destructor)pyrna_prop_collection_view_dealloc;
+  pyrna_prop_collection_view_Type.tp_as_buffer = &pyrna_prop_collection_view_as_buffer;
+  pyrna_prop_collection_view_Type.tp_flags = Py_TPFLAGS_DEFAULT;
+  if (PyType_Ready(&pyrna_prop_collection_view_Type) < 0) {
+    return;
+  }
 }
 
 /* 'bpy.data' from Python. */
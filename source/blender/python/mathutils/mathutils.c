@@ -476,6 +476,77 @@ int mathutils_array_parse_alloc_viseq(
   return size;
 }
 
+/**
+ * Get a contiguous buffer of 32 bit floats (\a format 'f') or ints (\a format 'i'),
+ * holding items of \a item_len values each, for batch operations which avoid creating
+ * Python objects for every value.
+ *
+ * \param len: The number of items the buffer must hold, -1 for any.
+ * \return The number of items or -1 on error, otherwise the buffer must be released.
+ */
+int mathutils_buffer_get(PyObject *value,
+                         Py_buffer *r_buffer,
+                         const char format,
+                         const int item_len,
+                         const int len,
+                         const int writable,
+                         const char *error_prefix)
+{
+  const int flags = PyBUF_C_CONTIGUOUS | PyBUF_FORMAT | (writable ? PyBUF_WRITABLE : 0);
+  const char *buffer_format;
+  Py_ssize_t buffer_len;
+
+  BLI_assert(ELEM(format, 'f', 'i'));
+
+  if (PyObject_GetBuffer(value, r_buffer, flags) == -1) {
+    PyErr_Format(PyExc_TypeError,
+                 "%.200s: expected a contiguous%s buffer, not a '%.200s'",
+                 error_prefix,
+                 writable ? " writable" : "",
+                 Py_TYPE(value)->tp_name);
+    return -1;
+  }
+
+  /* Skip the native byte order prefix. */
+  buffer_format = r_buffer->format ? r_buffer->format : "B";
+  if (ELEM(buffer_format[0], '@', '=')) {
+    buffer_format++;
+  }
+
+  if (r_buffer->itemsize != 4 || buffer_format[0] == '\0' || buffer_format[1] != '\0' ||
+      ((format == 'f') ? (buffer_format[0] != 'f') : !ELEM(buffer_format[0], 'i', 'l'))) {
+    PyErr_Format(PyExc_TypeError,
+                 "%.200s: expected a buffer of 32 bit %s, not format '%.200s'",
+                 error_prefix,
+                 (format == 'f') ? "floats" : "ints",
+                 r_buffer->format ? r_buffer->format : "B");
+    PyBuffer_Release(r_buffer);
+    return -1;
+  }
+
+  buffer_len = r_buffer->len / r_buffer->itemsize;
+  if (buffer_len % item_len != 0) {
+    PyErr_Format(PyExc_ValueError,
+                 "%.200s: buffer size %zd is not a multiple of %d",
+                 error_prefix,
+                 buffer_len,
+                 item_len);
+    PyBuffer_Release(r_buffer);
+    return -1;
+  }
+  if (len != -1 && buffer_len != (Py_ssize_t)len * item_len) {
+    PyErr_Format(PyExc_ValueError,
+                 "%.200s: buffer holds %zd items, expected %d",
+                 error_prefix,
+                 buffer_len / item_len,
+                 len);
+    PyBuffer_Release(r_buffer);
+    return -1;
+  }
+
+  return (int)(buffer_len / item_len);
+}
+
 int mathutils_any_to_rotmat(float rmat[3][3], PyObject *value, const char *error_prefix)
 {
   if (EulerObject_Check(value)) {
@@ -177,6 +177,13 @@ int mathutils_array_parse_alloc_vi(int **array,
                                    const char *error_prefix);
 int mathutils_array_parse_alloc_viseq(
     int **array, int **start_table, int **len_table, PyObject *value, const char *error_prefix);
+int mathutils_buffer_get(PyObject *value,
+                         Py_buffer *r_buffer,
+                         const char format,
+                         const int item_len,
+                         const int len,
+                         const int writable,
+                         const char *error_prefix);
 int mathutils_any_to_rotmat(float rmat[3][3], PyObject *value, const char *error_prefix);
 
 Py_hash_t mathutils_array_hash(const float *float_array, size_t array_len);
@@ -31,6 +31,7 @@
 #include "BLI_math.h"
 #include "BLI_ghash.h"
 #include "BLI_memarena.h"
+#include "BLI_task.h"
 
 #include "BKE_bvhutils.h"
 
@@ -502,6 +503,359 @@ static PyObject *py_bvhtree_find_nearest_range(PyBVHTree *self, PyObject *args)
   return ret;
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Batch Queries
+ *
+ * Run many queries from buffers in one call, on multiple threads without the GIL.
+ * \{ */
+
+#define PYBVH_BATCH_GENERIC_OUTPUT_DOC \
+  "   :arg indices: Output index of the element found for each query, -1 if there is none.\n" \
+  "   :type indices: writable buffer of 32 bit ints\n" \
+  "   :arg locations: Optional output location of each result.\n" \
+  "   :type locations: writable buffer of 32 bit floats, 3 for each query\n" \
+  "   :arg normals: Optional output normal of each result.\n" \
+  "   :type normals: writable buffer of 32 bit floats, 3 for each query\n" \
+  "   :arg distances: Optional output distance of each result.\n" \
+  "   :type distances: writable buffer of 32 bit floats\n" \
+  "   :return: The number of queries with a result, the outputs of the others are zero.\n" \
+  "   :rtype: int\n"
+
+/* Number of queries before using threads. */
+#define PYBVH_BATCH_THREADED_MIN 256
+
+enum {
+  PYBVH_BATCH_INDICES = 0,
+  PYBVH_BATCH_LOCATIONS,
+  PYBVH_BATCH_NORMALS,
+  PYBVH_BATCH_DISTANCES,
+  PYBVH_BATCH_OUTPUT_NUM,
+};
+
+typedef struct PyBVH_BatchOutput {
+  Py_buffer buffers[PYBVH_BATCH_OUTPUT_NUM];
+  bool is_set[PYBVH_BATCH_OUTPUT_NUM];
+
+  int *indices;
+  float (*locations)[3];
+  float (*normals)[3];
+  float *distances;
+} PyBVH_BatchOutput;
+
+static void py_bvhtree_batch_output_release(PyBVH_BatchOutput *output)
+{
+  for (int i = 0; i < PYBVH_BATCH_OUTPUT_NUM; i++) {
+    if (output->is_set[i]) {
+      PyBuffer_Release(&output->buffers[i]);
+    }
+  }
+}
+
+/**
+ * Get the output buffers, which must all hold \a len items.
+ * On failure the buffers which were already acquired are released.
+ */
+static bool py_bvhtree_batch_output_get(PyBVH_BatchOutput *output,
+                                        PyObject *py_outputs[PYBVH_BATCH_OUTPUT_NUM],
+                                        const int len,
+                                        const char *error_prefix)
+{
+  const int item_len[PYBVH_BATCH_OUTPUT_NUM] = {1, 3, 3, 1};
+  const char format[PYBVH_BATCH_OUTPUT_NUM] = {'i', 'f', 'f', 'f'};
+  void *arrays[PYBVH_BATCH_OUTPUT_NUM] = {NULL};
+
+  memset(output, 0, sizeof(*output));
+
+  /* Always written to, and used to count the results. */
+  if (py_outputs[PYBVH_BATCH_INDICES] == Py_None) {
+    PyErr_Format(PyExc_TypeError, "%.200s: indices must be a buffer, not None", error_prefix);
+    return false;
+  }
+
+  for (int i = 0; i < PYBVH_BATCH_OUTPUT_NUM; i++) {
+    if (py_outputs[i] == NULL || py_outputs[i] == Py_None) {
+      continue;
+    }
+    if (mathutils_buffer_get(
+            py_outputs[i], &output->buffers[i], format[i], item_len[i], len, true, error_prefix) ==
+        -1) {
+      py_bvhtree_batch_output_release(output);
+      return false;
+    }
+    output->is_set[i] = true;
+    arrays[i] = output->buffers[i].buf;
+  }
+
+  output->indices = arrays[PYBVH_BATCH_INDICES];
+  output->locations = arrays[PYBVH_BATCH_LOCATIONS];
+  output->normals = arrays[PYBVH_BATCH_NORMALS];
+  output->distances = arrays[PYBVH_BATCH_DISTANCES];
+  return true;
+}
+
+static void py_bvhtree_batch_output_set(PyBVH_BatchOutput *output,
+                                        const int i,
+                                        const int index,
+                                        const float co[3],
+                                        const float no[3],
+                                        const float dist)
+{
+  output->indices[i] = index;
+  if (output->locations) {
+    copy_v3_v3(output->locations[i], co);
+  }
+  if (output->normals) {
+    copy_v3_v3(output->normals[i], no);
+  }
+  if (output->distances) {
+    output->distances[i] = dist;
+  }
+}
+
+static void py_bvhtree_batch_output_set_none(PyBVH_BatchOutput *output, const int i)
+{
+  output->indices[i] = -1;
+  if (output->locations) {
+    zero_v3(output->locations[i]);
+  }
+  if (output->normals) {
+    zero_v3(output->normals[i]);
+  }
+  if (output->distances) {
+    output->distances[i] = 0.0f;
+  }
+}
+
+static int py_bvhtree_batch_output_hits(const PyBVH_BatchOutput *output, const int len)
+{
+  int hits = 0;
+  for (int i = 0; i < len; i++) {
+    if (output->indices[i] != -1) {
+      hits++;
+    }
+  }
+  return hits;
+}
+
+typedef struct PyBVH_BatchData {
+  PyBVHTree *self;
+  const float (*co)[3];
+  const float (*direction)[3];
+  /** When false a single direction is used for all rays. */
+  bool use_direction_array;
+  float max_dist;
+  PyBVH_BatchOutput *output;
+} PyBVH_BatchData;
+
+static void py_bvhtree_ray_cast_batch_cb(void *__restrict userdata,
+                                         const int i,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  PyBVH_BatchData *data = userdata;
+  BVHTreeRayHit hit;
+  float direction[3];
+
+  normalize_v3_v3(direction, data->direction[data->use_direction_array ? i : 0]);
+
+  hit.dist = data->max_dist;
+  hit.index = -1;
+
+  if (data->self->tree && BLI_bvhtree_ray_cast(data->self->tree,
+                                               data->co[i],
+                                               direction,
+                                               0.0f,
+                                               &hit,
+                                               py_bvhtree_raycast_cb,
+                                               data->self) != -1) {
+    py_bvhtree_batch_output_set(data->output, i, hit.index, hit.co, hit.no, hit.dist);
+  }
+  else {
+    py_bvhtree_batch_output_set_none(data->output, i);
+  }
+}
+
+PyDoc_STRVAR(py_bvhtree_ray_cast_batch_doc,
+             ".. method:: ray_cast_batch(origins, directions, indices, locations=None, "
+             "normals=None, distances=None, distance=sys.float_info.max)\n"
+             "\n"
+             "   Cast many rays onto the mesh, on multiple threads.\n"
+             "\n"
+             "   :arg origins: Start location of the rays in object space.\n"
+             "   :type origins: buffer of 32 bit floats, 3 for each ray\n"
+             "   :arg directions: Direction of the rays in object space, "
+             "or a single direction for all rays.\n"
+             "   :type directions: buffer of 32 bit floats, 3 for each ray\n"
+             PYBVH_BATCH_GENERIC_OUTPUT_DOC PYBVH_FIND_GENERIC_DISTANCE_DOC);
+static PyObject *py_bvhtree_ray_cast_batch(PyBVHTree *self, PyObject *args, PyObject *kwargs)
+{
+  const char *error_prefix = "ray_cast_batch";
+  const char *keywords[] = {
+      "origins", "directions", "indices", "locations", "normals", "distances", "distance", NULL};
+  PyObject *py_co, *py_direction;
+  PyObject *py_outputs[PYBVH_BATCH_OUTPUT_NUM] = {NULL};
+  Py_buffer co_buf, direction_buf;
+  PyBVH_BatchOutput output;
+  float max_dist = FLT_MAX;
+  int len, direction_len, hits;
+
+  if (!PyArg_ParseTupleAndKeywords(args,
+                                   kwargs,
+                                   "OOO|OOOf:ray_cast_batch",
+                                   (char **)keywords,
+                                   &py_co,
+                                   &py_direction,
+                                   &py_outputs[PYBVH_BATCH_INDICES],
+                                   &py_outputs[PYBVH_BATCH_LOCATIONS],
+                                   &py_outputs[PYBVH_BATCH_NORMALS],
+                                   &py_outputs[PYBVH_BATCH_DISTANCES],
+                                   &max_dist)) {
+    return NULL;
+  }
+
+  if ((len = mathutils_buffer_get(py_co, &co_buf, 'f', 3, -1, false, error_prefix)) == -1) {
+    return NULL;
+  }
+  if ((direction_len = mathutils_buffer_get(
+           py_direction, &direction_buf, 'f', 3, -1, false, error_prefix)) == -1) {
+    PyBuffer_Release(&co_buf);
+    return NULL;
+  }
+  if (!ELEM(direction_len, 1, len)) {
+    PyErr_Format(PyExc_ValueError,
+                 "%.200s: %d directions given for %d rays",
+                 error_prefix,
+                 direction_len,
+                 len);
+    PyBuffer_Release(&co_buf);
+    PyBuffer_Release(&direction_buf);
+    return NULL;
+  }
+  if (!py_bvhtree_batch_output_get(&output, py_outputs, len, error_prefix)) {
+    PyBuffer_Release(&co_buf);
+    PyBuffer_Release(&direction_buf);
+    return NULL;
+  }
+
+  PyBVH_BatchData data = {
+      .self = self,
+      .co = co_buf.buf,
+      .direction = direction_buf.buf,
+      .use_direction_array = (direction_len != 1),
+      .max_dist = max_dist,
+      .output = &output,
+  };
+
+  Py_BEGIN_ALLOW_THREADS;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (len > PYBVH_BATCH_THREADED_MIN);
+  BLI_task_parallel_range(0, len, &data, py_bvhtree_ray_cast_batch_cb, &settings);
+
+  Py_END_ALLOW_THREADS;
+
+  hits = py_bvhtree_batch_output_hits(&output, len);
+
+  py_bvhtree_batch_output_release(&output);
+  PyBuffer_Release(&co_buf);
+  PyBuffer_Release(&direction_buf);
+
+  return PyLong_FromLong(hits);
+}
+
+static void py_bvhtree_find_nearest_batch_cb(void *__restrict userdata,
+                                             const int i,
+                                             const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  PyBVH_BatchData *data = userdata;
+  BVHTreeNearest nearest;
+
+  nearest.index = -1;
+  nearest.dist_sq = data->max_dist * data->max_dist;
+
+  if (data->self->tree && BLI_bvhtree_find_nearest(data->self->tree,
+                                                   data->co[i],
+                                                   &nearest,
+                                                   py_bvhtree_nearest_point_cb,
+                                                   data->self) != -1) {
+    py_bvhtree_batch_output_set(
+        data->output, i, nearest.index, nearest.co, nearest.no, sqrtf(nearest.dist_sq));
+  }
+  else {
+    py_bvhtree_batch_output_set_none(data->output, i);
+  }
+}
+
+PyDoc_STRVAR(py_bvhtree_find_nearest_batch_doc,
+             ".. method:: find_nearest_batch(origins, indices, locations=None, normals=None, "
+             "distances=None, distance=" PYBVH_MAX_DIST_STR
+             ")\n"
+             "\n"
+             "   Find the nearest element (typically face index) to many points, "
+             "on multiple threads.\n"
+             "\n"
+             "   :arg origins: Find nearest elements to these points.\n"
+             "   :type origins: buffer of 32 bit floats, 3 for each point\n"
+             PYBVH_BATCH_GENERIC_OUTPUT_DOC PYBVH_FIND_GENERIC_DISTANCE_DOC);
+static PyObject *py_bvhtree_find_nearest_batch(PyBVHTree *self, PyObject *args, PyObject *kwargs)
+{
+  const char *error_prefix = "find_nearest_batch";
+  const char *keywords[] = {
+      "origins", "indices", "locations", "normals", "distances", "distance", NULL};
+  PyObject *py_co;
+  PyObject *py_outputs[PYBVH_BATCH_OUTPUT_NUM] = {NULL};
+  Py_buffer co_buf;
+  PyBVH_BatchOutput output;
+  float max_dist = max_dist_default;
+  int len, hits;
+
+  if (!PyArg_ParseTupleAndKeywords(args,
+                                   kwargs,
+                                   "OO|OOOf:find_nearest_batch",
+                                   (char **)keywords,
+                                   &py_co,
+                                   &py_outputs[PYBVH_BATCH_INDICES],
+                                   &py_outputs[PYBVH_BATCH_LOCATIONS],
+                                   &py_outputs[PYBVH_BATCH_NORMALS],
+                                   &py_outputs[PYBVH_BATCH_DISTANCES],
+                                   &max_dist)) {
+    return NULL;
+  }
+
+  if ((len = mathutils_buffer_get(py_co, &co_buf, 'f', 3, -1, false, error_prefix)) == -1) {
+    return NULL;
+  }
+  if (!py_bvhtree_batch_output_get(&output, py_outputs, len, error_prefix)) {
+    PyBuffer_Release(&co_buf);
+    return NULL;
+  }
+
+  PyBVH_BatchData data = {
+      .self = self,
+      .co = co_buf.buf,
+      .max_dist = max_dist,
+      .output = &output,
+  };
+
+  Py_BEGIN_ALLOW_THREADS;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (len > PYBVH_BATCH_THREADED_MIN);
+  BLI_task_parallel_range(0, len, &data, py_bvhtree_find_nearest_batch_cb, &settings);
+
+  Py_END_ALLOW_THREADS;
+
+  hits = py_bvhtree_batch_output_hits(&output, len);
+
+  py_bvhtree_batch_output_release(&output);
+  PyBuffer_Release(&co_buf);
+
+  return PyLong_FromLong(hits);
+}
+
+/** \} */
+
 BLI_INLINE uint overlap_hash(const void *overlap_v)
 {
   const BVHTreeOverlap *overlap = overlap_v;
@@ -1241,6 +1595,14 @@ static PyMethodDef py_bvhtree_methods[] = {
      (PyCFunction)py_bvhtree_find_nearest_range,
      METH_VARARGS,
      py_bvhtree_find_nearest_range_doc},
+    {"ray_cast_batch",
+     (PyCFunction)py_bvhtree_ray_cast_batch,
+     METH_VARARGS | METH_KEYWORDS,
+     py_bvhtree_ray_cast_batch_doc},
+    {"find_nearest_batch",
+     (PyCFunction)py_bvhtree_find_nearest_batch,
+     METH_VARARGS | METH_KEYWORDS,
+     py_bvhtree_find_nearest_batch_doc},
     {"overlap", (PyCFunction)py_bvhtree_overlap, METH_O, py_bvhtree_overlap_doc},
 
     /* class methods */
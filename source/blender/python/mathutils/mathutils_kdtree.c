@@ -27,6 +27,8 @@
 
 #include "BLI_utildefines.h"
 #include "BLI_kdtree.h"
+#include "BLI_math_vector.h"
+#include "BLI_task.h"
 
 #include "../generic/py_capi_utils.h"
 #include "../generic/python_utildefines.h"
@@ -41,6 +43,7 @@ typedef struct {
   uint maxsize;
   uint count;
   uint count_balance; /* size when we last balanced */
+  uint busy;          /* number of queries running without the GIL */
 } PyKDTree;
 
 /* -------------------------------------------------------------------- */
@@ -108,6 +111,7 @@ static int PyKDTree__tp_init(PyKDTree *self, PyObject *args, PyObject *kwargs)
   self->maxsize = maxsize;
   self->count = 0;
   self->count_balance = 0;
+  self->busy = 0;
 
   return 0;
 }
@@ -147,6 +151,11 @@ static PyObject *py_kdtree_insert(PyKDTree *self, PyObject *args, PyObject *kwar
     return NULL;
   }
 
+  if (self->busy) {
+    PyErr_SetString(PyExc_RuntimeError, "KDTree can't be modified while find_batch() is running");
+    return NULL;
+  }
+
   if (self->count >= self->maxsize) {
     PyErr_SetString(PyExc_RuntimeError, "Trying to insert more items than KDTree has room for");
     return NULL;
@@ -168,6 +177,11 @@ PyDoc_STRVAR(py_kdtree_balance_doc,
              "   This builds the entire tree, avoid calling after each insertion.\n");
 static PyObject *py_kdtree_balance(PyKDTree *self)
 {
+  if (self->busy) {
+    PyErr_SetString(PyExc_RuntimeError, "KDTree can't be modified while find_batch() is running");
+    return NULL;
+  }
+
   BLI_kdtree_3d_balance(self->obj);
   self->count_balance = self->count;
   Py_RETURN_NONE;
@@ -366,6 +380,149 @@ static PyObject *py_kdtree_find_range(PyKDTree *self, PyObject *args, PyObject *
   return py_list;
 }
 
+/* Number of queries before using threads. */
+#define PYKDTREE_BATCH_THREADED_MIN 256
+
+struct PyKDTree_BatchData {
+  const KDTree_3d *tree;
+  const float (*co)[3];
+  int *r_indices;
+  float (*r_co)[3];
+  float *r_dist;
+};
+
+static void py_kdtree_find_batch_cb(void *__restrict userdata,
+                                    const int i,
+                                    const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  struct PyKDTree_BatchData *data = userdata;
+  KDTreeNearest_3d nearest;
+
+  if (BLI_kdtree_3d_find_nearest(data->tree, data->co[i], &nearest) == -1) {
+    nearest.index = -1;
+    zero_v3(nearest.co);
+    nearest.dist = 0.0f;
+  }
+
+  data->r_indices[i] = nearest.index;
+  if (data->r_co) {
+    copy_v3_v3(data->r_co[i], nearest.co);
+  }
+  if (data->r_dist) {
+    data->r_dist[i] = nearest.dist;
+  }
+}
+
+PyDoc_STRVAR(py_kdtree_find_batch_doc,
+             ".. method:: find_batch(co, indices, locations=None, distances=None)\n"
+             "\n"
+             "   Find the nearest point to many coordinates, on multiple threads.\n"
+             "\n"
+             "   :arg co: 3d coordinates.\n"
+             "   :type co: buffer of 32 bit floats, 3 for each point\n"
+             "   :arg indices: Output index of the nearest point, -1 if the tree is empty.\n"
+             "   :type indices: writable buffer of 32 bit ints\n"
+             "   :arg locations: Optional output location of the nearest point.\n"
+             "   :type locations: writable buffer of 32 bit floats, 3 for each point\n"
+             "   :arg distances: Optional output distance to the nearest point.\n"
+             "   :type distances: writable buffer of 32 bit floats\n"
+             "   :return: The number of coordinates a point was found for, the outputs of the "
+             "others are zero.\n"
+             "   :rtype: int\n");
+static PyObject *py_kdtree_find_batch(PyKDTree *self, PyObject *args, PyObject *kwargs)
+{
+  const char *error_prefix = "find_batch";
+  PyObject *py_co, *py_indices, *py_r_co = Py_None, *py_r_dist = Py_None;
+  Py_buffer co_buf, indices_buf, r_co_buf, r_dist_buf;
+  bool has_co = false, has_indices = false, has_r_co = false, has_r_dist = false;
+  PyObject *ret = NULL;
+  int len, found = 0;
+
+  const char *keywords[] = {"co", "indices", "locations", "distances", NULL};
+
+  if (!PyArg_ParseTupleAndKeywords(args,
+                                   kwargs,
+                                   "OO|OO:find_batch",
+                                   (char **)keywords,
+                                   &py_co,
+                                   &py_indices,
+                                   &py_r_co,
+                                   &py_r_dist)) {
+    return NULL;
+  }
+
+  if (self->count != self->count_balance) {
+    PyErr_SetString(PyExc_RuntimeError, "KDTree must be balanced before calling find_batch()");
+    return NULL;
+  }
+
+  if ((len = mathutils_buffer_get(py_co, &co_buf, 'f', 3, -1, false, error_prefix)) == -1) {
+    goto finally;
+  }
+  has_co = true;
+  if (mathutils_buffer_get(py_indices, &indices_buf, 'i', 1, len, true, error_prefix) == -1) {
+    goto finally;
+  }
+  has_indices = true;
+  if (py_r_co != Py_None) {
+    if (mathutils_buffer_get(py_r_co, &r_co_buf, 'f', 3, len, true, error_prefix) == -1) {
+      goto finally;
+    }
+    has_r_co = true;
+  }
+  if (py_r_dist != Py_None) {
+    if (mathutils_buffer_get(py_r_dist, &r_dist_buf, 'f', 1, len, true, error_prefix) == -1) {
+      goto finally;
+    }
+    has_r_dist = true;
+  }
+
+  struct PyKDTree_BatchData data = {
+      .tree = self->obj,
+      .co = co_buf.buf,
+      .r_indices = indices_buf.buf,
+      .r_co = has_r_co ? r_co_buf.buf : NULL,
+      .r_dist = has_r_dist ? r_dist_buf.buf : NULL,
+  };
+
+  /* Other threads can run Python code while the GIL is released,
+   * the counter is only changed while holding it. */
+  self->busy++;
+
+  Py_BEGIN_ALLOW_THREADS;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (len > PYKDTREE_BATCH_THREADED_MIN);
+  BLI_task_parallel_range(0, len, &data, py_kdtree_find_batch_cb, &settings);
+
+  Py_END_ALLOW_THREADS;
+
+  self->busy--;
+
+  for (int i = 0; i < len; i++) {
+    if (data.r_indices[i] != -1) {
+      found++;
+    }
+  }
+  ret = PyLong_FromLong(found);
+
+finally:
+  if (has_co) {
+    PyBuffer_Release(&co_buf);
+  }
+  if (has_indices) {
+    PyBuffer_Release(&indices_buf);
+  }
+  if (has_r_co) {
+    PyBuffer_Release(&r_co_buf);
+  }
+  if (has_r_dist) {
+    PyBuffer_Release(&r_dist_buf);
+  }
+  return ret;
+}
+
 static PyMethodDef PyKDTree_methods[] = {
     {"insert", (PyCFunction)py_kdtree_insert, METH_VARARGS | METH_KEYWORDS, py_kdtree_insert_doc},
     {"balance", (PyCFunction)py_kdtree_balance, METH_NOARGS, py_kdtree_balance_doc},
@@ -375,6 +532,10 @@ static PyMethodDef PyKDTree_methods[] = {
      (PyCFunction)py_kdtree_find_range,
      METH_VARARGS | METH_KEYWORDS,
      py_kdtree_find_range_doc},
+    {"find_batch",
+     (PyCFunction)py_kdtree_find_batch,
+     METH_VARARGS | METH_KEYWORDS,
+     py_kdtree_find_batch_doc},
     {NULL, NULL, 0, NULL},
 };
 
@@ -0,0 +1,68 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "BKE_armature_deform_scene.h"
+
+extern "C" {
+#include "BLI_threads.h"
+
+#include "BKE_idtype.h"
+#include "BKE_modifier.h"
+
+#include "PIL_time.h"
+}
+
+#define DEFORM_REPEAT 10
+
+static void armature_deform_performance_test(const int verts_len)
+{
+  BLI_threadapi_init();
+  BKE_idtype_init();
+  BKE_modifier_init();
+
+  ArmatureDeformScene scene;
+  armature_deform_scene_create(&scene, verts_len);
+
+  float(*coords_sequential)[3] = (float(*)[3])MEM_dupallocN(scene.vert_coords);
+  float(*coords_chain)[3] = (float(*)[3])MEM_dupallocN(scene.vert_coords);
+
+  printf("\n========== STARTING %s (%d vertices, %d modifiers) ==========\n",
+         __func__,
+         verts_len,
+         (int)DEFORM_SCENE_CHAIN_LEN);
+
+  double start = PIL_check_seconds_timer();
+  for (int i = 0; i < DEFORM_REPEAT; i++) {
+    memcpy(coords_sequential, scene.vert_coords, sizeof(float[3]) * verts_len);
+    armature_deform_scene_sequential(&scene, coords_sequential);
+  }
+  printf("\tSequential: %f seconds\n", (PIL_check_seconds_timer() - start) / DEFORM_REPEAT);
+
+  start = PIL_check_seconds_timer();
+  for (int i = 0; i < DEFORM_REPEAT; i++) {
+    memcpy(coords_chain, scene.vert_coords, sizeof(float[3]) * verts_len);
+    armature_deform_scene_chain_apply(&scene, coords_chain);
+  }
+  printf("\tDeform chain: %f seconds\n", (PIL_check_seconds_timer() - start) / DEFORM_REPEAT);
+
+  EXPECT_EQ(memcmp(coords_chain, coords_sequential, sizeof(float[3]) * verts_len), 0);
+
+  printf("========== ENDED %s ==========\n\n", __func__);
+
+  MEM_freeN(coords_sequential);
+  MEM_freeN(coords_chain);
+  armature_deform_scene_free(&scene);
+
+  BLI_threadapi_exit();
+}
+
+TEST(armature_deform, Chain_100k)
+{
+  armature_deform_performance_test(100000);
+}
+
+TEST(armature_deform, Chain_1M)
+{
+  armature_deform_performance_test(1000000);
+}
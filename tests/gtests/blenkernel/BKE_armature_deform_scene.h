@@ -0,0 +1,190 @@
+/* Apache License, Version 2.0 */
+
+#ifndef __BKE_ARMATURE_DEFORM_SCENE_H__
+#define __BKE_ARMATURE_DEFORM_SCENE_H__
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_listbase.h"
+#include "BLI_math.h"
+#include "BLI_rand.h"
+#include "BLI_string.h"
+
+#include "DNA_action_types.h"
+#include "DNA_armature_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "BKE_armature.h"
+#include "BKE_customdata.h"
+#include "BKE_deform.h"
+#include "BKE_lattice.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+#include "BKE_modifier.h"
+#include "BKE_object.h"
+#include "BKE_object_deform.h"
+}
+
+/* A posed chain of bones along the X axis, deforming a mesh of random points around it. Every
+ * point is weighted to the two nearest bones, which also lie within the bone envelopes. */
+
+#define DEFORM_SCENE_BONES 8
+
+typedef struct ArmatureDeformScene {
+  Main *bmain;
+  Object *ob_arm;
+  Object *ob_mesh;
+  float (*vert_coords)[3];
+  int verts_len;
+} ArmatureDeformScene;
+
+static void armature_deform_scene_bones_create(ArmatureDeformScene *scene)
+{
+  bArmature *arm = BKE_armature_add(scene->bmain, "Armature");
+  scene->ob_arm = BKE_object_add_only_object(scene->bmain, OB_ARMATURE, "Armature");
+  scene->ob_arm->data = arm;
+  unit_m4(scene->ob_arm->obmat);
+
+  for (int i = 0; i < DEFORM_SCENE_BONES; i++) {
+    Bone *bone = (Bone *)MEM_callocN(sizeof(Bone), __func__);
+    BLI_snprintf(bone->name, sizeof(bone->name), "Bone.%d", i);
+    const float head[3] = {(float)i, 0.0f, 0.0f};
+    const float tail[3] = {(float)(i + 1), 0.0f, 0.0f};
+    copy_v3_v3(bone->head, head);
+    copy_v3_v3(bone->tail, tail);
+    copy_v3_v3(bone->arm_head, head);
+    copy_v3_v3(bone->arm_tail, tail);
+    unit_m4(bone->arm_mat);
+    copy_v3_v3(bone->arm_mat[3], head);
+    bone->length = 1.0f;
+    bone->rad_head = bone->rad_tail = 0.25f;
+    bone->dist = 0.5f;
+    bone->weight = 1.0f;
+    bone->segments = 1;
+    BLI_addtail(&arm->bonebase, bone);
+  }
+
+  BKE_pose_rebuild(NULL, scene->ob_arm, arm, false);
+
+  /* Rotate every bone around its head, and lift it a little. */
+  int i = 0;
+  LISTBASE_FOREACH (bPoseChannel *, pchan, &scene->ob_arm->pose->chanbase) {
+    float rot[3][3], to_head[4][4], from_head[4][4], rot_mat[4][4];
+    axis_angle_to_mat3_single(rot, 'Z', 0.1f * (float)(i + 1));
+    copy_m4_m3(rot_mat, rot);
+    unit_m4(to_head);
+    unit_m4(from_head);
+    negate_v3_v3(to_head[3], pchan->bone->arm_head);
+    copy_v3_v3(from_head[3], pchan->bone->arm_head);
+    from_head[3][2] += 0.1f * (float)i;
+    mul_m4_series(pchan->chan_mat, from_head, rot_mat, to_head);
+    mat4_to_dquat(&pchan->runtime.deform_dual_quat, pchan->bone->arm_mat, pchan->chan_mat);
+    i++;
+  }
+}
+
+static void armature_deform_scene_mesh_create(ArmatureDeformScene *scene, const int verts_len)
+{
+  Mesh *me = BKE_mesh_add(scene->bmain, "Mesh");
+  scene->ob_mesh = BKE_object_add_only_object(scene->bmain, OB_MESH, "Mesh");
+  scene->ob_mesh->data = me;
+  unit_m4(scene->ob_mesh->obmat);
+
+  for (int i = 0; i < DEFORM_SCENE_BONES; i++) {
+    char name[64];
+    BLI_snprintf(name, sizeof(name), "Bone.%d", i);
+    BKE_object_defgroup_add_name(scene->ob_mesh, name);
+  }
+
+  me->totvert = verts_len;
+  me->dvert = (MDeformVert *)CustomData_add_layer(
+      &me->vdata, CD_MDEFORMVERT, CD_CALLOC, NULL, verts_len);
+
+  scene->verts_len = verts_len;
+  scene->vert_coords = (float(*)[3])MEM_mallocN(sizeof(float[3]) * verts_len, __func__);
+
+  RNG *rng = BLI_rng_new(0);
+  for (int i = 0; i < verts_len; i++) {
+    float *co = scene->vert_coords[i];
+    co[0] = BLI_rng_get_float(rng) * (float)DEFORM_SCENE_BONES;
+    co[1] = (BLI_rng_get_float(rng) - 0.5f) * 0.5f;
+    co[2] = (BLI_rng_get_float(rng) - 0.5f) * 0.5f;
+
+    const int bone = min_ii((int)co[0], DEFORM_SCENE_BONES - 1);
+    const float t = co[0] - (float)bone;
+    BKE_defvert_add_index_notest(&me->dvert[i], bone, 1.0f - 0.5f * t);
+    if (bone + 1 < DEFORM_SCENE_BONES) {
+      BKE_defvert_add_index_notest(&me->dvert[i], bone + 1, 0.5f * t);
+    }
+  }
+  BLI_rng_free(rng);
+}
+
+/* Deform flags of the modifier chain, one armature modifier each. */
+static const int armature_deform_scene_chain[] = {
+    ARM_DEF_VGROUP,
+    ARM_DEF_VGROUP | ARM_DEF_QUATERNION,
+    ARM_DEF_ENVELOPE,
+};
+#define DEFORM_SCENE_CHAIN_LEN ((int)ARRAY_SIZE(armature_deform_scene_chain))
+
+/* Add the armature modifiers of the chain to the mesh object. */
+static void armature_deform_scene_modifiers_create(ArmatureDeformScene *scene)
+{
+  for (int i = 0; i < DEFORM_SCENE_CHAIN_LEN; i++) {
+    ArmatureModifierData *amd = (ArmatureModifierData *)modifier_new(eModifierType_Armature);
+    amd->object = scene->ob_arm;
+    amd->deformflag = armature_deform_scene_chain[i];
+    BLI_addtail(&scene->ob_mesh->modifiers, amd);
+  }
+}
+
+static void armature_deform_scene_create(ArmatureDeformScene *scene, const int verts_len)
+{
+  scene->bmain = BKE_main_new();
+  armature_deform_scene_bones_create(scene);
+  armature_deform_scene_mesh_create(scene, verts_len);
+  armature_deform_scene_modifiers_create(scene);
+}
+
+static void armature_deform_scene_free(ArmatureDeformScene *scene)
+{
+  MEM_freeN(scene->vert_coords);
+  BKE_main_free(scene->bmain);
+}
+
+/* Apply the modifiers one at a time over all coordinates. */
+static void armature_deform_scene_sequential(const ArmatureDeformScene *scene,
+                                             float (*vert_coords)[3])
+{
+  const ModifierEvalContext mectx = {NULL, scene->ob_mesh, (ModifierApplyFlag)0};
+  Mesh *mesh = (Mesh *)scene->ob_mesh->data;
+
+  LISTBASE_FOREACH (ModifierData *, md, &scene->ob_mesh->modifiers) {
+    modwrap_deformVerts(md, &mectx, mesh, vert_coords, scene->verts_len);
+  }
+}
+
+/* Apply the modifiers as a deform chain, the way mesh modifier evaluation does: the whole chain
+ * deforms one block of vertices before moving on to the next block. */
+static void armature_deform_scene_chain_apply(const ArmatureDeformScene *scene,
+                                              float (*vert_coords)[3])
+{
+  const ModifierEvalContext mectx = {NULL, scene->ob_mesh, (ModifierApplyFlag)0};
+  Mesh *mesh = (Mesh *)scene->ob_mesh->data;
+  ModifierDeformChain chain = {NULL};
+
+  LISTBASE_FOREACH (ModifierData *, md, &scene->ob_mesh->modifiers) {
+    const bool added = modifier_deform_chain_add(&chain, md, mesh);
+    EXPECT_TRUE(added);
+  }
+  modifier_deform_chain_flush(&chain, &mectx, vert_coords, scene->verts_len);
+  modifier_deform_chain_free(&chain);
+}
+
+#endif /* __BKE_ARMATURE_DEFORM_SCENE_H__ */
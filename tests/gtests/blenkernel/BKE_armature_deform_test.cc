@@ -0,0 +1,59 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "BKE_armature_deform_scene.h"
+
+extern "C" {
+#include "BLI_threads.h"
+
+#include "BKE_idtype.h"
+#include "BKE_modifier.h"
+}
+
+class ArmatureDeformTest : public testing::Test {
+ protected:
+  static void SetUpTestCase()
+  {
+    BLI_threadapi_init();
+    BKE_idtype_init();
+    BKE_modifier_init();
+  }
+
+  static void TearDownTestCase()
+  {
+    BLI_threadapi_exit();
+  }
+};
+
+static void armature_deform_chain_test(const int verts_len)
+{
+  ArmatureDeformScene scene;
+  armature_deform_scene_create(&scene, verts_len);
+
+  const size_t coords_size = sizeof(float[3]) * verts_len;
+  float(*coords_sequential)[3] = (float(*)[3])MEM_dupallocN(scene.vert_coords);
+  float(*coords_chain)[3] = (float(*)[3])MEM_dupallocN(scene.vert_coords);
+
+  armature_deform_scene_sequential(&scene, coords_sequential);
+  armature_deform_scene_chain_apply(&scene, coords_chain);
+
+  /* Every vertex goes through the same computations, so the results are identical. */
+  EXPECT_NE(memcmp(coords_sequential, scene.vert_coords, coords_size), 0);
+  EXPECT_EQ(memcmp(coords_chain, coords_sequential, coords_size), 0);
+
+  MEM_freeN(coords_sequential);
+  MEM_freeN(coords_chain);
+  armature_deform_scene_free(&scene);
+}
+
+TEST_F(ArmatureDeformTest, ChainSingleBlock)
+{
+  armature_deform_chain_test(100);
+}
+
+/* Several blocks of 1024 vertices, the last block is partial. */
+TEST_F(ArmatureDeformTest, ChainMultipleBlocks)
+{
+  armature_deform_chain_test(1024 * 7 + 123);
+}
@@ -0,0 +1,149 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_byte_planes.h"
+#include "BLI_rand.h"
+#include "BLI_utildefines.h"
+}
+
+static size_t byte_planes_round_trip(const void *values, size_t values_len, size_t stride)
+{
+  void *packed;
+  const size_t packed_size = BLI_byte_planes_pack(values, values_len, stride, &packed);
+  EXPECT_GE(MEM_allocN_len(packed), packed_size);
+
+  void *unpacked = MEM_mallocN(MAX2(values_len * stride, (size_t)1), __func__);
+  BLI_byte_planes_unpack(packed, values_len, stride, unpacked);
+  EXPECT_EQ(memcmp(unpacked, values, values_len * stride), 0);
+
+  MEM_freeN(unpacked);
+  MEM_freeN(packed);
+  return packed_size;
+}
+
+TEST(byte_planes, Empty)
+{
+  float value = 0.0f;
+  byte_planes_round_trip(&value, 0, sizeof(float));
+}
+
+TEST(byte_planes, Single)
+{
+  const float value[3] = {1.0f, -2.5f, 1e-20f};
+  byte_planes_round_trip(value, 1, sizeof(value));
+}
+
+TEST(byte_planes, Zeros)
+{
+  float(*values)[3] = (float(*)[3])MEM_callocN(sizeof(*values) * 10000, __func__);
+  const size_t packed_size = byte_planes_round_trip(values, 10000, sizeof(*values));
+  EXPECT_LT(packed_size, 16);
+  MEM_freeN(values);
+}
+
+TEST(byte_planes, Random)
+{
+  const size_t len = 10000;
+  uint *values = (uint *)MEM_mallocN(sizeof(*values) * len, __func__);
+  RNG *rng = BLI_rng_new(0);
+  for (size_t i = 0; i < len; i++) {
+    values[i] = (uint)BLI_rng_get_int(rng);
+  }
+  BLI_rng_free(rng);
+
+  byte_planes_round_trip(values, len, sizeof(*values));
+  MEM_freeN(values);
+}
+
+/* Short zero runs stay in the literal bytes, longer ones are stored by their length. */
+TEST(byte_planes, ZeroRuns)
+{
+  const size_t len = 4096;
+  uchar *values = (uchar *)MEM_callocN(len, __func__);
+  for (size_t i = 0; i < len; i++) {
+    if ((i / 3) % 5 == 0 || (i / 100) % 7 == 0) {
+      values[i] = (uchar)(i | 1);
+    }
+  }
+
+  byte_planes_round_trip(values, len, 1);
+  byte_planes_round_trip(values, len / 4, 4);
+  byte_planes_round_trip(values, len / 12, 12);
+  MEM_freeN(values);
+}
+
+/* Undo data stored as the XOR delta of two states, like sculpt coordinates and masks. Applying
+ * the delta swaps between both states, exactly. */
+template<typename T>
+static void byte_planes_delta_test(T *stored, const size_t len, const size_t changed_step)
+{
+  T *current = (T *)MEM_dupallocN(stored);
+  RNG *rng = BLI_rng_new(1);
+  for (size_t i = 0; i < len; i += changed_step) {
+    float *value = (float *)&current[i];
+    for (size_t j = 0; j < sizeof(T) / sizeof(float); j++) {
+      value[j] += BLI_rng_get_float(rng) * 0.01f;
+    }
+  }
+  BLI_rng_free(rng);
+
+  uchar *delta = (uchar *)MEM_mallocN(sizeof(T) * len, __func__);
+  const uchar *stored_bytes = (const uchar *)stored;
+  const uchar *current_bytes = (const uchar *)current;
+  for (size_t i = 0; i < sizeof(T) * len; i++) {
+    delta[i] = stored_bytes[i] ^ current_bytes[i];
+  }
+
+  void *packed;
+  const size_t packed_size = BLI_byte_planes_pack(delta, len, sizeof(T), &packed);
+  EXPECT_LT(packed_size, sizeof(T) * len / 2);
+  MEM_freeN(delta);
+
+  T *modified = (T *)MEM_dupallocN(current);
+  for (int step = 0; step < 2; step++) {
+    uchar *unpacked = (uchar *)MEM_mallocN(sizeof(T) * len, __func__);
+    BLI_byte_planes_unpack(packed, len, sizeof(T), unpacked);
+    uchar *bytes = (uchar *)current;
+    for (size_t i = 0; i < sizeof(T) * len; i++) {
+      bytes[i] ^= unpacked[i];
+    }
+    MEM_freeN(unpacked);
+
+    /* Undo restores the stored values, redo the modified ones. */
+    EXPECT_EQ(memcmp(current, (step == 0) ? stored : modified, sizeof(T) * len), 0);
+  }
+
+  MEM_freeN(modified);
+  MEM_freeN(current);
+  MEM_freeN(packed);
+}
+
+TEST(byte_planes, DeltaCoords)
+{
+  const size_t len = 5000;
+  float(*coords)[3] = (float(*)[3])MEM_mallocN(sizeof(*coords) * len, __func__);
+  RNG *rng = BLI_rng_new(0);
+  for (size_t i = 0; i < len; i++) {
+    BLI_rng_get_float_unit_v3(rng, coords[i]);
+  }
+  BLI_rng_free(rng);
+
+  byte_planes_delta_test((float(*)[3])coords, len, 10);
+  MEM_freeN(coords);
+}
+
+TEST(byte_planes, DeltaMasks)
+{
+  const size_t len = 5000;
+  float *masks = (float *)MEM_mallocN(sizeof(*masks) * len, __func__);
+  for (size_t i = 0; i < len; i++) {
+    masks[i] = (float)(i % 7) / 7.0f;
+  }
+
+  byte_planes_delta_test(masks, len, 10);
+  MEM_freeN(masks);
+}
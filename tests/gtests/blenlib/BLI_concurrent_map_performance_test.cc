@@ -0,0 +1,138 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_concurrent_map.h"
+#include "BLI_ghash.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "PIL_time.h"
+}
+
+/* Deduplicate keys from many threads, like welding vertices or building an edge map:
+ * most keys are added once and looked up a few more times. */
+
+#define DUPLICATES 4
+
+typedef struct DedupData {
+  GHash *ghash;
+  SpinLock lock;
+  ConcurrentMap *map;
+  uint keys_len;
+  uint *r_index;
+} DedupData;
+
+BLI_INLINE uint dedup_key(const DedupData *data, const int iter)
+{
+  /* Scatter the duplicates, so threads work on the same keys at the same time. */
+  return ((uint)iter * 2654435761u) % data->keys_len;
+}
+
+static void dedup_ghash_fn(void *__restrict userdata,
+                           const int iter,
+                           const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  DedupData *data = (DedupData *)userdata;
+  void **val_p;
+  BLI_spin_lock(&data->lock);
+  if (!BLI_ghash_ensure_p(data->ghash, POINTER_FROM_UINT(dedup_key(data, iter)), &val_p)) {
+    *val_p = POINTER_FROM_INT(iter);
+  }
+  data->r_index[iter] = POINTER_AS_UINT(*val_p);
+  BLI_spin_unlock(&data->lock);
+}
+
+static void dedup_map_fn(void *__restrict userdata,
+                         const int iter,
+                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  DedupData *data = (DedupData *)userdata;
+  void *val;
+  BLI_concurrent_map_ensure(
+      data->map, POINTER_FROM_UINT(dedup_key(data, iter)), POINTER_FROM_INT(iter), &val);
+  data->r_index[iter] = POINTER_AS_UINT(val);
+}
+
+static void concurrent_map_dedup_test(const uint keys_len, const bool reserve)
+{
+  const int iters_len = (int)keys_len * DUPLICATES;
+  DedupData data = {NULL};
+  data.keys_len = keys_len;
+  data.r_index = (uint *)MEM_mallocN(sizeof(uint) * (size_t)iters_len, __func__);
+
+  BLI_threadapi_init();
+
+  printf("\n========== STARTING %s (%u keys%s) ==========\n",
+         __func__,
+         keys_len,
+         reserve ? ", reserved" : "");
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+
+  BLI_spin_init(&data.lock);
+
+  /* GHash, single thread. */
+  data.ghash = BLI_ghash_int_new_ex(__func__, reserve ? keys_len : 0);
+  settings.use_threading = false;
+  double start = PIL_check_seconds_timer();
+  BLI_task_parallel_range(0, iters_len, &data, dedup_ghash_fn, &settings);
+  printf("\tGHash, single thread: %f seconds\n", PIL_check_seconds_timer() - start);
+  BLI_ghash_free(data.ghash, NULL, NULL);
+
+  /* GHash behind a lock. */
+  data.ghash = BLI_ghash_int_new_ex(__func__, reserve ? keys_len : 0);
+  settings.use_threading = true;
+  start = PIL_check_seconds_timer();
+  BLI_task_parallel_range(0, iters_len, &data, dedup_ghash_fn, &settings);
+  printf("\tGHash, locked: %f seconds\n", PIL_check_seconds_timer() - start);
+  EXPECT_EQ(BLI_ghash_len(data.ghash), keys_len);
+  BLI_ghash_free(data.ghash, NULL, NULL);
+  BLI_spin_end(&data.lock);
+
+  /* Concurrent map, single thread and threaded. */
+  for (int threaded = 0; threaded < 2; threaded++) {
+    data.map = BLI_concurrent_map_new(
+        BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__, reserve ? keys_len : 0);
+    settings.use_threading = threaded;
+    start = PIL_check_seconds_timer();
+    BLI_task_parallel_range(0, iters_len, &data, dedup_map_fn, &settings);
+    printf("\tConcurrentMap, %s: %f seconds\n",
+           threaded ? "threaded" : "single thread",
+           PIL_check_seconds_timer() - start);
+    EXPECT_EQ(BLI_concurrent_map_len(data.map), keys_len);
+    BLI_concurrent_map_free(data.map, NULL, NULL);
+  }
+
+  printf("========== ENDED %s ==========\n\n", __func__);
+
+  BLI_threadapi_exit();
+
+  MEM_freeN(data.r_index);
+}
+
+TEST(concurrent_map, Dedup100k)
+{
+  concurrent_map_dedup_test(100000, false);
+}
+
+TEST(concurrent_map, Dedup1M)
+{
+  concurrent_map_dedup_test(1000000, false);
+}
+
+TEST(concurrent_map, Dedup1MReserved)
+{
+  concurrent_map_dedup_test(1000000, true);
+}
+
+TEST(concurrent_map, Dedup10M)
+{
+  concurrent_map_dedup_test(10000000, false);
+}
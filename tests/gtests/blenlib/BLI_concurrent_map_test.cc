@@ -0,0 +1,215 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_concurrent_map.h"
+#include "BLI_ghash.h"
+#include "BLI_string.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+}
+
+static ConcurrentMap *int_map_new(const uint reserve)
+{
+  return BLI_concurrent_map_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__, reserve);
+}
+
+static void foreach_sum_fn(void *key, void *val, void *userdata)
+{
+  uint *sums = (uint *)userdata;
+  sums[0] += POINTER_AS_UINT(key);
+  sums[1] += POINTER_AS_UINT(val);
+}
+
+/* -------------------------------------------------------------------- */
+/* Single Thread */
+
+TEST(concurrent_map, Empty)
+{
+  ConcurrentMap *map = int_map_new(0);
+  EXPECT_EQ(BLI_concurrent_map_len(map), 0);
+  EXPECT_FALSE(BLI_concurrent_map_haskey(map, POINTER_FROM_UINT(0)));
+  EXPECT_EQ(BLI_concurrent_map_lookup(map, POINTER_FROM_UINT(1)), (void *)NULL);
+  BLI_concurrent_map_free(map, NULL, NULL);
+}
+
+TEST(concurrent_map, AddLookup)
+{
+  ConcurrentMap *map = int_map_new(0);
+  const uint keys_len = 10000;
+
+  /* Zero keys and NULL values are stored like any other. */
+  for (uint i = 0; i < keys_len; i++) {
+    EXPECT_TRUE(BLI_concurrent_map_add(map, POINTER_FROM_UINT(i), POINTER_FROM_UINT(i * 2)));
+  }
+  EXPECT_EQ(BLI_concurrent_map_len(map), keys_len);
+
+  for (uint i = 0; i < keys_len; i++) {
+    EXPECT_FALSE(BLI_concurrent_map_add(map, POINTER_FROM_UINT(i), POINTER_FROM_UINT(1)));
+  }
+  EXPECT_EQ(BLI_concurrent_map_len(map), keys_len);
+
+  for (uint i = 0; i < keys_len; i++) {
+    EXPECT_TRUE(BLI_concurrent_map_haskey(map, POINTER_FROM_UINT(i)));
+    EXPECT_EQ(POINTER_AS_UINT(BLI_concurrent_map_lookup(map, POINTER_FROM_UINT(i))), i * 2);
+  }
+  for (uint i = keys_len; i < keys_len * 2; i++) {
+    EXPECT_FALSE(BLI_concurrent_map_haskey(map, POINTER_FROM_UINT(i)));
+    EXPECT_EQ(BLI_concurrent_map_lookup_default(map, POINTER_FROM_UINT(i), POINTER_FROM_UINT(7)),
+              POINTER_FROM_UINT(7));
+  }
+
+  uint sums[2] = {0, 0};
+  BLI_concurrent_map_foreach(map, foreach_sum_fn, sums);
+  EXPECT_EQ(sums[0], keys_len * (keys_len - 1) / 2);
+  EXPECT_EQ(sums[1], keys_len * (keys_len - 1));
+
+  BLI_concurrent_map_free(map, NULL, NULL);
+}
+
+TEST(concurrent_map, Ensure)
+{
+  ConcurrentMap *map = int_map_new(100);
+  void *val;
+
+  EXPECT_FALSE(BLI_concurrent_map_ensure(map, POINTER_FROM_UINT(5), POINTER_FROM_UINT(1), &val));
+  EXPECT_EQ(val, POINTER_FROM_UINT(1));
+  EXPECT_TRUE(BLI_concurrent_map_ensure(map, POINTER_FROM_UINT(5), POINTER_FROM_UINT(2), &val));
+  EXPECT_EQ(val, POINTER_FROM_UINT(1));
+  EXPECT_EQ(BLI_concurrent_map_len(map), 1);
+
+  BLI_concurrent_map_free(map, NULL, NULL);
+}
+
+TEST(concurrent_map, StringKeys)
+{
+  ConcurrentMap *map = BLI_concurrent_map_new(
+      BLI_ghashutil_strhash_p, BLI_ghashutil_strcmp, __func__, 0);
+  char key[32];
+
+  for (int i = 0; i < 1000; i++) {
+    BLI_snprintf(key, sizeof(key), "key_%d", i);
+    BLI_concurrent_map_add(map, BLI_strdup(key), POINTER_FROM_INT(i));
+  }
+  for (int i = 0; i < 1000; i++) {
+    BLI_snprintf(key, sizeof(key), "key_%d", i);
+    EXPECT_EQ(BLI_concurrent_map_lookup(map, key), POINTER_FROM_INT(i));
+  }
+  EXPECT_FALSE(BLI_concurrent_map_haskey(map, "key_1000"));
+
+  BLI_concurrent_map_free(map, MEM_freeN, NULL);
+}
+
+/* -------------------------------------------------------------------- */
+/* Multiple Threads */
+
+typedef struct EnsureData {
+  ConcurrentMap *map;
+  uint keys_len;
+  void **vals;
+  bool *existed;
+} EnsureData;
+
+static void ensure_fn(void *__restrict userdata,
+                      const int iter,
+                      const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  EnsureData *data = (EnsureData *)userdata;
+  const uint key = (uint)iter % data->keys_len;
+  data->existed[iter] = BLI_concurrent_map_ensure(
+      data->map, POINTER_FROM_UINT(key), POINTER_FROM_INT(iter), &data->vals[iter]);
+  /* Lookups from other threads see the entry as soon as it's added. */
+  EXPECT_EQ(BLI_concurrent_map_lookup(data->map, POINTER_FROM_UINT(key)), data->vals[iter]);
+}
+
+static void concurrent_map_ensure_test(const uint keys_len, const int iters_len)
+{
+  BLI_system_num_threads_override_set(8);
+  BLI_threadapi_init();
+
+  /* Start small, so the map grows while other threads use it. */
+  ConcurrentMap *map = int_map_new(0);
+  EnsureData data = {
+      map,
+      keys_len,
+      (void **)MEM_mallocN(sizeof(void *) * (size_t)iters_len, __func__),
+      (bool *)MEM_mallocN(sizeof(bool) * (size_t)iters_len, __func__),
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 64;
+  BLI_task_parallel_range(0, iters_len, &data, ensure_fn, &settings);
+
+  EXPECT_EQ(BLI_concurrent_map_len(map), keys_len);
+
+  /* Every key was added once, and all threads agree on its value. */
+  uint *added = (uint *)MEM_callocN(sizeof(uint) * keys_len, __func__);
+  for (int i = 0; i < iters_len; i++) {
+    const uint key = (uint)i % keys_len;
+    void *val = BLI_concurrent_map_lookup(map, POINTER_FROM_UINT(key));
+    EXPECT_EQ(data.vals[i], val);
+    EXPECT_EQ((uint)POINTER_AS_INT(val) % keys_len, key);
+    if (!data.existed[i]) {
+      EXPECT_EQ(val, POINTER_FROM_INT(i));
+      added[key]++;
+    }
+  }
+  for (uint key = 0; key < keys_len; key++) {
+    EXPECT_EQ(added[key], 1);
+  }
+
+  MEM_freeN(added);
+  MEM_freeN(data.vals);
+  MEM_freeN(data.existed);
+  BLI_concurrent_map_free(map, NULL, NULL);
+
+  BLI_threadapi_exit();
+  BLI_system_num_threads_override_set(0);
+}
+
+TEST(concurrent_map, EnsureThreadedFewKeys)
+{
+  concurrent_map_ensure_test(100, 100000);
+}
+
+TEST(concurrent_map, EnsureThreadedManyKeys)
+{
+  concurrent_map_ensure_test(200000, 400000);
+}
+
+static void add_fn(void *__restrict userdata,
+                   const int iter,
+                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  ConcurrentMap *map = (ConcurrentMap *)userdata;
+  EXPECT_TRUE(BLI_concurrent_map_add(map, POINTER_FROM_INT(iter), POINTER_FROM_INT(iter)));
+}
+
+/* More threads than the smallest table takes before growing, all adding to it at once. */
+TEST(concurrent_map, AddThreadedSmallTable)
+{
+  BLI_system_num_threads_override_set(32);
+  BLI_threadapi_init();
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+
+  for (int i = 0; i < 200; i++) {
+    ConcurrentMap *map = int_map_new(0);
+    BLI_task_parallel_range(0, 64, map, add_fn, &settings);
+    EXPECT_EQ(BLI_concurrent_map_len(map), 64);
+    for (int key = 0; key < 64; key++) {
+      EXPECT_EQ(BLI_concurrent_map_lookup(map, POINTER_FROM_INT(key)), POINTER_FROM_INT(key));
+    }
+    BLI_concurrent_map_free(map, NULL, NULL);
+  }
+
+  BLI_threadapi_exit();
+  BLI_system_num_threads_override_set(0);
+}
@@ -102,6 +102,7 @@ TEST_PARSE_FAIL(BadArgCount2, "sqrt(1,2)")
 TEST_PARSE_FAIL(BadArgCount3, "pi()")
 TEST_PARSE_FAIL(BadArgCount4, "max()")
 TEST_PARSE_FAIL(BadArgCount5, "min()")
+TEST_PARSE_FAIL(BadArgCount6, "log(1,2,3)")
 
 TEST_PARSE_FAIL(Truncated1, "(1+2")
 TEST_PARSE_FAIL(Truncated2, "1 if 2")
@@ -113,6 +114,11 @@ TEST_PARSE_FAIL(Truncated7, "1 and")
 TEST_PARSE_FAIL(Truncated8, "1 or")
 TEST_PARSE_FAIL(Truncated9, "sqrt(1")
 TEST_PARSE_FAIL(Truncated10, "fmod(1,")
+TEST_PARSE_FAIL(Truncated11, "2 **")
+TEST_PARSE_FAIL(Truncated12, "2 //")
+TEST_PARSE_FAIL(Truncated13, "2 %")
+TEST_PARSE_FAIL(BadOp1, "2 ***2")
+TEST_PARSE_FAIL(BadOp2, "2 ///2")
 
 /* Constant expression with working constant folding */
 #define TEST_CONST(name, str, value) \
@@ -147,6 +153,8 @@ TEST_CONST(Half, ".5", 0.5)
 TEST_CONST(Pi, "pi", M_PI)
 TEST_CONST(True, "True", TRUE_VAL)
 TEST_CONST(False, "False", FALSE_VAL)
+TEST_CONST(E, "e", M_E)
+TEST_CONST(Tau, "tau", M_PI * 2.0)
 
 TEST_CONST(Sqrt, "sqrt(4)", 2.0)
 TEST_EVAL(Sqrt, "sqrt(x)", 4.0, 2.0)
@@ -157,6 +165,28 @@ TEST_EVAL(FMod, "fmod(x, 2)", 3.5, 1.5)
 TEST_CONST(Pow, "pow(4, 0.5)", 2.0)
 TEST_EVAL(Pow, "pow(4, x)", 0.5, 2.0)
 
+TEST_CONST(Log, "log(1)", 0.0)
+TEST_CONST(LogBase, "log(8, 2)", 3.0)
+TEST_EVAL(LogBase, "log(x, 10)", 100.0, 2.0)
+TEST_CONST(Log10, "log10(1000)", 3.0)
+TEST_CONST(Log2, "log2(0.5)", -1.0)
+
+TEST_CONST(Hypot, "hypot(3, 4)", 5.0)
+TEST_CONST(CopySign, "copysign(2, -1)", -2.0)
+TEST_CONST(Tanh, "tanh(0)", 0.0)
+TEST_EVAL(Sinh, "sinh(x)", 1.0, sinh(1.0))
+
+/* Python rounds halfway cases to the even neighbor. */
+TEST_CONST(Round1, "round(2.5)", 2.0)
+TEST_CONST(Round2, "round(3.5)", 4.0)
+TEST_CONST(Round3, "round(-2.5)", -2.0)
+TEST_CONST(Round4, "round(2.6)", 3.0)
+TEST_EVAL(Round, "round(x)", -0.4, 0.0)
+
+TEST_CONST(Float, "float(2)", 2.0)
+TEST_CONST(Bool1, "bool(2)", TRUE_VAL)
+TEST_CONST(Bool2, "bool(0)", FALSE_VAL)
+
 TEST_RESULT(Min1, "min(3,1,2)", 1.0)
 TEST_RESULT(Max1, "max(3,1,2)", 3.0)
 TEST_RESULT(Min2, "min(1,2,3)", 1.0)
@@ -181,10 +211,34 @@ TEST_EVAL(BinaryMul, "x*3", 2, 6.0)
 TEST_CONST(BinaryDiv, "3/2", 1.5)
 TEST_EVAL(BinaryDiv, "3/x", 2, 1.5)
 
+TEST_CONST(BinaryPow, "2**3", 8.0)
+TEST_EVAL(BinaryPow, "x**0.5", 4, 2.0)
+
+TEST_CONST(Pow1, "-2 ** 2", -4.0)
+TEST_CONST(Pow2, "2 ** -1", 0.5)
+TEST_CONST(Pow3, "2 ** 3 ** 2", 512.0)
+TEST_CONST(Pow4, "(2 ** 3) ** 2", 64.0)
+TEST_CONST(Pow5, "2 * 3 ** 2", 18.0)
+
+/* Python modulo and floor division round towards negative infinity. */
+TEST_CONST(Mod1, "7 % 3", 1.0)
+TEST_CONST(Mod2, "-7 % 3", 2.0)
+TEST_CONST(Mod3, "7 % -3", -2.0)
+TEST_CONST(Mod4, "5.5 % 2", 1.5)
+TEST_EVAL(Mod, "x % 1", -0.25, 0.75)
+
+TEST_CONST(FloorDiv1, "7 // 2", 3.0)
+TEST_CONST(FloorDiv2, "-7 // 2", -4.0)
+TEST_CONST(FloorDiv3, "7 // -2", -4.0)
+TEST_CONST(FloorDiv4, "7.5 // 2.5", 3.0)
+TEST_EVAL(FloorDiv, "x // 0.5", 1.75, 3.0)
+
 TEST_CONST(Arith1, "1 + -2 * 3", -5.0)
 TEST_CONST(Arith2, "(1 + -2) * 3", -3.0)
 TEST_CONST(Arith3, "-1 + 2 * 3", 5.0)
 TEST_CONST(Arith4, "3 * (-2 + 1)", -3.0)
+TEST_CONST(Arith5, "1 + 7 % 3 * 2 ** 2", 5.0)
+TEST_CONST(Arith6, "8 // 3 * 3 + 8 % 3", 8.0)
 
 TEST_EVAL(Arith1, "1 + -x * 3", 2, -5.0)
 
@@ -313,6 +367,11 @@ TEST_ERROR(SqrtDomain3, "sqrt(x)", 0.0, EXPR_PYLIKE_SUCCESS)
 TEST_ERROR(PowDomain1, "pow(-1, 0.5)", 0.0, EXPR_PYLIKE_MATH_ERROR)
 TEST_ERROR(PowDomain2, "pow(-1, x)", 0.5, EXPR_PYLIKE_MATH_ERROR)
 TEST_ERROR(PowDomain3, "pow(-1, x)", 2.0, EXPR_PYLIKE_SUCCESS)
+TEST_ERROR(PowDomain4, "(-1) ** x", 0.5, EXPR_PYLIKE_MATH_ERROR)
+
+TEST_ERROR(ModZero, "1 % x", 0.0, EXPR_PYLIKE_MATH_ERROR)
+TEST_ERROR(FloorDivZero, "1 // x", 0.0, EXPR_PYLIKE_MATH_ERROR)
+TEST_ERROR(LogDomain, "log(x)", 0.0, EXPR_PYLIKE_DIV_BY_ZERO)
 
 TEST_ERROR(Mixed1, "sqrt(x) + 1 / max(0, x)", -1.0, EXPR_PYLIKE_MATH_ERROR)
 TEST_ERROR(Mixed2, "sqrt(x) + 1 / max(0, x)", 0.0, EXPR_PYLIKE_DIV_BY_ZERO)
@@ -0,0 +1,188 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_kdopbvh.h"
+#include "BLI_math_geom.h"
+#include "BLI_math_vector.h"
+#include "BLI_rand.h"
+#include "BLI_utildefines.h"
+
+#include "PIL_time.h"
+}
+
+#include "stubs/bf_intern_eigen_stubs.h"
+
+/* Rays cast from a view over a scene with uneven density: a few large ground triangles and
+ * clusters of small ones, like objects on a floor. */
+
+#define CLUSTERS 8
+#define VIEW_SIZE 512
+
+static void raycast_tri_callback(void *userdata,
+                                 int index,
+                                 const BVHTreeRay *ray,
+                                 BVHTreeRayHit *hit)
+{
+  const float(*tris)[3][3] = (const float(*)[3][3])userdata;
+  const float(*tri)[3] = tris[index];
+  float dist;
+
+  if (isect_ray_tri_watertight_v3(
+          ray->origin, ray->isect_precalc, tri[0], tri[1], tri[2], &dist, NULL) &&
+      (dist < hit->dist)) {
+    hit->index = index;
+    hit->dist = dist;
+    madd_v3_v3v3fl(hit->co, ray->origin, ray->direction, dist);
+  }
+}
+
+static int scene_tris_create(float (**r_tris)[3][3], const int cluster_tris_len)
+{
+  const int ground_len = 16;
+  const int tris_len = ground_len * ground_len * 2 + CLUSTERS * cluster_tris_len;
+  float(*tris)[3][3] = (float(*)[3][3])MEM_mallocN(sizeof(*tris) * tris_len, __func__);
+  struct RNG *rng = BLI_rng_new(0);
+  int tri = 0;
+
+  for (int x = 0; x < ground_len; x++) {
+    for (int y = 0; y < ground_len; y++) {
+      const float quad[4][3] = {
+          {(float)x, (float)y, 0.0f},
+          {(float)x + 1.0f, (float)y, 0.0f},
+          {(float)x + 1.0f, (float)y + 1.0f, 0.0f},
+          {(float)x, (float)y + 1.0f, 0.0f},
+      };
+      copy_v3_v3(tris[tri][0], quad[0]);
+      copy_v3_v3(tris[tri][1], quad[1]);
+      copy_v3_v3(tris[tri][2], quad[2]);
+      tri++;
+      copy_v3_v3(tris[tri][0], quad[0]);
+      copy_v3_v3(tris[tri][1], quad[2]);
+      copy_v3_v3(tris[tri][2], quad[3]);
+      tri++;
+    }
+  }
+
+  for (int cluster = 0; cluster < CLUSTERS; cluster++) {
+    float center[3];
+    BLI_rng_get_float_unit_v2(rng, center);
+    center[0] = (center[0] + 1.0f) * (float)ground_len * 0.5f;
+    center[1] = (center[1] + 1.0f) * (float)ground_len * 0.5f;
+    center[2] = 1.0f;
+    for (int i = 0; i < cluster_tris_len; i++, tri++) {
+      float co[3];
+      BLI_rng_get_float_unit_v3(rng, co);
+      madd_v3_v3v3fl(co, center, co, BLI_rng_get_float(rng));
+      for (int j = 0; j < 3; j++) {
+        BLI_rng_get_float_unit_v3(rng, tris[tri][j]);
+        madd_v3_v3v3fl(tris[tri][j], co, tris[tri][j], 0.02f);
+      }
+    }
+  }
+
+  BLI_rng_free(rng);
+  *r_tris = tris;
+  return tris_len;
+}
+
+static void raycast_packet_test(const int cluster_tris_len, const char tree_type)
+{
+  float(*tris)[3][3];
+  const int tris_len = scene_tris_create(&tris, cluster_tris_len);
+  const int rays_len = VIEW_SIZE * VIEW_SIZE;
+
+  /* Rays from a view looking down at the scene, neighboring rays are coherent. */
+  float(*co)[3] = (float(*)[3])MEM_mallocN(sizeof(*co) * rays_len, __func__);
+  float(*dir)[3] = (float(*)[3])MEM_mallocN(sizeof(*dir) * rays_len, __func__);
+  for (int y = 0; y < VIEW_SIZE; y++) {
+    for (int x = 0; x < VIEW_SIZE; x++) {
+      const int i = y * VIEW_SIZE + x;
+      const float target[3] = {(float)x / VIEW_SIZE * 16.0f, (float)y / VIEW_SIZE * 16.0f, 0.0f};
+      const float origin[3] = {8.0f, -8.0f, 12.0f};
+      copy_v3_v3(co[i], origin);
+      sub_v3_v3v3(dir[i], target, origin);
+      normalize_v3(dir[i]);
+    }
+  }
+
+  BVHTreeRayHit *hits = (BVHTreeRayHit *)MEM_mallocN(sizeof(*hits) * rays_len, __func__);
+
+  printf("\n========== STARTING %s (%d triangles, tree type %d) ==========\n",
+         __func__,
+         tris_len,
+         tree_type);
+
+  for (int balance_flag = 0; balance_flag <= BVH_BALANCE_SAH; balance_flag++) {
+    const char *build = (balance_flag & BVH_BALANCE_SAH) ? "SAH" : "median";
+
+    double start = PIL_check_seconds_timer();
+    BVHTree *tree = BLI_bvhtree_new(tris_len, 0.0f, tree_type, 6);
+    for (int i = 0; i < tris_len; i++) {
+      BLI_bvhtree_insert(tree, i, tris[i][0], 3);
+    }
+    BLI_bvhtree_balance_ex(tree, balance_flag);
+    printf("\t%s build: %f seconds\n", build, PIL_check_seconds_timer() - start);
+
+    int hits_single_len = 0;
+    start = PIL_check_seconds_timer();
+    for (int i = 0; i < rays_len; i++) {
+      hits[i].index = -1;
+      hits[i].dist = BVH_RAYCAST_DIST_MAX;
+      BLI_bvhtree_ray_cast(tree, co[i], dir[i], 0.0f, &hits[i], raycast_tri_callback, tris);
+      if (hits[i].index != -1) {
+        hits_single_len++;
+      }
+    }
+    printf("\t%s, single rays: %f seconds\n", build, PIL_check_seconds_timer() - start);
+
+    int hits_packet_len = 0;
+    start = PIL_check_seconds_timer();
+    for (int i = 0; i < rays_len; i++) {
+      hits[i].index = -1;
+      hits[i].dist = BVH_RAYCAST_DIST_MAX;
+    }
+    BLI_bvhtree_ray_cast_packet(
+        tree, co, dir, rays_len, 0.0f, hits, raycast_tri_callback, tris, BVH_RAYCAST_DEFAULT);
+    printf("\t%s, packets: %f seconds\n", build, PIL_check_seconds_timer() - start);
+    for (int i = 0; i < rays_len; i++) {
+      if (hits[i].index != -1) {
+        hits_packet_len++;
+      }
+    }
+
+    EXPECT_EQ(hits_single_len, hits_packet_len);
+
+    BLI_bvhtree_free(tree);
+  }
+
+  printf("========== ENDED %s ==========\n\n", __func__);
+
+  MEM_freeN(tris);
+  MEM_freeN(co);
+  MEM_freeN(dir);
+  MEM_freeN(hits);
+}
+
+TEST(kdopbvh, RayCastPacket_80k_Binary)
+{
+  raycast_packet_test(10000, 2);
+}
+
+TEST(kdopbvh, RayCastPacket_80k_Oct)
+{
+  raycast_packet_test(10000, 8);
+}
+
+TEST(kdopbvh, RayCastPacket_800k_Quad)
+{
+  raycast_packet_test(100000, 4);
+}
+
+TEST(kdopbvh, RayCastPacket_800k_Oct)
+{
+  raycast_packet_test(100000, 8);
+}
@@ -10,6 +10,7 @@ extern "C" {
 #include "BLI_compiler_attrs.h"
 #include "BLI_kdopbvh.h"
 #include "BLI_rand.h"
+#include "BLI_math_geom.h"
 #include "BLI_math_vector.h"
 }
 
@@ -70,8 +71,12 @@ static void optimal_check_callback(void *userdata,
  * Note that a small epsilon is added to the BVH nodes bounds, even if we pass in zero.
  * Use rounding to ensure very close nodes don't cause the wrong node to be found as nearest.
  */
-static void find_nearest_points_test(
-    int points_len, float scale, int round, int random_seed, bool optimal = false)
+static void find_nearest_points_test(int points_len,
+                                     float scale,
+                                     int round,
+                                     int random_seed,
+                                     bool optimal = false,
+                                     int balance_flag = 0)
 {
   struct RNG *rng = BLI_rng_new(random_seed);
   BVHTree *tree = BLI_bvhtree_new(points_len, 0.0, 8, 8);
@@ -83,7 +88,7 @@ static void find_nearest_points_test(
     rng_v3_round(points[i], 3, rng, round, scale);
     BLI_bvhtree_insert(tree, i, points[i], 1);
   }
-  BLI_bvhtree_balance(tree);
+  BLI_bvhtree_balance_ex(tree, balance_flag);
 
   /* first find each point */
   BVHTree_NearestPointCallback callback = optimal ? optimal_check_callback : NULL;
@@ -136,3 +141,200 @@ TEST(kdopbvh, OptimalFindNearest_500)
 {
   find_nearest_points_test(500, 1.0, 1000, 12, true);
 }
+
+TEST(kdopbvh, FindNearestSAH_500)
+{
+  find_nearest_points_test(500, 1.0, 1000, 12, false, BVH_BALANCE_SAH);
+}
+TEST(kdopbvh, OptimalFindNearestSAH_500)
+{
+  find_nearest_points_test(500, 1.0, 1000, 12, true, BVH_BALANCE_SAH);
+}
+
+/* -------------------------------------------------------------------- */
+/* Ray-Cast */
+
+static void raycast_tri_callback(void *userdata,
+                                 int index,
+                                 const BVHTreeRay *ray,
+                                 BVHTreeRayHit *hit)
+{
+  const float(*tris)[3][3] = (const float(*)[3][3])userdata;
+  const float(*tri)[3] = tris[index];
+  float dist;
+
+  if (isect_ray_tri_watertight_v3(
+          ray->origin, ray->isect_precalc, tri[0], tri[1], tri[2], &dist, NULL) &&
+      (dist < hit->dist)) {
+    hit->index = index;
+    hit->dist = dist;
+    madd_v3_v3v3fl(hit->co, ray->origin, ray->direction, dist);
+  }
+}
+
+static BVHTree *raycast_tree_create(const float (*tris)[3][3],
+                                    int tris_len,
+                                    char tree_type,
+                                    int balance_flag)
+{
+  BVHTree *tree = BLI_bvhtree_new(tris_len, 0.0, tree_type, 6);
+  for (int i = 0; i < tris_len; i++) {
+    BLI_bvhtree_insert(tree, i, tris[i][0], 3);
+  }
+  BLI_bvhtree_balance_ex(tree, balance_flag);
+  return tree;
+}
+
+static void raycast_hits_init(BVHTreeRayHit *hits, int rays_len)
+{
+  for (int i = 0; i < rays_len; i++) {
+    hits[i].index = -1;
+    hits[i].dist = BVH_RAYCAST_DIST_MAX;
+  }
+}
+
+/**
+ * Cast coherent rays (from a few points towards the triangles, some axis aligned)
+ * one by one and as packets, on trees built with and without #BVH_BALANCE_SAH,
+ * all must find the same hits.
+ */
+static void raycast_packet_test(int tris_len, char tree_type, float radius, int random_seed)
+{
+  const int rays_len = 1001;
+  struct RNG *rng = BLI_rng_new(random_seed);
+
+  float(*tris)[3][3] = (float(*)[3][3])MEM_mallocN(sizeof(*tris) * tris_len, __func__);
+  for (int i = 0; i < tris_len; i++) {
+    float center[3];
+    BLI_rng_get_float_unit_v3(rng, center);
+    mul_v3_fl(center, BLI_rng_get_float(rng));
+    for (int j = 0; j < 3; j++) {
+      BLI_rng_get_float_unit_v3(rng, tris[i][j]);
+      madd_v3_v3fl(tris[i][j], center, 20.0f);
+      mul_v3_fl(tris[i][j], 0.05f);
+    }
+  }
+
+  float(*co)[3] = (float(*)[3])MEM_mallocN(sizeof(*co) * rays_len, __func__);
+  float(*dir)[3] = (float(*)[3])MEM_mallocN(sizeof(*dir) * rays_len, __func__);
+  for (int i = 0; i < rays_len; i++) {
+    const float origin[3] = {-2.0f, (float)((i / 100) % 2), 0.5f};
+    copy_v3_v3(co[i], origin);
+    if (i % 10 == 0) {
+      /* Axis aligned. */
+      co[i][1] = BLI_rng_get_float(rng) - 0.5f;
+      co[i][2] = BLI_rng_get_float(rng) - 0.5f;
+      dir[i][0] = 1.0f;
+      dir[i][1] = dir[i][2] = 0.0f;
+    }
+    else {
+      float target[3];
+      BLI_rng_get_float_unit_v3(rng, target);
+      sub_v3_v3v3(dir[i], target, co[i]);
+      normalize_v3(dir[i]);
+    }
+  }
+
+  BVHTreeRayHit *hits_ref = (BVHTreeRayHit *)MEM_mallocN(sizeof(*hits_ref) * rays_len, __func__);
+  BVHTreeRayHit *hits_single = (BVHTreeRayHit *)MEM_mallocN(sizeof(*hits_single) * rays_len,
+                                                            __func__);
+  BVHTreeRayHit *hits_packet = (BVHTreeRayHit *)MEM_mallocN(sizeof(*hits_packet) * rays_len,
+                                                            __func__);
+
+  /* The reference, single rays on the median split tree. */
+  BVHTree *tree_ref = raycast_tree_create(tris, tris_len, tree_type, 0);
+  raycast_hits_init(hits_ref, rays_len);
+  int hits_len = 0;
+  for (int i = 0; i < rays_len; i++) {
+    BLI_bvhtree_ray_cast(
+        tree_ref, co[i], dir[i], radius, &hits_ref[i], raycast_tri_callback, tris);
+    if (hits_ref[i].index != -1) {
+      hits_len++;
+    }
+  }
+  BLI_bvhtree_free(tree_ref);
+  EXPECT_GT(hits_len, 0);
+  EXPECT_LT(hits_len, rays_len);
+
+  for (int balance_flag = 0; balance_flag <= BVH_BALANCE_SAH; balance_flag++) {
+    /* Build from moved triangles and refit, which relies on children being after parents. */
+    float(*tris_moved)[3][3] = (float(*)[3][3])MEM_dupallocN(tris);
+    for (int i = 0; i < tris_len * 3; i++) {
+      add_v3_fl(tris_moved[i / 3][i % 3], 3.0f);
+    }
+    BVHTree *tree = raycast_tree_create(tris_moved, tris_len, tree_type, balance_flag);
+    MEM_freeN(tris_moved);
+    for (int i = 0; i < tris_len; i++) {
+      BLI_bvhtree_update_node(tree, i, tris[i][0], NULL, 3);
+    }
+    BLI_bvhtree_update_tree(tree);
+
+    raycast_hits_init(hits_single, rays_len);
+    raycast_hits_init(hits_packet, rays_len);
+    for (int i = 0; i < rays_len; i++) {
+      BLI_bvhtree_ray_cast(
+          tree, co[i], dir[i], radius, &hits_single[i], raycast_tri_callback, tris);
+    }
+    BLI_bvhtree_ray_cast_packet(tree,
+                                co,
+                                dir,
+                                rays_len,
+                                radius,
+                                hits_packet,
+                                raycast_tri_callback,
+                                tris,
+                                BVH_RAYCAST_DEFAULT);
+    for (int i = 0; i < rays_len; i++) {
+      EXPECT_EQ(hits_ref[i].index, hits_single[i].index);
+      EXPECT_EQ(hits_ref[i].index, hits_packet[i].index);
+      if (hits_ref[i].index != -1) {
+        EXPECT_EQ(hits_ref[i].dist, hits_single[i].dist);
+        EXPECT_EQ(hits_ref[i].dist, hits_packet[i].dist);
+      }
+    }
+
+    /* Without a callback the nearest bounding volume is hit. */
+    raycast_hits_init(hits_single, rays_len);
+    raycast_hits_init(hits_packet, rays_len);
+    for (int i = 0; i < rays_len; i++) {
+      BLI_bvhtree_ray_cast(tree, co[i], dir[i], radius, &hits_single[i], NULL, NULL);
+    }
+    BLI_bvhtree_ray_cast_packet(
+        tree, co, dir, rays_len, radius, hits_packet, NULL, NULL, BVH_RAYCAST_DEFAULT);
+    for (int i = 0; i < rays_len; i++) {
+      EXPECT_EQ(hits_single[i].index == -1, hits_packet[i].index == -1);
+      EXPECT_NEAR(hits_single[i].dist, hits_packet[i].dist, 1e-5f);
+    }
+
+    BLI_bvhtree_free(tree);
+  }
+
+  BLI_rng_free(rng);
+  MEM_freeN(tris);
+  MEM_freeN(co);
+  MEM_freeN(dir);
+  MEM_freeN(hits_ref);
+  MEM_freeN(hits_single);
+  MEM_freeN(hits_packet);
+}
+
+TEST(kdopbvh, RayCastPacket_Binary)
+{
+  raycast_packet_test(1000, 2, 0.0f, 1234);
+}
+TEST(kdopbvh, RayCastPacket_Quad)
+{
+  raycast_packet_test(1000, 4, 0.0f, 123);
+}
+TEST(kdopbvh, RayCastPacket_Oct)
+{
+  raycast_packet_test(2000, 8, 0.0f, 12);
+}
+TEST(kdopbvh, RayCastPacket_Radius)
+{
+  raycast_packet_test(1000, 4, 0.01f, 1);
+}
+TEST(kdopbvh, RayCastPacket_Few)
+{
+  raycast_packet_test(20, 8, 0.0f, 2);
+}
@@ -0,0 +1,225 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "DNA_listBase.h"
+
+#include "BLI_ghash.h"
+#include "BLI_mempool.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+}
+
+typedef struct TestElem {
+  /* Keep the first word clear of the free word used for iteration. */
+  void *self;
+  int index;
+  int thread_round;
+} TestElem;
+
+static int mempool_iter_count(BLI_mempool *pool)
+{
+  BLI_mempool_iter iter;
+  int count = 0;
+  BLI_mempool_iternew(pool, &iter);
+  for (TestElem *elem = (TestElem *)BLI_mempool_iterstep(&iter); elem;
+       elem = (TestElem *)BLI_mempool_iterstep(&iter)) {
+    EXPECT_EQ(elem->self, elem);
+    count++;
+  }
+  return count;
+}
+
+/* -------------------------------------------------------------------- */
+/* Single Thread */
+
+static void mempool_alloc_free_test(const uint flag)
+{
+  BLI_mempool *pool = BLI_mempool_create(sizeof(TestElem), 0, 64, flag);
+  TestElem *elems[1000];
+
+  for (int i = 0; i < 1000; i++) {
+    elems[i] = (TestElem *)BLI_mempool_calloc(pool);
+    EXPECT_EQ(elems[i]->index, 0);
+    elems[i]->self = elems[i];
+    elems[i]->index = i;
+  }
+  EXPECT_EQ(BLI_mempool_len(pool), 1000);
+  EXPECT_EQ(mempool_iter_count(pool), 1000);
+
+  for (int i = 0; i < 1000; i += 2) {
+    BLI_mempool_free(pool, elems[i]);
+  }
+  EXPECT_EQ(BLI_mempool_len(pool), 500);
+  EXPECT_EQ(mempool_iter_count(pool), 500);
+  for (int i = 1; i < 1000; i += 2) {
+    EXPECT_EQ(elems[i]->index, i);
+  }
+
+  TestElem **table = (TestElem **)BLI_mempool_as_tableN(pool, __func__);
+  for (int i = 0; i < 500; i++) {
+    EXPECT_EQ(table[i]->index % 2, 1);
+  }
+  MEM_freeN(table);
+
+  BLI_mempool_clear(pool);
+  EXPECT_EQ(BLI_mempool_len(pool), 0);
+  EXPECT_EQ(mempool_iter_count(pool), 0);
+  elems[0] = (TestElem *)BLI_mempool_alloc(pool);
+  elems[0]->self = elems[0];
+  EXPECT_EQ(BLI_mempool_len(pool), 1);
+  EXPECT_EQ(mempool_iter_count(pool), 1);
+
+  BLI_mempool_destroy(pool);
+}
+
+TEST(mempool, AllocFree)
+{
+  mempool_alloc_free_test(BLI_MEMPOOL_ALLOW_ITER);
+}
+
+TEST(mempool, AllocFreeThreadSafe)
+{
+  mempool_alloc_free_test(BLI_MEMPOOL_ALLOW_ITER | BLI_MEMPOOL_THREAD_SAFE);
+}
+
+/* -------------------------------------------------------------------- */
+/* Multiple Threads */
+
+#define THREAD_ELEMS_LEN 256
+
+typedef struct ThreadedData {
+  BLI_mempool *pool;
+  TestElem **elems;
+  int round;
+} ThreadedData;
+
+static void mempool_threaded_fn(void *__restrict userdata,
+                                const int iter,
+                                const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  ThreadedData *data = (ThreadedData *)userdata;
+  TestElem **elems = &data->elems[iter * THREAD_ELEMS_LEN];
+
+  /* Free the elements of the previous round, most likely allocated by another thread,
+   * then allocate new ones. */
+  for (int i = 0; i < THREAD_ELEMS_LEN; i++) {
+    if (elems[i] != NULL) {
+      EXPECT_EQ(elems[i]->self, elems[i]);
+      EXPECT_EQ(elems[i]->index, iter * THREAD_ELEMS_LEN + i);
+      EXPECT_EQ(elems[i]->thread_round, data->round - 1);
+      BLI_mempool_free(data->pool, elems[i]);
+    }
+    if (i % 3 != 0) {
+      elems[i] = (TestElem *)BLI_mempool_alloc(data->pool);
+      elems[i]->self = elems[i];
+      elems[i]->index = iter * THREAD_ELEMS_LEN + i;
+      elems[i]->thread_round = data->round;
+    }
+    else {
+      elems[i] = NULL;
+    }
+  }
+}
+
+TEST(mempool, ThreadSafeAllocFree)
+{
+  const int tasks_len = 512;
+  const int elems_len = tasks_len * THREAD_ELEMS_LEN;
+  int elems_used = 0;
+
+  BLI_system_num_threads_override_set(8);
+  BLI_threadapi_init();
+
+  ThreadedData data;
+  data.pool = BLI_mempool_create(
+      sizeof(TestElem), 0, 512, BLI_MEMPOOL_ALLOW_ITER | BLI_MEMPOOL_THREAD_SAFE);
+  data.elems = (TestElem **)MEM_callocN(sizeof(*data.elems) * (size_t)elems_len, __func__);
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  /* Hand out the tasks in a different order every round. */
+  settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+
+  for (data.round = 0; data.round < 8; data.round++) {
+    BLI_task_parallel_range(0, tasks_len, &data, mempool_threaded_fn, &settings);
+  }
+
+  for (int i = 0; i < elems_len; i++) {
+    if (data.elems[i]) {
+      elems_used++;
+    }
+  }
+  EXPECT_EQ(BLI_mempool_len(data.pool), elems_used);
+  EXPECT_EQ(mempool_iter_count(data.pool), elems_used);
+
+  MEM_freeN(data.elems);
+  BLI_mempool_destroy(data.pool);
+
+  BLI_threadapi_exit();
+  BLI_system_num_threads_override_set(0);
+}
+
+typedef struct FreeOtherThreadData {
+  BLI_mempool *pool;
+  void **elems;
+  int elems_len;
+} FreeOtherThreadData;
+
+static void *mempool_free_fn(void *userdata)
+{
+  FreeOtherThreadData *data = (FreeOtherThreadData *)userdata;
+  for (int i = 0; i < data->elems_len; i++) {
+    BLI_mempool_free(data->pool, data->elems[i]);
+  }
+  return NULL;
+}
+
+/* Elements freed by another thread are reused by the thread allocating them. */
+TEST(mempool, ThreadSafeFreeOtherThread)
+{
+  const int elems_len = 8192;
+
+  BLI_threadapi_init();
+
+  FreeOtherThreadData data;
+  data.pool = BLI_mempool_create(sizeof(TestElem), 0, 512, BLI_MEMPOOL_THREAD_SAFE);
+  data.elems = (void **)MEM_mallocN(sizeof(*data.elems) * (size_t)elems_len, __func__);
+  data.elems_len = elems_len;
+
+  for (int i = 0; i < elems_len; i++) {
+    data.elems[i] = BLI_mempool_alloc(data.pool);
+  }
+  GSet *elems_first = BLI_gset_ptr_new(__func__);
+  for (int i = 0; i < elems_len; i++) {
+    BLI_gset_insert(elems_first, data.elems[i]);
+  }
+
+  ListBase threads;
+  BLI_threadpool_init(&threads, mempool_free_fn, 1);
+  BLI_threadpool_insert(&threads, &data);
+  BLI_threadpool_end(&threads);
+  EXPECT_EQ(BLI_mempool_len(data.pool), 0);
+
+  /* Less than two chunks stay with the freeing thread. */
+  int reused = 0;
+  for (int i = 0; i < elems_len; i++) {
+    data.elems[i] = BLI_mempool_alloc(data.pool);
+    if (BLI_gset_haskey(elems_first, data.elems[i])) {
+      reused++;
+    }
+  }
+  EXPECT_GT(reused, elems_len * 3 / 4);
+  EXPECT_EQ(BLI_mempool_len(data.pool), elems_len);
+
+  BLI_gset_free(elems_first, NULL);
+  MEM_freeN(data.elems);
+  BLI_mempool_destroy(data.pool);
+
+  BLI_threadapi_exit();
+}
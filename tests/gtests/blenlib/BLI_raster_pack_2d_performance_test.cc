@@ -0,0 +1,166 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_boxpack_2d.h"
+#include "BLI_math_base.h"
+#include "BLI_math_geom.h"
+#include "BLI_math_vector.h"
+#include "BLI_rand.h"
+#include "BLI_raster_pack_2d.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "PIL_time.h"
+}
+
+#define TRIS_PER_ISLAND 4
+
+/* A mix of shapes like the islands of an unwrapped mesh: L shapes, triangles and strips. */
+static float (*islands_random_new(int islands_len, unsigned int seed))[TRIS_PER_ISLAND][3][2]
+{
+  float(*tris)[TRIS_PER_ISLAND][3][2] = (float(*)[TRIS_PER_ISLAND][3][2])MEM_callocN(
+      sizeof(*tris) * islands_len, __func__);
+  RNG *rng = BLI_rng_new(seed);
+  for (int i = 0; i < islands_len; i++) {
+    const float size = 0.2f + BLI_rng_get_float(rng) * BLI_rng_get_float(rng) * 3.0f;
+    const float a = size * (0.2f + BLI_rng_get_float(rng) * 0.8f);
+    const float b = size * (0.2f + BLI_rng_get_float(rng) * 0.8f);
+    float(*island)[3][2] = tris[i];
+    switch (i % 3) {
+      case 0:
+        /* L shape, two rectangles. */
+        copy_v2_fl2(island[0][0], 0.0f, 0.0f);
+        copy_v2_fl2(island[0][1], size, 0.0f);
+        copy_v2_fl2(island[0][2], size, b);
+        copy_v2_fl2(island[1][0], 0.0f, 0.0f);
+        copy_v2_fl2(island[1][1], size, b);
+        copy_v2_fl2(island[1][2], 0.0f, b);
+        copy_v2_fl2(island[2][0], 0.0f, b);
+        copy_v2_fl2(island[2][1], a, b);
+        copy_v2_fl2(island[2][2], a, size);
+        copy_v2_fl2(island[3][0], 0.0f, b);
+        copy_v2_fl2(island[3][1], a, size);
+        copy_v2_fl2(island[3][2], 0.0f, size);
+        break;
+      case 1:
+        /* Triangle. */
+        copy_v2_fl2(island[0][0], 0.0f, 0.0f);
+        copy_v2_fl2(island[0][1], size, 0.0f);
+        copy_v2_fl2(island[0][2], a, size);
+        copy_v2_v2(island[1][0], island[0][0]);
+        copy_v2_v2(island[1][1], island[0][0]);
+        copy_v2_v2(island[1][2], island[0][0]);
+        copy_v2_v2(island[2][0], island[0][0]);
+        copy_v2_v2(island[2][1], island[0][0]);
+        copy_v2_v2(island[2][2], island[0][0]);
+        copy_v2_v2(island[3][0], island[0][0]);
+        copy_v2_v2(island[3][1], island[0][0]);
+        copy_v2_v2(island[3][2], island[0][0]);
+        break;
+      case 2:
+        /* Diagonal strip. */
+        copy_v2_fl2(island[0][0], 0.0f, 0.0f);
+        copy_v2_fl2(island[0][1], a * 0.3f, 0.0f);
+        copy_v2_fl2(island[0][2], size, size);
+        copy_v2_fl2(island[1][0], 0.0f, 0.0f);
+        copy_v2_fl2(island[1][1], size, size);
+        copy_v2_fl2(island[1][2], size - a * 0.3f, size);
+        copy_v2_v2(island[2][0], island[0][0]);
+        copy_v2_v2(island[2][1], island[0][0]);
+        copy_v2_v2(island[2][2], island[0][0]);
+        copy_v2_v2(island[3][0], island[0][0]);
+        copy_v2_v2(island[3][1], island[0][0]);
+        copy_v2_v2(island[3][2], island[0][0]);
+        break;
+    }
+  }
+  BLI_rng_free(rng);
+  return tris;
+}
+
+static void raster_pack_2d_compare_test(int islands_len, int resolution)
+{
+  float(*tris)[TRIS_PER_ISLAND][3][2] = islands_random_new(islands_len, 1234);
+  double area = 0.0;
+
+  for (int i = 0; i < islands_len; i++) {
+    for (int j = 0; j < TRIS_PER_ISLAND; j++) {
+      area += (double)fabsf(area_tri_v2(tris[i][j][0], tris[i][j][1], tris[i][j][2]));
+    }
+  }
+
+  BLI_threadapi_init();
+
+  printf("\n========== STARTING %s (%d islands) ==========\n", __func__, islands_len);
+
+  /* Box packer, on the bounds of the islands. */
+  BoxPack *boxes = (BoxPack *)MEM_mallocN(sizeof(*boxes) * islands_len, __func__);
+  for (int i = 0; i < islands_len; i++) {
+    float min[2], max[2];
+    INIT_MINMAX2(min, max);
+    for (int j = 0; j < TRIS_PER_ISLAND; j++) {
+      for (int k = 0; k < 3; k++) {
+        minmax_v2v2_v2(min, max, tris[i][j][k]);
+      }
+    }
+    boxes[i].w = max[0] - min[0];
+    boxes[i].h = max[1] - min[1];
+    boxes[i].index = i;
+  }
+  float tot_width, tot_height;
+  double start = PIL_check_seconds_timer();
+  BLI_box_pack_2d(boxes, islands_len, &tot_width, &tot_height);
+  const double time_box = PIL_check_seconds_timer() - start;
+  const float side_box = max_ff(tot_width, tot_height);
+  const double efficiency_box = area / (double)(side_box * side_box);
+  printf("\tbox pack: %f seconds, %.1f%% of the area used\n", time_box, efficiency_box * 100.0);
+  MEM_freeN(boxes);
+
+  /* Raster packer. */
+  RasterPackIsland *islands = (RasterPackIsland *)MEM_callocN(sizeof(*islands) * islands_len,
+                                                              __func__);
+  for (int i = 0; i < islands_len; i++) {
+    islands[i].tris = tris[i];
+    islands[i].tris_len = TRIS_PER_ISLAND;
+  }
+  RasterPackParams params;
+  BLI_raster_pack_2d_params_defaults(&params);
+  params.resolution = resolution;
+  start = PIL_check_seconds_timer();
+  BLI_raster_pack_2d(islands, islands_len, &params, &tot_width, &tot_height);
+  const double time_raster = PIL_check_seconds_timer() - start;
+  const float side_raster = max_ff(tot_width, tot_height);
+  const double efficiency_raster = area / (double)(side_raster * side_raster);
+  printf("\traster pack (resolution %d): %f seconds, %.1f%% of the area used\n",
+         resolution,
+         time_raster,
+         efficiency_raster * 100.0);
+  MEM_freeN(islands);
+
+  EXPECT_GT(efficiency_raster, efficiency_box);
+
+  printf("========== ENDED %s ==========\n\n", __func__);
+
+  BLI_threadapi_exit();
+
+  MEM_freeN(tris);
+}
+
+TEST(raster_pack_2d, Compare1k)
+{
+  raster_pack_2d_compare_test(1000, 256);
+}
+
+TEST(raster_pack_2d, Compare5k)
+{
+  raster_pack_2d_compare_test(5000, 256);
+}
+
+TEST(raster_pack_2d, Compare5kHighResolution)
+{
+  raster_pack_2d_compare_test(5000, 512);
+}
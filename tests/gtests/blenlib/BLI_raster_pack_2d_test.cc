@@ -0,0 +1,179 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_math_base.h"
+#include "BLI_math_vector.h"
+#include "BLI_rand.h"
+#include "BLI_raster_pack_2d.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+}
+
+/* -------------------------------------------------------------------- */
+/* Helper Functions */
+
+/* Rectangles of random size, two triangles each. */
+static float (*rects_random_new(int rects_len, unsigned int seed))[3][2]
+{
+  float(*tris)[3][2] = (float(*)[3][2])MEM_mallocN(sizeof(*tris) * rects_len * 2, __func__);
+  RNG *rng = BLI_rng_new(seed);
+  for (int i = 0; i < rects_len; i++) {
+    const float w = 0.1f + BLI_rng_get_float(rng) * 2.0f;
+    const float h = 0.1f + BLI_rng_get_float(rng) * 2.0f;
+    const float x = BLI_rng_get_float(rng) * 10.0f, y = BLI_rng_get_float(rng) * 10.0f;
+    float(*rect_tris)[3][2] = &tris[i * 2];
+    copy_v2_fl2(rect_tris[0][0], x, y);
+    copy_v2_fl2(rect_tris[0][1], x + w, y);
+    copy_v2_fl2(rect_tris[0][2], x + w, y + h);
+    copy_v2_fl2(rect_tris[1][0], x, y);
+    copy_v2_fl2(rect_tris[1][1], x + w, y + h);
+    copy_v2_fl2(rect_tris[1][2], x, y + h);
+  }
+  BLI_rng_free(rng);
+  return tris;
+}
+
+static void island_bounds(const RasterPackIsland *island, float r_min[2], float r_max[2])
+{
+  const float cosine = cosf(island->angle), sine = sinf(island->angle);
+  INIT_MINMAX2(r_min, r_max);
+  for (uint i = 0; i < island->tris_len; i++) {
+    for (int j = 0; j < 3; j++) {
+      const float *co = island->tris[i][j];
+      const float co_packed[2] = {cosine * co[0] - sine * co[1] + island->offset[0],
+                                  sine * co[0] + cosine * co[1] + island->offset[1]};
+      minmax_v2v2_v2(r_min, r_max, co_packed);
+    }
+  }
+}
+
+static void raster_pack_rects_test(int rects_len, float margin, int rotations)
+{
+  float(*tris)[3][2] = rects_random_new(rects_len, 1234);
+  RasterPackIsland *islands = (RasterPackIsland *)MEM_callocN(sizeof(*islands) * rects_len,
+                                                              __func__);
+  RasterPackParams params;
+  float tot_width, tot_height;
+
+  BLI_threadapi_init();
+
+  for (int i = 0; i < rects_len; i++) {
+    islands[i].tris = &tris[i * 2];
+    islands[i].tris_len = 2;
+  }
+
+  BLI_raster_pack_2d_params_defaults(&params);
+  params.margin = margin;
+  params.rotations = rotations;
+  BLI_raster_pack_2d(islands, rects_len, &params, &tot_width, &tot_height);
+
+  const float eps = 1e-4f;
+  float(*bounds)[2][2] = (float(*)[2][2])MEM_mallocN(sizeof(*bounds) * rects_len, __func__);
+  for (int i = 0; i < rects_len; i++) {
+    island_bounds(&islands[i], bounds[i][0], bounds[i][1]);
+    EXPECT_GE(bounds[i][0][0], -eps);
+    EXPECT_GE(bounds[i][0][1], -eps);
+    EXPECT_LE(bounds[i][1][0], tot_width + eps);
+    EXPECT_LE(bounds[i][1][1], tot_height + eps);
+  }
+
+  /* Rotations are multiples of 90 degrees, so the bounds are the rectangles themselves. */
+  for (int i = 0; i < rects_len; i++) {
+    for (int j = i + 1; j < rects_len; j++) {
+      const float dist = max_ff(max_ff(bounds[j][0][0] - bounds[i][1][0],
+                                       bounds[i][0][0] - bounds[j][1][0]),
+                                max_ff(bounds[j][0][1] - bounds[i][1][1],
+                                       bounds[i][0][1] - bounds[j][1][1]));
+      EXPECT_GE(dist, margin - eps);
+    }
+  }
+
+  /* Same layout when packing again. */
+  RasterPackIsland *islands_again = (RasterPackIsland *)MEM_dupallocN(islands);
+  float tot_width_again, tot_height_again;
+  BLI_raster_pack_2d(islands_again, rects_len, &params, &tot_width_again, &tot_height_again);
+  EXPECT_EQ(tot_width, tot_width_again);
+  EXPECT_EQ(tot_height, tot_height_again);
+  for (int i = 0; i < rects_len; i++) {
+    EXPECT_EQ(islands[i].angle, islands_again[i].angle);
+    EXPECT_EQ(islands[i].offset[0], islands_again[i].offset[0]);
+    EXPECT_EQ(islands[i].offset[1], islands_again[i].offset[1]);
+  }
+
+  BLI_threadapi_exit();
+
+  MEM_freeN(islands_again);
+  MEM_freeN(bounds);
+  MEM_freeN(islands);
+  MEM_freeN(tris);
+}
+
+/* -------------------------------------------------------------------- */
+/* Tests */
+
+TEST(raster_pack_2d, Empty)
+{
+  RasterPackParams params;
+  float tot_width, tot_height;
+  BLI_raster_pack_2d_params_defaults(&params);
+  BLI_raster_pack_2d(NULL, 0, &params, &tot_width, &tot_height);
+  EXPECT_EQ(tot_width, 0.0f);
+  EXPECT_EQ(tot_height, 0.0f);
+}
+
+TEST(raster_pack_2d, Single)
+{
+  const float tris[1][3][2] = {{{1.0f, 1.0f}, {3.0f, 1.0f}, {1.0f, 2.0f}}};
+  RasterPackIsland island = {tris, 1};
+  RasterPackParams params;
+  float tot_width, tot_height, min[2], max[2];
+
+  BLI_raster_pack_2d_params_defaults(&params);
+  params.rotations = 1;
+  BLI_raster_pack_2d(&island, 1, &params, &tot_width, &tot_height);
+
+  island_bounds(&island, min, max);
+  EXPECT_EQ(island.angle, 0.0f);
+  EXPECT_NEAR(min[0], 0.0f, 1e-5f);
+  EXPECT_NEAR(min[1], 0.0f, 1e-5f);
+  /* The grid is coarse, but no coarser than the resolution. */
+  EXPECT_GE(tot_width, 2.0f);
+  EXPECT_GE(tot_height, 1.0f);
+  EXPECT_LE(tot_width, 2.0f * (1.0f + 2.0f / params.resolution));
+  EXPECT_LE(tot_height, 1.0f * (1.0f + 2.0f / params.resolution));
+}
+
+TEST(raster_pack_2d, Degenerate)
+{
+  const float tris[2][3][2] = {
+      {{1.0f, 1.0f}, {1.0f, 1.0f}, {1.0f, 1.0f}},
+      {{0.0f, 0.0f}, {1.0f, 0.0f}, {0.0f, 1.0f}},
+  };
+  RasterPackIsland islands[3] = {{&tris[0], 1}, {&tris[1], 1}, {NULL, 0}};
+  RasterPackParams params;
+  float tot_width, tot_height;
+
+  BLI_raster_pack_2d_params_defaults(&params);
+  BLI_raster_pack_2d(islands, 3, &params, &tot_width, &tot_height);
+  EXPECT_GT(tot_width, 0.0f);
+  EXPECT_GT(tot_height, 0.0f);
+}
+
+TEST(raster_pack_2d, Rects)
+{
+  raster_pack_rects_test(200, 0.0f, 4);
+}
+
+TEST(raster_pack_2d, RectsMargin)
+{
+  raster_pack_rects_test(200, 0.05f, 4);
+}
+
+TEST(raster_pack_2d, RectsNoRotation)
+{
+  raster_pack_rects_test(200, 0.0f, 1);
+}
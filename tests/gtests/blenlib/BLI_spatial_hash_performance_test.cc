@@ -0,0 +1,87 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_kdtree.h"
+#include "BLI_math_base.h"
+#include "BLI_rand.h"
+#include "BLI_spatial_hash.h"
+#include "BLI_threads.h"
+
+#include "PIL_time.h"
+}
+
+/* A noisy grid, similar to merging the copies of an array modifier or a scanned mesh. */
+static float (*points_grid_new(int points_len, unsigned int seed))[3]
+{
+  float(*points)[3] = (float(*)[3])MEM_mallocN(sizeof(*points) * points_len, __func__);
+  const int side = (int)powf((float)points_len, 1.0f / 3.0f) / 2 + 1;
+  RNG *rng = BLI_rng_new(seed);
+  for (int i = 0; i < points_len; i++) {
+    for (int j = 0; j < 3; j++) {
+      points[i][j] = (float)(BLI_rng_get_int(rng) % side) +
+                     (BLI_rng_get_float(rng) - 0.5f) * 1e-3f;
+    }
+  }
+  BLI_rng_free(rng);
+  return points;
+}
+
+static void spatial_hash_duplicates_test(int points_len)
+{
+  const float range = 1e-3f;
+  float(*points)[3] = points_grid_new(points_len, 1234);
+  int *duplicates = (int *)MEM_mallocN(sizeof(int) * points_len, __func__);
+
+  BLI_threadapi_init();
+
+  printf("\n========== STARTING %s (%d points) ==========\n", __func__, points_len);
+
+  double start = PIL_check_seconds_timer();
+  KDTree_3d *tree = BLI_kdtree_3d_new(points_len);
+  for (int i = 0; i < points_len; i++) {
+    BLI_kdtree_3d_insert(tree, i, points[i]);
+    duplicates[i] = -1;
+  }
+  BLI_kdtree_3d_balance(tree);
+  const int found_kdtree = BLI_kdtree_3d_calc_duplicates_fast(tree, range, true, duplicates);
+  BLI_kdtree_3d_free(tree);
+  printf("\tkdtree: %f seconds, %d duplicates\n", PIL_check_seconds_timer() - start, found_kdtree);
+
+  start = PIL_check_seconds_timer();
+  for (int i = 0; i < points_len; i++) {
+    duplicates[i] = -1;
+  }
+  const int found_hash = BLI_spatial_hash_3d_calc_duplicates(
+      points[0], sizeof(*points), points_len, range, duplicates);
+  printf("\tspatial hash: %f seconds, %d duplicates\n",
+         PIL_check_seconds_timer() - start,
+         found_hash);
+
+  EXPECT_EQ(found_kdtree, found_hash);
+
+  printf("========== ENDED %s ==========\n\n", __func__);
+
+  BLI_threadapi_exit();
+
+  MEM_freeN(duplicates);
+  MEM_freeN(points);
+}
+
+TEST(spatial_hash, Duplicates100k)
+{
+  spatial_hash_duplicates_test(100000);
+}
+
+TEST(spatial_hash, Duplicates1M)
+{
+  spatial_hash_duplicates_test(1000000);
+}
+
+TEST(spatial_hash, Duplicates10M)
+{
+  spatial_hash_duplicates_test(10000000);
+}
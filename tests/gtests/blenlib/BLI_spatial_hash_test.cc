@@ -0,0 +1,351 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_bitmap.h"
+#include "BLI_utildefines.h"
+#include "BLI_kdtree.h"
+#include "BLI_math_vector.h"
+#include "BLI_rand.h"
+#include "BLI_spatial_hash.h"
+#include "BLI_threads.h"
+}
+
+/* -------------------------------------------------------------------- */
+/* Helper Functions */
+
+/* Points rounded to a coarse grid so many of them are exactly or nearly the same. */
+static float (*points_random_new(int points_len, int round, float jitter, unsigned int seed))[3]
+{
+  float(*points)[3] = (float(*)[3])MEM_mallocN(sizeof(*points) * points_len, __func__);
+  RNG *rng = BLI_rng_new(seed);
+  for (int i = 0; i < points_len; i++) {
+    for (int j = 0; j < 3; j++) {
+      const float f = BLI_rng_get_float(rng) * 2.0f - 1.0f;
+      const float offset = (BLI_rng_get_float(rng) - 0.5f) * jitter;
+      points[i][j] = ((float)((int)(f * round)) / (float)round) + offset;
+    }
+  }
+  BLI_rng_free(rng);
+  return points;
+}
+
+static int find_root(int *parent, int index)
+{
+  while (parent[index] != index) {
+    index = parent[index];
+  }
+  return index;
+}
+
+/* Brute force version of #BLI_spatial_hash_3d_calc_clusters. */
+static int calc_clusters_brute_force(const float (*points)[3],
+                                     int points_len,
+                                     const BLI_bitmap *mask,
+                                     float range,
+                                     unsigned int max_neighbors,
+                                     int *r_clusters)
+{
+  int *parent = (int *)MEM_mallocN(sizeof(int) * points_len, __func__);
+  for (int i = 0; i < points_len; i++) {
+    parent[i] = i;
+  }
+  for (int i = 0; i < points_len; i++) {
+    if (mask && !BLI_BITMAP_TEST(mask, i)) {
+      continue;
+    }
+    unsigned int neighbors_len = 0;
+    for (int j = i + 1; j < points_len; j++) {
+      if (mask && !BLI_BITMAP_TEST(mask, j)) {
+        continue;
+      }
+      if (len_squared_v3v3(points[i], points[j]) <= range * range) {
+        const int root_a = find_root(parent, i);
+        const int root_b = find_root(parent, j);
+        parent[max_ii(root_a, root_b)] = min_ii(root_a, root_b);
+        if (++neighbors_len == max_neighbors) {
+          break;
+        }
+      }
+    }
+  }
+
+  int merged_len = 0;
+  for (int i = 0; i < points_len; i++) {
+    r_clusters[i] = -1;
+  }
+  for (int i = 0; i < points_len; i++) {
+    const int root = find_root(parent, i);
+    if (root != i) {
+      r_clusters[i] = root;
+      r_clusters[root] = root;
+      merged_len++;
+    }
+  }
+  MEM_freeN(parent);
+  return merged_len;
+}
+
+static void calc_duplicates_test(int points_len, int round, float range, bool use_keep)
+{
+  float(*points)[3] = points_random_new(points_len, round, range * 0.5f, 1234);
+  int *duplicates_kdtree = (int *)MEM_mallocN(sizeof(int) * points_len, __func__);
+  int *duplicates_hash = (int *)MEM_mallocN(sizeof(int) * points_len, __func__);
+
+  KDTree_3d *tree = BLI_kdtree_3d_new(points_len);
+  for (int i = 0; i < points_len; i++) {
+    BLI_kdtree_3d_insert(tree, i, points[i]);
+    duplicates_kdtree[i] = (use_keep && (i % 7) == 0) ? i : -1;
+    duplicates_hash[i] = duplicates_kdtree[i];
+  }
+  BLI_kdtree_3d_balance(tree);
+
+  const int found_kdtree = BLI_kdtree_3d_calc_duplicates_fast(
+      tree, range, true, duplicates_kdtree);
+  const int found_hash = BLI_spatial_hash_3d_calc_duplicates(
+      points[0], sizeof(*points), points_len, range, duplicates_hash);
+
+  EXPECT_NE(found_hash, 0);
+  EXPECT_EQ(found_kdtree, found_hash);
+  for (int i = 0; i < points_len; i++) {
+    EXPECT_EQ(duplicates_kdtree[i], duplicates_hash[i]);
+  }
+
+  BLI_kdtree_3d_free(tree);
+  MEM_freeN(duplicates_kdtree);
+  MEM_freeN(duplicates_hash);
+  MEM_freeN(points);
+}
+
+static void calc_clusters_test(
+    int points_len, int round, float range, unsigned int max_neighbors, bool use_mask)
+{
+  float(*points)[3] = points_random_new(points_len, round, range * 0.5f, 4321);
+  int *clusters_brute_force = (int *)MEM_mallocN(sizeof(int) * points_len, __func__);
+  int *clusters_hash = (int *)MEM_mallocN(sizeof(int) * points_len, __func__);
+  BLI_bitmap *mask = NULL;
+
+  if (use_mask) {
+    mask = BLI_BITMAP_NEW(points_len, __func__);
+    for (int i = 0; i < points_len; i++) {
+      if (i % 3) {
+        BLI_BITMAP_ENABLE(mask, i);
+      }
+    }
+  }
+
+  const int merged_brute_force = calc_clusters_brute_force(
+      points, points_len, mask, range, max_neighbors, clusters_brute_force);
+  const int merged_hash = BLI_spatial_hash_3d_calc_clusters(
+      points[0], sizeof(*points), points_len, mask, range, max_neighbors, clusters_hash);
+
+  EXPECT_NE(merged_hash, 0);
+  EXPECT_EQ(merged_brute_force, merged_hash);
+  for (int i = 0; i < points_len; i++) {
+    EXPECT_EQ(clusters_brute_force[i], clusters_hash[i]);
+  }
+
+  if (mask) {
+    MEM_freeN(mask);
+  }
+  MEM_freeN(clusters_brute_force);
+  MEM_freeN(clusters_hash);
+  MEM_freeN(points);
+}
+
+/* Merging the copies of an array modifier, each query point is a target point moved by less
+ * than the range. Compare against the nearest point found by the kdtree. */
+static void find_nearest_test(int points_len, int round, float range)
+{
+  float(*points)[3] = points_random_new(points_len, round, range * 0.5f, 5678);
+  float(*points_query)[3] = (float(*)[3])MEM_mallocN(sizeof(*points_query) * points_len,
+                                                       __func__);
+  int *nearest = (int *)MEM_mallocN(sizeof(int) * points_len, __func__);
+  const float offset[3] = {range * 0.5f, range * -0.25f, range * 0.125f};
+
+  KDTree_3d *tree = BLI_kdtree_3d_new(points_len);
+  for (int i = 0; i < points_len; i++) {
+    BLI_kdtree_3d_insert(tree, i, points[i]);
+    add_v3_v3v3(points_query[i], points[i], offset);
+  }
+  BLI_kdtree_3d_balance(tree);
+
+  BLI_spatial_hash_3d_find_nearest(points[0],
+                                   sizeof(*points),
+                                   points_len,
+                                   points_query[0],
+                                   sizeof(*points_query),
+                                   points_len,
+                                   range,
+                                   nearest);
+
+  int merged_kdtree = 0, merged_hash = 0;
+  for (int i = 0; i < points_len; i++) {
+    KDTreeNearest_3d nearest_kdtree;
+    const int index_kdtree = BLI_kdtree_3d_find_nearest(tree, points_query[i], &nearest_kdtree);
+    const bool found_kdtree = (index_kdtree != -1) && (nearest_kdtree.dist <= range);
+    merged_kdtree += found_kdtree;
+    merged_hash += (nearest[i] != -1);
+
+    EXPECT_EQ(found_kdtree, nearest[i] != -1);
+    if (found_kdtree && nearest[i] != -1) {
+      /* The index may differ when points are at the same distance. */
+      EXPECT_EQ(len_squared_v3v3(points_query[i], points[index_kdtree]),
+                len_squared_v3v3(points_query[i], points[nearest[i]]));
+    }
+  }
+  EXPECT_NE(merged_hash, 0);
+  EXPECT_EQ(merged_kdtree, merged_hash);
+
+  BLI_kdtree_3d_free(tree);
+  MEM_freeN(nearest);
+  MEM_freeN(points_query);
+  MEM_freeN(points);
+}
+
+/* -------------------------------------------------------------------- */
+/* Tests */
+
+class SpatialHashTest : public ::testing::Test {
+ protected:
+  static void SetUpTestCase()
+  {
+    BLI_threadapi_init();
+  }
+  static void TearDownTestCase()
+  {
+    BLI_threadapi_exit();
+  }
+};
+
+TEST_F(SpatialHashTest, Empty)
+{
+  float co[3] = {0.0f};
+  int duplicates[1] = {-1};
+  EXPECT_EQ(0, BLI_spatial_hash_3d_calc_duplicates(co, sizeof(co), 0, 0.1f, duplicates));
+  EXPECT_EQ(0, BLI_spatial_hash_3d_calc_clusters(co, sizeof(co), 0, NULL, 0.1f, 0, duplicates));
+}
+
+TEST_F(SpatialHashTest, DuplicatesSingle)
+{
+  float co[3] = {0.0f};
+  int duplicates[1] = {-1};
+  EXPECT_EQ(0, BLI_spatial_hash_3d_calc_duplicates(co, sizeof(co), 1, 0.1f, duplicates));
+  EXPECT_EQ(-1, duplicates[0]);
+}
+
+/* The kdtree doesn't find points at the exact same location with a zero range,
+ * so check against the coordinates directly. */
+TEST_F(SpatialHashTest, DuplicatesExact)
+{
+  const int points_len = 10000;
+  float(*points)[3] = points_random_new(points_len, 20, 0.0f, 1234);
+  int *duplicates = (int *)MEM_mallocN(sizeof(int) * points_len, __func__);
+  for (int i = 0; i < points_len; i++) {
+    duplicates[i] = -1;
+  }
+
+  const int found = BLI_spatial_hash_3d_calc_duplicates(
+      points[0], sizeof(*points), points_len, 0.0f, duplicates);
+
+  int found_check = 0;
+  for (int i = 0; i < points_len; i++) {
+    int first = i;
+    for (int j = 0; j < i; j++) {
+      if (equals_v3v3(points[i], points[j])) {
+        first = j;
+        break;
+      }
+    }
+    if (first != i) {
+      EXPECT_EQ(first, duplicates[i]);
+      found_check++;
+    }
+    else {
+      EXPECT_TRUE(ELEM(duplicates[i], -1, i));
+    }
+  }
+  EXPECT_NE(found, 0);
+  EXPECT_EQ(found_check, found);
+
+  MEM_freeN(duplicates);
+  MEM_freeN(points);
+}
+
+/* All points are within range of each other,
+ * the number of pairs is far larger than the number of points. */
+TEST_F(SpatialHashTest, DuplicatesSameLocation)
+{
+  const int points_len = 100000;
+  float(*points)[3] = (float(*)[3])MEM_callocN(sizeof(*points) * points_len, __func__);
+  int *duplicates = (int *)MEM_mallocN(sizeof(int) * points_len, __func__);
+  for (int i = 0; i < points_len; i++) {
+    duplicates[i] = -1;
+  }
+
+  EXPECT_EQ(points_len - 1,
+            BLI_spatial_hash_3d_calc_duplicates(
+                points[0], sizeof(*points), points_len, 0.1f, duplicates));
+  for (int i = 0; i < points_len; i++) {
+    EXPECT_EQ(0, duplicates[i]);
+  }
+
+  MEM_freeN(duplicates);
+  MEM_freeN(points);
+}
+
+TEST_F(SpatialHashTest, DuplicatesRange)
+{
+  calc_duplicates_test(10000, 20, 0.01f, false);
+}
+
+TEST_F(SpatialHashTest, DuplicatesRangeLarge)
+{
+  calc_duplicates_test(2000, 100, 0.1f, false);
+}
+
+TEST_F(SpatialHashTest, DuplicatesKeep)
+{
+  calc_duplicates_test(10000, 20, 0.01f, true);
+}
+
+TEST_F(SpatialHashTest, Clusters)
+{
+  calc_clusters_test(5000, 20, 0.01f, 0, false);
+}
+
+TEST_F(SpatialHashTest, ClustersChained)
+{
+  calc_clusters_test(5000, 100, 0.03f, 0, false);
+}
+
+TEST_F(SpatialHashTest, ClustersMaxNeighbors)
+{
+  calc_clusters_test(5000, 20, 0.01f, 1, false);
+}
+
+TEST_F(SpatialHashTest, ClustersMask)
+{
+  calc_clusters_test(5000, 20, 0.01f, 2, true);
+}
+
+TEST_F(SpatialHashTest, FindNearest)
+{
+  find_nearest_test(10000, 20, 0.01f);
+}
+
+TEST_F(SpatialHashTest, FindNearestRangeLarge)
+{
+  find_nearest_test(2000, 100, 0.1f);
+}
+
+TEST_F(SpatialHashTest, FindNearestEmpty)
+{
+  float co[3] = {0.0f};
+  int nearest[1] = {0};
+  BLI_spatial_hash_3d_find_nearest(co, sizeof(co), 0, co, sizeof(co), 1, 0.1f, nearest);
+  EXPECT_EQ(-1, nearest[0]);
+}
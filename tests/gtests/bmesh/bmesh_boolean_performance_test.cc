@@ -0,0 +1,42 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "bmesh_boolean_scene.h"
+
+extern "C" {
+#include "BLI_threads.h"
+}
+
+static void bm_boolean_performance_test(int subdivisions)
+{
+  BLI_threadapi_init();
+
+  printf("\n========== STARTING %s (%d subdivisions) ==========\n", __func__, subdivisions);
+
+  for (int i = 0; i < 2; i++) {
+    const bool use_threading = (i == 1);
+    double time;
+    BMesh *bm = bm_boolean_scene_do(subdivisions, use_threading, &time);
+    printf("\t%s: %f seconds, result has %d vertices and %d faces\n",
+           use_threading ? "Threaded" : "Serial",
+           time,
+           bm->totvert,
+           bm->totface);
+    BM_mesh_free(bm);
+  }
+
+  printf("========== ENDED %s ==========\n\n", __func__);
+
+  BLI_threadapi_exit();
+}
+
+TEST(bmesh_boolean, Difference10k)
+{
+  bm_boolean_performance_test(5);
+}
+
+TEST(bmesh_boolean, Difference40k)
+{
+  bm_boolean_performance_test(6);
+}
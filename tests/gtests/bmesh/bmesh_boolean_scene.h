@@ -0,0 +1,105 @@
+/* Apache License, Version 2.0 */
+
+#ifndef __BMESH_BOOLEAN_SCENE_H__
+#define __BMESH_BOOLEAN_SCENE_H__
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_math.h"
+#include "BLI_utildefines.h"
+#include "bmesh.h"
+
+extern "C" {
+#include "PIL_time.h"
+
+#include "tools/bmesh_intersect.h"
+}
+
+#define BM_FACE_TAG BM_ELEM_DRAW
+
+static int bm_face_isect_pair(BMFace *f, void *UNUSED(user_data))
+{
+  return BM_elem_flag_test(f, BM_FACE_TAG) ? 1 : 0;
+}
+
+static void bm_boolean_scene_icosphere_add(BMesh *bm,
+                                           int subdivisions,
+                                           const float offset[3],
+                                           bool tag)
+{
+  float mat[4][4];
+  BMOperator op;
+
+  unit_m4(mat);
+  copy_v3_v3(mat[3], offset);
+
+  BMO_op_initf(bm,
+               &op,
+               0,
+               "create_icosphere subdivisions=%i diameter=%f matrix=%m4 calc_uvs=%b",
+               subdivisions,
+               1.0f,
+               mat,
+               false);
+  BMO_op_exec(bm, &op);
+
+  if (tag) {
+    BMOIter oiter;
+    BMVert *v;
+    BMO_ITER (v, &oiter, op.slots_out, "verts.out", BM_VERT) {
+      BMIter iter;
+      BMFace *f;
+      BM_ITER_ELEM (f, &iter, v, BM_FACES_OF_VERT) {
+        BM_elem_flag_enable(f, BM_FACE_TAG);
+      }
+    }
+  }
+  BMO_op_finish(bm, &op);
+}
+
+/* Difference of two overlapping spheres, the same way the boolean modifier runs it. The time
+ * spent in the intersection is returned in r_time when it's not NULL. */
+static BMesh *bm_boolean_scene_do(int subdivisions, bool use_threading, double *r_time)
+{
+  const float offset_a[3] = {0.0f, 0.0f, 0.0f};
+  const float offset_b[3] = {0.5f, 0.25f, 0.125f};
+
+  BMeshCreateParams bm_params = {0};
+  bm_params.use_toolflags = true;
+  BMesh *bm = BM_mesh_create(&bm_mesh_allocsize_default, &bm_params);
+
+  bm_boolean_scene_icosphere_add(bm, subdivisions, offset_a, false);
+  bm_boolean_scene_icosphere_add(bm, subdivisions, offset_b, true);
+
+  const int looptris_tot = poly_to_tri_count(bm->totface, bm->totloop);
+  BMLoop *(*looptris)[3] = (BMLoop * (*)[3])
+      MEM_mallocN(sizeof(*looptris) * looptris_tot, __func__);
+  int tottri;
+  BM_mesh_calc_tessellation(bm, looptris, &tottri);
+
+  const double start = PIL_check_seconds_timer();
+  const bool changed = BM_mesh_intersect_ex(bm,
+                                            looptris,
+                                            tottri,
+                                            bm_face_isect_pair,
+                                            NULL,
+                                            false,
+                                            false,
+                                            true,
+                                            true,
+                                            false,
+                                            false,
+                                            BMESH_ISECT_BOOLEAN_DIFFERENCE,
+                                            1e-6f,
+                                            use_threading);
+  if (r_time) {
+    *r_time = PIL_check_seconds_timer() - start;
+  }
+
+  EXPECT_TRUE(changed);
+
+  MEM_freeN(looptris);
+  return bm;
+}
+
+#endif /* __BMESH_BOOLEAN_SCENE_H__ */
@@ -0,0 +1,50 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "bmesh_boolean_scene.h"
+
+extern "C" {
+#include "BLI_threads.h"
+}
+
+/* The threaded result must match the serial one exactly, element for element. */
+static void bm_boolean_test(int subdivisions)
+{
+  BLI_threadapi_init();
+
+  BMesh *bm_serial = bm_boolean_scene_do(subdivisions, false, NULL);
+  BMesh *bm_threaded = bm_boolean_scene_do(subdivisions, true, NULL);
+
+  EXPECT_EQ(bm_threaded->totvert, bm_serial->totvert);
+  EXPECT_EQ(bm_threaded->totedge, bm_serial->totedge);
+  EXPECT_EQ(bm_threaded->totface, bm_serial->totface);
+  EXPECT_EQ(bm_threaded->totloop, bm_serial->totloop);
+
+  if (bm_threaded->totvert == bm_serial->totvert) {
+    BM_mesh_elem_table_ensure(bm_serial, BM_VERT);
+    BM_mesh_elem_table_ensure(bm_threaded, BM_VERT);
+    int mismatch = 0;
+    for (int i = 0; i < bm_serial->totvert; i++) {
+      if (!equals_v3v3(bm_serial->vtable[i]->co, bm_threaded->vtable[i]->co)) {
+        mismatch++;
+      }
+    }
+    EXPECT_EQ(mismatch, 0);
+  }
+
+  BM_mesh_free(bm_serial);
+  BM_mesh_free(bm_threaded);
+
+  BLI_threadapi_exit();
+}
+
+TEST(bmesh_boolean, Difference640)
+{
+  bm_boolean_test(3);
+}
+
+TEST(bmesh_boolean, Difference10k)
+{
+  bm_boolean_test(5);
+}
@@ -0,0 +1,99 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include "BLI_utildefines.h"
+}
+
+#include "MEM_guardedalloc.h"
+
+/* Many small allocations from worker threads, like BMesh operators or depsgraph evaluation:
+ * every thread allocates a batch of blocks, then frees them in a different order. */
+
+#define BLOCKS_LEN 10000
+#define ROUNDS_LEN 100
+
+namespace {
+
+size_t test_len(const size_t i)
+{
+  return 8 + (i * 97) % 248;
+}
+
+void *alloc_system(size_t len)
+{
+  return malloc(len);
+}
+
+void *alloc_guarded(size_t len)
+{
+  return MEM_mallocN(len, __func__);
+}
+
+void alloc_throughput_run(const char *name,
+                          const int threads_len,
+                          void *(*alloc_fn)(size_t),
+                          void (*free_fn)(void *))
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < threads_len; t++) {
+    threads.emplace_back([=]() {
+      std::vector<void *> ptrs(BLOCKS_LEN);
+      for (int round = 0; round < ROUNDS_LEN; round++) {
+        for (size_t i = 0; i < BLOCKS_LEN; i++) {
+          ptrs[i] = alloc_fn(test_len(i + (size_t)round));
+          *(size_t *)ptrs[i] = i;
+        }
+        for (size_t i = 0; i < BLOCKS_LEN; i++) {
+          free_fn(ptrs[(i * 7919) % BLOCKS_LEN]);
+        }
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  const std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+  const double allocs_len = (double)threads_len * BLOCKS_LEN * ROUNDS_LEN;
+  printf("\t%s, %d threads: %f seconds, %.1f M allocations per second\n",
+         name,
+         threads_len,
+         time.count(),
+         allocs_len / time.count() * 1e-6);
+}
+
+void alloc_throughput_test(const int threads_len)
+{
+  printf("\n========== STARTING %s (%d threads) ==========\n", __func__, threads_len);
+
+  alloc_throughput_run("malloc", threads_len, alloc_system, free);
+  alloc_throughput_run("MEM_mallocN", threads_len, alloc_guarded, MEM_freeN);
+
+  printf("========== ENDED %s ==========\n\n", __func__);
+}
+
+}  // namespace
+
+TEST(guardedalloc, AllocThroughput1Thread)
+{
+  alloc_throughput_test(1);
+}
+
+TEST(guardedalloc, AllocThroughput4Threads)
+{
+  alloc_throughput_test(4);
+}
+
+TEST(guardedalloc, AllocThroughput16Threads)
+{
+  alloc_throughput_test(16);
+}
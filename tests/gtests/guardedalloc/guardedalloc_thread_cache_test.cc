@@ -0,0 +1,145 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include "BLI_utildefines.h"
+}
+
+#include "MEM_guardedalloc.h"
+
+namespace {
+
+/* Sizes around the thread cache size classes and above them. */
+size_t test_len(const size_t i)
+{
+  return (i * 37) % 700;
+}
+
+void fill(void *ptr, const size_t len, const uchar value)
+{
+  memset(ptr, value, len);
+}
+
+void check_and_free(void *ptr, const size_t len, const uchar value)
+{
+  const uchar *data = (const uchar *)ptr;
+  for (size_t i = 0; i < len; i++) {
+    if (data[i] != value) {
+      ADD_FAILURE() << "block changed while in use";
+      break;
+    }
+  }
+  MEM_freeN(ptr);
+}
+
+}  // namespace
+
+TEST(guardedalloc, ThreadCacheReuse)
+{
+  const size_t mem_in_use = MEM_get_memory_in_use();
+  const size_t mem_allocated = MEM_get_memory_allocated();
+  const unsigned int blocks_in_use = MEM_get_memory_blocks_in_use();
+  std::vector<void *> ptrs(2000);
+
+  for (int pass = 0; pass < 3; pass++) {
+    for (size_t i = 0; i < ptrs.size(); i++) {
+      const size_t len = test_len(i);
+      if (pass == 1) {
+        /* Reused blocks are cleared too. */
+        ptrs[i] = MEM_callocN(len, __func__);
+        for (size_t j = 0; j < len; j++) {
+          EXPECT_EQ(((uchar *)ptrs[i])[j], 0);
+        }
+      }
+      else {
+        ptrs[i] = MEM_mallocN(len, __func__);
+      }
+      EXPECT_EQ(MEM_allocN_len(ptrs[i]), (len + 3) & ~(size_t)3);
+      fill(ptrs[i], len, (uchar)i);
+    }
+    EXPECT_EQ(MEM_get_memory_blocks_in_use(), blocks_in_use + ptrs.size());
+    /* Rounding to the size classes is counted in the allocated memory only. */
+    EXPECT_GE(MEM_get_memory_allocated() - mem_allocated, MEM_get_memory_in_use() - mem_in_use);
+
+    for (size_t i = 0; i < ptrs.size(); i++) {
+      check_and_free(ptrs[i], test_len(i), (uchar)i);
+    }
+    /* Cached blocks don't count as used. */
+    EXPECT_EQ(MEM_get_memory_in_use(), mem_in_use);
+    EXPECT_EQ(MEM_get_memory_allocated(), mem_allocated);
+    EXPECT_EQ(MEM_get_memory_blocks_in_use(), blocks_in_use);
+  }
+}
+
+TEST(guardedalloc, ThreadCacheReallocDup)
+{
+  const size_t mem_in_use = MEM_get_memory_in_use();
+  char *str = (char *)MEM_mallocN(8, __func__);
+  memcpy(str, "abcdefg", 8);
+
+  for (size_t len = 16; len < 2048; len *= 2) {
+    str = (char *)MEM_reallocN(str, len);
+    EXPECT_STREQ(str, "abcdefg");
+    char *str_dup = (char *)MEM_dupallocN(str);
+    EXPECT_STREQ(str_dup, "abcdefg");
+    MEM_freeN(str_dup);
+  }
+  MEM_freeN(str);
+
+  EXPECT_EQ(MEM_get_memory_in_use(), mem_in_use);
+}
+
+/* Blocks allocated on one thread and freed on another, while threads come and go. */
+TEST(guardedalloc, ThreadCacheCrossThreadFree)
+{
+  const size_t mem_in_use = MEM_get_memory_in_use();
+  const size_t mem_allocated = MEM_get_memory_allocated();
+  const unsigned int blocks_in_use = MEM_get_memory_blocks_in_use();
+  const int threads_len = 8;
+  const size_t blocks_len = 5000;
+  /* Blocks of the previous and current round, per thread. */
+  std::vector<void *> ptrs[2][threads_len];
+
+  for (int round = 0; round < 5; round++) {
+    std::vector<void *> *ptrs_prev = ptrs[(round + 1) % 2];
+    std::vector<void *> *ptrs_curr = ptrs[round % 2];
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threads_len; t++) {
+      threads.emplace_back([=]() {
+        /* Free what the next thread allocated last round, while allocating new blocks. */
+        const int t_other = (t + 1) % threads_len;
+        ptrs_curr[t].resize(blocks_len);
+        for (size_t i = 0; i < blocks_len; i++) {
+          if (!ptrs_prev[t_other].empty()) {
+            check_and_free(ptrs_prev[t_other][i], test_len(i + (size_t)t_other), (uchar)t_other);
+          }
+          const size_t len = test_len(i + (size_t)t);
+          ptrs_curr[t][i] = MEM_mallocN(len, __func__);
+          fill(ptrs_curr[t][i], len, (uchar)t);
+        }
+      });
+    }
+    for (std::thread &thread : threads) {
+      thread.join();
+    }
+    for (int t = 0; t < threads_len; t++) {
+      ptrs_prev[t].clear();
+    }
+    EXPECT_EQ(MEM_get_memory_blocks_in_use(), blocks_in_use + threads_len * blocks_len);
+  }
+
+  for (int t = 0; t < threads_len; t++) {
+    for (int b = 0; b < 2; b++) {
+      for (size_t i = 0; i < ptrs[b][t].size(); i++) {
+        check_and_free(ptrs[b][t][i], test_len(i + (size_t)t), (uchar)t);
+      }
+    }
+  }
+  EXPECT_EQ(MEM_get_memory_in_use(), mem_in_use);
+  EXPECT_EQ(MEM_get_memory_allocated(), mem_allocated);
+  EXPECT_EQ(MEM_get_memory_blocks_in_use(), blocks_in_use);
+}
@@ -0,0 +1,91 @@
+/* Apache License, Version 2.0 */
+
+#ifndef __BPH_IMPLICIT_GRID_H__
+#define __BPH_IMPLICIT_GRID_H__
+
+/* Square grid of cloth held by its first row, stretched so all springs are under tension,
+ * used to set up the implicit solver like a cloth step does. */
+
+extern "C" {
+#include "BLI_math.h"
+#include "BLI_utildefines.h"
+
+#include "BPH_mass_spring.h"
+#include "implicit.h"
+}
+
+#define GRID_SPACING 0.1f
+#define GRID_STRETCH 1.05f
+#define GRID_MASS 0.3f
+
+static int grid_num_springs(int res)
+{
+  /* Structural and shear springs. */
+  return 2 * res * (res - 1) + 2 * (res - 1) * (res - 1);
+}
+
+static Implicit_Data *grid_solver_create(int res)
+{
+  Implicit_Data *id = BPH_mass_spring_solver_create(res * res, grid_num_springs(res));
+  float I3[3][3];
+  unit_m3(I3);
+
+  for (int y = 0; y < res; y++) {
+    for (int x = 0; x < res; x++) {
+      const int i = y * res + x;
+      const float co[3] = {x * GRID_SPACING * GRID_STRETCH,
+                           y * GRID_SPACING * GRID_STRETCH,
+                           0.01f * sinf(x * 0.7f) * cosf(y * 1.3f)};
+      const float vel[3] = {0.0f, 0.0f, -0.1f * sinf(i * 0.37f)};
+
+      BPH_mass_spring_set_vertex_mass(id, i, GRID_MASS);
+      BPH_mass_spring_set_rest_transform(id, i, I3);
+      BPH_mass_spring_set_motion_state(id, i, co, vel);
+    }
+  }
+
+  return id;
+}
+
+static void grid_spring(Implicit_Data *id, int i, int j, float restlen, float stiffness)
+{
+  BPH_mass_spring_force_spring_linear(
+      id, i, j, restlen, stiffness, 5.0f, stiffness, 5.0f, false, false, 0.0f);
+}
+
+/* Constraints and forces, as computed at the start of a cloth step. */
+static void grid_solver_setup(Implicit_Data *id, int res, float stiffness)
+{
+  const float ZERO[3] = {0.0f, 0.0f, 0.0f};
+  const float gravity[3] = {0.0f, 0.0f, -9.81f};
+  const float diag = GRID_SPACING * (float)M_SQRT2;
+
+  BPH_mass_spring_clear_constraints(id);
+  for (int x = 0; x < res; x++) {
+    BPH_mass_spring_add_constraint_ndof0(id, x, ZERO);
+  }
+
+  BPH_mass_spring_clear_forces(id);
+
+  for (int i = 0; i < res * res; i++) {
+    BPH_mass_spring_force_gravity(id, i, GRID_MASS, gravity);
+  }
+
+  for (int y = 0; y < res; y++) {
+    for (int x = 0; x < res; x++) {
+      const int i = y * res + x;
+      if (x + 1 < res) {
+        grid_spring(id, i, i + 1, GRID_SPACING, stiffness);
+      }
+      if (y + 1 < res) {
+        grid_spring(id, i, i + res, GRID_SPACING, stiffness);
+      }
+      if (x + 1 < res && y + 1 < res) {
+        grid_spring(id, i, i + res + 1, diag, stiffness);
+        grid_spring(id, i + 1, i + res, diag, stiffness);
+      }
+    }
+  }
+}
+
+#endif /* __BPH_IMPLICIT_GRID_H__ */
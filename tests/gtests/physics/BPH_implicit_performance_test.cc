@@ -0,0 +1,80 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "BPH_implicit_grid.h"
+
+extern "C" {
+#include "BLI_threads.h"
+
+#include "BKE_cloth.h"
+
+#include "PIL_time.h"
+}
+
+#define NUM_STEPS 4
+#define GRID_STIFFNESS 500.0f
+#define GRID_DT 0.2f
+
+/* Compare the legacy solver with the block CSR solver on garment sized grids. */
+static void implicit_solve_test_do(const char *name,
+                                   int res,
+                                   int linear_solver,
+                                   int preconditioner)
+{
+  Implicit_Data *id = grid_solver_create(res);
+  BPH_mass_spring_solver_set_method(id, linear_solver, preconditioner);
+
+  double solve_time = 0.0;
+  int iterations = 0;
+
+  for (int step = 0; step < NUM_STEPS; step++) {
+    ImplicitSolverResult result;
+
+    grid_solver_setup(id, res, GRID_STIFFNESS);
+
+    const double start = PIL_check_seconds_timer();
+    BPH_mass_spring_solve_velocities(id, GRID_DT, &result);
+    solve_time += PIL_check_seconds_timer() - start;
+    iterations += result.iterations;
+
+    BPH_mass_spring_solve_positions(id, GRID_DT);
+    BPH_mass_spring_apply_result(id);
+  }
+
+  printf("\t%s (%d vertices): %fs per step, %d iterations, %.1f iterations/s\n",
+         name,
+         res * res,
+         solve_time / NUM_STEPS,
+         iterations,
+         iterations / solve_time);
+
+  BPH_mass_spring_solver_free(id);
+}
+
+static void implicit_solve_test(int res)
+{
+  BLI_threadapi_init();
+
+  implicit_solve_test_do("CG", res, CLOTH_LINEAR_SOLVER_CG, CLOTH_PRECONDITIONER_NONE);
+  implicit_solve_test_do(
+      "Block CSR", res, CLOTH_LINEAR_SOLVER_BLOCK_CSR, CLOTH_PRECONDITIONER_NONE);
+  implicit_solve_test_do(
+      "Block CSR Jacobi", res, CLOTH_LINEAR_SOLVER_BLOCK_CSR, CLOTH_PRECONDITIONER_JACOBI);
+  implicit_solve_test_do("Block CSR Block Jacobi",
+                         res,
+                         CLOTH_LINEAR_SOLVER_BLOCK_CSR,
+                         CLOTH_PRECONDITIONER_BLOCK_JACOBI);
+
+  BLI_threadapi_exit();
+}
+
+TEST(implicit, Solve10k)
+{
+  implicit_solve_test(100);
+}
+
+TEST(implicit, Solve200k)
+{
+  implicit_solve_test(450);
+}
@@ -0,0 +1,104 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BPH_implicit_grid.h"
+
+extern "C" {
+#include "BLI_threads.h"
+
+#include "BKE_cloth.h"
+}
+
+/* Large enough for several solver chunks (CG_CSR_CHUNK_SIZE), so the threaded reductions run. */
+#define GRID_RES 48
+#define GRID_STIFFNESS 500.0f
+#define GRID_DT 0.2f
+
+/* Solve one step of the grid and return the new velocities. */
+static float (*grid_solve(int linear_solver, int preconditioner, ImplicitSolverResult *result))[3]
+{
+  const int numverts = GRID_RES * GRID_RES;
+  Implicit_Data *id = grid_solver_create(GRID_RES);
+  float(*vel)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * numverts, __func__);
+
+  BPH_mass_spring_solver_set_method(id, linear_solver, preconditioner);
+  grid_solver_setup(id, GRID_RES, GRID_STIFFNESS);
+  BPH_mass_spring_solve_velocities(id, GRID_DT, result);
+
+  for (int i = 0; i < numverts; i++) {
+    BPH_mass_spring_get_new_velocity(id, i, vel[i]);
+  }
+
+  BPH_mass_spring_solver_free(id);
+  return vel;
+}
+
+static float grid_relative_error(float (*a)[3], float (*b)[3])
+{
+  float diff = 0.0f, norm = 0.0f;
+  for (int i = 0; i < GRID_RES * GRID_RES; i++) {
+    diff += len_squared_v3v3(a[i], b[i]);
+    norm += len_squared_v3(b[i]);
+  }
+  return sqrtf(diff / norm);
+}
+
+static void grid_test_preconditioner(int preconditioner, float max_error)
+{
+  ImplicitSolverResult result_cg, result_csr;
+
+  BLI_threadapi_init();
+
+  float(*vel_cg)[3] = grid_solve(CLOTH_LINEAR_SOLVER_CG, CLOTH_PRECONDITIONER_NONE, &result_cg);
+  float(*vel_csr)[3] = grid_solve(CLOTH_LINEAR_SOLVER_BLOCK_CSR, preconditioner, &result_csr);
+
+  EXPECT_EQ(result_cg.status, BPH_SOLVER_SUCCESS);
+  EXPECT_EQ(result_csr.status, BPH_SOLVER_SUCCESS);
+  EXPECT_GT(result_csr.iterations, 0);
+  EXPECT_LE(result_csr.iterations, result_cg.iterations);
+  EXPECT_LT(grid_relative_error(vel_csr, vel_cg), max_error);
+
+  MEM_freeN(vel_cg);
+  MEM_freeN(vel_csr);
+
+  BLI_threadapi_exit();
+}
+
+TEST(implicit, BlockCSRNoPreconditioner)
+{
+  grid_test_preconditioner(CLOTH_PRECONDITIONER_NONE, 1e-4f);
+}
+
+TEST(implicit, BlockCSRJacobi)
+{
+  grid_test_preconditioner(CLOTH_PRECONDITIONER_JACOBI, 1e-2f);
+}
+
+TEST(implicit, BlockCSRBlockJacobi)
+{
+  grid_test_preconditioner(CLOTH_PRECONDITIONER_BLOCK_JACOBI, 1e-2f);
+}
+
+/* Reductions must not depend on thread scheduling, or simulations would not be repeatable. */
+TEST(implicit, BlockCSRDeterministic)
+{
+  ImplicitSolverResult result_a, result_b;
+
+  BLI_threadapi_init();
+
+  float(*vel_a)[3] = grid_solve(
+      CLOTH_LINEAR_SOLVER_BLOCK_CSR, CLOTH_PRECONDITIONER_BLOCK_JACOBI, &result_a);
+  float(*vel_b)[3] = grid_solve(
+      CLOTH_LINEAR_SOLVER_BLOCK_CSR, CLOTH_PRECONDITIONER_BLOCK_JACOBI, &result_b);
+
+  EXPECT_EQ(result_a.iterations, result_b.iterations);
+  EXPECT_EQ(memcmp(vel_a, vel_b, sizeof(float[3]) * GRID_RES * GRID_RES), 0);
+
+  MEM_freeN(vel_a);
+  MEM_freeN(vel_b);
+
+  BLI_threadapi_exit();
+}
@@ -4,6 +4,8 @@
 import unittest
 from mathutils import Matrix, Vector, Quaternion
 from mathutils import kdtree, geometry
+from mathutils.bvhtree import BVHTree
+from array import array
 import math
 
 # keep globals immutable
@@ -488,6 +490,98 @@ class KDTreeTesting(unittest.TestCase):
             k.find((0,) * 3, filter=lambda i: None)
 
 
+    def test_kdtree_find_batch(self):
+        k = self.kdtree_create_grid_3d(4)
+        points = [(0.1, 0.2, 0.3), (-1.0, 0.5, 2.0), (0.7, 0.7, 0.7), (0.5, 0.5, 0.5)] * 100
+        co = array('f', [v for p in points for v in p])
+        indices = array('i', [0]) * len(points)
+        locations = array('f', [0.0]) * (len(points) * 3)
+        distances = array('f', [0.0]) * len(points)
+        found = k.find_batch(co, indices, locations=locations, distances=distances)
+        self.assertEqual(found, len(points))
+        for i, p in enumerate(points):
+            co_find, index_find, dist_find = k.find(p)
+            self.assertEqual(indices[i], index_find)
+            self.assertAlmostEqualVector(locations[i * 3:i * 3 + 3], co_find, places=5)
+            self.assertAlmostEqual(distances[i], dist_find, places=5)
+
+    def test_kdtree_find_batch_empty(self):
+        k = kdtree.KDTree(0)
+        k.balance()
+        co = array('f', [0.5] * 6)
+        indices = array('i', [0] * 2)
+        self.assertEqual(k.find_batch(co, indices), 0)
+        self.assertEqual(list(indices), [-1, -1])
+
+    def test_kdtree_find_batch_invalid(self):
+        k = self.kdtree_create_grid_3d(2)
+        co = array('f', [0.0] * 6)
+        # wrong type
+        with self.assertRaises(TypeError):
+            k.find_batch(co, array('f', [0.0] * 2))
+        # wrong size
+        with self.assertRaises(ValueError):
+            k.find_batch(co, array('i', [0] * 3))
+        # not writable
+        with self.assertRaises(TypeError):
+            k.find_batch(co, bytes(8))
+
+
+class BVHTreeTesting(unittest.TestCase):
+    @staticmethod
+    def bvhtree_create_grid(tot):
+        verts = [(x, y, 0.0) for y in range(tot + 1) for x in range(tot + 1)]
+        row = tot + 1
+        polys = [
+            (y * row + x, y * row + x + 1, (y + 1) * row + x + 1, (y + 1) * row + x)
+            for y in range(tot) for x in range(tot)
+        ]
+        return BVHTree.FromPolygons(verts, polys)
+
+    def test_bvhtree_ray_cast_batch(self):
+        tree = self.bvhtree_create_grid(8)
+        origins = [(x * 0.3 - 1.0, y * 0.3 - 1.0, 1.0) for x in range(35) for y in range(35)]
+        co = array('f', [v for p in origins for v in p])
+        indices = array('i', [0]) * len(origins)
+        distances = array('f', [0.0]) * len(origins)
+        hits = tree.ray_cast_batch(co, array('f', (0.0, 0.0, -1.0)), indices, distances=distances)
+        hits_expect = 0
+        for i, p in enumerate(origins):
+            location, normal, index, dist = tree.ray_cast(p, (0.0, 0.0, -1.0))
+            if index is None:
+                self.assertEqual(indices[i], -1)
+            else:
+                hits_expect += 1
+                self.assertEqual(indices[i], index)
+                self.assertAlmostEqual(distances[i], dist, places=5)
+        self.assertEqual(hits, hits_expect)
+
+    def test_bvhtree_find_nearest_batch(self):
+        tree = self.bvhtree_create_grid(8)
+        origins = [(x * 0.7 - 1.0, y * 0.7 - 1.0, 0.5) for x in range(15) for y in range(15)]
+        co = array('f', [v for p in origins for v in p])
+        indices = array('i', [0]) * len(origins)
+        locations = array('f', [0.0]) * (len(origins) * 3)
+        hits = tree.find_nearest_batch(co, indices, locations=locations, distance=1.0)
+        for i, p in enumerate(origins):
+            location, normal, index, dist = tree.find_nearest(p, 1.0)
+            if index is None:
+                self.assertEqual(indices[i], -1)
+            else:
+                for j in range(3):
+                    self.assertAlmostEqual(locations[i * 3 + j], location[j], places=5)
+        self.assertEqual(hits, sum(1 for i in indices if i != -1))
+
+    def test_bvhtree_batch_invalid(self):
+        tree = self.bvhtree_create_grid(2)
+        co = array('f', [0.0] * 6)
+        # indices are required
+        with self.assertRaises(TypeError):
+            tree.find_nearest_batch(co, None)
+        with self.assertRaises(TypeError):
+            tree.ray_cast_batch(co, array('f', (0.0, 0.0, -1.0)), None)
+
+
 class TesselatePolygon(unittest.TestCase):
     def test_empty(self):
         self.assertEqual([], geometry.tessellate_polygon([]))
@@ -0,0 +1,108 @@
+# Apache License, Version 2.0
+
+# ./blender.bin --background -noaudio --python tests/python/bl_pyapi_prop_collection_view.py -- --verbose
+import bpy
+import array
+import time
+import unittest
+
+
+def mesh_grid_new(name, verts_len):
+    me = bpy.data.meshes.new(name)
+    me.vertices.add(verts_len)
+    me.vertices.foreach_set("co", [float(i) for i in range(verts_len * 3)])
+    return me
+
+
+class TestPropCollectionView(unittest.TestCase):
+    def setUp(self):
+        self.me = mesh_grid_new("TestMesh", 100)
+
+    def tearDown(self):
+        bpy.data.meshes.remove(self.me)
+
+    def test_shape(self):
+        with self.me.vertices.foreach_view("co") as view:
+            self.assertEqual(view.format, "f")
+            self.assertEqual(view.shape, (100, 3))
+            self.assertFalse(view.readonly)
+        self.me.loops.add(10)
+        with self.me.loops.foreach_view("vertex_index") as view:
+            self.assertEqual(view.format, "I")
+            self.assertEqual(view.shape, (10,))
+
+    def test_get(self):
+        co = array.array('f', [0.0]) * 300
+        self.me.vertices.foreach_get("co", co)
+        with self.me.vertices.foreach_view("co") as view:
+            self.assertEqual(view.tolist(), [list(co[i:i + 3]) for i in range(0, 300, 3)])
+
+    def test_set(self):
+        with self.me.vertices.foreach_view("co") as view:
+            view[10, 1] = -1.0
+        self.assertEqual(self.me.vertices[10].co.y, -1.0)
+
+    def test_readonly(self):
+        with self.me.vertices.foreach_view("co", readonly=True) as view:
+            self.assertTrue(view.readonly)
+            with self.assertRaises(TypeError):
+                view[10, 1] = -1.0
+        self.assertEqual(self.me.vertices[10].co.y, 31.0)
+
+    def test_resized(self):
+        view = self.me.vertices.foreach_view("co")
+        view_data = view.obj
+        view.release()
+        # The array is reallocated, the old view can't be used anymore.
+        self.me.vertices.add(10)
+        with self.assertRaises(BufferError):
+            memoryview(view_data)
+
+    def test_resized_in_use(self):
+        with self.me.vertices.foreach_view("co") as view:
+            # The view is a copy, it stays usable while the array is reallocated.
+            self.me.vertices.add(10)
+            view[10, 1] = -1.0
+            self.assertEqual(view[10, 1], -1.0)
+        # Not written back to the reallocated array.
+        self.assertEqual(self.me.vertices[10].co.y, 31.0)
+
+    def test_empty(self):
+        me = bpy.data.meshes.new("TestMeshEmpty")
+        with me.vertices.foreach_view("co") as view:
+            self.assertEqual(view.shape, (0, 3))
+            self.assertEqual(view.tolist(), [])
+        bpy.data.meshes.remove(me)
+
+    def test_unsupported(self):
+        with self.assertRaises(AttributeError):
+            self.me.vertices.foreach_view("does_not_exist")
+        # Only stored as a bit-flag, so there is no array to view.
+        with self.assertRaises(AttributeError):
+            self.me.vertices.foreach_view("select")
+
+    def test_timing(self):
+        verts_len = 1000000
+        me = mesh_grid_new("TestMeshLarge", verts_len)
+        co = array.array('f', [0.0]) * (verts_len * 3)
+
+        t = time.time()
+        me.vertices.foreach_get("co", co)
+        time_foreach_get = time.time() - t
+
+        t = time.time()
+        with me.vertices.foreach_view("co") as view:
+            co_sum = sum(view[-1])
+        time_foreach_view = time.time() - t
+
+        print("\n%d vertices: foreach_get %.6fs, foreach_view %.6fs" %
+              (verts_len, time_foreach_get, time_foreach_view))
+        self.assertEqual(co_sum, sum(co[-3:]))
+        bpy.data.meshes.remove(me)
+
+
+if __name__ == '__main__':
+    import sys
+
+    sys.argv = [__file__] + (sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else [])
+    unittest.main()